@@ -48,18 +48,31 @@
 #include "pho_type_utils.h"
 
 #include "import.h"
+#include "repack.h"
 
 enum pho_cfg_params_admin {
     /* Actual admin parameters */
     PHO_CFG_ADMIN_lrs_socket,
+    PHO_CFG_ADMIN_repack_buffer_mb,
+    PHO_CFG_ADMIN_repack_dss_batch,
 
     /* Delimiters, update when modifying options */
     PHO_CFG_ADMIN_FIRST = PHO_CFG_ADMIN_lrs_socket,
-    PHO_CFG_ADMIN_LAST  = PHO_CFG_ADMIN_lrs_socket
+    PHO_CFG_ADMIN_LAST  = PHO_CFG_ADMIN_repack_dss_batch
 };
 
 const struct pho_config_item cfg_admin[] = {
     [PHO_CFG_ADMIN_lrs_socket] = LRS_SOCKET_CFG_ITEM,
+    [PHO_CFG_ADMIN_repack_buffer_mb] = {
+        .section = "admin",
+        .name    = "repack_buffer_mb",
+        .value   = "256",
+    },
+    [PHO_CFG_ADMIN_repack_dss_batch] = {
+        .section = "admin",
+        .name    = "repack_dss_batch",
+        .value   = "64",
+    },
 };
 
 /* ****************************************************************************/
@@ -1402,30 +1415,6 @@ static int _send_and_recv_release(struct admin_handle *adm,
     return rc;
 }
 
-static void _build_new_extent(const struct pho_id *target,
-                              struct extent *old_extent,
-                              struct extent *new_extent,
-                              struct pho_io_descr *iod_source,
-                              struct pho_io_descr *iod_target)
-{
-    new_extent->uuid = generate_uuid();
-    new_extent->state = PHO_EXT_ST_PENDING;
-    new_extent->size = old_extent->size;
-    new_extent->address.size = old_extent->address.size;
-    new_extent->address.buff = xstrdup(old_extent->address.buff);
-    pho_id_copy(&new_extent->media, target);
-    new_extent->with_xxh128 = old_extent->with_xxh128;
-    if (new_extent->with_xxh128)
-        memcpy(new_extent->xxh128, old_extent->xxh128,
-               sizeof(old_extent->xxh128));
-    new_extent->with_md5 = old_extent->with_md5;
-    if (new_extent->with_md5)
-        memcpy(new_extent->md5, old_extent->md5, sizeof(old_extent->md5));
-    iod_source->iod_loc->extent = old_extent;
-    iod_source->iod_size = old_extent->size;
-    iod_target->iod_loc->extent = new_extent;
-}
-
 static int _clean_database_following_format(struct admin_handle *adm,
                                             const struct pho_id *source)
 {
@@ -1510,12 +1499,14 @@ int phobos_admin_repack(struct admin_handle *adm, const struct pho_id *source,
     struct pho_ext_loc loc_source = {0};
     struct pho_ext_loc loc_target = {0};
     struct io_adapter_module *ioa = {0};
+    struct repack_copy copy = {0};
+    const char **old_ext_uuids;
     struct extent *ext_res = NULL;
-    GArray *new_ext_uuids = NULL;
-    int ext_cnt_done = 0;
+    bool copying = false;
     struct pho_id target;
     ssize_t total_size;
     int ext_cnt;
+    int rc2;
     int rc;
     int i;
 
@@ -1536,8 +1527,6 @@ int phobos_admin_repack(struct admin_handle *adm, const struct pho_id *source,
     if (total_size == 0)
         goto format;
 
-    new_ext_uuids = g_array_new(FALSE, TRUE, sizeof(ext_res[0].uuid));
-
     /* Prepare read allocation */
     rc = _get_source_medium(adm, source, &loc_source, &iod_source, &ioa,
                             &source_fs_type);
@@ -1554,29 +1543,19 @@ int phobos_admin_repack(struct admin_handle *adm, const struct pho_id *source,
     }
 
     /* Copy loop */
-    for (i = 0; i < ext_cnt; ++i, ++ext_cnt_done) {
-        struct extent ext_new = {0};
-
-        _build_new_extent(&target, &ext_res[i], &ext_new, &iod_source,
-                          &iod_target);
-
-        rc = copy_extent(ioa, &iod_source, ioa, &iod_target, PHO_RSC_TAPE);
-        if (rc) {
-            pho_error(rc, "Failed to copy extent '%s'", ext_res[i].uuid);
-            break;
-        }
-
-        rc = dss_extent_insert(&adm->dss, &ext_new, 1);
-        if (rc) {
-            pho_error(rc, "Failed to add extent '%s' information in DSS",
-                      ext_res[i].uuid);
-            break;
-        }
-
-        g_array_append_val(new_ext_uuids, ext_new.uuid);
-
-        free(ext_new.address.buff);
-    }
+    copy.ioa = ioa;
+    copy.iod_source = &iod_source;
+    copy.iod_target = &iod_target;
+    copy.target = &target;
+    copy.extents = ext_res;
+    copy.count = ext_cnt;
+    copy.buffer_size = (size_t)PHO_CFG_GET_INT(cfg_admin, PHO_CFG_ADMIN,
+                                               repack_buffer_mb, 256) << 20;
+    copy.dss_batch = max(PHO_CFG_GET_INT(cfg_admin, PHO_CFG_ADMIN,
+                                         repack_dss_batch, 64), 1);
+
+    rc = repack_copy_extents(&adm->dss, &copy);
+    copying = true;
     free(loc_target.root_path);
     free(loc_source.root_path);
 
@@ -1586,24 +1565,24 @@ int phobos_admin_repack(struct admin_handle *adm, const struct pho_id *source,
     }
 
     rc = _send_and_recv_release(adm, source, &iod_source, 3,
-                                &target, &iod_target,
-                                ext_cnt_done == ext_cnt ?
-                                    total_size :
-                                    _sum_extent_size(ext_res, ext_cnt_done),
-                                ext_cnt_done);
+                                &target, &iod_target, copy.size_done,
+                                copy.n_done);
     if (rc)
         LOG_GOTO(free_ext, rc, "Failed to send/receive release");
 
     /* Database update: swap new and old extents */
-    for (i = 0; i < ext_cnt_done; ++i) {
-        rc = dss_update_extent_migrate(&adm->dss, ext_res[i].uuid,
-                                       g_array_index(new_ext_uuids, char *, i));
-        if (rc)
-            LOG_GOTO(free_ext, rc, "Failed to update layouts in DSS");
-    }
+    old_ext_uuids = xcalloc(copy.n_done, sizeof(*old_ext_uuids));
+    for (i = 0; i < copy.n_done; ++i)
+        old_ext_uuids[i] = ext_res[i].uuid;
 
-    g_array_free(new_ext_uuids, TRUE);
-    new_ext_uuids = NULL;
+    rc = dss_update_extents_migrate(&adm->dss, old_ext_uuids,
+                                    (const char **)copy.new_uuids,
+                                    copy.n_done);
+    free(old_ext_uuids);
+    if (rc)
+        LOG_GOTO(free_ext, rc, "Failed to update layouts in DSS");
+
+    copying = false;
 
 format:
     if (source_fs_type == PHO_FS_INVAL) {
@@ -1624,16 +1603,14 @@ format:
     rc = _clean_database_following_format(adm, source);
 
 free_ext:
-    if (new_ext_uuids) {
-        rc = dss_update_extent_state(&adm->dss,
-                                     (const char **)new_ext_uuids->data,
-                                     (int)new_ext_uuids->len,
-                                     PHO_EXT_ST_ORPHAN);
-        g_array_free(new_ext_uuids, TRUE);
-        if (rc)
-            pho_error(rc, "Failed to update state of new extents to orphan");
-
+    if (copying && copy.n_done > 0) {
+        rc2 = dss_update_extent_state(&adm->dss,
+                                      (const char **)copy.new_uuids,
+                                      copy.n_done, PHO_EXT_ST_ORPHAN);
+        if (rc2)
+            pho_error(rc2, "Failed to update state of new extents to orphan");
     }
+    repack_copy_fini(&copy);
     dss_res_free(ext_res, ext_cnt);
 
     return rc;
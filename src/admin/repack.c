@@ -0,0 +1,524 @@
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief  Phobos tape repack
+ *
+ * The source tape is read by a reader thread into a ring of chunks while the
+ * chunks already read are written to the target tape. As long as the ring is
+ * neither full nor empty, none of the drives has to stop and reposition
+ * (shoe-shining) between two extents.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pho_attrs.h"
+#include "pho_common.h"
+#include "pho_dss.h"
+#include "pho_io.h"
+#include "pho_type_utils.h"
+
+#include "repack.h"
+
+/** Size of a chunk if no io_block_size is configured for tapes */
+#define REPACK_DEFAULT_CHUNK_SIZE   (1024 * 1024)
+
+struct repack_chunk {
+    char *buff;
+    size_t size;                /**< Size of the data read in buff */
+};
+
+struct repack_ring {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;        /**< Signals any change of the fields below */
+    struct repack_chunk *chunks;
+    size_t n_chunks;
+    size_t chunk_size;
+    size_t head;                /**< Next chunk to fill */
+    size_t tail;                /**< Next chunk to write */
+    size_t n_filled;            /**< Chunks read and not written yet */
+    int n_opened;               /**< Source extents opened by the reader, their
+                                  *  attributes are available
+                                  */
+    int reader_rc;
+    bool reader_done;
+    bool stopping;              /**< The writer gave up, stop reading */
+};
+
+struct repack_ctx {
+    struct repack_copy *copy;
+    struct repack_ring ring;
+    struct pho_attrs *attrs;    /**< Attributes of each source extent */
+    struct extent *new_extents;
+};
+
+struct tape_position {
+    int64_t block;
+    int index;
+};
+
+static int64_t extent_start_block(const char *root_path,
+                                  struct extent *extent)
+{
+    const char *recorded;
+    int64_t block;
+    char *path;
+
+    /* position recorded when the extent was written, if any */
+    recorded = pho_attr_get(&extent->info, PHO_EXT_INFO_POSITION_NAME);
+    if (recorded) {
+        block = str2int64(recorded);
+        if (block >= 0)
+            return block;
+    }
+
+    if (asprintf(&path, "%s/%s", root_path, extent->address.buff) < 0)
+        return INT64_MAX;
+
+    block = ltfs_start_block(path);
+    free(path);
+
+    return block < 0 ? INT64_MAX : block;
+}
+
+static int cmp_tape_position(const void *a, const void *b)
+{
+    const struct tape_position *pos_a = a;
+    const struct tape_position *pos_b = b;
+
+    if (pos_a->block != pos_b->block)
+        return pos_a->block < pos_b->block ? -1 : 1;
+
+    return pos_a->index - pos_b->index;
+}
+
+/**
+ * Sort the extents in the order they are on the tape, so that the source
+ * tape is read sequentially. The extents whose position is unknown are kept
+ * in their order, at the end.
+ */
+static void sort_by_tape_position(struct repack_copy *copy)
+{
+    const char *root_path = copy->iod_source->iod_loc->root_path;
+    struct tape_position *positions;
+    struct extent *sorted;
+    int i;
+
+    positions = xcalloc(copy->count, sizeof(*positions));
+    for (i = 0; i < copy->count; i++) {
+        positions[i].block = extent_start_block(root_path, &copy->extents[i]);
+        positions[i].index = i;
+    }
+
+    qsort(positions, copy->count, sizeof(*positions), cmp_tape_position);
+
+    sorted = xmalloc(copy->count * sizeof(*sorted));
+    for (i = 0; i < copy->count; i++)
+        sorted[i] = copy->extents[positions[i].index];
+
+    memcpy(copy->extents, sorted, copy->count * sizeof(*sorted));
+
+    free(sorted);
+    free(positions);
+}
+
+static void build_new_extent(const struct pho_id *target,
+                             const struct extent *old_extent,
+                             struct extent *new_extent)
+{
+    new_extent->uuid = generate_uuid();
+    new_extent->state = PHO_EXT_ST_PENDING;
+    new_extent->size = old_extent->size;
+    new_extent->offset = old_extent->offset;
+    new_extent->address.size = old_extent->address.size;
+    new_extent->address.buff = xstrdup(old_extent->address.buff);
+    pho_id_copy(&new_extent->media, target);
+    new_extent->with_xxh128 = old_extent->with_xxh128;
+    if (new_extent->with_xxh128)
+        memcpy(new_extent->xxh128, old_extent->xxh128,
+               sizeof(old_extent->xxh128));
+    new_extent->with_md5 = old_extent->with_md5;
+    if (new_extent->with_md5)
+        memcpy(new_extent->md5, old_extent->md5, sizeof(old_extent->md5));
+    new_extent->with_crc32c = old_extent->with_crc32c;
+    if (new_extent->with_crc32c)
+        memcpy(new_extent->crc32c, old_extent->crc32c,
+               sizeof(old_extent->crc32c));
+}
+
+static int read_extent(struct repack_ctx *ctx, int i)
+{
+    struct repack_copy *copy = ctx->copy;
+    struct pho_io_descr *iod = copy->iod_source;
+    struct extent *extent = &copy->extents[i];
+    struct repack_ring *ring = &ctx->ring;
+    size_t left = extent->size;
+    int rc2;
+    int rc;
+
+    iod->iod_loc->extent = extent;
+    iod->iod_size = extent->size;
+    iod->iod_attrs.attr_set = NULL;
+    pho_json_to_attrs(&iod->iod_attrs,
+                      "{\"id\":\"\", \"user_md\":\"\", \"md5\":\"\"}");
+
+    rc = ioa_open(copy->ioa, NULL, iod, false);
+    if (rc) {
+        iod->iod_rc = rc;
+        LOG_RETURN(rc, "Unable to open source extent '%s'", extent->uuid);
+    }
+
+    /* the attributes are handed over to the writer */
+    MUTEX_LOCK(&ring->mutex);
+    ctx->attrs[i] = iod->iod_attrs;
+    ring->n_opened++;
+    pthread_cond_broadcast(&ring->cond);
+    MUTEX_UNLOCK(&ring->mutex);
+    iod->iod_attrs.attr_set = NULL;
+
+    while (left > 0) {
+        struct repack_chunk *chunk;
+        ssize_t nb_read_bytes;
+
+        MUTEX_LOCK(&ring->mutex);
+        while (ring->n_filled == ring->n_chunks && !ring->stopping)
+            pthread_cond_wait(&ring->cond, &ring->mutex);
+
+        if (ring->stopping) {
+            MUTEX_UNLOCK(&ring->mutex);
+            rc = -ECANCELED;
+            break;
+        }
+
+        chunk = &ring->chunks[ring->head];
+        MUTEX_UNLOCK(&ring->mutex);
+
+        nb_read_bytes = ioa_read(copy->ioa, iod, chunk->buff,
+                                 min(left, ring->chunk_size));
+        if (nb_read_bytes < 0) {
+            rc = nb_read_bytes;
+            pho_error(rc, "Unable to read source extent '%s'", extent->uuid);
+            break;
+        } else if (nb_read_bytes == 0) {
+            rc = -EIO;
+            pho_error(rc, "Unexpected end of source extent '%s', %zu bytes "
+                      "missing", extent->uuid, left);
+            break;
+        }
+
+        chunk->size = nb_read_bytes;
+        left -= nb_read_bytes;
+
+        MUTEX_LOCK(&ring->mutex);
+        ring->head = (ring->head + 1) % ring->n_chunks;
+        ring->n_filled++;
+        pthread_cond_broadcast(&ring->cond);
+        MUTEX_UNLOCK(&ring->mutex);
+    }
+
+    rc2 = ioa_close(copy->ioa, iod);
+    if (!rc && rc2)
+        pho_error(rc = rc2, "Unable to close source extent '%s'",
+                  extent->uuid);
+
+    if (rc)
+        iod->iod_rc = rc;
+
+    return rc;
+}
+
+static void *repack_reader(void *arg)
+{
+    struct repack_ctx *ctx = arg;
+    struct repack_ring *ring = &ctx->ring;
+    int rc = 0;
+    int i;
+
+    for (i = 0; i < ctx->copy->count && rc == 0; i++)
+        rc = read_extent(ctx, i);
+
+    MUTEX_LOCK(&ring->mutex);
+    ring->reader_rc = rc;
+    ring->reader_done = true;
+    pthread_cond_broadcast(&ring->cond);
+    MUTEX_UNLOCK(&ring->mutex);
+
+    return NULL;
+}
+
+/** Wait for the next chunk, NULL if the reader failed */
+static struct repack_chunk *next_chunk(struct repack_ring *ring)
+{
+    struct repack_chunk *chunk = NULL;
+
+    MUTEX_LOCK(&ring->mutex);
+    while (ring->n_filled == 0 && !ring->reader_done)
+        pthread_cond_wait(&ring->cond, &ring->mutex);
+
+    if (ring->n_filled > 0)
+        chunk = &ring->chunks[ring->tail];
+    MUTEX_UNLOCK(&ring->mutex);
+
+    return chunk;
+}
+
+static void release_chunk(struct repack_ring *ring)
+{
+    MUTEX_LOCK(&ring->mutex);
+    ring->tail = (ring->tail + 1) % ring->n_chunks;
+    ring->n_filled--;
+    pthread_cond_broadcast(&ring->cond);
+    MUTEX_UNLOCK(&ring->mutex);
+}
+
+static int reader_error(struct repack_ring *ring)
+{
+    int rc;
+
+    MUTEX_LOCK(&ring->mutex);
+    rc = ring->reader_rc ? : -EIO;
+    MUTEX_UNLOCK(&ring->mutex);
+
+    return rc;
+}
+
+static int write_extent(struct repack_ctx *ctx, int i)
+{
+    struct repack_copy *copy = ctx->copy;
+    struct extent *new_extent = &ctx->new_extents[i];
+    struct pho_io_descr *iod = copy->iod_target;
+    struct repack_ring *ring = &ctx->ring;
+    size_t left = copy->extents[i].size;
+    bool opened;
+    int rc2;
+    int rc;
+
+    /* wait for the reader to open the source extent */
+    MUTEX_LOCK(&ring->mutex);
+    while (ring->n_opened <= i && !ring->reader_done)
+        pthread_cond_wait(&ring->cond, &ring->mutex);
+    opened = ring->n_opened > i;
+    MUTEX_UNLOCK(&ring->mutex);
+
+    if (!opened)
+        return reader_error(ring);
+
+    build_new_extent(copy->target, &copy->extents[i], new_extent);
+    iod->iod_loc->extent = new_extent;
+    iod->iod_loc->addr_type = copy->iod_source->iod_loc->addr_type;
+    /* the target descriptor takes over the attributes of the source */
+    MUTEX_LOCK(&ring->mutex);
+    iod->iod_attrs = ctx->attrs[i];
+    ctx->attrs[i].attr_set = NULL;
+    MUTEX_UNLOCK(&ring->mutex);
+    iod->iod_size = 0;
+
+    rc = ioa_open(copy->ioa, NULL, iod, true);
+    if (rc) {
+        iod->iod_rc = rc;
+        pho_attrs_free(&iod->iod_attrs);
+        LOG_RETURN(rc, "Unable to open target extent of '%s'",
+                   copy->extents[i].uuid);
+    }
+
+    rc = ioa_set_md(copy->ioa, NULL, iod);
+    if (rc) {
+        iod->iod_rc = rc;
+        pho_error(rc, "Unable to set attrs to target extent of '%s'",
+                  copy->extents[i].uuid);
+    }
+
+    while (!rc && left > 0) {
+        struct repack_chunk *chunk = next_chunk(ring);
+
+        if (!chunk) {
+            rc = reader_error(ring);
+            break;
+        }
+
+        rc = ioa_write(copy->ioa, iod, chunk->buff, chunk->size);
+        if (rc) {
+            iod->iod_rc = rc;
+            pho_error(rc, "Unable to write %zu bytes to target extent of '%s'",
+                      chunk->size, copy->extents[i].uuid);
+            break;
+        }
+
+        left -= chunk->size;
+        release_chunk(ring);
+    }
+
+    rc2 = ioa_close(copy->ioa, iod);
+    if (rc)
+        rc2 = ioa_del(copy->ioa, iod);
+    if (!rc && rc2) {
+        iod->iod_rc = rc2;
+        rc = rc2;
+    }
+
+    pho_attrs_free(&iod->iod_attrs);
+
+    return rc;
+}
+
+/** Insert the copies of the extents [copy->n_done, \p last[ in the DSS */
+static int record_copies(struct dss_handle *dss, struct repack_ctx *ctx,
+                         int last)
+{
+    struct repack_copy *copy = ctx->copy;
+    int first = copy->n_done;
+    int rc;
+    int i;
+
+    if (last == first)
+        return 0;
+
+    rc = dss_extent_insert(dss, &ctx->new_extents[first], last - first);
+    if (rc)
+        LOG_RETURN(rc, "Failed to add %d extents information in DSS",
+                   last - first);
+
+    for (i = first; i < last; i++) {
+        copy->new_uuids[i] = ctx->new_extents[i].uuid;
+        ctx->new_extents[i].uuid = NULL;
+        copy->size_done += ctx->new_extents[i].size;
+    }
+    copy->n_done = last;
+
+    return 0;
+}
+
+static void repack_ring_init(struct repack_ring *ring, size_t buffer_size)
+{
+    size_t i;
+
+    get_cfg_io_block_size(&ring->chunk_size, PHO_RSC_TAPE);
+    if (ring->chunk_size == 0)
+        ring->chunk_size = REPACK_DEFAULT_CHUNK_SIZE;
+
+    /* at least two chunks, so that reads and writes overlap */
+    ring->n_chunks = max(buffer_size / ring->chunk_size, 2);
+    ring->chunks = xcalloc(ring->n_chunks, sizeof(*ring->chunks));
+    for (i = 0; i < ring->n_chunks; i++)
+        ring->chunks[i].buff = xmalloc(ring->chunk_size);
+
+    pthread_mutex_init(&ring->mutex, NULL);
+    pthread_cond_init(&ring->cond, NULL);
+}
+
+static void repack_ring_fini(struct repack_ring *ring)
+{
+    size_t i;
+
+    pthread_cond_destroy(&ring->cond);
+    pthread_mutex_destroy(&ring->mutex);
+
+    for (i = 0; i < ring->n_chunks; i++)
+        free(ring->chunks[i].buff);
+    free(ring->chunks);
+}
+
+int repack_copy_extents(struct dss_handle *dss, struct repack_copy *copy)
+{
+    struct repack_ctx ctx = { .copy = copy };
+    struct repack_ring *ring = &ctx.ring;
+    int n_written = 0;
+    pthread_t reader;
+    int rc2;
+    int rc;
+    int i;
+
+    copy->new_uuids = xcalloc(copy->count, sizeof(*copy->new_uuids));
+    copy->n_done = 0;
+    copy->size_done = 0;
+    if (copy->count == 0)
+        return 0;
+
+    sort_by_tape_position(copy);
+
+    ctx.attrs = xcalloc(copy->count, sizeof(*ctx.attrs));
+    ctx.new_extents = xcalloc(copy->count, sizeof(*ctx.new_extents));
+    repack_ring_init(ring, copy->buffer_size);
+
+    pho_verb("Repacking %d extents through %zu chunks of %zu bytes",
+             copy->count, ring->n_chunks, ring->chunk_size);
+
+    rc = -pthread_create(&reader, NULL, repack_reader, &ctx);
+    if (rc)
+        LOG_GOTO(free_ctx, rc, "Unable to start the repack reader");
+
+    for (i = 0; i < copy->count; i++) {
+        rc = write_extent(&ctx, i);
+        if (rc) {
+            pho_error(rc, "Failed to copy extent '%s'", copy->extents[i].uuid);
+            break;
+        }
+        n_written = i + 1;
+
+        if (n_written - copy->n_done >= copy->dss_batch) {
+            rc = record_copies(dss, &ctx, n_written);
+            if (rc)
+                break;
+        }
+    }
+
+    /* the extents already written are recorded even on failure, so that they
+     * are accounted for and cleaned up by the caller
+     */
+    rc2 = record_copies(dss, &ctx, n_written);
+    rc = rc ? : rc2;
+
+    MUTEX_LOCK(&ring->mutex);
+    ring->stopping = true;
+    pthread_cond_broadcast(&ring->cond);
+    MUTEX_UNLOCK(&ring->mutex);
+
+    pthread_join(reader, NULL);
+
+free_ctx:
+    for (i = 0; i < copy->count; i++) {
+        pho_attrs_free(&ctx.attrs[i]);
+        pho_attrs_free(&ctx.new_extents[i].info);
+        free(ctx.new_extents[i].uuid);
+        free(ctx.new_extents[i].address.buff);
+    }
+
+    repack_ring_fini(ring);
+    free(ctx.new_extents);
+    free(ctx.attrs);
+
+    return rc;
+}
+
+void repack_copy_fini(struct repack_copy *copy)
+{
+    int i;
+
+    for (i = 0; i < copy->n_done; i++)
+        free(copy->new_uuids[i]);
+
+    free(copy->new_uuids);
+    copy->new_uuids = NULL;
+}
@@ -0,0 +1,82 @@
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \brief  Phobos admin repack header
+ */
+
+#ifndef _PHO_ADMIN_REPACK_H
+#define _PHO_ADMIN_REPACK_H
+
+#include "pho_dss.h"
+#include "pho_io.h"
+#include "pho_types.h"
+
+/**
+ * Copy of the live extents of a tape to another one.
+ */
+struct repack_copy {
+    /* Inputs */
+    struct io_adapter_module *ioa;      /**< I/O adapter of both media */
+    struct pho_io_descr *iod_source;    /**< Location of the source medium */
+    struct pho_io_descr *iod_target;    /**< Location of the target medium */
+    const struct pho_id *target;        /**< Target medium */
+    struct extent *extents;             /**< Extents to copy */
+    int count;                          /**< Number of extents to copy */
+    size_t buffer_size;                 /**< Size of the buffer between the
+                                          *  drives, in bytes
+                                          */
+    int dss_batch;                      /**< Number of copies recorded in the
+                                          *  DSS per transaction
+                                          */
+
+    /* Outputs */
+    char **new_uuids;                   /**< UUID of the copy of each extent */
+    int n_done;                         /**< Number of extents copied and
+                                          *  recorded in the DSS
+                                          */
+    ssize_t size_done;                  /**< Size of these extents */
+};
+
+/**
+ * Copy the extents of \p copy from the source medium to the target one.
+ *
+ * The extents are first sorted in their on-tape order. They are then read by
+ * a dedicated thread while the calling thread writes them, so that both
+ * drives keep streaming. The copies are inserted in the DSS as pending
+ * extents, by batches of copy->dss_batch.
+ *
+ * On return, the first copy->n_done extents of copy->extents (in their new
+ * order) are copied and recorded, even on failure.
+ *
+ * @param[in]       dss     DSS handle.
+ * @param[in, out]  copy    Copy to perform.
+ *
+ * @return 0 on success, -errno on failure.
+ */
+int repack_copy_extents(struct dss_handle *dss, struct repack_copy *copy);
+
+/**
+ * Release the outputs of repack_copy_extents.
+ *
+ * @param[in, out]  copy    Copy to release.
+ */
+void repack_copy_fini(struct repack_copy *copy);
+
+#endif
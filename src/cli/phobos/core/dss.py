@@ -83,7 +83,6 @@ ATTRS2DSS = {
     'status'              : 'obj_status',
 
     # "Extent"
-    'ext_count'           : 'count(\'json_agg\')',
     'layout'              : 'lyt_info -> \'name\'',
 }
 
@@ -196,9 +195,9 @@ def dss_sort(obj_type, **kwargs):
             if ATTRS2DSS.get(kwargs[key]):
                 kwargs[key] = ATTRS2DSS[kwargs[key]]
 
-            # special case where the sorting of extents by size is done in the
-            # C API
-            if kwargs[key] == 'size' and obj_type == 'layout':
+            # special case where the sorting of extents by size or by count is
+            # done in the C API, the extents being one row each
+            if kwargs[key] in ('size', 'ext_count') and obj_type == 'layout':
                 psql_sort = False
 
             sort = SortFilter(kwargs[key].encode('utf-8'), reverse, is_lock,
@@ -386,7 +385,8 @@ class DSSHandle(Structure): # pylint: disable=too-few-public-methods
     Wrap connection to the backend. Absolutely opaque and propagated everywhere.
     """
     _fields_ = [
-        ('dh_conn', c_void_p)
+        ('dh_conn', c_void_p),
+        ('dh_prepared', c_void_p)
     ]
 
 class Client:
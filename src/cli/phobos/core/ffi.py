@@ -755,6 +755,8 @@ class ExtentInfo(Structure): # pylint: disable=too-few-public-methods
         ('xxh128', c_ubyte * 16),
         ('with_md5', c_bool),
         ('md5', c_ubyte * MD5_BYTE_LENGTH),
+        ('with_crc32c', c_bool),
+        ('crc32c', c_ubyte * 4),
         ('info', PhoAttrs)
     ]
 
@@ -802,6 +804,7 @@ class LayoutInfo(Structure, CLIManagedResourceMixin):
             'layout': None,
             'xxh128': None,
             'md5': None,
+            'crc32c': None,
             'library': None,
         }
 
@@ -892,6 +895,15 @@ class LayoutInfo(Structure, CLIManagedResourceMixin):
                 else None
                 for i in range(self.ext_count)]
 
+    @property
+    def crc32c(self):
+        """Wrapper to get extent crc32c."""
+        return [''.join('%02x' % one_byte
+                        for one_byte in self.extents[i].crc32c)
+                if self.extents[i].with_crc32c
+                else None
+                for i in range(self.ext_count)]
+
     @property
     def layout(self):
         """Wrapper to get object layout."""
@@ -33,7 +33,7 @@ from phobos.core.ffi import (LIBPHOBOS, ResourceFamily)
 
 ORDERED_SCHEMAS = [
     "1.1", "1.2", "1.91", "1.92", "1.93", "1.95",
-    "2.0", "2.1", "2.2"
+    "2.0", "2.1", "2.2", "2.3"
 ]
 FUTURE_SCHEMAS = []
 CURRENT_SCHEMA_VERSION = ORDERED_SCHEMAS[-1]
@@ -70,6 +70,7 @@ class Migrator: # pylint: disable=too-many-public-methods
             "1.95": ("2.0", self.convert_1_95_to_2_0),
             "2.0": ("2.1", self.convert_2_0_to_2_1),
             "2.1": ("2.2", self.convert_2_1_to_2_2),
+            "2.2": ("2.3", self.convert_2_2_to_2_3),
         }
 
         self.reachable_versions = set(
@@ -654,6 +655,115 @@ class Migrator: # pylint: disable=too-many-public-methods
         with self.connect():
             self.convert_schema_2_1_to_2_2()
 
+    def convert_schema_2_2_to_2_3(self):
+        """DB schema changes: notify the changes of the objects and layouts"""
+        cur = self.conn.cursor()
+        cur.execute("""
+            -- find the objects whose layout contains an extent
+            CREATE INDEX ON layout(extent_uuid);
+
+            -- notify the clients caching object metadata of the changes of
+            -- the objects and of their layout, once enabled by
+            -- "ALTER DATABASE ... SET phobos.notify_object_changes = on"
+            CREATE FUNCTION notify_object_change() RETURNS trigger AS $$
+            DECLARE
+                chan text := 'phobos_object_change';
+                obj record;
+            BEGIN
+                IF TG_LEVEL <> 'ROW' THEN
+                    PERFORM pg_notify(chan, '');
+                ELSIF TG_TABLE_NAME = 'extent' THEN
+                    FOR obj IN SELECT DISTINCT object_uuid FROM layout
+                               WHERE extent_uuid = OLD.extent_uuid LOOP
+                        PERFORM pg_notify(chan, 'uuid:' || obj.object_uuid);
+                    END LOOP;
+                ELSIF TG_TABLE_NAME = 'layout' THEN
+                    IF TG_OP <> 'INSERT' THEN
+                        PERFORM pg_notify(chan, 'uuid:' || OLD.object_uuid);
+                    END IF;
+                    IF TG_OP <> 'DELETE' THEN
+                        PERFORM pg_notify(chan, 'uuid:' || NEW.object_uuid);
+                    END IF;
+                ELSE
+                    IF TG_OP <> 'INSERT' THEN
+                        PERFORM pg_notify(chan, 'oid:' || OLD.oid);
+                    END IF;
+                    IF TG_OP <> 'DELETE' THEN
+                        PERFORM pg_notify(chan, 'oid:' || NEW.oid);
+                    END IF;
+                END IF;
+
+                RETURN NULL;
+            END;
+            $$ LANGUAGE plpgsql;
+
+            CREATE TRIGGER object_change
+                AFTER INSERT OR DELETE OR UPDATE OF oid, user_md, object_uuid,
+                    version, lyt_info, obj_status, creation_time, _grouping
+                ON object FOR EACH ROW
+                WHEN (current_setting('phobos.notify_object_changes', true)
+                      = 'on')
+                EXECUTE PROCEDURE notify_object_change();
+            CREATE TRIGGER object_truncate AFTER TRUNCATE ON object
+                FOR EACH STATEMENT
+                WHEN (current_setting('phobos.notify_object_changes', true)
+                      = 'on')
+                EXECUTE PROCEDURE notify_object_change();
+
+            CREATE TRIGGER deprecated_object_change
+                AFTER INSERT OR DELETE OR UPDATE OF oid, user_md, object_uuid,
+                    version, deprec_time, lyt_info, obj_status, creation_time,
+                    _grouping
+                ON deprecated_object FOR EACH ROW
+                WHEN (current_setting('phobos.notify_object_changes', true)
+                      = 'on')
+                EXECUTE PROCEDURE notify_object_change();
+            CREATE TRIGGER deprecated_object_truncate
+                AFTER TRUNCATE ON deprecated_object FOR EACH STATEMENT
+                WHEN (current_setting('phobos.notify_object_changes', true)
+                      = 'on')
+                EXECUTE PROCEDURE notify_object_change();
+
+            CREATE TRIGGER layout_change
+                AFTER INSERT OR DELETE OR UPDATE ON layout FOR EACH ROW
+                WHEN (current_setting('phobos.notify_object_changes', true)
+                      = 'on')
+                EXECUTE PROCEDURE notify_object_change();
+            CREATE TRIGGER layout_truncate AFTER TRUNCATE ON layout
+                FOR EACH STATEMENT
+                WHEN (current_setting('phobos.notify_object_changes', true)
+                      = 'on')
+                EXECUTE PROCEDURE notify_object_change();
+
+            CREATE TRIGGER extent_change AFTER UPDATE ON extent
+                FOR EACH ROW
+                WHEN (OLD.state <> 'pending' AND
+                      current_setting('phobos.notify_object_changes', true)
+                      = 'on')
+                EXECUTE PROCEDURE notify_object_change();
+            CREATE TRIGGER extent_delete AFTER DELETE ON extent
+                FOR EACH ROW
+                WHEN (OLD.state <> 'pending' AND
+                      current_setting('phobos.notify_object_changes', true)
+                      = 'on')
+                EXECUTE PROCEDURE notify_object_change();
+            CREATE TRIGGER extent_truncate AFTER TRUNCATE ON extent
+                FOR EACH STATEMENT
+                WHEN (current_setting('phobos.notify_object_changes', true)
+                      = 'on')
+                EXECUTE PROCEDURE notify_object_change();
+
+            -- update current schema version
+            UPDATE schema_info SET version = '2.3';
+        """)
+        self.conn.commit()
+        cur.close()
+
+    def convert_2_2_to_2_3(self):
+        """Convert DB from v2.2 to v2.3"""
+        with self.connect():
+            self.convert_schema_2_2_to_2_3()
+
     def migrate(self, target_version=None):
         """Convert DB schema up to a given phobos version"""
         target_version = target_version if target_version is not None \
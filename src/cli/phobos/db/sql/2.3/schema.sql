@@ -0,0 +1,232 @@
+CREATE EXTENSION IF NOT EXISTS "uuid-ossp";
+
+CREATE TYPE dev_family AS ENUM ('tape', 'dir', 'rados_pool');
+CREATE TYPE adm_status AS ENUM ('locked', 'unlocked', 'failed');
+CREATE TYPE fs_type AS ENUM ('POSIX', 'LTFS', 'RADOS');
+CREATE TYPE address_type AS ENUM ('PATH', 'HASH1', 'OPAQUE');
+CREATE TYPE fs_status AS ENUM ('blank', 'empty', 'used', 'full', 'importing');
+CREATE TYPE extent_state AS ENUM ('pending','sync','orphan');
+CREATE TYPE lock_type AS ENUM('object', 'device', 'media', 'media_update',
+                              'extent');
+CREATE TYPE operation_type AS ENUM ('Library scan', 'Library open',
+                                    'Device lookup', 'Medium lookup',
+                                    'Device load', 'Device unload',
+                                    'LTFS mount', 'LTFS umount',
+                                    'LTFS format', 'LTFS df',
+                                    'LTFS sync');
+CREATE TYPE obj_status AS ENUM ('incomplete', 'readable', 'complete');
+
+-- to extend enums: ALTER TYPE type ADD VALUE 'value'
+
+-- Database schema information
+CREATE TABLE schema_info (
+    version         varchar(32) PRIMARY KEY
+);
+
+-- Insert current schema version
+INSERT INTO schema_info VALUES ('2.3');
+
+CREATE TABLE device(
+    family          dev_family,
+    model           varchar(32),
+    id              varchar(255),
+    host            varchar(128),
+    adm_status      adm_status,
+    path            varchar(256),
+    library         varchar(255) NOT NULL,
+
+    PRIMARY KEY (family, id, library)
+);
+CREATE INDEX ON device USING gin(host);
+
+CREATE TABLE media(
+    family          dev_family,
+    model           varchar(32),
+    id              varchar(255),
+    adm_status      adm_status,
+    fs_type         fs_type,
+    fs_label        varchar(32),
+    address_type    address_type,
+    fs_status       fs_status,
+    stats           jsonb,
+    tags            jsonb, -- json array (optimized for searching)
+    put             boolean DEFAULT TRUE,
+    get             boolean DEFAULT TRUE,
+    delete          boolean DEFAULT TRUE,
+    library         varchar(255) NOT NULL,
+    groupings       jsonb, -- json array (optimized for searching)
+
+    PRIMARY KEY (family, id, library)
+);
+CREATE INDEX ON media((stats->>'phys_spc_free'));
+
+CREATE TABLE object(
+    oid             varchar(1024),
+    user_md         jsonb,
+    object_uuid     varchar(36) UNIQUE DEFAULT uuid_generate_v4(),
+    version         integer DEFAULT 1 NOT NULL,
+    lyt_info        jsonb,
+    obj_status      obj_status DEFAULT 'incomplete',
+    creation_time   timestamp DEFAULT now(),
+    access_time     timestamp DEFAULT now(),
+    _grouping       varchar(255),
+    -- grouping word is already used by psql as a function
+    -- _grouping will be replaced by groupings in the future if we want
+    -- to manage more than one grouping per object
+
+    PRIMARY KEY (oid)
+);
+
+CREATE TABLE deprecated_object(
+    oid             varchar(1024),
+    object_uuid     varchar(36),
+    version         integer DEFAULT 1 NOT NULL,
+    user_md         jsonb,
+    deprec_time     timestamp DEFAULT now(),
+    lyt_info        jsonb,
+    obj_status      obj_status DEFAULT 'incomplete',
+    creation_time   timestamp DEFAULT now(),
+    access_time     timestamp DEFAULT now(),
+    _grouping       varchar(255),
+    -- grouping word is already used by psql as a function
+    -- _grouping will be replaced by groupings in the future if we want
+    -- to manage more than one grouping per object
+
+    PRIMARY KEY (object_uuid, version)
+);
+
+CREATE TABLE extent(
+    extent_uuid     varchar(36) UNIQUE DEFAULT uuid_generate_v4(),
+    state           extent_state,
+    size            bigint,
+    medium_family   dev_family,
+    medium_id       varchar(255),
+    address         varchar(1024),
+    hash            jsonb,
+    info            jsonb,
+    offsetof        bigint, -- the name 'offset' is a reserved keyword
+    medium_library  varchar(255) NOT NULL,
+
+    PRIMARY KEY (extent_uuid)
+);
+
+CREATE TABLE layout(
+    object_uuid     varchar(36),
+    version         integer DEFAULT 1 NOT NULL,
+    extent_uuid     varchar(36),
+    layout_index    integer,
+
+    PRIMARY KEY (object_uuid, version, layout_index)
+);
+
+CREATE TABLE lock(
+    type            lock_type,
+    id              varchar(2048),
+    hostname        varchar(256) NOT NULL,
+    owner           integer NOT NULL,
+    timestamp       timestamp DEFAULT now(),
+
+    PRIMARY KEY (type, id)
+);
+
+CREATE TABLE logs(
+    family    dev_family,
+    device    varchar(255),
+    medium    varchar(255),
+    uuid      varchar(36) UNIQUE DEFAULT uuid_generate_v4(),
+    errno     integer NOT NULL,
+    cause     operation_type,
+    message   jsonb,
+    time      timestamp DEFAULT now(),
+    library   varchar(255) NOT NULL,
+
+    PRIMARY KEY (uuid)
+);
+
+-- find the objects whose layout contains an extent
+CREATE INDEX ON layout(extent_uuid);
+
+-- Notify the clients caching object metadata of the changes of the objects
+-- and of their layout. The payload is 'oid:<oid>' or 'uuid:<object_uuid>',
+-- or empty if all the cached metadata must be dropped.
+--
+-- The notifications are only sent once enabled, as the clients only cache
+-- metadata when they are:
+--   ALTER DATABASE <dbname> SET phobos.notify_object_changes = on;
+-- The setting applies to the sessions opened afterwards.
+CREATE FUNCTION notify_object_change() RETURNS trigger AS $$
+DECLARE
+    chan text := 'phobos_object_change';
+    obj record;
+BEGIN
+    IF TG_LEVEL <> 'ROW' THEN
+        PERFORM pg_notify(chan, '');
+    ELSIF TG_TABLE_NAME = 'extent' THEN
+        FOR obj IN SELECT DISTINCT object_uuid FROM layout
+                   WHERE extent_uuid = OLD.extent_uuid LOOP
+            PERFORM pg_notify(chan, 'uuid:' || obj.object_uuid);
+        END LOOP;
+    ELSIF TG_TABLE_NAME = 'layout' THEN
+        IF TG_OP <> 'INSERT' THEN
+            PERFORM pg_notify(chan, 'uuid:' || OLD.object_uuid);
+        END IF;
+        IF TG_OP <> 'DELETE' THEN
+            PERFORM pg_notify(chan, 'uuid:' || NEW.object_uuid);
+        END IF;
+    ELSE
+        IF TG_OP <> 'INSERT' THEN
+            PERFORM pg_notify(chan, 'oid:' || OLD.oid);
+        END IF;
+        IF TG_OP <> 'DELETE' THEN
+            PERFORM pg_notify(chan, 'oid:' || NEW.oid);
+        END IF;
+    END IF;
+
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+-- the access time is updated on every get and is not cached
+CREATE TRIGGER object_change
+    AFTER INSERT OR DELETE OR UPDATE OF oid, user_md, object_uuid, version,
+        lyt_info, obj_status, creation_time, _grouping
+    ON object FOR EACH ROW
+    WHEN (current_setting('phobos.notify_object_changes', true) = 'on')
+    EXECUTE PROCEDURE notify_object_change();
+CREATE TRIGGER object_truncate AFTER TRUNCATE ON object FOR EACH STATEMENT
+    WHEN (current_setting('phobos.notify_object_changes', true) = 'on')
+    EXECUTE PROCEDURE notify_object_change();
+
+CREATE TRIGGER deprecated_object_change
+    AFTER INSERT OR DELETE OR UPDATE OF oid, user_md, object_uuid, version,
+        deprec_time, lyt_info, obj_status, creation_time, _grouping
+    ON deprecated_object FOR EACH ROW
+    WHEN (current_setting('phobos.notify_object_changes', true) = 'on')
+    EXECUTE PROCEDURE notify_object_change();
+CREATE TRIGGER deprecated_object_truncate AFTER TRUNCATE ON deprecated_object
+    FOR EACH STATEMENT
+    WHEN (current_setting('phobos.notify_object_changes', true) = 'on')
+    EXECUTE PROCEDURE notify_object_change();
+
+CREATE TRIGGER layout_change AFTER INSERT OR DELETE OR UPDATE ON layout
+    FOR EACH ROW
+    WHEN (current_setting('phobos.notify_object_changes', true) = 'on')
+    EXECUTE PROCEDURE notify_object_change();
+CREATE TRIGGER layout_truncate AFTER TRUNCATE ON layout FOR EACH STATEMENT
+    WHEN (current_setting('phobos.notify_object_changes', true) = 'on')
+    EXECUTE PROCEDURE notify_object_change();
+
+-- only the extents already part of a layout may be cached
+CREATE TRIGGER extent_change AFTER UPDATE ON extent
+    FOR EACH ROW
+    WHEN (OLD.state <> 'pending' AND
+          current_setting('phobos.notify_object_changes', true) = 'on')
+    EXECUTE PROCEDURE notify_object_change();
+CREATE TRIGGER extent_delete AFTER DELETE ON extent
+    FOR EACH ROW
+    WHEN (OLD.state <> 'pending' AND
+          current_setting('phobos.notify_object_changes', true) = 'on')
+    EXECUTE PROCEDURE notify_object_change();
+CREATE TRIGGER extent_truncate AFTER TRUNCATE ON extent FOR EACH STATEMENT
+    WHEN (current_setting('phobos.notify_object_changes', true) = 'on')
+    EXECUTE PROCEDURE notify_object_change();
@@ -56,6 +56,10 @@ struct io_chan_arg {
  * reference counting for this purpose.
  */
 struct exec_ctx {
+    GMainContext *context; /* Main context of the call, private so that
+                            * commands called by different threads run
+                            * concurrently
+                            */
     GMainLoop   *loop;  /* GMainLoop for the current context */
     int          ref;   /* Pending operations in the loop */
     int          rc;    /* Subprocess termination code (as an errno) */
@@ -175,9 +179,24 @@ static gboolean readline_cb(GIOChannel *channel, GIOCondition cond, gpointer ud)
     return true;
 }
 
+/** Attach a watcher to the main context of a command call */
+static void ctx_watch(struct exec_ctx *ctx, GSource *source, GSourceFunc func,
+                      gpointer data)
+{
+    ctx_incref(ctx);
+    g_source_set_callback(source, func, data, NULL);
+    g_source_attach(source, ctx->context);
+    g_source_unref(source);
+}
+
 /**
  * Execute synchronously an external command, read its output and invoke
  * a user-provided filter function on every line of it.
+ *
+ * The watchers of the command are attached to a main context of its own and
+ * not to the global default one: a loop running on the default context holds
+ * it, which would serialize the commands called by concurrent threads (e.g.
+ * LTFS formats of several device threads).
  */
 int command_call(const char *cmd_line, parse_cb_t cb_func, void *cb_arg)
 {
@@ -199,7 +218,8 @@ int command_call(const char *cmd_line, parse_cb_t cb_func, void *cb_arg)
         LOG_GOTO(out_err_free, rc = -EINVAL, "Cannot parse '%s': %s",
                  cmd_line, err_desc->message);
 
-    ctx.loop = g_main_loop_new(NULL, false);
+    ctx.context = g_main_context_new();
+    ctx.loop = g_main_loop_new(ctx.context, false);
     ctx.ref  = 0;
     ctx.rc   = 0;
 
@@ -221,8 +241,8 @@ int command_call(const char *cmd_line, parse_cb_t cb_func, void *cb_arg)
                  cmd_line, err_desc->message);
 
     /* register a watcher in the loop, thus increase refcount of our exec_ctx */
-    ctx_incref(&ctx);
-    g_child_watch_add(pid, watch_child_cb, &ctx);
+    ctx_watch(&ctx, g_child_watch_source_new(pid), (GSourceFunc)watch_child_cb,
+              &ctx);
 
     if (cb_func != NULL) {
         struct io_chan_arg  out_args = {
@@ -245,18 +265,18 @@ int command_call(const char *cmd_line, parse_cb_t cb_func, void *cb_arg)
         g_io_channel_set_close_on_unref(out_chan, true);
         g_io_channel_set_close_on_unref(err_chan, true);
 
-        /* update refcount for the two watchers */
-        ctx_incref(&ctx);
-        ctx_incref(&ctx);
-
-        g_io_add_watch(out_chan, G_IO_IN | G_IO_HUP, readline_cb, &out_args);
-        g_io_add_watch(err_chan, G_IO_IN | G_IO_HUP, readline_cb, &err_args);
+        /* the two watchers update the refcount */
+        ctx_watch(&ctx, g_io_create_watch(out_chan, G_IO_IN | G_IO_HUP),
+                  (GSourceFunc)readline_cb, &out_args);
+        ctx_watch(&ctx, g_io_create_watch(err_chan, G_IO_IN | G_IO_HUP),
+                  (GSourceFunc)readline_cb, &err_args);
     }
 
     g_main_loop_run(ctx.loop);
 
 out_free:
     g_main_loop_unref(ctx.loop);
+    g_main_context_unref(ctx.context);
     g_strfreev(av);
 
 out_err_free:
@@ -327,6 +347,29 @@ int64_t str2int64(const char *str)
     return val;
 }
 
+#define LTFS_STARTBLOCK_XATTR "user.ltfs.startblock"
+
+int64_t ltfs_start_block(const char *path)
+{
+    struct phobos_global_context *context = phobos_context();
+    char value[32];
+    int64_t block;
+    ssize_t len;
+
+    len = context->mock_ltfs.mock_getxattr(path, LTFS_STARTBLOCK_XATTR, value,
+                                           sizeof(value) - 1);
+    if (len < 0)
+        return -errno;
+
+    if (len == 0)
+        return -ENODATA;
+
+    value[len] = '\0';
+    block = str2int64(value);
+
+    return block < 0 ? -EINVAL : block;
+}
+
 char *uchar2hex(const unsigned char *buf, int buf_size)
 {
     char *hex = xcalloc(buf_size * 2 + 1, sizeof(char));
@@ -30,6 +30,7 @@
 #include <errno.h>
 #include <jansson.h>
 #include <math.h>
+#include <sched.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -417,60 +418,172 @@ void layout_info_free_extents(struct layout_info *layout)
     layout->extents = NULL;
 }
 
+static int copy_attr_cb(const char *key, const char *value, void *udata)
+{
+    pho_attr_set(udata, key, value);
+    return 0;
+}
+
+struct layout_info *layout_info_dup(const struct layout_info *layout)
+{
+    struct layout_info *dup;
+    int i;
+
+    dup = xcalloc(1, sizeof(*dup));
+    dup->oid = xstrdup_safe(layout->oid);
+    dup->uuid = xstrdup_safe(layout->uuid);
+    dup->version = layout->version;
+    dup->wr_size = layout->wr_size;
+
+    dup->layout_desc.mod_name = xstrdup_safe(layout->layout_desc.mod_name);
+    dup->layout_desc.mod_major = layout->layout_desc.mod_major;
+    dup->layout_desc.mod_minor = layout->layout_desc.mod_minor;
+    pho_attrs_foreach(&layout->layout_desc.mod_attrs, copy_attr_cb,
+                      &dup->layout_desc.mod_attrs);
+
+    dup->ext_count = layout->ext_count;
+    if (layout->ext_count == 0)
+        return dup;
+
+    dup->extents = xmalloc(layout->ext_count * sizeof(*dup->extents));
+    for (i = 0; i < layout->ext_count; i++) {
+        struct extent *extent = &dup->extents[i];
+
+        *extent = layout->extents[i];
+        extent->uuid = xstrdup_safe(layout->extents[i].uuid);
+        extent->address.buff = xstrdup_safe(layout->extents[i].address.buff);
+        extent->info.attr_set = NULL;
+        pho_attrs_foreach(&layout->extents[i].info, copy_attr_cb,
+                          &extent->info);
+    }
+
+    return dup;
+}
+
+void layout_info_free(struct layout_info *layout)
+{
+    int i;
+
+    if (!layout)
+        return;
+
+    for (i = 0; i < layout->ext_count; i++)
+        pho_attrs_free(&layout->extents[i].info);
+
+    layout_info_free_extents(layout);
+    free(layout->layout_desc.mod_name);
+    pho_attrs_free(&layout->layout_desc.mod_attrs);
+    free(layout->oid);
+    free(layout->uuid);
+    free(layout);
+}
+
 int tsqueue_init(struct tsqueue *tsqueue)
 {
-    int rc;
+    struct tsqueue_node *stub = xmalloc(sizeof(*stub));
 
-    rc = pthread_mutex_init(&tsqueue->mutex, NULL);
-    if (rc)
-        LOG_RETURN(-rc, "Unable to init threadsafe queue mutex");
+    /* the tail is always a node whose element was already popped */
+    stub->data = NULL;
+    atomic_init(&stub->next, NULL);
 
-    tsqueue->queue = g_queue_new();
+    atomic_init(&tsqueue->head, stub);
+    atomic_init(&tsqueue->tail, stub);
+    atomic_init(&tsqueue->length, 0);
+    tsqueue->notify = NULL;
+    tsqueue->notify_arg = NULL;
+    atomic_init(&tsqueue->n_pushed, 0);
+    atomic_init(&tsqueue->n_waits, 0);
 
     return 0;
 }
 
+void tsqueue_set_notify(struct tsqueue *tsq, void (*notify)(void *arg),
+                        void *arg)
+{
+    tsq->notify = notify;
+    tsq->notify_arg = arg;
+}
+
 void tsqueue_destroy(struct tsqueue *tsq, GDestroyNotify free_func)
 {
-    int rc;
+    void *data;
 
-    if (free_func == NULL)
-        g_queue_free(tsq->queue);
-    else
-        g_queue_free_full(tsq->queue, free_func);
+    while ((data = tsqueue_pop(tsq)) != NULL)
+        if (free_func)
+            free_func(data);
 
-    rc = pthread_mutex_destroy(&tsq->mutex);
-    if (rc)
-        pho_error(-rc, "Unable to destroy threadsafe queue mutex");
+    free(atomic_load(&tsq->tail));
+    atomic_store(&tsq->tail, NULL);
 }
 
 void *tsqueue_pop(struct tsqueue *tsq)
 {
+    struct tsqueue_node *tail;
+    struct tsqueue_node *next;
     void *data;
 
-    MUTEX_LOCK(&tsq->mutex);
-    data = g_queue_pop_tail(tsq->queue);
-    MUTEX_UNLOCK(&tsq->mutex);
+    tail = atomic_load_explicit(&tsq->tail, memory_order_relaxed);
+    next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    if (!next) {
+        /* sequentially consistent with the exchange of the head and the load
+         * of the tail in tsqueue_push: either the new head is seen here, or
+         * the producer sees that the queue was empty and notifies
+         */
+        if (atomic_load(&tsq->head) == tail)
+            return NULL;
+
+        /* a producer swapped the head but did not link its element yet, it
+         * is only a few instructions away
+         */
+        atomic_fetch_add_explicit(&tsq->n_waits, 1, memory_order_relaxed);
+        while (!(next = atomic_load_explicit(&tail->next,
+                                             memory_order_acquire)))
+            sched_yield();
+    }
+
+    data = next->data;
+    atomic_store(&tsq->tail, next);
+    free(tail);
+    atomic_fetch_sub_explicit(&tsq->length, 1, memory_order_relaxed);
 
     return data;
 }
 
 void tsqueue_push(struct tsqueue *tsq, void *data)
 {
-    MUTEX_LOCK(&tsq->mutex);
-    g_queue_push_head(tsq->queue, data);
-    MUTEX_UNLOCK(&tsq->mutex);
+    struct tsqueue_node *node = xmalloc(sizeof(*node));
+    struct tsqueue_node *prev;
+    bool was_empty;
+
+    node->data = data;
+    atomic_init(&node->next, NULL);
+
+    /* counted before being reachable, so that the length never underflows */
+    atomic_fetch_add_explicit(&tsq->length, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&tsq->n_pushed, 1, memory_order_relaxed);
+
+    prev = atomic_exchange(&tsq->head, node);
+    /* prev cannot be freed before being linked to node. If it is the tail,
+     * every element before ours was popped and the consumer may have found
+     * the queue empty: it must be woken up. Otherwise, the consumer will reach
+     * prev and wait for the link below.
+     */
+    was_empty = atomic_load(&tsq->tail) == prev;
+    atomic_store_explicit(&prev->next, node, memory_order_release);
+
+    if (was_empty && tsq->notify)
+        tsq->notify(tsq->notify_arg);
 }
 
 unsigned int tsqueue_get_length(struct tsqueue *tsq)
 {
-    unsigned int length;
-
-    MUTEX_LOCK(&tsq->mutex);
-    length = g_queue_get_length(tsq->queue);
-    MUTEX_UNLOCK(&tsq->mutex);
+    return atomic_load_explicit(&tsq->length, memory_order_relaxed);
+}
 
-    return length;
+void tsqueue_log_stats(struct tsqueue *tsq, const char *name)
+{
+    pho_verb("Queue '%s': %lu elements pushed, %lu pops waited for a producer",
+             name, atomic_load(&tsq->n_pushed), atomic_load(&tsq->n_waits));
 }
 
 struct pho_id *pho_id_dup(const struct pho_id *src)
@@ -34,10 +34,12 @@
 #include <fcntl.h>
 #include <netdb.h>
 #include <net/if.h>
+#include <poll.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -524,7 +526,125 @@ static void _release_comm_recv_info(struct _pho_comm_recv_info *cri)
 
 static void _release_event(void *key, void *val, void *udata)
 {
-    _release_comm_recv_info((struct _pho_comm_recv_info *)val);
+    struct _pho_comm_recv_info *cri = val;
+    struct pho_comm_info *ci = udata;
+
+    /* the listening socket of a worker is closed by its server */
+    if (ci->shared_socket && cri->fd == ci->socket_fd) {
+        free(cri);
+        return;
+    }
+
+    _release_comm_recv_info(cri);
+}
+
+/** Add a descriptor polled for input to the socket poll of a server */
+static int _poll_add(struct pho_comm_info *ci, int fd, uint32_t events)
+{
+    struct _pho_comm_recv_info *cri;
+    struct epoll_event ev;
+
+    cri = xmalloc(sizeof(*cri));
+    _init_comm_recv_info(cri, fd, PHO_CRI_MSG_SIZE, 0, 0, NULL);
+
+    ev.events = events;
+    ev.data.ptr = cri;
+    if (epoll_ctl(ci->epoll_fd, EPOLL_CTL_ADD, fd, &ev)) {
+        free(cri);
+        return -errno;
+    }
+
+    g_hash_table_insert(ci->ev_tab, &cri->fd, cri);
+
+    return 0;
+}
+
+int pho_comm_open_worker(struct pho_comm_info *worker,
+                         const struct pho_comm_info *server)
+{
+    uint32_t events = EPOLLIN;
+    int flags;
+    int rc;
+
+    *worker = pho_comm_info_init();
+    worker->type = server->type;
+    worker->socket_fd = server->socket_fd;
+    worker->shared_socket = true;
+
+    /* offline mode */
+    if (server->socket_fd < 0)
+        return 0;
+
+    /* a worker may be woken up for a client accepted by another one */
+    flags = fcntl(server->socket_fd, F_GETFL);
+    if (flags == -1 ||
+        fcntl(server->socket_fd, F_SETFL, flags | O_NONBLOCK) == -1)
+        LOG_RETURN(-errno, "Failed to make socket '%s' non-blocking",
+                   server->path);
+
+#ifdef EPOLLEXCLUSIVE
+    /* only wake up one of the idle workers for each new client */
+    events |= EPOLLEXCLUSIVE;
+#endif
+
+    worker->path = xstrdup(server->path);
+    worker->ev_tab = g_hash_table_new(NULL, NULL);
+
+    worker->epoll_fd = epoll_create(1);
+    if (worker->epoll_fd == -1)
+        LOG_GOTO(out_err, rc = -errno, "Socket poll creation failed");
+
+    rc = _poll_add(worker, worker->socket_fd, events);
+    if (rc)
+        LOG_GOTO(out_err, rc, "Socket poll control failed in adding(%s)",
+                 worker->path);
+
+    worker->wakeup_fd = eventfd(0, EFD_NONBLOCK);
+    if (worker->wakeup_fd == -1)
+        LOG_GOTO(out_err, rc = -errno, "Failed to create wakeup event");
+
+    rc = _poll_add(worker, worker->wakeup_fd, EPOLLIN);
+    if (rc) {
+        close(worker->wakeup_fd);
+        LOG_GOTO(out_err, rc, "Socket poll control failed in adding wakeup "
+                 "event");
+    }
+
+    return 0;
+
+out_err:
+    pho_comm_close(worker);
+    *worker = pho_comm_info_init();
+
+    return rc;
+}
+
+int pho_comm_wakeup_enable(struct pho_comm_info *ci)
+{
+    assert(ci->type == PHO_COMM_UNIX_CLIENT || ci->type == PHO_COMM_TCP_CLIENT);
+
+    if (ci->wakeup_fd >= 0)
+        return 0;
+
+    ci->wakeup_fd = eventfd(0, EFD_NONBLOCK);
+    if (ci->wakeup_fd == -1)
+        LOG_RETURN(-errno, "Failed to create wakeup event");
+
+    return 0;
+}
+
+int pho_comm_wakeup(struct pho_comm_info *ci)
+{
+    uint64_t one = 1;
+
+    if (ci->wakeup_fd < 0)
+        return -EINVAL;
+
+    /* EAGAIN: the counter is saturated, a wakeup is pending anyway */
+    if (write(ci->wakeup_fd, &one, sizeof(one)) == -1 && errno != EAGAIN)
+        LOG_RETURN(-errno, "Failed to wake up socket poll");
+
+    return 0;
 }
 
 int pho_comm_close(struct pho_comm_info *ci)
@@ -539,18 +659,25 @@ int pho_comm_close(struct pho_comm_info *ci)
         if (close(ci->socket_fd))
             rc = -errno;
 
+        if (ci->wakeup_fd >= 0) {
+            close(ci->wakeup_fd);
+            ci->wakeup_fd = -1;
+        }
+
         free(ci->path);
         return rc;
     }
 
-    /* close sockets (including ci->socket_fd) and free event information */
-    g_hash_table_foreach(ci->ev_tab, _release_event, NULL);
+    /* close sockets (including ci->socket_fd if it is not shared) and free
+     * event information
+     */
+    g_hash_table_foreach(ci->ev_tab, _release_event, ci);
     g_hash_table_destroy(ci->ev_tab);
 
     if (close(ci->epoll_fd))
         rc = -errno;
 
-    if (ci->type == PHO_COMM_UNIX_SERVER) {
+    if (ci->type == PHO_COMM_UNIX_SERVER && !ci->shared_socket) {
         if (unlink(ci->path))
             rc = rc ? : -errno;
     }
@@ -720,6 +847,9 @@ static int _process_accept(struct pho_comm_info *ci,
     /* accepting a new client */
     lensocka = sizeof(socka);
     sfd = accept(cri->fd, (struct sockaddr *) &socka, &lensocka);
+    if (sfd == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        /* accepted by another worker of the same socket */
+        return 0;
     if (sfd == -1)
         LOG_RETURN(-errno, "Socket accept failed");
 
@@ -856,6 +986,14 @@ static int _recv_server(struct pho_comm_info *ci, struct pho_comm_data **data,
         struct _pho_comm_recv_info *cri
             = (struct _pho_comm_recv_info *) ev[idx_event].data.ptr;
 
+        if (cri->fd == ci->wakeup_fd) { /* wakeup event */
+            uint64_t count;
+
+            if (read(cri->fd, &count, sizeof(count)) == -1 && errno != EAGAIN)
+                pho_warn("Failed to clear wakeup event: %s", strerror(errno));
+            continue;
+        }
+
         if (cri->fd == ci->socket_fd) { /* accept socket */
             rc = _process_accept(ci, cri);
             if (rc) {
@@ -941,3 +1079,48 @@ int pho_comm_recv(struct pho_comm_info *ci, struct pho_comm_data **data,
 
     return _recv_client(ci, data, nb_data);
 }
+
+int pho_comm_wait(struct pho_comm_info *ci, int timeout_ms)
+{
+    struct pollfd pfd[2];
+    nfds_t nfds = 1;
+    int rc;
+
+    assert(ci->socket_fd >= 0); /* if assert, programming error */
+    assert(ci->type == PHO_COMM_UNIX_CLIENT || ci->type == PHO_COMM_TCP_CLIENT);
+
+    pfd[0].fd = ci->socket_fd;
+    pfd[0].events = POLLIN;
+    pfd[0].revents = 0;
+
+    if (ci->wakeup_fd >= 0) {
+        pfd[1].fd = ci->wakeup_fd;
+        pfd[1].events = POLLIN;
+        pfd[1].revents = 0;
+        nfds++;
+    }
+
+    do {
+        rc = poll(pfd, nfds, timeout_ms);
+    } while (rc == -1 && errno == EINTR);
+
+    if (rc == -1)
+        LOG_RETURN(-errno, "Socket poll failed");
+
+    if (rc == 0)
+        return -ETIMEDOUT;
+
+    if (nfds > 1 && pfd[1].revents) {
+        uint64_t count;
+
+        if (read(ci->wakeup_fd, &count, sizeof(count)) == -1 &&
+            errno != EAGAIN)
+            pho_warn("Failed to clear wakeup event: %s", strerror(errno));
+
+        if (!pfd[0].revents)
+            return -EINTR;
+    }
+
+    /* Errors and hang-ups are reported by the following pho_comm_recv() */
+    return 0;
+}
@@ -45,11 +45,12 @@
 #include "dss_config.h"
 #include "dss_utils.h"
 #include "filters.h"
+#include "full_layout.h"
 #include "media.h"
 #include "resources.h"
 #include "object.h"
 
-#define SCHEMA_INFO "2.2"
+#define SCHEMA_INFO "2.3"
 
 struct dss_result {
     PGresult *pg_res;
@@ -116,6 +117,8 @@ int dss_init(struct dss_handle *handle)
     const char *conn_str;
     int rc;
 
+    handle->dh_prepared = NULL;
+
     /* init static config parsing */
     rc = parse_supported_tape_models();
     if (rc && rc != -EALREADY)
@@ -138,12 +141,78 @@ int dss_init(struct dss_handle *handle)
 
     (void)PQsetNoticeProcessor(handle->dh_conn, dss_pg_logger, NULL);
 
+    /* prepared statements only live as long as the connection */
+    handle->dh_prepared = g_hash_table_new(g_str_hash, g_str_equal);
+
     return check_db_version(handle);
 }
 
 void dss_fini(struct dss_handle *handle)
 {
     PQfinish(handle->dh_conn);
+    if (handle->dh_prepared) {
+        g_hash_table_destroy(handle->dh_prepared);
+        handle->dh_prepared = NULL;
+    }
+}
+
+int dss_listen(struct dss_handle *handle, const char *channel)
+{
+    PGconn *conn = handle->dh_conn;
+    GString *request;
+    PGresult *res;
+    char *escaped;
+    int rc;
+
+    escaped = PQescapeIdentifier(conn, channel, strlen(channel));
+    if (!escaped)
+        LOG_RETURN(-ENOMEM, "Failed to escape channel '%s': %s", channel,
+                   PQerrorMessage(conn));
+
+    request = g_string_new(NULL);
+    g_string_printf(request, "LISTEN %s;", escaped);
+    PQfreemem(escaped);
+
+    rc = execute(conn, request->str, &res, PGRES_COMMAND_OK);
+    PQclear(res);
+    g_string_free(request, true);
+
+    return rc;
+}
+
+int dss_object_changes_notified(struct dss_handle *handle, bool *notified)
+{
+    PGresult *res;
+    int rc;
+
+    rc = execute(handle->dh_conn,
+                 "SELECT current_setting('" DSS_OBJECT_CHANGE_SETTING "', "
+                 "true) = 'on';", &res, PGRES_TUPLES_OK);
+    if (!rc)
+        *notified = !PQgetisnull(res, 0, 0) &&
+                    !strcmp(PQgetvalue(res, 0, 0), "t");
+
+    PQclear(res);
+
+    return rc;
+}
+
+int dss_notifications_consume(struct dss_handle *handle,
+                              dss_notification_cb_t cb, void *udata)
+{
+    PGconn *conn = handle->dh_conn;
+    PGnotify *notify;
+
+    if (!PQconsumeInput(conn) || PQstatus(conn) != CONNECTION_OK)
+        LOG_RETURN(-ENOTCONN, "Failed to read notifications: %s",
+                   PQerrorMessage(conn));
+
+    while ((notify = PQnotifies(conn)) != NULL) {
+        cb(notify->relname, notify->extra, udata);
+        PQfreemem(notify);
+    }
+
+    return 0;
 }
 
 static void _dss_result_free(struct dss_result *dss_res, int item_cnt)
@@ -161,17 +230,110 @@ static void _dss_result_free(struct dss_result *dss_res, int item_cnt)
 
 }
 
+/**
+ * Convert the rows of \p res to items of \p type. The result is owned by the
+ * returned item list, and is freed with it or on error.
+ */
+static int dss_result_build(struct dss_handle *handle, enum dss_type type,
+                            PGresult *res, void **item_list, int *item_cnt)
+{
+    struct dss_result *dss_res;
+    size_t dss_res_size;
+    size_t item_size;
+    int rc = 0;
+    int i;
+
+    item_size = get_resource_size(type);
+
+    dss_res_size = sizeof(struct dss_result) + PQntuples(res) * item_size;
+    dss_res = xcalloc(1, dss_res_size);
+
+    dss_res->item_type = type;
+    dss_res->pg_res = res;
+
+    for (i = 0; i < PQntuples(res); i++) {
+        void *item_ptr = (char *)&dss_res->items.raw + i * item_size;
+
+        rc = create_resource(type, handle, item_ptr, res, i);
+        if (rc) {
+            /* Only free elements that were initialized, this also frees res */
+            _dss_result_free(dss_res, i);
+            return rc;
+        }
+    }
+
+    *item_list = &dss_res->items.raw;
+    *item_cnt = PQntuples(res);
+
+    return 0;
+}
+
+/** Layouts being decoded from the rows of a full layout select */
+struct full_layout_stream {
+    struct dss_result *result;
+    int count;
+    int capacity;
+};
+
+static int full_layout_stream_row(PGresult *res, int row_num, void *udata)
+{
+    struct full_layout_stream *stream = udata;
+    struct layout_info *layouts;
+    int rc;
+
+    if (stream->count == stream->capacity) {
+        stream->capacity = stream->capacity ? 2 * stream->capacity : 16;
+        stream->result = xrealloc(stream->result,
+                                  sizeof(*stream->result) +
+                                  stream->capacity * sizeof(*layouts));
+    }
+
+    layouts = stream->result->items.layout;
+    rc = full_layout_add_row(stream->count ? &layouts[stream->count - 1] :
+                                             NULL,
+                             &layouts[stream->count], res, row_num);
+    if (rc < 0)
+        return rc;
+
+    stream->count += rc;
+
+    return 0;
+}
+
+/**
+ * Receive the rows of the full layout select just sent, one chunk at a time,
+ * and group them into layouts. Unlike dss_result_build, the whole result is
+ * never held in memory, the items own their strings.
+ */
+static int dss_full_layout_stream(struct dss_handle *handle, void **item_list,
+                                  int *item_cnt)
+{
+    struct full_layout_stream stream = { .count = 0 };
+    int rc;
+
+    stream.result = xcalloc(1, sizeof(*stream.result));
+    stream.result->item_type = DSS_FULL_LAYOUT;
+
+    rc = stream_rows(handle->dh_conn, full_layout_stream_row, &stream);
+    if (rc) {
+        _dss_result_free(stream.result, stream.count);
+        return rc;
+    }
+
+    *item_list = &stream.result->items.raw;
+    *item_cnt = stream.count;
+
+    return 0;
+}
+
 static int dss_generic_get(struct dss_handle *handle, enum dss_type type,
                            const struct dss_filter **filters, int filters_count,
                            void **item_list, int *item_cnt,
                            struct dss_sort *sort)
 {
     PGconn *conn = handle->dh_conn;
-    struct dss_result *dss_res;
     GString *clause = NULL;
     GString **conditions;
-    size_t dss_res_size;
-    size_t item_size;
     PGresult *res;
     int rc = 0;
     int i = 0;
@@ -209,45 +371,96 @@ static int dss_generic_get(struct dss_handle *handle, enum dss_type type,
         return rc;
     }
 
-    pho_debug("Executing request: '%s'", clause->str);
-
-    rc = execute(conn, clause->str, &res, PGRES_TUPLES_OK);
-    g_string_free(clause, true);
-    if (rc)
-        return rc;
-
-    item_size = get_resource_size(type);
-
-    dss_res_size = sizeof(struct dss_result) + PQntuples(res) * item_size;
-    dss_res = xcalloc(1, dss_res_size);
+    if (type == DSS_FULL_LAYOUT) {
+        /* a layout may have millions of extents, stream them */
+        rc = send_query(conn, clause->str);
+        g_string_free(clause, true);
+        if (rc)
+            return rc;
 
-    dss_res->item_type = type;
-    dss_res->pg_res = res;
+        rc = dss_full_layout_stream(handle, item_list, item_cnt);
+        if (rc)
+            return rc;
+    } else {
+        pho_debug("Executing request: '%s'", clause->str);
 
-    for (i = 0; i < PQntuples(res); i++) {
-        void *item_ptr = (char *)&dss_res->items.raw + i * item_size;
+        rc = execute(conn, clause->str, &res, PGRES_TUPLES_OK);
+        g_string_free(clause, true);
+        if (rc) {
+            PQclear(res);
+            return rc;
+        }
 
-        rc = create_resource(type, handle, item_ptr, res, i);
+        rc = dss_result_build(handle, type, res, item_list, item_cnt);
         if (rc)
-            goto out;
+            return rc;
     }
 
-    *item_list = &dss_res->items.raw;
-    *item_cnt = PQntuples(res);
-
     if (sort && !sort->psql_sort) {
         if (type == DSS_FULL_LAYOUT && !strcmp(sort->attr, "size")) {
-            quicksort(item_list, 0, *item_cnt - 1, item_size, sort->reverse,
-                      cmp_size);
+            quicksort(item_list, 0, *item_cnt - 1, get_resource_size(type),
+                      sort->reverse, cmp_size);
+        } else if (type == DSS_FULL_LAYOUT &&
+                   !strcmp(sort->attr, "ext_count")) {
+            quicksort(item_list, 0, *item_cnt - 1, get_resource_size(type),
+                      sort->reverse, cmp_ext_count);
         }
     }
 
-out:
+    return 0;
+}
+
+/**
+ * Execute a prepared select and convert its rows to items of \p type, the
+ * counterpart of dss_generic_get for the queries whose shape is fixed.
+ */
+static int dss_prepared_get(struct dss_handle *handle, enum dss_type type,
+                            const struct dss_prepared *stmt,
+                            const struct dss_params *params,
+                            void **item_list, int *item_cnt)
+{
+    PGresult *res;
+    int rc;
+
+    ENTRY;
+
+    if (handle->dh_conn == NULL || item_list == NULL || item_cnt == NULL)
+        LOG_RETURN(-EINVAL, "dss - conn: %p, item_list: %p, item_cnt: %p",
+                   handle->dh_conn, item_list, item_cnt);
+
+    *item_list = NULL;
+    *item_cnt = 0;
+
+    rc = execute_prepared(handle, stmt, params, &res, PGRES_TUPLES_OK);
+    if (rc) {
+        PQclear(res);
+        return rc;
+    }
+
+    return dss_result_build(handle, type, res, item_list, item_cnt);
+}
+
+/**
+ * Insert the items with the prepared statements of their type, in a single
+ * transaction sent in one round trip when libpq supports pipelining.
+ *
+ * \return -ENOTSUP if the type has no prepared insert, nothing is done then
+ */
+static int dss_prepared_insert(struct dss_handle *handle, enum dss_type type,
+                               void *item_list, int item_cnt, int64_t fields)
+{
+    int rc;
+
+    if (!has_insert_prepared(type))
+        return -ENOTSUP;
+
+    rc = prepared_transaction_begin(handle);
     if (rc)
-        /* Only free elements that were initialized, this also frees res */
-        _dss_result_free(dss_res, i);
+        return rc;
 
-    return rc;
+    rc = insert_prepared(type, handle, item_list, item_cnt, fields);
+
+    return prepared_transaction_end(handle, rc);
 }
 
 static int dss_generic_set(struct dss_handle *handle, enum dss_type type,
@@ -265,6 +478,18 @@ static int dss_generic_set(struct dss_handle *handle, enum dss_type type,
         LOG_RETURN(-EINVAL, "conn: %p, item_list: %p, item_cnt: %d",
                    conn, item_list, item_cnt);
 
+    /* A batch is sent as a single multi-row insert, planned once for all
+     * its rows, rather than as one prepared execution per row.
+     */
+    if (item_cnt == 1 &&
+        (action == DSS_SET_INSERT || action == DSS_SET_FULL_INSERT)) {
+        rc = dss_prepared_insert(handle, type, item_list, item_cnt,
+                                 action == DSS_SET_INSERT ? INSERT_OBJECT :
+                                                            INSERT_FULL_OBJECT);
+        if (rc != -ENOTSUP)
+            return rc;
+    }
+
     request = g_string_new("BEGIN;");
 
     switch (action) {
@@ -505,6 +730,76 @@ int dss_media_get(struct dss_handle *handle, const struct dss_filter *filter,
                            (void **) media_list, media_count, sort);
 }
 
+int dss_media_get_from_id(struct dss_handle *handle,
+                          const struct pho_id *medium_id,
+                          struct media_info **media_list, int *media_count)
+{
+    struct dss_params params = { .count = 0 };
+
+    dss_param_str(&params, rsc_family2str(medium_id->family));
+    dss_param_str(&params, medium_id->name);
+    dss_param_str(&params, medium_id->library);
+
+    return dss_prepared_get(handle, DSS_MEDIA, &media_from_id_stmt, &params,
+                            (void **) media_list, media_count);
+}
+
+int dss_media_get_from_ids(struct dss_handle *handle,
+                           const struct pho_id *medium_ids, int count,
+                           struct media_info **media_list, int *media_count)
+{
+    PGconn *conn = handle->dh_conn;
+    GString *request;
+    PGresult *res;
+    int rc;
+    int i;
+
+    ENTRY;
+
+    if (conn == NULL || media_list == NULL || media_count == NULL)
+        LOG_RETURN(-EINVAL, "dss - conn: %p, media_list: %p, media_count: %p",
+                   conn, media_list, media_count);
+
+    *media_list = NULL;
+    *media_count = 0;
+    if (count == 0)
+        return 0;
+
+    request = g_string_new(media_with_lock_select);
+    g_string_append(request,
+                    " WHERE (media.family, media.id, media.library) IN (");
+    for (i = 0; i < count; i++) {
+        char *name = dss_char4sql(conn, medium_ids[i].name);
+        char *library = dss_char4sql(conn, medium_ids[i].library);
+
+        if (!name || !library) {
+            free_dss_char4sql(name);
+            free_dss_char4sql(library);
+            g_string_free(request, true);
+            return -EINVAL;
+        }
+
+        g_string_append_printf(request, "%s('%s', %s, %s)", i ? ", " : "",
+                               rsc_family2str(medium_ids[i].family), name,
+                               library);
+        free_dss_char4sql(name);
+        free_dss_char4sql(library);
+    }
+    g_string_append(request, ");");
+
+    pho_debug("Executing request: '%s'", request->str);
+
+    rc = execute(conn, request->str, &res, PGRES_TUPLES_OK);
+    g_string_free(request, true);
+    if (rc) {
+        PQclear(res);
+        return rc;
+    }
+
+    return dss_result_build(handle, DSS_MEDIA, res, (void **) media_list,
+                            media_count);
+}
+
 int dss_media_delete(struct dss_handle *handle, struct media_info *media_list,
                      int media_count)
 {
@@ -532,6 +827,52 @@ int dss_layout_insert(struct dss_handle *handle,
                            layout_count, DSS_SET_INSERT);
 }
 
+int dss_layouts_save(struct dss_handle *handle, struct layout_info *layouts,
+                     int layout_count)
+{
+    PGconn *conn = handle->dh_conn;
+    struct object_info *objects;
+    GString *request;
+    int rc = 0;
+    int i;
+
+    ENTRY;
+
+    if (conn == NULL || layouts == NULL || layout_count == 0)
+        LOG_RETURN(-EINVAL, "conn: %p, layouts: %p, layout_count: %d",
+                   conn, layouts, layout_count);
+
+    objects = xcalloc(layout_count, sizeof(*objects));
+    request = g_string_new("BEGIN;");
+
+    for (i = 0; i < layout_count; i++) {
+        rc = get_insert_query(DSS_EXTENT, conn, layouts[i].extents,
+                              layouts[i].ext_count, INSERT_OBJECT, request);
+        if (rc)
+            LOG_GOTO(out_cleanup, rc, "SQL request build failed");
+
+        objects[i].oid = layouts[i].oid;
+        objects[i].obj_status = PHO_OBJ_STATUS_COMPLETE;
+    }
+
+    rc = get_insert_query(DSS_LAYOUT, conn, layouts, layout_count,
+                          INSERT_OBJECT, request);
+    if (rc)
+        LOG_GOTO(out_cleanup, rc, "SQL request build failed");
+
+    rc = get_update_query(DSS_OBJECT, conn, objects, objects, layout_count,
+                          DSS_OBJECT_UPDATE_OBJ_STATUS, request);
+    if (rc)
+        LOG_GOTO(out_cleanup, rc, "SQL request build failed");
+
+    rc = execute_and_commit_or_rollback(conn, request, NULL, PGRES_COMMAND_OK);
+
+out_cleanup:
+    g_string_free(request, true);
+    free(objects);
+    return rc;
+}
+
 int dss_layout_delete(struct dss_handle *handle,
                       struct layout_info *layout_list, int layout_count)
 {
@@ -554,6 +895,30 @@ int dss_full_layout_get(struct dss_handle *hdl, const struct dss_filter *object,
                            layout_count, sort);
 }
 
+int dss_full_layout_get_from_uuid(struct dss_handle *hdl, const char *uuid,
+                                  int version, struct layout_info **layouts,
+                                  int *layout_count)
+{
+    struct dss_params params = { .count = 0 };
+    int rc;
+
+    if (hdl->dh_conn == NULL || layouts == NULL || layout_count == NULL)
+        LOG_RETURN(-EINVAL, "dss - conn: %p, item_list: %p, item_cnt: %p",
+                   hdl->dh_conn, layouts, layout_count);
+
+    *layouts = NULL;
+    *layout_count = 0;
+
+    dss_param_str(&params, uuid);
+    dss_param_int4(&params, version);
+
+    rc = send_prepared(hdl, &full_layout_from_uuid_stmt, &params);
+    if (rc)
+        return rc;
+
+    return dss_full_layout_stream(hdl, (void **)layouts, layout_count);
+}
+
 /*
  * EXTENT FUNCTIONS
  */
@@ -0,0 +1,358 @@
+/* -*- mode: c; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief  Asynchronous writer of Phobos's Distributed State Service.
+ *
+ * The updates handed over to the writer are queued and written by its own
+ * thread, on its own connection. The updates queued while a batch is written
+ * form the next batch: under load, the cost of a round trip to the database is
+ * shared by all the updates of a batch.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <glib.h>
+#include <pthread.h>
+
+#include "pho_common.h"
+#include "pho_dss.h"
+#include "pho_type_utils.h"
+
+#include "logs.h"
+
+enum dss_async_op_type {
+    DSS_ASYNC_LOG,
+    DSS_ASYNC_MEDIA_UPDATE,
+};
+
+struct dss_async_op {
+    enum dss_async_op_type type;
+    union {
+        struct pho_log log;
+        struct {
+            struct media_info *medium;
+            uint64_t fields;
+        } media;
+    };
+};
+
+struct dss_async {
+    struct dss_handle dss;          /**< Connection of the writer thread */
+    pthread_t tid;                  /**< Writer thread */
+    pthread_mutex_t mutex;          /**< Protects the fields below */
+    pthread_cond_t cond;            /**< Signals new operations to the writer
+                                      *  and written batches to the waiters
+                                      */
+    GQueue *pending;                /**< Operations of the next batch */
+    GQueue *running;                /**< Operations being written, NULL if
+                                      *  none
+                                      */
+    unsigned long n_queued;         /**< Operations queued since the start */
+    unsigned long n_written;        /**< Operations written or cancelled since
+                                      *  the start
+                                      */
+    bool stopping;                  /**< Stop once the queue is empty */
+};
+
+static void dss_async_op_free(struct dss_async_op *op)
+{
+    switch (op->type) {
+    case DSS_ASYNC_LOG:
+        if (op->log.message)
+            json_decref(op->log.message);
+        break;
+    case DSS_ASYNC_MEDIA_UPDATE:
+        media_info_free(op->media.medium);
+        break;
+    }
+
+    free(op);
+}
+
+/* Write the media updates of \p ops, one call per set of fields */
+static void dss_async_write_media(struct dss_handle *dss, GPtrArray *ops)
+{
+    struct media_info *media;
+    guint done = 0;
+    bool *written;
+    guint i;
+    int rc;
+
+    media = xcalloc(ops->len, sizeof(*media));
+    written = xcalloc(ops->len, sizeof(*written));
+
+    while (done < ops->len) {
+        uint64_t fields = 0;
+        int count = 0;
+
+        for (i = 0; i < ops->len; i++) {
+            struct dss_async_op *op = g_ptr_array_index(ops, i);
+
+            if (written[i])
+                continue;
+
+            if (count == 0)
+                fields = op->media.fields;
+            else if (op->media.fields != fields)
+                continue;
+
+            /* shallow copy, the ops are left untouched as
+             * dss_async_media_cancel may look at them
+             */
+            media[count++] = *op->media.medium;
+            written[i] = true;
+            done++;
+        }
+
+        rc = dss_media_update(dss, media, media, count, fields);
+        if (rc)
+            pho_error(rc, "Failed to update %d media asynchronously", count);
+    }
+
+    free(written);
+    free(media);
+}
+
+static void dss_async_write(struct dss_async *async, GQueue *batch)
+{
+    GPtrArray *media_ops = g_ptr_array_new();
+    GArray *logs = g_array_new(false, false, sizeof(struct pho_log));
+    GList *item;
+
+    for (item = batch->head; item; item = item->next) {
+        struct dss_async_op *op = item->data;
+
+        if (op->type == DSS_ASYNC_LOG)
+            g_array_append_val(logs, op->log);
+        else
+            g_ptr_array_add(media_ops, op);
+    }
+
+    pho_debug("Writing %u logs and %u media updates", logs->len,
+              media_ops->len);
+
+    logs_emit(&async->dss, (struct pho_log *)logs->data, logs->len);
+    if (media_ops->len)
+        dss_async_write_media(&async->dss, media_ops);
+
+    g_array_free(logs, true);
+    g_ptr_array_free(media_ops, true);
+}
+
+static void *dss_async_thread(void *arg)
+{
+    struct dss_async *async = arg;
+
+    MUTEX_LOCK(&async->mutex);
+    while (true) {
+        GQueue *batch;
+
+        while (g_queue_is_empty(async->pending) && !async->stopping)
+            pthread_cond_wait(&async->cond, &async->mutex);
+
+        if (g_queue_is_empty(async->pending))
+            break;
+
+        batch = async->pending;
+        async->pending = g_queue_new();
+        async->running = batch;
+        MUTEX_UNLOCK(&async->mutex);
+
+        dss_async_write(async, batch);
+
+        MUTEX_LOCK(&async->mutex);
+        async->n_written += g_queue_get_length(batch);
+        async->running = NULL;
+        pthread_cond_broadcast(&async->cond);
+
+        g_queue_free_full(batch, (GDestroyNotify)dss_async_op_free);
+    }
+    MUTEX_UNLOCK(&async->mutex);
+
+    return NULL;
+}
+
+int dss_async_init(struct dss_async **async)
+{
+    struct dss_async *writer;
+    int rc;
+
+    writer = xcalloc(1, sizeof(*writer));
+
+    rc = dss_init(&writer->dss);
+    if (rc)
+        LOG_GOTO(free_writer, rc, "Failed to init asynchronous dss handle");
+
+    pthread_mutex_init(&writer->mutex, NULL);
+    pthread_cond_init(&writer->cond, NULL);
+    writer->pending = g_queue_new();
+
+    rc = -pthread_create(&writer->tid, NULL, dss_async_thread, writer);
+    if (rc)
+        LOG_GOTO(fini, rc, "Failed to create asynchronous dss thread");
+
+    *async = writer;
+
+    return 0;
+
+fini:
+    g_queue_free(writer->pending);
+    pthread_cond_destroy(&writer->cond);
+    pthread_mutex_destroy(&writer->mutex);
+    dss_fini(&writer->dss);
+free_writer:
+    free(writer);
+
+    return rc;
+}
+
+void dss_async_fini(struct dss_async *async)
+{
+    if (async == NULL)
+        return;
+
+    MUTEX_LOCK(&async->mutex);
+    async->stopping = true;
+    pthread_cond_broadcast(&async->cond);
+    MUTEX_UNLOCK(&async->mutex);
+
+    /* the writer only stops once everything is written */
+    pthread_join(async->tid, NULL);
+
+    g_queue_free(async->pending);
+    pthread_cond_destroy(&async->cond);
+    pthread_mutex_destroy(&async->mutex);
+    dss_fini(&async->dss);
+    free(async);
+}
+
+static void dss_async_push(struct dss_async *async, struct dss_async_op *op)
+{
+    MUTEX_LOCK(&async->mutex);
+    g_queue_push_tail(async->pending, op);
+    async->n_queued++;
+    pthread_cond_broadcast(&async->cond);
+    MUTEX_UNLOCK(&async->mutex);
+}
+
+void dss_async_emit_log(struct dss_async *async, struct pho_log *log,
+                        enum operation_type action, int rc)
+{
+    struct dss_async_op *op;
+
+    if (!log_after_action(log, action, rc)) {
+        if (log->message)
+            json_decref(log->message);
+        return;
+    }
+
+    op = xmalloc(sizeof(*op));
+    op->type = DSS_ASYNC_LOG;
+    /* the op takes ownership of the message */
+    op->log = *log;
+
+    dss_async_push(async, op);
+}
+
+static bool is_media_update_of(struct dss_async_op *op,
+                               const struct pho_id *id)
+{
+    return op->type == DSS_ASYNC_MEDIA_UPDATE &&
+           pho_id_equal(&op->media.medium->rsc.id, id);
+}
+
+void dss_async_media_update(struct dss_async *async,
+                            const struct media_info *medium, uint64_t fields)
+{
+    struct dss_async_op *op;
+    GList *item;
+
+    MUTEX_LOCK(&async->mutex);
+    /* A pending update of the same fields of this medium is not written yet,
+     * only the most recent values need to be.
+     */
+    for (item = async->pending->head; item; item = item->next) {
+        op = item->data;
+
+        if (is_media_update_of(op, &medium->rsc.id) &&
+            op->media.fields == fields) {
+            media_info_free(op->media.medium);
+            op->media.medium = media_info_dup(medium);
+            MUTEX_UNLOCK(&async->mutex);
+            return;
+        }
+    }
+    MUTEX_UNLOCK(&async->mutex);
+
+    op = xmalloc(sizeof(*op));
+    op->type = DSS_ASYNC_MEDIA_UPDATE;
+    op->media.medium = media_info_dup(medium);
+    op->media.fields = fields;
+
+    dss_async_push(async, op);
+}
+
+void dss_async_media_cancel(struct dss_async *async, const struct pho_id *id)
+{
+    bool running;
+    GList *item;
+
+    MUTEX_LOCK(&async->mutex);
+    item = async->pending->head;
+    while (item) {
+        GList *next = item->next;
+
+        if (is_media_update_of(item->data, id)) {
+            dss_async_op_free(item->data);
+            g_queue_delete_link(async->pending, item);
+            async->n_written++;
+        }
+        item = next;
+    }
+
+    /* An update of this medium may be being written, wait for it */
+    do {
+        running = false;
+        if (async->running)
+            for (item = async->running->head; item; item = item->next)
+                if (is_media_update_of(item->data, id))
+                    running = true;
+
+        if (running)
+            pthread_cond_wait(&async->cond, &async->mutex);
+    } while (running);
+    MUTEX_UNLOCK(&async->mutex);
+}
+
+void dss_async_flush(struct dss_async *async)
+{
+    unsigned long target;
+
+    MUTEX_LOCK(&async->mutex);
+    target = async->n_queued;
+    while (async->n_written < target)
+        pthread_cond_wait(&async->cond, &async->mutex);
+    MUTEX_UNLOCK(&async->mutex);
+}
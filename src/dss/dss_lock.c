@@ -82,69 +82,12 @@ struct dss_generic_call {
 };
 
 enum lock_query_idx {
-    DSS_LOCK_QUERY,
-    DSS_REFRESH_QUERY,
-    DSS_UNLOCK_QUERY,
-    DSS_UNLOCK_FORCE_QUERY,
-    DSS_STATUS_QUERY,
     DSS_CLEAN_DEVICE_QUERY,
     DSS_CLEAN_MEDIA_QUERY,
     DSS_PURGE_ALL_LOCKS_QUERY,
 };
 
-#define DECLARE_BLOCK " DECLARE lock_type lock_type:= '%s'::lock_type;" \
-                      "         lock_id TEXT:= '%s';"                   \
-                      "         lock_hostname TEXT:="                   \
-                      "             (SELECT hostname FROM lock"         \
-                      "              WHERE type = lock_type AND "       \
-                      "                    id = lock_id);"              \
-                      "         lock_owner INTEGER:="                   \
-                      "             (SELECT owner FROM lock"            \
-                      "              WHERE type = lock_type AND "       \
-                      "                    id = lock_id);"              \
-
-#define CHECK_VALID_OWNER_HOSTNAME " IF lock_owner IS NULL OR "         \
-                                   "    lock_hostname IS NULL THEN"     \
-                                   "  RAISE USING errcode = 'PHLK1';"   \
-                                   " END IF;"
-
-#define CHECK_OWNER_HOSTNAME_EXISTS " IF lock_owner <> '%d' OR "        \
-                                    "    lock_hostname <> '%s' THEN"    \
-                                    "  RAISE USING errcode = 'PHLK2';"  \
-                                    " END IF;"
-
-#define WHERE_CONDITION " WHERE type = lock_type AND id = lock_id AND " \
-                        "       owner = lock_owner AND "                \
-                        "       hostname = lock_hostname;"
-
 static const char * const lock_query[] = {
-    [DSS_LOCK_QUERY]         = "INSERT INTO lock (type, id, owner, hostname)"
-                               " VALUES ('%s'::lock_type, '%s', %d, '%s');",
-    [DSS_REFRESH_QUERY]      = "DO $$"
-                                 DECLARE_BLOCK
-                               " BEGIN"
-                                 CHECK_VALID_OWNER_HOSTNAME
-                                 CHECK_OWNER_HOSTNAME_EXISTS
-                               " UPDATE lock SET timestamp = now()"
-                                 WHERE_CONDITION
-                               "END $$;",
-    [DSS_UNLOCK_QUERY]       = "DO $$"
-                                 DECLARE_BLOCK
-                               " BEGIN"
-                                 CHECK_VALID_OWNER_HOSTNAME
-                                 CHECK_OWNER_HOSTNAME_EXISTS
-                               " DELETE FROM lock"
-                                 WHERE_CONDITION
-                               "END $$;",
-    [DSS_UNLOCK_FORCE_QUERY] = "DO $$"
-                                  DECLARE_BLOCK
-                               "  BEGIN"
-                                  CHECK_VALID_OWNER_HOSTNAME
-                               "  DELETE FROM lock"
-                               "   WHERE type = lock_type AND id = lock_id;"
-                               "END $$;",
-    [DSS_STATUS_QUERY]       = "SELECT hostname, owner, timestamp FROM lock "
-                               "  WHERE type = '%s'::lock_type AND id = '%s';",
     [DSS_CLEAN_DEVICE_QUERY] = "WITH id_host AS (SELECT id || '_' || library "
                                "                        AS id, host "
                                "                     FROM device "
@@ -171,6 +114,74 @@ static const char * const lock_query[] = {
     [DSS_PURGE_ALL_LOCKS_QUERY] = "TRUNCATE TABLE lock; "
 };
 
+/*
+ * The lock, refresh, unlock and status requests are issued for every resource
+ * handled by the LRS, so they are prepared once per connection and their
+ * parameters are not escaped into the query.
+ *
+ * Refresh and unlock return the number of locks found with the given type and
+ * id, and the number of those also matching the owner and hostname that were
+ * updated or deleted: the first one being 0 means the lock does not exist
+ * (-ENOLCK), the second one being 0 means it is held by someone else
+ * (-EACCES).
+ */
+#define LOCK_EXISTING_CTE "WITH existing AS (SELECT 1 FROM lock"         \
+                          "                  WHERE type = $1::lock_type" \
+                          "                    AND id = $2)"
+
+#define LOCK_OWNER_CONDITION " WHERE type = $1::lock_type AND id = $2 AND " \
+                             "       owner = $3 AND hostname = $4"
+
+static const Oid lock_owner_types[] = { 0, 0, DSS_INT4OID, 0 };
+
+static const struct dss_prepared lock_stmt = {
+    .name        = "dss_lock",
+    .query       = "INSERT INTO lock (type, id, owner, hostname)"
+                   " VALUES ($1::lock_type, $2, $3, $4);",
+    .n_params    = 4,
+    .param_types = lock_owner_types,
+};
+
+static const struct dss_prepared refresh_stmt = {
+    .name        = "dss_lock_refresh",
+    .query       = LOCK_EXISTING_CTE ","
+                   " done AS (UPDATE lock SET timestamp = now()"
+                              LOCK_OWNER_CONDITION
+                   "          RETURNING 1)"
+                   " SELECT (SELECT count(*) FROM existing),"
+                   "        (SELECT count(*) FROM done);",
+    .n_params    = 4,
+    .param_types = lock_owner_types,
+};
+
+static const struct dss_prepared unlock_stmt = {
+    .name        = "dss_unlock",
+    .query       = LOCK_EXISTING_CTE ","
+                   " done AS (DELETE FROM lock"
+                              LOCK_OWNER_CONDITION
+                   "          RETURNING 1)"
+                   " SELECT (SELECT count(*) FROM existing),"
+                   "        (SELECT count(*) FROM done);",
+    .n_params    = 4,
+    .param_types = lock_owner_types,
+};
+
+static const struct dss_prepared unlock_force_stmt = {
+    .name        = "dss_unlock_force",
+    .query       = "DELETE FROM lock WHERE type = $1::lock_type AND id = $2"
+                   " RETURNING 1;",
+    .n_params    = 2,
+    .param_types = NULL,
+};
+
+static const struct dss_prepared status_stmt = {
+    .name        = "dss_lock_status",
+    .query       = "SELECT hostname, owner, timestamp FROM lock"
+                   " WHERE type = $1::lock_type AND id = $2;",
+    .n_params    = 2,
+    .param_types = NULL,
+};
+
 static const char *dss_translate_prefix(enum dss_type type,
                                         const void *item_list,
                                         int pos)
@@ -227,22 +238,8 @@ static const char *dss_translate_suffix(enum dss_type type,
     return NULL;
 }
 
-static void append_escaped_to_id(PGconn *conn, const char *string, GString *id)
-{
-    unsigned int escape_len;
-    char *escape_string;
-
-    escape_len = strlen(string) * 2 + 1;
-    escape_string = xmalloc(escape_len);
-
-    PQescapeStringConn(conn, escape_string, string, escape_len, NULL);
-    g_string_append(id, escape_string);
-    free(escape_string);
-}
-
-static int dss_build_lock_id_list(PGconn *conn, const void *item_list,
-                                  int item_cnt, enum dss_type type,
-                                  GString **ids)
+static int dss_build_lock_id_list(const void *item_list, int item_cnt,
+                                  enum dss_type type, GString **ids)
 {
     const char   *name;
     int           i;
@@ -252,12 +249,12 @@ static int dss_build_lock_id_list(PGconn *conn, const void *item_list,
         if (!name)
             LOG_RETURN(-EINVAL, "no lock id prefix found");
 
-        append_escaped_to_id(conn, name, ids[i]);
+        g_string_append(ids[i], name);
 
         name = dss_translate_suffix(type, item_list, i);
         if (name) {
             g_string_append(ids[i], "_");
-            append_escaped_to_id(conn, name, ids[i]);
+            g_string_append(ids[i], name);
         }
 
         if (ids[i]->len > PHO_DSS_MAX_LOCK_ID_LEN)
@@ -267,72 +264,96 @@ static int dss_build_lock_id_list(PGconn *conn, const void *item_list,
     return 0;
 }
 
+static void lock_owner_params(struct dss_params *params,
+                              enum dss_type lock_type, const char *lock_id,
+                              int lock_owner, const char *lock_hostname)
+{
+    params->count = 0;
+    dss_param_str(params, dss_type_names[lock_type]);
+    dss_param_str(params, lock_id);
+    dss_param_int4(params, lock_owner);
+    dss_param_str(params, lock_hostname);
+}
+
 static int basic_lock(struct dss_handle *handle, enum dss_type lock_type,
                       const char *lock_id, int lock_owner,
                       const char *lock_hostname)
 {
-    GString *request = g_string_new("");
-    PGconn *conn = handle->dh_conn;
+    struct dss_params params;
     PGresult *res;
     int rc;
 
     if (lock_type == DSS_DEPREC)
         lock_type = DSS_OBJECT;
 
-    g_string_printf(request, lock_query[DSS_LOCK_QUERY],
-                    dss_type_names[lock_type], lock_id, lock_owner,
-                    lock_hostname);
+    lock_owner_params(&params, lock_type, lock_id, lock_owner, lock_hostname);
 
-    rc = execute(conn, request->str, &res, PGRES_COMMAND_OK);
+    rc = execute_prepared(handle, &lock_stmt, &params, &res,
+                          PGRES_COMMAND_OK);
 
     PQclear(res);
-    g_string_free(request, true);
 
     return rc;
 }
 
-static int basic_refresh(struct dss_handle *handle, enum dss_type lock_type,
-                         const char *lock_id, int lock_owner,
-                         const char *lock_hostname)
+/**
+ * Execute a refresh or an unlock, and convert its counts to an error code.
+ */
+static int lock_owner_update(struct dss_handle *handle,
+                             const struct dss_prepared *stmt,
+                             enum dss_type lock_type, const char *lock_id,
+                             int lock_owner, const char *lock_hostname)
 {
-    GString *request = g_string_new("");
-    PGconn *conn = handle->dh_conn;
+    struct dss_params params;
     PGresult *res;
-    int rc = 0;
+    int rc;
 
-    g_string_printf(request, lock_query[DSS_REFRESH_QUERY],
-                    dss_type_names[lock_type], lock_id, lock_owner,
-                    lock_hostname);
+    lock_owner_params(&params, lock_type, lock_id, lock_owner, lock_hostname);
 
-    rc = execute(conn, request->str, &res, PGRES_COMMAND_OK);
+    rc = execute_prepared(handle, stmt, &params, &res, PGRES_TUPLES_OK);
+    if (rc)
+        goto out_cleanup;
+
+    if (strcmp(PQgetvalue(res, 0, 0), "0") == 0)
+        rc = -ENOLCK;
+    else if (strcmp(PQgetvalue(res, 0, 1), "0") == 0)
+        rc = -EACCES;
 
+out_cleanup:
     PQclear(res);
-    g_string_free(request, true);
 
     return rc;
 }
 
+static int basic_refresh(struct dss_handle *handle, enum dss_type lock_type,
+                         const char *lock_id, int lock_owner,
+                         const char *lock_hostname)
+{
+    return lock_owner_update(handle, &refresh_stmt, lock_type, lock_id,
+                             lock_owner, lock_hostname);
+}
+
 static int basic_unlock(struct dss_handle *handle, enum dss_type lock_type,
                         const char *lock_id, int lock_owner,
                         const char *lock_hostname)
 {
-    GString *request = g_string_new("");
-    PGconn *conn = handle->dh_conn;
+    struct dss_params params = { .count = 0 };
     PGresult *res;
     int rc;
 
     if (lock_owner)
-        g_string_printf(request, lock_query[DSS_UNLOCK_QUERY],
-                        dss_type_names[lock_type], lock_id, lock_owner,
-                        lock_hostname);
-    else
-        g_string_printf(request, lock_query[DSS_UNLOCK_FORCE_QUERY],
-                        dss_type_names[lock_type], lock_id);
+        return lock_owner_update(handle, &unlock_stmt, lock_type, lock_id,
+                                 lock_owner, lock_hostname);
 
-    rc = execute(conn, request->str, &res, PGRES_COMMAND_OK);
+    dss_param_str(&params, dss_type_names[lock_type]);
+    dss_param_str(&params, lock_id);
+
+    rc = execute_prepared(handle, &unlock_force_stmt, &params, &res,
+                          PGRES_TUPLES_OK);
+    if (!rc && PQntuples(res) == 0)
+        rc = -ENOLCK;
 
     PQclear(res);
-    g_string_free(request, true);
 
     return rc;
 }
@@ -340,22 +361,22 @@ static int basic_unlock(struct dss_handle *handle, enum dss_type lock_type,
 static int basic_status(struct dss_handle *handle, enum dss_type lock_type,
                         const char *lock_id, struct pho_lock *lock)
 {
-    GString *request = g_string_new("");
-    PGconn *conn = handle->dh_conn;
+    struct dss_params params = { .count = 0 };
     struct timeval lock_timestamp;
     PGresult *res;
     int rc = 0;
 
-    g_string_printf(request, lock_query[DSS_STATUS_QUERY],
-                    dss_type_names[lock_type], lock_id);
+    dss_param_str(&params, dss_type_names[lock_type]);
+    dss_param_str(&params, lock_id);
 
-    rc = execute(conn, request->str, &res, PGRES_TUPLES_OK);
+    rc = execute_prepared(handle, &status_stmt, &params, &res,
+                          PGRES_TUPLES_OK);
     if (rc)
         goto out_cleanup;
 
     if (PQntuples(res) == 0) {
-        pho_debug("Requested lock '%s' was not found, request: '%s' ",
-                  lock_id, request->str);
+        pho_debug("Requested lock '%s' of type '%s' was not found", lock_id,
+                  dss_type_names[lock_type]);
         rc = -ENOLCK;
         if (lock) {
             lock->hostname = NULL;
@@ -373,7 +394,6 @@ static int basic_status(struct dss_handle *handle, enum dss_type lock_type,
 
 out_cleanup:
     PQclear(res);
-    g_string_free(request, true);
 
     return rc;
 }
@@ -382,7 +402,6 @@ static int dss_generic(struct dss_handle *handle, enum dss_type type,
                        const void *item_list, int item_cnt,
                        struct dss_generic_call *callee)
 {
-    PGconn *conn = handle->dh_conn;
     GString **ids;
     int rc = 0;
     int i;
@@ -391,7 +410,7 @@ static int dss_generic(struct dss_handle *handle, enum dss_type type,
 
     LOCK_ID_LIST_ALLOCATE(ids, item_cnt);
 
-    rc = dss_build_lock_id_list(conn, item_list, item_cnt, type, ids);
+    rc = dss_build_lock_id_list(item_list, item_cnt, type, ids);
     if (rc)
         LOG_GOTO(cleanup, rc, "Ids list build failed");
 
@@ -429,6 +448,61 @@ cleanup:
     return rc;
 }
 
+/**
+ * Lock several items with a single multi-row insert: the insert fails as a
+ * whole if one of the locks already exists, so nothing has to be rolled back.
+ */
+static int multiple_lock(struct dss_handle *handle, enum dss_type type,
+                         const void *item_list, int item_cnt,
+                         const char *lock_hostname, int lock_owner)
+{
+    enum dss_type lock_type = type == DSS_DEPREC ? DSS_OBJECT : type;
+    PGconn *conn = handle->dh_conn;
+    char *hostname = NULL;
+    GString *request;
+    PGresult *res;
+    GString **ids;
+    int rc = 0;
+    int i;
+
+    ENTRY;
+
+    LOCK_ID_LIST_ALLOCATE(ids, item_cnt);
+    request = g_string_new("INSERT INTO lock (type, id, owner, hostname) "
+                           "VALUES ");
+
+    rc = dss_build_lock_id_list(item_list, item_cnt, type, ids);
+    if (rc)
+        LOG_GOTO(cleanup, rc, "Ids list build failed");
+
+    hostname = dss_char4sql(conn, lock_hostname);
+    if (!hostname)
+        LOG_GOTO(cleanup, rc = -EINVAL, "Invalid lock hostname");
+
+    for (i = 0; i < item_cnt; ++i) {
+        char *id = dss_char4sql(conn, ids[i]->str);
+
+        if (!id)
+            LOG_GOTO(cleanup, rc = -EINVAL, "Invalid lock id");
+
+        g_string_append_printf(request, "%s('%s'::lock_type, %s, %d, %s)",
+                               i ? ", " : "", dss_type_names[lock_type], id,
+                               lock_owner, hostname);
+        free_dss_char4sql(id);
+    }
+    g_string_append(request, ";");
+
+    rc = execute(conn, request->str, &res, PGRES_COMMAND_OK);
+    PQclear(res);
+
+cleanup:
+    free_dss_char4sql(hostname);
+    g_string_free(request, true);
+    LOCK_ID_LIST_FREE(ids, item_cnt);
+
+    return rc;
+}
+
 static int dss_lock_rollback(struct dss_handle *handle, enum dss_type type,
                              GString **ids, int rollback_cnt)
 {
@@ -467,6 +541,10 @@ int _dss_lock(struct dss_handle *handle, enum dss_type type,
         .action = "lock"
     };
 
+    if (item_cnt > 1)
+        return multiple_lock(handle, type, item_list, item_cnt, lock_hostname,
+                             lock_pid);
+
     return dss_generic(handle, type, item_list, item_cnt, &callee);
 }
 
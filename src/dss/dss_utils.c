@@ -29,8 +29,11 @@
 #include "dss_utils.h"
 #include "pho_common.h"
 
+#include <assert.h>
+#include <endian.h>
 #include <errno.h>
 #include <libpq-fe.h>
+#include <string.h>
 
 struct sqlerr_map_item {
     const char *smi_prefix;  /**< SQL error code or class (prefix) */
@@ -77,6 +80,442 @@ int execute(PGconn *conn, const char *request, PGresult **res,
     return 0;
 }
 
+void dss_param_str(struct dss_params *params, const char *value)
+{
+    assert(params->count < DSS_MAX_PARAMS);
+
+    params->values[params->count] = value;
+    params->lengths[params->count] = 0;
+    params->formats[params->count] = 0;
+    params->count++;
+}
+
+void dss_param_int4(struct dss_params *params, int32_t value)
+{
+    uint32_t be = htobe32((uint32_t)value);
+
+    assert(params->count < DSS_MAX_PARAMS);
+
+    memcpy(params->binary[params->count], &be, sizeof(be));
+    params->values[params->count] = params->binary[params->count];
+    params->lengths[params->count] = sizeof(be);
+    params->formats[params->count] = 1;
+    params->count++;
+}
+
+void dss_param_int8(struct dss_params *params, int64_t value)
+{
+    uint64_t be = htobe64((uint64_t)value);
+
+    assert(params->count < DSS_MAX_PARAMS);
+
+    memcpy(params->binary[params->count], &be, sizeof(be));
+    params->values[params->count] = params->binary[params->count];
+    params->lengths[params->count] = sizeof(be);
+    params->formats[params->count] = 1;
+    params->count++;
+}
+
+/** Whether the requests sent on \p conn are queued in pipeline mode */
+static bool in_pipeline(PGconn *conn)
+{
+#ifdef LIBPQ_HAS_PIPELINING
+    return PQpipelineStatus(conn) != PQ_PIPELINE_OFF;
+#else
+    (void) conn;
+    return false;
+#endif
+}
+
+/** Prepare \p stmt on the connection of \p handle, if not done already */
+static int prepare_once(struct dss_handle *handle,
+                        const struct dss_prepared *stmt)
+{
+    GHashTable *prepared = handle->dh_prepared;
+    PGresult *res;
+
+    if (g_hash_table_contains(prepared, stmt->name))
+        return 0;
+
+    pho_debug("Preparing statement '%s': '%s'", stmt->name, stmt->query);
+
+    if (in_pipeline(handle->dh_conn)) {
+        /* its result is checked by prepared_transaction_end, which forgets
+         * all the statements if the pipeline fails
+         */
+        if (!PQsendPrepare(handle->dh_conn, stmt->name, stmt->query,
+                           stmt->n_params, stmt->param_types))
+            LOG_RETURN(-ECOMM, "Cannot send preparation of '%s': %s",
+                       stmt->name, PQerrorMessage(handle->dh_conn));
+
+        g_hash_table_add(prepared, (gpointer)stmt->name);
+        return 0;
+    }
+
+    res = PQprepare(handle->dh_conn, stmt->name, stmt->query, stmt->n_params,
+                    stmt->param_types);
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        int rc = psql_state2errno(res);
+
+        pho_error(rc, "Preparation of '%s' failed: %s", stmt->name,
+                  PQresultErrorField(res, PG_DIAG_MESSAGE_PRIMARY));
+        PQclear(res);
+        return rc;
+    }
+
+    PQclear(res);
+    /* the names are static strings, no need to copy them */
+    g_hash_table_add(prepared, (gpointer)stmt->name);
+
+    return 0;
+}
+
+int execute_prepared(struct dss_handle *handle,
+                     const struct dss_prepared *stmt,
+                     const struct dss_params *params, PGresult **res,
+                     ExecStatusType tested)
+{
+    PGconn *conn = handle->dh_conn;
+    int rc;
+
+    assert(params->count == stmt->n_params);
+
+    *res = NULL;
+    rc = prepare_once(handle, stmt);
+    if (rc)
+        return rc;
+
+    pho_debug("Executing prepared statement '%s'", stmt->name);
+
+    if (in_pipeline(conn)) {
+        if (!PQsendQueryPrepared(conn, stmt->name, params->count,
+                                 params->values, params->lengths,
+                                 params->formats, 0))
+            LOG_RETURN(-ECOMM, "Cannot send request '%s': %s", stmt->name,
+                       PQerrorMessage(conn));
+
+        return 0;
+    }
+
+    /* results are kept in text format, which is what the row parsers use */
+    *res = PQexecPrepared(conn, stmt->name, params->count, params->values,
+                          params->lengths, params->formats, 0);
+    if (PQresultStatus(*res) != tested)
+        LOG_RETURN(psql_state2errno(*res), "Request '%s' failed: %s",
+                   stmt->name,
+                   PQresultErrorField(*res, PG_DIAG_MESSAGE_PRIMARY));
+
+    return 0;
+}
+
+int send_query(PGconn *conn, const char *request)
+{
+    pho_debug("Sending request: '%s'", request);
+
+    if (!PQsendQuery(conn, request))
+        LOG_RETURN(-ECOMM, "Cannot send request: %s", PQerrorMessage(conn));
+
+    return 0;
+}
+
+int send_prepared(struct dss_handle *handle, const struct dss_prepared *stmt,
+                  const struct dss_params *params)
+{
+    PGconn *conn = handle->dh_conn;
+    int rc;
+
+    assert(params->count == stmt->n_params);
+
+    rc = prepare_once(handle, stmt);
+    if (rc)
+        return rc;
+
+    pho_debug("Sending prepared statement '%s'", stmt->name);
+
+    if (!PQsendQueryPrepared(conn, stmt->name, params->count, params->values,
+                             params->lengths, params->formats, 0))
+        LOG_RETURN(-ECOMM, "Cannot send request '%s': %s", stmt->name,
+                   PQerrorMessage(conn));
+
+    return 0;
+}
+
+int prepared_transaction_begin(struct dss_handle *handle)
+{
+    PGconn *conn = handle->dh_conn;
+
+#ifdef LIBPQ_HAS_PIPELINING
+    if (PQenterPipelineMode(conn) != 1)
+        LOG_RETURN(-ECOMM, "Cannot enter pipeline mode: %s",
+                   PQerrorMessage(conn));
+
+    if (PQsendQueryParams(conn, "BEGIN;", 0, NULL, NULL, NULL, NULL, 0) == 1)
+        return 0;
+
+    pho_error(-ECOMM, "Cannot send request: %s", PQerrorMessage(conn));
+    PQexitPipelineMode(conn);
+    return -ECOMM;
+#else
+    PGresult *res;
+    int rc;
+
+    rc = execute(conn, "BEGIN;", &res, PGRES_COMMAND_OK);
+    PQclear(res);
+
+    return rc;
+#endif
+}
+
+#ifdef LIBPQ_HAS_PIPELINING
+/**
+ * Read the results of the pipeline up to its sync point.
+ *
+ * \return 0 if all the requests succeeded, the error of the first failing one
+ *         otherwise
+ */
+static int pipeline_drain(PGconn *conn)
+{
+    bool previous_null = false;
+    int rc = 0;
+
+    while (true) {
+        PGresult *res = PQgetResult(conn);
+        ExecStatusType status;
+
+        if (res == NULL) {
+            /* two NULLs in a row: no result is expected anymore */
+            if (previous_null)
+                return rc ? : -ECOMM;
+
+            previous_null = true;
+            continue;
+        }
+
+        previous_null = false;
+        status = PQresultStatus(res);
+        if (status == PGRES_PIPELINE_SYNC) {
+            PQclear(res);
+            return rc;
+        }
+
+        /* the requests following a failure are skipped by the server */
+        if (rc == 0 && status != PGRES_COMMAND_OK &&
+            status != PGRES_PIPELINE_ABORTED) {
+            rc = psql_state2errno(res) ? : -ECOMM;
+            pho_error(rc, "Request failed: %s",
+                      PQresultErrorField(res, PG_DIAG_MESSAGE_PRIMARY));
+        }
+        PQclear(res);
+    }
+}
+#endif
+
+int prepared_transaction_end(struct dss_handle *handle, int rc)
+{
+    PGconn *conn = handle->dh_conn;
+    PGresult *res;
+
+#ifdef LIBPQ_HAS_PIPELINING
+    int rc2;
+
+    if (rc == 0 &&
+        PQsendQueryParams(conn, "COMMIT;", 0, NULL, NULL, NULL, NULL, 0) != 1) {
+        rc = -ECOMM;
+        pho_error(rc, "Cannot send request: %s", PQerrorMessage(conn));
+    }
+
+    if (PQpipelineSync(conn) != 1) {
+        rc = rc ? : -ECOMM;
+        pho_error(-ECOMM, "Cannot sync pipeline: %s", PQerrorMessage(conn));
+    } else {
+        rc2 = pipeline_drain(conn);
+        rc = rc ? : rc2;
+    }
+
+    if (PQexitPipelineMode(conn) != 1) {
+        rc = rc ? : -ECOMM;
+        pho_error(-ECOMM, "Cannot exit pipeline mode: %s",
+                  PQerrorMessage(conn));
+    }
+
+    if (rc == 0)
+        return 0;
+
+    /* the server leaves a failed explicit transaction open after the sync */
+    if (PQtransactionStatus(conn) != PQTRANS_IDLE) {
+        pho_info("Attempting to rollback after transaction failure");
+        execute(conn, "ROLLBACK;", &res, PGRES_COMMAND_OK);
+        PQclear(res);
+    }
+
+    /* the statements sent in the failed pipeline may not have been prepared */
+    g_hash_table_remove_all(handle->dh_prepared);
+    execute(conn, "DEALLOCATE ALL;", &res, PGRES_COMMAND_OK);
+    PQclear(res);
+
+    return rc;
+#else
+    if (rc == 0) {
+        rc = execute(conn, "COMMIT;", &res, PGRES_COMMAND_OK);
+        PQclear(res);
+        return rc;
+    }
+
+    pho_info("Attempting to rollback after transaction failure");
+    execute(conn, "ROLLBACK;", &res, PGRES_COMMAND_OK);
+    PQclear(res);
+
+    return rc;
+#endif
+}
+
+/* Number of rows received at once when streaming, if libpq supports it */
+#define STREAM_CHUNK_ROWS 1024
+
+static bool is_streamed_status(ExecStatusType status)
+{
+#ifdef LIBPQ_HAS_CHUNK_MODE
+    if (status == PGRES_TUPLES_CHUNK)
+        return true;
+#endif
+    return status == PGRES_SINGLE_TUPLE || status == PGRES_TUPLES_OK;
+}
+
+int stream_rows(PGconn *conn, stream_row_cb_t row_cb, void *udata)
+{
+    PGresult *res;
+    int rc = 0;
+
+#ifdef LIBPQ_HAS_CHUNK_MODE
+    if (!PQsetChunkedRowsMode(conn, STREAM_CHUNK_ROWS))
+#else
+    if (!PQsetSingleRowMode(conn))
+#endif
+        pho_warn("Cannot stream the rows, they are received at once");
+
+    /* all the results are read, even on failure, to leave the connection
+     * ready for the next request
+     */
+    while ((res = PQgetResult(conn)) != NULL) {
+        int i;
+
+        if (rc == 0 && !is_streamed_status(PQresultStatus(res))) {
+            rc = psql_state2errno(res) ? : -ECOMM;
+            pho_error(rc, "Request failed: %s",
+                      PQresultErrorField(res, PG_DIAG_MESSAGE_PRIMARY));
+        }
+
+        for (i = 0; rc == 0 && i < PQntuples(res); i++)
+            rc = row_cb(res, i, udata);
+
+        PQclear(res);
+    }
+
+    return rc;
+}
+
+/* Bound the number of requests in flight, in blocking mode the server could
+ * otherwise fill its output buffer while we are still sending.
+ */
+#define PIPELINE_MAX_REQUESTS 64
+
+#ifdef LIBPQ_HAS_PIPELINING
+static int pipeline_result(PGconn *conn, int *rc, ExecStatusType tested)
+{
+    PGresult *res;
+
+    res = PQgetResult(conn);
+    if (res == NULL)
+        LOG_RETURN(-ECOMM, "Missing pipeline result: %s",
+                   PQerrorMessage(conn));
+
+    *rc = 0;
+    if (PQresultStatus(res) != tested) {
+        *rc = psql_state2errno(res) ? : -ECOMM;
+        pho_error(*rc, "Request failed: %s",
+                  PQresultErrorField(res, PG_DIAG_MESSAGE_PRIMARY));
+    }
+    PQclear(res);
+
+    /* end of the results of this request, then its sync point */
+    res = PQgetResult(conn);
+    PQclear(res);
+    res = PQgetResult(conn);
+    if (PQresultStatus(res) != PGRES_PIPELINE_SYNC) {
+        PQclear(res);
+        LOG_RETURN(-ECOMM, "Unexpected pipeline state: %s",
+                   PQerrorMessage(conn));
+    }
+    PQclear(res);
+
+    return 0;
+}
+
+static int execute_pipeline_chunk(PGconn *conn, GString **requests, int count,
+                                  int *rcs, ExecStatusType tested)
+{
+    int sent;
+    int rc;
+    int i;
+
+    if (PQenterPipelineMode(conn) != 1)
+        LOG_RETURN(-ECOMM, "Cannot enter pipeline mode: %s",
+                   PQerrorMessage(conn));
+
+    rc = 0;
+    for (sent = 0; sent < count; sent++) {
+        pho_debug("Sending request: '%s'", requests[sent]->str);
+        if (PQsendQueryParams(conn, requests[sent]->str, 0, NULL, NULL, NULL,
+                              NULL, 0) != 1 ||
+            PQpipelineSync(conn) != 1) {
+            rc = -ECOMM;
+            pho_error(rc, "Cannot send request: %s", PQerrorMessage(conn));
+            break;
+        }
+    }
+
+    for (i = 0; i < sent && rc == 0; i++)
+        rc = pipeline_result(conn, &rcs[i], tested);
+
+    for (; i < count; i++)
+        rcs[i] = -ECOMM;
+
+    if (PQexitPipelineMode(conn) != 1) {
+        pho_error(-ECOMM, "Cannot exit pipeline mode: %s",
+                  PQerrorMessage(conn));
+        rc = rc ? : -ECOMM;
+    }
+
+    return rc;
+}
+#endif
+
+int execute_pipeline(PGconn *conn, GString **requests, int count, int *rcs,
+                     ExecStatusType tested)
+{
+    int rc = 0;
+    int i;
+
+#ifdef LIBPQ_HAS_PIPELINING
+    for (i = 0; i < count && rc == 0; i += PIPELINE_MAX_REQUESTS)
+        rc = execute_pipeline_chunk(conn, requests + i,
+                                    min(count - i, PIPELINE_MAX_REQUESTS),
+                                    rcs + i, tested);
+
+    for (; i < count; i++)
+        rcs[i] = -ECOMM;
+#else
+    for (i = 0; i < count; i++) {
+        PGresult *res;
+
+        rcs[i] = execute(conn, requests[i]->str, &res, tested);
+        PQclear(res);
+    }
+#endif
+
+    return rc;
+}
+
 int psql_state2errno(const PGresult *res)
 {
     char *sqlstate = PQresultErrorField(res, PG_DIAG_SQLSTATE);
@@ -263,6 +702,20 @@ cmp_size(void *first_extent, void *second_extent)
     return 0;
 }
 
+int
+cmp_ext_count(void *first_layout, void *second_layout)
+{
+    int second_count = ((struct layout_info *) second_layout)->ext_count;
+    int first_count = ((struct layout_info *) first_layout)->ext_count;
+
+    if (first_count < second_count)
+        return -1;
+    if (first_count > second_count)
+        return 1;
+
+    return 0;
+}
+
 static void
 swap_list(void **list, int a, int b, size_t item_size)
 {
@@ -108,6 +108,172 @@ int psql_state2errno(const PGresult *res);
 int execute_and_commit_or_rollback(PGconn *conn, GString *request,
                                    PGresult **res, ExecStatusType tested);
 
+/** Type OIDs of the binary parameters of prepared statements */
+#define DSS_INT8OID 20
+#define DSS_INT4OID 23
+
+/** Maximum number of parameters of a prepared statement */
+#define DSS_MAX_PARAMS 16
+
+/**
+ * Statement prepared once per connection, on its first execution.
+ *
+ * The name must be unique amongst all the prepared statements. A parameter
+ * type of 0 lets the server infer it, which is what is used for all the text
+ * parameters.
+ */
+struct dss_prepared {
+    const char *name;
+    const char *query;
+    int n_params;
+    const Oid *param_types;
+};
+
+/**
+ * Parameters of one execution of a prepared statement. Strings are sent as
+ * text, integers in binary so that they are not formatted and parsed back.
+ */
+struct dss_params {
+    int count;
+    const char *values[DSS_MAX_PARAMS];
+    int lengths[DSS_MAX_PARAMS];
+    int formats[DSS_MAX_PARAMS];
+    char binary[DSS_MAX_PARAMS][8];
+};
+
+/**
+ * Append a text parameter, NULL for a SQL NULL.
+ */
+void dss_param_str(struct dss_params *params, const char *value);
+
+/**
+ * Append a binary integer parameter, for an "integer" column.
+ */
+void dss_param_int4(struct dss_params *params, int32_t value);
+
+/**
+ * Append a binary integer parameter, for a "bigint" column.
+ */
+void dss_param_int8(struct dss_params *params, int64_t value);
+
+/**
+ * Execute the prepared statement \p stmt with \p params, verify the result is
+ * as expected with \p tested and put the result in \p res.
+ *
+ * The statement is prepared on the first call with a given handle, and the
+ * following calls only send its name and parameters: the server does not parse
+ * and plan the query again.
+ *
+ * Between prepared_transaction_begin and prepared_transaction_end, the
+ * execution is only queued: \p res is set to NULL and the result is checked by
+ * prepared_transaction_end, which expects PGRES_COMMAND_OK.
+ *
+ * \param handle[in]  The DSS handle, holding the prepared statements
+ * \param stmt[in]    Statement to execute
+ * \param params[in]  Parameters of the statement, count must match
+ *                    stmt->n_params
+ * \param res[out]    Result holder of the request
+ * \param tested[in]  The expected result of the request
+ *
+ * \return            0 on success, or the error as returned by PSQL
+ */
+int execute_prepared(struct dss_handle *handle,
+                     const struct dss_prepared *stmt,
+                     const struct dss_params *params, PGresult **res,
+                     ExecStatusType tested);
+
+/**
+ * Start a transaction whose prepared statements are sent with those of
+ * execute_prepared in a single round trip, when libpq supports pipelining.
+ * It must be ended by prepared_transaction_end.
+ *
+ * \param handle[in]  The DSS handle whose connection runs the transaction
+ *
+ * \return            0 on success, or the error as returned by PSQL
+ */
+int prepared_transaction_begin(struct dss_handle *handle);
+
+/**
+ * Commit the transaction started by prepared_transaction_begin if \p rc is 0,
+ * or roll it back otherwise, and check the result of its statements.
+ *
+ * If one of the statements failed, the whole transaction is rolled back and
+ * the statements prepared on the connection are deallocated, since the
+ * preparations sent within the transaction may have failed as well.
+ *
+ * \param handle[in]  The DSS handle whose connection runs the transaction
+ * \param rc[in]      0, or the error met while queuing the statements
+ *
+ * \return            \p rc if not 0, otherwise 0 on success or the error of
+ *                    the first failing statement
+ */
+int prepared_transaction_end(struct dss_handle *handle, int rc);
+
+/**
+ * Send \p request without waiting for its result, to be read with
+ * stream_rows.
+ *
+ * \param[in]  conn     The connection to the database
+ * \param[in]  request  Request to send
+ *
+ * \return 0 on success, -ECOMM on failure
+ */
+int send_query(PGconn *conn, const char *request);
+
+/**
+ * Prepare \p stmt if needed and send an execution of it without waiting for
+ * its result, to be read with stream_rows.
+ *
+ * \param[in]  handle   DSS handle whose connection runs the statement
+ * \param[in]  stmt     Statement to execute
+ * \param[in]  params   Values of its parameters
+ *
+ * \return 0 on success, negative error code on failure
+ */
+int send_prepared(struct dss_handle *handle, const struct dss_prepared *stmt,
+                  const struct dss_params *params);
+
+/**
+ * Callback called by stream_rows for each row received.
+ *
+ * \return 0 to go on, a negative error code to stop
+ */
+typedef int (*stream_row_cb_t)(PGresult *res, int row_num, void *udata);
+
+/**
+ * Receive the rows of the request just sent on \p conn by chunks (or one by
+ * one if libpq cannot do chunks), so that they are never all held in memory,
+ * and call \p row_cb for each of them, in order.
+ *
+ * \param[in]  conn     The connection to the database
+ * \param[in]  row_cb   Callback called for each row
+ * \param[in]  udata    Argument of \p row_cb
+ *
+ * \return 0 on success, the error of the request or of \p row_cb otherwise
+ */
+int stream_rows(PGconn *conn, stream_row_cb_t row_cb, void *udata);
+
+/**
+ * Execute independent single-statement \p requests in one round trip, and
+ * verify each result is as expected with \p tested.
+ *
+ * The requests are sent in pipeline mode, each in its own implicit
+ * transaction: a failing request does not prevent the others from being
+ * committed. If libpq does not support pipelining, the requests are executed
+ * one after the other.
+ *
+ * \param conn[in]    The connection to the database
+ * \param requests[in] Requests to execute, one SQL statement each
+ * \param count[in]   Number of requests
+ * \param rcs[out]    Outcome of each request, 0 or the error as returned by
+ *                    PSQL
+ * \param tested[in]  The expected result of the requests
+ *
+ * \return            0 if all the requests were sent, -ECOMM otherwise
+ */
+int execute_pipeline(PGconn *conn, GString **requests, int count, int *rcs,
+                     ExecStatusType tested);
+
 /**
  * Unlike PQgetvalue that returns '' for NULL fields,
  * this function returns NULL for NULL fields.
@@ -274,4 +440,16 @@ quicksort(void **list, int low, int high, size_t item_size, bool reverse,
 int
 cmp_size(void *first_extent, void *second_extent);
 
+/**
+ * Comparison function to compare the number of extents of layouts
+ *
+ * \param first_layout[in]      The first layout
+ * \param second_layout[in]     The second layout
+ *
+ * \return -1, 0 or 1 if first_layout has less, as many or more extents than
+ *  second_layout
+ */
+int
+cmp_ext_count(void *first_layout, void *second_layout);
+
 #endif
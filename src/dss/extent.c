@@ -93,6 +93,16 @@ static char *dss_extent_hash_encode(struct extent *extent)
             LOG_GOTO(out_free, rc = -EINVAL, "Cannot set xxh128");
     }
 
+    if (extent->with_crc32c) {
+        char buf[64];
+
+        encode_hex_buffer(buf, extent->crc32c, sizeof(extent->crc32c));
+        rc = json_object_set_new(root, PHO_HASH_CRC32C_KEY_NAME,
+                                 json_string(buf));
+        if (rc)
+            LOG_GOTO(out_free, rc = -EINVAL, "Cannot set crc32c");
+    }
+
     result = json_dumps(root, 0);
 
     pho_debug("Created json representation for hash: '%s'",
@@ -155,6 +165,63 @@ static int extent_insert_query(PGconn *conn, void *void_extent, int item_cnt,
     return 0;
 }
 
+static const Oid extent_insert_types[] = {
+    0, 0, DSS_INT8OID, DSS_INT8OID, 0, 0, 0, 0, 0, 0
+};
+
+static const struct dss_prepared extent_insert_stmt = {
+    .name        = "dss_extent_insert",
+    .query       = "INSERT INTO extent (extent_uuid, state, size, offsetof,"
+                   " medium_family, medium_id, medium_library, address, hash,"
+                   " info) VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10);",
+    .n_params    = 10,
+    .param_types = extent_insert_types,
+};
+
+static int extent_insert_prepared(struct dss_handle *handle,
+                                  void *void_extent, int item_cnt,
+                                  int64_t fields)
+{
+    (void) fields;
+
+    for (int i = 0; i < item_cnt; ++i) {
+        struct extent *extent = ((struct extent *) void_extent) + i;
+        struct dss_params params = { .count = 0 };
+        PGresult *res;
+        GString *info;
+        char *hash;
+        int rc;
+
+        hash = dss_extent_hash_encode(extent);
+        if (hash == NULL)
+            return -EINVAL;
+
+        info = g_string_new("");
+        pho_attrs_to_json(&extent->info, info, JSON_COMPACT);
+
+        dss_param_str(&params, extent->uuid);
+        dss_param_str(&params, extent_state2str(extent->state));
+        dss_param_int8(&params, extent->size);
+        dss_param_int8(&params, extent->offset);
+        dss_param_str(&params, rsc_family2str(extent->media.family));
+        dss_param_str(&params, extent->media.name);
+        dss_param_str(&params, extent->media.library);
+        dss_param_str(&params, extent->address.buff);
+        dss_param_str(&params, hash);
+        dss_param_str(&params, info->str);
+
+        rc = execute_prepared(handle, &extent_insert_stmt, &params, &res,
+                              PGRES_COMMAND_OK);
+        PQclear(res);
+        g_string_free(info, TRUE);
+        free(hash);
+        if (rc)
+            return rc;
+    }
+
+    return 0;
+}
+
 static int extent_update_query(PGconn *conn, void *src_extent, void *dst_extent,
                                int item_cnt, int64_t fields, GString *request)
 {
@@ -241,33 +308,46 @@ static int read_hex_buffer(unsigned char *digest, size_t size,
     return 0;
 }
 
-int dss_extent_hash_decode(struct extent *extent, json_t *hash_field)
+int dss_extent_hash_decode_hex(struct extent *extent, const char *xxh128,
+                               const char *md5, const char *crc32c)
 {
-    const char *tmp;
-    int rc = 0;
-
-    ENTRY;
-
-    if (!json_is_object(hash_field))
-        LOG_RETURN(rc = -EINVAL, "Invalid JSON hash");
+    int rc;
 
-    tmp = json_dict2tmp_str(hash_field, "xxh128");
-    if (tmp) {
-        rc = read_hex_buffer(extent->xxh128, sizeof(extent->xxh128), tmp);
+    if (xxh128) {
+        rc = read_hex_buffer(extent->xxh128, sizeof(extent->xxh128), xxh128);
         if (rc)
             LOG_RETURN(rc, "Failed to decode xxh128 extent");
     }
-    extent->with_xxh128 = (tmp != NULL);
+    extent->with_xxh128 = (xxh128 != NULL);
 
-    tmp = json_dict2tmp_str(hash_field, "md5");
-    if (tmp) {
-        rc = read_hex_buffer(extent->md5, sizeof(extent->md5), tmp);
+    if (md5) {
+        rc = read_hex_buffer(extent->md5, sizeof(extent->md5), md5);
         if (rc)
             LOG_RETURN(rc, "Failed to decode md5 extent");
     }
-    extent->with_md5 = (tmp != NULL);
+    extent->with_md5 = (md5 != NULL);
+
+    if (crc32c) {
+        rc = read_hex_buffer(extent->crc32c, sizeof(extent->crc32c), crc32c);
+        if (rc)
+            LOG_RETURN(rc, "Failed to decode crc32c extent");
+    }
+    extent->with_crc32c = (crc32c != NULL);
+
+    return 0;
+}
+
+int dss_extent_hash_decode(struct extent *extent, json_t *hash_field)
+{
+    ENTRY;
+
+    if (!json_is_object(hash_field))
+        LOG_RETURN(-EINVAL, "Invalid JSON hash");
 
-    return rc;
+    return dss_extent_hash_decode_hex(extent,
+                                      json_dict2tmp_str(hash_field, "xxh128"),
+                                      json_dict2tmp_str(hash_field, "md5"),
+                                      json_dict2tmp_str(hash_field, "crc32c"));
 }
 
 static int extent_from_pg_row(struct dss_handle *handle, void *void_extent,
@@ -318,11 +398,12 @@ static void extent_result_free(void *void_extent)
 }
 
 const struct dss_resource_ops extent_ops = {
-    .insert_query = extent_insert_query,
-    .update_query = extent_update_query,
-    .select_query = extent_select_query,
-    .delete_query = extent_delete_query,
-    .create       = extent_from_pg_row,
-    .free         = extent_result_free,
-    .size         = sizeof(struct extent),
+    .insert_query    = extent_insert_query,
+    .insert_prepared = extent_insert_prepared,
+    .update_query    = extent_update_query,
+    .select_query    = extent_select_query,
+    .delete_query    = extent_delete_query,
+    .create          = extent_from_pg_row,
+    .free            = extent_result_free,
+    .size            = sizeof(struct extent),
 };
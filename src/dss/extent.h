@@ -46,4 +46,17 @@ extern const struct dss_resource_ops extent_ops;
  */
 int dss_extent_hash_decode(struct extent *extent, json_t *hash_field);
 
+/**
+ * Decode the hexadecimal hashes of an extent and store them in \p extent.
+ *
+ * \param[out] extent  The extent in which to store the hashes
+ * \param[in]  xxh128  XXH128 hash, NULL if not set
+ * \param[in]  md5     MD5 hash, NULL if not set
+ * \param[in]  crc32c  CRC32C checksum, NULL if not set
+ *
+ * \return 0 on success, negative error code on failure
+ */
+int dss_extent_hash_decode_hex(struct extent *extent, const char *xxh128,
+                               const char *md5, const char *crc32c);
+
 #endif
@@ -24,8 +24,8 @@
  * \brief  Full layout resource file of Phobos's Distributed State Service.
  */
 
-#include <jansson.h>
 #include <libpq-fe.h>
+#include <string.h>
 
 #include "pho_type_utils.h"
 
@@ -34,179 +34,174 @@
 #include "full_layout.h"
 #include "layout.h"
 
+#define FULL_LAYOUT_SELECT                                                  \
+    "SELECT oid, object_uuid, version, lyt_info, extent_uuid, layout_index," \
+    " state, size, offsetof, medium_family, medium_id, medium_library,"     \
+    " address, hash->>'xxh128', hash->>'md5', hash->>'crc32c', info"        \
+    " FROM extent"                                                          \
+    " RIGHT JOIN ("                                                         \
+    "  SELECT oid, object_uuid, version, lyt_info, extent_uuid,"            \
+    "         layout_index"                                                 \
+    "   FROM layout"                                                        \
+    "   LEFT JOIN ("                                                        \
+    "    SELECT oid, object_uuid, version, lyt_info FROM object"            \
+    "    UNION SELECT oid, object_uuid, version, lyt_info"                  \
+    "     FROM deprecated_object"                                           \
+    "   ) AS inner_table USING (object_uuid, version)"
+
+#define FULL_LAYOUT_JOIN_EXTENTS " ) AS outer_table USING (extent_uuid)"
+
+/* The rows of a layout must be consecutive, in the order of its extents, and
+ * the generations of an object sorted by version
+ */
+#define FULL_LAYOUT_ORDER_EXTENTS "version, object_uuid, layout_index"
+
+/** Columns of FULL_LAYOUT_SELECT */
+enum full_layout_column {
+    FL_OID,
+    FL_UUID,
+    FL_VERSION,
+    FL_LYT_INFO,
+    FL_EXTENT_UUID,
+    FL_LAYOUT_INDEX,
+    FL_STATE,
+    FL_SIZE,
+    FL_OFFSET,
+    FL_FAMILY,
+    FL_MEDIUM,
+    FL_LIBRARY,
+    FL_ADDRESS,
+    FL_XXH128,
+    FL_MD5,
+    FL_CRC32C,
+    FL_INFO,
+};
+
+static const Oid full_layout_from_uuid_types[] = { 0, DSS_INT4OID };
+
+const struct dss_prepared full_layout_from_uuid_stmt = {
+    .name        = "dss_full_layout_from_uuid",
+    .query       = FULL_LAYOUT_SELECT
+                   " WHERE object_uuid = $1 AND version = $2"
+                   FULL_LAYOUT_JOIN_EXTENTS
+                   " ORDER BY layout_index;",
+    .n_params    = 2,
+    .param_types = full_layout_from_uuid_types,
+};
+
 static int full_layout_select_query(GString **conditions, int n_conditions,
                                     GString *request, struct dss_sort *sort)
 {
-    g_string_append(request,
-                    "SELECT oid, object_uuid, version, lyt_info,"
-                    " json_agg(json_build_object("
-                    "  'extent_uuid', extent_uuid, 'sz', size,"
-                    "  'offsetof', offsetof, 'fam', medium_family,"
-                    "  'state', state, 'media', medium_id,"
-                    "  'library', medium_library, 'addr', address,"
-                    "  'hash', hash, 'info', info, 'lyt_index', layout_index"
-                    " ) ORDER BY layout_index)"
-                    " FROM extent"
-                    " RIGHT JOIN ("
-                    "  SELECT oid, object_uuid, version, lyt_info, extent_uuid,"
-                    "         layout_index"
-                    "   FROM layout"
-                    "   LEFT JOIN ("
-                    "    SELECT oid, object_uuid, version, lyt_info FROM object"
-                    "    UNION SELECT oid, object_uuid, version, lyt_info"
-                    "     FROM deprecated_object"
-                    "   ) AS inner_table USING (object_uuid, version)");
+    g_string_append(request, FULL_LAYOUT_SELECT);
 
     if (n_conditions >= 1)
         g_string_append(request, conditions[0]->str);
 
-    g_string_append(request,
-                    " ) AS outer_table USING (extent_uuid)");
+    g_string_append(request, FULL_LAYOUT_JOIN_EXTENTS);
 
     if (n_conditions >= 2)
         g_string_append(request, conditions[1]->str);
 
-    g_string_append(request,
-                    " GROUP BY oid, object_uuid, version, lyt_info");
-    if (sort)
+    if (sort && sort->psql_sort) {
         dss_sort2sql(request, sort);
-    else
-        g_string_append(request, " ORDER BY oid, version, object_uuid");
+        g_string_append(request, ", " FULL_LAYOUT_ORDER_EXTENTS);
+    } else {
+        g_string_append(request,
+                        " ORDER BY oid, " FULL_LAYOUT_ORDER_EXTENTS);
+    }
 
     return 0;
 }
 
+static const char *get_nullable_value(PGresult *res, int row_num, int column)
+{
+    return PQgetisnull(res, row_num, column) ?
+        NULL : PQgetvalue(res, row_num, column);
+}
+
 /**
- * Extract extents from json
+ * Decode the extent of a full layout row.
  *
- * \param[out] extents extent list
- * \param[out] count  number of extents decoded
- * \param[in]  json   String with json media stats
+ * \param[out] extent   Zeroed extent to fill, left zeroed on failure
+ * \param[in]  res      Result holding the row
+ * \param[in]  row_num  Row to decode
  *
  * \return 0 on success, negative error code on failure.
  */
-static int layout_extents_decode(struct extent **extents, int *count,
-                                 const char *json)
+static int extent_from_row(struct extent *extent, PGresult *res, int row_num)
 {
-    struct extent *result = NULL;
-    size_t extents_res_size;
-    json_error_t json_error;
-    json_t *child;
-    json_t *root;
+    static const enum full_layout_column mandatory[] = {
+        FL_EXTENT_UUID, FL_LAYOUT_INDEX, FL_STATE, FL_SIZE, FL_OFFSET,
+        FL_FAMILY, FL_MEDIUM, FL_LIBRARY, FL_ADDRESS,
+    };
+    size_t i;
     int rc;
-    int i;
-
-    ENTRY;
-
-    pho_debug("Decoding JSON representation for extents: '%s'", json);
-
-    root = json_loads(json, JSON_REJECT_DUPLICATES, &json_error);
-    if (!root)
-        LOG_RETURN(-EINVAL, "Failed to parse json data: %s", json_error.text);
-
-    if (!json_is_array(root))
-        LOG_GOTO(out_decref, rc = -EINVAL, "Invalid extents description");
-
-    *count = json_array_size(root);
-    if (*count == 0) {
-        extents = NULL;
-        LOG_GOTO(out_decref, rc = -EINVAL,
-                 "json parser: extents array is empty");
-    }
-
-    extents_res_size = sizeof(struct extent) * (*count);
-    result = xcalloc(1, extents_res_size);
-
-    for (i = 0; i < *count; i++) {
-        const char *tmp;
-        const char *tmp2;
-
-        child = json_array_get(root, i);
-
-        result[i].uuid = json_dict2str(child, "extent_uuid");
-        if (!result[i].uuid)
-            LOG_GOTO(out_decref, rc = -EINVAL,
-                     "Missing attribute 'extent_uuid'");
-
-        result[i].layout_idx = json_dict2ll(child, "lyt_index");
-        if (result[i].layout_idx < 0)
-            LOG_GOTO(out_decref, rc = -EINVAL, "Missing attribute 'lyt_index'");
-
-        tmp = json_dict2tmp_str(child, "state");
-        if (!tmp)
-            LOG_GOTO(out_decref, rc = -EINVAL, "Missing attribute 'state'");
-
-        result[i].state = str2extent_state(tmp);
-        result[i].size = json_dict2ll(child, "sz");
-        if (result[i].size < 0)
-            LOG_GOTO(out_decref, rc = -EINVAL, "Missing attribute 'sz'");
-
-        result[i].address.buff = json_dict2str(child, "addr");
-        if (!result[i].address.buff)
-            LOG_GOTO(out_decref, rc = -EINVAL, "Missing attribute 'addr'");
-
-        result[i].address.size = strlen(result[i].address.buff) + 1;
-
-        tmp = json_dict2tmp_str(child, "fam");
-        if (!tmp)
-            LOG_GOTO(out_decref, rc = -EINVAL, "Missing attribute 'fam'");
-
-        result[i].media.family = str2rsc_family(tmp);
-
-        result[i].offset = json_dict2ll(child, "offsetof");
-        if (result[i].offset == INT64_MIN)
-            LOG_GOTO(out_decref, rc = -EINVAL, "Missing attribute 'offsetof'");
 
-        /*XXX fs_type & address_type retrieved from media info */
-        if (result[i].media.family == PHO_RSC_INVAL)
-            LOG_GOTO(out_decref, rc = -EINVAL, "Invalid medium family");
-
-        tmp = json_dict2tmp_str(child, "media");
-        if (!tmp)
-            LOG_GOTO(out_decref, rc = -EINVAL, "Missing attribute 'media'");
-
-        tmp2 = json_dict2tmp_str(child, "library");
-        if (!tmp2)
-            LOG_GOTO(out_decref, rc = -EINVAL, "Missing attribute 'library'");
-
-        pho_id_name_set(&result[i].media, tmp, tmp2);
+    for (i = 0; i < sizeof(mandatory) / sizeof(mandatory[0]); i++)
+        if (PQgetisnull(res, row_num, mandatory[i]))
+            LOG_RETURN(-EINVAL, "Missing attribute '%s' in layout of '%s'",
+                       PQfname(res, mandatory[i]),
+                       PQgetvalue(res, row_num, FL_UUID));
+
+    extent->media.family = str2rsc_family(PQgetvalue(res, row_num,
+                                                     FL_FAMILY));
+    /*XXX fs_type & address_type retrieved from media info */
+    if (extent->media.family == PHO_RSC_INVAL)
+        LOG_RETURN(-EINVAL, "Invalid medium family");
+
+    rc = dss_extent_hash_decode_hex(extent,
+                                    get_nullable_value(res, row_num,
+                                                       FL_XXH128),
+                                    get_nullable_value(res, row_num, FL_MD5),
+                                    get_nullable_value(res, row_num,
+                                                       FL_CRC32C));
+    if (rc)
+        LOG_RETURN(-EINVAL, "Failed to set hash");
 
-        rc = dss_extent_hash_decode(&result[i], json_object_get(child, "hash"));
+    if (!PQgetisnull(res, row_num, FL_INFO)) {
+        rc = pho_json_to_attrs(&extent->info,
+                               PQgetvalue(res, row_num, FL_INFO));
         if (rc)
-            LOG_GOTO(out_decref, rc = -EINVAL, "Failed to set hash");
-
-        pho_json_raw_to_attrs(&result[i].info,
-                              json_object_get(child, "info"));
+            LOG_RETURN(rc, "Failed to decode extent info");
     }
 
-    *extents = result;
-    rc = 0;
+    extent->uuid = xstrdup(PQgetvalue(res, row_num, FL_EXTENT_UUID));
+    extent->layout_idx = atoi(PQgetvalue(res, row_num, FL_LAYOUT_INDEX));
+    extent->state = str2extent_state(PQgetvalue(res, row_num, FL_STATE));
+    extent->size = atoll(PQgetvalue(res, row_num, FL_SIZE));
+    extent->offset = atoll(PQgetvalue(res, row_num, FL_OFFSET));
+    pho_id_name_set(&extent->media, PQgetvalue(res, row_num, FL_MEDIUM),
+                    PQgetvalue(res, row_num, FL_LIBRARY));
+    extent->address.buff = xstrdup(PQgetvalue(res, row_num, FL_ADDRESS));
+    extent->address.size = strlen(extent->address.buff) + 1;
 
-out_decref:
-    if (rc)
-        free(result);
-    json_decref(root);
-    return rc;
+    return 0;
 }
 
-static int full_layout_from_pg_row(struct dss_handle *handle, void *void_layout,
-                                   PGresult *res, int row_num)
+/** Append the extent of a row to \p layout */
+static int layout_add_extent(struct layout_info *layout, PGresult *res,
+                             int row_num)
 {
-    struct layout_info *layout = void_layout;
+    int count = layout->ext_count;
     int rc;
 
-    (void) handle;
+    /* the capacity of the extent list is the next power of two of its
+     * count, so that it is only reallocated when the count reaches a power
+     * of two
+     */
+    if (count == 0 || (count & (count - 1)) == 0)
+        layout->extents = xrealloc(layout->extents,
+                                   (count ? 2 * count : 1) *
+                                   sizeof(*layout->extents));
+
+    memset(&layout->extents[count], 0, sizeof(*layout->extents));
+    rc = extent_from_row(&layout->extents[count], res, row_num);
+    if (rc) {
+        pho_attrs_free(&layout->extents[count].info);
+        return rc;
+    }
 
-    layout->oid = PQgetvalue(res, row_num, 0);
-    layout->uuid = PQgetvalue(res, row_num, 1);
-    layout->version = atoi(PQgetvalue(res, row_num, 2));
-    rc = layout_desc_decode(&layout->layout_desc, PQgetvalue(res, row_num, 3));
-    if (rc)
-        LOG_RETURN(rc, "dss_layout_desc decode error");
-    rc = layout_extents_decode(&layout->extents, &layout->ext_count,
-                               PQgetvalue(res, row_num, 4));
-    if (rc)
-        LOG_RETURN(rc, "dss_extent decode error");
+    layout->ext_count++;
 
     return 0;
 }
@@ -214,24 +209,62 @@ static int full_layout_from_pg_row(struct dss_handle *handle, void *void_layout,
 static void full_layout_result_free(void *void_layout)
 {
     struct layout_info *layout = void_layout;
+    int i;
 
     if (!layout)
         return;
 
+    free(layout->oid);
+    free(layout->uuid);
+
     /* Undo dss_layout_desc_decode */
     free(layout->layout_desc.mod_name);
     pho_attrs_free(&layout->layout_desc.mod_attrs);
 
-    /* Undo dss_layout_extents_decode */
+    /* Undo extent_from_row */
+    for (i = 0; i < layout->ext_count; i++)
+        pho_attrs_free(&layout->extents[i].info);
     layout_info_free_extents(layout);
 }
 
+int full_layout_add_row(struct layout_info *last, struct layout_info *next,
+                        PGresult *res, int row_num)
+{
+    const char *uuid = PQgetvalue(res, row_num, FL_UUID);
+    int version = atoi(PQgetvalue(res, row_num, FL_VERSION));
+    int rc;
+
+    if (last && last->version == version && !strcmp(last->uuid, uuid))
+        return layout_add_extent(last, res, row_num);
+
+    memset(next, 0, sizeof(*next));
+    next->oid = xstrdup(PQgetvalue(res, row_num, FL_OID));
+    next->uuid = xstrdup(uuid);
+    next->version = version;
+
+    rc = layout_desc_decode(&next->layout_desc,
+                            PQgetvalue(res, row_num, FL_LYT_INFO));
+    if (rc) {
+        full_layout_result_free(next);
+        LOG_RETURN(rc, "dss_layout_desc decode error");
+    }
+
+    rc = layout_add_extent(next, res, row_num);
+    if (rc) {
+        full_layout_result_free(next);
+        LOG_RETURN(rc, "dss_extent decode error");
+    }
+
+    return 1;
+}
+
+/* The rows are decoded by full_layout_add_row, not one item per row */
 const struct dss_resource_ops full_layout_ops = {
     .insert_query = NULL,
     .update_query = NULL,
     .select_query = full_layout_select_query,
     .delete_query = NULL,
-    .create       = full_layout_from_pg_row,
+    .create       = NULL,
     .free         = full_layout_result_free,
     .size         = sizeof(struct layout_info),
 };
@@ -27,13 +27,38 @@
 #ifndef _PHO_DSS_FULL_LAYOUT_H
 #define _PHO_DSS_FULL_LAYOUT_H
 
+#include "dss_utils.h"
 #include "resources.h"
 
 /**
  * The "full layout" operations structure.
  * Implements every function of the structure except "insert_query",
- * "update_query" and "delete_query".
+ * "update_query", "delete_query" and "create", the rows being decoded with
+ * full_layout_add_row.
  */
 extern const struct dss_resource_ops full_layout_ops;
 
+/**
+ * Prepared select of the full layout of one object, given its uuid ($1) and
+ * version ($2).
+ */
+extern const struct dss_prepared full_layout_from_uuid_stmt;
+
+/**
+ * Decode a row of a full layout select. The rows of a layout are consecutive,
+ * one per extent: the extent of the row is appended to \p last if the row
+ * belongs to it, otherwise a new layout is started in \p next.
+ *
+ * \param[in,out] last     Last layout decoded, NULL if none
+ * \param[out]    next     Layout to start if the row does not belong to
+ *                         \p last, left unset on failure
+ * \param[in]     res      Result holding the row
+ * \param[in]     row_num  Row to decode
+ *
+ * \return 1 if \p next was started, 0 if \p last was completed, negative
+ *         error code on failure
+ */
+int full_layout_add_row(struct layout_info *last, struct layout_info *next,
+                        PGresult *res, int row_num);
+
 #endif
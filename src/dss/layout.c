@@ -154,6 +154,75 @@ static int layout_insert_query(PGconn *conn, void *void_layout, int item_cnt,
     return 0;
 }
 
+static const Oid layout_insert_types[] = { 0, 0, DSS_INT4OID };
+
+static const struct dss_prepared layout_insert_stmt = {
+    .name        = "dss_layout_insert",
+    .query       = "INSERT INTO layout (object_uuid, version, extent_uuid,"
+                   " layout_index) VALUES ("
+                   "(SELECT object_uuid FROM object WHERE oid = $1),"
+                   " (SELECT version FROM object WHERE oid = $1),"
+                   " (SELECT extent_uuid FROM extent WHERE address = $2),"
+                   " $3);",
+    .n_params    = 3,
+    .param_types = layout_insert_types,
+};
+
+static const struct dss_prepared layout_info_update_stmt = {
+    .name        = "dss_layout_info_update",
+    .query       = "UPDATE object SET lyt_info = $1 WHERE oid = $2;",
+    .n_params    = 2,
+    .param_types = NULL,
+};
+
+static int layout_insert_prepared(struct dss_handle *handle,
+                                  void *void_layout, int item_cnt,
+                                  int64_t fields)
+{
+    struct dss_params params;
+    PGresult *res;
+    int rc;
+
+    (void) fields;
+
+    for (int i = 0; i < item_cnt; ++i) {
+        struct layout_info *layout = ((struct layout_info *) void_layout) + i;
+        char *layout_description;
+
+        for (int j = 0; j < layout->ext_count; ++j) {
+            struct extent *extent = &layout->extents[j];
+
+            params.count = 0;
+            dss_param_str(&params, layout->oid);
+            dss_param_str(&params, extent->address.buff);
+            dss_param_int4(&params, extent->layout_idx);
+
+            rc = execute_prepared(handle, &layout_insert_stmt, &params, &res,
+                                  PGRES_COMMAND_OK);
+            PQclear(res);
+            if (rc)
+                return rc;
+        }
+
+        layout_description = dss_layout_desc_encode(&layout->layout_desc);
+        if (!layout_description)
+            LOG_RETURN(-EINVAL, "JSON layout desc encoding error");
+
+        params.count = 0;
+        dss_param_str(&params, layout_description);
+        dss_param_str(&params, layout->oid);
+
+        rc = execute_prepared(handle, &layout_info_update_stmt, &params, &res,
+                              PGRES_COMMAND_OK);
+        PQclear(res);
+        free(layout_description);
+        if (rc)
+            return rc;
+    }
+
+    return 0;
+}
+
 static int layout_select_query(GString **conditions, int n_conditions,
                                GString *request, struct dss_sort *sort)
 {
@@ -310,11 +379,12 @@ static void layout_result_free(void *void_layout)
 }
 
 const struct dss_resource_ops layout_ops = {
-    .insert_query = layout_insert_query,
-    .update_query = NULL,
-    .select_query = layout_select_query,
-    .delete_query = layout_delete_query,
-    .create       = layout_from_pg_row,
-    .free         = layout_result_free,
-    .size         = sizeof(struct layout_info),
+    .insert_query    = layout_insert_query,
+    .insert_prepared = layout_insert_prepared,
+    .update_query    = NULL,
+    .select_query    = layout_select_query,
+    .delete_query    = layout_delete_query,
+    .create          = layout_from_pg_row,
+    .free            = layout_result_free,
+    .size            = sizeof(struct layout_info),
 };
@@ -332,10 +332,7 @@ static const char *pho_log2str(struct pho_log *log)
     return repr;
 }
 
-void emit_log_after_action(struct dss_handle *dss,
-                           struct pho_log *log,
-                           enum operation_type action,
-                           int rc)
+bool log_after_action(struct pho_log *log, enum operation_type action, int rc)
 {
     log->error_number = rc;
     if (rc) {
@@ -352,7 +349,23 @@ void emit_log_after_action(struct dss_handle *dss,
         }
     }
 
-    if (should_log(log, action)) {
+    return should_log(log, action);
+}
+
+static void log_emit_failed(struct pho_log *log, int rc)
+{
+    const char *log_str = pho_log2str(log);
+
+    pho_error(rc, "Failed to emit log: %s", log_str);
+    free((void *) log_str);
+}
+
+void emit_log_after_action(struct dss_handle *dss,
+                           struct pho_log *log,
+                           enum operation_type action,
+                           int rc)
+{
+    if (log_after_action(log, action, rc)) {
         GString *request;
         int rc2;
 
@@ -361,13 +374,10 @@ void emit_log_after_action(struct dss_handle *dss,
         logs_insert_query(dss->dh_conn, log, 1, 0, request);
         rc2 = execute_and_commit_or_rollback(dss->dh_conn, request, NULL,
                                              PGRES_COMMAND_OK);
+        g_string_free(request, true);
 
-        if (rc2) {
-            const char *log_str = pho_log2str(log);
-
-            pho_error(rc2, "Failed to emit log: %s", log_str);
-            free((void *) log_str);
-        }
+        if (rc2)
+            log_emit_failed(log, rc2);
         /* Ignore emit errors */
     }
 
@@ -375,6 +385,42 @@ void emit_log_after_action(struct dss_handle *dss,
         json_decref(log->message);
 }
 
+void logs_emit(struct dss_handle *dss, struct pho_log *logs, int count)
+{
+    GString **requests;
+    int *rcs;
+    int rc;
+    int i;
+
+    if (count == 0)
+        return;
+
+    requests = xcalloc(count, sizeof(*requests));
+    rcs = xcalloc(count, sizeof(*rcs));
+
+    /* One request per log, so that a log that cannot be inserted does not
+     * prevent the others to be.
+     */
+    for (i = 0; i < count; i++) {
+        requests[i] = g_string_new(NULL);
+        logs_insert_query(dss->dh_conn, &logs[i], 1, 0, requests[i]);
+    }
+
+    rc = execute_pipeline(dss->dh_conn, requests, count, rcs,
+                          PGRES_COMMAND_OK);
+    if (rc)
+        pho_error(rc, "Failed to send %d logs", count);
+
+    for (i = 0; i < count; i++) {
+        if (rcs[i])
+            log_emit_failed(&logs[i], rcs[i]);
+        g_string_free(requests[i], true);
+    }
+
+    free(requests);
+    free(rcs);
+}
+
 static ssize_t count_health(struct pho_log *logs, size_t count,
                             size_t max_health)
 {
@@ -35,6 +35,20 @@
  */
 extern const struct dss_resource_ops logs_ops;
 
+/**
+ * Complete \p log with the outcome \p rc of \p action, as
+ * emit_log_after_action does.
+ *
+ * \return true if the log must be emitted, false otherwise
+ */
+bool log_after_action(struct pho_log *log, enum operation_type action, int rc);
+
+/**
+ * Insert \p count logs in one round trip. The logs that cannot be inserted are
+ * reported in the daemon logs instead. The messages are not freed.
+ */
+void logs_emit(struct dss_handle *dss, struct pho_log *logs, int count);
+
 int dss_resource_health(struct dss_handle *dss,
                         const struct pho_id *medium_id,
                         enum dss_type resource, size_t max_health,
@@ -594,13 +594,34 @@ static int media_update_query(PGconn *conn, void *src_med, void *dst_med,
     return 0;
 }
 
+#define MEDIA_COLUMNS                                                       \
+    "family, model, media.id, media.library, adm_status,"                   \
+    " address_type, fs_type, fs_status, fs_label, stats, tags, "            \
+    " put, get, delete, groupings"
+
+#define MEDIA_SELECT "SELECT " MEDIA_COLUMNS " FROM media"
+
+/* Index of the first lock column in the rows of media_with_lock_select */
+#define MEDIA_LOCK_COLUMN 15
+
+const char * const media_with_lock_select =
+    "SELECT " MEDIA_COLUMNS ", lock.hostname, lock.owner, lock.timestamp"
+    " FROM media"
+    " LEFT JOIN lock ON lock.type = 'media'::lock_type"
+    "               AND lock.id = media.id || '_' || media.library";
+
+const struct dss_prepared media_from_id_stmt = {
+    .name        = "dss_media_from_id",
+    .query       = MEDIA_SELECT
+                   " WHERE family = $1 AND id = $2 AND library = $3;",
+    .n_params    = 3,
+    .param_types = NULL,
+};
+
 static int media_select_query(GString **conditions, int n_conditions,
                               GString *request, struct dss_sort *sort)
 {
-    g_string_append(request,
-                    "SELECT family, model, media.id, media.library, adm_status,"
-                    " address_type, fs_type, fs_status, fs_label, stats, tags, "
-                    " put, get, delete, groupings FROM media");
+    g_string_append(request, MEDIA_SELECT);
 
     if (sort && sort->is_lock)
         g_string_append(request,
@@ -633,6 +654,26 @@ static int media_delete_query(void *void_med, int item_cnt, GString *request)
     return 0;
 }
 
+static void media_lock_from_pg_row(struct pho_lock *lock, PGresult *res,
+                                   int row_num)
+{
+    struct timeval timestamp;
+
+    if (PQgetisnull(res, row_num, MEDIA_LOCK_COLUMN)) {
+        lock->hostname = NULL;
+        lock->owner = 0;
+        lock->timestamp.tv_sec = 0;
+        lock->timestamp.tv_usec = 0;
+        return;
+    }
+
+    str2timeval(PQgetvalue(res, row_num, MEDIA_LOCK_COLUMN + 2), &timestamp);
+    init_pho_lock(lock, PQgetvalue(res, row_num, MEDIA_LOCK_COLUMN),
+                  (int) strtoll(PQgetvalue(res, row_num, MEDIA_LOCK_COLUMN + 1),
+                                NULL, 10),
+                  &timestamp);
+}
+
 static int media_from_pg_row(struct dss_handle *handle, void *void_media,
                              PGresult *res, int row_num)
 {
@@ -680,6 +721,12 @@ static int media_from_pg_row(struct dss_handle *handle, void *void_media,
     pho_debug("Decoded %lu groupings (%s)",
               medium->groupings.count, PQgetvalue(res, row_num, 14));
 
+    if (PQnfields(res) > MEDIA_LOCK_COLUMN) {
+        /* the lock was joined to the medium, no need to query it */
+        media_lock_from_pg_row(&medium->lock, res, row_num);
+        return 0;
+    }
+
     rc = dss_lock_status(handle, DSS_MEDIA, medium, 1, &medium->lock);
     if (rc == -ENOLCK) {
         medium->lock.hostname = NULL;
@@ -27,6 +27,7 @@
 #ifndef _PHO_DSS_MEDIA_H
 #define _PHO_DSS_MEDIA_H
 
+#include "dss_utils.h"
 #include "resources.h"
 
 /**
@@ -35,4 +36,17 @@
  */
 extern const struct dss_resource_ops media_ops;
 
+/**
+ * Prepared select of one medium, given its family ($1), id ($2) and library
+ * ($3).
+ */
+extern const struct dss_prepared media_from_id_stmt;
+
+/**
+ * Select of the media joined with their lock, to be completed by a WHERE
+ * clause. The rows it returns are decoded by the "media" operations without
+ * any additional lock status query.
+ */
+extern const char * const media_with_lock_select;
+
 #endif
@@ -91,6 +91,58 @@ static int object_insert_query(PGconn *conn, void *void_object, int item_cnt,
     return 0;
 }
 
+static const Oid object_insert_types[] = { 0, 0, 0, 0 };
+static const Oid object_full_insert_types[] = { 0, 0, DSS_INT4OID, 0, 0, 0 };
+
+static const struct dss_prepared object_insert_stmt = {
+    .name        = "dss_object_insert",
+    .query       = "INSERT INTO object (oid, user_md, obj_status, _grouping)"
+                   " VALUES ($1, $2, $3, $4);",
+    .n_params    = 4,
+    .param_types = object_insert_types,
+};
+
+static const struct dss_prepared object_full_insert_stmt = {
+    .name        = "dss_object_full_insert",
+    .query       = "INSERT INTO object (oid, object_uuid, version, user_md,"
+                   " obj_status, _grouping) VALUES ($1, $2, $3, $4, $5, $6);",
+    .n_params    = 6,
+    .param_types = object_full_insert_types,
+};
+
+static int object_insert_prepared(struct dss_handle *handle,
+                                  void *void_object, int item_cnt,
+                                  int64_t fields)
+{
+    for (int i = 0; i < item_cnt; ++i) {
+        struct object_info *object = ((struct object_info *) void_object) + i;
+        const struct dss_prepared *stmt;
+        struct dss_params params;
+        PGresult *res;
+        int rc;
+
+        params.count = 0;
+        dss_param_str(&params, object->oid);
+        if (fields & INSERT_OBJECT) {
+            stmt = &object_insert_stmt;
+        } else {
+            stmt = &object_full_insert_stmt;
+            dss_param_str(&params, object->uuid);
+            dss_param_int4(&params, object->version);
+        }
+        dss_param_str(&params, object->user_md);
+        dss_param_str(&params, obj_status2str(object->obj_status));
+        dss_param_str(&params, object->grouping);
+
+        rc = execute_prepared(handle, stmt, &params, &res, PGRES_COMMAND_OK);
+        PQclear(res);
+        if (rc)
+            return rc;
+    }
+
+    return 0;
+}
+
 static inline const char *_get_user_md(void *object)
 {
     return ((struct object_info *) object)->user_md;
@@ -192,11 +244,12 @@ static void object_result_free(void *void_object)
 }
 
 const struct dss_resource_ops object_ops = {
-    .insert_query = object_insert_query,
-    .update_query = object_update_query,
-    .select_query = object_select_query,
-    .delete_query = object_delete_query,
-    .create       = object_from_pg_row,
-    .free         = object_result_free,
-    .size         = sizeof(struct object_info),
+    .insert_query    = object_insert_query,
+    .insert_prepared = object_insert_prepared,
+    .update_query    = object_update_query,
+    .select_query    = object_select_query,
+    .delete_query    = object_delete_query,
+    .create          = object_from_pg_row,
+    .free            = object_result_free,
+    .size            = sizeof(struct object_info),
 };
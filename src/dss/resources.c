@@ -87,6 +87,25 @@ int get_insert_query(enum dss_type type, PGconn *conn, void *void_resource,
                                       request);
 }
 
+bool has_insert_prepared(enum dss_type type)
+{
+    const struct dss_resource_ops *resource_ops = get_resource_ops(type);
+
+    return resource_ops != NULL && resource_ops->insert_prepared != NULL;
+}
+
+int insert_prepared(enum dss_type type, struct dss_handle *handle,
+                    void *void_resource, int item_count, int64_t fields)
+{
+    const struct dss_resource_ops *resource_ops = get_resource_ops(type);
+
+    if (resource_ops == NULL || resource_ops->insert_prepared == NULL)
+        return -ENOTSUP;
+
+    return resource_ops->insert_prepared(handle, void_resource, item_count,
+                                         fields);
+}
+
 int get_update_query(enum dss_type type, PGconn *conn, void *src_resource,
                      void *dst_resource, int item_count, int64_t fields,
                      GString *request)
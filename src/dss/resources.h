@@ -29,6 +29,7 @@
 
 #include <gmodule.h>
 #include <libpq-fe.h>
+#include <stdbool.h>
 #include <stddef.h>
 
 #include "pho_dss.h"
@@ -47,6 +48,8 @@
 struct dss_resource_ops {
     int (*insert_query)(PGconn *conn, void *void_resource, int item_count,
                         int64_t fields, GString *request);
+    int (*insert_prepared)(struct dss_handle *handle, void *void_resource,
+                           int item_count, int64_t fields);
     int (*update_query)(PGconn *conn, void *src_resource, void *dst_resource,
                         int item_count, int64_t fields, GString *request);
     int (*select_query)(GString **conditions, int n_conditions,
@@ -80,6 +83,30 @@ struct dss_resource_ops {
 int get_insert_query(enum dss_type type, PGconn *conn, void *void_resource,
                      int item_count, int64_t fields, GString *request);
 
+/**
+ * Insert resources with prepared statements, one execution per row, inside the
+ * transaction opened by the caller.
+ *
+ * \param[in]  type           The resource type whose insert_prepared function
+ *                            should be called
+ * \param[in]  handle         The DSS handle holding the prepared statements
+ * \param[in]  void_resource  The resources to insert
+ * \param[in]  item_count     The number of resources to insert
+ * \param[in]  fields         Additionnal fields used to specify the type of
+ *                            insert
+ *
+ * \return 0 on success, -ENOTSUP if the resource has no prepared insert, the
+ *                                caller should then use get_insert_query
+ *                       negative error code otherwise
+ */
+int insert_prepared(enum dss_type type, struct dss_handle *handle,
+                    void *void_resource, int item_count, int64_t fields);
+
+/**
+ * Whether resources of \p type can be inserted with insert_prepared.
+ */
+bool has_insert_prepared(enum dss_type type);
+
 /**
  * Get the update query of a resource into \p request.
  *
@@ -29,6 +29,7 @@
 #include <glib.h>
 #include <libpq-fe.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "pho_common.h"
 #include "pho_dss.h"
@@ -81,27 +82,10 @@ int dss_one_medium_get_from_id(struct dss_handle *dss,
                                const struct pho_id *medium_id,
                                struct media_info **medium_info)
 {
-    struct dss_filter filter;
     int cnt;
     int rc;
 
-    /* get medium info from medium id */
-    rc = dss_filter_build(&filter,
-                          "{\"$AND\": ["
-                              "{\"DSS::MDA::family\": \"%s\"}, "
-                              "{\"DSS::MDA::id\": \"%s\"}, "
-                              "{\"DSS::MDA::library\": \"%s\"}"
-                          "]}",
-                          rsc_family2str(medium_id->family),
-                          medium_id->name, medium_id->library);
-    if (rc)
-        LOG_RETURN(rc,
-                   "Unable to build filter for media family %s, name %s and "
-                   "library %s", rsc_family2str(medium_id->family),
-                   medium_id->name, medium_id->library);
-
-    rc = dss_media_get(dss, &filter, medium_info, &cnt, NULL);
-    dss_filter_free(&filter);
+    rc = dss_media_get_from_id(dss, medium_id, medium_info, &cnt);
     if (rc)
         LOG_RETURN(rc,
                    "Error while getting medium info for family %s, name %s "
@@ -122,23 +106,24 @@ int dss_one_medium_get_from_id(struct dss_handle *dss,
     return 0;
 }
 
-int dss_medium_locate(struct dss_handle *dss, const struct pho_id *medium_id,
-                      char **hostname, struct media_info **_medium_info)
+/**
+ * Check that a medium can be read and get the host holding its lock, the
+ * common part of dss_medium_locate and dss_media_locate.
+ */
+static int medium_locate_check(const struct media_info *medium_info,
+                               char **hostname,
+                               struct media_info **_medium_info)
 {
-    struct media_info *medium_info;
-    int rc;
+    const struct pho_id *medium_id = &medium_info->rsc.id;
 
     *hostname = NULL;
-    rc = dss_one_medium_get_from_id(dss, medium_id, &medium_info);
-    if (rc)
-        LOG_RETURN(rc, "Unable to get medium_info to locate");
 
     /* check ADMIN STATUS to see if the medium is available */
     if (medium_info->rsc.adm_status != PHO_RSC_ADM_ST_UNLOCKED) {
         pho_warn("Medium (family %s, name %s, library %s) is admin locked",
                  rsc_family2str(medium_id->family), medium_id->name,
                  medium_id->library);
-        GOTO(clean, rc = -EACCES);
+        return -EACCES;
     }
 
     if (!medium_info->flags.get) {
@@ -146,7 +131,7 @@ int dss_medium_locate(struct dss_handle *dss, const struct pho_id *medium_id,
                  "(family %s, name %s, library %s)",
                  rsc_family2str(medium_id->family), medium_id->name,
                  medium_id->library);
-        GOTO(clean, rc = -EPERM);
+        return -EPERM;
     }
 
     if (_medium_info != NULL)
@@ -155,21 +140,260 @@ int dss_medium_locate(struct dss_handle *dss, const struct pho_id *medium_id,
     /* medium without any lock */
     if (!medium_info->lock.owner) {
         if (medium_info->rsc.id.family == PHO_RSC_DIR)
-            GOTO(clean, rc = -ENODEV);
+            return -ENODEV;
 
-        *hostname = NULL;
-        GOTO(clean, rc = 0);
+        return 0;
     }
 
     /* get lock hostname */
     *hostname = xstrdup(medium_info->lock.hostname);
 
-clean:
+    return 0;
+}
+
+int dss_medium_locate(struct dss_handle *dss, const struct pho_id *medium_id,
+                      char **hostname, struct media_info **_medium_info)
+{
+    struct media_info *medium_info;
+    int rc;
+
+    *hostname = NULL;
+    rc = dss_one_medium_get_from_id(dss, medium_id, &medium_info);
+    if (rc)
+        LOG_RETURN(rc, "Unable to get medium_info to locate");
+
+    rc = medium_locate_check(medium_info, hostname, _medium_info);
     dss_res_free(medium_info, 1);
 
     return rc;
 }
 
+/* Number of media located by each query of dss_media_locate */
+#define DSS_LOCATE_BATCH 512
+
+static int media_locate_batch(struct dss_handle *dss,
+                              struct dss_medium_location *locations,
+                              size_t count)
+{
+    struct media_info *media;
+    struct pho_id *ids;
+    GHashTable *found;
+    int n_media;
+    size_t i;
+    int rc;
+
+    ids = xmalloc(count * sizeof(*ids));
+    for (i = 0; i < count; i++)
+        ids[i] = locations[i].id;
+
+    rc = dss_media_get_from_ids(dss, ids, count, &media, &n_media);
+    free(ids);
+    if (rc)
+        return rc;
+
+    found = g_hash_table_new(g_pho_id_hash, g_pho_id_equal);
+    for (i = 0; i < n_media; i++)
+        g_hash_table_insert(found, &media[i].rsc.id, &media[i]);
+
+    for (i = 0; i < count; i++) {
+        struct dss_medium_location *loc = &locations[i];
+        struct media_info *medium;
+
+        medium = g_hash_table_lookup(found, &loc->id);
+        if (!medium) {
+            pho_warn("Medium (family %s, name %s, library %s) is absent from "
+                     "media table", rsc_family2str(loc->id.family),
+                     loc->id.name, loc->id.library);
+            loc->rc = -ENOENT;
+            continue;
+        }
+
+        loc->rc = medium_locate_check(medium, &loc->hostname, &loc->medium);
+    }
+
+    g_hash_table_destroy(found);
+    dss_res_free(media, n_media);
+
+    return 0;
+}
+
+int dss_media_locate(struct dss_handle *dss,
+                     struct dss_medium_location *locations, size_t count)
+{
+    size_t i;
+    int rc;
+
+    for (i = 0; i < count; i++) {
+        locations[i].rc = 0;
+        locations[i].hostname = NULL;
+        locations[i].medium = NULL;
+    }
+
+    for (i = 0; i < count; i += DSS_LOCATE_BATCH) {
+        size_t batch = min(count - i, (size_t) DSS_LOCATE_BATCH);
+        size_t j;
+
+        rc = media_locate_batch(dss, locations + i, batch);
+        if (rc) {
+            for (j = i; j < count; j++)
+                locations[j].rc = rc;
+
+            LOG_RETURN(rc, "Unable to get the media to locate");
+        }
+    }
+
+    return 0;
+}
+
+void dss_medium_location_fini(struct dss_medium_location *location)
+{
+    free(location->hostname);
+    location->hostname = NULL;
+    media_info_free(location->medium);
+    location->medium = NULL;
+}
+
+static void locate_cache_entry_free(gpointer data)
+{
+    struct dss_medium_location *loc = data;
+
+    dss_medium_location_fini(loc);
+    free(loc);
+}
+
+void dss_locate_cache_init(struct dss_locate_cache *cache)
+{
+    memset(cache, 0, sizeof(*cache));
+    /* the keys are the ids of the entries */
+    cache->media = g_hash_table_new_full(g_pho_id_hash, g_pho_id_equal, NULL,
+                                         locate_cache_entry_free);
+}
+
+void dss_locate_cache_fini(struct dss_locate_cache *cache)
+{
+    int i;
+
+    if (!cache->media)
+        return;
+
+    g_hash_table_destroy(cache->media);
+    cache->media = NULL;
+
+    for (i = 0; i < PHO_RSC_LAST; i++) {
+        if (cache->devices_loaded[i])
+            dss_res_free(cache->devices[i], cache->n_devices[i]);
+        cache->devices_loaded[i] = false;
+    }
+}
+
+int dss_locate_cache_load(struct dss_handle *dss,
+                          struct dss_locate_cache *cache,
+                          const struct pho_id *medium_ids, size_t count)
+{
+    struct dss_medium_location *locations;
+    GHashTable *missing;
+    size_t n_missing = 0;
+    size_t i;
+    int rc;
+
+    missing = g_hash_table_new(g_pho_id_hash, g_pho_id_equal);
+    locations = xcalloc(count, sizeof(*locations));
+    for (i = 0; i < count; i++) {
+        if (g_hash_table_contains(cache->media, &medium_ids[i]) ||
+            g_hash_table_contains(missing, &medium_ids[i]))
+            continue;
+
+        g_hash_table_add(missing, (gpointer) &medium_ids[i]);
+        locations[n_missing++].id = medium_ids[i];
+    }
+    g_hash_table_destroy(missing);
+
+    rc = dss_media_locate(dss, locations, n_missing);
+    if (rc) {
+        /* the batches located before the failure are filled */
+        for (i = 0; i < n_missing; i++)
+            dss_medium_location_fini(&locations[i]);
+        free(locations);
+        return rc;
+    }
+
+    for (i = 0; i < n_missing; i++) {
+        struct dss_medium_location *loc = xmalloc(sizeof(*loc));
+
+        *loc = locations[i];
+        g_hash_table_insert(cache->media, &loc->id, loc);
+    }
+    free(locations);
+
+    return 0;
+}
+
+int dss_locate_cache_medium(struct dss_handle *dss,
+                            struct dss_locate_cache *cache,
+                            const struct pho_id *medium_id, char **hostname,
+                            struct media_info **medium_info)
+{
+    struct dss_medium_location *loc;
+    int rc;
+
+    *hostname = NULL;
+    *medium_info = NULL;
+
+    loc = g_hash_table_lookup(cache->media, medium_id);
+    if (!loc) {
+        rc = dss_locate_cache_load(dss, cache, medium_id, 1);
+        if (rc)
+            return rc;
+
+        loc = g_hash_table_lookup(cache->media, medium_id);
+        assert(loc);
+    }
+
+    if (loc->rc)
+        return loc->rc;
+
+    *hostname = xstrdup_safe(loc->hostname);
+    *medium_info = media_info_dup(loc->medium);
+
+    return 0;
+}
+
+int dss_locate_cache_devices(struct dss_handle *dss,
+                             struct dss_locate_cache *cache,
+                             enum rsc_family family, struct dev_info **devices,
+                             int *count)
+{
+    int rc;
+
+    if (!cache->devices_loaded[family]) {
+        rc = dss_get_usable_devices(dss, family, NULL, &cache->devices[family],
+                                    &cache->n_devices[family]);
+        if (rc)
+            return rc;
+
+        cache->devices_loaded[family] = true;
+    }
+
+    *devices = cache->devices[family];
+    *count = cache->n_devices[family];
+
+    return 0;
+}
+
+void dss_locate_cache_set_host(struct dss_locate_cache *cache,
+                               const struct pho_id *medium_id,
+                               const char *hostname)
+{
+    struct dss_medium_location *loc;
+
+    loc = g_hash_table_lookup(cache->media, medium_id);
+    if (!loc || loc->rc)
+        return;
+
+    free(loc->hostname);
+    loc->hostname = xstrdup_safe(hostname);
+}
+
 int dss_medium_health(struct dss_handle *dss, const struct pho_id *medium_id,
                       size_t max_health, size_t *health)
 {
@@ -528,19 +752,42 @@ free_oid_list:
 
 int dss_update_extent_migrate(struct dss_handle *handle, const char *old_uuid,
                               const char *new_uuid)
+{
+    return dss_update_extents_migrate(handle, &old_uuid, &new_uuid, 1);
+}
+
+int dss_update_extents_migrate(struct dss_handle *handle,
+                               const char **old_uuids, const char **new_uuids,
+                               int count)
 {
     GString *request = g_string_new("BEGIN;");
-    PGresult *res;
     int rc = 0;
+    int i;
 
-    g_string_append_printf(request,
-        "UPDATE layout SET extent_uuid = '%s' WHERE extent_uuid = '%s';"
-        "UPDATE extent SET state = 'orphan' WHERE extent_uuid = '%s';"
-        "UPDATE extent SET state = 'sync' WHERE extent_uuid = '%s';",
-        new_uuid, old_uuid, old_uuid, new_uuid);
+    if (count < 1)
+        goto req_free;
 
-    rc = execute_and_commit_or_rollback(handle->dh_conn, request, &res,
+    for (i = 0; i < count; ++i)
+        g_string_append_printf(request,
+            "UPDATE layout SET extent_uuid = '%s' WHERE extent_uuid = '%s';",
+            new_uuids[i], old_uuids[i]);
+
+    g_string_append(request,
+                    "UPDATE extent SET state = 'orphan' WHERE extent_uuid IN (");
+    for (i = 0; i < count; ++i)
+        g_string_append_printf(request, "'%s'%s", old_uuids[i],
+                               i == count - 1 ? ");" : ", ");
+
+    g_string_append(request,
+                    "UPDATE extent SET state = 'sync' WHERE extent_uuid IN (");
+    for (i = 0; i < count; ++i)
+        g_string_append_printf(request, "'%s'%s", new_uuids[i],
+                               i == count - 1 ? ");" : ", ");
+
+    rc = execute_and_commit_or_rollback(handle->dh_conn, request, NULL,
                                         PGRES_COMMAND_OK);
+
+req_free:
     g_string_free(request, true);
     return rc;
 }
@@ -93,6 +93,13 @@ struct pho_comm_info {
     GHashTable *ev_tab; /*!< Hash table of events of the socket poll
                          *   (used by the server for cleaning).
                          */
+    bool shared_socket; /*!< The main socket belongs to another server,
+                         *   this one is a worker of it.
+                         */
+    int wakeup_fd;      /*!< Event descriptor interrupting the socket poll
+                         *   (only used by server workers and by the clients
+                         *   which enabled it).
+                         */
 };
 
 /**
@@ -112,7 +119,9 @@ static inline struct pho_comm_info pho_comm_info_init(void)
         .path = NULL,
         .socket_fd = -1,
         .epoll_fd = -1,
-        .ev_tab = NULL
+        .ev_tab = NULL,
+        .shared_socket = false,
+        .wakeup_fd = -1
     };
 
     return info;
@@ -220,6 +229,47 @@ int tlc_lib_device_from_cfg(const char *library,
 int pho_comm_open(struct pho_comm_info *ci, const union pho_comm_addr *addr,
                   enum pho_comm_socket_type type);
 
+/**
+ * Open a worker of a server socket.
+ *
+ * The worker has its own socket poll, in which it accepts the new clients of
+ * the listening socket of \p server and receives their messages. Several
+ * workers of the same server may be polled concurrently by different threads:
+ * each new client is accepted by only one of them, which is then the only one
+ * to receive its messages.
+ *
+ * The worker must be closed with pho_comm_close() before the server.
+ *
+ * \param[out]      worker      Communication info to be initialized.
+ * \param[in]       server      Opened server communication info.
+ *
+ * \return                      0 on success, negative POSIX error on failure
+ */
+int pho_comm_open_worker(struct pho_comm_info *worker,
+                         const struct pho_comm_info *server);
+
+/**
+ * Allow other threads to interrupt pho_comm_wait() on a client socket with
+ * pho_comm_wakeup().
+ *
+ * \param[in]       ci          Opened communication info of a client socket.
+ *
+ * \return                      0 on success, -errno on failure.
+ */
+int pho_comm_wakeup_enable(struct pho_comm_info *ci);
+
+/**
+ * Interrupt the current or next pho_comm_recv() call on a server worker,
+ * which then returns without any message if none is available, or the
+ * current or next pho_comm_wait() call on a client whose wakeups are enabled.
+ *
+ * \param[in]       ci          Communication info of a server worker or of a
+ *                              client.
+ *
+ * \return                      0 on success, -errno on failure.
+ */
+int pho_comm_wakeup(struct pho_comm_info *ci);
+
 /**
  * Closer for the unix socket.
  *
@@ -259,4 +309,23 @@ int pho_comm_send(const struct pho_comm_data *data);
 int pho_comm_recv(struct pho_comm_info *ci, struct pho_comm_data **data,
                   int *nb_data);
 
+/**
+ * Wait for a message to be available on a client socket.
+ *
+ * This allows a client to sleep on its socket until the server answers, with
+ * an upper bound on the waiting time, instead of blocking indefinitely in
+ * pho_comm_recv() or polling it periodically.
+ *
+ * \param[in]       ci          Communication info of a client socket.
+ * \param[in]       timeout_ms  Maximum time to wait in milliseconds,
+ *                              -1 to wait indefinitely.
+ *
+ * \return                      0 if a message can be received,
+ *                              -ETIMEDOUT if the timeout expired,
+ *                              -EINTR if interrupted by pho_comm_wakeup()
+ *                              before a message is available,
+ *                              -errno on failure.
+ */
+int pho_comm_wait(struct pho_comm_info *ci, int timeout_ms);
+
 #endif
@@ -421,6 +421,16 @@ char *rstrip(char *msg);
  */
 int64_t str2int64(const char *str);
 
+/**
+ * Get the tape block where LTFS wrote a file, from its "user.ltfs.startblock"
+ * extended attribute.
+ *
+ * @param[in]   path    Path of the file in a mounted LTFS.
+ *
+ * @return the start block on success, a negative error code if it is unknown.
+ */
+int64_t ltfs_start_block(const char *path);
+
 /**
  * Converts an unsigned char * to a string hex-encoded.
  *
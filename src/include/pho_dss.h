@@ -178,6 +178,7 @@ static struct dss_field_def dss_fields_names[] = {
     {"DSS::EXT::address", "address"},
     {"DSS::EXT::md5", "hash->>'md5'"},
     {"DSS::EXT::xxh128", "hash->>'xxh128'"},
+    {"DSS::EXT::crc32c", "hash->>'crc32c'"},
     {"DSS::EXT::info", "info"},
     /* Media related fields */
     {"DSS::MDA::family", "family"},
@@ -300,6 +301,7 @@ void dss_filter_free(struct dss_filter *filter);
 /* Exposed externally for python bindings generation */
 struct dss_handle {
     void  *dh_conn;
+    void  *dh_prepared;     /**< Names of the statements prepared on dh_conn */
 };
 
 /**
@@ -315,6 +317,64 @@ int dss_init(struct dss_handle *handle);
  */
 void dss_fini(struct dss_handle *handle);
 
+/** Channel on which the changes of the objects and layouts are notified */
+#define DSS_OBJECT_CHANGE_CHANNEL "phobos_object_change"
+
+/**
+ * Database setting enabling the notifications of DSS_OBJECT_CHANGE_CHANNEL,
+ * off by default so that the writers do not pay for them:
+ * ALTER DATABASE <dbname> SET phobos.notify_object_changes = on;
+ */
+#define DSS_OBJECT_CHANGE_SETTING "phobos.notify_object_changes"
+
+/**
+ * Callback called for each notification received on a DSS connection.
+ *
+ * @param[in]  channel  Channel of the notification.
+ * @param[in]  payload  Payload of the notification, may be empty.
+ * @param[in]  udata    User data given to dss_notifications_consume.
+ */
+typedef void (*dss_notification_cb_t)(const char *channel,
+                                      const char *payload, void *udata);
+
+/**
+ * Listen to the notifications sent on \p channel, on the connection of
+ * \p handle. The handle should be dedicated to listening, as notifications
+ * are only received between requests.
+ *
+ * @param[in]  handle   Connection handle.
+ * @param[in]  channel  Channel to listen to.
+ *
+ * @return 0 on success, negated errno code on failure.
+ */
+int dss_listen(struct dss_handle *handle, const char *channel);
+
+/**
+ * Check whether the changes of the objects and layouts are notified on
+ * DSS_OBJECT_CHANGE_CHANNEL to the sessions opened with the settings of
+ * \p handle.
+ *
+ * @param[in]  handle     Connection handle.
+ * @param[out] notified   True if DSS_OBJECT_CHANGE_SETTING is on.
+ *
+ * @return 0 on success, negated errno code on failure.
+ */
+int dss_object_changes_notified(struct dss_handle *handle, bool *notified);
+
+/**
+ * Read the notifications received so far on the connection of \p handle,
+ * without blocking, and call \p cb for each of them.
+ *
+ * @param[in]  handle   Connection handle.
+ * @param[in]  cb       Callback called for each notification.
+ * @param[in]  udata    Argument passed to \p cb.
+ *
+ * @return 0 on success, -ENOTCONN if the connection is lost, in which case
+ *         notifications may have been missed.
+ */
+int dss_notifications_consume(struct dss_handle *handle,
+                              dss_notification_cb_t cb, void *udata);
+
 /**
  *  Generic function: frees item_list that was allocated in dss_xxx_get()
  *  @param[in]  item_list   list of items to free
@@ -419,6 +479,43 @@ int dss_media_get(struct dss_handle *handle, const struct dss_filter *filter,
                   struct media_info **media_list, int *media_count,
                   struct dss_sort *sort);
 
+/**
+ * Retrieve the information of one medium from DSS, with a statement prepared
+ * once per handle.
+ *
+ * @param[in]  handle       valid connection handle
+ * @param[in]  medium_id    family, name and library of the medium
+ * @param[out] media_list   list of retrieved items to be freed
+ *                          w/ dss_res_free()
+ * @param[out] media_count  number of items retrieved in the list (0 or 1)
+ *
+ * @return 0 on success, negated errno on failure
+ */
+mockable
+int dss_media_get_from_id(struct dss_handle *handle,
+                          const struct pho_id *medium_id,
+                          struct media_info **media_list, int *media_count);
+
+/**
+ * Retrieve the information of several media from DSS, their lock included,
+ * in a single query.
+ *
+ * The media absent from the media table are not returned, and the order of
+ * the returned media is unspecified.
+ *
+ * @param[in]  handle       valid connection handle
+ * @param[in]  medium_ids   family, name and library of the media
+ * @param[in]  count        number of media in \p medium_ids
+ * @param[out] media_list   list of retrieved items to be freed
+ *                          w/ dss_res_free()
+ * @param[out] media_count  number of items retrieved in the list
+ *
+ * @return 0 on success, negated errno on failure
+ */
+int dss_media_get_from_ids(struct dss_handle *handle,
+                           const struct pho_id *medium_ids, int count,
+                           struct media_info **media_list, int *media_count);
+
 /**
  * Delete information for one or many media in DSS.
  *
@@ -495,6 +592,19 @@ int dss_layout_insert(struct dss_handle *handle,
                       struct layout_info *layout_list,
                       int layout_count);
 
+/**
+ * Store the extents and layouts of one or many objects, and mark these objects
+ * as complete, in a single transaction: either all of them are saved or none.
+ *
+ * @param[in]  handle        valid connection handle
+ * @param[in]  layouts       layouts to store, with their extents
+ * @param[in]  layout_count  number of items in the list
+ *
+ * @return 0 on success, negated errno on failure
+ */
+int dss_layouts_save(struct dss_handle *handle, struct layout_info *layouts,
+                     int layout_count);
+
 /**
  * Retrieve layout information from DSS.
  *
@@ -538,6 +648,23 @@ int dss_full_layout_get(struct dss_handle *hdl, const struct dss_filter *object,
                         struct layout_info **layouts, int *layout_count,
                         struct dss_sort *sort);
 
+/**
+ * Retrieve the layout + extents information of one object version from DSS,
+ * with a statement prepared once per handle.
+ *
+ * @param[in]  hdl           valid connection handle
+ * @param[in]  uuid          uuid of the object
+ * @param[in]  version       version of the object
+ * @param[out] layouts       list of retrieved items to be freed with
+ *                           dss_res_free()
+ * @param[out] layout_count  number of items retrieved in the list (0 or 1)
+ *
+ * @return 0 on success, negated errno on failure
+ */
+int dss_full_layout_get_from_uuid(struct dss_handle *hdl, const char *uuid,
+                                  int version, struct layout_info **layouts,
+                                  int *layout_count);
+
 /**
  * Store information for one or many objects in DSS.
  *
@@ -919,6 +1046,60 @@ void emit_log_after_action(struct dss_handle *dss,
                            struct pho_log *log,
                            enum operation_type action,
                            int rc);
+/**
+ * Asynchronous DSS writer.
+ *
+ * The independent updates handed over to the writer, such as logs or media
+ * statistics, are written by a dedicated thread on its own connection, so
+ * that the caller does not wait for the database. The updates queued while a
+ * batch is written are written together in the next one.
+ */
+struct dss_async;
+
+/**
+ * Start an asynchronous writer.
+ *
+ * \param[out] async  The writer, to be stopped with dss_async_fini
+ *
+ * \return 0 on success, -errno on failure
+ */
+int dss_async_init(struct dss_async **async);
+
+/**
+ * Write all the updates queued and stop the writer.
+ *
+ * \param[in] async   The writer to stop, may be NULL
+ */
+void dss_async_fini(struct dss_async *async);
+
+/**
+ * Asynchronous version of emit_log_after_action. The writer takes ownership
+ * of the log message.
+ */
+void dss_async_emit_log(struct dss_async *async, struct pho_log *log,
+                        enum operation_type action, int rc);
+
+/**
+ * Queue the update of \p fields of \p medium, as dss_media_update would do
+ * it. \p medium is copied, and replaces the values of an update of the same
+ * fields of this medium that is not written yet.
+ *
+ * Errors are reported in the daemon logs.
+ */
+void dss_async_media_update(struct dss_async *async,
+                            const struct media_info *medium, uint64_t fields);
+
+/**
+ * Drop the queued updates of the medium \p id, and wait for the one being
+ * written, if any. To be called before writing newer values synchronously.
+ */
+void dss_async_media_cancel(struct dss_async *async, const struct pho_id *id);
+
+/**
+ * Wait for all the updates queued before this call to be written.
+ */
+void dss_async_flush(struct dss_async *async);
+
 /**
  * Create a valid dss_filter based on the criteria given in \p log_filter.
  *
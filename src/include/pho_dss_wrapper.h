@@ -112,6 +112,130 @@ int dss_one_medium_get_from_id(struct dss_handle *dss,
 int dss_medium_locate(struct dss_handle *dss, const struct pho_id *medium_id,
                       char **hostname, struct media_info **medium_info);
 
+/** Location of one medium, filled by dss_media_locate */
+struct dss_medium_location {
+    struct pho_id id;               /**< Medium to locate */
+    int rc;                         /**< Result of the locate of this medium,
+                                      *  with the codes of dss_medium_locate
+                                      */
+    char *hostname;                 /**< Host holding the lock of the medium,
+                                      *  NULL if it is not locked
+                                      */
+    struct media_info *medium;      /**< Medium information, may be NULL if
+                                      *  rc is not 0
+                                      */
+};
+
+/**
+ * Locate several media at once
+ *
+ * This is the bulk version of dss_medium_locate: the media and their lock are
+ * retrieved with one query per batch of 512 media, instead of two queries per
+ * medium. The result of each locate is set in the rc field of its location.
+ *
+ * @param[in]      dss         DSS to request
+ * @param[in, out] locations   Media to locate, their id must be set, the
+ *                             other fields are overwritten. They must be
+ *                             released by dss_medium_location_fini.
+ * @param[in]      count       Number of locations
+ *
+ * @return 0 if success, -errno if the media could not be retrieved, the rc
+ *         of the locations not retrieved is then set to this error
+ */
+int dss_media_locate(struct dss_handle *dss,
+                     struct dss_medium_location *locations, size_t count);
+
+/**
+ * Release the hostname and medium of a location
+ *
+ * @param[in, out] location    Location to release
+ */
+void dss_medium_location_fini(struct dss_medium_location *location);
+
+/**
+ * Media locations and usable devices shared by the locate of several layouts
+ *
+ * The locate of a batch of objects loads the media of all their extents at
+ * once with dss_locate_cache_load. The locks taken by each locate are then
+ * recorded with dss_locate_cache_set_host, so that the next ones see them
+ * without querying the DSS again.
+ */
+struct dss_locate_cache {
+    GHashTable *media;                      /**< pho_id -> struct
+                                              *  dss_medium_location
+                                              */
+    struct dev_info *devices[PHO_RSC_LAST]; /**< Usable devices per family,
+                                              *  loaded on first use
+                                              */
+    int n_devices[PHO_RSC_LAST];
+    bool devices_loaded[PHO_RSC_LAST];
+};
+
+void dss_locate_cache_init(struct dss_locate_cache *cache);
+
+void dss_locate_cache_fini(struct dss_locate_cache *cache);
+
+/**
+ * Locate the media of \p medium_ids that are not cached yet, with
+ * dss_media_locate
+ *
+ * @param[in]      dss         DSS to request
+ * @param[in, out] cache       Cache to fill
+ * @param[in]      medium_ids  Media to locate, may contain duplicates
+ * @param[in]      count       Number of media in \p medium_ids
+ *
+ * @return 0 if success, -errno if the media could not be retrieved
+ */
+int dss_locate_cache_load(struct dss_handle *dss,
+                          struct dss_locate_cache *cache,
+                          const struct pho_id *medium_ids, size_t count);
+
+/**
+ * Locate a medium from the cache, loading it if it is not cached yet
+ *
+ * @param[in]      dss          DSS to request
+ * @param[in, out] cache        Cache to look up
+ * @param[in]      medium_id    Medium to locate
+ * @param[out]     hostname     Allocated and returned hostname or NULL if the
+ *                              medium is not locked by anyone
+ * @param[out]     medium_info  Allocated and returned medium information
+ *
+ * @return the same codes as dss_medium_locate, hostname and medium_info are
+ *         only set on success
+ */
+int dss_locate_cache_medium(struct dss_handle *dss,
+                            struct dss_locate_cache *cache,
+                            const struct pho_id *medium_id, char **hostname,
+                            struct media_info **medium_info);
+
+/**
+ * Get the usable devices of a family from the cache, with
+ * dss_get_usable_devices on first use
+ *
+ * @param[in]      dss      DSS to request
+ * @param[in, out] cache    Cache to look up
+ * @param[in]      family   Family of the devices
+ * @param[out]     devices  Devices, owned by the cache
+ * @param[out]     count    Number of devices
+ *
+ * @return 0 on success, negated errno on failure
+ */
+int dss_locate_cache_devices(struct dss_handle *dss,
+                             struct dss_locate_cache *cache,
+                             enum rsc_family family, struct dev_info **devices,
+                             int *count);
+
+/**
+ * Record the new lock holder of a cached medium
+ *
+ * @param[in, out] cache        Cache to update
+ * @param[in]      medium_id    Medium whose lock changed
+ * @param[in]      hostname     New holder of the lock, NULL if unlocked
+ */
+void dss_locate_cache_set_host(struct dss_locate_cache *cache,
+                               const struct pho_id *medium_id,
+                               const char *hostname);
+
 /**
  * Return the health of a medium
  *
@@ -202,6 +326,21 @@ int dss_move_deprecated_to_object(struct dss_handle *handle,
 int dss_update_extent_migrate(struct dss_handle *handle, const char *old_uuid,
                               const char *new_uuid);
 
+/**
+ * Same as dss_update_extent_migrate for \p count extents, in one transaction.
+ *
+ * @param[in]   handle          DSS handle
+ * @param[in]   old_uuids       Old extent UUIDs
+ * @param[in]   new_uuids       New extent UUIDs, new_uuids[i] replaces
+ *                              old_uuids[i]
+ * @param[in]   count           Number of extents to migrate
+ *
+ * @return 0 on success, -errno on failure
+ */
+int dss_update_extents_migrate(struct dss_handle *handle,
+                               const char **old_uuids, const char **new_uuids,
+                               int count);
+
 /**
  * Update state of given extents
  *
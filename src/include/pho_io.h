@@ -39,9 +39,17 @@
 #define PHO_EA_UMD_NAME             "user_md"
 #define PHO_EA_MD5_NAME             "md5"
 #define PHO_EA_XXH128_NAME          "xxh128"
+#define PHO_EA_CRC32C_NAME          "crc32c"
 #define PHO_EA_LAYOUT_NAME          "layout"
 #define PHO_EA_EXTENT_OFFSET_NAME   "extent_offset"
 
+/**
+ * Extent info entry holding the position of the extent on its medium, set by
+ * the I/O adapters able to know it (e.g. the first tape block of the extent
+ * for LTFS). Used to read the extents of a medium in their on-medium order.
+ */
+#define PHO_EXT_INFO_POSITION_NAME  "medium_position"
+
 #define PHO_ATTR_BACKUP_JSON_FLAGS (JSON_COMPACT | JSON_SORT_KEYS)
 
 /* FIXME: only 2 combinations are used: REPLACE | NO_REUSE and DELETE */
@@ -99,6 +107,8 @@ struct pho_io_adapter_module_ops {
     int (*ioa_open)(const char *extent_desc, struct pho_io_descr *iod,
                     bool is_put);
     int (*ioa_write)(struct pho_io_descr *iod, const void *buf, size_t count);
+    int (*ioa_write_from_fd)(struct pho_io_descr *iod, int src_fd,
+                             off_t src_offset, size_t count);
     ssize_t (*ioa_read)(struct pho_io_descr *iod, void *buf, size_t count);
     int (*ioa_close)(struct pho_io_descr *iod);
     int (*ioa_medium_sync)(const char *root_path, json_t **message);
@@ -121,6 +131,15 @@ struct io_adapter_module {
  */
 int get_io_adapter(enum fs_type fstype, struct io_adapter_module **ioa);
 
+/**
+ * Retrieve IO functions for the given filesystem type, as configured for the
+ * media of \p family: the data of POSIX file systems can be accessed with the
+ * "posix" (default) or "uring" adapter ("io_adapter" parameter of the "io"
+ * section).
+ */
+int get_io_adapter_for_family(enum fs_type fstype, enum rsc_family family,
+                              struct io_adapter_module **ioa);
+
 /**
  * Get an object from a media.
  * All I/O adapters must implement this call.
@@ -285,6 +304,41 @@ static inline int ioa_write(const struct io_adapter_module *ioa,
     return ioa->ops->ioa_write(iod, buf, count);
 }
 
+/**
+ * Whether the I/O adapter implements ioa_write_from_fd.
+ */
+static inline bool ioa_can_write_from_fd(const struct io_adapter_module *ioa)
+{
+    assert(ioa != NULL);
+    assert(ioa->ops != NULL);
+    return ioa->ops->ioa_write_from_fd != NULL;
+}
+
+/**
+ * Same as ioa_write, but the data is copied from the regular file \p src_fd
+ * without going through a user space buffer (copy_file_range(2),
+ * sendfile(2)...). The file offset of \p src_fd is not modified.
+ * This call is optional.
+ *
+ * \param[in]       ioa         Suitable I/O adapter for the media
+ * \param[in,out]   iod         I/O descriptor (see ioa_write)
+ * \param[in]       src_fd      Regular file to copy the data from
+ * \param[in]       src_offset  Offset of the data in \p src_fd
+ * \param[in]       count       Size in byte of data to copy
+ *
+ * \return 0 on success, -ENOTSUP if the I/O adapter does not support this
+ *         call, negative error code on failure
+ */
+static inline int ioa_write_from_fd(const struct io_adapter_module *ioa,
+                                    struct pho_io_descr *iod, int src_fd,
+                                    off_t src_offset, size_t count)
+{
+    if (!ioa_can_write_from_fd(ioa))
+        return -ENOTSUP;
+
+    return ioa->ops->ioa_write_from_fd(iod, src_fd, src_offset, count);
+}
+
 /**
  * Read data from the IO adapter private context to the output buffer.
  * All I/O adapters must implement this call for the extent copy/migration.
@@ -31,6 +31,7 @@
 
 #include "phobos_store.h"
 #include "pho_dss.h"
+#include "pho_dss_wrapper.h"
 #include "pho_srl_lrs.h"
 #include "pho_io.h"
 
@@ -63,8 +64,9 @@ struct pho_layout_module_ops {
     int (*delete)(struct pho_encoder *dec);
 
     /** Retrieve one node name from which an object can be accessed */
-    int (*locate)(struct dss_handle *dss, struct layout_info *layout,
-                  const char *focus_host, char **hostname, int *nb_new_lock);
+    int (*locate)(struct dss_handle *dss, struct dss_locate_cache *cache,
+                  struct layout_info *layout, const char *focus_host,
+                  char **hostname, int *nb_new_lock);
 
     /** Updates the information of the layout, object and extent based on the
      * medium's extent and the layout used.
@@ -252,6 +254,9 @@ int layout_delete(struct pho_encoder *dec, struct pho_xfer_desc *xfer,
  * Retrieve one node name from which an object can be accessed.
  *
  * @param[in]   dss         DSS handle
+ * @param[in]   cache       Media and devices already located, shared with the
+ *                          locate of other layouts (NULL to locate this
+ *                          layout alone)
  * @param[in]   layout      Layout of the object to locate
  * @param[in]   focus_host  Hostname on which the caller would like to access
  *                          the object if there is no more convenient node (if
@@ -271,8 +276,9 @@ int layout_delete(struct pho_encoder *dec, struct pho_xfer_desc *xfer,
  *                          retrieve this layout
  *                          -EADDRNOTAVAIL if we cannot get self hostname
  */
-int layout_locate(struct dss_handle *dss, struct layout_info *layout,
-                  const char *focus_host, char **hostname, int *nb_new_lock);
+int layout_locate(struct dss_handle *dss, struct dss_locate_cache *cache,
+                  struct layout_info *layout, const char *focus_host,
+                  char **hostname, int *nb_new_lock);
 
 /**
  * Advance the layout operation of one step by providing a response from the LRS
@@ -175,6 +175,12 @@ struct saj_parser;
  */
 void layout_info_free_extents(struct layout_info *layout);
 
+/** duplicate a layout_info structure with its extents, cannot return NULL */
+struct layout_info *layout_info_dup(const struct layout_info *layout);
+
+/** free a layout_info structure returned by layout_info_dup */
+void layout_info_free(struct layout_info *layout);
+
 /** @} end of pho_layout_mod group */
 
 
@@ -291,6 +297,19 @@ int saj_parser_run(struct saj_parser *parser, json_t *root);
  */
 int tsqueue_init(struct tsqueue *tsqueue);
 
+/**
+ * Set the function called when an element is pushed to a queue whose elements
+ * were all popped, so that the consumer can wait for the queue to be filled.
+ *
+ * Must be called before the queue is shared with the producers.
+ *
+ * @param[in,out]   tsq         Threadsafe queue.
+ * @param[in]       notify      Function to call, NULL for none.
+ * @param[in]       arg         Argument of \p notify.
+ */
+void tsqueue_set_notify(struct tsqueue *tsq, void (*notify)(void *arg),
+                        void *arg);
+
 /**
  * Threadsafe queue destructor.
  * @param[in,out]   tsq         Threadsafe queue.
@@ -300,9 +319,13 @@ void tsqueue_destroy(struct tsqueue *tsq, GDestroyNotify free_func);
 
 /**
  * Pop element from threadsafe queue.
+ *
+ * A queue has a single consumer: this function must always be called by the
+ * same thread, or under a lock of the caller.
+ *
  * @param[in,out]   tsq     Threadsafe queue.
  *
- * @return          Element popped.
+ * @return          Element popped, NULL if the queue is empty.
  */
 void *tsqueue_pop(struct tsqueue *tsq);
 
@@ -321,4 +344,11 @@ void tsqueue_push(struct tsqueue *tsq, void *data);
  */
 unsigned int tsqueue_get_length(struct tsqueue *tsq);
 
+/**
+ * Log the counters of a threadsafe queue at verbose level.
+ * @param[in]   tsq     Threadsafe queue
+ * @param[in]   name    Name of the queue in the log
+ */
+void tsqueue_log_stats(struct tsqueue *tsq, const char *name);
+
 #endif
@@ -34,6 +34,7 @@
 #include <errno.h>
 #include <glib.h>
 #include <limits.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
@@ -382,6 +383,8 @@ struct pho_resource {
 #define PHO_HASH_MD5_KEY_NAME    "md5"
 #define XXH128_BYTE_LENGTH 16
 #define PHO_HASH_XXH128_KEY_NAME "xxh128"
+#define CRC32C_BYTE_LENGTH 4
+#define PHO_HASH_CRC32C_KEY_NAME "crc32c"
 
 struct extent {
     char               *uuid;       /**< extent UUID */
@@ -398,6 +401,10 @@ struct extent {
     bool                with_md5;   /**< true if extent md5 field is set */
     unsigned char       md5[MD5_BYTE_LENGTH];
                                     /**< MD5 checksum */
+    bool                with_crc32c;
+                                    /**< true if extent crc32c field is set */
+    unsigned char       crc32c[CRC32C_BYTE_LENGTH];
+                                    /**< CRC32C checksum, big endian */
     /** Extra attributes specific to the layout which wrote the extent */
     struct pho_attrs    info;
 };
@@ -601,16 +608,41 @@ static inline bool pho_configure_op_is_valid(enum configure_op op)
     return op > PHO_CONF_OP_INVAL && op < PHO_CONF_OP_LAST;
 }
 
+struct tsqueue_node {
+    void                                 *data;
+    struct tsqueue_node * _Atomic         next;
+};
+
 /**
- * Threadsafe FIFO queue, composed of a GLIB queue and a mutex.
+ * Threadsafe FIFO queue, with any number of producers and a single consumer.
+ *
+ * The elements are kept in a linked list: producers atomically swap the head
+ * of the list and then link the previous head to their element, the consumer
+ * pops the elements from the tail without any lock.
  *
  * Functions that interact with this structure are available in
  * pho_type_utils.h.
  *
  */
 struct tsqueue {
-    GQueue             *queue;          /**< Object queue */
-    pthread_mutex_t     mutex;          /**< Mutex to protect the queue */
+    struct tsqueue_node * _Atomic  head;    /**< Last pushed element */
+    struct tsqueue_node * _Atomic  tail;    /**< Node of the last popped
+                                              *  element, only modified by the
+                                              *  consumer
+                                              */
+    atomic_uint                    length;  /**< Elements pushed and not
+                                              *  popped yet
+                                              */
+    void                         (*notify)(void *arg);
+                                            /**< Called when an element is
+                                              *  pushed to the empty queue
+                                              */
+    void                          *notify_arg;
+    atomic_ulong                   n_pushed;
+                                            /**< Elements pushed */
+    atomic_ulong                   n_waits; /**< Pops that waited for a
+                                              *  producer to link its element
+                                              */
 };
 
 #endif
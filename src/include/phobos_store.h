@@ -339,6 +339,56 @@ int phobos_undelete(struct pho_xfer_desc *xfers, size_t num_xfers);
 int phobos_locate(const char *obj_id, const char *uuid, int version,
                   const char *focus_host, char **hostname, int *nb_new_lock);
 
+/** One object to locate with phobos_locate_bulk */
+struct pho_locate_target {
+    /* Inputs */
+    const char *oid;                /**< OID of the object (may be NULL if
+                                      *  uuid is not)
+                                      */
+    const char *uuid;               /**< UUID of the object (may be NULL if
+                                      *  oid is not)
+                                      */
+    int version;                    /**< Version of the object (0 for the
+                                      *  latest one)
+                                      */
+
+    /* Outputs */
+    char *hostname;                 /**< Allocated hostname of the most
+                                      *  convenient node, NULL on error
+                                      */
+    int nb_new_lock;                /**< Number of new locks on media added
+                                      *  for this hostname
+                                      */
+    int rc;                         /**< Result of the locate, with the codes
+                                      *  of phobos_locate
+                                      */
+};
+
+/**
+ * Retrieve the most convenient node of several objects.
+ *
+ * This is the bulk version of phobos_locate: the objects are located one
+ * after the other, as many calls to phobos_locate would, but the media of all
+ * their extents and the devices that may read them are retrieved from the DSS
+ * once for the whole batch. The locks taken for an object are taken into
+ * account to locate the next ones.
+ *
+ * @param[in, out] targets     Objects to locate, the result of each locate is
+ *                             set in its rc field
+ * @param[in]      n           Number of objects to locate
+ * @param[in]      focus_host  Hostname on which the caller would like to
+ *                             access the objects if there is no node more
+ *                             convenient (if NULL, focus_host is set to local
+ *                             hostname)
+ *
+ * @return                     0 if every object was located, the first error
+ *                             of the targets otherwise
+ *
+ * This must be called after phobos_init.
+ */
+int phobos_locate_bulk(struct pho_locate_target *targets, size_t n,
+                       const char *focus_host);
+
 /**
  * Rename an object in the object store.
  *
@@ -27,6 +27,9 @@
 #include "pho_module_loader.h"
 
 #include <attr/xattr.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
 #include <sys/types.h>
 
 #define PLUGIN_NAME     "ltfs"
@@ -65,6 +68,49 @@ static int pho_ltfs_sync(const char *root_path, json_t **message)
     return 0;
 }
 
+/**
+ * Record in the extent info the tape block where LTFS wrote the extent, so
+ * that the LRS can serve the reads of a tape in their on-tape order.
+ *
+ * This is only a hint: failing to get it does not fail the I/O.
+ */
+static void ltfs_record_position(const char *fpath, struct extent *extent)
+{
+    char value[32];
+    int64_t block;
+
+    block = ltfs_start_block(fpath);
+    if (block < 0) {
+        pho_debug("Cannot get the start block of '%s': %s", fpath,
+                  strerror(-block));
+        return;
+    }
+
+    snprintf(value, sizeof(value), "%"PRId64, block);
+    pho_attr_set(&extent->info, PHO_EXT_INFO_POSITION_NAME, value);
+}
+
+static int pho_ltfs_close(struct pho_io_descr *iod)
+{
+    struct posix_io_ctx *io_ctx = iod->iod_ctx;
+    char *written_path = NULL;
+    int rc;
+
+    /* the file has a position on tape only once LTFS closed it */
+    if (io_ctx && io_ctx->fpath && io_ctx->fd >= 0 && iod->iod_loc &&
+        iod->iod_loc->extent &&
+        (fcntl(io_ctx->fd, F_GETFL) & O_ACCMODE) != O_RDONLY)
+        written_path = xstrdup(io_ctx->fpath);
+
+    rc = pho_posix_close(iod);
+    if (!rc && written_path)
+        ltfs_record_position(written_path, iod->iod_loc->extent);
+
+    free(written_path);
+
+    return rc;
+}
+
 /** LTFS adapter */
 static const struct pho_io_adapter_module_ops IO_ADAPTER_LTFS_OPS = {
     .ioa_get               = pho_posix_get,
@@ -72,7 +118,7 @@ static const struct pho_io_adapter_module_ops IO_ADAPTER_LTFS_OPS = {
     .ioa_open              = pho_posix_open,
     .ioa_write             = pho_posix_write,
     .ioa_read              = pho_posix_read,
-    .ioa_close             = pho_posix_close,
+    .ioa_close             = pho_ltfs_close,
     .ioa_medium_sync       = pho_ltfs_sync,
     .ioa_preferred_io_size = pho_posix_preferred_io_size,
     .ioa_set_md            = pho_posix_set_md,
@@ -45,29 +45,6 @@ static struct module_desc IO_ADAPTER_POSIX_MODULE_DESC = {
     .mod_minor = PLUGIN_MINOR,
 };
 
-static int pho_posix_medium_sync(const char *root_path, json_t **message)
-{
-    int rc = 0;
-    int fd;
-
-    ENTRY;
-
-    if (message)
-        *message = NULL;
-
-    fd = open(root_path, O_RDONLY);
-    if (fd == -1)
-        return -errno;
-
-    if (syncfs(fd))
-        rc = -errno;
-
-    if (close(fd) && !rc)
-        return -errno;
-
-    return rc;
-}
-
 /** POSIX adapter */
 static const struct pho_io_adapter_module_ops IO_ADAPTER_POSIX_OPS = {
     .ioa_get               = pho_posix_get,
@@ -75,6 +52,7 @@ static const struct pho_io_adapter_module_ops IO_ADAPTER_POSIX_OPS = {
     .ioa_open              = pho_posix_open,
     .iod_from_fd           = pho_posix_iod_from_fd,
     .ioa_write             = pho_posix_write,
+    .ioa_write_from_fd     = pho_posix_write_from_fd,
     .ioa_read              = pho_posix_read,
     .ioa_close             = pho_posix_close,
     .ioa_medium_sync       = pho_posix_medium_sync,
@@ -57,6 +57,7 @@ static struct posix_io_ctx *alloc_posix_io_ctx(void)
     io_ctx = xmalloc(sizeof(struct posix_io_ctx));
     io_ctx->fd = -1;
     io_ctx->fpath = NULL;
+    io_ctx->priv = NULL;
 
     return io_ctx;
 }
@@ -768,6 +769,57 @@ int pho_posix_write(struct pho_io_descr *iod, const void *buf, size_t count)
     return rc;
 }
 
+int pho_posix_write_from_fd(struct pho_io_descr *iod, int src_fd,
+                            off_t src_offset, size_t count)
+{
+    struct posix_io_ctx *io_ctx = iod->iod_ctx;
+    bool use_sendfile = false;
+    size_t written_size = 0;
+    int nb_null_try = 0;
+
+    ENTRY;
+
+    while (written_size < count) {
+        ssize_t nb_written_bytes;
+
+        /* copy_file_range may even share the blocks of the source if both
+         * files are on the same file system. It is not supported by all the
+         * file systems nor across file systems, sendfile is.
+         */
+        if (!use_sendfile) {
+            nb_written_bytes = copy_file_range(src_fd, &src_offset,
+                                               io_ctx->fd, NULL,
+                                               count - written_size, 0);
+            if (nb_written_bytes < 0 &&
+                (errno == EXDEV || errno == EINVAL || errno == ENOSYS ||
+                 errno == EOPNOTSUPP)) {
+                pho_debug("copy_file_range into '%s' failed (%s), using "
+                          "sendfile", io_ctx->fpath, strerror(errno));
+                use_sendfile = true;
+                continue;
+            }
+        } else {
+            nb_written_bytes = sendfile(io_ctx->fd, src_fd, &src_offset,
+                                        count - written_size);
+        }
+
+        if (nb_written_bytes < 0)
+            LOG_RETURN(-errno, "Failed to copy into %s", io_ctx->fpath);
+
+        if (nb_written_bytes == 0) {
+            nb_null_try++;
+            if (nb_null_try > MAX_NULL_WRITE_TRY)
+                LOG_RETURN(-ENOBUFS, "Reached the end of the source after "
+                           "copying %zu of %zu bytes into '%s'",
+                           written_size, count, io_ctx->fpath);
+        }
+
+        written_size += nb_written_bytes;
+    }
+
+    return 0;
+}
+
 ssize_t pho_posix_read(struct pho_io_descr *iod, void *buf, size_t count)
 {
     struct posix_io_ctx *io_ctx;
@@ -830,6 +882,29 @@ int pho_posix_close(struct pho_io_descr *iod)
     return rc;
 }
 
+int pho_posix_medium_sync(const char *root_path, json_t **message)
+{
+    int rc = 0;
+    int fd;
+
+    ENTRY;
+
+    if (message)
+        *message = NULL;
+
+    fd = open(root_path, O_RDONLY);
+    if (fd == -1)
+        return -errno;
+
+    if (syncfs(fd))
+        rc = -errno;
+
+    if (close(fd) && !rc)
+        return -errno;
+
+    return rc;
+}
+
 ssize_t pho_posix_preferred_io_size(struct pho_io_descr *iod)
 {
     struct posix_io_ctx *io_ctx;
@@ -896,6 +971,7 @@ int pho_get_common_xattrs_from_extent(struct pho_io_descr *iod,
     pho_attr_set(&md, PHO_EA_UMD_NAME, NULL);
     pho_attr_set(&md, PHO_EA_MD5_NAME, NULL);
     pho_attr_set(&md, PHO_EA_XXH128_NAME, NULL);
+    pho_attr_set(&md, PHO_EA_CRC32C_NAME, NULL);
     pho_attr_set(&md, PHO_EA_EXTENT_OFFSET_NAME, NULL);
 
     rc = pho_posix_md_get(NULL, iod->iod_fd, &md);
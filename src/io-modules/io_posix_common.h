@@ -31,6 +31,9 @@
 struct posix_io_ctx {
     char *fpath;
     int fd;
+    void *priv;     /**< Private data of the adapters built on top of the
+                      *  POSIX functions
+                      */
 };
 
 int pho_posix_get(const char *extent_desc, struct pho_io_descr *iod);
@@ -44,12 +47,17 @@ int pho_posix_iod_from_fd(struct pho_io_descr *iod, int fd);
 
 int pho_posix_write(struct pho_io_descr *iod, const void *buf, size_t count);
 
+int pho_posix_write_from_fd(struct pho_io_descr *iod, int src_fd,
+                            off_t src_offset, size_t count);
+
 ssize_t pho_posix_read(struct pho_io_descr *iod, void *buf, size_t count);
 
 int pho_posix_close(struct pho_io_descr *iod);
 
 int pho_posix_set_md(const char *extent_desc, struct pho_io_descr *iod);
 
+int pho_posix_medium_sync(const char *root_path, json_t **message);
+
 ssize_t pho_posix_preferred_io_size(struct pho_io_descr *iod);
 
 int build_addr_path(const char *extent_key, const char *extent_desc,
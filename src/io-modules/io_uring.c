@@ -0,0 +1,546 @@
+/* -*- mode: c; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief  Phobos I/O io_uring adapter.
+ *
+ * Same as the POSIX adapter, except that the data of the extents is read and
+ * written through an io_uring, bypassing the page cache (O_DIRECT) when the
+ * file system supports it.
+ *
+ * The data is staged in aligned buffers registered in the ring. Writes are
+ * submitted as soon as a buffer is full, so that up to URING_QUEUE_DEPTH
+ * writes are in flight for each extent. Reads are done ahead in the same
+ * buffers.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "io_posix_common.h"
+#include "pho_common.h"
+#include "pho_module_loader.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <liburing.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#define PLUGIN_NAME     "uring"
+#define PLUGIN_MAJOR    0
+#define PLUGIN_MINOR    1
+
+static struct module_desc IO_ADAPTER_URING_MODULE_DESC = {
+    .mod_name  = PLUGIN_NAME,
+    .mod_major = PLUGIN_MAJOR,
+    .mod_minor = PLUGIN_MINOR,
+};
+
+/** Alignment of the buffers, offsets and sizes of the O_DIRECT I/Os */
+#define URING_ALIGN         4096
+/** Size of each staging buffer */
+#define URING_BUF_SIZE      (1024 * 1024)
+/** Number of staging buffers, i.e. of I/Os in flight for an extent */
+#define URING_QUEUE_DEPTH   4
+/** Tag of the fsync request, the other requests are tagged by buffer index */
+#define URING_FSYNC_TAG     ((__u64)-1)
+
+#define ALIGN_UP(_x, _a)    (((_x) + (_a) - 1) / (_a) * (_a))
+
+enum uring_buf_state {
+    URING_BUF_FREE,         /**< Can be filled (put) or submitted (get) */
+    URING_BUF_BUSY,         /**< I/O in flight */
+    URING_BUF_READY,        /**< Read completed, data not consumed yet */
+};
+
+struct uring_buf {
+    char *data;
+    size_t len;             /**< Put: bytes staged, get: bytes read */
+    size_t pos;             /**< Get: bytes already consumed */
+    size_t io_len;          /**< Size of the I/O in flight */
+    enum uring_buf_state state;
+};
+
+struct uring_io_ctx {
+    struct io_uring ring;
+    const char *fpath;              /**< Path of the extent, for the logs */
+    int fd;                         /**< Descriptor the I/Os are done on */
+    bool direct;                    /**< fd is an O_DIRECT descriptor */
+    bool registered;                /**< Buffers are registered in the ring */
+    bool is_put;
+    struct uring_buf bufs[URING_QUEUE_DEPTH];
+    int cur;                        /**< Buffer being filled or consumed */
+    unsigned int in_flight;         /**< Requests submitted, not completed */
+    off_t offset;                   /**< Offset of the next I/O */
+    size_t size;                    /**< Put: bytes written by the caller */
+    bool eof;                       /**< Get: end of the extent reached */
+    int rc;                         /**< First error of a completed request */
+};
+
+static void uring_prep_io(struct uring_io_ctx *ctx, int idx, size_t len)
+{
+    struct uring_buf *buf = &ctx->bufs[idx];
+    struct io_uring_sqe *sqe;
+
+    /* the ring has more entries than requests in flight */
+    sqe = io_uring_get_sqe(&ctx->ring);
+    assert(sqe);
+
+    if (ctx->is_put && ctx->registered)
+        io_uring_prep_write_fixed(sqe, ctx->fd, buf->data, len, ctx->offset,
+                                  idx);
+    else if (ctx->is_put)
+        io_uring_prep_write(sqe, ctx->fd, buf->data, len, ctx->offset);
+    else if (ctx->registered)
+        io_uring_prep_read_fixed(sqe, ctx->fd, buf->data, len, ctx->offset,
+                                 idx);
+    else
+        io_uring_prep_read(sqe, ctx->fd, buf->data, len, ctx->offset);
+
+    sqe->user_data = idx;
+    buf->io_len = len;
+    buf->state = URING_BUF_BUSY;
+    ctx->offset += len;
+    ctx->in_flight++;
+}
+
+static int uring_submit(struct uring_io_ctx *ctx)
+{
+    int rc;
+
+    rc = io_uring_submit(&ctx->ring);
+    if (rc < 0)
+        LOG_RETURN(rc, "Failed to submit I/Os on '%s'", ctx->fpath);
+
+    return 0;
+}
+
+static void uring_complete(struct uring_io_ctx *ctx, struct io_uring_cqe *cqe)
+{
+    __u64 tag = cqe->user_data;
+    int res = cqe->res;
+    struct uring_buf *buf;
+
+    io_uring_cqe_seen(&ctx->ring, cqe);
+    ctx->in_flight--;
+
+    if (tag == URING_FSYNC_TAG) {
+        if (res < 0 && !ctx->rc) {
+            ctx->rc = res;
+            pho_error(res, "Failed to sync '%s'", ctx->fpath);
+        }
+        return;
+    }
+
+    buf = &ctx->bufs[tag];
+    if (res >= 0 && ctx->is_put && (size_t)res != buf->io_len) {
+        pho_warn("Incomplete write into '%s': %d of %zu", ctx->fpath, res,
+                 buf->io_len);
+        res = -EIO;
+    }
+
+    if (res < 0 && !ctx->rc) {
+        ctx->rc = res;
+        pho_error(res, "Failed to %s '%s'", ctx->is_put ? "write into" :
+                  "read from", ctx->fpath);
+    }
+
+    if (ctx->is_put) {
+        buf->len = 0;
+        buf->state = URING_BUF_FREE;
+    } else {
+        buf->len = res < 0 ? 0 : res;
+        buf->pos = 0;
+        buf->state = URING_BUF_READY;
+    }
+}
+
+/** Wait for at least one request to complete and reap all the completed ones */
+static int uring_wait(struct uring_io_ctx *ctx)
+{
+    struct io_uring_cqe *cqe;
+    int rc;
+
+    do {
+        rc = io_uring_wait_cqe(&ctx->ring, &cqe);
+    } while (rc == -EINTR);
+    if (rc)
+        LOG_RETURN(rc, "Failed to wait for I/Os on '%s'", ctx->fpath);
+
+    uring_complete(ctx, cqe);
+    while (io_uring_peek_cqe(&ctx->ring, &cqe) == 0)
+        uring_complete(ctx, cqe);
+
+    return 0;
+}
+
+static int uring_drain(struct uring_io_ctx *ctx)
+{
+    int rc;
+
+    while (ctx->in_flight > 0) {
+        rc = uring_wait(ctx);
+        if (rc)
+            return rc;
+    }
+
+    return ctx->rc;
+}
+
+static void uring_ctx_free(struct uring_io_ctx *ctx)
+{
+    int i;
+
+    io_uring_queue_exit(&ctx->ring);
+    for (i = 0; i < URING_QUEUE_DEPTH; i++)
+        free(ctx->bufs[i].data);
+
+    if (ctx->direct)
+        close(ctx->fd);
+
+    free(ctx);
+}
+
+static int uring_ctx_init(struct posix_io_ctx *io_ctx, bool is_put,
+                          struct uring_io_ctx **uring_ctx)
+{
+    struct iovec iovs[URING_QUEUE_DEPTH];
+    struct uring_io_ctx *ctx;
+    int rc;
+    int i;
+
+    ctx = xcalloc(1, sizeof(*ctx));
+    ctx->fpath = io_ctx->fpath;
+    ctx->is_put = is_put;
+
+    /* one more entry than buffers, for the fsync request */
+    rc = io_uring_queue_init(URING_QUEUE_DEPTH + 1, &ctx->ring, 0);
+    if (rc) {
+        free(ctx);
+        return rc;
+    }
+
+    for (i = 0; i < URING_QUEUE_DEPTH; i++) {
+        void *data;
+
+        rc = posix_memalign(&data, URING_ALIGN, URING_BUF_SIZE);
+        if (rc) {
+            uring_ctx_free(ctx);
+            return -rc;
+        }
+
+        ctx->bufs[i].data = data;
+        iovs[i].iov_base = data;
+        iovs[i].iov_len = URING_BUF_SIZE;
+    }
+
+    /* Registered buffers save the mapping of the pages on each I/O, but they
+     * count against RLIMIT_MEMLOCK: do without them if the limit is too low.
+     */
+    rc = io_uring_register_buffers(&ctx->ring, iovs, URING_QUEUE_DEPTH);
+    if (rc)
+        pho_verb("Unable to register the io_uring buffers of '%s': %s",
+                 ctx->fpath, strerror(-rc));
+    else
+        ctx->registered = true;
+
+    /* The POSIX descriptor holds the metadata of the extent, the data goes
+     * through a second one opened with O_DIRECT.
+     */
+    ctx->fd = open(io_ctx->fpath, (is_put ? O_WRONLY : O_RDONLY) | O_DIRECT);
+    if (ctx->fd >= 0) {
+        ctx->direct = true;
+    } else if (errno == EINVAL) {
+        pho_verb("'%s' cannot be opened with O_DIRECT, using the page cache",
+                 io_ctx->fpath);
+        ctx->fd = io_ctx->fd;
+    } else {
+        rc = -errno;
+        uring_ctx_free(ctx);
+        LOG_RETURN(rc, "open(%s) with O_DIRECT failed", io_ctx->fpath);
+    }
+
+    *uring_ctx = ctx;
+
+    return 0;
+}
+
+static int pho_uring_open(const char *extent_desc, struct pho_io_descr *iod,
+                          bool is_put)
+{
+    struct posix_io_ctx *io_ctx;
+    struct uring_io_ctx *ctx;
+    int rc;
+
+    ENTRY;
+
+    rc = pho_posix_open(extent_desc, iod, is_put);
+    if (rc || (iod->iod_flags & PHO_IO_MD_ONLY))
+        return rc;
+
+    io_ctx = iod->iod_ctx;
+
+    /* io_uring may be disabled on this host (kernel.io_uring_disabled,
+     * seccomp...): the extent is then accessed as with the POSIX adapter.
+     */
+    rc = uring_ctx_init(io_ctx, is_put, &ctx);
+    if (rc) {
+        pho_warn("Unable to use io_uring for '%s', falling back to POSIX "
+                 "I/Os: %s", io_ctx->fpath, strerror(-rc));
+        return 0;
+    }
+
+    io_ctx->priv = ctx;
+
+    return 0;
+}
+
+static int pho_uring_write(struct pho_io_descr *iod, const void *buf,
+                           size_t count)
+{
+    struct posix_io_ctx *io_ctx = iod->iod_ctx;
+    struct uring_io_ctx *ctx = io_ctx->priv;
+    size_t written_size = 0;
+    int rc;
+
+    if (!ctx)
+        return pho_posix_write(iod, buf, count);
+
+    /* The data is copied to the staging buffers, so that the caller can reuse
+     * its buffer as soon as we return.
+     */
+    while (written_size < count) {
+        struct uring_buf *ubuf = &ctx->bufs[ctx->cur];
+        size_t n;
+
+        while (ubuf->state == URING_BUF_BUSY) {
+            rc = uring_wait(ctx);
+            if (rc)
+                return rc;
+        }
+
+        if (ctx->rc)
+            return ctx->rc;
+
+        n = min(count - written_size, URING_BUF_SIZE - ubuf->len);
+        memcpy(ubuf->data + ubuf->len, buf + written_size, n);
+        ubuf->len += n;
+        written_size += n;
+        ctx->size += n;
+
+        if (ubuf->len < URING_BUF_SIZE)
+            break;
+
+        uring_prep_io(ctx, ctx->cur, URING_BUF_SIZE);
+        rc = uring_submit(ctx);
+        if (rc)
+            return rc;
+
+        ctx->cur = (ctx->cur + 1) % URING_QUEUE_DEPTH;
+    }
+
+    return 0;
+}
+
+/** Submit the reads of all the free buffers, in order */
+static int uring_read_ahead(struct uring_io_ctx *ctx)
+{
+    int i;
+
+    for (i = 0; i < URING_QUEUE_DEPTH; i++) {
+        int idx = (ctx->cur + i) % URING_QUEUE_DEPTH;
+
+        if (ctx->bufs[idx].state == URING_BUF_FREE)
+            uring_prep_io(ctx, idx, URING_BUF_SIZE);
+    }
+
+    return uring_submit(ctx);
+}
+
+static ssize_t pho_uring_read(struct pho_io_descr *iod, void *buf,
+                              size_t count)
+{
+    struct posix_io_ctx *io_ctx = iod->iod_ctx;
+    struct uring_io_ctx *ctx = io_ctx->priv;
+    ssize_t nb_read_bytes = 0;
+    int rc;
+
+    if (!ctx)
+        return pho_posix_read(iod, buf, count);
+
+    if (ctx->offset == 0) {
+        rc = uring_read_ahead(ctx);
+        if (rc)
+            return rc;
+    }
+
+    while (count > 0 && !ctx->eof) {
+        struct uring_buf *ubuf = &ctx->bufs[ctx->cur];
+        size_t n;
+
+        while (ubuf->state == URING_BUF_BUSY) {
+            rc = uring_wait(ctx);
+            if (rc)
+                return rc;
+        }
+
+        if (ctx->rc)
+            return ctx->rc;
+
+        n = min(count, ubuf->len - ubuf->pos);
+        memcpy(buf + nb_read_bytes, ubuf->data + ubuf->pos, n);
+        ubuf->pos += n;
+        nb_read_bytes += n;
+        count -= n;
+
+        if (ubuf->pos < ubuf->len)
+            break;
+
+        /* a short read means that the end of the extent is reached */
+        if (ubuf->len < URING_BUF_SIZE) {
+            ctx->eof = true;
+            break;
+        }
+
+        ubuf->state = URING_BUF_FREE;
+        uring_prep_io(ctx, ctx->cur, URING_BUF_SIZE);
+        rc = uring_submit(ctx);
+        if (rc)
+            return rc;
+
+        ctx->cur = (ctx->cur + 1) % URING_QUEUE_DEPTH;
+    }
+
+    return nb_read_bytes;
+}
+
+/**
+ * Write the last staged data and wait for all the writes. O_DIRECT writes
+ * must be aligned: the tail is padded with zeros, then the file is truncated
+ * to its actual size.
+ */
+static int uring_flush(struct uring_io_ctx *ctx, enum pho_io_flags flags)
+{
+    struct uring_buf *ubuf = &ctx->bufs[ctx->cur];
+    struct io_uring_sqe *sqe;
+    int rc;
+
+    if (ubuf->len > 0) {
+        size_t len = ubuf->len;
+
+        if (ctx->direct) {
+            len = ALIGN_UP(len, URING_ALIGN);
+            memset(ubuf->data + ubuf->len, 0, len - ubuf->len);
+        }
+
+        uring_prep_io(ctx, ctx->cur, len);
+        rc = uring_submit(ctx);
+        if (rc)
+            return rc;
+    }
+
+    rc = uring_drain(ctx);
+    if (rc)
+        return rc;
+
+    if (ctx->offset != ctx->size && ftruncate(ctx->fd, ctx->size))
+        LOG_RETURN(-errno, "Failed to truncate '%s' to %zu bytes", ctx->fpath,
+                   ctx->size);
+
+    if (!(flags & PHO_IO_SYNC_FILE))
+        return 0;
+
+    sqe = io_uring_get_sqe(&ctx->ring);
+    assert(sqe);
+    io_uring_prep_fsync(sqe, ctx->fd, IORING_FSYNC_DATASYNC);
+    sqe->user_data = URING_FSYNC_TAG;
+    ctx->in_flight++;
+
+    rc = uring_submit(ctx);
+    if (rc)
+        return rc;
+
+    return uring_drain(ctx);
+}
+
+static int pho_uring_close(struct pho_io_descr *iod)
+{
+    struct posix_io_ctx *io_ctx = iod->iod_ctx;
+    struct uring_io_ctx *ctx;
+    int rc = 0;
+    int rc2;
+
+    if (!io_ctx || !io_ctx->priv)
+        return pho_posix_close(iod);
+
+    ctx = io_ctx->priv;
+
+    /* nothing more is written after a failed write, the extent is dropped */
+    if (ctx->is_put && !ctx->rc)
+        rc = uring_flush(ctx, iod->iod_flags);
+
+    /* The buffers may not be freed while requests are in flight. The errors
+     * of the reads done ahead are not relevant, their data was not consumed.
+     */
+    rc2 = uring_drain(ctx);
+    if (rc2 && !ctx->is_put)
+        rc2 = 0;
+    if (!rc)
+        rc = rc2;
+
+    uring_ctx_free(ctx);
+    io_ctx->priv = NULL;
+
+    rc2 = pho_posix_close(iod);
+
+    return rc ? rc : rc2;
+}
+
+/** io_uring adapter */
+static const struct pho_io_adapter_module_ops IO_ADAPTER_URING_OPS = {
+    .ioa_get               = pho_posix_get,
+    .ioa_del               = pho_posix_del,
+    .ioa_open              = pho_uring_open,
+    .iod_from_fd           = pho_posix_iod_from_fd,
+    .ioa_write             = pho_uring_write,
+    .ioa_read              = pho_uring_read,
+    .ioa_close             = pho_uring_close,
+    .ioa_medium_sync       = pho_posix_medium_sync,
+    .ioa_preferred_io_size = pho_posix_preferred_io_size,
+    .ioa_set_md            = pho_posix_set_md,
+    .ioa_get_common_xattrs_from_extent  = pho_get_common_xattrs_from_extent,
+};
+
+/** IO adapter module registration entry point */
+int pho_module_register(void *module, void *context)
+{
+    struct io_adapter_module *self = (struct io_adapter_module *) module;
+
+    phobos_module_context_set(context);
+
+    self->desc = IO_ADAPTER_URING_MODULE_DESC;
+    self->ops = &IO_ADAPTER_URING_OPS;
+
+    return 0;
+}
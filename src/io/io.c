@@ -31,6 +31,7 @@
 
 #define IO_BLOCK_SIZE_ATTR_KEY "io_block_size"
 #define FS_BLOCK_SIZE_ATTR_KEY "fs_block_size"
+#define IO_ADAPTER_ATTR_KEY "io_adapter"
 
 /**
  * List of configuration parameters for this module
@@ -39,10 +40,11 @@ enum pho_cfg_params_io {
     /* Actual parameters */
     PHO_CFG_IO_io_block_size,
     PHO_CFG_IO_fs_block_size,
+    PHO_CFG_IO_io_adapter,
 
     /* Delimiters, update when modifying options */
     PHO_CFG_IO_FIRST = PHO_CFG_IO_io_block_size,
-    PHO_CFG_IO_LAST  = PHO_CFG_IO_fs_block_size,
+    PHO_CFG_IO_LAST  = PHO_CFG_IO_io_adapter,
 };
 
 const struct pho_config_item cfg_io[] = {
@@ -56,6 +58,11 @@ const struct pho_config_item cfg_io[] = {
         .name    = FS_BLOCK_SIZE_ATTR_KEY,
         .value   = "dir=1024,tape=524288,rados_pool=1024"
     },
+    [PHO_CFG_IO_io_adapter] = {
+        .section = "io",
+        .name    = IO_ADAPTER_ATTR_KEY,
+        .value   = "dir=posix" /** only POSIX file systems have a choice */
+    },
 };
 
 int get_cfg_io_block_size(size_t *size, enum rsc_family family)
@@ -157,6 +164,39 @@ int get_io_adapter(enum fs_type fstype, struct io_adapter_module **ioa)
     return rc;
 }
 
+int get_io_adapter_for_family(enum fs_type fstype, enum rsc_family family,
+                              struct io_adapter_module **ioa)
+{
+    char *name;
+    int rc;
+
+    if (fstype != PHO_FS_POSIX)
+        return get_io_adapter(fstype, ioa);
+
+    rc = pho_cfg_get_substring_value("io", IO_ADAPTER_ATTR_KEY, family,
+                                     &name);
+    if (rc == -ENODATA)
+        return get_io_adapter(fstype, ioa);
+    else if (rc)
+        return rc;
+
+    if (!strcmp(name, "posix")) {
+        rc = get_io_adapter(fstype, ioa);
+    } else if (!strcmp(name, "uring")) {
+        rc = load_module("io_adapter_uring", sizeof(**ioa), phobos_context(),
+                         (void **)ioa);
+    } else {
+        rc = -EINVAL;
+        pho_error(rc, "Invalid value '%s' for parameter 'io_adapter' of "
+                  "family '%s', expected 'posix' or 'uring'", name,
+                  rsc_family2str(family));
+    }
+
+    free(name);
+
+    return rc;
+}
+
 int copy_extent(struct io_adapter_module *ioa_source,
                 struct pho_io_descr *iod_source,
                 struct io_adapter_module *ioa_target,
@@ -294,6 +334,16 @@ int set_object_md(const struct io_adapter_module *ioa, struct pho_io_descr *iod,
         free((char *)xxh128_buffer);
     }
 
+    if (extent->with_crc32c) {
+        const char *crc32c_buffer = uchar2hex(extent->crc32c,
+                                              sizeof(extent->crc32c));
+        if (!crc32c_buffer)
+            LOG_RETURN(rc = -ENOMEM, "Unable to construct hex crc32c");
+
+        pho_attr_set(&iod->iod_attrs, PHO_EA_CRC32C_NAME, crc32c_buffer);
+        free((char *)crc32c_buffer);
+    }
+
     rc = snprintf(str_buffer, sizeof(str_buffer),
                   "%lu", object_md->object_size);
     if (rc < 0)
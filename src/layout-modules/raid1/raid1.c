@@ -31,6 +31,7 @@
 #include <glib.h>
 #include <openssl/evp.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #ifdef HAVE_XXH128
 #include <xxhash.h>
@@ -67,6 +68,7 @@ enum pho_cfg_params_raid1 {
     PHO_CFG_LYT_RAID1_repl_count,
     PHO_CFG_LYT_RAID1_extent_xxh128,
     PHO_CFG_LYT_RAID1_extent_md5,
+    PHO_CFG_LYT_RAID1_extent_crc32c,
     PHO_CFG_LYT_RAID1_check_hash,
 
     /* Delimiters, update when modifying options */
@@ -90,6 +92,11 @@ const struct pho_config_item cfg_lyt_raid1[] = {
         .name    = EXTENT_MD5_ATTR_KEY,
         .value   = DEFAULT_MD5
     },
+    [PHO_CFG_LYT_RAID1_extent_crc32c] = {
+        .section = "layout_raid1",
+        .name    = EXTENT_CRC32C_ATTR_KEY,
+        .value   = DEFAULT_CRC32C,
+    },
     [PHO_CFG_LYT_RAID1_check_hash] = {
         .section = "layout_raid1",
         .name    = "check_hash",
@@ -123,54 +130,149 @@ int raid1_repl_count(struct layout_info *layout, unsigned int *repl_count)
 static int write_all_chunks(struct raid_io_context *io_context,
                             size_t split_size)
 {
+    struct raid_io_pipeline *pipeline = &io_context->pipeline;
     struct pho_io_descr *posix = &io_context->posix;
     size_t to_write = split_size;
     struct pho_io_descr *iods;
     size_t buffer_size;
     size_t repl_count;
-    char *buffer;
+    ssize_t read_size;
+    int cur = 0;
     int rc = 0;
 
-    buffer = io_context->buffers[0].buff;
     buffer_size = io_context->buffers[0].size;
     repl_count = io_context->n_data_extents + io_context->n_parity_extents;
     iods = io_context->iods;
 
+    if (to_write == 0)
+        return 0;
+
+    read_size = ioa_read(posix->iod_ioa, posix, io_context->buffers[cur].buff,
+                         min(to_write, buffer_size));
+    if (read_size < 0)
+        LOG_RETURN(read_size,
+                   "Error when read buffer in raid1 write, %zu remaning bytes",
+                   to_write);
+
+    rc = raid_io_pipeline_start(pipeline, repl_count);
+    if (rc)
+        return rc;
+
     while (to_write > 0) {
-        ssize_t read_size;
+        char *buffer = io_context->buffers[cur].buff;
+        ssize_t next_read_size = 0;
+        int rc2;
         int i;
 
-        read_size = ioa_read(posix->iod_ioa, posix, buffer,
-                             to_write > buffer_size ? buffer_size : to_write);
-        if (read_size < 0)
-            LOG_RETURN(rc,
-                       "Error when read buffer in raid1 write, "
-                       "%zu remaning bytes",
-                       to_write);
+        /* Write the current block to all the replicas in the background, the
+         * replicas sharing the hash computed along with the first one...
+         */
+        for (i = 0; i < repl_count; ++i)
+            raid_io_pipeline_submit(pipeline, i, RAID_IO_WRITE, &iods[i],
+                                    buffer, read_size,
+                                    i == 0 ? &io_context->hashes[0] : NULL);
 
-        /* TODO manage as async/parallel IO */
-        for (i = 0; i < repl_count; ++i) {
-            rc = ioa_write(iods[i].iod_ioa, &iods[i], buffer, read_size);
-            if (rc)
-                LOG_RETURN(rc,
-                           "RAID1 write: unable to write %zu bytes in replica "
-                           "%d, %zu remaining bytes",
-                           read_size, i, to_write);
+        to_write -= read_size;
 
-            /* update written iod size */
-            iods[i].iod_size += read_size;
+        /* ... while the next one is read from the source */
+        if (to_write > 0) {
+            next_read_size = ioa_read(posix->iod_ioa, posix,
+                                      io_context->buffers[1 - cur].buff,
+                                      min(to_write, buffer_size));
+            if (next_read_size < 0)
+                pho_error(rc = next_read_size,
+                          "Error when read buffer in raid1 write, "
+                          "%zu remaning bytes", to_write);
         }
 
-        rc = extent_hash_update(&io_context->hashes[0], buffer, read_size);
+        rc2 = raid_io_pipeline_wait(pipeline);
+        if (rc2)
+            pho_error(rc2,
+                      "RAID1 write: unable to write %zu bytes in replicas, "
+                      "%zu remaining bytes", read_size, to_write);
+        rc = rc ? : rc2;
         if (rc)
-            return rc;
+            break;
 
-        to_write -= read_size;
+        read_size = next_read_size;
+        cur = 1 - cur;
     }
 
+    raid_io_pipeline_stop(pipeline);
+
     return rc;
 }
 
+/**
+ * Whether the split can be copied from \p src_fd to the replicas without
+ * going through the buffers of the layout.
+ */
+static bool can_write_zero_copy(struct raid_io_context *io_context,
+                                int src_fd)
+{
+    size_t repl_count = io_context->n_data_extents +
+        io_context->n_parity_extents;
+    struct stat st;
+    size_t i;
+
+    /* the data has to go through user space to be hashed */
+    if (extent_hash_is_enabled(&io_context->hashes[0]))
+        return false;
+
+    /* the source is read once per replica, at a given offset */
+    if (fstat(src_fd, &st) || !S_ISREG(st.st_mode))
+        return false;
+
+    for (i = 0; i < repl_count; i++)
+        if (!ioa_can_write_from_fd(io_context->iods[i].iod_ioa))
+            return false;
+
+    return true;
+}
+
+static int write_zero_copy(struct raid_io_context *io_context, int src_fd,
+                           size_t split_size)
+{
+    struct raid_io_pipeline *pipeline = &io_context->pipeline;
+    size_t repl_count = io_context->n_data_extents +
+        io_context->n_parity_extents;
+    off_t offset;
+    size_t i;
+    int rc;
+
+    if (split_size == 0)
+        return 0;
+
+    /* The split is copied from the current offset of the source, which is
+     * then moved past the split as if it had been read.
+     */
+    offset = lseek(src_fd, 0, SEEK_CUR);
+    if (offset == -1)
+        LOG_RETURN(-errno, "Unable to get the offset of the source file");
+
+    pho_debug("RAID1 write: copying %zu bytes to %zu replicas", split_size,
+              repl_count);
+
+    rc = raid_io_pipeline_start(pipeline, repl_count);
+    if (rc)
+        return rc;
+
+    for (i = 0; i < repl_count; i++)
+        raid_io_pipeline_submit_copy(pipeline, i, &io_context->iods[i],
+                                     src_fd, offset, split_size);
+
+    rc = raid_io_pipeline_wait(pipeline);
+    raid_io_pipeline_stop(pipeline);
+    if (rc)
+        LOG_RETURN(rc, "RAID1 write: unable to copy %zu bytes in replicas",
+                   split_size);
+
+    if (lseek(src_fd, offset + split_size, SEEK_SET) == -1)
+        LOG_RETURN(-errno, "Unable to move the offset of the source file");
+
+    return 0;
+}
+
 static int set_layout_specific_md(int layout_index, int replica_count,
                                   struct pho_io_descr *iod)
 {
@@ -206,14 +308,18 @@ static int raid1_write_split(struct pho_encoder *enc, size_t split_size,
         &((struct raid_io_context *) enc->priv_enc)[target_idx];
     size_t repl_count = io_context->n_data_extents +
         io_context->n_parity_extents;
+    int src_fd = enc->xfer->xd_targets[target_idx].xt_fd;
     struct pho_io_descr *iods;
     int rc = 0;
     int i;
 
     iods = io_context->iods;
 
-    /* write all extents by chunk of buffer size*/
-    rc = write_all_chunks(io_context, split_size);
+    if (can_write_zero_copy(io_context, src_fd))
+        rc = write_zero_copy(io_context, src_fd, split_size);
+    else
+        /* write all extents by chunk of buffer size*/
+        rc = write_all_chunks(io_context, split_size);
     if (rc)
         LOG_RETURN(rc, "Unable to write in raid1 encoder write");
 
@@ -246,41 +352,61 @@ static int raid1_write_split(struct pho_encoder *enc, size_t split_size,
 static int checked_read(struct pho_encoder *dec)
 {
     struct raid_io_context *io_context = dec->priv_enc;
+    struct raid_io_pipeline *pipeline = &io_context->pipeline;
     struct pho_io_descr *iod;
     size_t written = 0;
     size_t read_size;
     size_t to_write;
+    int cur = 0;
     int rc;
 
     iod = &io_context->iods[0];
     read_size = io_context->buffers[0].size;
     to_write = io_context->read.extents[0]->size;
 
+    rc = raid_io_pipeline_start(pipeline, 1);
+    if (rc)
+        return rc;
+
+    if (to_write > 0)
+        raid_io_pipeline_submit(pipeline, 0, RAID_IO_READ, iod,
+                                io_context->buffers[cur].buff, read_size,
+                                &io_context->hashes[0]);
+
     while (written < to_write) {
-        ssize_t data_written;
         ssize_t data_read;
 
-        data_read = ioa_read(iod->iod_ioa, iod, io_context->buffers[0].buff,
-                             read_size);
-        if (data_read < 0)
-            return data_read;
+        rc = raid_io_pipeline_wait(pipeline);
+        if (rc)
+            goto out;
 
-        data_written = ioa_write(io_context->posix.iod_ioa,
-                                 &io_context->posix,
-                                 io_context->buffers[0].buff,
-                                 data_read);
-        if (data_written < 0)
-            return data_written;
+        data_read = raid_io_pipeline_result(pipeline, 0);
+        if (data_read == 0)
+            LOG_GOTO(out, rc = -EIO,
+                     "Unexpected end of extent after %zu bytes", written);
 
         written += data_read;
 
-        rc = extent_hash_update(&io_context->hashes[0],
-                                io_context->buffers[0].buff,
-                                data_read);
+        /* Read and hash the next block while this one is written out */
+        if (written < to_write)
+            raid_io_pipeline_submit(pipeline, 0, RAID_IO_READ, iod,
+                                    io_context->buffers[1 - cur].buff,
+                                    read_size, &io_context->hashes[0]);
+
+        rc = ioa_write(io_context->posix.iod_ioa, &io_context->posix,
+                       io_context->buffers[cur].buff, data_read);
         if (rc)
-            return rc;
+            goto out;
+
+        cur = 1 - cur;
     }
 
+out:
+    /* Wait for a possibly pending read before stopping */
+    raid_io_pipeline_stop(pipeline);
+    if (rc)
+        return rc;
+
     rc = extent_hash_digest(&io_context->hashes[0]);
     if (rc)
         return rc;
@@ -400,7 +526,8 @@ static int layout_raid1_encode(struct pho_encoder *enc)
         io_context->n_data_extents = 1;
         io_context->n_parity_extents = repl_count - 1;
         io_context->write.to_write = enc->xfer->xd_targets[i].xt_size;
-        io_context->nb_hashes = repl_count;
+        /* the replicas are identical, they share the same hash */
+        io_context->nb_hashes = 1;
         io_context->hashes = xcalloc(io_context->nb_hashes,
                                      sizeof(*io_context->hashes));
 
@@ -413,6 +540,10 @@ static int layout_raid1_encode(struct pho_encoder *enc)
                               PHO_CFG_GET_BOOL(cfg_lyt_raid1,
                                                PHO_CFG_LYT_RAID1,
                                                extent_xxh128,
+                                               false),
+                              PHO_CFG_GET_BOOL(cfg_lyt_raid1,
+                                               PHO_CFG_LYT_RAID1,
+                                               extent_crc32c,
                                                false));
             if (rc)
                 goto out_hash;
@@ -525,9 +656,9 @@ static int layout_raid1_delete(struct pho_encoder *dec)
     return rc;
 }
 
-int layout_raid1_locate(struct dss_handle *dss, struct layout_info *layout,
-                        const char *focus_host, char **hostname,
-                        int *nb_new_locks)
+int layout_raid1_locate(struct dss_handle *dss, struct dss_locate_cache *cache,
+                        struct layout_info *layout, const char *focus_host,
+                        char **hostname, int *nb_new_locks)
 {
     unsigned int repl_count;
     int rc;
@@ -536,8 +667,8 @@ int layout_raid1_locate(struct dss_handle *dss, struct layout_info *layout,
     if (rc)
         LOG_RETURN(rc, "Invalid replica count from layout to locate");
 
-    return raid_locate(dss, layout, 1, repl_count - 1, focus_host, hostname,
-                       nb_new_locks);
+    return raid_locate(dss, cache, layout, 1, repl_count - 1, focus_host,
+                       hostname, nb_new_locks);
 }
 
 static int layout_raid1_reconstruct(struct layout_info lyt,
@@ -26,6 +26,8 @@
 #define _PHO_RAID1_H
 
 #include "pho_types.h" /* struct layout_info */
+#include "pho_dss.h"
+#include "pho_dss_wrapper.h"
 #include "pho_io.h"
 
 /**
@@ -54,6 +56,12 @@
  */
 #define EXTENT_MD5_ATTR_KEY "extent_md5"
 
+/**
+ * Computing the CRC32C of each extent is enabled by the configuration if
+ * EXTENT_CRC32C_ATTR_KEY is set to "yes"
+ */
+#define EXTENT_CRC32C_ATTR_KEY "extent_crc32c"
+
 /**
  * Set unsigned int replica count value from layout attributes
  *
@@ -72,6 +80,8 @@ int raid1_repl_count(struct layout_info *layout, unsigned int *repl_count);
  *
  * Implement layout_locate layout module methods.
  *
+ * @param[in]   dss         DSS handle
+ * @param[in]   cache       Media and devices already located (may be NULL)
  * @param[in]   layout      Layout of the object to locate
  * @param[in]   focus_host  Hostname on which the caller would like to access
  *                          the object if there is no node more convenient (if
@@ -90,8 +100,8 @@ int raid1_repl_count(struct layout_info *layout, unsigned int *repl_count);
  *                          currently retrieve this object
  *                          -EADDRNOTAVAIL if we cannot get self hostname
  */
-int layout_raid1_locate(struct dss_handle *dss, struct layout_info *layout,
-                        const char *focus_host, char **hostname,
-                        int *nb_new_lock);
+int layout_raid1_locate(struct dss_handle *dss, struct dss_locate_cache *cache,
+                        struct layout_info *layout, const char *focus_host,
+                        char **hostname, int *nb_new_lock);
 
 #endif
@@ -64,6 +64,7 @@ enum pho_cfg_params_raid4 {
     /* Actual parameters */
     PHO_CFG_LYT_RAID4_extent_xxh128,
     PHO_CFG_LYT_RAID4_extent_md5,
+    PHO_CFG_LYT_RAID4_extent_crc32c,
     PHO_CFG_LYT_RAID4_check_hash,
 
     /* Delimiters, update when modifying options */
@@ -82,6 +83,11 @@ const struct pho_config_item raid4_cfg_items[] = {
         .name    = "extent_md5",
         .value   = DEFAULT_MD5,
     },
+    [PHO_CFG_LYT_RAID4_extent_crc32c] = {
+        .section = "layout_raid4",
+        .name    = "extent_crc32c",
+        .value   = DEFAULT_CRC32C,
+    },
     [PHO_CFG_LYT_RAID4_check_hash] = {
         .section = "layout_raid4",
         .name    = "check_hash",
@@ -120,6 +126,10 @@ static int layout_raid4_encode(struct pho_encoder *enc)
                               PHO_CFG_GET_BOOL(raid4_cfg_items,
                                                PHO_CFG_LYT_RAID4,
                                                extent_xxh128,
+                                               false),
+                              PHO_CFG_GET_BOOL(raid4_cfg_items,
+                                               PHO_CFG_LYT_RAID4,
+                                               extent_crc32c,
                                                false));
             if (rc)
                 goto out_hash;
@@ -220,12 +230,14 @@ static int layout_raid4_delete(struct pho_encoder *dec)
 }
 
 static int layout_raid4_locate(struct dss_handle *dss,
+                               struct dss_locate_cache *cache,
                                struct layout_info *layout,
                                const char *focus_host,
                                char **hostname,
                                int *nb_new_lock)
 {
-    return raid_locate(dss, layout, 2, 1, focus_host, hostname, nb_new_lock);
+    return raid_locate(dss, cache, layout, 2, 1, focus_host, hostname,
+                       nb_new_lock);
 }
 
 static const struct pho_layout_module_ops LAYOUT_RAID4_OPS = {
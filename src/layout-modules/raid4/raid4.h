@@ -14,7 +14,28 @@ int raid4_read_split(struct pho_encoder *dec);
 
 int raid4_get_block_size(struct pho_encoder *enc, size_t *block_size);
 
+/**
+ * Compute xor = buff1 ^ buff2 on \p count bytes.
+ *
+ * The fastest implementation supported by the CPU is selected when the module
+ * is loaded (AVX-512, AVX2, SSE2, or a portable 64-bit word loop).
+ */
 void buffer_xor(struct pho_buff *buff1, struct pho_buff *buff2,
                 struct pho_buff *xor, size_t count);
 
+/**
+ * Force the implementation used by buffer_xor().
+ *
+ * \param[in]  name    "avx512", "avx2", "sse2" or "word"
+ *
+ * \return 0 on success, -ENOTSUP if the CPU does not support it, -EINVAL if
+ *         the implementation does not exist.
+ */
+int buffer_xor_set_impl(const char *name);
+
+/**
+ * Name of the implementation currently used by buffer_xor().
+ */
+const char *buffer_xor_impl(void);
+
 #endif
@@ -30,19 +30,61 @@
 
 #include <unistd.h>
 
+/**
+ * Read the next block of both extents in the background, hashing them if
+ * needed.
+ */
+static void submit_reads(struct raid_io_context *io_context,
+                         struct pho_io_descr *iod1,
+                         struct pho_io_descr *iod2,
+                         struct pho_buff *buffers, size_t size)
+{
+    bool check_hash = io_context->read.check_hash;
+
+    raid_io_pipeline_submit(&io_context->pipeline, 0, RAID_IO_READ, iod1,
+                            buffers[0].buff, size,
+                            check_hash ? &io_context->hashes[0] : NULL);
+    raid_io_pipeline_submit(&io_context->pipeline, 1, RAID_IO_READ, iod2,
+                            buffers[1].buff, size,
+                            check_hash ? &io_context->hashes[1] : NULL);
+}
+
+static int check_hashes(struct raid_io_context *io_context)
+{
+    int rc;
+    int i;
+
+    if (!io_context->read.check_hash)
+        return 0;
+
+    for (i = 0; i < io_context->n_data_extents; i++) {
+        rc = extent_hash_digest(&io_context->hashes[i]);
+        if (rc)
+            return rc;
+
+        rc = extent_hash_compare(&io_context->hashes[i],
+                                 io_context->read.extents[i]);
+        if (rc)
+            return rc;
+    }
+
+    return 0;
+}
+
 static int write_with_xor(struct pho_encoder *dec,
                           struct pho_io_descr *iod1,
                           struct pho_io_descr *iod2,
                           bool second_part_missing)
 {
     struct raid_io_context *io_context = dec->priv_enc;
+    struct raid_io_pipeline *pipeline = &io_context->pipeline;
     struct pho_io_descr *posix = &io_context->posix;
     size_t buf_size = io_context->buffers[0].size;
     struct extent *split_extents;
     size_t written = 0;
     size_t split_size;
+    int cur = 0;
     int rc;
-    int i;
 
     ENTRY;
 
@@ -51,95 +93,83 @@ static int write_with_xor(struct pho_encoder *dec,
 
     split_size = split_extents[0].size + split_extents[1].size;
 
+    rc = raid_io_pipeline_start(pipeline, 2);
+    if (rc)
+        return rc;
+
+    /* Double buffering: the blocks of one set are decoded and written to the
+     * output while the next ones are read in the other set.
+     */
+    submit_reads(io_context, iod1, iod2, &io_context->buffers[0], buf_size);
+
     while (true) {
+        struct pho_buff *buffers = &io_context->buffers[3 * cur];
         ssize_t part1_size;
         ssize_t part2_size;
+        size_t first_size;
+        size_t second_size;
 
-        part1_size = ioa_read(iod1->iod_ioa, iod1,
-                              io_context->buffers[0].buff, buf_size);
-        if (part1_size < 0)
-            LOG_RETURN(part1_size, "Failed to read file");
-        pho_debug("part1_size: %ld", part1_size);
-
-        if (io_context->read.check_hash) {
-            rc = extent_hash_update(&io_context->hashes[0],
-                                    io_context->buffers[0].buff, part1_size);
-            if (rc)
-                return rc;
-        }
-
-        // XOR
-        part2_size = ioa_read(iod2->iod_ioa, iod2,
-                              io_context->buffers[1].buff,
-                              buf_size);
-        if (part2_size < 0)
-            LOG_RETURN(part2_size, "Failed to read file");
+        rc = raid_io_pipeline_wait(pipeline);
+        if (rc)
+            LOG_GOTO(out, rc, "Failed to read file");
 
+        part1_size = raid_io_pipeline_result(pipeline, 0);
+        part2_size = raid_io_pipeline_result(pipeline, 1);
+        pho_debug("part1_size: %ld", part1_size);
         pho_debug("part2_size: %ld", part2_size);
 
-        if (io_context->read.check_hash) {
-            rc = extent_hash_update(&io_context->hashes[1],
-                                    io_context->buffers[1].buff, part2_size);
-            if (rc)
-                return rc;
-        }
-
         if (part1_size != part2_size) {
             /* Since the xor is always associated with iod2 and each buffer is
              * padded during put, the xor should always be a multiple of the
              * buffer size.
              */
             assert(part1_size < part2_size);
-            memset(io_context->buffers[0].buff + part1_size, 0,
+            memset(buffers[0].buff + part1_size, 0,
                    part2_size - part1_size);
         }
 
-        buffer_xor(&io_context->buffers[0], &io_context->buffers[1],
-                   &io_context->buffers[2], buf_size);
+        buffer_xor(&buffers[0], &buffers[1], &buffers[2], buf_size);
+
+        first_size = second_part_missing ? part1_size : part2_size;
+        second_size = second_part_missing ?
+            min(part1_size, split_size - written - first_size) :
+            part1_size;
+
+        if (written + first_size + second_size < split_size)
+            submit_reads(io_context, iod1, iod2,
+                         &io_context->buffers[3 * (1 - cur)], buf_size);
 
         rc = ioa_write(posix->iod_ioa, posix,
                        second_part_missing ?
-                           io_context->buffers[0].buff :
-                           io_context->buffers[2].buff,
-                       second_part_missing ?
-                           part1_size :
-                           part2_size);
+                           buffers[0].buff :
+                           buffers[2].buff,
+                       first_size);
         if (rc)
-            return rc;
+            goto out;
 
-        written += second_part_missing ?  part1_size : part2_size;
+        written += first_size;
         rc = ioa_write(posix->iod_ioa, posix,
                        second_part_missing ?
-                           io_context->buffers[2].buff :
-                           io_context->buffers[0].buff,
-                       second_part_missing ?
-                           min(part1_size, split_size - written) :
-                           part1_size);
+                           buffers[2].buff :
+                           buffers[0].buff,
+                       second_size);
         if (rc)
-            return rc;
+            goto out;
 
-        written += second_part_missing ?
-            min(part1_size, split_size - written) :
-            part1_size;
+        written += second_size;
 
         if (written >= split_size)
             break;
-    }
-
-    if (io_context->read.check_hash) {
-        for (i = 0; i < io_context->n_data_extents; i++) {
-            rc = extent_hash_digest(&io_context->hashes[i]);
-            if (rc)
-                return rc;
 
-            rc = extent_hash_compare(&io_context->hashes[i],
-                                     io_context->read.extents[i]);
-            if (rc)
-                return rc;
-        }
+        cur = 1 - cur;
     }
 
-    return 0;
+out:
+    raid_io_pipeline_stop(pipeline);
+    if (rc)
+        return rc;
+
+    return check_hashes(io_context);
 }
 
 static int write_without_xor(struct pho_encoder *dec,
@@ -147,13 +177,13 @@ static int write_without_xor(struct pho_encoder *dec,
                              struct pho_io_descr *iod2)
 {
     struct raid_io_context *io_context = dec->priv_enc;
+    struct raid_io_pipeline *pipeline = &io_context->pipeline;
     struct pho_io_descr *posix = &io_context->posix;
     size_t written = 0;
-    ssize_t data_read;
     size_t read_size;
     size_t to_write;
+    int cur = 0;
     int rc;
-    int i;
 
     ENTRY;
 
@@ -161,64 +191,54 @@ static int write_without_xor(struct pho_encoder *dec,
         io_context->read.extents[1]->size;
     read_size = io_context->buffers[0].size;
 
+    rc = raid_io_pipeline_start(pipeline, 2);
+    if (rc)
+        return rc;
+
+    if (written < to_write)
+        submit_reads(io_context, iod1, iod2, &io_context->buffers[0],
+                     read_size);
+
     while (written < to_write) {
+        struct pho_buff *buffers = &io_context->buffers[3 * cur];
+        ssize_t data_read1;
+        ssize_t data_read2;
 
-        data_read = ioa_read(iod1->iod_ioa, iod1,
-                             io_context->buffers[0].buff,
-                             read_size);
-        if (data_read < 0)
-            LOG_RETURN(data_read, "Failed to read file");
+        rc = raid_io_pipeline_wait(pipeline);
+        if (rc)
+            LOG_GOTO(out, rc, "Failed to read file");
 
-        rc = ioa_write(posix->iod_ioa, posix, io_context->buffers[0].buff,
-                       data_read);
-        if (rc < 0)
-            LOG_RETURN(rc, "Failed to write in file");
-
-        if (io_context->read.check_hash) {
-            rc = extent_hash_update(&io_context->hashes[0],
-                                    io_context->buffers[0].buff,
-                                    data_read);
-            if (rc)
-                return rc;
-        }
+        data_read1 = raid_io_pipeline_result(pipeline, 0);
+        data_read2 = raid_io_pipeline_result(pipeline, 1);
+        if (data_read1 + data_read2 == 0)
+            LOG_GOTO(out, rc = -EIO,
+                     "Unexpected end of extents after %zu bytes", written);
 
-        written += data_read;
-        data_read = ioa_read(iod2->iod_ioa, iod2,
-                             io_context->buffers[0].buff,
-                             read_size);
-        if (data_read < 0)
-            LOG_RETURN(data_read, "Failed to read file");
+        /* Read the next blocks while these ones are written to the output */
+        if (written + data_read1 + data_read2 < to_write)
+            submit_reads(io_context, iod1, iod2,
+                         &io_context->buffers[3 * (1 - cur)], read_size);
 
-        rc = ioa_write(posix->iod_ioa, posix, io_context->buffers[0].buff,
-                       data_read);
+        rc = ioa_write(posix->iod_ioa, posix, buffers[0].buff, data_read1);
         if (rc < 0)
-            LOG_RETURN(rc, "Failed to write in file");
-
-        if (io_context->read.check_hash) {
-            rc = extent_hash_update(&io_context->hashes[1],
-                                    io_context->buffers[0].buff,
-                                    data_read);
-            if (rc)
-                return rc;
-        }
+            LOG_GOTO(out, rc, "Failed to write in file");
 
-        written += data_read;
-    }
+        written += data_read1;
 
-    if (io_context->read.check_hash) {
-        for (i = 0; i < io_context->n_data_extents; i++) {
-            rc = extent_hash_digest(&io_context->hashes[i]);
-            if (rc)
-                return rc;
+        rc = ioa_write(posix->iod_ioa, posix, buffers[1].buff, data_read2);
+        if (rc < 0)
+            LOG_GOTO(out, rc, "Failed to write in file");
 
-            rc = extent_hash_compare(&io_context->hashes[i],
-                                     io_context->read.extents[i]);
-            if (rc)
-                return rc;
-        }
+        written += data_read2;
+        cur = 1 - cur;
     }
 
-    return 0;
+out:
+    raid_io_pipeline_stop(pipeline);
+    if (rc)
+        return rc;
+
+    return check_hashes(io_context);
 }
 
 /* has_part1 and has_xor are tested first as it is easier to check for their
@@ -65,17 +65,68 @@ static int set_raid4_md(struct raid_io_context *io_context, size_t chunk_size)
     return rc;
 }
 
+/**
+ * Read the next two data blocks of the split from the source and compute their
+ * parity block.
+ *
+ * \param[in]      io_context      I/O context of the split
+ * \param[out]     buffers         Data blocks and parity block
+ * \param[in/out]  buf_size        Size of the blocks to read, reduced for the
+ *                                 last blocks
+ * \param[in/out]  left_to_read    Size remaining to read in the split
+ * \param[out]     sizes           Size of each block to write
+ */
+static int read_and_xor(struct raid_io_context *io_context,
+                        struct pho_buff *buffers, size_t *buf_size,
+                        size_t *left_to_read, ssize_t *sizes)
+{
+    struct pho_io_descr *posix = &io_context->posix;
+
+    if (*left_to_read < 2 * *buf_size)
+        /* split the size over the 2 extents otherwise, one extent will
+         * exceed the size allocated by the LRS
+         */
+        *buf_size = (*left_to_read + 1) / 2;
+
+    sizes[0] = ioa_read(posix->iod_ioa, posix, buffers[0].buff, *buf_size);
+    if (sizes[0] < 0)
+        LOG_RETURN(sizes[0], "Unable to read %zu bytes in raid4 write",
+                   *buf_size);
+
+    sizes[1] = ioa_read(posix->iod_ioa, posix, buffers[1].buff, *buf_size);
+    if (sizes[1] < 0)
+        LOG_RETURN(sizes[1], "Unable to read %zu bytes in raid4 write",
+                   *buf_size);
+
+    *left_to_read -= sizes[0];
+    *left_to_read -= sizes[1];
+
+    /* Add 0 padding at the end of the second buffer to match the size of
+     * the first one for the last xor.
+     */
+    if (*left_to_read == 0)
+        memset(buffers[1].buff + sizes[1], 0, sizes[0] - sizes[1]);
+
+    buffer_xor(&buffers[0], &buffers[1], &buffers[2], sizes[0]);
+    sizes[2] = sizes[0];
+
+    return 0;
+}
+
 int raid4_write_split(struct pho_encoder *enc, size_t split_size,
                       int target_idx)
 {
     struct raid_io_context *io_context =
         &((struct raid_io_context *) enc->priv_enc)[target_idx];
-    struct pho_io_descr *posix = &io_context->posix;
+    struct raid_io_pipeline *pipeline = &io_context->pipeline;
     size_t buf_size = io_context->buffers[0].size;
     struct pho_io_descr *iods = io_context->iods;
+    struct pho_buff *buffers[2];
     size_t left_to_read;
-    bool eof = false;
+    ssize_t sizes[2][3];
+    int cur = 0;
     int rc = 0;
+    int rc2;
     int i;
 
     ENTRY;
@@ -86,86 +137,48 @@ int raid4_write_split(struct pho_encoder *enc, size_t split_size,
     if (rc)
         return rc;
 
-    while (!eof) {
-        ssize_t bytes_read1 = 0;
-        ssize_t bytes_read2 = 0;
-
-        if (left_to_read < 2 * buf_size)
-            /* split the size over the 2 extents otherwise, one extent will
-             * exceed the size allocated by the LRS
-             */
-            buf_size = (left_to_read + 1) / 2;
-
-        bytes_read1 = ioa_read(posix->iod_ioa, posix,
-                               io_context->buffers[0].buff,
-                               buf_size);
-        if (bytes_read1 < 0)
-            goto out;
-
-        bytes_read2 = ioa_read(posix->iod_ioa, posix,
-                               io_context->buffers[1].buff,
-                               buf_size);
-        if (bytes_read2 < 0)
-            goto out;
-
-        left_to_read -= bytes_read1;
-        left_to_read -= bytes_read2;
-        eof = (left_to_read == 0);
-
-        rc = ioa_write(iods[0].iod_ioa, &iods[0], io_context->buffers[0].buff,
-                       bytes_read1);
-        if (rc)
-            LOG_GOTO(out, rc, "Unable to write %zu bytes in raid4 write",
-                     bytes_read1);
-
-        rc = extent_hash_update(&io_context->hashes[0],
-                                io_context->buffers[0].buff,
-                                bytes_read1);
-        if (rc)
-            return rc;
-
-        iods[0].iod_size += bytes_read1;
-
-        rc = ioa_write(iods[1].iod_ioa, &iods[1], io_context->buffers[1].buff,
-                       bytes_read2);
-        if (rc)
-            LOG_GOTO(out, rc, "Unable to write %zu bytes in raid4 write",
-                     bytes_read2);
+    /* Double buffering: the blocks of one set are written to the extents
+     * while the next blocks are read in the other set.
+     */
+    buffers[0] = &io_context->buffers[0];
+    buffers[1] = &io_context->buffers[3];
 
-        rc = extent_hash_update(&io_context->hashes[1],
-                                io_context->buffers[1].buff,
-                                bytes_read2);
-        if (rc)
-            return rc;
-
-        iods[1].iod_size += bytes_read2;
+    rc = read_and_xor(io_context, buffers[cur], &buf_size, &left_to_read,
+                      sizes[cur]);
+    if (rc)
+        return rc;
 
-        /* Add 0 padding at the end of the second buffer to match the size of
-         * the first one for the last xor.
-         */
-        if (eof)
-            memset(io_context->buffers[1].buff + bytes_read2, 0,
-                   bytes_read1 - bytes_read2);
+    rc = raid_io_pipeline_start(pipeline, 3);
+    if (rc)
+        return rc;
 
-        buffer_xor(&io_context->buffers[0], &io_context->buffers[1],
-                   &io_context->buffers[2], bytes_read1);
+    while (true) {
+        bool eof = (left_to_read == 0);
 
-        rc = ioa_write(iods[2].iod_ioa, &iods[2], io_context->buffers[2].buff,
-                       bytes_read1);
-        if (rc)
-            LOG_GOTO(out, rc, "Unable to write %zu bytes in raid4 write",
-                     bytes_read1);
+        for (i = 0; i < 3; i++)
+            raid_io_pipeline_submit(pipeline, i, RAID_IO_WRITE, &iods[i],
+                                    buffers[cur][i].buff, sizes[cur][i],
+                                    &io_context->hashes[i]);
 
-        rc = extent_hash_update(&io_context->hashes[2],
-                                io_context->buffers[2].buff,
-                                bytes_read1);
-        if (rc)
-            return rc;
+        if (!eof)
+            rc = read_and_xor(io_context, buffers[1 - cur], &buf_size,
+                              &left_to_read, sizes[1 - cur]);
 
-        iods[2].iod_size += bytes_read1;
+        rc2 = raid_io_pipeline_wait(pipeline);
+        if (rc2)
+            pho_error(rc2, "Unable to write %zu bytes in raid4 write",
+                      sizes[cur][0]);
+        rc = rc ? : rc2;
+        if (rc || eof)
+            break;
 
+        cur = 1 - cur;
     }
 
+    raid_io_pipeline_stop(pipeline);
+    if (rc)
+        return rc;
+
     for (i = 0; i < io_context->nb_hashes; i++) {
         rc = extent_hash_digest(&io_context->hashes[i]);
         if (rc)
@@ -177,6 +190,5 @@ int raid4_write_split(struct pho_encoder *enc, size_t split_size,
             return rc;
     }
 
-out:
     return rc;
 }
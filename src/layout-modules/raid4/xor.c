@@ -28,11 +28,179 @@
 
 #include "raid4.h"
 
-void buffer_xor(struct pho_buff *buff1, struct pho_buff *buff2,
-                struct pho_buff *xor, size_t count)
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define XOR_X86 1
+#endif
+
+typedef void (*xor_func_t)(const char *buff1, const char *buff2, char *xor,
+                           size_t count);
+
+/* Portable version, working on 64-bit words then on the remaining bytes */
+static void xor_word(const char *buff1, const char *buff2, char *xor,
+                     size_t count)
+{
+    size_t i;
+
+    for (i = 0; i + sizeof(uint64_t) <= count; i += sizeof(uint64_t)) {
+        uint64_t word1;
+        uint64_t word2;
+
+        /* memcpy is turned into plain loads, and handles misaligned data */
+        memcpy(&word1, buff1 + i, sizeof(word1));
+        memcpy(&word2, buff2 + i, sizeof(word2));
+        word1 ^= word2;
+        memcpy(xor + i, &word1, sizeof(word1));
+    }
+
+    for (; i < count; i++)
+        xor[i] = buff1[i] ^ buff2[i];
+}
+
+#ifdef XOR_X86
+__attribute__((target("sse2")))
+static void xor_sse2(const char *buff1, const char *buff2, char *xor,
+                     size_t count)
 {
     size_t i;
 
-    for (i = 0; i < count; i++)
-        xor->buff[i] = buff1->buff[i] ^ buff2->buff[i];
+    for (i = 0; i + 4 * sizeof(__m128i) <= count; i += 4 * sizeof(__m128i)) {
+        __m128i a0 = _mm_loadu_si128((const __m128i *)(buff1 + i));
+        __m128i a1 = _mm_loadu_si128((const __m128i *)(buff1 + i + 16));
+        __m128i a2 = _mm_loadu_si128((const __m128i *)(buff1 + i + 32));
+        __m128i a3 = _mm_loadu_si128((const __m128i *)(buff1 + i + 48));
+        __m128i b0 = _mm_loadu_si128((const __m128i *)(buff2 + i));
+        __m128i b1 = _mm_loadu_si128((const __m128i *)(buff2 + i + 16));
+        __m128i b2 = _mm_loadu_si128((const __m128i *)(buff2 + i + 32));
+        __m128i b3 = _mm_loadu_si128((const __m128i *)(buff2 + i + 48));
+
+        _mm_storeu_si128((__m128i *)(xor + i), _mm_xor_si128(a0, b0));
+        _mm_storeu_si128((__m128i *)(xor + i + 16), _mm_xor_si128(a1, b1));
+        _mm_storeu_si128((__m128i *)(xor + i + 32), _mm_xor_si128(a2, b2));
+        _mm_storeu_si128((__m128i *)(xor + i + 48), _mm_xor_si128(a3, b3));
+    }
+
+    xor_word(buff1 + i, buff2 + i, xor + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void xor_avx2(const char *buff1, const char *buff2, char *xor,
+                     size_t count)
+{
+    size_t i;
+
+    for (i = 0; i + 2 * sizeof(__m256i) <= count; i += 2 * sizeof(__m256i)) {
+        __m256i a0 = _mm256_loadu_si256((const __m256i *)(buff1 + i));
+        __m256i a1 = _mm256_loadu_si256((const __m256i *)(buff1 + i + 32));
+        __m256i b0 = _mm256_loadu_si256((const __m256i *)(buff2 + i));
+        __m256i b1 = _mm256_loadu_si256((const __m256i *)(buff2 + i + 32));
+
+        _mm256_storeu_si256((__m256i *)(xor + i), _mm256_xor_si256(a0, b0));
+        _mm256_storeu_si256((__m256i *)(xor + i + 32),
+                            _mm256_xor_si256(a1, b1));
+    }
+
+    xor_sse2(buff1 + i, buff2 + i, xor + i, count - i);
+}
+
+__attribute__((target("avx512f")))
+static void xor_avx512(const char *buff1, const char *buff2, char *xor,
+                       size_t count)
+{
+    size_t i;
+
+    for (i = 0; i + 2 * sizeof(__m512i) <= count; i += 2 * sizeof(__m512i)) {
+        __m512i a0 = _mm512_loadu_si512(buff1 + i);
+        __m512i a1 = _mm512_loadu_si512(buff1 + i + 64);
+        __m512i b0 = _mm512_loadu_si512(buff2 + i);
+        __m512i b1 = _mm512_loadu_si512(buff2 + i + 64);
+
+        _mm512_storeu_si512(xor + i, _mm512_xor_si512(a0, b0));
+        _mm512_storeu_si512(xor + i + 64, _mm512_xor_si512(a1, b1));
+    }
+
+    xor_avx2(buff1 + i, buff2 + i, xor + i, count - i);
+}
+#endif
+
+static const struct {
+    const char *name;
+    xor_func_t func;
+} XOR_IMPLS[] = {
+    /* Ordered from the fastest to the slowest */
+#ifdef XOR_X86
+    { "avx512", xor_avx512 },
+    { "avx2",   xor_avx2 },
+    { "sse2",   xor_sse2 },
+#endif
+    { "word",   xor_word },
+};
+
+#define N_XOR_IMPLS (sizeof(XOR_IMPLS) / sizeof(XOR_IMPLS[0]))
+
+static size_t xor_impl_index = N_XOR_IMPLS - 1;
+
+static bool xor_impl_supported(size_t index)
+{
+#ifdef XOR_X86
+    const char *name = XOR_IMPLS[index].name;
+
+    __builtin_cpu_init();
+    if (!strcmp(name, "avx512"))
+        return __builtin_cpu_supports("avx512f");
+    if (!strcmp(name, "avx2"))
+        return __builtin_cpu_supports("avx2");
+    if (!strcmp(name, "sse2"))
+        return __builtin_cpu_supports("sse2");
+#endif
+
+    return true;
+}
+
+/* Select the fastest implementation supported by the CPU when the module is
+ * loaded.
+ */
+__attribute__((constructor))
+static void buffer_xor_select(void)
+{
+    size_t i;
+
+    for (i = 0; i < N_XOR_IMPLS; i++) {
+        if (xor_impl_supported(i)) {
+            xor_impl_index = i;
+            return;
+        }
+    }
+}
+
+int buffer_xor_set_impl(const char *name)
+{
+    size_t i;
+
+    for (i = 0; i < N_XOR_IMPLS; i++) {
+        if (strcmp(XOR_IMPLS[i].name, name))
+            continue;
+
+        if (!xor_impl_supported(i))
+            return -ENOTSUP;
+
+        xor_impl_index = i;
+        return 0;
+    }
+
+    return -EINVAL;
+}
+
+const char *buffer_xor_impl(void)
+{
+    return XOR_IMPLS[xor_impl_index].name;
+}
+
+void buffer_xor(struct pho_buff *buff1, struct pho_buff *buff2,
+                struct pho_buff *xor, size_t count)
+{
+    XOR_IMPLS[xor_impl_index].func(buff1->buff, buff2->buff, xor->buff, count);
 }
@@ -0,0 +1,336 @@
+/* -*- mode: c; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief  GF(2^8) arithmetic and Reed-Solomon coding for the raid_ec layout
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "raid_ec.h"
+
+#include "pho_common.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GF_X86 1
+#endif
+
+/* x^8 + x^4 + x^3 + x^2 + 1, the usual Reed-Solomon polynomial, for which 2
+ * is a generator of the multiplicative group.
+ */
+#define GF_POLYNOMIAL 0x11d
+
+static uint8_t gf_exp[2 * 255];
+static uint8_t gf_log[256];
+
+__attribute__((constructor))
+static void gf256_init_tables(void)
+{
+    unsigned int x = 1;
+    int i;
+
+    for (i = 0; i < 255; i++) {
+        gf_exp[i] = x;
+        gf_exp[i + 255] = x;
+        gf_log[x] = i;
+        x <<= 1;
+        if (x & 0x100)
+            x ^= GF_POLYNOMIAL;
+    }
+}
+
+uint8_t gf256_mul(uint8_t a, uint8_t b)
+{
+    if (a == 0 || b == 0)
+        return 0;
+
+    return gf_exp[gf_log[a] + gf_log[b]];
+}
+
+uint8_t gf256_inv(uint8_t a)
+{
+    return gf_exp[255 - gf_log[a]];
+}
+
+typedef void (*gf_mul_add_func_t)(const char *src, char *dst,
+                                  const uint8_t *low, const uint8_t *high,
+                                  size_t size);
+
+/* Since the multiplication is linear, c * x = c * (x & 0x0f) ^ c * (x & 0xf0):
+ * all the kernels use two 16-entry tables, for the low and high nibbles.
+ */
+static void gf_mul_add_table(const char *src, char *dst, const uint8_t *low,
+                             const uint8_t *high, size_t size)
+{
+    uint8_t table[256];
+    size_t i;
+
+    for (i = 0; i < 256; i++)
+        table[i] = low[i & 0x0f] ^ high[i >> 4];
+
+    for (i = 0; i < size; i++)
+        dst[i] ^= table[(uint8_t)src[i]];
+}
+
+#ifdef GF_X86
+__attribute__((target("ssse3")))
+static void gf_mul_add_ssse3(const char *src, char *dst, const uint8_t *low,
+                             const uint8_t *high, size_t size)
+{
+    __m128i tlow = _mm_loadu_si128((const __m128i *)low);
+    __m128i thigh = _mm_loadu_si128((const __m128i *)high);
+    __m128i mask = _mm_set1_epi8(0x0f);
+    size_t i;
+
+    for (i = 0; i + sizeof(__m128i) <= size; i += sizeof(__m128i)) {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i lo = _mm_and_si128(s, mask);
+        __m128i hi = _mm_and_si128(_mm_srli_epi64(s, 4), mask);
+        __m128i p = _mm_xor_si128(_mm_shuffle_epi8(tlow, lo),
+                                  _mm_shuffle_epi8(thigh, hi));
+
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_xor_si128(d, p));
+    }
+
+    for (; i < size; i++) {
+        uint8_t s = src[i];
+
+        dst[i] ^= low[s & 0x0f] ^ high[s >> 4];
+    }
+}
+
+__attribute__((target("avx2")))
+static void gf_mul_add_avx2(const char *src, char *dst, const uint8_t *low,
+                            const uint8_t *high, size_t size)
+{
+    __m256i tlow = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128((const __m128i *)low));
+    __m256i thigh = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128((const __m128i *)high));
+    __m256i mask = _mm256_set1_epi8(0x0f);
+    size_t i;
+
+    for (i = 0; i + sizeof(__m256i) <= size; i += sizeof(__m256i)) {
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+        __m256i lo = _mm256_and_si256(s, mask);
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi64(s, 4), mask);
+        __m256i p = _mm256_xor_si256(_mm256_shuffle_epi8(tlow, lo),
+                                     _mm256_shuffle_epi8(thigh, hi));
+
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_xor_si256(d, p));
+    }
+
+    gf_mul_add_ssse3(src + i, dst + i, low, high, size - i);
+}
+#endif
+
+static const struct {
+    const char *name;
+    gf_mul_add_func_t func;
+} GF_IMPLS[] = {
+    /* Ordered from the fastest to the slowest */
+#ifdef GF_X86
+    { "avx2",   gf_mul_add_avx2 },
+    { "ssse3",  gf_mul_add_ssse3 },
+#endif
+    { "table",  gf_mul_add_table },
+};
+
+#define N_GF_IMPLS (sizeof(GF_IMPLS) / sizeof(GF_IMPLS[0]))
+
+static size_t gf_impl_index = N_GF_IMPLS - 1;
+
+static bool gf_impl_supported(size_t index)
+{
+#ifdef GF_X86
+    const char *name = GF_IMPLS[index].name;
+
+    __builtin_cpu_init();
+    if (!strcmp(name, "avx2"))
+        return __builtin_cpu_supports("avx2");
+    if (!strcmp(name, "ssse3"))
+        return __builtin_cpu_supports("ssse3");
+#endif
+
+    return true;
+}
+
+/* Select the fastest implementation supported by the CPU when the module is
+ * loaded.
+ */
+__attribute__((constructor))
+static void gf256_select(void)
+{
+    size_t i;
+
+    for (i = 0; i < N_GF_IMPLS; i++) {
+        if (gf_impl_supported(i)) {
+            gf_impl_index = i;
+            return;
+        }
+    }
+}
+
+int gf256_set_impl(const char *name)
+{
+    size_t i;
+
+    for (i = 0; i < N_GF_IMPLS; i++) {
+        if (strcmp(GF_IMPLS[i].name, name))
+            continue;
+
+        if (!gf_impl_supported(i))
+            return -ENOTSUP;
+
+        gf_impl_index = i;
+        return 0;
+    }
+
+    return -EINVAL;
+}
+
+const char *gf256_impl(void)
+{
+    return GF_IMPLS[gf_impl_index].name;
+}
+
+void gf256_mul_add_region(const char *src, char *dst, uint8_t coef,
+                          size_t size)
+{
+    uint8_t high[16];
+    uint8_t low[16];
+    int i;
+
+    if (coef == 0)
+        return;
+
+    for (i = 0; i < 16; i++) {
+        low[i] = gf256_mul(coef, i);
+        high[i] = gf256_mul(coef, i << 4);
+    }
+
+    GF_IMPLS[gf_impl_index].func(src, dst, low, high, size);
+}
+
+uint8_t rs_parity_coef(size_t n_data, size_t parity, size_t data)
+{
+    /* Cauchy matrix 1 / (x_i + y_j) with x_i = n_data + i and y_j = j, all
+     * distinct since n_data + n_parity <= 256.
+     */
+    return gf256_inv((n_data + parity) ^ data);
+}
+
+void rs_encode(size_t n_data, size_t n_parity, char * const *data,
+               char * const *parity, size_t size)
+{
+    size_t i;
+    size_t j;
+
+    for (i = 0; i < n_parity; i++) {
+        memset(parity[i], 0, size);
+        for (j = 0; j < n_data; j++)
+            gf256_mul_add_region(data[j], parity[i],
+                                 rs_parity_coef(n_data, i, j), size);
+    }
+}
+
+int rs_decode_matrix(size_t n_data, const size_t *positions, uint8_t *matrix)
+{
+    size_t width = 2 * n_data;
+    uint8_t *work;
+    size_t row;
+    size_t col;
+    size_t i;
+
+    /* Gauss-Jordan elimination on [generator rows of the blocks | identity] */
+    work = xcalloc(n_data * width, sizeof(*work));
+
+    for (row = 0; row < n_data; row++) {
+        for (col = 0; col < n_data; col++)
+            work[row * width + col] = positions[row] < n_data ?
+                positions[row] == col :
+                rs_parity_coef(n_data, positions[row] - n_data, col);
+
+        work[row * width + n_data + row] = 1;
+    }
+
+    for (col = 0; col < n_data; col++) {
+        uint8_t inv;
+
+        for (row = col; row < n_data; row++)
+            if (work[row * width + col])
+                break;
+
+        if (row == n_data) {
+            free(work);
+            return -EINVAL;
+        }
+
+        if (row != col) {
+            for (i = 0; i < width; i++) {
+                uint8_t tmp = work[row * width + i];
+
+                work[row * width + i] = work[col * width + i];
+                work[col * width + i] = tmp;
+            }
+        }
+
+        inv = gf256_inv(work[col * width + col]);
+        for (i = 0; i < width; i++)
+            work[col * width + i] = gf256_mul(work[col * width + i], inv);
+
+        for (row = 0; row < n_data; row++) {
+            uint8_t factor = work[row * width + col];
+
+            if (row == col || factor == 0)
+                continue;
+
+            for (i = 0; i < width; i++)
+                work[row * width + i] ^= gf256_mul(factor,
+                                                   work[col * width + i]);
+        }
+    }
+
+    for (row = 0; row < n_data; row++)
+        memcpy(matrix + row * n_data, work + row * width + n_data, n_data);
+
+    free(work);
+
+    return 0;
+}
+
+void rs_decode_block(size_t n_data, const uint8_t *row, char * const *blocks,
+                     char *output, size_t size)
+{
+    size_t i;
+
+    memset(output, 0, size);
+    for (i = 0; i < n_data; i++)
+        gf256_mul_add_region(blocks[i], output, row[i], size);
+}
@@ -0,0 +1,432 @@
+/* -*- mode: c; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief  Phobos Reed-Solomon erasure coding layout plugin
+ *
+ * Each split is made of k data extents and m parity extents. The data of the
+ * split is cut in stripes of k chunks, one per data extent, and the m parity
+ * chunks of each stripe are computed with a Reed-Solomon code over GF(2^8).
+ * Any k extents of a split are enough to read it back.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "raid_ec.h"
+
+#include "pho_module_loader.h"
+
+#include <errno.h>
+#include <glib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define PLUGIN_NAME     "raid_ec"
+#define PLUGIN_MAJOR    0
+#define PLUGIN_MINOR    1
+
+static struct module_desc RAID_EC_MODULE_DESC = {
+    .mod_name  = PLUGIN_NAME,
+    .mod_major = PLUGIN_MAJOR,
+    .mod_minor = PLUGIN_MINOR,
+};
+
+static struct raid_ops RAID_EC_OPS = {
+    .write_split    = raid_ec_write_split,
+    .read_split     = raid_ec_read_split,
+    .delete_split   = raid_delete_split,
+    .get_block_size = raid_ec_get_block_size,
+};
+
+static const struct pho_enc_ops RAID_EC_ENCODER_OPS = {
+    .step       = raid_encoder_step,
+    .destroy    = raid_encoder_destroy,
+};
+
+/**
+ * List of configuration parameters for this module
+ */
+enum pho_cfg_params_raid_ec {
+    /* Actual parameters */
+    PHO_CFG_LYT_RAID_EC_data_extents,
+    PHO_CFG_LYT_RAID_EC_parity_extents,
+    PHO_CFG_LYT_RAID_EC_extent_xxh128,
+    PHO_CFG_LYT_RAID_EC_extent_md5,
+    PHO_CFG_LYT_RAID_EC_extent_crc32c,
+    PHO_CFG_LYT_RAID_EC_check_hash,
+
+    /* Delimiters, update when modifying options */
+    PHO_CFG_LYT_RAID_EC_FIRST = PHO_CFG_LYT_RAID_EC_data_extents,
+    PHO_CFG_LYT_RAID_EC_LAST  = PHO_CFG_LYT_RAID_EC_check_hash,
+};
+
+const struct pho_config_item raid_ec_cfg_items[] = {
+    [PHO_CFG_LYT_RAID_EC_data_extents] = {
+        .section = "layout_raid_ec",
+        .name    = DATA_EXTENTS_ATTR_KEY,
+        .value   = "4",
+    },
+    [PHO_CFG_LYT_RAID_EC_parity_extents] = {
+        .section = "layout_raid_ec",
+        .name    = PARITY_EXTENTS_ATTR_KEY,
+        .value   = "2",
+    },
+    [PHO_CFG_LYT_RAID_EC_extent_xxh128] = {
+        .section = "layout_raid_ec",
+        .name    = "extent_xxh128",
+        .value   = DEFAULT_XXH128,
+    },
+    [PHO_CFG_LYT_RAID_EC_extent_md5] = {
+        .section = "layout_raid_ec",
+        .name    = "extent_md5",
+        .value   = DEFAULT_MD5,
+    },
+    [PHO_CFG_LYT_RAID_EC_extent_crc32c] = {
+        .section = "layout_raid_ec",
+        .name    = "extent_crc32c",
+        .value   = DEFAULT_CRC32C,
+    },
+    [PHO_CFG_LYT_RAID_EC_check_hash] = {
+        .section = "layout_raid_ec",
+        .name    = "check_hash",
+        .value   = DEFAULT_CHECK_HASH,
+    },
+};
+
+static int parse_extent_count(const char *value, const char *name,
+                              size_t *count)
+{
+    int64_t parsed;
+
+    if (value == NULL)
+        LOG_RETURN(-EINVAL, "raid_ec: '%s' is not set", name);
+
+    parsed = str2int64(value);
+    if (parsed <= 0 || parsed >= RAID_EC_MAX_EXTENTS)
+        LOG_RETURN(-EINVAL, "raid_ec: invalid value '%s' for '%s'", value,
+                   name);
+
+    *count = parsed;
+
+    return 0;
+}
+
+/**
+ * Get the number of data and parity extents of each split of \p layout.
+ */
+static int raid_ec_layout_geometry(struct layout_info *layout, size_t *n_data,
+                                   size_t *n_parity)
+{
+    int rc;
+
+    rc = parse_extent_count(pho_attr_get(&layout->layout_desc.mod_attrs,
+                                         PHO_EA_RAID_EC_DATA_EXTENTS_NAME),
+                            PHO_EA_RAID_EC_DATA_EXTENTS_NAME, n_data);
+    if (rc)
+        return rc;
+
+    rc = parse_extent_count(pho_attr_get(&layout->layout_desc.mod_attrs,
+                                         PHO_EA_RAID_EC_PARITY_EXTENTS_NAME),
+                            PHO_EA_RAID_EC_PARITY_EXTENTS_NAME, n_parity);
+    if (rc)
+        return rc;
+
+    if (*n_data + *n_parity > RAID_EC_MAX_EXTENTS)
+        LOG_RETURN(-EINVAL,
+                   "raid_ec: %zu data + %zu parity extents exceed the maximum "
+                   "of %d extents", *n_data, *n_parity, RAID_EC_MAX_EXTENTS);
+
+    return 0;
+}
+
+/**
+ * Get the geometry of a put from the layout parameters or the configuration,
+ * and save it in the layouts of the encoder.
+ */
+static int raid_ec_put_geometry(struct pho_encoder *enc, size_t *n_data,
+                                size_t *n_parity)
+{
+    struct pho_attrs *lyt_params = &enc->xfer->xd_params.put.lyt_params;
+    const char *parity = NULL;
+    const char *data = NULL;
+    int rc;
+    int i;
+
+    if (!pho_attrs_is_empty(lyt_params)) {
+        data = pho_attr_get(lyt_params, DATA_EXTENTS_ATTR_KEY);
+        parity = pho_attr_get(lyt_params, PARITY_EXTENTS_ATTR_KEY);
+    }
+
+    if (data == NULL)
+        data = PHO_CFG_GET(raid_ec_cfg_items, PHO_CFG_LYT_RAID_EC,
+                           data_extents);
+    if (parity == NULL)
+        parity = PHO_CFG_GET(raid_ec_cfg_items, PHO_CFG_LYT_RAID_EC,
+                             parity_extents);
+
+    if (data == NULL || parity == NULL)
+        LOG_RETURN(-EINVAL, "Unable to get the number of data and parity "
+                            "extents to build a raid_ec encoder");
+
+    for (i = 0; i < enc->xfer->xd_ntargets; i++) {
+        pho_attr_set(&enc->layout[i].layout_desc.mod_attrs,
+                     PHO_EA_RAID_EC_DATA_EXTENTS_NAME, data);
+        pho_attr_set(&enc->layout[i].layout_desc.mod_attrs,
+                     PHO_EA_RAID_EC_PARITY_EXTENTS_NAME, parity);
+
+        rc = raid_ec_layout_geometry(&enc->layout[i], n_data, n_parity);
+        if (rc)
+            return rc;
+    }
+
+    return 0;
+}
+
+static int layout_raid_ec_encode(struct pho_encoder *enc)
+{
+    struct raid_io_context *io_contexts;
+    struct raid_io_context *io_context;
+    size_t n_parity;
+    size_t n_data;
+    int i, j;
+    int rc;
+
+    ENTRY;
+
+    rc = raid_ec_put_geometry(enc, &n_data, &n_parity);
+    if (rc)
+        return rc;
+
+    io_contexts = xcalloc(enc->xfer->xd_ntargets, sizeof(*io_contexts));
+    enc->priv_enc = io_contexts;
+
+    for (i = 0; i < enc->xfer->xd_ntargets; i++) {
+        io_context = &io_contexts[i];
+        io_context->name = PLUGIN_NAME;
+        io_context->n_data_extents = n_data;
+        io_context->n_parity_extents = n_parity;
+        io_context->write.to_write = enc->xfer->xd_targets[i].xt_size;
+        io_context->nb_hashes = n_data + n_parity;
+        io_context->hashes = xcalloc(io_context->nb_hashes,
+                                     sizeof(*io_context->hashes));
+
+        for (j = 0; j < io_context->nb_hashes; j++) {
+            rc = extent_hash_init(&io_context->hashes[j],
+                              PHO_CFG_GET_BOOL(raid_ec_cfg_items,
+                                               PHO_CFG_LYT_RAID_EC,
+                                               extent_md5,
+                                               false),
+                              PHO_CFG_GET_BOOL(raid_ec_cfg_items,
+                                               PHO_CFG_LYT_RAID_EC,
+                                               extent_xxh128,
+                                               false),
+                              PHO_CFG_GET_BOOL(raid_ec_cfg_items,
+                                               PHO_CFG_LYT_RAID_EC,
+                                               extent_crc32c,
+                                               false));
+            if (rc)
+                goto out_hash;
+        }
+    }
+
+    return raid_encoder_init(enc, &RAID_EC_MODULE_DESC, &RAID_EC_ENCODER_OPS,
+                             &RAID_EC_OPS);
+
+out_hash:
+    for (j -= 1; j >= 0; j--)
+        extent_hash_fini(&io_contexts[i].hashes[j]);
+    io_contexts[i].nb_hashes = 0;
+
+    for (i -= 1; i >= 0; i--) {
+        io_context = &io_contexts[i];
+        for (j = 0; j < io_context->nb_hashes; j++)
+            extent_hash_fini(&io_context->hashes[j]);
+        io_context->nb_hashes = 0;
+    }
+
+    /* The rest will be free'd by layout_destroy */
+    return rc;
+}
+
+static int layout_raid_ec_decode(struct pho_encoder *dec)
+{
+    struct raid_io_context *io_context;
+    size_t n_parity;
+    size_t n_data;
+    size_t n_total;
+    int rc;
+    int i;
+
+    ENTRY;
+
+    rc = raid_ec_layout_geometry(dec->layout, &n_data, &n_parity);
+    if (rc)
+        LOG_RETURN(rc, "Invalid geometry from layout to build raid_ec decoder");
+
+    n_total = n_data + n_parity;
+    if (dec->layout->ext_count % n_total != 0)
+        LOG_RETURN(-EINVAL,
+                   "raid_ec layout extents count (%d) is not a multiple of %zu",
+                   dec->layout->ext_count, n_total);
+
+    io_context = xcalloc(1, sizeof(*io_context));
+    dec->priv_enc = io_context;
+    io_context->name = PLUGIN_NAME;
+    io_context->n_data_extents = n_data;
+    io_context->n_parity_extents = n_parity;
+
+    io_context->read.check_hash = PHO_CFG_GET_BOOL(raid_ec_cfg_items,
+                                                   PHO_CFG_LYT_RAID_EC,
+                                                   check_hash, true);
+
+    if (io_context->read.check_hash) {
+        io_context->nb_hashes = io_context->n_data_extents;
+        io_context->hashes = xcalloc(io_context->nb_hashes,
+                                     sizeof(*io_context->hashes));
+    }
+
+    rc = raid_decoder_init(dec, &RAID_EC_MODULE_DESC, &RAID_EC_ENCODER_OPS,
+                           &RAID_EC_OPS);
+    if (rc)
+        return rc;
+
+    /* The first data extent of a split is the largest one, and the size read
+     * for each split by raid_common is the size of the largest extent read.
+     */
+    for (i = 0; i < dec->layout->ext_count; i += n_total)
+        io_context->read.to_read += dec->layout->extents[i].size;
+
+    /* Empty GET does not need any IO */
+    if (io_context->read.to_read == 0)
+        dec->done = true;
+
+    return 0;
+}
+
+static int layout_raid_ec_delete(struct pho_encoder *dec)
+{
+    struct raid_io_context *io_context;
+    size_t n_parity;
+    size_t n_data;
+    int rc;
+
+    rc = raid_ec_layout_geometry(dec->layout, &n_data, &n_parity);
+    if (rc)
+        LOG_RETURN(rc, "Invalid geometry from layout to build raid_ec decoder");
+
+    io_context = xcalloc(1, sizeof(*io_context));
+    dec->priv_enc = io_context;
+    io_context->name = PLUGIN_NAME;
+    io_context->n_data_extents = n_data;
+    io_context->n_parity_extents = n_parity;
+
+    rc = raid_delete_decoder_init(dec, &RAID_EC_MODULE_DESC,
+                                  &RAID_EC_ENCODER_OPS, &RAID_EC_OPS);
+    if (rc) {
+        dec->priv_enc = NULL;
+        free(io_context);
+        return rc;
+    }
+
+    io_context->delete.to_delete = 0;
+    /* No hard removal on tapes */
+    if (dec->layout->ext_count != 0 &&
+        dec->layout->extents[0].media.family != PHO_RSC_TAPE)
+        io_context->delete.to_delete = dec->layout->ext_count;
+
+    if (io_context->delete.to_delete == 0)
+        dec->done = true;
+
+    return 0;
+}
+
+static int layout_raid_ec_locate(struct dss_handle *dss,
+                                 struct dss_locate_cache *cache,
+                                 struct layout_info *layout,
+                                 const char *focus_host,
+                                 char **hostname,
+                                 int *nb_new_lock)
+{
+    size_t n_parity;
+    size_t n_data;
+    int rc;
+
+    rc = raid_ec_layout_geometry(layout, &n_data, &n_parity);
+    if (rc)
+        LOG_RETURN(rc, "Invalid geometry from layout to locate");
+
+    return raid_locate(dss, cache, layout, n_data, n_parity, focus_host,
+                       hostname, nb_new_lock);
+}
+
+static const struct pho_layout_module_ops LAYOUT_RAID_EC_OPS = {
+    .encode = layout_raid_ec_encode,
+    .decode = layout_raid_ec_decode,
+    .delete = layout_raid_ec_delete,
+    .locate = layout_raid_ec_locate,
+    .get_specific_attrs = NULL,
+    .reconstruct = NULL,
+};
+
+/** Layout module registration entry point */
+int pho_module_register(void *module, void *context)
+{
+    struct layout_module *self = (struct layout_module *) module;
+
+    phobos_module_context_set(context);
+
+    self->desc = RAID_EC_MODULE_DESC;
+    self->ops = &LAYOUT_RAID_EC_OPS;
+
+    return 0;
+}
+
+int raid_ec_get_block_size(struct pho_encoder *enc, size_t *block_size)
+{
+    struct raid_io_context *io_context = enc->priv_enc;
+    struct extent *extent;
+    const char *attr;
+    int64_t value;
+
+    /* The chunk size is chosen per split on write, use the one of the split
+     * being read.
+     */
+    extent = io_context->read.extents[0];
+    attr = pho_attr_get(&extent->info, PHO_EA_RAID_EC_CHUNK_SIZE_NAME);
+    if (!attr)
+        LOG_RETURN(-EINVAL, "'%s' attribute not found on extent '%s'",
+                   PHO_EA_RAID_EC_CHUNK_SIZE_NAME, extent->uuid);
+
+    pho_debug("raid_ec: found block size '%s' for extent '%s'", attr,
+              extent->uuid);
+
+    value = str2int64(attr);
+    if (value <= 0)
+        LOG_RETURN(-EINVAL,
+                   "Invalid block size '%s' found in '%s' on extent '%s'. "
+                   "Expected a positive integer",
+                   attr, PHO_EA_RAID_EC_CHUNK_SIZE_NAME, extent->uuid);
+
+    *block_size = value;
+
+    return 0;
+}
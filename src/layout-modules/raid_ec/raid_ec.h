@@ -0,0 +1,142 @@
+/* -*- mode: c; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief  Phobos Reed-Solomon erasure coding layout plugin
+ */
+#ifndef _PHO_RAID_EC_H
+#define _PHO_RAID_EC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "raid_common.h"
+
+/**
+ * Extended attributes' names for the raid_ec layout
+ */
+#define PHO_EA_RAID_EC_DATA_EXTENTS_NAME    "raid_ec.data_extents"
+#define PHO_EA_RAID_EC_PARITY_EXTENTS_NAME  "raid_ec.parity_extents"
+#define PHO_EA_RAID_EC_CHUNK_SIZE_NAME      "raid_ec.chunk_size"
+
+/**
+ * Keys of the layout parameters given on put (--lyt-params)
+ */
+#define DATA_EXTENTS_ATTR_KEY               "data_extents"
+#define PARITY_EXTENTS_ATTR_KEY             "parity_extents"
+
+/**
+ * A stripe of a GF(2^8) Reed-Solomon code is made of k data blocks followed by
+ * m parity blocks. k + m must not exceed 256, the number of elements of the
+ * field.
+ */
+#define RAID_EC_MAX_EXTENTS                 256
+
+int raid_ec_write_split(struct pho_encoder *enc, size_t split_size,
+                        int target_idx);
+int raid_ec_read_split(struct pho_encoder *dec);
+int raid_ec_get_block_size(struct pho_encoder *enc, size_t *block_size);
+
+/**
+ * Multiply \p a by \p b in GF(2^8)
+ */
+uint8_t gf256_mul(uint8_t a, uint8_t b);
+
+/**
+ * Inverse of \p a in GF(2^8), \p a must not be 0
+ */
+uint8_t gf256_inv(uint8_t a);
+
+/**
+ * Compute dst ^= coef * src on \p size bytes in GF(2^8).
+ *
+ * The fastest implementation supported by the CPU is selected when the module
+ * is loaded (AVX2 or SSSE3 nibble lookups, or a portable table lookup).
+ */
+void gf256_mul_add_region(const char *src, char *dst, uint8_t coef,
+                          size_t size);
+
+/**
+ * Force the implementation used by gf256_mul_add_region().
+ *
+ * \param[in]  name    "avx2", "ssse3" or "table"
+ *
+ * \return 0 on success, -ENOTSUP if the CPU does not support it, -EINVAL if
+ *         the implementation does not exist.
+ */
+int gf256_set_impl(const char *name);
+
+/**
+ * Name of the implementation currently used by gf256_mul_add_region().
+ */
+const char *gf256_impl(void);
+
+/**
+ * Coefficient applied to the data block \p data to compute the parity block
+ * \p parity of a stripe of \p n_data data blocks.
+ *
+ * The parity rows form a Cauchy matrix, so that any n_data rows of the
+ * generator matrix (identity rows for the data blocks, followed by the parity
+ * rows) are linearly independent.
+ */
+uint8_t rs_parity_coef(size_t n_data, size_t parity, size_t data);
+
+/**
+ * Compute the \p n_parity parity blocks of a stripe.
+ *
+ * \param[in]   n_data      Number of data blocks
+ * \param[in]   n_parity    Number of parity blocks
+ * \param[in]   data        Data blocks, each of \p size bytes
+ * \param[out]  parity      Parity blocks, each of \p size bytes
+ * \param[in]   size        Size of the blocks
+ */
+void rs_encode(size_t n_data, size_t n_parity, char * const *data,
+               char * const *parity, size_t size);
+
+/**
+ * Build the matrix rebuilding the data blocks of a stripe from \p n_data of
+ * its blocks.
+ *
+ * \param[in]   n_data      Number of data blocks
+ * \param[in]   positions   Position of each available block in the stripe
+ *                          (data blocks first, then parity blocks)
+ * \param[out]  matrix      n_data x n_data matrix, row i gives the
+ *                          coefficients to apply to the available blocks to
+ *                          get the data block i
+ *
+ * \return 0 on success, -EINVAL if the blocks are not independent.
+ */
+int rs_decode_matrix(size_t n_data, const size_t *positions, uint8_t *matrix);
+
+/**
+ * Rebuild one data block of a stripe.
+ *
+ * \param[in]   n_data      Number of data blocks
+ * \param[in]   row         Row of the decode matrix for this data block
+ * \param[in]   blocks      Available blocks, in the order given to
+ *                          rs_decode_matrix(), each of \p size bytes
+ * \param[out]  output      Rebuilt data block
+ * \param[in]   size        Size of the blocks
+ */
+void rs_decode_block(size_t n_data, const uint8_t *row, char * const *blocks,
+                     char *output, size_t size);
+
+#endif
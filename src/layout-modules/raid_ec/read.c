@@ -0,0 +1,297 @@
+/* -*- mode: c; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief  Phobos Reed-Solomon erasure coding layout plugin
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "raid_ec.h"
+
+#include <unistd.h>
+
+/**
+ * State of the read of one split: which blocks of the stripes are read, and
+ * how to rebuild the missing data blocks from them.
+ */
+struct raid_ec_split {
+    size_t n_data;
+    size_t n_missing;
+    size_t *ext_sizes;          /**< Size of each data extent of the split */
+    ssize_t *slots;             /**< Index in the read extents of each data
+                                  *  extent, or -1 if it has to be rebuilt
+                                  */
+    size_t *missing;            /**< Data extents to rebuild */
+    uint8_t *matrix;            /**< Decode matrix, NULL if nothing is
+                                  *  missing
+                                  */
+};
+
+static void raid_ec_split_fini(struct raid_ec_split *split)
+{
+    free(split->ext_sizes);
+    free(split->slots);
+    free(split->missing);
+    free(split->matrix);
+}
+
+static int raid_ec_split_init(struct pho_encoder *dec,
+                              struct raid_ec_split *split)
+{
+    struct raid_io_context *io_context = dec->priv_enc;
+    size_t n_total = n_total_extents(io_context);
+    size_t n_data = io_context->n_data_extents;
+    struct extent *split_extents;
+    size_t *positions;
+    size_t i;
+    int rc;
+
+    split_extents = dec->layout->extents + io_context->current_split * n_total;
+
+    split->n_data = n_data;
+    split->n_missing = 0;
+    split->matrix = NULL;
+    split->ext_sizes = xcalloc(n_data, sizeof(*split->ext_sizes));
+    split->slots = xcalloc(n_data, sizeof(*split->slots));
+    split->missing = xcalloc(n_data, sizeof(*split->missing));
+    positions = xcalloc(n_data, sizeof(*positions));
+
+    for (i = 0; i < n_data; i++) {
+        split->ext_sizes[i] = split_extents[i].size;
+        split->slots[i] = -1;
+    }
+
+    /* The extents read are sorted by layout index, so the data extents come
+     * first, followed by the parity extents.
+     */
+    for (i = 0; i < n_data; i++) {
+        positions[i] = io_context->read.extents[i]->layout_idx % n_total;
+        if (positions[i] < n_data)
+            split->slots[positions[i]] = i;
+    }
+
+    for (i = 0; i < n_data; i++)
+        if (split->slots[i] == -1)
+            split->missing[split->n_missing++] = i;
+
+    rc = 0;
+    if (split->n_missing > 0) {
+        pho_verb("raid_ec: rebuilding %zu data extents of split %zu",
+                 split->n_missing, io_context->current_split);
+        split->matrix = xmalloc(n_data * n_data);
+        rc = rs_decode_matrix(n_data, positions, split->matrix);
+        if (rc)
+            pho_error(rc, "raid_ec: unable to invert the decode matrix");
+    }
+
+    free(positions);
+    if (rc)
+        raid_ec_split_fini(split);
+
+    return rc;
+}
+
+/**
+ * Size of the block of the data extent \p data in the stripe starting at
+ * \p offset, of \p stripe_size bytes.
+ */
+static size_t data_block_size(struct raid_ec_split *split, size_t data,
+                              size_t offset, size_t stripe_size)
+{
+    size_t ext_size = split->ext_sizes[data];
+
+    if (offset >= ext_size)
+        return 0;
+
+    return min(stripe_size, ext_size - offset);
+}
+
+static void submit_reads(struct raid_io_context *io_context,
+                         struct pho_buff *buffers, size_t size)
+{
+    bool check_hash = io_context->read.check_hash;
+    size_t i;
+
+    for (i = 0; i < io_context->n_data_extents; i++)
+        raid_io_pipeline_submit(&io_context->pipeline, i, RAID_IO_READ,
+                                &io_context->iods[i], buffers[i].buff, size,
+                                check_hash ? &io_context->hashes[i] : NULL);
+}
+
+static int check_hashes(struct raid_io_context *io_context)
+{
+    int rc;
+    int i;
+
+    if (!io_context->read.check_hash)
+        return 0;
+
+    for (i = 0; i < io_context->n_data_extents; i++) {
+        rc = extent_hash_digest(&io_context->hashes[i]);
+        if (rc)
+            return rc;
+
+        rc = extent_hash_compare(&io_context->hashes[i],
+                                 io_context->read.extents[i]);
+        if (rc)
+            return rc;
+    }
+
+    return 0;
+}
+
+/**
+ * Check the size of the blocks read for the stripe starting at \p offset and
+ * pad them with zeros up to \p stripe_size.
+ */
+static int check_and_pad(struct raid_io_context *io_context,
+                         struct raid_ec_split *split,
+                         struct pho_buff *buffers,
+                         size_t offset, size_t stripe_size)
+{
+    size_t n_total = n_total_extents(io_context);
+    size_t n_data = split->n_data;
+    size_t i;
+
+    for (i = 0; i < n_data; i++) {
+        size_t position = io_context->read.extents[i]->layout_idx % n_total;
+        ssize_t size = raid_io_pipeline_result(&io_context->pipeline, i);
+        size_t expected;
+
+        /* parity blocks have the size of the first data block */
+        expected = position < n_data ?
+            data_block_size(split, position, offset, stripe_size) :
+            stripe_size;
+
+        if (size < 0 || (size_t)size != expected)
+            LOG_RETURN(-EIO, "Read %zd bytes instead of %zu on extent '%s' "
+                       "at offset %zu", size, expected,
+                       io_context->read.extents[i]->uuid, offset);
+
+        memset(buffers[i].buff + size, 0, stripe_size - size);
+    }
+
+    return 0;
+}
+
+int raid_ec_read_split(struct pho_encoder *dec)
+{
+    struct raid_io_context *io_context = dec->priv_enc;
+    struct raid_io_pipeline *pipeline = &io_context->pipeline;
+    struct pho_io_descr *posix = &io_context->posix;
+    size_t n_total = n_total_extents(io_context);
+    size_t n_data = io_context->n_data_extents;
+    size_t buf_size = io_context->buffers[0].size;
+    char *blocks[RAID_EC_MAX_EXTENTS];
+    struct raid_ec_split split;
+    size_t offset = 0;
+    int cur = 0;
+    size_t i;
+    int rc;
+
+    ENTRY;
+
+    rc = raid_ec_split_init(dec, &split);
+    if (rc)
+        return rc;
+
+    if (split.ext_sizes[0] == 0)
+        goto out_split;
+
+    rc = raid_io_pipeline_start(pipeline, n_data);
+    if (rc)
+        goto out_split;
+
+    /* Double buffering: the blocks of one stripe are decoded and written to
+     * the output while the next stripe is read in the other set of buffers.
+     * The first n_data buffers of a set receive the blocks read, the next ones
+     * the rebuilt data blocks.
+     */
+    submit_reads(io_context, &io_context->buffers[0], buf_size);
+
+    while (true) {
+        struct pho_buff *buffers = &io_context->buffers[cur * n_total];
+        size_t stripe_size;
+        bool last;
+
+        rc = raid_io_pipeline_wait(pipeline);
+        if (rc)
+            LOG_GOTO(out, rc, "Failed to read file");
+
+        stripe_size = data_block_size(&split, 0, offset, buf_size);
+        last = offset + stripe_size >= split.ext_sizes[0];
+
+        rc = check_and_pad(io_context, &split, buffers, offset, stripe_size);
+        if (rc)
+            goto out;
+
+        /* Read the next stripe while this one is decoded and written */
+        if (!last)
+            submit_reads(io_context,
+                         &io_context->buffers[(1 - cur) * n_total], buf_size);
+
+        for (i = 0; i < n_data; i++)
+            blocks[i] = buffers[i].buff;
+
+        for (i = 0; i < split.n_missing; i++)
+            rs_decode_block(n_data, split.matrix + split.missing[i] * n_data,
+                            blocks, buffers[n_data + i].buff, stripe_size);
+
+        for (i = 0; i < n_data; i++) {
+            size_t size = data_block_size(&split, i, offset, stripe_size);
+            char *data;
+
+            if (size == 0)
+                continue;
+
+            if (split.slots[i] >= 0) {
+                data = buffers[split.slots[i]].buff;
+            } else {
+                size_t j;
+
+                for (j = 0; split.missing[j] != i; j++)
+                    ;
+                data = buffers[n_data + j].buff;
+            }
+
+            rc = ioa_write(posix->iod_ioa, posix, data, size);
+            if (rc)
+                LOG_GOTO(out, rc, "Failed to write in file");
+        }
+
+        offset += stripe_size;
+        if (last)
+            break;
+
+        cur = 1 - cur;
+    }
+
+out:
+    raid_io_pipeline_stop(pipeline);
+out_split:
+    raid_ec_split_fini(&split);
+    if (rc)
+        return rc;
+
+    return check_hashes(io_context);
+}
@@ -0,0 +1,203 @@
+/* -*- mode: c; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief  Phobos Reed-Solomon erasure coding layout plugin
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "raid_ec.h"
+
+#include <unistd.h>
+
+static int set_raid_ec_md(struct raid_io_context *io_context,
+                          size_t chunk_size)
+{
+    struct extent *extents = io_context->write.extents;
+    struct pho_io_descr *iods = io_context->iods;
+    char buff[64];
+    size_t i;
+    int rc;
+
+    rc = sprintf(buff, "%lu", chunk_size);
+    if (rc < 0)
+        LOG_RETURN(rc = -errno, "Unable to convert chunk size to string");
+
+    for (i = 0; i < n_total_extents(io_context); i++) {
+        pho_attr_set(&extents[i].info, PHO_EA_RAID_EC_CHUNK_SIZE_NAME, buff);
+        pho_attr_set(&iods[i].iod_attrs, PHO_EA_RAID_EC_CHUNK_SIZE_NAME,
+                     buff);
+    }
+
+    return 0;
+}
+
+/**
+ * Read the next stripe of the split from the source and compute its parity
+ * blocks.
+ *
+ * \param[in]      io_context      I/O context of the split
+ * \param[out]     buffers         Data blocks followed by the parity blocks
+ * \param[in/out]  buf_size        Size of the blocks to read, reduced for the
+ *                                 last stripe
+ * \param[in/out]  left_to_read    Size remaining to read in the split
+ * \param[out]     sizes           Size of each block to write
+ */
+static int read_and_encode(struct raid_io_context *io_context,
+                           struct pho_buff *buffers, size_t *buf_size,
+                           size_t *left_to_read, ssize_t *sizes)
+{
+    size_t n_parity = io_context->n_parity_extents;
+    size_t n_data = io_context->n_data_extents;
+    struct pho_io_descr *posix = &io_context->posix;
+    char *blocks[RAID_EC_MAX_EXTENTS];
+    size_t i;
+
+    if (*left_to_read < n_data * *buf_size)
+        /* spread the end of the split over all the data extents, otherwise
+         * the first ones would exceed the size allocated by the LRS
+         */
+        *buf_size = (*left_to_read + n_data - 1) / n_data;
+
+    for (i = 0; i < n_data; i++) {
+        size_t to_read = min(*buf_size, *left_to_read);
+
+        sizes[i] = 0;
+        if (to_read > 0) {
+            sizes[i] = ioa_read(posix->iod_ioa, posix, buffers[i].buff,
+                                to_read);
+            if (sizes[i] < 0)
+                LOG_RETURN(sizes[i],
+                           "Unable to read %zu bytes in raid_ec write",
+                           to_read);
+            if ((size_t)sizes[i] < to_read)
+                LOG_RETURN(-EIO, "Unexpected end of file after %zd of %zu "
+                           "bytes in raid_ec write", sizes[i], to_read);
+        }
+
+        *left_to_read -= sizes[i];
+
+        /* Pad the last blocks with zeros so that the parity is computed on
+         * blocks of the same size. Only the data actually read is written.
+         */
+        if (sizes[i] < sizes[0])
+            memset(buffers[i].buff + sizes[i], 0, sizes[0] - sizes[i]);
+
+        blocks[i] = buffers[i].buff;
+    }
+
+    for (i = 0; i < n_parity; i++) {
+        blocks[n_data + i] = buffers[n_data + i].buff;
+        sizes[n_data + i] = sizes[0];
+    }
+
+    rs_encode(n_data, n_parity, blocks, blocks + n_data, sizes[0]);
+
+    return 0;
+}
+
+int raid_ec_write_split(struct pho_encoder *enc, size_t split_size,
+                        int target_idx)
+{
+    struct raid_io_context *io_context =
+        &((struct raid_io_context *) enc->priv_enc)[target_idx];
+    struct raid_io_pipeline *pipeline = &io_context->pipeline;
+    size_t n_extents = n_total_extents(io_context);
+    size_t buf_size = io_context->buffers[0].size;
+    struct pho_io_descr *iods = io_context->iods;
+    ssize_t *sizes[2];
+    size_t left_to_read;
+    int cur = 0;
+    int rc = 0;
+    size_t i;
+    int rc2;
+
+    ENTRY;
+
+    left_to_read = min(split_size * io_context->n_data_extents,
+                       io_context->write.to_write);
+
+    rc = set_raid_ec_md(io_context, buf_size);
+    if (rc)
+        return rc;
+
+    sizes[0] = xcalloc(2 * n_extents, sizeof(*sizes[0]));
+    sizes[1] = sizes[0] + n_extents;
+
+    /* Double buffering: the blocks of one stripe are written to the extents
+     * while the next stripe is read and encoded in the other set of buffers.
+     */
+    rc = read_and_encode(io_context, &io_context->buffers[0], &buf_size,
+                         &left_to_read, sizes[cur]);
+    if (rc)
+        goto free_sizes;
+
+    rc = raid_io_pipeline_start(pipeline, n_extents);
+    if (rc)
+        goto free_sizes;
+
+    while (true) {
+        struct pho_buff *buffers = &io_context->buffers[cur * n_extents];
+        bool eof = (left_to_read == 0);
+
+        for (i = 0; i < n_extents; i++)
+            raid_io_pipeline_submit(pipeline, i, RAID_IO_WRITE, &iods[i],
+                                    buffers[i].buff, sizes[cur][i],
+                                    &io_context->hashes[i]);
+
+        if (!eof)
+            rc = read_and_encode(io_context,
+                                 &io_context->buffers[(1 - cur) * n_extents],
+                                 &buf_size, &left_to_read, sizes[1 - cur]);
+
+        rc2 = raid_io_pipeline_wait(pipeline);
+        if (rc2)
+            pho_error(rc2, "Unable to write %zu bytes in raid_ec write",
+                      sizes[cur][0]);
+        rc = rc ? : rc2;
+        if (rc || eof)
+            break;
+
+        cur = 1 - cur;
+    }
+
+    raid_io_pipeline_stop(pipeline);
+    if (rc)
+        goto free_sizes;
+
+    for (i = 0; i < io_context->nb_hashes; i++) {
+        rc = extent_hash_digest(&io_context->hashes[i]);
+        if (rc)
+            goto free_sizes;
+
+        rc = extent_hash_copy(&io_context->hashes[i],
+                              &io_context->write.extents[i]);
+        if (rc)
+            goto free_sizes;
+    }
+
+free_sizes:
+    free(sizes[0]);
+
+    return rc;
+}
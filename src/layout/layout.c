@@ -180,8 +180,9 @@ int layout_delete(struct pho_encoder *dec, struct pho_xfer_desc *xfer,
     return rc;
 }
 
-int layout_locate(struct dss_handle *dss, struct layout_info *layout,
-                  const char *focus_host, char **hostname, int *nb_new_lock)
+int layout_locate(struct dss_handle *dss, struct dss_locate_cache *cache,
+                  struct layout_info *layout, const char *focus_host,
+                  char **hostname, int *nb_new_lock)
 {
     char layout_name[NAME_MAX];
     struct layout_module *mod;
@@ -200,7 +201,8 @@ int layout_locate(struct dss_handle *dss, struct layout_info *layout,
     if (rc)
         return rc;
 
-    return mod->ops->locate(dss, layout, focus_host, hostname, nb_new_lock);
+    return mod->ops->locate(dss, cache, layout, focus_host, hostname,
+                            nb_new_lock);
 }
 
 int layout_get_specific_attrs(struct pho_io_descr *iod,
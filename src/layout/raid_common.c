@@ -23,6 +23,7 @@
 #endif
 
 #include <assert.h>
+#include <endian.h>
 #include <errno.h>
 #include <glib.h>
 #include <limits.h>
@@ -54,6 +55,12 @@ size_t n_total_extents(struct raid_io_context *io_context)
     return io_context->n_data_extents + io_context->n_parity_extents;
 }
 
+/* Two buffers per extent to allow double buffering in the layouts */
+static size_t n_buffers(struct raid_io_context *io_context)
+{
+    return 2 * n_total_extents(io_context);
+}
+
 static void free_extent_address_buff(void *void_extent)
 {
     struct extent *extent = void_extent;
@@ -155,7 +162,8 @@ int raid_encoder_init(struct pho_encoder *enc,
         io_context->iods = xcalloc(n_extents, sizeof(*io_context->iods));
         io_context->write.extents = xcalloc(n_extents,
                                             sizeof(*io_context->write.extents));
-        io_context->buffers = xmalloc(n_extents * sizeof(*io_context->buffers));
+        io_context->buffers = xmalloc(n_buffers(io_context) *
+                                      sizeof(*io_context->buffers));
     }
 
     return 0;
@@ -212,7 +220,6 @@ int raid_decoder_init(struct pho_encoder *dec,
                       const struct raid_ops *raid_ops)
 {
     struct raid_io_context *io_context = dec->priv_enc;
-    size_t n_extents = n_total_extents(io_context);
     int rc;
 
     if (dec->xfer->xd_targets->xt_fd < 0)
@@ -227,7 +234,8 @@ int raid_decoder_init(struct pho_encoder *dec,
                                sizeof(*io_context->iods));
     io_context->read.extents = xcalloc(io_context->n_data_extents,
                                        sizeof(*io_context->read.extents));
-    io_context->buffers = xmalloc(n_extents * sizeof(*io_context->buffers));
+    io_context->buffers = xmalloc(n_buffers(io_context) *
+                                  sizeof(*io_context->buffers));
 
     rc = init_posix_iod(dec, 0);
     if (rc) {
@@ -470,6 +478,26 @@ static size_t split_first_extent_index(struct pho_encoder *enc)
     return io_context->current_split * n_total_extents(io_context);
 }
 
+/**
+ * Position of \p extent on its medium as recorded by the I/O adapter when it
+ * was written, shifted by one so that 0 means unknown.
+ */
+static uint64_t extent_position(struct extent *extent)
+{
+    const char *value;
+    int64_t position;
+
+    value = pho_attr_get(&extent->info, PHO_EXT_INFO_POSITION_NAME);
+    if (!value)
+        return 0;
+
+    position = str2int64(value);
+    if (position < 0)
+        return 0;
+
+    return position + 1;
+}
+
 /** Generate the next read allocation request for this decoder */
 static void raid_build_read_allocation_req(struct pho_encoder *dec,
                                            pho_req_t *req)
@@ -495,6 +523,8 @@ static void raid_build_read_allocation_req(struct pho_encoder *dec,
             xstrdup(dec->layout->extents[ext_idx].media.name);
         req->ralloc->med_ids[i]->library =
             xstrdup(dec->layout->extents[ext_idx].media.library);
+        req->ralloc->positions[i] =
+            extent_position(&dec->layout->extents[ext_idx]);
     }
 }
 
@@ -629,8 +659,10 @@ static int write_split_setup(struct pho_encoder *enc, pho_resp_write_t *wresp,
     iods = io_context->iods;
 
     for (i = 0; i < n_extents; ++i) {
-        rc = get_io_adapter((enum fs_type)wresp->media[i]->fs_type,
-                            &iods[i].iod_ioa);
+        rc = get_io_adapter_for_family(
+            (enum fs_type)wresp->media[i]->fs_type,
+            (enum rsc_family)wresp->media[i]->med_id->family,
+            &iods[i].iod_ioa);
         if (rc)
             LOG_RETURN(rc, "Unable to get io_adapter in raid encoder");
 
@@ -653,7 +685,7 @@ static int write_split_setup(struct pho_encoder *enc, pho_resp_write_t *wresp,
     if (split_size < enc->io_block_size)
         enc->io_block_size = split_size;
 
-    for (i = 0; i < n_extents; i++)
+    for (i = 0; i < n_buffers(io_context); i++)
         pho_buff_alloc(&io_context->buffers[i], enc->io_block_size);
 
     for (i = 0; i < io_context->nb_hashes; i++) {
@@ -756,10 +788,11 @@ static int write_split_fini(struct pho_encoder *enc, int io_rc,
         io_context->current_split++;
     }
 
-    for (i = 0; i < n_extents; i++) {
+    for (i = 0; i < n_extents; i++)
         pho_attrs_free(&raid_enc_iod(enc, i, target_idx)->iod_attrs);
+
+    for (i = 0; i < n_buffers(io_context); i++)
         pho_buff_free(&io_context->buffers[i]);
-    }
 
     return rc;
 }
@@ -868,8 +901,10 @@ static int read_split_setup(struct pho_encoder *dec,
     for (i = 0; i < io_context->n_data_extents; i++) {
         ssize_t ext_index;
 
-        rc = get_io_adapter((enum fs_type)medium[i]->fs_type,
-                            &io_context->iods[i].iod_ioa);
+        rc = get_io_adapter_for_family(
+            (enum fs_type)medium[i]->fs_type,
+            (enum rsc_family)medium[i]->med_id->family,
+            &io_context->iods[i].iod_ioa);
         if (rc)
             return rc;
 
@@ -909,14 +944,25 @@ static int read_split_setup(struct pho_encoder *dec,
                   dec->io_block_size);
     }
 
-    for (i = 0; i < n_extents; i++)
+    for (i = 0; i < n_buffers(io_context); i++)
         pho_buff_alloc(&io_context->buffers[i], dec->io_block_size);
 
     if (io_context->read.check_hash) {
         for (i = 0; i < io_context->nb_hashes; i++) {
-            rc = extent_hash_init(&io_context->hashes[i],
-                                  io_context->read.extents[i]->with_md5,
-                                  io_context->read.extents[i]->with_xxh128);
+            struct extent *extent = io_context->read.extents[i];
+            bool use_xxh128 = false;
+            bool use_crc32c;
+            bool use_md5;
+
+            /* Checking one of the hashes is enough, use the fastest one */
+#if HAVE_XXH128
+            use_xxh128 = extent->with_xxh128;
+#endif
+            use_crc32c = !use_xxh128 && extent->with_crc32c;
+            use_md5 = !use_xxh128 && !use_crc32c && extent->with_md5;
+
+            rc = extent_hash_init(&io_context->hashes[i], use_md5, use_xxh128,
+                                  use_crc32c);
             if (rc)
                 return rc;
 
@@ -951,8 +997,10 @@ static int delete_split_setup(struct pho_encoder *dec,
     for (i = 0; i < n_extents; i++) {
         ssize_t ext_index;
 
-        rc = get_io_adapter((enum fs_type)medium[i]->fs_type,
-                            &io_context->iods[i].iod_ioa);
+        rc = get_io_adapter_for_family(
+            (enum fs_type)medium[i]->fs_type,
+            (enum rsc_family)medium[i]->med_id->family,
+            &io_context->iods[i].iod_ioa);
         if (rc)
             return rc;
 
@@ -1280,7 +1328,7 @@ skip_io:
         (*reqs)[*n_reqs].release->media[i]->to_sync = false;
     }
 
-    for (i = 0; i < n_total_extents(io_context); i++)
+    for (i = 0; i < n_buffers(io_context); i++)
         pho_buff_free(&io_context->buffers[i]);
 
     if (!rc) {
@@ -1363,6 +1411,22 @@ static int raid_enc_handle_resp(struct pho_encoder *enc, pho_resp_t *resp,
     int i;
 
     if (pho_response_is_error(resp)) {
+        /* No resource available yet: the allocation will be requested again
+         * by the caller once the store backed off.
+         */
+        if (resp->error->rc == -EAGAIN &&
+            (resp->error->req_kind == PHO_REQUEST_KIND__RQ_WRITE ||
+             resp->error->req_kind == PHO_REQUEST_KIND__RQ_READ)) {
+            pho_verb("%s %d will retry its %s", encoder_type2str(enc),
+                     resp->req_id, pho_srl_error_kind_str(resp->error));
+            for (i = 0; i < enc->xfer->xd_ntargets; i++) {
+                io_context = &((struct raid_io_context *) enc->priv_enc)[i];
+                io_context->requested_alloc = false;
+            }
+
+            return 0;
+        }
+
         enc->xfer->xd_rc = resp->error->rc;
         enc->done = true;
         LOG_RETURN(enc->xfer->xd_rc,
@@ -1491,7 +1555,466 @@ out:
     return rc;
 }
 
-int extent_hash_init(struct extent_hash *hash, bool use_md5, bool use_xxhash)
+/* Must be called with the pipeline mutex held */
+static void raid_hash_push(struct raid_io_worker *worker,
+                           struct extent_hash *hash, char *buff, size_t size,
+                           bool after_io)
+{
+    struct raid_hash_job *hash_job = xmalloc(sizeof(*hash_job));
+
+    hash_job->hash = hash;
+    hash_job->buff = buff;
+    hash_job->size = size;
+    hash_job->seq = worker->seq;
+    hash_job->after_io = after_io;
+
+    g_queue_push_tail(worker->hash_jobs, hash_job);
+    pthread_cond_broadcast(&worker->pipeline->hash_submitted);
+}
+
+static void raid_io_job_run(struct raid_io_worker *worker)
+{
+    struct raid_io_job *job = &worker->job;
+    size_t hashed_size;
+    int rc;
+
+    if (job->kind == RAID_IO_COPY) {
+        job->rc = ioa_write_from_fd(job->iod->iod_ioa, job->iod, job->src_fd,
+                                    job->src_offset, job->size);
+        if (job->rc == 0)
+            job->iod->iod_size += job->size;
+
+        return;
+    } else if (job->kind == RAID_IO_WRITE) {
+        job->rc = ioa_write(job->iod->iod_ioa, job->iod, job->buff, job->size);
+        if (job->rc)
+            return;
+
+        job->iod->iod_size += job->size;
+        hashed_size = job->size;
+    } else {
+        job->rc = ioa_read(job->iod->iod_ioa, job->iod, job->buff, job->size);
+        if (job->rc < 0)
+            return;
+
+        hashed_size = job->rc;
+    }
+
+    if (!job->hash)
+        return;
+
+    /* the block read is hashed while the next one is read */
+    if (worker->hasher_started) {
+        MUTEX_LOCK(&worker->pipeline->mutex);
+        raid_hash_push(worker, job->hash, job->buff, hashed_size, true);
+        MUTEX_UNLOCK(&worker->pipeline->mutex);
+        return;
+    }
+
+    rc = extent_hash_update(job->hash, job->buff, hashed_size);
+    if (rc)
+        job->rc = rc;
+}
+
+static void *raid_io_worker_routine(void *arg)
+{
+    struct raid_io_worker *worker = arg;
+    struct raid_io_pipeline *pipeline = worker->pipeline;
+
+    MUTEX_LOCK(&pipeline->mutex);
+    while (true) {
+        while (!worker->pending && !pipeline->stopping)
+            pthread_cond_wait(&pipeline->submitted, &pipeline->mutex);
+
+        /* pending jobs are completed before stopping */
+        if (!worker->pending)
+            break;
+
+        MUTEX_UNLOCK(&pipeline->mutex);
+        raid_io_job_run(worker);
+        MUTEX_LOCK(&pipeline->mutex);
+
+        worker->pending = false;
+        pipeline->n_pending--;
+        pthread_cond_signal(&pipeline->completed);
+    }
+    MUTEX_UNLOCK(&pipeline->mutex);
+
+    return NULL;
+}
+
+static void *raid_hasher_routine(void *arg)
+{
+    struct raid_io_worker *worker = arg;
+    struct raid_io_pipeline *pipeline = worker->pipeline;
+
+    MUTEX_LOCK(&pipeline->mutex);
+    while (true) {
+        struct raid_hash_job *hash_job;
+        int rc;
+
+        while (g_queue_is_empty(worker->hash_jobs) &&
+               !pipeline->hashers_stopping)
+            pthread_cond_wait(&pipeline->hash_submitted, &pipeline->mutex);
+
+        /* pending hashes are completed before stopping */
+        hash_job = g_queue_peek_head(worker->hash_jobs);
+        if (!hash_job)
+            break;
+
+        MUTEX_UNLOCK(&pipeline->mutex);
+        rc = extent_hash_update(hash_job->hash, hash_job->buff,
+                                hash_job->size);
+        MUTEX_LOCK(&pipeline->mutex);
+
+        if (rc)
+            worker->hash_rc = worker->hash_rc ? : rc;
+
+        g_queue_pop_head(worker->hash_jobs);
+        free(hash_job);
+        pthread_cond_signal(&pipeline->completed);
+    }
+    MUTEX_UNLOCK(&pipeline->mutex);
+
+    return NULL;
+}
+
+/* Start the hashing thread of a worker, its jobs are hashed inline if it
+ * cannot be started
+ */
+static void raid_hasher_start(struct raid_io_worker *worker)
+{
+    int rc;
+
+    rc = pthread_create(&worker->hasher_tid, NULL, raid_hasher_routine,
+                        worker);
+    if (rc) {
+        pho_warn("Unable to start raid hashing thread (%s), hashing in the "
+                 "I/O worker", strerror(rc));
+        return;
+    }
+
+    worker->hasher_started = true;
+}
+
+int raid_io_pipeline_start(struct raid_io_pipeline *pipeline,
+                           size_t n_workers)
+{
+    size_t i;
+    int rc;
+
+    pthread_mutex_init(&pipeline->mutex, NULL);
+    pthread_cond_init(&pipeline->submitted, NULL);
+    pthread_cond_init(&pipeline->completed, NULL);
+    pthread_cond_init(&pipeline->hash_submitted, NULL);
+    pipeline->workers = xcalloc(n_workers, sizeof(*pipeline->workers));
+    pipeline->n_workers = 0;
+    pipeline->n_pending = 0;
+    pipeline->stopping = false;
+    pipeline->hashers_stopping = false;
+
+    for (i = 0; i < n_workers; i++) {
+        struct raid_io_worker *worker = &pipeline->workers[i];
+
+        worker->pipeline = pipeline;
+        worker->hash_jobs = g_queue_new();
+        rc = pthread_create(&worker->tid, NULL, raid_io_worker_routine,
+                            worker);
+        if (rc) {
+            g_queue_free(worker->hash_jobs);
+            raid_io_pipeline_stop(pipeline);
+            LOG_RETURN(-rc, "Unable to start raid I/O worker %zu", i);
+        }
+
+        pipeline->n_workers++;
+    }
+
+    return 0;
+}
+
+static void raid_io_pipeline_push(struct raid_io_pipeline *pipeline,
+                                  size_t worker_idx, struct raid_io_job *job)
+{
+    struct raid_io_worker *worker;
+
+    assert(worker_idx < pipeline->n_workers);
+    worker = &pipeline->workers[worker_idx];
+
+    if (job->hash && !extent_hash_is_enabled(job->hash))
+        job->hash = NULL;
+
+    if (job->hash && !worker->hasher_started)
+        raid_hasher_start(worker);
+
+    MUTEX_LOCK(&pipeline->mutex);
+    assert(!worker->pending);
+
+    worker->seq++;
+
+    /* the data to write can be hashed while it is written */
+    if (job->hash && job->kind == RAID_IO_WRITE && worker->hasher_started) {
+        raid_hash_push(worker, job->hash, job->buff, job->size, false);
+        job->hash = NULL;
+    }
+
+    worker->job = *job;
+    worker->pending = true;
+    pipeline->n_pending++;
+    pthread_cond_broadcast(&pipeline->submitted);
+    MUTEX_UNLOCK(&pipeline->mutex);
+}
+
+void raid_io_pipeline_submit(struct raid_io_pipeline *pipeline, size_t worker,
+                             enum raid_io_kind kind, struct pho_io_descr *iod,
+                             char *buff, size_t size,
+                             struct extent_hash *hash)
+{
+    struct raid_io_job job = {
+        .kind = kind,
+        .iod = iod,
+        .buff = buff,
+        .src_fd = -1,
+        .size = size,
+        .hash = hash,
+    };
+
+    raid_io_pipeline_push(pipeline, worker, &job);
+}
+
+void raid_io_pipeline_submit_copy(struct raid_io_pipeline *pipeline,
+                                  size_t worker, struct pho_io_descr *iod,
+                                  int src_fd, off_t src_offset, size_t size)
+{
+    struct raid_io_job job = {
+        .kind = RAID_IO_COPY,
+        .iod = iod,
+        .src_fd = src_fd,
+        .src_offset = src_offset,
+        .size = size,
+    };
+
+    raid_io_pipeline_push(pipeline, worker, &job);
+}
+
+/* Whether the only hashes left are the ones of the last reads. Must be called
+ * with the pipeline mutex held.
+ */
+static bool raid_hashes_caught_up(struct raid_io_pipeline *pipeline)
+{
+    size_t i;
+
+    for (i = 0; i < pipeline->n_workers; i++) {
+        struct raid_io_worker *worker = &pipeline->workers[i];
+        struct raid_hash_job *oldest;
+
+        oldest = g_queue_peek_head(worker->hash_jobs);
+        if (oldest && !(oldest->after_io && oldest->seq == worker->seq))
+            return false;
+    }
+
+    return true;
+}
+
+int raid_io_pipeline_wait(struct raid_io_pipeline *pipeline)
+{
+    int rc = 0;
+    size_t i;
+
+    MUTEX_LOCK(&pipeline->mutex);
+    while (pipeline->n_pending > 0 || !raid_hashes_caught_up(pipeline))
+        pthread_cond_wait(&pipeline->completed, &pipeline->mutex);
+
+    for (i = 0; i < pipeline->n_workers; i++) {
+        if (pipeline->workers[i].job.rc < 0)
+            rc = rc ? : pipeline->workers[i].job.rc;
+        rc = rc ? : pipeline->workers[i].hash_rc;
+    }
+    MUTEX_UNLOCK(&pipeline->mutex);
+
+    return rc;
+}
+
+ssize_t raid_io_pipeline_result(struct raid_io_pipeline *pipeline,
+                                size_t worker)
+{
+    assert(worker < pipeline->n_workers);
+
+    return pipeline->workers[worker].job.rc;
+}
+
+void raid_io_pipeline_stop(struct raid_io_pipeline *pipeline)
+{
+    size_t i;
+
+    MUTEX_LOCK(&pipeline->mutex);
+    pipeline->stopping = true;
+    pthread_cond_broadcast(&pipeline->submitted);
+    MUTEX_UNLOCK(&pipeline->mutex);
+
+    for (i = 0; i < pipeline->n_workers; i++)
+        pthread_join(pipeline->workers[i].tid, NULL);
+
+    /* the workers do not submit hashes anymore */
+    MUTEX_LOCK(&pipeline->mutex);
+    pipeline->hashers_stopping = true;
+    pthread_cond_broadcast(&pipeline->hash_submitted);
+    MUTEX_UNLOCK(&pipeline->mutex);
+
+    for (i = 0; i < pipeline->n_workers; i++) {
+        struct raid_io_worker *worker = &pipeline->workers[i];
+
+        if (worker->hasher_started)
+            pthread_join(worker->hasher_tid, NULL);
+        g_queue_free(worker->hash_jobs);
+    }
+
+    free(pipeline->workers);
+    pipeline->workers = NULL;
+    pipeline->n_workers = 0;
+    pthread_cond_destroy(&pipeline->hash_submitted);
+    pthread_cond_destroy(&pipeline->completed);
+    pthread_cond_destroy(&pipeline->submitted);
+    pthread_mutex_destroy(&pipeline->mutex);
+}
+
+/* Size of the chunks given in turn to each digest of an extent hash */
+#define HASH_CHUNK_SIZE (64 * 1024)
+
+/* CRC32C (Castagnoli) polynomial, reversed */
+#define CRC32C_POLY 0x82f63b78
+
+static uint32_t crc32c_table[8][256];
+static pthread_once_t crc32c_once = PTHREAD_ONCE_INIT;
+static bool crc32c_hw;
+
+static void crc32c_init_tables(void)
+{
+    uint32_t crc;
+    int i, j;
+
+    for (i = 0; i < 256; i++) {
+        crc = i;
+        for (j = 0; j < 8; j++)
+            crc = (crc >> 1) ^ (crc & 1 ? CRC32C_POLY : 0);
+        crc32c_table[0][i] = crc;
+    }
+
+    for (i = 0; i < 256; i++) {
+        crc = crc32c_table[0][i];
+        for (j = 1; j < 8; j++) {
+            crc = crc32c_table[0][crc & 0xff] ^ (crc >> 8);
+            crc32c_table[j][i] = crc;
+        }
+    }
+
+#if defined(__x86_64__) && defined(__GNUC__)
+    crc32c_hw = __builtin_cpu_supports("sse4.2");
+#endif
+}
+
+/* Slicing-by-8, on the words read as little-endian as the CRC is reflected */
+static uint32_t crc32c_sw(uint32_t crc, const unsigned char *buffer,
+                          size_t size)
+{
+    while (size && ((uintptr_t)buffer & 7)) {
+        crc = crc32c_table[0][(crc ^ *buffer++) & 0xff] ^ (crc >> 8);
+        size--;
+    }
+
+    while (size >= 8) {
+        uint64_t word;
+
+        memcpy(&word, buffer, sizeof(word));
+        word = le64toh(word) ^ crc;
+        crc = crc32c_table[7][word & 0xff] ^
+              crc32c_table[6][(word >> 8) & 0xff] ^
+              crc32c_table[5][(word >> 16) & 0xff] ^
+              crc32c_table[4][(word >> 24) & 0xff] ^
+              crc32c_table[3][(word >> 32) & 0xff] ^
+              crc32c_table[2][(word >> 40) & 0xff] ^
+              crc32c_table[1][(word >> 48) & 0xff] ^
+              crc32c_table[0][word >> 56];
+        buffer += 8;
+        size -= 8;
+    }
+
+    while (size--)
+        crc = crc32c_table[0][(crc ^ *buffer++) & 0xff] ^ (crc >> 8);
+
+    return crc;
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+/* SSE 4.2 crc32 instruction, which computes the CRC32C */
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_hw_update(uint32_t crc, const unsigned char *buffer,
+                                 size_t size)
+{
+    uint64_t crc64 = crc;
+
+    while (size && ((uintptr_t)buffer & 7)) {
+        crc64 = __builtin_ia32_crc32qi(crc64, *buffer++);
+        size--;
+    }
+
+    while (size >= 8) {
+        uint64_t word;
+
+        memcpy(&word, buffer, sizeof(word));
+        crc64 = __builtin_ia32_crc32di(crc64, word);
+        buffer += 8;
+        size -= 8;
+    }
+
+    while (size--)
+        crc64 = __builtin_ia32_crc32qi(crc64, *buffer++);
+
+    return crc64;
+}
+#endif
+
+/* The CRC is kept inverted between updates */
+static uint32_t crc32c_update(uint32_t crc, const char *buffer, size_t size)
+{
+#if defined(__x86_64__) && defined(__GNUC__)
+    if (crc32c_hw)
+        return crc32c_hw_update(crc, (const unsigned char *)buffer, size);
+#endif
+
+    return crc32c_sw(crc, (const unsigned char *)buffer, size);
+}
+
+int extent_hash_crc32c_set_impl(const char *name)
+{
+    pthread_once(&crc32c_once, crc32c_init_tables);
+
+    if (!strcmp(name, "sw")) {
+        crc32c_hw = false;
+        return 0;
+    }
+
+    if (strcmp(name, "sse4.2"))
+        return -EINVAL;
+
+#if defined(__x86_64__) && defined(__GNUC__)
+    if (__builtin_cpu_supports("sse4.2")) {
+        crc32c_hw = true;
+        return 0;
+    }
+#endif
+
+    return -ENOTSUP;
+}
+
+const char *extent_hash_crc32c_impl(void)
+{
+    pthread_once(&crc32c_once, crc32c_init_tables);
+
+    return crc32c_hw ? "sse4.2" : "sw";
+}
+
+int extent_hash_init(struct extent_hash *hash, bool use_md5, bool use_xxhash,
+                     bool use_crc32c)
 {
     if (use_md5) {
         hash->md5context = EVP_MD_CTX_create();
@@ -1509,11 +2032,18 @@ int extent_hash_init(struct extent_hash *hash, bool use_md5, bool use_xxhash)
     (void) use_xxhash;
 #endif
 
+    if (use_crc32c) {
+        pthread_once(&crc32c_once, crc32c_init_tables);
+        hash->with_crc32c = true;
+    }
+
     return 0;
 }
 
 int extent_hash_reset(struct extent_hash *hash)
 {
+    hash->rc = 0;
+
     if (hash->md5context) {
         if (EVP_DigestInit_ex(hash->md5context, EVP_md5(), NULL) == 0)
             LOG_RETURN(-ENOMEM, " ");
@@ -1526,6 +2056,8 @@ int extent_hash_reset(struct extent_hash *hash)
     }
 #endif
 
+    hash->crc32c = ~0U;
+
     return 0;
 }
 
@@ -1539,7 +2071,8 @@ void extent_hash_fini(struct extent_hash *hash)
 #endif
 }
 
-int extent_hash_update(struct extent_hash *hash, char *buffer, size_t size)
+static int extent_hash_update_chunk(struct extent_hash *hash, char *buffer,
+                                    size_t size)
 {
     if (hash->md5context &&
         EVP_DigestUpdate(hash->md5context, buffer, size) == 0) {
@@ -1551,12 +2084,44 @@ int extent_hash_update(struct extent_hash *hash, char *buffer, size_t size)
         LOG_RETURN(-ENOMEM, "Unable to update XXHASH128");
     }
 #endif
+    if (hash->with_crc32c)
+        hash->crc32c = crc32c_update(hash->crc32c, buffer, size);
 
     return 0;
 }
 
+int extent_hash_update(struct extent_hash *hash, char *buffer, size_t size)
+{
+    size_t offset;
+    int rc;
+
+    for (offset = 0; offset < size; offset += HASH_CHUNK_SIZE) {
+        rc = extent_hash_update_chunk(hash, buffer + offset,
+                                      min(size - offset, HASH_CHUNK_SIZE));
+        if (rc) {
+            hash->rc = hash->rc ? : rc;
+            return rc;
+        }
+    }
+
+    return 0;
+}
+
+bool extent_hash_is_enabled(const struct extent_hash *hash)
+{
+#if HAVE_XXH128
+    if (hash->xxh128context)
+        return true;
+#endif
+
+    return hash->md5context != NULL || hash->with_crc32c;
+}
+
 int extent_hash_digest(struct extent_hash *hash)
 {
+    if (hash->rc)
+        LOG_RETURN(hash->rc, "Failed to hash the data of the extent");
+
     if (hash->md5context) {
         if (EVP_DigestFinal_ex(hash->md5context, hash->md5, NULL) == 0)
             LOG_RETURN(-ENOMEM, "Unable to produce MD5 hash");
@@ -1568,6 +2133,18 @@ int extent_hash_digest(struct extent_hash *hash)
     return 0;
 }
 
+/* Big endian representation of the CRC32C of \p hash */
+static void crc32c_canonical(const struct extent_hash *hash,
+                             unsigned char digest[CRC32C_BYTE_LENGTH])
+{
+    uint32_t crc = ~hash->crc32c;
+
+    digest[0] = crc >> 24;
+    digest[1] = crc >> 16;
+    digest[2] = crc >> 8;
+    digest[3] = crc;
+}
+
 int extent_hash_copy(struct extent_hash *hash, struct extent *extent)
 {
     if (hash->md5context) {
@@ -1585,6 +2162,11 @@ int extent_hash_copy(struct extent_hash *hash, struct extent *extent)
     }
 #endif
 
+    if (hash->with_crc32c) {
+        crc32c_canonical(hash, extent->crc32c);
+        extent->with_crc32c = true;
+    }
+
     return 0;
 }
 
@@ -1608,6 +2190,16 @@ int extent_hash_compare(struct extent_hash *hash, struct extent *extent)
             goto log_err;
     }
 #endif
+
+    if (hash->with_crc32c && extent->with_crc32c) {
+        unsigned char digest[CRC32C_BYTE_LENGTH];
+
+        crc32c_canonical(hash, digest);
+        rc = memcmp(digest, extent->crc32c, CRC32C_BYTE_LENGTH);
+        if (rc)
+            goto log_err;
+    }
+
     return 0;
 
 log_err:
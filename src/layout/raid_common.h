@@ -22,6 +22,7 @@
 #include "pho_layout.h"
 
 #include <openssl/evp.h>
+#include <pthread.h>
 #if HAVE_XXH128
 #include <xxhash.h>
 #endif
@@ -35,6 +36,8 @@
 #endif
 #define DEFAULT_CHECK_HASH "true"
 
+#define DEFAULT_CRC32C "false"
+
 struct extent_hash {
 #if HAVE_XXH128
     XXH128_hash_t xxh128;
@@ -42,6 +45,11 @@ struct extent_hash {
 #endif
     unsigned char md5[MD5_BYTE_LENGTH];
     EVP_MD_CTX   *md5context;
+    bool          with_crc32c;
+    uint32_t      crc32c;
+    int           rc;               /**< First error of an update, returned
+                                      *  by extent_hash_digest
+                                      */
 };
 
 struct read_io_context {
@@ -89,6 +97,90 @@ struct write_io_context {
     size_t n_released_media;
 };
 
+/**
+ * Kind of I/O performed on an extent by a raid_io_pipeline worker
+ */
+enum raid_io_kind {
+    RAID_IO_READ,
+    RAID_IO_WRITE,
+    RAID_IO_COPY,                   /**< Write from a file, see
+                                      *  ioa_write_from_fd
+                                      */
+};
+
+/**
+ * I/O to perform on one extent by a raid_io_pipeline worker
+ */
+struct raid_io_job {
+    enum raid_io_kind kind;
+    struct pho_io_descr *iod;       /**< I/O descriptor of the extent */
+    char *buff;                     /**< Data to write or buffer to read in */
+    int src_fd;                     /**< File to copy from */
+    off_t src_offset;               /**< Offset of the data to copy */
+    size_t size;                    /**< Size to write, read or copy */
+    struct extent_hash *hash;       /**< Hash to update with the data written
+                                      *  or read, may be NULL
+                                      */
+    ssize_t rc;                     /**< Number of bytes read, 0 on successful
+                                      *  write, -errno on failure
+                                      */
+};
+
+/**
+ * Data of a job to feed to its hash
+ */
+struct raid_hash_job {
+    struct extent_hash *hash;
+    char *buff;
+    size_t size;
+    size_t seq;                     /**< Sequence number of the I/O job */
+    bool after_io;                  /**< Whether the data is the one read by
+                                      *  the I/O job
+                                      */
+};
+
+struct raid_io_worker {
+    pthread_t tid;
+    struct raid_io_pipeline *pipeline;
+    struct raid_io_job job;
+    bool pending;                   /**< Whether job is to be run */
+    size_t seq;                     /**< Number of jobs submitted */
+
+    /* The hashes of the data of the jobs are computed by a second thread,
+     * started on the first job to hash, so that hashing a block overlaps
+     * with the I/O of the block (write) or of the next one (read).
+     */
+    pthread_t hasher_tid;
+    bool hasher_started;
+    GQueue *hash_jobs;              /**< raid_hash_job to run, in order */
+    int hash_rc;                    /**< First error of the hashes */
+};
+
+/**
+ * Set of worker threads, one per extent, used to perform the I/O of the
+ * extents of a split concurrently with each other and with the I/O on the
+ * xfer file descriptor.
+ *
+ * The layouts use it to write block N to the extents while block N + 1 is
+ * read from the source file, so that the time spent on a split is bounded by
+ * the slowest medium instead of the sum of all media.
+ */
+struct raid_io_pipeline {
+    pthread_mutex_t mutex;
+    pthread_cond_t submitted;       /**< Signaled when a job is submitted */
+    pthread_cond_t completed;       /**< Signaled when a job or a hash is
+                                      *  completed
+                                      */
+    pthread_cond_t hash_submitted;  /**< Signaled when a hash is submitted */
+    struct raid_io_worker *workers;
+    size_t n_workers;
+    size_t n_pending;               /**< Number of submitted jobs which are
+                                      *  not completed yet
+                                      */
+    bool stopping;
+    bool hashers_stopping;          /**< Set once the I/O workers are joined */
+};
+
 struct raid_io_context {
     /** Name of the RAID layout (stored on the medium) */
     const char *name;
@@ -98,8 +190,9 @@ struct raid_io_context {
      * encoder or not
      */
     bool requested_alloc;
-    /** Buffers used by the layout, only the layout knows how many buffer it
-     * allocates
+    /** Buffers used by the layout, two buffers per extent are allocated so
+     * that the layout can fill the second half while the first one is being
+     * read or written by the pipeline.
      */
     struct pho_buff *buffers;
     size_t current_split;
@@ -113,6 +206,8 @@ struct raid_io_context {
     struct pho_io_descr posix;
     /** I/O descriptors used to read or write extents */
     struct pho_io_descr *iods;
+    /** Workers performing the I/O on \p iods */
+    struct raid_io_pipeline pipeline;
     union {
         struct read_io_context read;
         struct delete_io_context delete;
@@ -169,30 +264,119 @@ int raid_delete_split(struct pho_encoder *dec);
  * n_parity_extents. It will locate an object whose layout requires
  * n_data_extents to be available on the host to be read. The total number of
  * extents of this object per split is n_data_extents + n_parity_extents.
+ *
+ * If \p cache is NULL, the media and devices are retrieved for this layout
+ * only.
  */
-int raid_locate(struct dss_handle *dss, struct layout_info *layout,
-                size_t n_data_extents, size_t n_parity_extents,
-                const char *focus_host, char **hostname,
-                int *nb_new_lock);
+int raid_locate(struct dss_handle *dss, struct dss_locate_cache *cache,
+                struct layout_info *layout, size_t n_data_extents,
+                size_t n_parity_extents, const char *focus_host,
+                char **hostname, int *nb_new_lock);
 
 void raid_encoder_destroy(struct pho_encoder *enc);
 
 size_t n_total_extents(struct raid_io_context *io_context);
 
-int extent_hash_init(struct extent_hash *hash, bool use_md5, bool use_xxhash);
+int extent_hash_init(struct extent_hash *hash, bool use_md5, bool use_xxhash,
+                     bool use_crc32c);
 
 int extent_hash_reset(struct extent_hash *hash);
 
 void extent_hash_fini(struct extent_hash *hash);
 
+/**
+ * Feed \p size bytes of \p buffer to all the digests of \p hash. The buffer is
+ * processed by chunks which fit in the CPU cache, each chunk being given to
+ * every digest in turn, so that the data is loaded from memory only once.
+ */
 int extent_hash_update(struct extent_hash *hash, char *buffer, size_t size);
 
+/** Whether \p hash computes any hash of the data */
+bool extent_hash_is_enabled(const struct extent_hash *hash);
+
 int extent_hash_digest(struct extent_hash *hash);
 
 int extent_hash_copy(struct extent_hash *hash, struct extent *extent);
 
 int extent_hash_compare(struct extent_hash *hash, struct extent *extent);
 
+/**
+ * Force the implementation of the CRC32C of the extent hashes.
+ *
+ * \param[in]  name    "sse4.2" or "sw" (slicing-by-8 tables)
+ *
+ * \return 0 on success, -ENOTSUP if the CPU does not support it, -EINVAL if
+ *         the implementation does not exist.
+ */
+int extent_hash_crc32c_set_impl(const char *name);
+
+/**
+ * Name of the implementation currently used for the CRC32C.
+ */
+const char *extent_hash_crc32c_impl(void);
+
+/**
+ * Start one I/O worker per extent.
+ *
+ * \param[out]  pipeline    Pipeline to initialize
+ * \param[in]   n_workers   Number of workers, worker i is meant to perform
+ *                          the I/O of extent i.
+ *
+ * \return 0 on success, -errno on failure.
+ */
+int raid_io_pipeline_start(struct raid_io_pipeline *pipeline,
+                           size_t n_workers);
+
+/**
+ * Submit an I/O to a worker. The worker must not have any pending job.
+ *
+ * On successful write, iod->iod_size is increased by \p size.
+ *
+ * If \p hash is not NULL, the data written or read is fed to it by the hashing
+ * thread of the worker: as soon as the job is submitted for a write, once
+ * the data is read for a read. The hashes of a worker are computed in the
+ * order of its jobs.
+ */
+void raid_io_pipeline_submit(struct raid_io_pipeline *pipeline, size_t worker,
+                             enum raid_io_kind kind, struct pho_io_descr *iod,
+                             char *buff, size_t size,
+                             struct extent_hash *hash);
+
+/**
+ * Submit to a worker the copy of \p size bytes of \p src_fd, from
+ * \p src_offset, to the extent of \p iod (see ioa_write_from_fd). The worker
+ * must not have any pending job.
+ *
+ * On success, iod->iod_size is increased by \p size.
+ */
+void raid_io_pipeline_submit_copy(struct raid_io_pipeline *pipeline,
+                                  size_t worker, struct pho_io_descr *iod,
+                                  int src_fd, off_t src_offset, size_t size);
+
+/**
+ * Wait for all the submitted jobs to complete, as well as their hashes,
+ * except the ones of the last read of each worker: that buffer may still be
+ * hashed while the caller consumes it, it must not be modified before the
+ * next call to this function. raid_io_pipeline_stop waits for all the
+ * hashes.
+ *
+ * \return 0 on success, the first error of the jobs or of the hashes
+ *         otherwise.
+ */
+int raid_io_pipeline_wait(struct raid_io_pipeline *pipeline);
+
+/**
+ * Result of the last job completed by a worker, i.e. the number of bytes read
+ * for a read, 0 for a successful write, -errno on failure.
+ */
+ssize_t raid_io_pipeline_result(struct raid_io_pipeline *pipeline,
+                                size_t worker);
+
+/**
+ * Complete the pending jobs and their hashes, and stop the workers.
+ */
+void raid_io_pipeline_stop(struct raid_io_pipeline *pipeline);
+
 struct pho_ext_loc make_ext_location(struct pho_encoder *enc, size_t i,
                                      int idx);
 
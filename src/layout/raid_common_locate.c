@@ -145,14 +145,26 @@ static void remove_extent_location(GPtrArray *extents, int index)
 }
 
 static int locate_all_extents(struct dss_handle *dss,
+                              struct dss_locate_cache *cache,
                               struct layout_info *layout,
                               GPtrArray *extents,
                               size_t extents_per_split)
 {
+    struct pho_id *medium_ids;
     int rc;
     int i;
     int j;
 
+    /* one query for the media of every extent not located yet */
+    medium_ids = xcalloc(layout->ext_count, sizeof(*medium_ids));
+    for (i = 0; i < layout->ext_count; i++)
+        medium_ids[i] = layout->extents[i].media;
+
+    rc = dss_locate_cache_load(dss, cache, medium_ids, layout->ext_count);
+    free(medium_ids);
+    if (rc)
+        return rc;
+
     for (i = 0; i < extents->len / extents_per_split; i++) {
         bool one_locate_succeeded = false;
 
@@ -165,8 +177,8 @@ static int locate_all_extents(struct dss_handle *dss,
             loc = extents->pdata[ext_index];
             medium_id = &layout->extents[ext_index].media;
 
-            rc = dss_medium_locate(dss, medium_id, &loc->hostname,
-                                   &loc->medium);
+            rc = dss_locate_cache_medium(dss, cache, medium_id,
+                                         &loc->hostname, &loc->medium);
             if (rc) {
                 pho_warn("Error when trying to locate medium "
                          "(family %s, name %s, library %s) of extent %lu : %s",
@@ -463,6 +475,7 @@ static char *find_best_host(GHashTable *hosts, GPtrArray *extents,
 }
 
 static void cleanup_locks(struct dss_handle *dss,
+                          struct dss_locate_cache *cache,
                           struct pho_id **medium_locked,
                           int nb_extents)
 {
@@ -485,6 +498,8 @@ static void cleanup_locks(struct dss_handle *dss,
 
         medium.rsc.id = *medium_locked[i];
         rc = dss_unlock(dss, DSS_MEDIA, &medium, 1, false);
+        if (!rc)
+            dss_locate_cache_set_host(cache, &medium.rsc.id, NULL);
         if (rc == -ENOLCK || rc == -EACCES)
             pho_warn("locate: failed to unlock reserved lock for ('%s', '%s'). "
                      "Lock was modified by someone else: %s",
@@ -502,6 +517,7 @@ static void cleanup_locks(struct dss_handle *dss,
  * on the selected host.
  */
 static int lock_extents(struct dss_handle *dss,
+                        struct dss_locate_cache *cache,
                         GPtrArray *extents,
                         int *nb_locks_per_split,
                         const char *hostname,
@@ -540,6 +556,7 @@ static int lock_extents(struct dss_handle *dss,
                 continue;
             }
 
+            dss_locate_cache_set_host(cache, &medium.rsc.id, hostname);
             nb_new_locks++;
             nb_locks_per_split[i]++;
             /* used for later cleanup in case of error */
@@ -549,7 +566,7 @@ static int lock_extents(struct dss_handle *dss,
         }
 
         if (nb_locks_per_split[i] < n_data_extents) {
-            cleanup_locks(dss, medium_locked, extents->len);
+            cleanup_locks(dss, cache, medium_locked, extents->len);
             LOG_RETURN(-EAGAIN, "locate: not enough locks where taken");
         }
     }
@@ -557,7 +574,8 @@ static int lock_extents(struct dss_handle *dss,
     return nb_new_locks;
 }
 
-static int reserve_locks(struct dss_handle *dss, GHashTable *hosts,
+static int reserve_locks(struct dss_handle *dss,
+                         struct dss_locate_cache *cache, GHashTable *hosts,
                          GPtrArray *extents, const char *hostname,
                          size_t n_data_extents, size_t n_parity_extents)
 {
@@ -579,15 +597,16 @@ static int reserve_locks(struct dss_handle *dss, GHashTable *hosts,
         }
     }
 
-    return lock_extents(dss, extents, nb_locks_per_split, hostname,
+    return lock_extents(dss, cache, extents, nb_locks_per_split, hostname,
                         n_data_extents, n_parity_extents);
 }
 
-int raid_locate(struct dss_handle *dss, struct layout_info *layout,
-                size_t n_data_extents, size_t n_parity_extents,
-                const char *focus_host, char **hostname,
-                int *nb_new_locks)
+int raid_locate(struct dss_handle *dss, struct dss_locate_cache *cache,
+                struct layout_info *layout, size_t n_data_extents,
+                size_t n_parity_extents, const char *focus_host,
+                char **hostname, int *nb_new_locks)
 {
+    struct dss_locate_cache local_cache;
     struct dev_info *devices;
     enum rsc_family family;
     GPtrArray *extents; /* struct extent_location */
@@ -601,16 +620,21 @@ int raid_locate(struct dss_handle *dss, struct layout_info *layout,
             LOG_RETURN(-EADDRNOTAVAIL, "Unable to get self hostname");
     }
 
+    if (!cache) {
+        dss_locate_cache_init(&local_cache);
+        cache = &local_cache;
+    }
+
     family = layout->extents[0].media.family;
-    rc = dss_get_usable_devices(dss, family, NULL, &devices, &n_devices);
+    rc = dss_locate_cache_devices(dss, cache, family, &devices, &n_devices);
     if (rc)
-        return rc;
+        goto free_cache;
 
     hosts = setup_available_hosts(devices, n_devices, layout->ext_count,
                                   focus_host);
     extents = setup_extent_location(layout);
 
-    rc = locate_all_extents(dss, layout, extents,
+    rc = locate_all_extents(dss, cache, layout, extents,
                             n_data_extents + n_parity_extents);
     if (rc)
         GOTO(clean, rc);
@@ -631,7 +655,7 @@ int raid_locate(struct dss_handle *dss, struct layout_info *layout,
     if (!*hostname)
         GOTO(clean, rc = -EAGAIN);
 
-    *nb_new_locks = reserve_locks(dss, hosts, extents, *hostname,
+    *nb_new_locks = reserve_locks(dss, cache, hosts, extents, *hostname,
                                  n_data_extents, n_parity_extents);
     if (*nb_new_locks < 0)
         rc = *nb_new_locks;
@@ -639,7 +663,10 @@ int raid_locate(struct dss_handle *dss, struct layout_info *layout,
 clean:
     g_ptr_array_free(extents, true);
     g_hash_table_destroy(hosts);
-    dss_res_free(devices, n_devices);
+
+free_cache:
+    if (cache == &local_cache)
+        dss_locate_cache_fini(&local_cache);
 
     return rc;
 }
@@ -35,6 +35,7 @@
 #include "pho_module_loader.h"
 
 #include <jansson.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <sys/stat.h>
@@ -57,6 +58,7 @@ enum pho_cfg_params_ltfs {
     PHO_CFG_LTFS_cmd_umount,
     PHO_CFG_LTFS_cmd_format,
     PHO_CFG_LTFS_cmd_release,
+    PHO_CFG_LTFS_max_concurrent_formats,
     PHO_CFG_LTFS_tape_full_threshold,
 
     /* Delimiters, update when modifying options */
@@ -86,6 +88,11 @@ const struct pho_config_item cfg_ltfs[] = {
         .name    = "cmd_release",
         .value   = PHO_LDM_HELPER" release_ltfs \"%s\""
     },
+    [PHO_CFG_LTFS_max_concurrent_formats] = {
+        .section = "ltfs",
+        .name    = "max_concurrent_formats",
+        .value   = "0"
+    },
     [PHO_CFG_LTFS_tape_full_threshold] = {
         .section = "tape",
         .name = "tape_full_threshold",
@@ -305,6 +312,49 @@ out_free:
     return rc;
 }
 
+/** Number of format commands in progress, bounded by max_concurrent_formats */
+static struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int count;
+} ltfs_formats = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+    .count = 0,
+};
+
+/**
+ * Wait until a new format command can be run. The device threads format their
+ * media concurrently, up to "max_concurrent_formats" (0 for no limit).
+ */
+static int ltfs_format_start(void)
+{
+    int max_formats;
+
+    max_formats = PHO_CFG_GET_INT(cfg_ltfs, PHO_CFG_LTFS,
+                                  max_concurrent_formats, -1);
+    if (max_formats < 0)
+        LOG_RETURN(-EINVAL, "Invalid value for ltfs max_concurrent_formats, "
+                   "expected a non-negative integer");
+
+    MUTEX_LOCK(&ltfs_formats.mutex);
+    while (max_formats > 0 && ltfs_formats.count >= max_formats)
+        pthread_cond_wait(&ltfs_formats.cond, &ltfs_formats.mutex);
+
+    ltfs_formats.count++;
+    MUTEX_UNLOCK(&ltfs_formats.mutex);
+
+    return 0;
+}
+
+static void ltfs_format_end(void)
+{
+    MUTEX_LOCK(&ltfs_formats.mutex);
+    ltfs_formats.count--;
+    pthread_cond_signal(&ltfs_formats.cond);
+    MUTEX_UNLOCK(&ltfs_formats.mutex);
+}
+
 static int ltfs_format(const char *dev_path, const char *label,
                        struct ldm_fs_space *fs_spc, json_t **message)
 {
@@ -324,8 +374,13 @@ static int ltfs_format(const char *dev_path, const char *label,
     if (fs_spc != NULL)
         memset(fs_spc, 0, sizeof(*fs_spc));
 
+    rc = ltfs_format_start();
+    if (rc)
+        goto out_free;
+
     /* Format the media */
     rc = context->mock_ltfs.mock_command_call(cmd, ltfs_format_filter, fs_spc);
+    ltfs_format_end();
     if (rc) {
         if (message)
             *message = json_pack("{s:s+}", "format",
@@ -56,16 +56,36 @@ struct pho_config_item cfg_io_sched[] = {
         .name    = "dispatch_algo",
         .value   = "none",
     },
+    [PHO_IO_SCHED_read_order] = {
+        .section = "io_sched",
+        .name    = "read_order",
+        .value   = "arrival",
+    },
+    [PHO_IO_SCHED_priority_algo] = {
+        .section = "io_sched",
+        .name    = "priority_algo",
+        .value   = NULL,    /* imposed by dispatch_algo */
+    },
+    [PHO_IO_SCHED_read_prefetch] = {
+        .section = "io_sched",
+        .name    = "read_prefetch",
+        .value   = "false",
+    },
 };
 
 static int io_sched_init(struct io_sched_handle *io_sched_hdl)
 {
     int rc;
 
+    io_sched_hdl->fair_queuing.clients = g_hash_table_new_full(g_direct_hash,
+                                                               g_direct_equal,
+                                                               NULL, free);
+    io_sched_hdl->fair_queuing.vtime = 0.0;
+
     io_sched_hdl->read.io_sched_hdl = io_sched_hdl;
     rc = io_sched_hdl->read.ops.init(&io_sched_hdl->read);
     if (rc)
-        return rc;
+        goto free_clients;
     io_sched_hdl->read.devices = g_ptr_array_new();
 
     io_sched_hdl->write.io_sched_hdl = io_sched_hdl;
@@ -88,6 +108,8 @@ write_fini:
 read_fini:
     g_ptr_array_free(io_sched_hdl->read.devices, TRUE);
     io_sched_hdl->read.ops.fini(&io_sched_hdl->read);
+free_clients:
+    g_hash_table_destroy(io_sched_hdl->fair_queuing.clients);
     return rc;
 }
 
@@ -101,6 +123,8 @@ void io_sched_fini(struct io_sched_handle *io_sched_hdl)
 
     io_sched_hdl->format.ops.fini(&io_sched_hdl->format);
     g_ptr_array_free(io_sched_hdl->format.devices, TRUE);
+
+    g_hash_table_destroy(io_sched_hdl->fair_queuing.clients);
 }
 
 int io_sched_dispatch_devices(struct io_sched_handle *io_sched_hdl,
@@ -109,9 +133,75 @@ int io_sched_dispatch_devices(struct io_sched_handle *io_sched_hdl,
     return io_sched_hdl->dispatch_devices(io_sched_hdl, devices);
 }
 
+/* Set the deadline and the virtual start time of \p reqc, see
+ * struct io_sched_fair_queuing.
+ */
+static void io_sched_tag_request(struct io_sched_handle *io_sched_hdl,
+                                 struct req_container *reqc)
+{
+    struct io_sched_fair_queuing *fq = &io_sched_hdl->fair_queuing;
+    gpointer client = GINT_TO_POINTER(reqc->socket_id);
+    pho_req_t *req = reqc->req;
+    unsigned int priority;
+    double *finish;
+
+    if (req->has_deadline_ms && req->deadline_ms > 0) {
+        struct timespec delay = {
+            .tv_sec = req->deadline_ms / 1000,
+            .tv_nsec = (req->deadline_ms % 1000) * 1000000,
+        };
+
+        reqc->deadline = add_timespec(&reqc->received_at, &delay);
+    } else {
+        reqc->deadline.tv_sec = 0;
+        reqc->deadline.tv_nsec = 0;
+    }
+
+    priority = req->has_priority ? req->priority : 0;
+
+    finish = g_hash_table_lookup(fq->clients, client);
+    if (!finish) {
+        finish = xmalloc(sizeof(*finish));
+        *finish = fq->vtime;
+        g_hash_table_insert(fq->clients, client, finish);
+    }
+
+    reqc->vstart = max(*finish, fq->vtime);
+    *finish = reqc->vstart + 1.0 / (1.0 + priority);
+}
+
+static gboolean glib_client_is_idle(gpointer key, gpointer value,
+                                    gpointer user_data)
+{
+    double *finish = value;
+    double *vtime = user_data;
+
+    (void) key;
+
+    return *finish <= *vtime;
+}
+
+/* \p reqc is being scheduled, advance the virtual time to its start time */
+static void io_sched_advance_vtime(struct io_sched_handle *io_sched_hdl,
+                                   struct req_container *reqc)
+{
+    struct io_sched_fair_queuing *fq = &io_sched_hdl->fair_queuing;
+
+    if (reqc->vstart <= fq->vtime)
+        return;
+
+    fq->vtime = reqc->vstart;
+    /* a client whose requests all started is tagged from vtime again */
+    g_hash_table_foreach_remove(fq->clients, glib_client_is_idle, &fq->vtime);
+}
+
 int io_sched_push_request(struct io_sched_handle *io_sched_hdl,
                           struct req_container *reqc)
 {
+    if (pho_request_is_read(reqc->req) || pho_request_is_write(reqc->req) ||
+        pho_request_is_format(reqc->req))
+        io_sched_tag_request(io_sched_hdl, reqc);
+
     if (pho_request_is_read(reqc->req)) {
         io_sched_hdl->io_stats.nb_reads++;
         pho_debug("lrs received read allocation request (%p)", reqc->req);
@@ -146,6 +236,8 @@ int io_sched_requeue(struct io_sched_handle *io_sched_hdl,
 int io_sched_remove_request(struct io_sched_handle *io_sched_hdl,
                          struct req_container *reqc)
 {
+    io_sched_advance_vtime(io_sched_hdl, reqc);
+
     if (pho_request_is_read(reqc->req)) {
         io_sched_hdl->io_stats.nb_reads--;
         return io_sched_hdl->read.ops.remove_request(&io_sched_hdl->read, reqc);
@@ -227,6 +319,21 @@ int io_sched_retry(struct io_sched_handle *io_sched_hdl,
     return io_sched->ops.retry(io_sched, sreq, dev);
 }
 
+int io_sched_prefetch(struct io_sched_handle *io_sched_hdl,
+                      struct lrs_dev **dev,
+                      struct media_info **medium)
+{
+    struct io_scheduler *io_sched = &io_sched_hdl->read;
+
+    *dev = NULL;
+    *medium = NULL;
+
+    if (!io_sched->ops.prefetch)
+        return 0;
+
+    return io_sched->ops.prefetch(io_sched, dev, medium);
+}
+
 int io_sched_remove_device(struct io_sched_handle *io_sched_hdl,
                            struct lrs_dev *device)
 {
@@ -335,6 +442,8 @@ static enum io_schedulers str2io_sched(const char *value)
         return IO_SCHED_FIFO;
     else if (!strcmp(value, "grouped_read"))
         return IO_SCHED_GROUPED_READ;
+    else if (!strcmp(value, "priority"))
+        return IO_SCHED_PRIORITY;
 
     return IO_SCHED_INVAL;
 }
@@ -361,10 +470,9 @@ int io_sched_cfg_section_name(enum rsc_family family, char **section_name)
     return 0;
 }
 
-static int
-io_sched_get_param_from_cfg(enum pho_cfg_params_io_sched type,
-                            enum rsc_family family,
-                            const char **value)
+int io_sched_get_param_from_cfg(enum pho_cfg_params_io_sched type,
+                                enum rsc_family family,
+                                const char **value)
 {
     char *section_name;
     int rc;
@@ -422,6 +530,9 @@ static int get_io_sched(struct io_sched_handle *io_sched_hdl,
     case IO_SCHED_GROUPED_READ:
         *ops = IO_SCHED_GROUPED_READ_OPS;
         break;
+    case IO_SCHED_PRIORITY:
+        *ops = IO_SCHED_PRIORITY_OPS;
+        break;
     default:
         return -EINVAL;
     }
@@ -441,8 +552,8 @@ static int set_dispatch_algorithm(struct io_sched_handle *io_sched_hdl,
         return rc;
 
     if (!strcmp(value, "none")) {
-        /* TODO load next_request from the configuration. For now, the dispatch
-         * algo imposes the next_request one so this is fine.
+        /* Unless priority_algo is set, the dispatch algo imposes the
+         * next_request one.
          */
         io_sched_hdl->next_request = fifo_next_request;
         io_sched_hdl->dispatch_devices = no_dispatch;
@@ -457,11 +568,38 @@ static int set_dispatch_algorithm(struct io_sched_handle *io_sched_hdl,
     return 0;
 }
 
+static int set_priority_algorithm(struct io_sched_handle *io_sched_hdl,
+                                  enum rsc_family family)
+{
+    const char *value;
+    int rc;
+
+    rc = io_sched_get_param_from_cfg(PHO_IO_SCHED_priority_algo, family,
+                                     &value);
+    if (rc == -ENODATA)
+        /* keep the one of the dispatch algo */
+        return 0;
+    if (rc)
+        return rc;
+
+    if (!strcmp(value, "fifo"))
+        io_sched_hdl->next_request = fifo_next_request;
+    else if (!strcmp(value, "round_robin"))
+        io_sched_hdl->next_request = round_robin;
+    else if (!strcmp(value, "priority"))
+        io_sched_hdl->next_request = priority_next_request;
+    else
+        LOG_RETURN(-EINVAL, "Unknown priority_algo '%s'", value);
+
+    return 0;
+}
+
 int io_sched_handle_load_from_config(struct io_sched_handle *io_sched_hdl,
                                      enum rsc_family family)
 {
     int rc;
 
+    io_sched_hdl->family = family;
     io_sched_hdl->read.type = IO_REQ_READ;
     io_sched_hdl->write.type = IO_REQ_WRITE;
     io_sched_hdl->format.type = IO_REQ_FORMAT;
@@ -482,6 +620,10 @@ int io_sched_handle_load_from_config(struct io_sched_handle *io_sched_hdl,
     if (rc)
         LOG_RETURN(rc, "Failed to read 'dispatch_algo' from config");
 
+    rc = set_priority_algorithm(io_sched_hdl, family);
+    if (rc)
+        LOG_RETURN(rc, "Failed to read 'priority_algo' from config");
+
     return io_sched_init(io_sched_hdl);
 }
 
@@ -50,6 +50,9 @@ enum pho_cfg_params_io_sched {
     PHO_IO_SCHED_write_algo,
     PHO_IO_SCHED_format_algo,
     PHO_IO_SCHED_dispatch_algo,
+    PHO_IO_SCHED_read_order,
+    PHO_IO_SCHED_priority_algo,
+    PHO_IO_SCHED_read_prefetch,
 
     PHO_IO_SCHED_LAST
 };
@@ -58,6 +61,7 @@ enum io_schedulers {
     IO_SCHED_INVAL = -1,
     IO_SCHED_FIFO,
     IO_SCHED_GROUPED_READ,
+    IO_SCHED_PRIORITY,
 };
 
 /**
@@ -124,6 +128,22 @@ struct io_scheduler_ops {
     int (*requeue)(struct io_scheduler *io_sched,
                    struct req_container *reqc);
 
+    /* Select a medium that the queued requests will need and an idle device
+     * where it can be loaded before these requests are scheduled. This
+     * callback is optional.
+     *
+     * \param[in]  io_sched  a valid io_scheduler
+     * \param[out] device    the device where to load \p medium, NULL if there
+     *                       is nothing to prefetch
+     * \param[out] medium    a new reference on the medium to load, to be
+     *                       released by the caller
+     *
+     * \return               0 on success, negative POSIX error code on failure
+     */
+    int (*prefetch)(struct io_scheduler *io_sched,
+                    struct lrs_dev **device,
+                    struct media_info **medium);
+
     /* Add a device to this I/O scheduler. This device can already be in the
      * I/O scheduler, it is up to this callback to check this.
      *
@@ -205,6 +225,25 @@ struct io_stats {
     size_t nb_formats;
 };
 
+/**
+ * State of the start-time fair queuing of the requests between the clients.
+ *
+ * Each read, write and format request is tagged on push with a virtual start
+ * time: the finish time of the previous request of the same client (socket),
+ * or the current virtual time if later. Its finish time is its start time plus
+ * 1 / (1 + priority). The virtual time is the start time of the last request
+ * scheduled. Serving the requests by increasing start time gives each active
+ * client a share of the devices proportional to 1 + priority, whatever the
+ * number of requests it has queued, and a request waiting for long enough
+ * always ends up being the next one.
+ */
+struct io_sched_fair_queuing {
+    GHashTable *clients;        /* socket ID -> finish time of the last request
+                                 * of this client (double *)
+                                 */
+    double vtime;               /* virtual time */
+};
+
 struct io_sched_handle {
     /**
      * Decide which request should be considered next. This callback will decide
@@ -255,6 +294,8 @@ struct io_sched_handle {
     GPtrArray          *global_device_list; /* reference to
                                              * lrs_sched::devices::ldh_devices
                                              */
+    enum rsc_family     family;
+    struct io_sched_fair_queuing fair_queuing;
 };
 
 /* I/O Scheduler interface */
@@ -397,6 +438,23 @@ int io_sched_retry(struct io_sched_handle *io_sched_hdl,
                    struct sub_request *sreq,
                    struct lrs_dev **dev);
 
+/*
+ * Ask the read scheduler for a medium that its queued requests will need and
+ * an idle device where to load it ahead of time, so that the robot move and
+ * the mount overlap with the I/Os of the other devices.
+ *
+ * \param[in]  io_sched_hdl  a valid I/O scheduler
+ * \param[out] dev           the device where to load \p medium, NULL if there
+ *                           is nothing to prefetch
+ * \param[out] medium        a new reference on the medium to load, to be
+ *                           released by the caller
+ *
+ * \return                   0 on success, negative POSIX error on failure
+ */
+int io_sched_prefetch(struct io_sched_handle *io_sched_hdl,
+                      struct lrs_dev **dev,
+                      struct media_info **medium);
+
 /* Remove a specific device from the I/O schedulers that own it
  *
  * \param[in]  io_sched_hdl a valid io_sched_handle
@@ -458,4 +516,17 @@ size_t io_sched_count_device_per_techno(struct io_scheduler *io_sched,
 
 int io_sched_cfg_section_name(enum rsc_family family, char **section_name);
 
+/**
+ * Get the value of an I/O scheduler parameter from the section of \p family.
+ *
+ * \param[in]   type    parameter to get
+ * \param[in]   family  family of the I/O schedulers
+ * \param[out]  value   value of the parameter
+ *
+ * \return              0 on success, negative POSIX error code on failure
+ */
+int io_sched_get_param_from_cfg(enum pho_cfg_params_io_sched type,
+                                enum rsc_family family,
+                                const char **value);
+
 #endif
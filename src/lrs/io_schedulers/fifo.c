@@ -20,7 +20,12 @@
  *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
  */
 /**
- * \brief  LRS FIFO I/O Scheduler
+ * \brief  LRS FIFO and priority I/O Schedulers
+ *
+ * Both schedulers keep their requests in a queue whose tail is the next
+ * request to schedule. The FIFO one queues them in arrival order. The priority
+ * one sorts them by virtual start time (see struct io_sched_fair_queuing), and
+ * schedules first the requests whose deadline is past.
  */
 #include <glib.h>
 #include <pthread.h>
@@ -38,6 +43,24 @@ struct queue_element {
     size_t num_media_allocated;
 };
 
+struct fifo_data {
+    GQueue *queue;
+    bool by_priority;           /* priority scheduler */
+    size_t n_deadlines;         /* number of queued requests with a deadline,
+                                 * only maintained by the priority scheduler
+                                 */
+};
+
+static GQueue *fifo_queue(struct io_scheduler *io_sched)
+{
+    return ((struct fifo_data *)io_sched->private_data)->queue;
+}
+
+static bool reqc_has_deadline(struct req_container *reqc)
+{
+    return reqc->deadline.tv_sec != 0 || reqc->deadline.tv_nsec != 0;
+}
+
 static void print_elem(gpointer data, gpointer user_data)
 {
     struct queue_element *elem = data;
@@ -53,24 +76,64 @@ static void print_queue(GQueue *queue)
     g_queue_foreach(queue, print_elem, NULL);
 }
 
-static int fifo_init(struct io_scheduler *io_sched)
+static int fifo_data_init(struct io_scheduler *io_sched, bool by_priority)
 {
-    io_sched->private_data = (void *)g_queue_new();
-    if (!io_sched->private_data)
-        return -ENOMEM;
+    struct fifo_data *data;
+
+    data = xmalloc(sizeof(*data));
+    data->queue = g_queue_new();
+    data->by_priority = by_priority;
+    data->n_deadlines = 0;
+
+    io_sched->private_data = data;
 
     return 0;
 }
 
+static int fifo_init(struct io_scheduler *io_sched)
+{
+    return fifo_data_init(io_sched, false);
+}
+
+static int priority_init(struct io_scheduler *io_sched)
+{
+    return fifo_data_init(io_sched, true);
+}
+
 static void fifo_fini(struct io_scheduler *io_sched)
 {
-    g_queue_free((GQueue *) io_sched->private_data);
-    return;
+    struct fifo_data *data = io_sched->private_data;
+
+    g_queue_free(data->queue);
+    free(data);
+}
+
+/* The queue is sorted from the head by decreasing urgency, so that the tail is
+ * the next request. Between equivalent requests, the new one goes after the
+ * queued ones.
+ */
+static gint glib_less_urgent(gconstpointer _elem, gconstpointer _new,
+                             gpointer user_data)
+{
+    const struct queue_element *elem = _elem;
+    const struct queue_element *new = _new;
+    const struct timespec *now = user_data;
+
+    return request_priority_cmp(elem->reqc, new->reqc, now) > 0 ? -1 : 1;
+}
+
+static void priority_insert(struct fifo_data *data, struct queue_element *elem)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    g_queue_insert_sorted(data->queue, elem, glib_less_urgent, &now);
 }
 
 static int fifo_push_request(struct io_scheduler *io_sched,
                              struct req_container *reqc)
 {
+    struct fifo_data *data = io_sched->private_data;
     struct queue_element *elem;
 
     elem = xmalloc(sizeof(*elem));
@@ -78,7 +141,13 @@ static int fifo_push_request(struct io_scheduler *io_sched,
     elem->reqc = reqc;
     elem->num_media_allocated = 0;
 
-    g_queue_push_head((GQueue *)io_sched->private_data, elem);
+    if (data->by_priority) {
+        priority_insert(data, elem);
+        if (reqc_has_deadline(reqc))
+            data->n_deadlines++;
+    } else {
+        g_queue_push_head(data->queue, elem);
+    }
 
     pho_debug("Request %p pushed to fifo '%s' scheduler",
               reqc, pho_srl_request_kind_str(reqc->req));
@@ -100,34 +169,68 @@ static bool is_reqc_the_first_element(GQueue *queue, struct req_container *reqc)
 static int fifo_remove_request(struct io_scheduler *io_sched,
                                struct req_container *reqc)
 {
+    struct fifo_data *data = io_sched->private_data;
     struct queue_element *elem;
     GQueue *queue;
 
     pho_debug("Request %p will be removed from fifo '%s' scheduler",
               reqc, pho_srl_request_kind_str(reqc->req));
 
-    queue = (GQueue *) io_sched->private_data;
+    queue = data->queue;
 
     if (!is_reqc_the_first_element(queue, reqc))
         LOG_RETURN(-EINVAL, "element '%p' is not first, cannot remove it",
                    reqc);
 
     elem = g_queue_pop_tail(queue);
+    if (data->by_priority && reqc_has_deadline(reqc))
+        data->n_deadlines--;
     free(elem);
 
     return 0;
 }
 
+/* A request that cannot be scheduled yet must not prevent the others from
+ * being scheduled: it loses its turn, as if it was pushed again by its client,
+ * and its past deadline is dropped.
+ */
+static void priority_requeue(struct io_scheduler *io_sched,
+                             struct queue_element *elem)
+{
+    struct io_sched_fair_queuing *fq = &io_sched->io_sched_hdl->fair_queuing;
+    struct fifo_data *data = io_sched->private_data;
+    struct req_container *reqc = elem->reqc;
+    double vtime;
+
+    if (reqc_has_deadline(reqc)) {
+        struct timespec now;
+
+        clock_gettime(CLOCK_REALTIME, &now);
+        if (cmp_timespec(&reqc->deadline, &now) <= 0) {
+            reqc->deadline.tv_sec = 0;
+            reqc->deadline.tv_nsec = 0;
+            data->n_deadlines--;
+        }
+    }
+
+    vtime = max(reqc->vstart, fq->vtime);
+    reqc->vstart = vtime + 1.0 / (1.0 + (reqc->req->has_priority ?
+                                         reqc->req->priority : 0));
+
+    priority_insert(data, elem);
+}
+
 static int fifo_requeue(struct io_scheduler *io_sched,
                         struct req_container *reqc)
 {
+    struct fifo_data *data = io_sched->private_data;
     struct queue_element *elem;
     GQueue *queue;
 
     pho_debug("Request %p will be requeued into fifo '%s' scheduler",
               reqc, pho_srl_request_kind_str(reqc->req));
 
-    queue = (GQueue *) io_sched->private_data;
+    queue = data->queue;
     if (!is_reqc_the_first_element(queue, reqc))
         return -EINVAL;
 
@@ -136,17 +239,56 @@ static int fifo_requeue(struct io_scheduler *io_sched,
     /* reset internal state */
     elem->num_media_allocated = 0;
 
-    /* not FIFO but this is the current behavior */
-    g_queue_push_head(queue, elem);
+    if (data->by_priority)
+        priority_requeue(io_sched, elem);
+    else
+        /* not FIFO but this is the current behavior */
+        g_queue_push_head(queue, elem);
+
     return 0;
 }
 
+/* Move the request with the earliest past deadline, if any, to the tail */
+static void priority_schedule_late_request(struct fifo_data *data)
+{
+    GList *late = NULL;
+    struct timespec now;
+
+    if (data->n_deadlines == 0)
+        return;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    for (GList *iter = data->queue->head; iter; iter = iter->next) {
+        struct queue_element *elem = iter->data;
+
+        if (!reqc_has_deadline(elem->reqc) ||
+            cmp_timespec(&elem->reqc->deadline, &now) > 0)
+            continue;
+
+        if (!late ||
+            request_priority_cmp(elem->reqc,
+                                 ((struct queue_element *)late->data)->reqc,
+                                 &now) < 0)
+            late = iter;
+    }
+
+    if (!late || late == data->queue->tail)
+        return;
+
+    g_queue_unlink(data->queue, late);
+    g_queue_push_tail_link(data->queue, late);
+}
+
 static int fifo_peek_request(struct io_scheduler *io_sched,
                              struct req_container **reqc)
 {
+    struct fifo_data *data = io_sched->private_data;
     struct queue_element *elem;
 
-    elem = g_queue_peek_tail((GQueue *) io_sched->private_data);
+    if (data->by_priority)
+        priority_schedule_late_request(data);
+
+    elem = g_queue_peek_tail(data->queue);
     if (!elem) {
         *reqc = NULL;
         return 0;
@@ -469,7 +611,7 @@ static int fifo_get_device_medium_pair(struct io_scheduler *io_sched,
     GQueue *queue;
     int rc;
 
-    queue = (GQueue *) io_sched->private_data;
+    queue = fifo_queue(io_sched);
 
     if (pho_request_is_read(reqc->req) &&
         *reqc_get_medium_to_alloc(reqc, sreq.medium_index)) {
@@ -630,3 +772,18 @@ struct io_scheduler_ops IO_SCHED_FIFO_OPS = {
     .remove_device          = fifo_remove_device,
     .claim_device           = fifo_claim_device,
 };
+
+struct io_scheduler_ops IO_SCHED_PRIORITY_OPS = {
+    .init                   = priority_init,
+    .fini                   = fifo_fini,
+    .push_request           = fifo_push_request,
+    .remove_request         = fifo_remove_request,
+    .requeue                = fifo_requeue,
+    .peek_request           = fifo_peek_request,
+    .get_device_medium_pair = fifo_get_device_medium_pair,
+    .retry                  = fifo_retry,
+    .add_device             = fifo_add_device,
+    .get_device             = fifo_get_device,
+    .remove_device          = fifo_remove_device,
+    .claim_device           = fifo_claim_device,
+};
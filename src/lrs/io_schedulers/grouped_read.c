@@ -64,6 +64,23 @@
  * On remove_request, the request is removed from all the queues it belongs to.
  * If any of these queues are empty, it is removed from its associated device
  * and freed.
+ *
+ * By default, the requests of a queue are served in their arrival order. With
+ * "read_order = position", they are served in the order of the extents on the
+ * medium, as given by ralloc->positions, like an elevator: the requests after
+ * the last position read are served first by increasing position, then the
+ * ones before it in a new pass. A batch of reads on a tape is thus served in
+ * a single forward pass instead of seeking back and forth. Requests whose
+ * position is unknown are served at the end of the current pass.
+ *
+ * With "read_prefetch = true", the scheduler also looks ahead in its queues:
+ * the medium of the longest queue which is not loaded anywhere yet is loaded
+ * in an idle device (i.e. ready for scheduling, without a queue and whose
+ * medium, if any, is not needed by any queued request). This happens when the
+ * first request of the queue cannot be allocated yet, for instance because it
+ * needs more media than there are available devices. The robot move and the
+ * mount are thus overlapped with the I/Os of the other devices and the queue
+ * is associated to the device on the next peek_request, once it is loaded.
  */
 
 struct request_queue;
@@ -80,6 +97,12 @@ struct queue_element {
     struct list_pair     *pair;  /* pointer to a pair of lists shared between
                                   * each queue_element of the same request.
                                   */
+    uint64_t              position; /* position of the extent on the medium,
+                                     * UINT64_MAX if unknown
+                                     */
+    unsigned int          pass;  /* pass over the medium in which this element
+                                  * will be served
+                                  */
 };
 
 struct device;
@@ -99,6 +122,10 @@ struct request_queue {
                             * It is copied into rwalloc_params::media in
                             * grouped_get_device_medium_pair.
                             */
+    uint64_t           last_position; /* position of the last element served
+                                       * from this queue
+                                       */
+    unsigned int       pass;   /* pass of the last element served */
 };
 
 struct device {
@@ -126,6 +153,8 @@ struct grouped_data {
                                  * request_queue. Key is the medium_id
                                  */
     struct queue_element *current_elem;
+    bool by_position;           /* serve the queues in on-medium order */
+    bool prefetch;              /* load the media of the queues ahead of time */
 };
 
 /* Iterate over all the element in the GList \p list. \p var is used as the
@@ -150,12 +179,65 @@ static ssize_t reqc_get_medium_index_from_medium_id(struct req_container *reqc,
     return -1;
 }
 
+static int read_order_from_cfg(struct io_scheduler *io_sched,
+                               bool *by_position)
+{
+    const char *value;
+    int rc;
+
+    rc = io_sched_get_param_from_cfg(PHO_IO_SCHED_read_order,
+                                     io_sched->io_sched_hdl->family, &value);
+    if (rc)
+        return rc;
+
+    if (!strcmp(value, "position"))
+        *by_position = true;
+    else if (!strcmp(value, "arrival"))
+        *by_position = false;
+    else
+        LOG_RETURN(-EINVAL, "Invalid read_order '%s', expected 'arrival' or "
+                   "'position'", value);
+
+    return 0;
+}
+
+static int read_prefetch_from_cfg(struct io_scheduler *io_sched,
+                                  bool *prefetch)
+{
+    const char *value;
+    int rc;
+
+    rc = io_sched_get_param_from_cfg(PHO_IO_SCHED_read_prefetch,
+                                     io_sched->io_sched_hdl->family, &value);
+    if (rc)
+        return rc;
+
+    if (!strcmp(value, "true"))
+        *prefetch = true;
+    else if (!strcmp(value, "false"))
+        *prefetch = false;
+    else
+        LOG_RETURN(-EINVAL, "Invalid read_prefetch '%s', expected 'true' or "
+                   "'false'", value);
+
+    return 0;
+}
+
 static int grouped_init(struct io_scheduler *io_sched)
 {
     struct grouped_data *data;
     int rc;
 
     data = xmalloc(sizeof(*data));
+    data->current_elem = NULL;
+
+    rc = read_order_from_cfg(io_sched, &data->by_position);
+    if (rc)
+        GOTO(free_data, rc);
+
+    rc = read_prefetch_from_cfg(io_sched, &data->prefetch);
+    if (rc)
+        GOTO(free_data, rc);
 
     data->request_queues = g_hash_table_new(g_pho_id_hash, g_pho_id_equal);
     if (!data->request_queues)
@@ -332,6 +414,8 @@ request_queue_alloc(struct io_scheduler *io_sched,
 
     (*queue)->device = NULL;
     (*queue)->queue = g_queue_new();
+    (*queue)->last_position = 0;
+    (*queue)->pass = 0;
 
     g_hash_table_insert(data->request_queues, &(*queue)->medium_id, *queue);
 
@@ -798,6 +882,55 @@ static int allocate_queue_if_loaded(struct io_scheduler *io_sched,
     return 0;
 }
 
+/* Elements are served from the tail of the queue: sort them by decreasing
+ * (pass, position) from the head, and keep the arrival order between elements
+ * of the same pass and position.
+ */
+static gint glib_served_after(gconstpointer _elem, gconstpointer _new,
+                              gpointer user_data)
+{
+    const struct queue_element *elem = _elem;
+    const struct queue_element *new = _new;
+
+    (void) user_data;
+
+    if (elem->pass != new->pass)
+        return elem->pass > new->pass ? -1 : 1;
+
+    if (elem->position != new->position)
+        return elem->position > new->position ? -1 : 1;
+
+    /* new is served after the elements already in the queue */
+    return 1;
+}
+
+static void queue_insert_by_position(struct request_queue *queue,
+                                     struct queue_element *elem,
+                                     bool next_pass)
+{
+    /* an element behind the last position read waits for the next pass */
+    if (next_pass ||
+        (elem->position != UINT64_MAX && elem->position < queue->last_position))
+        elem->pass = queue->pass + 1;
+    else
+        elem->pass = queue->pass;
+
+    g_queue_insert_sorted(queue->queue, elem, glib_served_after, NULL);
+}
+
+/* ralloc->positions is only in the order of med_ids before the medium list of
+ * the request is reordered by the scheduler, which happens after the push.
+ */
+static uint64_t reqc_get_position(struct req_container *reqc, size_t index)
+{
+    pho_req_read_t *ralloc = reqc->req->ralloc;
+
+    if (index >= ralloc->n_positions || ralloc->positions[index] == 0)
+        return UINT64_MAX;
+
+    return ralloc->positions[index] - 1;
+}
+
 static int insert_request_in_medium_queue(struct io_scheduler *io_sched,
                                           struct queue_element *elem,
                                           size_t index)
@@ -818,8 +951,13 @@ static int insert_request_in_medium_queue(struct io_scheduler *io_sched,
         allocate_queue_if_loaded(io_sched, queue);
     }
 
-    g_queue_push_head(queue->queue, elem);
     elem->queue = queue;
+    if (data->by_position) {
+        elem->position = reqc_get_position(elem->reqc, index);
+        queue_insert_by_position(queue, elem, false);
+    } else {
+        g_queue_push_head(queue->queue, elem);
+    }
 
     return 0;
 }
@@ -936,6 +1074,13 @@ static int grouped_remove_request(struct io_scheduler *io_sched,
     assert(link);
 
     elem = link->data;
+    if (data->by_position) {
+        /* the medium is now positioned after this extent */
+        queue->pass = elem->pass;
+        if (elem->position != UINT64_MAX)
+            queue->last_position = elem->position;
+    }
+
     remove_elements_from_list(data, elem, elem->pair->used);
     remove_elements_from_list(data, elem, elem->pair->free);
 
@@ -983,7 +1128,10 @@ static int grouped_requeue(struct io_scheduler *io_sched,
                                              elem->pair->used);
             elem->pair->used = NULL;
 
-            g_queue_push_head(queue->queue, elem);
+            if (data->by_position)
+                queue_insert_by_position(queue, elem, true);
+            else
+                g_queue_push_head(queue->queue, elem);
         }
     }
 
@@ -1337,6 +1485,102 @@ static int grouped_retry(struct io_scheduler *io_sched,
     return 0;
 }
 
+/* An idle device can be given a medium to prefetch: it is ready for
+ * scheduling, compatible with \p queue, not associated to a queue and its
+ * medium, if any, is neither waiting for a sync nor needed by the queued
+ * requests.
+ */
+static struct device *find_idle_device(struct io_scheduler *io_sched,
+                                       struct request_queue *queue)
+{
+    struct grouped_data *data = io_sched->private_data;
+    int i;
+
+    for (i = 0; i < io_sched->devices->len; i++) {
+        struct media_info *medium;
+        struct device *dev;
+        bool is_compatible;
+        bool needed;
+
+        dev = g_ptr_array_index(io_sched->devices, i);
+        if (dev->queue || !dev_is_sched_ready(dev->device))
+            continue;
+
+        if (tape_drive_compat(queue->medium_info, dev->device,
+                              &is_compatible) || !is_compatible)
+            continue;
+
+        MUTEX_LOCK(&dev->device->ld_mutex);
+        needed = dev->device->ld_sync_params.tosync_array->len > 0;
+        MUTEX_UNLOCK(&dev->device->ld_mutex);
+        if (needed)
+            continue;
+
+        medium = atomic_dev_medium_get(dev->device);
+        needed = medium &&
+            g_hash_table_lookup(data->request_queues, &medium->rsc.id);
+        lrs_medium_release(medium);
+        if (!needed)
+            return dev;
+    }
+
+    return NULL;
+}
+
+static int grouped_prefetch(struct io_scheduler *io_sched,
+                            struct lrs_dev **dev,
+                            struct media_info **medium)
+{
+    struct grouped_data *data = io_sched->private_data;
+    struct request_queue *best = NULL;
+    struct device *best_device = NULL;
+    GHashTableIter iter;
+    gpointer value;
+
+    *dev = NULL;
+    *medium = NULL;
+
+    if (!data->prefetch)
+        return 0;
+
+    g_hash_table_iter_init(&iter, data->request_queues);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        struct request_queue *queue = value;
+        struct device *device;
+
+        if (queue->device)
+            continue;
+
+        if (best &&
+            g_queue_get_length(queue->queue) <= g_queue_get_length(best->queue))
+            continue;
+
+        /* already loaded, or being loaded, in a device */
+        if (search_in_use_medium(io_sched->io_sched_hdl->global_device_list,
+                                 queue->medium_id.name,
+                                 queue->medium_id.library, NULL))
+            continue;
+
+        device = find_idle_device(io_sched, queue);
+        if (!device)
+            continue;
+
+        best = queue;
+        best_device = device;
+    }
+
+    if (!best)
+        return 0;
+
+    *medium = lrs_medium_acquire(&best->medium_info->rsc.id);
+    if (!*medium)
+        return -errno;
+
+    *dev = best_device->device;
+
+    return 0;
+}
+
 static void grouped_add_device(struct io_scheduler *io_sched,
                                struct lrs_dev *new_device)
 {
@@ -1481,6 +1725,7 @@ struct io_scheduler_ops IO_SCHED_GROUPED_READ_OPS = {
     .peek_request           = grouped_peek_request,
     .get_device_medium_pair = grouped_get_device_medium_pair,
     .retry                  = grouped_retry,
+    .prefetch               = grouped_prefetch,
     .add_device             = grouped_add_device,
     .get_device             = grouped_get_device,
     .remove_device          = grouped_remove_device,
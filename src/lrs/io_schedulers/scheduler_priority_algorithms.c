@@ -109,3 +109,59 @@ struct req_container *round_robin(struct io_sched_handle *io_sched_hdl,
 
     return NULL;
 }
+
+static bool deadline_is_past(const struct req_container *reqc,
+                             const struct timespec *now)
+{
+    if (reqc->deadline.tv_sec == 0 && reqc->deadline.tv_nsec == 0)
+        return false;
+
+    return cmp_timespec(&reqc->deadline, now) <= 0;
+}
+
+int request_priority_cmp(const struct req_container *a,
+                         const struct req_container *b,
+                         const struct timespec *now)
+{
+    bool a_late = deadline_is_past(a, now);
+    bool b_late = deadline_is_past(b, now);
+
+    if (a_late != b_late)
+        return a_late ? -1 : 1;
+
+    if (a_late) {
+        int rc = cmp_timespec(&a->deadline, &b->deadline);
+
+        if (rc)
+            return rc;
+    }
+
+    if (a->vstart != b->vstart)
+        return a->vstart < b->vstart ? -1 : 1;
+
+    return cmp_timespec(&a->received_at, &b->received_at);
+}
+
+struct req_container *priority_next_request(
+    struct io_sched_handle *io_sched_hdl,
+    struct req_container *read,
+    struct req_container *write,
+    struct req_container *format)
+{
+    struct req_container *requests[] = { read, write, format };
+    struct req_container *best = NULL;
+    struct timespec now;
+    int i;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    for (i = 0; i < ARRAY_SIZE(requests); i++) {
+        if (!requests[i])
+            continue;
+
+        if (!best || request_priority_cmp(requests[i], best, &now) < 0)
+            best = requests[i];
+    }
+
+    return best;
+}
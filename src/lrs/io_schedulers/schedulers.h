@@ -29,6 +29,7 @@
 
 extern struct io_scheduler_ops IO_SCHED_FIFO_OPS;
 extern struct io_scheduler_ops IO_SCHED_GROUPED_READ_OPS;
+extern struct io_scheduler_ops IO_SCHED_PRIORITY_OPS;
 
 /********************************
  * Device dispatcher algorithms *
@@ -95,4 +96,31 @@ struct req_container *round_robin(struct io_sched_handle *io_sched_hdl,
                                   struct req_container *write,
                                   struct req_container *format);
 
+/**
+ * Compare the urgency of two requests: the ones whose deadline is past come
+ * first, by increasing deadline, then the others by increasing virtual start
+ * time (see struct io_sched_fair_queuing), then by arrival.
+ *
+ * \param[in]  a    first request
+ * \param[in]  b    second request
+ * \param[in]  now  current time
+ *
+ * \return          a negative value if \p a is to be scheduled before \p b, a
+ *                  positive one if \p b is to be scheduled first, 0 if they are
+ *                  equivalent
+ */
+int request_priority_cmp(const struct req_container *a,
+                         const struct req_container *b,
+                         const struct timespec *now);
+
+/**
+ * Return the most urgent request out of the 3, according to
+ * request_priority_cmp.
+ */
+struct req_container *priority_next_request(
+    struct io_sched_handle *io_sched_hdl,
+    struct req_container *read,
+    struct req_container *write,
+    struct req_container *format);
+
 #endif
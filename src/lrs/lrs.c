@@ -43,8 +43,27 @@
 #include "pho_type_utils.h"
 
 #include "lrs_cfg.h"
+#include "lrs_media_index.h"
 #include "lrs_sched.h"
 
+struct lrs;
+
+/**
+ * Communication worker: receives the requests of the clients it accepted and
+ * sends them their responses. The first worker is run by the main thread.
+ */
+struct lrs_comm_worker {
+    struct lrs           *lrs;
+    struct pho_comm_info  comm;                /*!< Socket poll of the worker */
+    struct tsqueue        response_queue;      /*!< Responses to the clients of
+                                                * this worker
+                                                */
+    pthread_t             tid;
+    bool                  started;             /*!< The worker has its own
+                                                * thread
+                                                */
+};
+
 /**
  * Local Resource Scheduler instance, composed of two parts:
  * - Scheduler: manages media and local devices for the actual IO
@@ -54,14 +73,25 @@
 struct lrs {
     struct lrs_sched     *sched[PHO_RSC_LAST]; /*!< Scheduler handles */
     struct pho_comm_info  comm;                /*!< Communication handle */
-    struct tsqueue        response_queue;      /*!< Response queue */
+    struct tsqueue        response_queue;      /*!< Responses of the
+                                                * schedulers, routed to the
+                                                * communication workers
+                                                */
+    struct lrs_comm_worker *workers;           /*!< Communication workers */
+    int                   n_workers;           /*!< Number of initialized
+                                                * workers
+                                                */
+    GHashTable           *clients;             /*!< Socket id -> worker
+                                                * receiving its requests
+                                                */
+    pthread_mutex_t       clients_mutex;       /*!< Protects clients */
+    pthread_mutex_t       configure_mutex;     /*!< Serializes configure
+                                                * requests
+                                                */
     bool                  stopped;             /*!< true when every I/O has been
                                                 * completed after the LRS
                                                 * stopped.
                                                 */
-    struct dss_handle     dss;                 /*!< DSS handle of the
-                                                * communication thread
-                                                */
     const char *lock_file;                     /*!< Daemon lock file path */
 };
 
@@ -328,14 +358,84 @@ cancel:
     return rc;
 }
 
-static int send_responses_from_queue(struct lrs *lrs)
+/* ****************************************************************************/
+/* Communication workers ******************************************************/
+/* ****************************************************************************/
+
+static void client_set_worker(struct lrs_comm_worker *worker, int socket_id)
+{
+    struct lrs *lrs = worker->lrs;
+
+    MUTEX_LOCK(&lrs->clients_mutex);
+    g_hash_table_insert(lrs->clients, GINT_TO_POINTER(socket_id), worker);
+    MUTEX_UNLOCK(&lrs->clients_mutex);
+}
+
+static void client_unset_worker(struct lrs_comm_worker *worker, int socket_id)
+{
+    struct lrs *lrs = worker->lrs;
+
+    MUTEX_LOCK(&lrs->clients_mutex);
+    /* the socket id may already be reused by a client of another worker */
+    if (g_hash_table_lookup(lrs->clients, GINT_TO_POINTER(socket_id)) ==
+            worker)
+        g_hash_table_remove(lrs->clients, GINT_TO_POINTER(socket_id));
+    MUTEX_UNLOCK(&lrs->clients_mutex);
+}
+
+static struct lrs_comm_worker *client_get_worker(struct lrs *lrs,
+                                                 int socket_id)
+{
+    struct lrs_comm_worker *worker;
+
+    MUTEX_LOCK(&lrs->clients_mutex);
+    worker = g_hash_table_lookup(lrs->clients, GINT_TO_POINTER(socket_id));
+    MUTEX_UNLOCK(&lrs->clients_mutex);
+
+    return worker;
+}
+
+/** Wake up a worker whose response queue is no longer empty */
+static void worker_wakeup(void *arg)
+{
+    struct lrs_comm_worker *worker = arg;
+
+    pho_comm_wakeup(&worker->comm);
+}
+
+/**
+ * Move the responses of the schedulers to the queue of the worker handling
+ * their client. The response queue of the LRS is only consumed by the first
+ * worker.
+ */
+static void route_responses(struct lrs_comm_worker *worker)
+{
+    struct lrs *lrs = worker->lrs;
+    struct resp_container *respc;
+
+    while ((respc = tsqueue_pop(&lrs->response_queue)) != NULL) {
+        struct lrs_comm_worker *owner;
+
+        owner = client_get_worker(lrs, respc->socket_id);
+        /* the client is gone, let this worker report the failed sending */
+        if (!owner)
+            owner = worker;
+
+        tsqueue_push(&owner->response_queue, respc);
+    }
+}
+
+static int send_responses_from_queue(struct lrs_comm_worker *worker)
 {
     struct resp_container *respc;
     int rc = 0;
     int rc2;
 
-    while ((respc = tsqueue_pop(&lrs->response_queue)) != NULL) {
-        rc2 = _send_message(&lrs->comm, respc);
+    if (worker == worker->lrs->workers)
+        route_responses(worker);
+
+    while ((respc = tsqueue_pop(&worker->response_queue)) != NULL) {
+        rc2 = _send_message(&worker->comm, respc);
         rc = rc ? : rc2;
         sched_resp_free_with_cont(respc);
     }
@@ -485,21 +585,21 @@ static void init_request_container_param(struct req_container *reqc)
         reqc->params.notify.notified_device = NULL;
 }
 
-static int update_phys_spc_free(struct dss_handle *dss,
-                                struct media_info *dss_media_info,
-                                size_t written_size)
+/* The update is written by the scheduler DSS writer, so that the
+ * communication thread does not wait for the database.
+ */
+static void update_phys_spc_free(struct dss_async *dss_async,
+                                 struct media_info *dss_media_info,
+                                 size_t written_size)
 {
     if (written_size > 0) {
         dss_media_info->stats.phys_spc_free -= written_size;
-        return dss_media_update(dss, dss_media_info, dss_media_info, 1,
-                                PHYS_SPC_FREE);
+        dss_async_media_update(dss_async, dss_media_info, PHYS_SPC_FREE);
+        lrs_media_index_update(dss_media_info);
     }
-
-    return 0;
 }
 
 static int release_medium(struct lrs_sched *sched,
-                          struct dss_handle *comm_dss,
                           struct req_container *reqc,
                           pho_req_release_elt_t *release,
                           size_t medium_index,
@@ -535,8 +635,8 @@ static int release_medium(struct lrs_sched *sched,
     /* update media phys_spc_free stats in advance, before next sync */
     MUTEX_LOCK(&dev->ld_mutex);
     if (release->rc == 0)
-        rc = update_phys_spc_free(comm_dss, dev->ld_dss_media_info,
-                                  release->size_written);
+        update_phys_spc_free(sched->dss_async, dev->ld_dss_media_info,
+                             release->size_written);
 
     /* Acknowledgement of the request */
     dev->ld_ongoing_io = false;
@@ -563,7 +663,6 @@ static int release_medium(struct lrs_sched *sched,
  * an error message.
  */
 static int process_release_request(struct lrs_sched *sched,
-                                   struct dss_handle *comm_dss,
                                    struct req_container *reqc)
 {
     int release_index = -1;
@@ -576,8 +675,8 @@ static int process_release_request(struct lrs_sched *sched,
         pho_req_release_elt_t *release_elt = reqc->req->release->media[i];
         int req_rc = 0;
 
-        rc = release_medium(sched, comm_dss, reqc, release_elt,
-                            release_index + 1, &req_rc);
+        rc = release_medium(sched, reqc, release_elt, release_index + 1,
+                            &req_rc);
         if (rc)
             /* system error, stop */
             break;
@@ -783,7 +882,9 @@ static bool handle_quick_requests(struct lrs *lrs, struct req_container *reqc)
         sched_req_free(reqc);
         return true;
     } else if (pho_request_is_configure(reqc->req)) {
+        MUTEX_LOCK(&lrs->configure_mutex);
         _process_configure_request(lrs, reqc);
+        MUTEX_UNLOCK(&lrs->configure_mutex);
         sched_req_free(reqc);
         return true;
     } else {
@@ -795,9 +896,11 @@ static bool handle_quick_requests(struct lrs *lrs, struct req_container *reqc)
  * schedulers_to_signal is a bool array of length PHO_RSC_LAST, representing
  * every scheduler that could be signaled
  */
-static int _prepare_requests(struct lrs *lrs, bool *schedulers_to_signal,
+static int _prepare_requests(struct lrs_comm_worker *worker,
+                             bool *schedulers_to_signal,
                              const int n_data, struct pho_comm_data *data)
 {
+    struct lrs *lrs = worker->lrs;
     enum rsc_family fam;
     int rc = 0;
     int i;
@@ -806,8 +909,13 @@ static int _prepare_requests(struct lrs *lrs, bool *schedulers_to_signal,
         struct req_container *req_cont;
         int rc2;
 
-        if (data[i].buf.size == -1) /* close notification, ignore */
+        if (data[i].buf.size == -1) { /* close notification */
+            client_unset_worker(worker, data[i].fd);
             continue;
+        }
+
+        /* the responses to this client will be sent by this worker */
+        client_set_worker(worker, data[i].fd);
 
         req_cont = xcalloc(1, sizeof(*req_cont));
 
@@ -848,7 +956,7 @@ static int _prepare_requests(struct lrs *lrs, bool *schedulers_to_signal,
 
         init_request_container_param(req_cont);
         if (pho_request_is_release(req_cont->req)) {
-            rc2 = process_release_request(lrs->sched[fam], &lrs->dss, req_cont);
+            rc2 = process_release_request(lrs->sched[fam], req_cont);
             rc = rc ? : rc2;
             if (!rc2)
                 schedulers_to_signal[fam] = true;
@@ -929,6 +1037,208 @@ out_free:
     return rc;
 }
 
+/**
+ * Process pending requests from the unix socket and send the associated
+ * responses to clients.
+ *
+ * Requests are guaranteed to be answered at some point.
+ *
+ * TODO: we need to think about a way to avoid the EPIPE error in the future,
+ * due to a client departure before the release ack is sent.
+ * I got three ideas (the latter, the better):
+ * - consider that this EPIPE error is not critical and can happen if
+ *   the client does not care about the release acknowledgement;
+ * - consider a boolean 'send_resp' in the release message protocol to
+ *   indicate if the client need a response, and then send it if needed;
+ * - force the client to always receive the ack, but putting a boolean
+ *   'with_flush' in the release message protocol to let the client
+ *   be responded before or after a flush operation. If not, the client
+ *   only says to the LRS that its operation is done and that it does
+ *   not need the device anymore. The LRS sends its response once the
+ *   release request is received.
+ *
+ * \param[in]       worker      The worker that will handle the requests.
+ *
+ * \return                      0 on succes, -errno on failure.
+ */
+static int lrs_process(struct lrs_comm_worker *worker)
+{
+    bool schedulers_to_signal[PHO_RSC_LAST] = {false};
+    struct pho_comm_data *data = NULL;
+    struct lrs *lrs = worker->lrs;
+    int n_data;
+    int rc = 0;
+    int i;
+
+    /* request reception and accept handling */
+    rc = pho_comm_recv(&worker->comm, &data, &n_data);
+    if (rc) {
+        for (i = 0; i < n_data; ++i)
+            free(data[i].buf.buff);
+        free(data);
+        running = false;
+        LOG_GOTO(end, rc, "Error during request reception");
+    }
+
+    rc = _prepare_requests(worker, schedulers_to_signal, n_data, data);
+    free(data);
+    if (rc) {
+        running = false;
+        LOG_GOTO(end, rc, "Error during request enqueuing");
+    }
+
+    /* response processing */
+    for (i = 0; i < PHO_RSC_LAST; ++i) {
+        if (!lrs->sched[i])
+            continue;
+
+        if (schedulers_to_signal[i])
+            thread_signal(&lrs->sched[i]->sched_thread);
+    }
+
+end:
+    rc = send_responses_from_queue(worker);
+    if (rc)
+        running = false;
+
+    return rc;
+}
+
+/** Check that the LRS is stopping and that no device is still running */
+static bool lrs_devices_stopped(struct lrs *lrs)
+{
+    int i;
+
+    for (i = 0; i < PHO_RSC_LAST; ++i) {
+        if (!lrs->sched[i])
+            continue;
+
+        if (running || sched_has_running_devices(lrs->sched[i]))
+            return false;
+    }
+
+    return true;
+}
+
+static void *lrs_comm_worker_thread(void *arg)
+{
+    struct lrs_comm_worker *worker = arg;
+    bool last = false;
+
+    while (!last) {
+        /* one more round once the LRS is stopped, to send the last
+         * responses
+         */
+        last = !running && worker->lrs->stopped;
+        lrs_process(worker);
+    }
+
+    return NULL;
+}
+
+static int lrs_comm_workers_init(struct lrs *lrs)
+{
+    int n_workers;
+    int rc;
+    int i;
+
+    n_workers = PHO_CFG_GET_INT(cfg_lrs, PHO_CFG_LRS, comm_threads, 1);
+    if (n_workers < 1)
+        LOG_RETURN(-EINVAL, "Invalid number of communication threads %d, "
+                   "must be at least 1", n_workers);
+
+    lrs->workers = xcalloc(n_workers, sizeof(*lrs->workers));
+
+    for (lrs->n_workers = 0; lrs->n_workers < n_workers; lrs->n_workers++) {
+        struct lrs_comm_worker *worker = &lrs->workers[lrs->n_workers];
+
+        worker->lrs = lrs;
+        rc = pho_comm_open_worker(&worker->comm, &lrs->comm);
+        if (rc)
+            LOG_RETURN(rc, "Failed to open communication worker %d",
+                       lrs->n_workers);
+
+        rc = tsqueue_init(&worker->response_queue);
+        if (rc) {
+            pho_comm_close(&worker->comm);
+            LOG_RETURN(rc, "Unable to init worker response queue");
+        }
+
+        tsqueue_set_notify(&worker->response_queue, worker_wakeup, worker);
+    }
+
+    /* the responses of the schedulers are routed by the first worker */
+    tsqueue_set_notify(&lrs->response_queue, worker_wakeup, lrs->workers);
+
+    /* the first worker is run by the main thread */
+    for (i = 1; i < lrs->n_workers; i++) {
+        struct lrs_comm_worker *worker = &lrs->workers[i];
+
+        rc = -pthread_create(&worker->tid, NULL, lrs_comm_worker_thread,
+                             worker);
+        if (rc)
+            LOG_RETURN(rc, "Failed to start communication thread %d", i);
+
+        worker->started = true;
+    }
+
+    pho_verb("Client requests handled by %d communication threads",
+             lrs->n_workers);
+
+    return 0;
+}
+
+/** Wait for the end of the worker threads, no new request is received then */
+static void lrs_comm_workers_stop(struct lrs *lrs)
+{
+    int i;
+
+    if (!lrs->workers)
+        return;
+
+    /* the workers end their current round and stop */
+    running = false;
+    lrs->stopped = true;
+
+    for (i = 0; i < lrs->n_workers; i++) {
+        struct lrs_comm_worker *worker = &lrs->workers[i];
+
+        if (worker->started) {
+            pho_comm_wakeup(&worker->comm);
+            pthread_join(worker->tid, NULL);
+            worker->started = false;
+        }
+    }
+}
+
+/**
+ * Release the workers, once the schedulers, which may still wake them up,
+ * are stopped.
+ */
+static void lrs_comm_workers_fini(struct lrs *lrs)
+{
+    int rc;
+    int i;
+
+    if (!lrs->workers)
+        return;
+
+    for (i = 0; i < lrs->n_workers; i++) {
+        struct lrs_comm_worker *worker = &lrs->workers[i];
+
+        rc = pho_comm_close(&worker->comm);
+        if (rc)
+            pho_error(rc, "Failed to close communication worker %d", i);
+
+        tsqueue_log_stats(&worker->response_queue, "worker responses");
+        tsqueue_destroy(&worker->response_queue, sched_resp_free_with_cont);
+    }
+
+    free(lrs->workers);
+    lrs->workers = NULL;
+    lrs->n_workers = 0;
+}
+
 /* ****************************************************************************/
 /* LRS main functions *********************************************************/
 /* ****************************************************************************/
@@ -952,6 +1262,8 @@ static void lrs_fini(struct lrs *lrs)
     if (lrs == NULL)
         return;
 
+    lrs_comm_workers_stop(lrs);
+
     for (i = 0; i < PHO_RSC_LAST; ++i) {
         if (lrs->sched[i])
             thread_signal_stop(&lrs->sched[i]->sched_thread);
@@ -966,12 +1278,19 @@ static void lrs_fini(struct lrs *lrs)
         free(lrs->sched[i]);
     }
 
+    lrs_comm_workers_fini(lrs);
+
     rc = pho_comm_close(&lrs->comm);
     if (rc)
         pho_error(rc, "Failed to close the phobosd socket");
 
+    tsqueue_log_stats(&lrs->response_queue, "responses");
     tsqueue_destroy(&lrs->response_queue, sched_resp_free_with_cont);
-    dss_fini(&lrs->dss);
+
+    if (lrs->clients)
+        g_hash_table_destroy(lrs->clients);
+    pthread_mutex_destroy(&lrs->clients_mutex);
+    pthread_mutex_destroy(&lrs->configure_mutex);
 
     _delete_lock_file(lrs->lock_file);
 }
@@ -1007,6 +1326,9 @@ static int lrs_init(struct lrs *lrs)
     if (rc)
         LOG_GOTO(err, rc, "Unable to init lrs response queue");
 
+    lrs->clients = g_hash_table_new(g_direct_hash, g_direct_equal);
+    pthread_mutex_init(&lrs->clients_mutex, NULL);
+    pthread_mutex_init(&lrs->configure_mutex, NULL);
     lrs->stopped = false;
 
     rc = _load_schedulers(lrs);
@@ -1018,9 +1340,9 @@ static int lrs_init(struct lrs *lrs)
     if (rc)
         LOG_GOTO(err, rc, "Failed to open the phobosd socket");
 
-    rc = dss_init(&lrs->dss);
+    rc = lrs_comm_workers_init(lrs);
     if (rc)
-        LOG_GOTO(err, rc, "Failed to init comm dss handle");
+        LOG_GOTO(err, rc, "Failed to start the communication workers");
 
     return rc;
 
@@ -1029,88 +1351,6 @@ err:
     return rc;
 }
 
-/**
- * Process pending requests from the unix socket and send the associated
- * responses to clients.
- *
- * Requests are guaranteed to be answered at some point.
- *
- * TODO: we need to think about a way to avoid the EPIPE error in the future,
- * due to a client departure before the release ack is sent.
- * I got three ideas (the latter, the better):
- * - consider that this EPIPE error is not critical and can happen if
- *   the client does not care about the release acknowledgement;
- * - consider a boolean 'send_resp' in the release message protocol to
- *   indicate if the client need a response, and then send it if needed;
- * - force the client to always receive the ack, but putting a boolean
- *   'with_flush' in the release message protocol to let the client
- *   be responded before or after a flush operation. If not, the client
- *   only says to the LRS that its operation is done and that it does
- *   not need the device anymore. The LRS sends its response once the
- *   release request is received.
- *
- * \param[in]       lrs         The LRS that will handle the requests.
- *
- * \return                      0 on succes, -errno on failure.
- */
-static int lrs_process(struct lrs *lrs)
-{
-    bool schedulers_to_signal[PHO_RSC_LAST] = {false};
-    struct pho_comm_data *data = NULL;
-    bool stopped = true;
-    int n_data;
-    int rc = 0;
-    int i;
-
-    /* check if some devices are still running */
-    for (i = 0; i < PHO_RSC_LAST; ++i) {
-        if (!lrs->sched[i])
-            continue;
-
-        if (running || sched_has_running_devices(lrs->sched[i]))
-            stopped = false;
-    }
-
-    /* request reception and accept handling */
-    rc = pho_comm_recv(&lrs->comm, &data, &n_data);
-    if (rc) {
-        for (i = 0; i < n_data; ++i)
-            free(data[i].buf.buff);
-        free(data);
-        running = false;
-        LOG_GOTO(end, rc, "Error during request reception");
-    }
-
-    rc = _prepare_requests(lrs, schedulers_to_signal, n_data, data);
-    free(data);
-    if (rc) {
-        running = false;
-        LOG_GOTO(end, rc, "Error during request enqueuing");
-    }
-
-    /* response processing */
-    for (i = 0; i < PHO_RSC_LAST; ++i) {
-        if (!lrs->sched[i])
-            continue;
-
-        if (schedulers_to_signal[i])
-            thread_signal(&lrs->sched[i]->sched_thread);
-
-        if (running || sched_has_running_devices(lrs->sched[i]))
-            stopped = false;
-    }
-
-end:
-    rc = send_responses_from_queue(lrs);
-    if (rc)
-        running = false;
-
-    if (!running)
-        lrs->stopped = stopped;
-
-    return rc;
-}
-
 int main(int argc, char **argv)
 {
     int write_pipe_from_child_to_father;
@@ -1143,8 +1383,14 @@ int main(int argc, char **argv)
         return -rc;
     }
 
-    while (running || !lrs.stopped)
-        lrs_process(&lrs);
+    while (running || !lrs.stopped) {
+        bool stopped = lrs_devices_stopped(&lrs);
+
+        lrs_process(&lrs.workers[0]);
+
+        if (!running)
+            lrs.stopped = stopped && lrs_devices_stopped(&lrs);
+    }
 
     lrs_fini(&lrs);
     return EXIT_SUCCESS;
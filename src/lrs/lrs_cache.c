@@ -30,6 +30,7 @@
 
 #include "health.h"
 #include "lrs_cache.h"
+#include "lrs_media_index.h"
 #include "pho_common.h"
 #include "pho_dss.h"
 #include "pho_dss_wrapper.h"
@@ -107,16 +108,26 @@ void lrs_medium_release(struct media_info *medium)
 struct media_info *lrs_medium_update(struct pho_id *id)
 {
     enum rsc_family family = id->family;
+    struct media_info *medium;
+
+    medium = pho_cache_update(phobos_context()->lrs_media_cache[family], id);
+    if (medium)
+        lrs_media_index_update(medium);
 
-    return pho_cache_update(phobos_context()->lrs_media_cache[family], id);
+    return medium;
 }
 
 struct media_info *lrs_medium_insert(struct media_info *medium)
 {
     enum rsc_family family = medium->rsc.id.family;
+    struct media_info *inserted;
 
-    return pho_cache_insert(phobos_context()->lrs_media_cache[family],
-                            &medium->rsc.id, medium);
+    inserted = pho_cache_insert(phobos_context()->lrs_media_cache[family],
+                                &medium->rsc.id, medium);
+    if (inserted)
+        lrs_media_index_update(inserted);
+
+    return inserted;
 }
 
 void lrs_media_cache_dump(enum rsc_family family)
@@ -129,27 +140,11 @@ static struct key_value *lrs_media_cache_build(const void *key, void *_env)
     struct media_cache_env *env = _env;
     const struct pho_id *id = key;
     struct media_info *medium;
-    struct dss_filter filter;
     struct key_value *kv;
     int count;
     int rc;
 
-    rc = dss_filter_build(&filter,
-                          "{\"$AND\": ["
-                              "{\"DSS::MDA::family\": \"%s\"}, "
-                              "{\"DSS::MDA::id\": \"%s\"}, "
-                              "{\"DSS::MDA::library\": \"%s\"}"
-                          "]}",
-                          rsc_family2str(id->family),
-                          id->name,
-                          id->library);
-    if (rc) {
-        errno = -rc;
-        return NULL;
-    }
-
-    rc = dss_media_get(&env->dss, &filter, &medium, &count, NULL);
-    dss_filter_free(&filter);
+    rc = dss_media_get_from_id(&env->dss, id, &medium, &count);
     if (rc) {
         errno = -rc;
         return NULL;
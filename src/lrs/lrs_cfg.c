@@ -84,6 +84,21 @@ const struct pho_config_item cfg_lrs[] = {
         .name    = "max_health",
         .value   = "1",
     },
+    [PHO_CFG_LRS_media_index_refresh_ms] = {
+        .section = "lrs",
+        .name    = "media_index_refresh_ms",
+        .value   = "tape=60000,dir=60000,rados_pool=60000"
+    },
+    [PHO_CFG_LRS_comm_threads] = {
+        .section = "lrs",
+        .name    = "comm_threads",
+        .value   = "4"
+    },
+    [PHO_CFG_LRS_sync_latency_target_ms] = {
+        .section = "lrs",
+        .name    = "sync_latency_target_ms",
+        .value   = "tape=0,dir=0,rados_pool=0"
+    },
 };
 
 static int _get_unsigned_long_from_string(const char *value,
@@ -171,3 +186,87 @@ int get_cfg_sync_wsize_value(enum rsc_family family, unsigned long *threshold)
 
     return 0;
 }
+
+/**
+ * Get the value of \p family in a "family=value,..." parameter, or in its
+ * default value if the parameter is not configured.
+ */
+static int _get_substring_value_or_default(enum pho_cfg_params_lrs param,
+                                           enum rsc_family family,
+                                           char **value)
+{
+    const char *family_name = rsc_family2str(family);
+    char *default_value;
+    char *save_ptr;
+    char *item;
+    int rc;
+
+    rc = pho_cfg_get_substring_value(cfg_lrs[param].section,
+                                     cfg_lrs[param].name, family, value);
+    if (rc != -ENODATA)
+        return rc;
+
+    default_value = xstrdup(cfg_lrs[param].value);
+    rc = -EINVAL;
+    for (item = strtok_r(default_value, ",", &save_ptr);
+         item != NULL;
+         item = strtok_r(NULL, ",", &save_ptr)) {
+        size_t len = strlen(family_name);
+
+        if (!strncmp(item, family_name, len) && item[len] == '=') {
+            *value = xstrdup(item + len + 1);
+            rc = 0;
+            break;
+        }
+    }
+
+    free(default_value);
+
+    return rc;
+}
+
+int get_cfg_sync_latency_target_ms_value(enum rsc_family family,
+                                         struct timespec *target)
+{
+    unsigned long num_milliseconds;
+    char *value;
+    int rc;
+
+    rc = _get_substring_value_or_default(PHO_CFG_LRS_sync_latency_target_ms,
+                                         family, &value);
+    if (rc)
+        return rc;
+
+    rc = _get_unsigned_long_from_string(value, 0, ULONG_MAX, &num_milliseconds);
+    free(value);
+    if (rc)
+        return rc;
+
+    target->tv_sec = num_milliseconds / 1000;
+    target->tv_nsec = (num_milliseconds % 1000) * 1000000;
+
+    return 0;
+}
+
+int get_cfg_media_index_refresh_ms_value(enum rsc_family family,
+                                         struct timespec *period)
+{
+    unsigned long num_milliseconds;
+    char *value;
+    int rc;
+
+    rc = _get_substring_value_or_default(PHO_CFG_LRS_media_index_refresh_ms,
+                                         family, &value);
+    if (rc)
+        return rc;
+
+    rc = _get_unsigned_long_from_string(value, 0, ULONG_MAX, &num_milliseconds);
+    free(value);
+    if (rc)
+        return rc;
+
+    period->tv_sec = num_milliseconds / 1000;
+    period->tv_nsec = (num_milliseconds % 1000) * 1000000;
+
+    return 0;
+}
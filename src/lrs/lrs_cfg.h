@@ -43,8 +43,11 @@ enum pho_cfg_params_lrs {
     PHO_CFG_LRS_sync_nb_req,
     PHO_CFG_LRS_sync_wsize_kb,
     PHO_CFG_LRS_max_health,
+    PHO_CFG_LRS_media_index_refresh_ms,
+    PHO_CFG_LRS_comm_threads,
+    PHO_CFG_LRS_sync_latency_target_ms,
 
-    PHO_CFG_LRS_LAST = PHO_CFG_LRS_max_health,
+    PHO_CFG_LRS_LAST = PHO_CFG_LRS_sync_latency_target_ms,
 };
 
 extern const struct pho_config_item cfg_lrs[];
@@ -80,4 +83,28 @@ int get_cfg_sync_nb_req_value(enum rsc_family family, unsigned int *threshold);
  */
 int get_cfg_sync_wsize_value(enum rsc_family family, unsigned long *threshold);
 
+/**
+ * Getter of the release latency target of the adaptive synchronization for a
+ * given family.
+ *
+ * @param[in]   family      Targeted family.
+ * @param[out]  target      Returned target, zero if the synchronization is
+ *                          driven by the static thresholds.
+ * @return                  0 on success,
+ *                         -errno on failure.
+ */
+int get_cfg_sync_latency_target_ms_value(enum rsc_family family,
+                                         struct timespec *target);
+
+/**
+ * Getter of the refresh period of the writable media index of a given family.
+ *
+ * @param[in]   family      Targeted family.
+ * @param[out]  period      Returned period.
+ * @return                  0 on success,
+ *                         -errno on failure.
+ */
+int get_cfg_media_index_refresh_ms_value(enum rsc_family family,
+                                         struct timespec *period);
+
 #endif
@@ -33,6 +33,7 @@
 #include "lrs_cache.h"
 #include "lrs_cfg.h"
 #include "lrs_device.h"
+#include "lrs_media_index.h"
 #include "lrs_sched.h"
 #include "lrs_utils.h"
 
@@ -58,6 +59,8 @@ static int dev_medium_switch_mount(struct lrs_dev *dev,
                                    struct medium_switch_context *context);
 static int dev_thread_init(struct lrs_dev *device);
 static void sync_params_init(struct sync_params *params);
+static bool sync_is_adaptive(struct lrs_dev_hdl *handle);
+static double timespec2ms(const struct timespec *time);
 
 static inline long ms2sec(long ms)
 {
@@ -97,6 +100,11 @@ int lrs_dev_hdl_init(struct lrs_dev_hdl *handle, enum rsc_family family)
     if (rc)
         return rc;
 
+    rc = get_cfg_sync_latency_target_ms_value(family,
+                                              &handle->sync_latency_target);
+    if (rc)
+        return rc;
+
     return 0;
 }
 
@@ -119,17 +127,25 @@ static int lrs_dev_init_from_info(struct lrs_dev_hdl *handle,
         GOTO(err_dev, rc = -ENOMEM);
 
     sync_params_init(&(*dev)->ld_sync_params);
+    atomic_init(&(*dev)->ld_sync_params.window_ms,
+                timespec2ms(&handle->sync_time_ms));
+    if (sync_is_adaptive(handle) &&
+        cmp_timespec(&handle->sync_latency_target, &handle->sync_time_ms) < 0)
+        atomic_store(&(*dev)->ld_sync_params.window_ms,
+                     timespec2ms(&handle->sync_latency_target));
 
     rc = dss_init(&(*dev)->ld_device_thread.dss);
     if (rc)
         GOTO(err_info, rc);
 
+    (*dev)->ld_dss_async = sched->dss_async;
     (*dev)->ld_response_queue = sched->response_queue;
     (*dev)->ld_ongoing_format = &sched->ongoing_format;
     (*dev)->sched_req_queue = &sched->incoming;
     (*dev)->sched_retry_queue = &sched->retry_queue;
     (*dev)->ld_handle = handle;
     (*dev)->ld_sub_request = NULL;
+    (*dev)->ld_preload_medium = NULL;
     (*dev)->ld_mnt_path[0] = 0;
 
     if ((*dev)->ld_dss_dev_info->rsc.model) {
@@ -209,6 +225,7 @@ static void lrs_dev_info_clean(struct lrs_dev_hdl *handle,
                         sub_request_free_wrapper, NULL);
     g_ptr_array_unref(dev->ld_sync_params.tosync_array);
     sub_request_free(dev->ld_sub_request);
+    lrs_medium_release(dev->ld_preload_medium);
     dev_info_free(dev->ld_dss_dev_info, 1);
     dss_fini(&dev->ld_device_thread.dss);
 
@@ -447,6 +464,112 @@ static void sync_params_init(struct sync_params *params)
     params->groupings_to_update = false;
 }
 
+/* Adaptive synchronization
+ *
+ * A sync takes seconds with LTFS and milliseconds with POSIX file systems,
+ * whereas the release latency seen by the clients is the time waited before
+ * the sync plus the sync itself. In adaptive mode, each device measures the
+ * duration of its syncs and the interval between the releases to sync, and
+ * waits for SYNC_COST_RATIO times the sync duration to batch the releases, so
+ * that syncs take at most a fifth of the device time. It does not wait if the
+ * releases are too far apart to be batched, nor more than the latency target
+ * minus the sync duration.
+ */
+#define SYNC_COST_RATIO     4
+#define SYNC_EWMA_WEIGHT    0.25
+
+static bool sync_is_adaptive(struct lrs_dev_hdl *handle)
+{
+    return handle->sync_latency_target.tv_sec != 0 ||
+           handle->sync_latency_target.tv_nsec != 0;
+}
+
+static double timespec2ms(const struct timespec *time)
+{
+    return time->tv_sec * 1000.0 + time->tv_nsec / 1000000.0;
+}
+
+static struct timespec ms2timespec(double ms)
+{
+    struct timespec time;
+
+    time.tv_sec = ms / 1000;
+    time.tv_nsec = (ms - time.tv_sec * 1000.0) * 1000000;
+
+    return time;
+}
+
+static void ewma_update(double *average, double sample)
+{
+    if (*average == 0)
+        *average = sample;
+    else
+        *average += SYNC_EWMA_WEIGHT * (sample - *average);
+}
+
+/* called with a lock on \p dev */
+static void sync_update_window(struct lrs_dev *dev)
+{
+    struct sync_params *params = &dev->ld_sync_params;
+    double target = timespec2ms(&dev->ld_handle->sync_latency_target);
+    double window;
+
+    if (params->sync_cost_ms == 0)
+        /* keep the initial window until a sync is measured */
+        return;
+
+    window = SYNC_COST_RATIO * params->sync_cost_ms;
+    if (params->interval_ms > window)
+        /* no other release would join the batch */
+        window = 0;
+
+    window = min(window, max(target - params->sync_cost_ms, 0.));
+    atomic_store(&params->window_ms, window);
+}
+
+void lrs_dev_sync_record_release(struct lrs_dev *dev,
+                                 const struct timespec *date)
+{
+    struct sync_params *params = &dev->ld_sync_params;
+
+    if (!sync_is_adaptive(dev->ld_handle))
+        return;
+
+    if (params->last_release.tv_sec != 0) {
+        struct timespec interval = diff_timespec(date, &params->last_release);
+
+        ewma_update(&params->interval_ms, timespec2ms(&interval));
+        sync_update_window(dev);
+    }
+
+    params->last_release = *date;
+}
+
+void lrs_dev_sync_record_cost(struct lrs_dev *dev,
+                              const struct timespec *duration)
+{
+    struct sync_params *params = &dev->ld_sync_params;
+
+    if (!sync_is_adaptive(dev->ld_handle))
+        return;
+
+    ewma_update(&params->sync_cost_ms, timespec2ms(duration));
+    sync_update_window(dev);
+
+    pho_debug("Device '%s': sync cost %.1f ms, releases every %.1f ms, "
+              "sync window set to %ld ms", lrs_dev_name(dev),
+              params->sync_cost_ms, params->interval_ms,
+              atomic_load(&params->window_ms));
+}
+
+struct timespec lrs_dev_sync_window(struct lrs_dev *dev)
+{
+    if (!sync_is_adaptive(dev->ld_handle))
+        return dev->ld_handle->sync_time_ms;
+
+    return ms2timespec(atomic_load(&dev->ld_sync_params.window_ms));
+}
+
 static const struct timespec MINSLEEP = {
     .tv_sec = 0,
     .tv_nsec = 10000000, /* 10 ms */
@@ -455,6 +578,7 @@ static const struct timespec MINSLEEP = {
 static int compute_wakeup_date(struct lrs_dev *dev, struct timespec *date)
 {
     struct timespec *oldest_tosync = &dev->ld_sync_params.oldest_tosync;
+    struct timespec window = lrs_dev_sync_window(dev);
     struct timespec diff;
     struct timespec now;
     int rc;
@@ -464,9 +588,9 @@ static int compute_wakeup_date(struct lrs_dev *dev, struct timespec *date)
         LOG_RETURN(-errno, "clock_gettime: unable to get CLOCK_REALTIME");
 
     if (oldest_tosync->tv_sec == 0 && oldest_tosync->tv_nsec == 0) {
-        *date = add_timespec(&now, &dev->ld_handle->sync_time_ms);
+        *date = add_timespec(&now, &window);
     } else {
-        *date = add_timespec(oldest_tosync, &dev->ld_handle->sync_time_ms);
+        *date = add_timespec(oldest_tosync, &window);
 
         diff = diff_timespec(date, &now);
         if (cmp_timespec(&diff, &MINSLEEP) == -1)
@@ -618,6 +742,7 @@ void push_new_sync_to_device(struct lrs_dev *dev, struct req_container *reqc,
         reqc->req->release->media[medium_index]->grouping;
     struct sync_params *sync_params = &dev->ld_sync_params;
     struct string_array *dev_medium_groupings;
+    struct timespec now;
 
     struct sub_request *req_tosync;
 
@@ -637,6 +762,8 @@ void push_new_sync_to_device(struct lrs_dev *dev, struct req_container *reqc,
     sync_params->tosync_nb_extents +=
         reqc->params.release.tosync_media[medium_index].nb_extents_written;
     update_oldest_tosync(&sync_params->oldest_tosync, reqc->received_at);
+    clock_gettime(CLOCK_REALTIME, &now);
+    lrs_dev_sync_record_release(dev, &now);
 
     /* Set ld_needs_sync to true to avoid waiting until the threshold are
      * exceeded
@@ -726,12 +853,14 @@ static void remove_canceled_sync(struct lrs_dev *dev)
 static void check_needs_sync(struct lrs_dev_hdl *handle, struct lrs_dev *dev)
 {
     struct sync_params *sync_params = &dev->ld_sync_params;
+    struct timespec window;
 
     MUTEX_LOCK(&dev->ld_mutex);
+    window = lrs_dev_sync_window(dev);
     dev->ld_needs_sync = sync_params->tosync_array->len > 0 &&
                       (sync_params->tosync_array->len >= handle->sync_nb_req ||
                        is_past(add_timespec(&sync_params->oldest_tosync,
-                                            &handle->sync_time_ms)) ||
+                                            &window)) ||
                        sync_params->tosync_size >= handle->sync_wsize_kb);
     dev->ld_needs_sync |= (!running && sync_params->tosync_array->len > 0);
     dev->ld_needs_sync |= (thread_is_stopping(&dev->ld_device_thread) &&
@@ -749,7 +878,6 @@ int medium_sync(struct lrs_dev *dev)
     struct media_info *media_info = dev->ld_dss_media_info;
     const char *fsroot = dev->ld_mnt_path;
     struct io_adapter_module *ioa;
-    struct dss_handle *dss;
     struct pho_log log;
     int rc;
 
@@ -760,12 +888,11 @@ int medium_sync(struct lrs_dev *dev)
         LOG_RETURN(rc, "No suitable I/O adapter for filesystem type: '%s'",
                    fs_type2str(media_info->fs.type));
 
-    dss = &dev->ld_device_thread.dss;
     init_pho_log(&log, &dev->ld_dss_dev_info->rsc.id,
                  &dev->ld_dss_media_info->rsc.id, PHO_LTFS_SYNC);
 
     rc = ioa_medium_sync(ioa, fsroot, &log.message);
-    emit_log_after_action(dss, &log, PHO_LTFS_SYNC, rc);
+    dss_async_emit_log(dev->ld_dss_async, &log, PHO_LTFS_SYNC, rc);
 
     pho_debug("sync: medium=%s rc=%d", media_info->rsc.id.name, rc);
     if (rc)
@@ -813,7 +940,7 @@ static int lrs_dev_media_update(struct lrs_dev *dev, size_t size_written,
                      &dev->ld_dss_media_info->rsc.id, PHO_LTFS_DF);
 
         rc2 = ldm_fs_df(fsa, fsroot, &space, &log.message);
-        emit_log_after_action(dss, &log, PHO_LTFS_DF, rc2);
+        dss_async_emit_log(dev->ld_dss_async, &log, PHO_LTFS_DF, rc2);
         if (rc2) {
             rc = rc ? : rc2;
             pho_error(rc2, "Cannot retrieve media usage information");
@@ -859,9 +986,13 @@ static int lrs_dev_media_update(struct lrs_dev *dev, size_t size_written,
     /* TODO update nb_load, nb_errors, last_load */
 
     assert(fields);
+    /* the estimate of the free space queued on release is now outdated */
+    dss_async_media_cancel(dev->ld_dss_async, &media_info->rsc.id);
     rc2 = dss_media_update(dss, media_info, media_info, 1, fields);
     if (rc2)
         rc = rc ? : rc2;
+    else
+        lrs_media_index_update(media_info);
 
     return rc;
 }
@@ -870,15 +1001,24 @@ static int lrs_dev_media_update(struct lrs_dev *dev, size_t size_written,
 static int dev_sync(struct lrs_dev *dev)
 {
     struct sync_params *sync_params = &dev->ld_sync_params;
+    struct timespec duration;
+    struct timespec start;
+    struct timespec now;
     int rc = 0;
     int rc2;
 
     MUTEX_LOCK(&dev->ld_mutex);
 
     /* Do not sync on error as we don't know what happened on the tape. */
-    if (dev->ld_last_client_rc == 0)
+    if (dev->ld_last_client_rc == 0) {
+        clock_gettime(CLOCK_REALTIME, &start);
         rc = medium_sync(dev);
-    else
+        if (!rc) {
+            clock_gettime(CLOCK_REALTIME, &now);
+            duration = diff_timespec(&now, &start);
+            lrs_dev_sync_record_cost(dev, &duration);
+        }
+    } else
         /* this will cause the device thread to stop */
         rc = dev->ld_last_client_rc;
 
@@ -916,13 +1056,11 @@ static int dev_sync(struct lrs_dev *dev)
 int dev_umount(struct lrs_dev *dev)
 {
     struct fs_adapter_module *fsa;
-    struct dss_handle *dss;
     struct pho_log log;
     int rc;
 
     ENTRY;
 
-    dss = &dev->ld_device_thread.dss;
     init_pho_log(&log, &dev->ld_dss_dev_info->rsc.id,
                  &dev->ld_dss_media_info->rsc.id, PHO_LTFS_UMOUNT);
 
@@ -944,7 +1082,7 @@ int dev_umount(struct lrs_dev *dev)
                    dev->ld_dss_media_info->rsc.id.library, dev->ld_dev_path);
 
     rc = ldm_fs_umount(fsa, dev->ld_dev_path, dev->ld_mnt_path, &log.message);
-    emit_log_after_action(dss, &log, PHO_LTFS_UMOUNT, rc);
+    dss_async_emit_log(dev->ld_dss_async, &log, PHO_LTFS_UMOUNT, rc);
     clean_tosync_array(dev, rc);
     if (rc)
         LOG_RETURN(rc,
@@ -1090,6 +1228,8 @@ static int dss_set_medium_to_failed(struct dss_handle *dss,
               rsc_family2str(media_info->rsc.id.family),
               media_info->rsc.id.name, media_info->rsc.id.library);
     media_info->rsc.adm_status = PHO_RSC_ADM_ST_FAILED;
+    /* a failed medium cannot be written to anymore */
+    lrs_media_index_update(media_info);
     return dss_media_update(dss, media_info, media_info, 1, ADM_STATUS);
 }
 
@@ -1125,7 +1265,8 @@ int dev_load(struct lrs_dev *dev, struct media_info *medium)
 
     ENTRY;
 
-    dev->ld_sub_request->failure_on_medium = false;
+    if (dev->ld_sub_request)
+        dev->ld_sub_request->failure_on_medium = false;
     pho_verb("load: medium (family '%s', name '%s', library '%s') into '%s'",
              rsc_family2str(medium->rsc.id.family), medium->rsc.id.name,
              medium->rsc.id.library, dev->ld_dev_path);
@@ -1140,7 +1281,8 @@ int dev_load(struct lrs_dev *dev, struct media_info *medium)
     rc = ldm_lib_load(&lib_hdl, dev->ld_dss_dev_info->rsc.id.name,
                       medium->rsc.id.name);
     if (rc) {
-        dev->ld_sub_request->failure_on_medium = true;
+        if (dev->ld_sub_request)
+            dev->ld_sub_request->failure_on_medium = true;
         LOG_GOTO(out_close, rc, "Media load failed");
     }
 
@@ -1177,14 +1319,12 @@ int dev_format(struct lrs_dev *dev, struct fs_adapter_module *fsa, bool unlock)
 {
     struct media_info *medium = dev->ld_dss_media_info;
     struct ldm_fs_space space = {0};
-    struct dss_handle *dss;
     uint64_t fields = 0;
     struct pho_log log;
     int rc;
 
     ENTRY;
 
-    dss = &dev->ld_device_thread.dss;
     init_pho_log(&log, &dev->ld_dss_dev_info->rsc.id, &medium->rsc.id,
                  PHO_LTFS_FORMAT);
 
@@ -1194,7 +1334,7 @@ int dev_format(struct lrs_dev *dev, struct fs_adapter_module *fsa, bool unlock)
 
     rc = ldm_fs_format(fsa, dev->ld_dev_path, medium->rsc.id.name, &space,
                        &log.message);
-    emit_log_after_action(dss, &log, PHO_LTFS_FORMAT, rc);
+    dss_async_emit_log(dev->ld_dss_async, &log, PHO_LTFS_FORMAT, rc);
     if (rc)
         LOG_RETURN(rc,
                    "Cannot format medium (family '%s', name '%s', library "
@@ -1241,6 +1381,8 @@ int dev_format(struct lrs_dev *dev, struct fs_adapter_module *fsa, bool unlock)
                    rsc_family2str(medium->rsc.id.family), medium->rsc.id.name,
                    medium->rsc.id.library);
 
+    lrs_media_index_update(medium);
+
     return 0;
 }
 
@@ -1612,7 +1754,6 @@ char *mount_point(const char *id)
 
 int dev_mount(struct lrs_dev *dev)
 {
-    struct dss_handle *dss = &dev->ld_device_thread.dss;
     struct fs_adapter_module *fsa;
     struct pho_log log;
     char *mnt_root;
@@ -1663,7 +1804,7 @@ int dev_mount(struct lrs_dev *dev)
     rc = ldm_fs_mount(fsa, dev->ld_dev_path, mnt_root,
                       dev->ld_dss_media_info->fs.label,
                       &log.message);
-    emit_log_after_action(dss, &log, PHO_LTFS_MOUNT, rc);
+    dss_async_emit_log(dev->ld_dss_async, &log, PHO_LTFS_MOUNT, rc);
     if (rc)
         goto out_free;
 
@@ -1686,11 +1827,9 @@ bool dev_mount_is_writable(struct lrs_dev *dev)
     const char *fs_root = dev->ld_mnt_path;
     struct ldm_fs_space fs_info = {0};
     struct fs_adapter_module *fsa;
-    struct dss_handle *dss;
     struct pho_log log;
     int rc;
 
-    dss = &dev->ld_device_thread.dss;
     init_pho_log(&log, &dev->ld_dss_dev_info->rsc.id,
                  &dev->ld_dss_media_info->rsc.id, PHO_LTFS_DF);
 
@@ -1702,7 +1841,7 @@ bool dev_mount_is_writable(struct lrs_dev *dev)
     }
 
     rc = ldm_fs_df(fsa, fs_root, &fs_info, &log.message);
-    emit_log_after_action(dss, &log, PHO_LTFS_DF, rc);
+    dss_async_emit_log(dev->ld_dss_async, &log, PHO_LTFS_DF, rc);
     if (rc) {
         pho_error(rc, "Cannot retrieve media usage information");
         return false;
@@ -1781,6 +1920,94 @@ out_free:
     return 0;
 }
 
+/**
+ * Release the medium to preload, and its DSS lock if the device did not load
+ * it.
+ */
+static void dev_release_preload(struct lrs_dev *dev, bool unlock)
+{
+    struct media_info *medium = dev->ld_preload_medium;
+
+    if (unlock) {
+        int rc = dss_medium_release(&dev->ld_device_thread.dss, medium);
+
+        if (rc)
+            pho_error(rc,
+                      "Unable to release medium (family '%s', name '%s', "
+                      "library '%s') after its preload",
+                      rsc_family2str(medium->rsc.id.family),
+                      medium->rsc.id.name, medium->rsc.id.library);
+    }
+
+    MUTEX_LOCK(&dev->ld_mutex);
+    dev->ld_preload_medium = NULL;
+    MUTEX_UNLOCK(&dev->ld_mutex);
+
+    lrs_medium_release(medium);
+}
+
+/**
+ * Load and mount the medium that the scheduler expects queued reads to need.
+ *
+ * The medium stays in the device as if it had been used by a previous request,
+ * so that the next read on it does not wait for the robot and the mount. A
+ * failure is not fatal: the reads will load the medium again and handle the
+ * error.
+ */
+static int dev_handle_preload(struct lrs_dev *dev)
+{
+    struct media_info *medium = dev->ld_preload_medium;
+    const struct pho_id *dev_id = lrs_dev_id(dev);
+    int rc;
+
+    ENTRY;
+
+    if (!thread_is_running(&dev->ld_device_thread)) {
+        dev_release_preload(dev, true);
+        return 0;
+    }
+
+    pho_verb("preload: medium (family '%s', name '%s', library '%s') into "
+             "device (family '%s', name '%s', library '%s')",
+             rsc_family2str(medium->rsc.id.family), medium->rsc.id.name,
+             medium->rsc.id.library, rsc_family2str(dev_id->family),
+             dev_id->name, dev_id->library);
+
+    if (!medium_is_loaded(dev, medium)) {
+        rc = dev_empty(dev);
+        if (!rc)
+            rc = dev_load(dev, medium);
+        if (rc) {
+            pho_error(rc,
+                      "failed to preload medium (family '%s', name '%s', "
+                      "library '%s') in device (family '%s', name '%s', "
+                      "library '%s')", rsc_family2str(medium->rsc.id.family),
+                      medium->rsc.id.name, medium->rsc.id.library,
+                      rsc_family2str(dev_id->family), dev_id->name,
+                      dev_id->library);
+            decrease_device_health(dev);
+            dev_release_preload(dev, !medium_is_loaded(dev, medium));
+
+            return dev_is_failed(dev) ? rc : 0;
+        }
+    }
+
+    /* the medium is loaded and locked by the device from now on */
+    if (!dev_is_mounted(dev)) {
+        rc = dev_mount(dev);
+        if (rc)
+            pho_error(rc,
+                      "failed to mount preloaded medium (family '%s', name "
+                      "'%s', library '%s'), the next request will retry",
+                      rsc_family2str(medium->rsc.id.family),
+                      medium->rsc.id.name, medium->rsc.id.library);
+    }
+
+    dev_release_preload(dev, false);
+
+    return 0;
+}
+
 /**
  * Manage a format request at device thread end.
  *
@@ -1830,6 +2057,7 @@ static void cancel_pending_format(struct lrs_dev *device)
                           medium_to_format->rsc.id.name,
                           medium_to_format->rsc.id.library);
                 medium_to_format->rsc.adm_status = PHO_RSC_ADM_ST_FAILED;
+                lrs_media_index_update(medium_to_format);
                 rc = dss_media_update(&device->ld_device_thread.dss,
                                       medium_to_format, medium_to_format, 1,
                                       ADM_STATUS);
@@ -2023,6 +2251,10 @@ static void dev_thread_end(struct lrs_dev *device)
     }
 
     cancel_pending_format(device);
+    if (device->ld_preload_medium)
+        dev_release_preload(device,
+                            !medium_is_loaded(device,
+                                              device->ld_preload_medium));
 
     if (!device->ld_device_thread.status) {
         int rc = dev_cleanup_medium_at_stop(device);
@@ -2091,7 +2323,7 @@ static void *lrs_dev_thread(void *tdata)
             check_needs_sync(device->ld_handle, device);
 
         if (thread_is_stopping(thread) && !device->ld_ongoing_io &&
-            !device->ld_sub_request &&
+            !device->ld_sub_request && !device->ld_preload_medium &&
             device->ld_sync_params.tosync_array->len == 0) {
             pho_debug("Switching to stopped");
             thread->state = THREAD_STOPPED;
@@ -2129,6 +2361,17 @@ static void *lrs_dev_thread(void *tdata)
                              rsc_family2str(dev_id->family), dev_id->name,
                              dev_id->library);
                 }
+            } else if (device->ld_preload_medium) {
+                rc = dev_handle_preload(device);
+                if (rc) {
+                    const struct pho_id *dev_id = lrs_dev_id(device);
+
+                    LOG_GOTO(end_thread, thread->status = rc,
+                             "device thread (family '%s', name '%s', library "
+                             "'%s'): fatal error preloading a medium",
+                             rsc_family2str(dev_id->family), dev_id->name,
+                             dev_id->library);
+                }
             }
         }
 
@@ -2431,6 +2674,7 @@ static int dev_medium_switch_mount(struct lrs_dev *dev,
 
         MUTEX_LOCK(&dev->ld_mutex);
         dev->ld_dss_media_info->fs.status = PHO_FS_STATUS_FULL;
+        lrs_media_index_update(dev->ld_dss_media_info);
         MUTEX_UNLOCK(&dev->ld_mutex);
         rc2 = dss_media_update(&dev->ld_device_thread.dss,
                                dev->ld_dss_media_info, dev->ld_dss_media_info,
@@ -55,6 +55,12 @@ struct lrs_dev_hdl {
     unsigned long   sync_wsize_kb; /**< Written size threshold for
                                      *  medium synchronization
                                      */
+    struct timespec sync_latency_target;
+                                   /**< Bound of the time between a release
+                                     *  and its synchronization in adaptive
+                                     *  mode, zero if the time threshold is
+                                     *  sync_time_ms
+                                     */
 };
 
 /** Request pushed to a device */
@@ -188,6 +194,17 @@ struct sync_params {
                                     /**< A new grouping was added to the medium.
                                      *   The grouping field need to be updated.
                                      */
+    /* adaptive mode */
+    atomic_long      window_ms;     /**< time threshold of the device, read
+                                      *  without lock
+                                      */
+    double           sync_cost_ms;  /**< average duration of a sync, 0 if
+                                      *  unknown
+                                      */
+    double           interval_ms;   /**< average time between two releases to
+                                      *  sync, 0 if unknown
+                                      */
+    struct timespec  last_release;  /**< last release to sync */
 };
 
 /**
@@ -254,6 +271,11 @@ struct lrs_dev {
                                                   * filesystem
                                                   */
     struct sub_request  *ld_sub_request;        /**< sub request to handle */
+    struct media_info   *ld_preload_medium;     /**< medium to load ahead of
+                                                  *  the requests that will
+                                                  *  use it, locked by the
+                                                  *  scheduler
+                                                  */
     bool                 ld_ongoing_scheduled;  /**< one I/O is going to be
                                                   *  scheduled
                                                   */
@@ -265,6 +287,9 @@ struct lrs_dev {
     struct sync_params   ld_sync_params;        /**< pending synchronization
                                                   * requests
                                                   */
+    struct dss_async    *ld_dss_async;          /**< reference to the sched
+                                                  * DSS writer
+                                                  */
     struct tsqueue      *ld_response_queue;     /**< reference to the response
                                                   * queue
                                                   */
@@ -329,7 +354,7 @@ static inline bool dev_is_sched_ready(struct lrs_dev *dev)
 {
     return dev && thread_is_running(&dev->ld_device_thread) &&
            !dev->ld_ongoing_io && !dev->ld_needs_sync && !dev->ld_sub_request &&
-           !dev->ld_ongoing_scheduled &&
+           !dev->ld_ongoing_scheduled && !dev->ld_preload_medium &&
            !dev_is_failed(dev) &&
            (dev->ld_dss_dev_info->rsc.adm_status == PHO_RSC_ADM_ST_UNLOCKED);
 }
@@ -362,6 +387,42 @@ void push_new_sync_to_device(struct lrs_dev *dev, struct req_container *reqc,
  */
 int medium_sync(struct lrs_dev *dev);
 
+/**
+ * Time after which a release to sync is synchronized on \p dev.
+ *
+ * This is the sync_time_ms threshold, or the window tuned by the device in
+ * adaptive mode.
+ *
+ * @param[in]   dev     Device.
+ *
+ * @return the time threshold of the device.
+ */
+struct timespec lrs_dev_sync_window(struct lrs_dev *dev);
+
+/**
+ * In adaptive mode, record a release to sync received by \p dev at \p date
+ * and tune the sync window of the device to the interval between releases.
+ *
+ * Must be called with a lock on \p dev.
+ *
+ * @param[in]   dev     Device.
+ * @param[in]   date    Reception date of the release.
+ */
+void lrs_dev_sync_record_release(struct lrs_dev *dev,
+                                 const struct timespec *date);
+
+/**
+ * In adaptive mode, record the duration of a sync of \p dev and tune the sync
+ * window of the device to the cost of its syncs.
+ *
+ * Must be called with a lock on \p dev.
+ *
+ * @param[in]   dev         Device.
+ * @param[in]   duration    Duration of the sync.
+ */
+void lrs_dev_sync_record_cost(struct lrs_dev *dev,
+                              const struct timespec *duration);
+
 /**
  * Initialize an lrs_dev_hdl to manipulate devices from the scheduler
  *
@@ -0,0 +1,351 @@
+/* -*- mode: c; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief LRS Writable Media Index implementation
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <glib.h>
+#include <pthread.h>
+#include <string.h>
+
+#include "lrs_cfg.h"
+#include "lrs_media_index.h"
+#include "pho_common.h"
+#include "pho_type_utils.h"
+
+struct media_index {
+    pthread_mutex_t mutex;
+    bool initialized;
+    GSequence *by_free;         /**< media_info sorted by free space */
+    GHashTable *by_id;          /**< pho_id -> iterator in by_free */
+    bool loaded;
+    struct timespec loaded_at;  /**< Last reload from the DSS */
+} lrs_media_index[PHO_RSC_LAST];
+
+/* Free space, then library and name to have a total order */
+static gint media_index_cmp(gconstpointer a, gconstpointer b, gpointer udata)
+{
+    const struct media_info *medium_a = a;
+    const struct media_info *medium_b = b;
+    int rc;
+
+    (void) udata;
+
+    if (medium_a->stats.phys_spc_free != medium_b->stats.phys_spc_free)
+        return medium_a->stats.phys_spc_free < medium_b->stats.phys_spc_free ?
+            -1 : 1;
+
+    rc = strcmp(medium_a->rsc.id.library, medium_b->rsc.id.library);
+    if (rc)
+        return rc;
+
+    return strcmp(medium_a->rsc.id.name, medium_b->rsc.id.name);
+}
+
+static bool medium_is_writable(const struct media_info *medium)
+{
+    return medium->flags.put &&
+           medium->rsc.adm_status == PHO_RSC_ADM_ST_UNLOCKED &&
+           (medium->fs.status == PHO_FS_STATUS_EMPTY ||
+            medium->fs.status == PHO_FS_STATUS_USED);
+}
+
+static bool medium_matches(const struct media_info *medium,
+                           const struct media_index_query *query)
+{
+    if (query->empty_medium && medium->fs.status != PHO_FS_STATUS_EMPTY)
+        return false;
+
+    if (query->library && strcmp(medium->rsc.id.library, query->library))
+        return false;
+
+    if (query->grouping && !string_exists(&medium->groupings, query->grouping))
+        return false;
+
+    if (query->tags && query->tags->count > 0 &&
+        !string_array_in(&medium->tags, query->tags))
+        return false;
+
+    return true;
+}
+
+bool lrs_media_index_match(const struct media_info *medium,
+                           const struct media_index_query *query)
+{
+    return medium_is_writable(medium) &&
+           medium->stats.phys_spc_free >= (ssize_t)query->min_free &&
+           medium_matches(medium, query);
+}
+
+static void media_index_alloc(struct media_index *index)
+{
+    index->by_free = g_sequence_new((GDestroyNotify)media_info_free);
+    index->by_id = g_hash_table_new(g_pho_id_hash, g_pho_id_equal);
+}
+
+static void media_index_free(struct media_index *index)
+{
+    /* the keys of by_id belong to the media of by_free */
+    g_hash_table_destroy(index->by_id);
+    g_sequence_free(index->by_free);
+}
+
+/* Must be called with the index mutex held */
+static void media_index_remove(struct media_index *index,
+                               const struct pho_id *id)
+{
+    GSequenceIter *iter;
+
+    iter = g_hash_table_lookup(index->by_id, id);
+    if (!iter)
+        return;
+
+    g_hash_table_remove(index->by_id, id);
+    g_sequence_remove(iter);
+}
+
+/* Must be called with the index mutex held */
+static void media_index_insert(struct media_index *index,
+                               const struct media_info *medium)
+{
+    struct media_info *copy = media_info_dup(medium);
+    GSequenceIter *iter;
+
+    /* the lock is the one of the DSS state at load time, always check it */
+    pho_lock_clean(&copy->lock);
+
+    iter = g_sequence_insert_sorted(index->by_free, copy, media_index_cmp,
+                                    NULL);
+    g_hash_table_insert(index->by_id, &copy->rsc.id, iter);
+}
+
+int lrs_media_index_setup(enum rsc_family family)
+{
+    struct media_index *index = &lrs_media_index[family];
+
+    pthread_mutex_init(&index->mutex, NULL);
+    media_index_alloc(index);
+    index->loaded = false;
+    index->initialized = true;
+
+    return 0;
+}
+
+void lrs_media_index_cleanup(enum rsc_family family)
+{
+    struct media_index *index = &lrs_media_index[family];
+
+    if (!index->initialized)
+        return;
+
+    media_index_free(index);
+    pthread_mutex_destroy(&index->mutex);
+    index->initialized = false;
+}
+
+static int media_index_load(struct dss_handle *dss, enum rsc_family family,
+                            struct media_info **media, int *count)
+{
+    struct dss_filter filter;
+    int rc;
+
+    rc = dss_filter_build(&filter,
+                          "{\"$AND\": ["
+                          "  {\"DSS::MDA::family\": \"%s\"},"
+                          "  {\"DSS::MDA::put\": \"t\"},"
+                          "  {\"DSS::MDA::adm_status\": \"%s\"},"
+                          "  {\"$OR\": ["
+                          "    {\"DSS::MDA::fs_status\": \"%s\"},"
+                          "    {\"DSS::MDA::fs_status\": \"%s\"}"
+                          "  ]}"
+                          "]}",
+                          rsc_family2str(family),
+                          rsc_adm_status2str(PHO_RSC_ADM_ST_UNLOCKED),
+                          fs_status2str(PHO_FS_STATUS_USED),
+                          fs_status2str(PHO_FS_STATUS_EMPTY));
+    if (rc)
+        return rc;
+
+    rc = dss_media_get(dss, &filter, media, count, NULL);
+    dss_filter_free(&filter);
+
+    return rc;
+}
+
+int lrs_media_index_refresh(struct dss_handle *dss, enum rsc_family family)
+{
+    struct media_index *index = &lrs_media_index[family];
+    struct timespec refresh_period;
+    struct media_index fresh;
+    struct media_info *media;
+    struct timespec now;
+    bool stale;
+    int count;
+    int rc;
+    int i;
+
+    if (!index->initialized)
+        return -EINVAL;
+
+    rc = get_cfg_media_index_refresh_ms_value(family, &refresh_period);
+    if (rc)
+        LOG_RETURN(rc, "Failed to get media index refresh period of family "
+                   "'%s'", rsc_family2str(family));
+
+    MUTEX_LOCK(&index->mutex);
+    stale = !index->loaded ||
+            is_past(add_timespec(&index->loaded_at, &refresh_period));
+    MUTEX_UNLOCK(&index->mutex);
+
+    if (!stale)
+        return 0;
+
+    rc = clock_gettime(CLOCK_REALTIME, &now);
+    if (rc)
+        LOG_RETURN(rc = -errno, "Unable to get CLOCK_REALTIME");
+
+    rc = media_index_load(dss, family, &media, &count);
+    if (rc)
+        LOG_RETURN(rc, "Failed to load the writable media of family '%s'",
+                   rsc_family2str(family));
+
+    /* build the new index without holding the lock */
+    media_index_alloc(&fresh);
+    for (i = 0; i < count; i++)
+        media_index_insert(&fresh, &media[i]);
+
+    dss_res_free(media, count);
+
+    MUTEX_LOCK(&index->mutex);
+    media_index_free(index);
+    index->by_free = fresh.by_free;
+    index->by_id = fresh.by_id;
+    index->loaded = true;
+    index->loaded_at = now;
+    MUTEX_UNLOCK(&index->mutex);
+
+    pho_debug("Media index of family '%s' reloaded with %d media",
+              rsc_family2str(family), count);
+
+    return 0;
+}
+
+void lrs_media_index_update(const struct media_info *medium)
+{
+    struct media_index *index = &lrs_media_index[medium->rsc.id.family];
+
+    if (!index->initialized)
+        return;
+
+    MUTEX_LOCK(&index->mutex);
+    media_index_remove(index, &medium->rsc.id);
+    if (medium_is_writable(medium))
+        media_index_insert(index, medium);
+    MUTEX_UNLOCK(&index->mutex);
+}
+
+/* Must be called with the index mutex held */
+static GSequenceIter *cursor_next(struct media_index *index,
+                                  const struct media_index_query *query,
+                                  struct media_index_cursor *cursor,
+                                  bool descending)
+{
+    struct media_info key = {0};
+    GSequenceIter *iter;
+
+    if (cursor->started) {
+        key.stats.phys_spc_free = cursor->free;
+        pho_id_copy(&key.rsc.id, &cursor->id);
+    } else if (descending) {
+        return g_sequence_get_end_iter(index->by_free);
+    } else {
+        /* an empty name and library sort before any medium of this size */
+        key.stats.phys_spc_free = query->min_free;
+    }
+
+    /* the position after the media equal to the key */
+    iter = g_sequence_search(index->by_free, &key, media_index_cmp, NULL);
+    if (!descending)
+        return iter;
+
+    /* skip the last returned medium if it is still there */
+    if (!g_sequence_iter_is_begin(iter)) {
+        GSequenceIter *prev = g_sequence_iter_prev(iter);
+
+        if (media_index_cmp(g_sequence_get(prev), &key, NULL) == 0)
+            iter = prev;
+    }
+
+    return iter;
+}
+
+struct media_info *lrs_media_index_next(enum rsc_family family,
+                                        const struct media_index_query *query,
+                                        struct media_index_cursor *cursor,
+                                        bool descending)
+{
+    struct media_index *index = &lrs_media_index[family];
+    struct media_info *medium = NULL;
+    GSequenceIter *iter;
+
+    if (!index->initialized)
+        return NULL;
+
+    MUTEX_LOCK(&index->mutex);
+    iter = cursor_next(index, query, cursor, descending);
+    while (true) {
+        struct media_info *curr;
+
+        if (descending) {
+            if (g_sequence_iter_is_begin(iter))
+                break;
+            iter = g_sequence_iter_prev(iter);
+        } else if (g_sequence_iter_is_end(iter)) {
+            break;
+        }
+
+        curr = g_sequence_get(iter);
+        if (curr->stats.phys_spc_free < (ssize_t)query->min_free)
+            /* when descending, all the next ones are smaller */
+            break;
+
+        if (medium_matches(curr, query)) {
+            medium = media_info_dup(curr);
+            break;
+        }
+
+        if (!descending)
+            iter = g_sequence_iter_next(iter);
+    }
+
+    if (medium) {
+        cursor->started = true;
+        cursor->free = medium->stats.phys_spc_free;
+        pho_id_copy(&cursor->id, &medium->rsc.id);
+    }
+    MUTEX_UNLOCK(&index->mutex);
+
+    return medium;
+}
@@ -0,0 +1,111 @@
+/* -*- mode: c; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief LRS Writable Media Index prototypes
+ *
+ * The index keeps, for each family, the media that may be written to (put
+ * flag set, administratively unlocked, empty or used) sorted by free space.
+ * It is loaded from the DSS, kept up to date by the LRS when it updates a
+ * medium, and reloaded periodically to catch the changes made by other
+ * hosts or directly in the DSS. Its content is therefore a hint: a medium
+ * selected through the index must be checked against the DSS before use.
+ */
+#ifndef _PHO_LRS_MEDIA_INDEX_H
+#define _PHO_LRS_MEDIA_INDEX_H
+
+#include "pho_dss.h"
+#include "pho_types.h"
+
+/** Criteria of the media to look for */
+struct media_index_query {
+    const char *library;                /**< NULL for any library */
+    const char *grouping;               /**< NULL for any grouping */
+    const struct string_array *tags;    /**< Tags the media must have, may be
+                                          *  NULL
+                                          */
+    bool empty_medium;                  /**< Only select empty media */
+    size_t min_free;                    /**< Minimal free space */
+};
+
+/** Position in the index, to be zero-initialized before the first lookup */
+struct media_index_cursor {
+    bool started;
+    size_t free;                        /**< Free space of the last medium */
+    struct pho_id id;                   /**< Last medium returned */
+};
+
+int lrs_media_index_setup(enum rsc_family family);
+
+void lrs_media_index_cleanup(enum rsc_family family);
+
+/**
+ * Reload the index of \p family from the DSS if it was never loaded or if it
+ * was loaded more than "media_index_refresh_ms" ago.
+ *
+ * @param[in]  dss     DSS handle to use.
+ * @param[in]  family  Family of the index to refresh.
+ *
+ * @return 0 on success, -errno on failure.
+ */
+int lrs_media_index_refresh(struct dss_handle *dss, enum rsc_family family);
+
+/**
+ * Take into account a new state of a medium: it is added, updated or removed
+ * from the index of its family depending on whether it can be written to.
+ *
+ * @param[in]  medium  New state of the medium.
+ */
+void lrs_media_index_update(const struct media_info *medium);
+
+/**
+ * Check whether a medium can be written to and matches \p query.
+ *
+ * @param[in]  medium  Medium to check.
+ * @param[in]  query   Criteria of the medium.
+ *
+ * @return true if the medium matches, false otherwise.
+ */
+bool lrs_media_index_match(const struct media_info *medium,
+                           const struct media_index_query *query);
+
+/**
+ * Get the next medium matching \p query.
+ *
+ * The media are returned by increasing free space, starting at
+ * query->min_free, or by decreasing free space if \p descending is set. The
+ * lookup is in O(log n), plus the number of media skipped because they do
+ * not match the query.
+ *
+ * @param[in]      family      Family of the index.
+ * @param[in]      query       Criteria of the medium.
+ * @param[in, out] cursor      Position of the previous lookup.
+ * @param[in]      descending  Direction of the lookup.
+ *
+ * @return a copy of the medium, to be freed by media_info_free, or NULL if
+ *         there is no more matching medium.
+ */
+struct media_info *lrs_media_index_next(enum rsc_family family,
+                                        const struct media_index_query *query,
+                                        struct media_index_cursor *cursor,
+                                        bool descending);
+
+#endif
@@ -30,6 +30,7 @@
 #include "lrs_cache.h"
 #include "lrs_cfg.h"
 #include "lrs_device.h"
+#include "lrs_media_index.h"
 #include "lrs_sched.h"
 #include "lrs_utils.h"
 #include "pho_common.h"
@@ -678,6 +679,8 @@ int sched_init(struct lrs_sched *sched, enum rsc_family family,
                    "failed to initialize media cache for family '%s'",
                    rsc_family2str(sched->family));
 
+    lrs_media_index_setup(sched->family);
+
     rc = format_media_init(&sched->ongoing_format);
     if (rc)
         LOG_GOTO(err_clean_cache, rc,  "Failed to init sched format media");
@@ -695,9 +698,13 @@ int sched_init(struct lrs_sched *sched, enum rsc_family family,
     if (rc)
         LOG_GOTO(err_dss_fini, rc, "Failed to get hostname and PID");
 
+    rc = dss_async_init(&sched->dss_async);
+    if (rc)
+        LOG_GOTO(err_dss_fini, rc, "Failed to init sched dss writer");
+
     rc = tsqueue_init(&sched->incoming);
     if (rc)
-        LOG_GOTO(err_dss_fini, rc, "Failed to init sched incoming");
+        LOG_GOTO(err_async_fini, rc, "Failed to init sched incoming");
 
     rc = tsqueue_init(&sched->retry_queue);
     if (rc)
@@ -743,6 +750,8 @@ err_retry_queue_fini:
     tsqueue_destroy(&sched->retry_queue, sched_req_free);
 err_incoming_fini:
     tsqueue_destroy(&sched->incoming, sched_req_free);
+err_async_fini:
+    dss_async_fini(sched->dss_async);
 err_dss_fini:
     dss_fini(&sched->sched_thread.dss);
 err_hdl_fini:
@@ -750,6 +759,7 @@ err_hdl_fini:
 err_format_media:
     format_media_clean(&sched->ongoing_format);
 err_clean_cache:
+    lrs_media_index_cleanup(family);
     lrs_cache_cleanup(family);
     return rc;
 }
@@ -827,10 +837,15 @@ void sched_fini(struct lrs_sched *sched)
     lrs_dev_hdl_clear(&sched->devices, sched);
     io_sched_fini(&sched->io_sched_hdl);
     lrs_dev_hdl_fini(&sched->devices);
+    /* after the devices, which may still have updates to write */
+    dss_async_fini(sched->dss_async);
     dss_fini(&sched->sched_thread.dss);
+    tsqueue_log_stats(&sched->incoming, "incoming");
     tsqueue_destroy(&sched->incoming, sched_req_free);
+    tsqueue_log_stats(&sched->retry_queue, "retry");
     tsqueue_destroy(&sched->retry_queue, sub_request_free_cb);
     format_media_clean(&sched->ongoing_format);
+    lrs_media_index_cleanup(sched->family);
     lrs_cache_cleanup(sched->family);
 }
 
@@ -845,7 +860,7 @@ bool sched_has_running_devices(struct lrs_sched *sched)
         MUTEX_LOCK(&dev->ld_mutex);
         if (dev->ld_ongoing_io || dev->ld_needs_sync || dev->ld_sub_request ||
             dev->ld_sync_params.tosync_array->len ||
-            dev->ld_ongoing_scheduled) {
+            dev->ld_ongoing_scheduled || dev->ld_preload_medium) {
             MUTEX_UNLOCK(&dev->ld_mutex);
             return true;
         }
@@ -856,77 +871,6 @@ bool sched_has_running_devices(struct lrs_sched *sched)
     return false;
 }
 
-/**
- * Build a filter string fragment to filter on a given tag array. The returned
- * string is allocated with malloc. NULL is returned when ENOMEM is encountered.
- *
- * The returned string looks like the following:
- * {"$AND": [{"$XJSON": {"DSS:MDA::tags": "tag1"}}]}
- */
-static char *build_tag_filter(const struct string_array *tags)
-{
-    json_t *and_filter = NULL;
-    json_t *tag_filters = NULL;
-    char   *tag_filter_json = NULL;
-    size_t  i;
-
-    /* Build a json array to properly format tag related DSS filter */
-    tag_filters = json_array();
-    if (!tag_filters)
-        return NULL;
-
-    /* Build and append one filter per tag */
-    for (i = 0; i < tags->count; i++) {
-        json_t *tag_flt;
-        json_t *xjson;
-
-        tag_flt = json_object();
-        if (!tag_flt)
-            GOTO(out, -ENOMEM);
-
-        xjson = json_object();
-        if (!xjson) {
-            json_decref(tag_flt);
-            GOTO(out, -ENOMEM);
-        }
-
-        if (json_object_set_new(tag_flt, "DSS::MDA::tags",
-                                json_string(tags->strings[i]))) {
-            json_decref(tag_flt);
-            json_decref(xjson);
-            GOTO(out, -ENOMEM);
-        }
-
-        if (json_object_set_new(xjson, "$XJSON", tag_flt)) {
-            json_decref(xjson);
-            GOTO(out, -ENOMEM);
-        }
-
-        if (json_array_append_new(tag_filters, xjson))
-            GOTO(out, -ENOMEM);
-    }
-
-    and_filter = json_object();
-    if (!and_filter)
-        GOTO(out, -ENOMEM);
-
-    /* Do not use the _new function and decref inconditionnaly later */
-    if (json_object_set(and_filter, "$AND", tag_filters))
-        GOTO(out, -ENOMEM);
-
-    /* Convert to string for formatting */
-    tag_filter_json = json_dumps(and_filter, 0);
-
-out:
-    json_decref(tag_filters);
-
-    /* json_decref(NULL) is safe but not documented */
-    if (and_filter)
-        json_decref(and_filter);
-
-    return tag_filter_json;
-}
-
 /**
  * Check if medium is already selected in request
  *
@@ -988,9 +932,109 @@ static int medium_in_devices(const struct media_info *medium,
     return 0;
 }
 
+/**
+ * Check that a medium of the media index can be used by a write allocation.
+ *
+ * The index may be outdated, so the medium is reloaded from the DSS and
+ * checked against \p query again before checking its lock, health and usage.
+ *
+ * @param[in]     io_sched    Current I/O scheduler
+ * @param[in]     candidate   Medium found in the index
+ * @param[in]     query       Criteria the medium must match
+ * @param[in]     reqc        Current write alloc request container
+ * @param[in]     n_med       Nb already allocated media
+ * @param[in]     not_alloc   Index to ignore in \p reqc allocated media
+ * @param[in,out] avail_size  If not NULL, incremented by the free space of
+ *                            \p candidate unless it is already allocated
+ * @param[out]    p_media     Fresh copy of the medium from the DSS, to be
+ *                            freed by media_info_free, if it can be used
+ *
+ * @return 0 if the medium can be used, 1 if it cannot, -errno on error
+ */
+static int check_index_candidate(struct io_scheduler *io_sched,
+                                 const struct media_info *candidate,
+                                 const struct media_index_query *query,
+                                 struct req_container *reqc, size_t n_med,
+                                 size_t not_alloc, size_t *avail_size,
+                                 struct media_info **p_media)
+{
+    struct lock_handle *lock_handle = io_sched->io_sched_hdl->lock_handle;
+    struct media_info *curr = NULL;
+    struct lrs_dev *dev = NULL;
+    bool already_alloc;
+    bool sched_ready;
+    int mcnt = 0;
+    int rc;
+
+    /* exclude medium already booked for this allocation */
+    rc = medium_in_devices(candidate, reqc, n_med, not_alloc, &already_alloc);
+    if (rc)
+        LOG_RETURN(-EAGAIN, "Unable to test if medium is already alloc");
+
+    if (already_alloc)
+        return 1;
+
+    if (avail_size)
+        *avail_size += candidate->stats.phys_spc_free;
+
+    rc = dss_media_get_from_id(lock_handle->dss, &candidate->rsc.id, &curr,
+                               &mcnt);
+    if (rc)
+        return rc;
+
+    if (mcnt == 0)
+        GOTO(free_res, rc = 1);
+
+    lrs_media_index_update(curr);
+    if (!lrs_media_index_match(curr, query)) {
+        pho_debug("Medium (family '%s', name '%s', library '%s') changed since "
+                  "it was indexed, skipping it",
+                  rsc_family2str(curr->rsc.id.family), curr->rsc.id.name,
+                  curr->rsc.id.library);
+        GOTO(free_res, rc = 1);
+    }
+
+    /* already locked */
+    if (curr->lock.hostname != NULL)
+        if (check_renew_lock(lock_handle, DSS_MEDIA, curr, &curr->lock))
+            /* not locked by myself */
+            GOTO(free_res, rc = 1);
+
+    rc = dss_medium_health(lock_handle->dss, &curr->rsc.id, max_health(),
+                           &curr->health);
+    if (rc)
+        GOTO(free_res, rc = 1);
+
+    /* already loaded and in use ? */
+    dev = search_in_use_medium(io_sched->io_sched_hdl->global_device_list,
+                               curr->rsc.id.name, curr->rsc.id.library,
+                               &sched_ready);
+    if (dev && (!sched_ready ||
+                /* we cannot use a medium that doesn't belong to the write
+                 * I/O scheduler.
+                 */
+                !(dev->ld_io_request_type & io_sched->type))) {
+        pho_debug("Skipping device '%s', already in use",
+                  dev->ld_dss_dev_info->rsc.id.name);
+        GOTO(free_res, rc = 1);
+    }
+
+    *p_media = media_info_dup(curr);
+
+free_res:
+    dss_res_free(curr, mcnt);
+
+    return rc;
+}
+
 /**
  * Get a suitable medium for a write operation.
  *
+ * The candidates are looked for in the in-memory index of the writable media
+ * of the family: the best fit is the first medium of the index, by increasing
+ * free space, with enough room for \p required_size. Only if there is none,
+ * the medium with the most free space is selected to split the write on.
+ *
  * @param[in]  sched         Current scheduler
  * @param[out] p_media       Selected medium
  * @param[in]  required_size Size of the extent to be written.
@@ -1020,172 +1064,87 @@ int sched_select_medium(struct io_scheduler *io_sched,
                         bool *need_new_grouping)
 {
     struct lock_handle *lock_handle = io_sched->io_sched_hdl->lock_handle;
-    bool with_tags = tags != NULL && tags->count > 0;
-    struct media_info *split_media_best = NULL;
-    struct media_info *whole_media_best = NULL;
+    struct media_index_query query = {
+        .library = library,
+        .grouping = grouping,
+        .tags = tags,
+        .empty_medium = reqc->req->walloc->media[0]->empty_medium,
+    };
+    struct media_index_cursor cursor = {0};
     struct media_info *chosen_media = NULL;
-    struct media_info *pmedia_res = NULL;
-    char *tag_filter_json = NULL;
-    struct dss_filter filter;
+    bool no_split = reqc->req->walloc->no_split;
+    struct media_info *curr;
     size_t avail_size = 0;
+    size_t min_free;
     int mcnt = 0;
-    int rc;
-    int i;
+    int rc = 0;
 
     ENTRY;
 
     *need_new_grouping = false;
 
-    if (with_tags) {
-        tag_filter_json = build_tag_filter(tags);
-        if (!tag_filter_json)
-            LOG_GOTO(err_nores, rc = -ENOMEM, "while building tags dss filter");
-    }
-
-    if (reqc->req->walloc->media[0]->empty_medium)
-        rc = dss_filter_build(&filter,
-                              "{\"$AND\": ["
-                              "  {\"DSS::MDA::family\": \"%s\"},"
-                              "  {\"DSS::MDA::put\": \"t\"},"
-                              "  {\"DSS::MDA::adm_status\": \"%s\"},"
-                              "  {\"DSS::MDA::fs_status\": \"%s\"}"
-                              "  %s%s%s"
-                              "  %s%s%s"
-                              "  %s%s"
-                              "]}",
-                              rsc_family2str(family),
-                              rsc_adm_status2str(PHO_RSC_ADM_ST_UNLOCKED),
-                              fs_status2str(PHO_FS_STATUS_EMPTY),
-                              library ? ", {\"DSS::MDA::library\": \"" : "",
-                              library ? library : "",
-                              library ? "\"}" : "",
-                              grouping ? ", {\"$XJSON\": "
-                                         "{\"DSS::MDA::groupings\": \"" : "",
-                              grouping ? grouping : "",
-                              grouping ? "\"}}" : "",
-                              with_tags ? ", " : "",
-                              with_tags ? tag_filter_json : "");
-    else
-        rc = dss_filter_build(&filter,
-                              "{\"$AND\": ["
-                              /* Basic criteria */
-                              "  {\"DSS::MDA::family\": \"%s\"},"
-                              /* Check put media operation flags */
-                              "  {\"DSS::MDA::put\": \"t\"},"
-                              /* Exclude media locked by admin */
-                              "  {\"DSS::MDA::adm_status\": \"%s\"},"
-                              "  {\"$OR\": ["
-                                   /* Include used media */
-                              "    {\"DSS::MDA::fs_status\": \"%s\"},"
-                                   /* Include empty media */
-                              "    {\"DSS::MDA::fs_status\": \"%s\"}"
-                              "  ]}"
-                              "  %s%s%s"
-                              "  %s%s%s"
-                              "  %s%s"
-                              "]}",
-                              rsc_family2str(family),
-                              rsc_adm_status2str(PHO_RSC_ADM_ST_UNLOCKED),
-                              /**
-                               * @TODO add criteria to limit the maximum number
-                               * of data fragments:
-                               * vol_free >= required_size/max_fragments with a
-                               * configurable max_fragments of 4 for example)
-                               */
-                              fs_status2str(PHO_FS_STATUS_USED),
-                              fs_status2str(PHO_FS_STATUS_EMPTY),
-                              library ? ", {\"DSS::MDA::library\": \"" : "",
-                              library ? library : "",
-                              library ? "\"}" : "",
-                              grouping ? ", {\"$XJSON\": "
-                                         "{\"DSS::MDA::groupings\": \"" : "",
-                              grouping ? grouping : "",
-                              grouping ? "\"}}" : "",
-                              with_tags ? ", " : "",
-                              with_tags ? tag_filter_json : "");
-
-    free(tag_filter_json);
+    rc = lrs_media_index_refresh(lock_handle->dss, family);
     if (rc)
         return rc;
 
-    rc = dss_media_get(lock_handle->dss, &filter, &pmedia_res,
-                       &mcnt, NULL);
-    if (mcnt == 0) {
-        char *dump = json_dumps(filter.df_json, JSON_COMPACT);
-
-        pho_warn("No medium found matching query: %s", dump);
-        dss_filter_free(&filter);
-        free(dump);
-        if (grouping)
-            *need_new_grouping = true;
-
-        GOTO(free_res, rc = -ENOSPC);
+    /* get the best fit: the smallest medium with enough room, a no-split
+     * allocation excludes the media of exactly the required size
+     */
+    min_free = required_size + (no_split ? 1 : 0);
+    query.min_free = min_free;
+    while (!chosen_media &&
+           (curr = lrs_media_index_next(family, &query, &cursor, false))) {
+        rc = check_index_candidate(io_sched, curr, &query, reqc, n_med,
+                                   not_alloc, &avail_size, &chosen_media);
+        mcnt++;
+        media_info_free(curr);
+        if (rc < 0)
+            return rc;
     }
 
-    dss_filter_free(&filter);
-    if (rc)
-        GOTO(err_nores, rc);
+    if (chosen_media)
+        goto select;
 
-    /* get the best fit */
-    for (i = 0; i < mcnt; i++) {
-        struct media_info *curr = &pmedia_res[i];
-        struct lrs_dev *dev = NULL;
+    /* no medium is big enough, count the space of the smaller ones and
+     * split on the medium with the most free space
+     */
+    query.min_free = 0;
+    memset(&cursor, 0, sizeof(cursor));
+    while ((curr = lrs_media_index_next(family, &query, &cursor, true))) {
         bool already_alloc;
-        bool sched_ready;
 
-        /* exclude medium already booked for this allocation */
-        rc = medium_in_devices(curr, reqc, n_med, not_alloc, &already_alloc);
-        if (rc)
-            LOG_GOTO(free_res, rc = -EAGAIN,
-                     "Unable to test if medium is already alloc");
-
-        if (already_alloc)
+        if (curr->stats.phys_spc_free >= (ssize_t)min_free) {
+            /* already taken into account by the best fit lookup */
+            media_info_free(curr);
             continue;
+        }
 
+        mcnt++;
         /* exclude medium too small to do a no-split */
-        if (reqc->req->walloc->no_split &&
-            curr->stats.phys_spc_free <= required_size)
-            continue;
-
-        avail_size += curr->stats.phys_spc_free;
+        if (no_split) {
+            media_info_free(curr);
+            break;
+        }
 
-        /* already locked */
-        if (curr->lock.hostname != NULL)
-            if (check_renew_lock(lock_handle, DSS_MEDIA, curr,
-                                 &curr->lock))
-                /* not locked by myself */
-                continue;
+        rc = medium_in_devices(curr, reqc, n_med, not_alloc, &already_alloc);
+        if (!rc && !already_alloc)
+            avail_size += curr->stats.phys_spc_free;
 
-        rc = dss_medium_health(lock_handle->dss, &curr->rsc.id, max_health(),
-                               &curr->health);
+        media_info_free(curr);
         if (rc)
-            continue;
-
-        /* already loaded and in use ? */
-        dev = search_in_use_medium(io_sched->io_sched_hdl->global_device_list,
-                                   curr->rsc.id.name, curr->rsc.id.library,
-                                   &sched_ready);
-        if (dev && (!sched_ready ||
-                    /* we cannot use a medium that doesn't belong to the write
-                     * I/O scheduler.
-                     */
-                    !(dev->ld_io_request_type & io_sched->type))) {
-            pho_debug("Skipping device '%s', already in use",
-                      dev->ld_dss_dev_info->rsc.id.name);
-            continue;
-        }
-
-        if (!reqc->req->walloc->no_split &&
-            (split_media_best == NULL ||
-             curr->stats.phys_spc_free > split_media_best->stats.phys_spc_free))
-                split_media_best = curr;
+            LOG_RETURN(-EAGAIN, "Unable to test if medium is already alloc");
+    }
 
-        if (curr->stats.phys_spc_free < required_size)
-            continue;
+    if (mcnt == 0) {
+        pho_warn("No medium found matching query (family '%s', library '%s', "
+                 "grouping '%s', %zu tags%s)", rsc_family2str(family),
+                 library ? : "any", grouping ? : "none",
+                 tags ? tags->count : 0,
+                 query.empty_medium ? ", empty" : "");
+        if (grouping)
+            *need_new_grouping = true;
 
-        if (whole_media_best == NULL ||
-            curr->stats.phys_spc_free < whole_media_best->stats.phys_spc_free)
-            whole_media_best = curr;
+        return -ENOSPC;
     }
 
     if (avail_size < required_size) {
@@ -1194,26 +1153,37 @@ int sched_select_medium(struct io_scheduler *io_sched,
         if (grouping)
             *need_new_grouping = true;
 
-        GOTO(free_res, rc = -ENOSPC);
+        return -ENOSPC;
     }
 
-    if (whole_media_best != NULL) {
-        chosen_media = whole_media_best;
-    } else if (split_media_best != NULL) {
-        chosen_media = split_media_best;
-        pho_info("Split %zd required_size on %zd avail size on medium (family "
-                 "'%s', name '%s', library '%s')",
-                 required_size, chosen_media->stats.phys_spc_free,
-                 rsc_family2str(chosen_media->rsc.id.family),
-                 chosen_media->rsc.id.name, chosen_media->rsc.id.library);
-    } else {
+    memset(&cursor, 0, sizeof(cursor));
+    while (!no_split && !chosen_media &&
+           (curr = lrs_media_index_next(family, &query, &cursor, true))) {
+        /* the bigger ones were already checked by the best fit lookup */
+        if (curr->stats.phys_spc_free < (ssize_t)min_free)
+            rc = check_index_candidate(io_sched, curr, &query, reqc, n_med,
+                                       not_alloc, NULL, &chosen_media);
+        media_info_free(curr);
+        if (rc < 0)
+            return rc;
+    }
+
+    if (!chosen_media) {
         pho_debug("No medium available, wait for one");
         if (grouping)
             *need_new_grouping = true;
 
-        GOTO(free_res, rc = -EAGAIN);
+        return -EAGAIN;
     }
 
+select:
+    if (chosen_media->stats.phys_spc_free < (ssize_t)required_size)
+        pho_info("Split %zd required_size on %zd avail size on medium (family "
+                 "'%s', name '%s', library '%s')",
+                 required_size, chosen_media->stats.phys_spc_free,
+                 rsc_family2str(chosen_media->rsc.id.family),
+                 chosen_media->rsc.id.name, chosen_media->rsc.id.library);
+
     pho_verb("Selected medium (family '%s', name '%s', library '%s'): %zd "
              "bytes free", rsc_family2str(family), chosen_media->rsc.id.name,
              chosen_media->rsc.id.library, chosen_media->stats.phys_spc_free);
@@ -1227,10 +1197,8 @@ int sched_select_medium(struct io_scheduler *io_sched,
     else
         rc = 0;
 
-free_res:
-    dss_res_free(pmedia_res, mcnt);
+    media_info_free(chosen_media);
 
-err_nores:
     return rc;
 }
 
@@ -1355,7 +1323,7 @@ struct lrs_dev *dev_picker(GPtrArray *devices,
 
         MUTEX_LOCK(&itr->ld_mutex);
         if (itr->ld_ongoing_io || itr->ld_needs_sync || itr->ld_sub_request ||
-            itr->ld_ongoing_scheduled) {
+            itr->ld_ongoing_scheduled || itr->ld_preload_medium) {
             pho_debug("Skipping busy device '%s'", itr->ld_dev_path);
             goto unlock_continue;
         }
@@ -1946,14 +1914,32 @@ static void sched_write_alloc_add_threshold(struct lrs_sched *sched,
                                             struct resp_container *respc)
 {
     pho_resp_write_t *wresp = respc->resp->walloc;
+    struct timespec sync_time = sched->devices.sync_time_ms;
+    bool first = true;
+    size_t i;
+
+    /* the earliest sync of the allocated devices, whose time threshold may
+     * be tuned in adaptive mode
+     */
+    for (i = 0; i < respc->devices_len; i++) {
+        struct timespec window;
+
+        if (!respc->devices[i])
+            continue;
+
+        window = lrs_dev_sync_window(respc->devices[i]);
+        if (first || cmp_timespec(&window, &sync_time) < 0)
+            sync_time = window;
+        first = false;
+    }
 
     wresp->threshold = xmalloc(sizeof(*wresp->threshold));
     pho_sync_threshold__init(wresp->threshold);
 
     wresp->threshold->sync_nb_req    = sched->devices.sync_nb_req;
     wresp->threshold->sync_wsize_kb  = sched->devices.sync_wsize_kb;
-    wresp->threshold->sync_time_sec  = sched->devices.sync_time_ms.tv_sec;
-    wresp->threshold->sync_time_nsec = sched->devices.sync_time_ms.tv_nsec;
+    wresp->threshold->sync_time_sec  = sync_time.tv_sec;
+    wresp->threshold->sync_time_nsec = sync_time.tv_nsec;
 }
 
 /**
@@ -2894,6 +2880,50 @@ int lrs_schedule_work(struct lrs_sched *sched)
     return rc == -EAGAIN ? 0 : rc;
 }
 
+/**
+ * Load ahead, in idle devices, the media that the queued reads will need, so
+ * that the robot moves and the mounts overlap with the I/Os of the other
+ * devices.
+ */
+static void sched_prefetch_media(struct lrs_sched *sched)
+{
+    while (running) {
+        struct media_info *medium;
+        struct lrs_dev *dev;
+        int rc;
+
+        rc = io_sched_prefetch(&sched->io_sched_hdl, &dev, &medium);
+        if (rc) {
+            pho_error(rc, "'%s' scheduler: failed to select a medium to "
+                      "prefetch", rsc_family2str(sched->family));
+            return;
+        }
+
+        if (!dev)
+            return;
+
+        /* the device releases the lock if it cannot load the medium */
+        rc = ensure_medium_lock(&sched->lock_handle, medium);
+        if (rc) {
+            pho_verb("Cannot lock medium (family '%s', name '%s', library "
+                     "'%s') to prefetch it",
+                     rsc_family2str(medium->rsc.id.family),
+                     medium->rsc.id.name, medium->rsc.id.library);
+            lrs_medium_release(medium);
+            return;
+        }
+
+        pho_debug("prefetch: medium '%s' in device '%s'",
+                  medium->rsc.id.name, dev->ld_dss_dev_info->rsc.id.name);
+
+        MUTEX_LOCK(&dev->ld_mutex);
+        dev->ld_preload_medium = medium;
+        MUTEX_UNLOCK(&dev->ld_mutex);
+
+        thread_signal(&dev->ld_device_thread);
+    }
+}
+
 static void _json_object_set_str(struct json_t *object,
                                  const char *key,
                                  const char *value)
@@ -3052,6 +3082,8 @@ static void *lrs_sched_thread(void *sdata)
                      "'%s' scheduler: error while scheduling requests",
                      rsc_family2str(sched->family));
 
+        sched_prefetch_media(sched);
+
         rc = compute_wakeup_time(&timeout, &wakeup_date);
         if (rc)
             GOTO(end_thread, thread->status = rc);
@@ -101,6 +101,9 @@ struct lrs_sched {
     struct thread_info     sched_thread;   /**< thread handling the actions
                                              *  executed by the scheduler
                                              */
+    struct dss_async      *dss_async;      /**< writer of the updates which
+                                             *  need not be waited for
+                                             */
     struct io_sched_handle io_sched_hdl;   /**< I/O scheduler handle */
 };
 
@@ -209,6 +212,12 @@ struct req_container {
     int socket_id;                  /**< Socket ID to pass to the response. */
     pho_req_t *req;                 /**< Request. */
     struct timespec received_at;    /**< Request reception timestamp */
+    struct timespec deadline;       /**< Time by which the request should be
+                                      *  scheduled, zero if none
+                                      */
+    double vstart;                  /**< Virtual start time of the request,
+                                      *  see io_sched_tag_request
+                                      */
     union {                         /**< Parameters used by the LRS. */
         struct release_params release;
         struct format_params format;
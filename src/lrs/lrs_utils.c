@@ -204,6 +204,17 @@ struct lrs_dev *search_in_use_medium(GPtrArray *devices, const char *name,
         }
 
 check_load:
+        if (dev->ld_preload_medium != NULL) {
+            media_id = &dev->ld_preload_medium->rsc.id;
+            if (!strcmp(name, media_id->name) &&
+                !strcmp(library, media_id->library)) {
+                MUTEX_UNLOCK(&dev->ld_mutex);
+                pho_debug("Found '%s' being preloaded in '%s'",
+                          name, dev->ld_dss_dev_info->rsc.id.name);
+                return dev;
+            }
+        }
+
         if (dev->ld_op_status != PHO_DEV_OP_ST_EMPTY) {
             /* The drive may contain a media unknown to phobos, skip it */
             if (dev->ld_dss_media_info == NULL)
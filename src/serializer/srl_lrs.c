@@ -154,6 +154,9 @@ void pho_srl_request_read_alloc(pho_req_t *req, size_t n_media)
 
     req->ralloc->n_med_ids = n_media;
     req->ralloc->med_ids = xmalloc(n_media * sizeof(*req->ralloc->med_ids));
+    req->ralloc->n_positions = n_media;
+    req->ralloc->positions = xcalloc(n_media,
+                                     sizeof(*req->ralloc->positions));
 
     for (i = 0; i < n_media; ++i) {
         req->ralloc->med_ids[i] = xmalloc(sizeof(*req->ralloc->med_ids[i]));
@@ -264,6 +267,7 @@ void pho_srl_request_free(pho_req_t *req, bool unpack)
             free(req->ralloc->med_ids[i]);
         }
         free(req->ralloc->med_ids);
+        free(req->ralloc->positions);
         free(req->ralloc);
         req->ralloc = NULL;
     }
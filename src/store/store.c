@@ -38,11 +38,13 @@
 #include "pho_srl_lrs.h"
 #include "pho_type_utils.h"
 #include "pho_types.h"
+#include "store_md_cache.h"
 #include "store_profile.h"
 #include "store_utils.h"
 
 #include <attr/xattr.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
@@ -51,6 +53,7 @@
 
 #define RETRY_SLEEP_MAX_US (1000 * 1000) /* 1 second */
 #define RETRY_SLEEP_MIN_US (10 * 1000)   /* 10 ms */
+#define LRS_RESP_WAIT_MS   (10 * 1000)   /* 10 seconds */
 
 /**
  * List of configuration parameters for store
@@ -60,12 +63,66 @@ enum pho_cfg_params_store {
 
     /* store parameters */
     PHO_CFG_STORE_lrs_socket = PHO_CFG_STORE_FIRST,
+    PHO_CFG_STORE_md_batch_size,
+    PHO_CFG_STORE_read_priority,
+    PHO_CFG_STORE_write_priority,
+    PHO_CFG_STORE_read_deadline_ms,
+    PHO_CFG_STORE_write_deadline_ms,
+    PHO_CFG_STORE_io_workers,
 
     PHO_CFG_STORE_LAST
 };
 
 const struct pho_config_item cfg_store[] = {
     [PHO_CFG_STORE_lrs_socket] = LRS_SOCKET_CFG_ITEM,
+    [PHO_CFG_STORE_md_batch_size] = {
+        .section = "store",
+        .name    = "md_batch_size",
+        .value   = "256",
+    },
+    [PHO_CFG_STORE_read_priority] = {
+        .section = "store",
+        .name    = "read_priority",
+        .value   = "0",
+    },
+    [PHO_CFG_STORE_write_priority] = {
+        .section = "store",
+        .name    = "write_priority",
+        .value   = "0",
+    },
+    [PHO_CFG_STORE_read_deadline_ms] = {
+        .section = "store",
+        .name    = "read_deadline_ms",
+        .value   = "0",
+    },
+    [PHO_CFG_STORE_write_deadline_ms] = {
+        .section = "store",
+        .name    = "write_deadline_ms",
+        .value   = "0",
+    },
+    [PHO_CFG_STORE_io_workers] = {
+        .section = "store",
+        .name    = "io_workers",
+        .value   = "4",
+    },
+};
+
+/** Scheduling hints given to the LRS for one kind of request */
+struct lrs_sched_hints {
+    unsigned int priority;
+    unsigned int deadline_ms;       /**< 0 for none */
+};
+
+/**
+ * Step of an encoder given a read or write allocation, whose data movement is
+ * run by an I/O worker.
+ */
+struct store_step {
+    int enc_id;                     /**< Index of the encoder */
+    pho_resp_t *resp;               /**< Allocation given to the encoder */
+    int rc;                         /**< Result of the step */
+    pho_req_t *requests;            /**< Requests emitted by the step */
+    size_t n_reqs;                  /**< Number of requests emitted */
 };
 
 /**
@@ -96,6 +153,47 @@ struct phobos_handle {
 
     pho_completion_cb_t cb;         /**< Callback called on xfer completion */
     void *udata;                    /**< User-provided argument to `cb` */
+    unsigned int rand_seed;         /**< Seed of the retry backoff delays */
+    pho_resp_t **enc_retry;         /**< -EAGAIN responses held until
+                                      *  enc_retry_at, so that their encoders
+                                      *  retry their requests later without
+                                      *  stalling the dispatch thread
+                                      */
+    struct timespec *enc_retry_at;  /**< Monotonic date at which the held
+                                      *  responses are given to the encoders
+                                      */
+
+    size_t md_batch_size;           /**< Maximum number of puts whose
+                                      *  metadata are saved in the same
+                                      *  transaction, 1 to disable batching
+                                      */
+    size_t *md_pending;             /**< Indexes of the successful puts whose
+                                      *  layouts are not saved yet
+                                      */
+    size_t n_md_pending;            /**< Number of items in md_pending */
+
+    struct lrs_sched_hints read_hints;  /**< Hints of the read allocations */
+    struct lrs_sched_hints write_hints; /**< Hints of the write allocations */
+
+    /* The data movement of the encoders is run by I/O workers, so that the
+     * dispatch thread keeps serving the LRS responses of the other encoders
+     * and several xfers move data concurrently.
+     */
+    pthread_t *workers;             /**< I/O worker threads */
+    size_t n_workers;               /**< Number of I/O workers, 0 to run the
+                                      *  steps in the dispatch thread
+                                      */
+    pthread_mutex_t steps_mutex;    /**< Protects the fields below */
+    pthread_cond_t steps_cond;      /**< Signaled when a step is submitted */
+    GQueue *steps_todo;             /**< Steps waiting for a worker */
+    GQueue *steps_done;             /**< Steps run, to be dispatched */
+    bool workers_stopping;
+    bool *enc_busy;                 /**< Whether the step of an encoder is
+                                      *  submitted and not dispatched yet
+                                      */
+    GQueue **enc_deferred;          /**< LRS responses received while the
+                                      *  encoder is busy
+                                      */
 };
 
 int phobos_init(void)
@@ -111,6 +209,7 @@ int phobos_init(void)
 
 void phobos_fini(void)
 {
+    md_cache_fini();
     pho_context_fini();
 }
 
@@ -167,70 +266,91 @@ static int pho_xfer_desc_flag_check(const struct pho_xfer_desc *xfer)
 static int decoder_build(struct pho_encoder *dec, struct pho_xfer_desc *xfer,
                          struct dss_handle *dss)
 {
+    struct layout_info *layouts;
     struct layout_info *layout;
-    struct dss_filter filter;
     int cnt = 0;
     int rc;
 
     assert(xfer->xd_op == PHO_XFER_OP_GET || xfer->xd_op == PHO_XFER_OP_DEL);
 
-    rc = dss_filter_build(&filter,
-                          "{\"$AND\": ["
-                              "{\"DSS::LYT::object_uuid\": \"%s\"}, "
-                              "{\"DSS::LYT::version\": \"%d\"}"
-                          "]}",
-                          xfer->xd_targets->xt_objuuid,
-                          xfer->xd_targets->xt_version);
-    if (rc)
-        LOG_RETURN(rc, "Cannot build filter");
+    if (xfer->xd_op == PHO_XFER_OP_GET) {
+        rc = md_cache_full_layout_get(dss, xfer->xd_targets->xt_objuuid,
+                                      xfer->xd_targets->xt_version, &layout);
+        if (rc)
+            return rc;
 
-    rc = dss_full_layout_get(dss, &filter, NULL, &layout, &cnt, NULL);
-    dss_filter_free(&filter);
-    if (rc)
-        GOTO(err, rc);
+        rc = layout_decode(dec, xfer, layout);
+    } else {
+        /* the layout to delete is never taken from the cache */
+        rc = dss_full_layout_get_from_uuid(dss, xfer->xd_targets->xt_objuuid,
+                                           xfer->xd_targets->xt_version,
+                                           &layouts, &cnt);
+        if (rc)
+            return rc;
 
-    if (cnt == 0)
-        GOTO(err, rc = -ENOENT);
+        if (cnt == 0) {
+            dss_res_free(layouts, cnt);
+            return -ENOENT;
+        }
 
-    /* @FIXME: duplicate layout to avoid calling dss functions to free this? */
-    rc = xfer->xd_op == PHO_XFER_OP_GET ?
-        layout_decode(dec, xfer, layout) :
-        layout_delete(dec, xfer, layout);
-    if (rc)
-        GOTO(err, rc);
+        layout = layout_info_dup(layouts);
+        dss_res_free(layouts, cnt);
+
+        rc = layout_delete(dec, xfer, layout);
+    }
+
+    if (rc) {
+        /* the layout module may have kept it before failing */
+        if (dec->layout == layout)
+            dec->layout = NULL;
+        layout_info_free(layout);
+    }
 
-err:
-    if (rc)
-        dss_res_free(layout, cnt);
     return rc;
 }
 
+static unsigned int cfg_get_hint(enum pho_cfg_params_store param)
+{
+    int value;
+
+    value = _pho_cfg_get_int(PHO_CFG_STORE_FIRST, PHO_CFG_STORE_LAST, param,
+                             cfg_store, 0);
+
+    return value > 0 ? value : 0;
+}
+
+static void set_sched_hints(pho_req_t *req, const struct lrs_sched_hints *hints)
+{
+    if (hints->priority > 0) {
+        req->has_priority = true;
+        req->priority = hints->priority;
+    }
+
+    if (hints->deadline_ms > 0) {
+        req->has_deadline_ms = true;
+        req->deadline_ms = hints->deadline_ms;
+    }
+}
+
 /**
- * Forward a response from the LRS to its destination encoder, collect this
- * encoder's next requests and forward them back to the LRS.
+ * Forward the requests emitted by an encoder step to the LRS.
  *
- * @param[in/out]   enc     The encoder to give the response to.
- * @param[in]       ci      Communication information.
- * @param[in]       resp    The response to be forwarded to \a enc. Can be NULL
- *                          to generate the first request from \a enc.
- * @param[in]       enc_id  Identifier of this encoder (for request / response
- *                          tracking).
+ * @param[in]       pho         Phobos handle of the encoder.
+ * @param[in]       enc         The encoder which emitted the requests.
+ * @param[in]       requests    Requests to send, freed by this function.
+ * @param[in]       n_reqs      Number of requests.
+ * @param[in]       enc_id      Identifier of this encoder.
+ * @param[in]       rc          Result of the encoder step.
  *
- * @return 0 on success, -errno on error.
+ * @return rc if not 0, otherwise 0 on success, -errno on error.
  */
-static int encoder_communicate(struct pho_encoder *enc,
-                               struct pho_comm_info *comm, pho_resp_t *resp,
-                               int enc_id)
+static int encoder_send_requests(struct phobos_handle *pho,
+                                 struct pho_encoder *enc, pho_req_t *requests,
+                                 size_t n_reqs, int enc_id, int rc)
 {
-    pho_req_t *requests = NULL;
+    struct pho_comm_info *comm = &pho->comm;
     struct pho_comm_data data;
-    size_t n_reqs = 0;
     size_t i = 0;
-    int rc;
-
-    rc = layout_step(enc, resp, &requests, &n_reqs);
-    if (rc)
-        pho_error(rc, "Error while communicating with encoder");
 
     /* Dispatch generated requests (even on error, if any) */
     for (i = 0; i < n_reqs; i++) {
@@ -250,6 +370,9 @@ static int encoder_communicate(struct pho_encoder *enc,
                 xstrdup_safe(enc->xfer->xd_params.put.library);
             req->walloc->grouping =
                 xstrdup_safe(enc->xfer->xd_params.put.grouping);
+            set_sched_hints(req, &pho->write_hints);
+        } else if (pho_request_is_read(req)) {
+            set_sched_hints(req, &pho->read_hints);
         }
 
         data = pho_comm_data_init(comm);
@@ -274,6 +397,34 @@ static int encoder_communicate(struct pho_encoder *enc,
     return rc;
 }
 
+/**
+ * Forward a response from the LRS to its destination encoder, collect this
+ * encoder's next requests and forward them back to the LRS.
+ *
+ * @param[in]       pho     Phobos handle of the encoder.
+ * @param[in/out]   enc     The encoder to give the response to.
+ * @param[in]       resp    The response to be forwarded to \a enc. Can be NULL
+ *                          to generate the first request from \a enc.
+ * @param[in]       enc_id  Identifier of this encoder (for request / response
+ *                          tracking).
+ *
+ * @return 0 on success, -errno on error.
+ */
+static int encoder_communicate(struct phobos_handle *pho,
+                               struct pho_encoder *enc, pho_resp_t *resp,
+                               int enc_id)
+{
+    pho_req_t *requests = NULL;
+    size_t n_reqs = 0;
+    int rc;
+
+    rc = layout_step(enc, resp, &requests, &n_reqs);
+    if (rc)
+        pho_error(rc, "Error while communicating with encoder");
+
+    return encoder_send_requests(pho, enc, requests, n_reqs, enc_id, rc);
+}
+
 /**
  * Retrieve metadata associated with this xfer oid from the DSS and update the
  * \a xfer xd_attrs field accordingly.
@@ -837,7 +988,19 @@ static int init_enc_or_dec(struct pho_encoder *enc, struct dss_handle *dss,
 
     /* can't get md for undel without any objid */
     /* TODO: really necessary to create decoder for getmd, del and undel OP ? */
-    if (xfer->xd_op != PHO_XFER_OP_UNDEL && xfer->xd_op != PHO_XFER_OP_GET) {
+    if (xfer->xd_op == PHO_XFER_OP_GETMD) {
+        rc = md_cache_living_object_get(dss, xfer->xd_targets->xt_objid,
+                                        &obj);
+        if (rc)
+            LOG_RETURN(rc, "Cannot find metadata for objid:'%s'",
+                       xfer->xd_targets->xt_objid);
+
+        rc = object_info_copy_into_xfer(obj, xfer->xd_targets);
+        object_info_free(obj);
+        if (rc)
+            return rc;
+    } else if (xfer->xd_op != PHO_XFER_OP_UNDEL &&
+               xfer->xd_op != PHO_XFER_OP_GET) {
         rc = object_md_get(dss, xfer->xd_targets);
         if (rc)
             LOG_RETURN(rc, "Cannot find metadata for objid:'%s'",
@@ -859,9 +1022,15 @@ static int init_enc_or_dec(struct pho_encoder *enc, struct dss_handle *dss,
     if (!xfer->xd_targets->xt_objid && !xfer->xd_targets->xt_objuuid)
         LOG_RETURN(rc = -EINVAL, "uuid or oid must be provided");
 
-    rc = dss_lazy_find_object(dss, xfer->xd_targets->xt_objid,
-                              xfer->xd_targets->xt_objuuid,
-                              xfer->xd_targets->xt_version, &obj);
+    /* the object to hard delete is never taken from the cache */
+    if (xfer->xd_op == PHO_XFER_OP_DEL)
+        rc = dss_lazy_find_object(dss, xfer->xd_targets->xt_objid,
+                                  xfer->xd_targets->xt_objuuid,
+                                  xfer->xd_targets->xt_version, &obj);
+    else
+        rc = md_cache_object_find(dss, xfer->xd_targets->xt_objid,
+                                  xfer->xd_targets->xt_objuuid,
+                                  xfer->xd_targets->xt_version, &obj);
     if (rc)
         LOG_RETURN(rc, "Cannot find metadata for objid:'%s'",
                    xfer->xd_targets->xt_objid);
@@ -961,36 +1130,27 @@ static int store_end_delete_xfer(struct phobos_handle *pho,
 }
 
 /**
- * Mark the end of a transfer (successful or not) by updating the encoder
- * structure, saving the encoder layout to the DSS if necessary, properly
- * positioning xfer->xd_rc and calling the termination callback.
- *
- * If this function is called twice for the same transfer, the operations will
- * only be performed once.
+ * Complete a transfer that has ended: save the encoder layout to the DSS if
+ * necessary and not done yet, properly position xfer->xd_rc and call the
+ * termination callback.
  *
- * @param[in]   pho         The phobos handle handling this encoder.
- * @param[in]   xfer_idx    The index of the terminating xfer in \a pho.
- * @param[in]   rc          The outcome of the xfer (replaces the xfer's xd_rc
- *                          if it was 0).
+ * @param[in]   pho             The phobos handle handling this encoder.
+ * @param[in]   xfer_idx        The index of the terminating xfer in \a pho.
+ * @param[in]   rc              The outcome of the xfer (replaces the xfer's
+ *                              xd_rc if it was 0).
+ * @param[in]   layouts_saved   True if the layouts of the xfer were already
+ *                              saved with those of other xfers.
  */
-static void store_end_xfer(struct phobos_handle *pho, size_t xfer_idx, int rc)
+static void store_complete_xfer(struct phobos_handle *pho, size_t xfer_idx,
+                                int rc, bool layouts_saved)
 {
     struct pho_encoder *enc = &pho->encoders[xfer_idx];
     struct pho_xfer_desc *xfer = &pho->xfers[xfer_idx];
     int rc2 = 0;
     int i, j;
 
-    /* Don't end an encoder twice */
-    if (pho->ended_xfers[xfer_idx])
-        return;
-
-    /* Remember we ended this encoder */
-    pho->ended_xfers[xfer_idx] = true;
-    pho->n_ended_xfers++;
-    enc->done = true;
-
     /* Once the encoder is done and successful, save the layout and metadata */
-    if (is_encoder(enc) && xfer->xd_rc == 0 && rc == 0) {
+    if (!layouts_saved && is_encoder(enc) && xfer->xd_rc == 0 && rc == 0) {
         for (i = 0; i < xfer->xd_ntargets; i++) {
             pho_debug("Saving layout for objid:'%s'",
                       xfer->xd_targets[i].xt_objid);
@@ -1046,7 +1206,7 @@ static void store_end_xfer(struct phobos_handle *pho, size_t xfer_idx, int rc)
     if (xfer->xd_rc == 0 && rc == 0 && xfer->xd_op == PHO_XFER_OP_GET) {
         struct object_info *obj;
 
-        rc = dss_lazy_find_object(&pho->dss, xfer->xd_targets->xt_objid,
+        rc = md_cache_object_find(&pho->dss, xfer->xd_targets->xt_objid,
                                   xfer->xd_targets->xt_objuuid,
                                   xfer->xd_targets->xt_version, &obj);
         if (rc)
@@ -1102,6 +1262,225 @@ cont:
         pho->cb(pho->udata, xfer, rc);
 }
 
+/**
+ * Save the layouts of all the pending puts in a single transaction, and
+ * complete these puts.
+ *
+ * If the transaction fails, nothing is saved and each put is saved again on
+ * its own, so that the errors are reported on the xfers they belong to.
+ */
+static void store_flush_layouts(struct phobos_handle *pho)
+{
+    struct layout_info *layouts;
+    size_t n_layouts = 0;
+    size_t i;
+    int rc;
+    int j;
+
+    if (pho->n_md_pending == 0)
+        return;
+
+    for (i = 0; i < pho->n_md_pending; i++)
+        n_layouts += pho->xfers[pho->md_pending[i]].xd_ntargets;
+
+    layouts = xcalloc(n_layouts, sizeof(*layouts));
+    n_layouts = 0;
+    for (i = 0; i < pho->n_md_pending; i++) {
+        size_t xfer_idx = pho->md_pending[i];
+
+        for (j = 0; j < pho->xfers[xfer_idx].xd_ntargets; j++)
+            layouts[n_layouts++] = pho->encoders[xfer_idx].layout[j];
+    }
+
+    pho_debug("Saving the layouts of %zu objects", n_layouts);
+    rc = dss_layouts_save(&pho->dss, layouts, n_layouts);
+    if (rc)
+        pho_warn("Unable to save the layouts of %zu objects at once (%s), "
+                 "saving them one by one", n_layouts, strerror(-rc));
+    free(layouts);
+
+    for (i = 0; i < pho->n_md_pending; i++)
+        store_complete_xfer(pho, pho->md_pending[i], 0, rc == 0);
+
+    pho->n_md_pending = 0;
+}
+
+/**
+ * Mark the end of a transfer (successful or not) by updating the encoder
+ * structure and completing it with store_complete_xfer. The completion of
+ * successful puts is delayed until enough of them ended to save their layouts
+ * in a single transaction, or until all the transfers ended.
+ *
+ * If this function is called twice for the same transfer, the operations will
+ * only be performed once.
+ *
+ * @param[in]   pho         The phobos handle handling this encoder.
+ * @param[in]   xfer_idx    The index of the terminating xfer in \a pho.
+ * @param[in]   rc          The outcome of the xfer (replaces the xfer's xd_rc
+ *                          if it was 0).
+ */
+static void store_end_xfer(struct phobos_handle *pho, size_t xfer_idx, int rc)
+{
+    struct pho_encoder *enc = &pho->encoders[xfer_idx];
+    struct pho_xfer_desc *xfer = &pho->xfers[xfer_idx];
+
+    /* Don't end an encoder twice */
+    if (pho->ended_xfers[xfer_idx])
+        return;
+
+    /* Remember we ended this encoder */
+    pho->ended_xfers[xfer_idx] = true;
+    pho->n_ended_xfers++;
+    enc->done = true;
+
+    /* The layouts of successful puts are saved by batches */
+    if (pho->md_pending && is_encoder(enc) && xfer->xd_rc == 0 && rc == 0) {
+        pho->md_pending[pho->n_md_pending++] = xfer_idx;
+        if (pho->n_md_pending >= pho->md_batch_size)
+            store_flush_layouts(pho);
+    } else {
+        store_complete_xfer(pho, xfer_idx, rc, false);
+    }
+
+    /* No other xfer will end to fill the batch */
+    if (pho->n_ended_xfers == pho->n_xfers)
+        store_flush_layouts(pho);
+}
+
+static void store_step_free(struct store_step *step)
+{
+    size_t i;
+
+    for (i = 0; i < step->n_reqs; i++)
+        pho_srl_request_free(step->requests + i, false);
+    free(step->requests);
+    pho_srl_response_free(step->resp, true);
+    free(step);
+}
+
+/** Run the steps submitted by the dispatch thread */
+static void *store_io_worker(void *arg)
+{
+    struct phobos_handle *pho = arg;
+    struct store_step *step;
+
+    MUTEX_LOCK(&pho->steps_mutex);
+    while (true) {
+        while (g_queue_is_empty(pho->steps_todo) && !pho->workers_stopping)
+            pthread_cond_wait(&pho->steps_cond, &pho->steps_mutex);
+
+        /* the steps still queued are dropped by store_workers_stop */
+        if (pho->workers_stopping)
+            break;
+
+        step = g_queue_pop_head(pho->steps_todo);
+        MUTEX_UNLOCK(&pho->steps_mutex);
+
+        step->rc = layout_step(&pho->encoders[step->enc_id], step->resp,
+                               &step->requests, &step->n_reqs);
+        if (step->rc)
+            pho_error(step->rc, "Error while communicating with encoder");
+
+        MUTEX_LOCK(&pho->steps_mutex);
+        g_queue_push_tail(pho->steps_done, step);
+        pho_comm_wakeup(&pho->comm);
+    }
+    MUTEX_UNLOCK(&pho->steps_mutex);
+
+    return NULL;
+}
+
+/**
+ * Start the I/O workers, up to "io_workers" and no more than one per xfer.
+ * There are none for a single xfer, whose steps run in the dispatch thread.
+ */
+static int store_workers_start(struct phobos_handle *pho)
+{
+    int n_workers;
+    int rc;
+
+    n_workers = PHO_CFG_GET_INT(cfg_store, PHO_CFG_STORE, io_workers, 0);
+    if (n_workers <= 0 || pho->n_xfers < 2)
+        return 0;
+
+    /* the workers wake up the dispatch thread waiting for the LRS */
+    rc = pho_comm_wakeup_enable(&pho->comm);
+    if (rc)
+        return rc;
+
+    n_workers = min((size_t)n_workers, pho->n_xfers);
+    pho->workers = xcalloc(n_workers, sizeof(*pho->workers));
+    pho->enc_busy = xcalloc(pho->n_xfers, sizeof(*pho->enc_busy));
+    pho->enc_deferred = xcalloc(pho->n_xfers, sizeof(*pho->enc_deferred));
+    pho->steps_todo = g_queue_new();
+    pho->steps_done = g_queue_new();
+    pho->workers_stopping = false;
+    pthread_mutex_init(&pho->steps_mutex, NULL);
+    pthread_cond_init(&pho->steps_cond, NULL);
+
+    for (pho->n_workers = 0; pho->n_workers < n_workers; pho->n_workers++) {
+        rc = -pthread_create(&pho->workers[pho->n_workers], NULL,
+                             store_io_worker, pho);
+        if (rc)
+            LOG_RETURN(rc, "Failed to start I/O worker %zu", pho->n_workers);
+    }
+
+    pho_debug("Data of %zu xfers moved by %zu I/O workers", pho->n_xfers,
+              pho->n_workers);
+
+    return 0;
+}
+
+/**
+ * Wait for the steps in progress and stop the I/O workers. The steps which
+ * are not dispatched yet are dropped, their xfers are to be ended by the
+ * caller.
+ */
+static void store_workers_stop(struct phobos_handle *pho)
+{
+    struct store_step *step;
+    size_t i;
+
+    if (!pho->workers)
+        return;
+
+    MUTEX_LOCK(&pho->steps_mutex);
+    pho->workers_stopping = true;
+    pthread_cond_broadcast(&pho->steps_cond);
+    MUTEX_UNLOCK(&pho->steps_mutex);
+
+    for (i = 0; i < pho->n_workers; i++)
+        pthread_join(pho->workers[i], NULL);
+
+    while ((step = g_queue_pop_head(pho->steps_todo)) != NULL)
+        store_step_free(step);
+    while ((step = g_queue_pop_head(pho->steps_done)) != NULL)
+        store_step_free(step);
+
+    for (i = 0; i < pho->n_xfers; i++) {
+        pho_resp_t *resp;
+
+        if (!pho->enc_deferred[i])
+            continue;
+
+        while ((resp = g_queue_pop_head(pho->enc_deferred[i])) != NULL)
+            pho_srl_response_free(resp, true);
+        g_queue_free(pho->enc_deferred[i]);
+    }
+
+    g_queue_free(pho->steps_todo);
+    g_queue_free(pho->steps_done);
+    pthread_cond_destroy(&pho->steps_cond);
+    pthread_mutex_destroy(&pho->steps_mutex);
+    free(pho->enc_deferred);
+    free(pho->enc_busy);
+    free(pho->workers);
+    pho->enc_deferred = NULL;
+    pho->enc_busy = NULL;
+    pho->workers = NULL;
+    pho->n_workers = 0;
+}
+
 /**
  * Destroy a phobos handle and all associated resources. All unfinished
  * transfers will end with return code \a rc.
@@ -1110,34 +1489,49 @@ static void store_fini(struct phobos_handle *pho, int rc)
 {
     size_t i;
 
-    /* Cleanup encoders */
-    for (i = 0; i < pho->n_xfers; i++) {
-        /**
-         * Encoders that have not finished at this point are marked as failed
-         * with the global rc
-         */
+    /* No step may run on the encoders from now on */
+    store_workers_stop(pho);
+
+    /**
+     * Encoders that have not finished at this point are marked as failed
+     * with the global rc. This also saves the layouts of the successful puts
+     * that are still pending, before their encoders are destroyed.
+     */
+    for (i = 0; i < pho->n_xfers; i++)
         if (pho->ended_xfers && !pho->ended_xfers[i])
             store_end_xfer(pho, i, rc);
 
+    /* Cleanup encoders */
+    for (i = 0; i < pho->n_xfers; i++) {
         /*
-         * We allocated the decoder layouts from the dss (in decoder_build),
-         * hence we also free them.
+         * We allocated the decoder layouts in decoder_build, hence we also
+         * free them.
          */
         if (pho->encoders) {
             if (is_decoder(&pho->encoders[i])) {
-                dss_res_free(pho->encoders[i].layout, 1);
+                layout_info_free(pho->encoders[i].layout);
                 pho->encoders[i].layout = NULL;
             }
             layout_destroy(&pho->encoders[i]);
         }
     }
 
+    for (i = 0; pho->enc_retry && i < pho->n_xfers; i++)
+        if (pho->enc_retry[i])
+            pho_srl_response_free(pho->enc_retry[i], true);
+
     free(pho->encoders);
     free(pho->ended_xfers);
     free(pho->md_created);
+    free(pho->md_pending);
+    free(pho->enc_retry);
+    free(pho->enc_retry_at);
     pho->encoders = NULL;
     pho->ended_xfers = NULL;
     pho->md_created = NULL;
+    pho->md_pending = NULL;
+    pho->enc_retry = NULL;
+    pho->enc_retry_at = NULL;
 
     rc = pho_comm_close(&pho->comm);
     if (rc)
@@ -1176,6 +1570,10 @@ static int store_init(struct phobos_handle *pho, struct pho_xfer_desc *xfers,
     pho->ended_xfers = NULL;
     pho->encoders = NULL;
     pho->md_created = NULL;
+    pho->md_pending = NULL;
+    pho->enc_retry = NULL;
+    pho->enc_retry_at = NULL;
+    pho->rand_seed = getpid() + time(NULL);
 
     /* Check xfers consistency */
     for (i = 0; i < n_xfers; i++) {
@@ -1220,6 +1618,28 @@ static int store_init(struct phobos_handle *pho, struct pho_xfer_desc *xfers,
      */
     pho->md_created = xcalloc(n_xfers, sizeof(*pho->md_created));
 
+    pho->enc_retry = xcalloc(n_xfers, sizeof(*pho->enc_retry));
+    pho->enc_retry_at = xcalloc(n_xfers, sizeof(*pho->enc_retry_at));
+
+    /* Save the metadata of the puts by batches, if there is more than one */
+    rc = PHO_CFG_GET_INT(cfg_store, PHO_CFG_STORE, md_batch_size, 1);
+    pho->md_batch_size = rc > 1 ? rc : 1;
+    rc = 0;
+    if (pho->md_batch_size > 1 && n_xfers > 1)
+        pho->md_pending = xcalloc(n_xfers, sizeof(*pho->md_pending));
+
+    /* Scheduling hints of the requests sent to the LRS */
+    pho->read_hints.priority = cfg_get_hint(PHO_CFG_STORE_read_priority);
+    pho->write_hints.priority = cfg_get_hint(PHO_CFG_STORE_write_priority);
+    pho->read_hints.deadline_ms =
+        cfg_get_hint(PHO_CFG_STORE_read_deadline_ms);
+    pho->write_hints.deadline_ms =
+        cfg_get_hint(PHO_CFG_STORE_write_deadline_ms);
+
+    rc = store_workers_start(pho);
+    if (rc)
+        LOG_GOTO(out, rc, "Cannot start the I/O workers");
+
     /* Initialize all the encoders */
     for (i = 0; i < n_xfers; i++) {
         pho_debug("Initializing %s %ld for %d objid(s)",
@@ -1241,25 +1661,206 @@ out:
     return rc;
 }
 
+/**
+ * Hold the response of an encoder whose request had no resource available in
+ * the LRS for a random amount of time, before letting the encoder retry it.
+ * The dispatch loop gives it to the encoder once the delay expired.
+ */
+static void store_retry_backoff(struct phobos_handle *pho, int enc_id,
+                                pho_resp_t *resp)
+{
+    struct timespec delay;
+    struct timespec now;
+    long sleep_time;
+
+    sleep_time =
+        (rand_r(&pho->rand_seed) % (RETRY_SLEEP_MAX_US - RETRY_SLEEP_MIN_US))
+        + RETRY_SLEEP_MIN_US;
+    pho_info("No resource available to perform IO, retrying in %ld ms",
+             sleep_time / 1000);
+
+    delay.tv_sec = sleep_time / 1000000;
+    delay.tv_nsec = (sleep_time % 1000000) * 1000;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    pho->enc_retry[enc_id] = resp;
+    pho->enc_retry_at[enc_id] = add_timespec(&now, &delay);
+}
+
+/** Handle the end of a step of an encoder */
+static int store_encoder_stepped(struct phobos_handle *pho, int enc_id, int rc)
+{
+    struct pho_encoder *encoder = &pho->encoders[enc_id];
+
+    /* Success or failure final callback */
+    if (rc || encoder->done)
+        store_end_xfer(pho, enc_id, rc);
+
+    if (rc)
+        pho_error(rc, "Error while sending response to layout for %s %d",
+                  encoder_type2str(encoder), enc_id);
+
+    return rc;
+}
+
+static void store_step_submit(struct phobos_handle *pho, int enc_id,
+                              pho_resp_t *resp)
+{
+    struct store_step *step = xcalloc(1, sizeof(*step));
+
+    step->enc_id = enc_id;
+    step->resp = resp;
+    pho->enc_busy[enc_id] = true;
+
+    MUTEX_LOCK(&pho->steps_mutex);
+    g_queue_push_tail(pho->steps_todo, step);
+    pthread_cond_signal(&pho->steps_cond);
+    MUTEX_UNLOCK(&pho->steps_mutex);
+}
+
+/**
+ * Give a response of the LRS to its encoder, or to an I/O worker for the
+ * steps which move data.
+ */
+static int store_encoder_response(struct phobos_handle *pho, pho_resp_t *resp)
+{
+    struct pho_encoder *encoder = &pho->encoders[resp->req_id];
+    int enc_id = resp->req_id;
+    int rc;
+
+    if (pho->workers && !encoder->done &&
+        (pho_response_is_write(resp) || pho_response_is_read(resp))) {
+        store_step_submit(pho, enc_id, resp);
+        return 0;
+    }
+
+    rc = encoder_communicate(pho, encoder, resp, enc_id);
+    pho_srl_response_free(resp, true);
+
+    return store_encoder_stepped(pho, enc_id, rc);
+}
+
+/**
+ * Give a response of the LRS to its encoder, which takes ownership of it.
+ *
+ * If there are I/O workers, the read and write allocations, whose steps move
+ * data, are given to the encoders by a worker. An encoder runs one step at a
+ * time: the responses it receives meanwhile are deferred. The responses for
+ * which the LRS had no resource available are held until their retry delay
+ * expires (see store_retry_backoff).
+ */
 static int store_lrs_response_process(struct phobos_handle *pho,
                                       pho_resp_t *resp)
 {
     struct pho_encoder *encoder = &pho->encoders[resp->req_id];
-    int rc;
+    int enc_id = resp->req_id;
+
+    if (pho->workers && pho->enc_busy[enc_id]) {
+        if (!pho->enc_deferred[enc_id])
+            pho->enc_deferred[enc_id] = g_queue_new();
+
+        g_queue_push_tail(pho->enc_deferred[enc_id], resp);
+        return 0;
+    }
 
     pho_debug("%s %d for %d objid(s) received a response of type %s",
               encoder_type2str(encoder), resp->req_id,
               encoder->xfer->xd_ntargets, pho_srl_response_kind_str(resp));
 
-    rc = encoder_communicate(encoder, &pho->comm, resp, resp->req_id);
+    /* The layout will emit its request again, do not flood the LRS with it */
+    if (pho_response_is_error(resp) && resp->error->rc == -EAGAIN) {
+        store_retry_backoff(pho, enc_id, resp);
+        return 0;
+    }
 
-    /* Success or failure final callback */
-    if (rc || encoder->done)
-        store_end_xfer(pho, resp->req_id, rc);
+    return store_encoder_response(pho, resp);
+}
 
-    if (rc)
-        pho_error(rc, "Error while sending response to layout for %s %d",
-                  encoder_type2str(encoder), resp->req_id);
+/**
+ * Forward the requests of the steps run by the I/O workers, then give their
+ * encoders the responses deferred meanwhile.
+ */
+static int store_steps_dispatch(struct phobos_handle *pho)
+{
+    struct store_step *step;
+    int rc = 0;
+
+    if (!pho->workers)
+        return 0;
+
+    while (true) {
+        GQueue *deferred;
+        int enc_id;
+        int rc2;
+
+        MUTEX_LOCK(&pho->steps_mutex);
+        step = g_queue_pop_head(pho->steps_done);
+        MUTEX_UNLOCK(&pho->steps_mutex);
+        if (!step)
+            break;
+
+        enc_id = step->enc_id;
+        rc2 = encoder_send_requests(pho, &pho->encoders[enc_id],
+                                    step->requests, step->n_reqs, enc_id,
+                                    step->rc);
+        step->requests = NULL;
+        step->n_reqs = 0;
+        store_step_free(step);
+
+        pho->enc_busy[enc_id] = false;
+        rc2 = store_encoder_stepped(pho, enc_id, rc2);
+        rc = rc ? : rc2;
+
+        deferred = pho->enc_deferred[enc_id];
+        while (deferred && !g_queue_is_empty(deferred) &&
+               !pho->enc_busy[enc_id]) {
+            rc2 = store_lrs_response_process(pho, g_queue_pop_head(deferred));
+            rc = rc ? : rc2;
+        }
+    }
+
+    return rc;
+}
+
+/**
+ * Give the encoders the responses whose retry delay expired.
+ *
+ * @param[in]   pho         Phobos handle.
+ * @param[out]  timeout_ms  Time until the next retry if it is sooner than
+ *                          LRS_RESP_WAIT_MS, LRS_RESP_WAIT_MS otherwise.
+ *
+ * @return 0 on success, the first error of the encoders otherwise.
+ */
+static int store_retries_process(struct phobos_handle *pho, int *timeout_ms)
+{
+    struct timespec now;
+    int rc = 0;
+    size_t i;
+
+    *timeout_ms = LRS_RESP_WAIT_MS;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    for (i = 0; i < pho->n_xfers; i++) {
+        struct timespec left;
+        pho_resp_t *resp;
+        int rc2;
+
+        if (!pho->enc_retry[i])
+            continue;
+
+        if (cmp_timespec(&pho->enc_retry_at[i], &now) > 0) {
+            left = diff_timespec(&pho->enc_retry_at[i], &now);
+            /* rounded up, not to wake up right before the deadline */
+            *timeout_ms = min(*timeout_ms,
+                              left.tv_sec * 1000 + left.tv_nsec / 1000000 + 1);
+            continue;
+        }
+
+        resp = pho->enc_retry[i];
+        pho->enc_retry[i] = NULL;
+        rc2 = store_encoder_response(pho, resp);
+        rc = rc ? : rc2;
+    }
 
     return rc;
 }
@@ -1271,6 +1872,31 @@ static int store_dispatch_loop(struct phobos_handle *pho)
     int rc = 0;
     int i;
     pho_resp_t **resps = NULL;
+    int timeout_ms;
+
+    rc = store_steps_dispatch(pho);
+    if (rc)
+        return rc;
+
+    rc = store_retries_process(pho, &timeout_ms);
+    if (rc || pho->n_ended_xfers == pho->n_xfers)
+        return rc;
+
+    /* Sleep on the LRS socket until a response is available or a retry is
+     * due
+     */
+    rc = pho_comm_wait(&pho->comm, timeout_ms);
+    if (rc == -EINTR) {
+        /* woken up by an I/O worker which ended a step */
+        return 0;
+    } else if (rc == -ETIMEDOUT) {
+        if (timeout_ms == LRS_RESP_WAIT_MS)
+            pho_verb("No response from LRS after %d ms, still waiting",
+                     LRS_RESP_WAIT_MS);
+        return 0;
+    } else if (rc) {
+        LOG_RETURN(rc, "Error while waiting for responses from LRS");
+    }
 
     /* Collect LRS responses */
     rc = pho_comm_recv(&pho->comm, &responses, &n_responses);
@@ -1303,32 +1929,162 @@ static int store_dispatch_loop(struct phobos_handle *pho)
         }
 
         rc = store_lrs_response_process(pho, resps[i]);
-        pho_srl_response_free(resps[i], true);
         if (rc)
             break;
     }
 
-    /*
-     * If there are no new answer, it means no resource is available yet,
-     * wait a bit before retrying.
-     */
-    if (n_responses == 0) {
-        unsigned int rand_seed = getpid() + time(NULL);
-        useconds_t sleep_time;
-
-        sleep_time =
-            (rand_r(&rand_seed) % (RETRY_SLEEP_MAX_US - RETRY_SLEEP_MIN_US))
-            + RETRY_SLEEP_MIN_US;
-        pho_info("No resource available to perform IO, retrying in %d ms",
-                 sleep_time / 1000);
-        usleep(sleep_time);
-    }
+    /* Free the responses left on error */
+    for (i++; i < n_responses; i++)
+        if (resps[i])
+            pho_srl_response_free(resps[i], true);
 
     free(resps);
 
     return rc;
 }
 
+/**
+ * Save the metadata of all the new objects of the puts with a single insert,
+ * as object_md_save does for each of them.
+ *
+ * If a lock or the insert fails, nothing is saved and the puts are left to
+ * object_md_save, so that the errors are reported on the xfers they belong
+ * to. The puts whose metadata were saved are flagged in md_created.
+ */
+static void store_reserve_oids(struct phobos_handle *pho)
+{
+    struct pho_xfer_target **targets;
+    struct object_info *objs;
+    struct object_info *res;
+    struct dss_filter filter;
+    GString **md_reprs;
+    GString *filter_str;
+    size_t n_total = 0;
+    size_t n_objs = 0;
+    int res_cnt = 0;
+    size_t i, k;
+    int rc2;
+    int rc;
+    int j;
+
+    ENTRY;
+
+    if (pho->md_pending == NULL)
+        return;
+
+    for (i = 0; i < pho->n_xfers; i++)
+        if (pho->xfers[i].xd_op == PHO_XFER_OP_PUT &&
+            !pho->xfers[i].xd_params.put.overwrite)
+            n_total += pho->xfers[i].xd_ntargets;
+
+    if (n_total < 2)
+        return;
+
+    objs = xcalloc(n_total, sizeof(*objs));
+    targets = xcalloc(n_total, sizeof(*targets));
+    md_reprs = xcalloc(n_total, sizeof(*md_reprs));
+
+    for (i = 0; i < pho->n_xfers; i++) {
+        struct pho_xfer_desc *xfer = &pho->xfers[i];
+
+        if (xfer->xd_op != PHO_XFER_OP_PUT || xfer->xd_params.put.overwrite)
+            continue;
+
+        for (j = 0; j < xfer->xd_ntargets; j++, n_objs++) {
+            md_reprs[n_objs] = g_string_new(NULL);
+            rc = pho_attrs_to_json(&xfer->xd_targets[j].xt_attrs,
+                                   md_reprs[n_objs], 0);
+            if (rc)
+                /* object_md_save will report it on the right xfer */
+                goto out_free;
+
+            targets[n_objs] = &xfer->xd_targets[j];
+            objs[n_objs].oid = xfer->xd_targets[j].xt_objid;
+            objs[n_objs].obj_status = PHO_OBJ_STATUS_INCOMPLETE;
+            objs[n_objs].user_md = md_reprs[n_objs]->str;
+            objs[n_objs].grouping = xfer->xd_params.put.grouping;
+        }
+    }
+
+    rc = dss_lock(&pho->dss, DSS_OBJECT, objs, n_objs);
+    if (rc) {
+        pho_verb("Unable to lock %zu objects at once, saving them one by one",
+                 n_objs);
+        goto out_free;
+    }
+
+    pho_debug("Storing %zu objects (transient)", n_objs);
+
+    rc = dss_object_insert(&pho->dss, objs, n_objs, DSS_SET_INSERT);
+    if (rc) {
+        pho_verb("Unable to insert %zu objects at once, saving them one by "
+                 "one", n_objs);
+        goto out_unlock;
+    }
+
+    /* From now on, the metadata exist and the puts must clean them on error */
+    for (i = 0; i < pho->n_xfers; i++)
+        if (pho->xfers[i].xd_op == PHO_XFER_OP_PUT &&
+            !pho->xfers[i].xd_params.put.overwrite)
+            pho->md_created[i] = true;
+
+    filter_str = g_string_new("{\"$OR\": [");
+    for (k = 0; k < n_objs; k++)
+        g_string_append_printf(filter_str, "%s{\"DSS::OBJ::oid\": \"%s\"}",
+                               k ? ", " : "", objs[k].oid);
+    g_string_append(filter_str, "]}");
+
+    rc = dss_filter_build(&filter, "%s", filter_str->str);
+    g_string_free(filter_str, true);
+    if (rc)
+        LOG_GOTO(out_unlock, rc, "dss_filter_build failed");
+
+    rc = dss_object_get(&pho->dss, &filter, &res, &res_cnt, NULL);
+    dss_filter_free(&filter);
+    if (rc)
+        LOG_GOTO(out_unlock, rc, "Cannot fetch the %zu objects saved", n_objs);
+
+    for (k = 0; k < n_objs; k++) {
+        for (j = 0; j < res_cnt; j++) {
+            if (strcmp(res[j].oid, targets[k]->xt_objid) == 0) {
+                targets[k]->xt_version = res[j].version;
+                targets[k]->xt_objuuid = xstrdup(res[j].uuid);
+                break;
+            }
+        }
+
+        if (j == res_cnt) {
+            pho_error(rc = -ENOENT, "Cannot fetch objid:'%s'",
+                      targets[k]->xt_objid);
+            break;
+        }
+    }
+
+    dss_res_free(res, res_cnt);
+
+out_unlock:
+    rc2 = dss_unlock(&pho->dss, DSS_OBJECT, objs, n_objs, false);
+    if (rc2)
+        pho_error(rc2, "Couldn't unlock %zu objects. Database may be "
+                  "corrupted.", n_objs);
+
+    /* The objects may be saved but the puts cannot go on, end them once
+     * unlocked so that their metadata can be cleaned.
+     */
+    if (rc || rc2)
+        for (i = 0; i < pho->n_xfers; i++)
+            if (pho->md_created[i])
+                store_end_xfer(pho, i, rc ? : rc2);
+
+out_free:
+    for (k = 0; k < n_total; k++)
+        if (md_reprs[k])
+            g_string_free(md_reprs[k], true);
+    free(md_reprs);
+    free(targets);
+    free(objs);
+}
+
 /**
  * Perform the main store loop:
  * - collect requests from encoders
@@ -1358,6 +2114,8 @@ static int store_perform_xfers(struct phobos_handle *pho)
      * unicity before performing any IO. From now on, any failed object must
      * have its metadata cleared from the DSS.
      */
+    store_reserve_oids(pho);
+
     for (i = 0; i < pho->n_xfers; i++) {
         if (pho->xfers[i].xd_op == PHO_XFER_OP_DEL &&
             !(pho->xfers[i].xd_flags & PHO_XFER_OBJ_HARD_DEL)) {
@@ -1380,7 +2138,7 @@ static int store_perform_xfers(struct phobos_handle *pho)
             store_end_xfer(pho, i, rc);
         }
 
-        if (pho->xfers[i].xd_op != PHO_XFER_OP_PUT)
+        if (pho->xfers[i].xd_op != PHO_XFER_OP_PUT || pho->md_created[i])
             continue;
         for (j = 0; j < pho->xfers[i].xd_ntargets; j++) {
             rc2 = object_md_save(&pho->dss, &pho->xfers[i].xd_targets[j],
@@ -1406,7 +2164,7 @@ static int store_perform_xfers(struct phobos_handle *pho)
         if (pho->encoders[i].done)
             continue;
 
-        rc = encoder_communicate(&pho->encoders[i], &pho->comm, NULL, i);
+        rc = encoder_communicate(pho, &pho->encoders[i], NULL, i);
         if (rc)
             store_end_xfer(pho, i, rc);
     }
@@ -1438,7 +2196,9 @@ static int phobos_xfer(struct pho_xfer_desc *xfers, size_t n,
                        pho_completion_cb_t cb, void *udata)
 {
     struct phobos_handle pho;
+    size_t i;
     int rc;
+    int j;
 
     rc = store_init(&pho, xfers, n, cb, udata);
     if (rc)
@@ -1447,6 +2207,18 @@ static int phobos_xfer(struct pho_xfer_desc *xfers, size_t n,
     rc = store_perform_xfers(&pho);
     store_fini(&pho, rc);
 
+    /* do not wait for the DSS notifications of our own changes */
+    for (i = 0; i < n; i++) {
+        if (xfers[i].xd_op != PHO_XFER_OP_PUT &&
+            xfers[i].xd_op != PHO_XFER_OP_DEL &&
+            xfers[i].xd_op != PHO_XFER_OP_UNDEL)
+            continue;
+
+        for (j = 0; j < xfers[i].xd_ntargets; j++)
+            md_cache_invalidate(xfers[i].xd_targets[j].xt_objid,
+                                xfers[i].xd_targets[j].xt_objuuid);
+    }
+
     return rc;
 }
 
@@ -1473,11 +2245,81 @@ int phobos_put(struct pho_xfer_desc *xfers, size_t n,
     return phobos_xfer(xfers, n, cb, udata);
 }
 
+/**
+ * Locate the objects of the xfers with the PHO_XFER_OBJ_BEST_HOST flag in one
+ * phobos_locate_bulk call. The xfers located on another node get -EREMOTE.
+ *
+ * \return the first locate error, the number of xfers to get locally is
+ *         incremented in \p n_xfers_to_get
+ */
+static int get_best_host_locate(struct pho_xfer_desc *xfers, size_t n,
+                                size_t *n_xfers_to_get)
+{
+    struct pho_locate_target *targets;
+    const char *hostname;
+    size_t *indexes;
+    size_t n_targets;
+    size_t i;
+    int rc;
+
+    targets = xcalloc(n, sizeof(*targets));
+    indexes = xcalloc(n, sizeof(*indexes));
+    for (i = 0, n_targets = 0; i < n; i++) {
+        if (!(xfers[i].xd_flags & PHO_XFER_OBJ_BEST_HOST))
+            continue;
+
+        targets[n_targets].oid = xfers[i].xd_targets->xt_objid;
+        targets[n_targets].uuid = xfers[i].xd_targets->xt_objuuid;
+        targets[n_targets].version = xfers[i].xd_targets->xt_version;
+        indexes[n_targets++] = i;
+    }
+
+    if (!n_targets)
+        GOTO(free_targets, rc = 0);
+
+    hostname = get_hostname();
+    if (!hostname) {
+        for (i = 0; i < n_targets; i++) {
+            pho_warn("Get was cancelled for object '%s': "
+                     "hostname couldn't be retrieved", targets[i].oid);
+            xfers[indexes[i]].xd_rc = -ECANCELED;
+        }
+        GOTO(free_targets, rc = 0);
+    }
+
+    rc = phobos_locate_bulk(targets, n_targets, hostname);
+    for (i = 0; i < n_targets; i++) {
+        struct pho_xfer_desc *xfer = &xfers[indexes[i]];
+
+        xfer->xd_params.get.node_name = NULL;
+        if (targets[i].rc) {
+            pho_warn("Object objid:'%s' couldn't be located",
+                     xfer->xd_targets->xt_objid);
+            xfer->xd_rc = targets[i].rc;
+        } else if (strcmp(targets[i].hostname, hostname)) {
+            pho_warn("Object objid:'%s' located on node: %s",
+                     xfer->xd_targets->xt_objid, targets[i].hostname);
+            xfer->xd_params.get.node_name = targets[i].hostname;
+            xfer->xd_rc = -EREMOTE;
+        } else {
+            pho_info("Object objid:'%s' located on local node",
+                     xfer->xd_targets->xt_objid);
+            (*n_xfers_to_get)++;
+            free(targets[i].hostname);
+        }
+    }
+
+free_targets:
+    free(indexes);
+    free(targets);
+
+    return rc;
+}
+
 int phobos_get(struct pho_xfer_desc *xfers, size_t n,
                pho_completion_cb_t cb, void *udata)
 {
     struct pho_xfer_desc *xfers_to_get = NULL;
-    const char *hostname = NULL;
     size_t n_xfers_to_get = 0;
     size_t j = 0;
     int rc2 = 0;
@@ -1501,49 +2343,13 @@ int phobos_get(struct pho_xfer_desc *xfers, size_t n,
             xfers[i].xd_targets->xt_objuuid =
                 xstrdup(xfers[i].xd_targets->xt_objuuid);
 
-        if (xfers[i].xd_flags & PHO_XFER_OBJ_BEST_HOST) {
-            int nb_new_lock;
-
-            if (!hostname) {
-                hostname = get_hostname();
-                if (!hostname) {
-                    pho_warn("Get was cancelled for object '%s': "
-                             "hostname couldn't be retrieved",
-                             xfers[i].xd_targets->xt_objid);
-                    xfers[i].xd_rc = -ECANCELED;
-                    continue;
-                }
-            }
-
-            rc2 = phobos_locate(xfers[i].xd_targets->xt_objid,
-                                xfers[i].xd_targets->xt_objuuid,
-                                xfers[i].xd_targets->xt_version, hostname,
-                                &xfers[i].xd_params.get.node_name,
-                                &nb_new_lock);
-            rc = rc ? : rc2;
-            if (rc2) {
-                pho_warn("Object objid:'%s' couldn't be located",
-                         xfers[i].xd_targets->xt_objid);
-                xfers[i].xd_rc = rc2;
-            } else {
-                if (strcmp(xfers[i].xd_params.get.node_name, hostname)) {
-                    pho_warn("Object objid:'%s' located on node: %s",
-                             xfers[i].xd_targets->xt_objid,
-                             xfers[i].xd_params.get.node_name);
-                    xfers[i].xd_rc = -EREMOTE;
-                } else {
-                    pho_info("Object objid:'%s' located on local node",
-                             xfers[i].xd_targets->xt_objid);
-                    n_xfers_to_get++;
-                    free(xfers[i].xd_params.get.node_name);
-                    xfers[i].xd_params.get.node_name = NULL;
-                }
-            }
-        } else {
+        if (!(xfers[i].xd_flags & PHO_XFER_OBJ_BEST_HOST))
             n_xfers_to_get++;
-        }
     }
 
+    /* the objects are located together to share the DSS queries */
+    rc = get_best_host_locate(xfers, n, &n_xfers_to_get);
+
     if (!n_xfers_to_get)
         return -EREMOTE;
 
@@ -1697,6 +2503,9 @@ int phobos_rename(const char *old_oid, const char *uuid, char *new_oid)
                  "Failed to rename objects with %s '%s' to rename",
                  old_oid ? "oid" : "uuid", old_oid ? old_oid : uuid);
 
+    md_cache_invalidate(old_oid, uuid);
+    md_cache_invalidate(new_oid, NULL);
+
 clean:
     if (deprec_objects)
         dss_res_free(deprec_objects, deprec_count);
@@ -1739,14 +2548,44 @@ void pho_xfer_clean(struct pho_xfer_target *xfer)
     free(xfer->xt_objuuid);
 }
 
+/**
+ * Find the layout of the object to locate, to be freed with dss_res_free.
+ */
+static int locate_layout_get(struct dss_handle *dss, const char *oid,
+                             const char *uuid, int version,
+                             struct layout_info **layout)
+{
+    struct object_info *obj = NULL;
+    int cnt;
+    int rc;
+
+    *layout = NULL;
+
+    if (!uuid && !oid)
+        LOG_RETURN(-EINVAL, "uuid or oid must be provided");
+
+    /* find object */
+    rc = dss_lazy_find_object(dss, oid, uuid, version, &obj);
+    if (rc)
+        LOG_RETURN(rc, "Unable to find object to locate");
+
+    /* find layout to locate media */
+    rc = dss_full_layout_get_from_uuid(dss, obj->uuid, obj->version, layout,
+                                       &cnt);
+    object_info_free(obj);
+    if (rc)
+        return rc;
+
+    assert(cnt == 1);
+
+    return 0;
+}
+
 int phobos_locate(const char *oid, const char *uuid, int version,
                   const char *focus_host, char **hostname, int *nb_new_lock)
 {
-    struct object_info *obj = NULL;
     struct layout_info *layout;
-    struct dss_filter filter;
     struct dss_handle dss;
-    int cnt;
     int rc;
 
     *hostname = NULL;
@@ -1764,36 +2603,94 @@ int phobos_locate(const char *oid, const char *uuid, int version,
     if (rc)
         return rc;
 
-    /* find object */
-    rc = dss_lazy_find_object(&dss, oid, uuid, version, &obj);
+    rc = locate_layout_get(&dss, oid, uuid, version, &layout);
     if (rc)
-        LOG_GOTO(clean, rc, "Unable to find object to locate");
+        GOTO(clean, rc);
 
-    /* find layout to locate media */
-    rc = dss_filter_build(&filter,
-                          "{\"$AND\": ["
-                              "{\"DSS::LYT::object_uuid\": \"%s\"}, "
-                              "{\"DSS::LYT::version\": \"%d\"}"
-                          "]}",
-                          obj->uuid, obj->version);
+    /* locate media */
+    rc = layout_locate(&dss, NULL, layout, focus_host, hostname, nb_new_lock);
+    dss_res_free(layout, 1);
+
+clean:
+    dss_fini(&dss);
+    return rc;
+}
+
+int phobos_locate_bulk(struct pho_locate_target *targets, size_t n,
+                       const char *focus_host)
+{
+    struct dss_locate_cache cache;
+    struct layout_info **layouts;
+    struct dss_handle dss;
+    GArray *medium_ids;
+    int rc2 = 0;
+    int rc = 0;
+    size_t i;
+    int j;
+
+    for (i = 0; i < n; i++) {
+        targets[i].hostname = NULL;
+        targets[i].nb_new_lock = 0;
+        targets[i].rc = 0;
+    }
+
+    /* Ensure conf is loaded */
+    rc = pho_cfg_init_local(NULL);
+    if (rc && rc != -EALREADY)
+        goto fail_all;
+
+    /* Connect to the DSS */
+    rc = dss_init(&dss);
     if (rc)
-        LOG_GOTO(clean, rc,
-                 "Unable to build filter oid %s uuid %s version %d to get "
-                 "layout from extent", obj->oid, obj->uuid, obj->version);
+        goto fail_all;
 
-    rc = dss_full_layout_get(&dss, &filter, NULL, &layout, &cnt, NULL);
-    dss_filter_free(&filter);
+    layouts = xcalloc(n, sizeof(*layouts));
+    medium_ids = g_array_new(false, false, sizeof(struct pho_id));
+    for (i = 0; i < n; i++) {
+        targets[i].rc = locate_layout_get(&dss, targets[i].oid,
+                                          targets[i].uuid, targets[i].version,
+                                          &layouts[i]);
+        if (targets[i].rc)
+            continue;
+
+        for (j = 0; j < layouts[i]->ext_count; j++)
+            g_array_append_val(medium_ids, layouts[i]->extents[j].media);
+    }
+
+    /* locate the media of every object at once, the locate of each layout
+     * then only queries the DSS to take its locks
+     */
+    dss_locate_cache_init(&cache);
+    rc = dss_locate_cache_load(&dss, &cache,
+                               (struct pho_id *) medium_ids->data,
+                               medium_ids->len);
     if (rc)
-        GOTO(clean, rc);
+        pho_warn("Failed to locate the media of %zu objects at once, they "
+                 "will be located one by one: %s", n, strerror(-rc));
 
-    assert(cnt == 1);
+    for (i = 0; i < n; i++) {
+        if (targets[i].rc)
+            continue;
 
-    /* locate media */
-    rc = layout_locate(&dss, layout, focus_host, hostname, nb_new_lock);
-    dss_res_free(layout, cnt);
+        targets[i].rc = layout_locate(&dss, &cache, layouts[i], focus_host,
+                                      &targets[i].hostname,
+                                      &targets[i].nb_new_lock);
+        dss_res_free(layouts[i], 1);
+    }
 
-clean:
-    object_info_free(obj);
+    for (i = 0; i < n; i++)
+        rc2 = rc2 ? : targets[i].rc;
+
+    dss_locate_cache_fini(&cache);
+    g_array_free(medium_ids, true);
+    free(layouts);
     dss_fini(&dss);
+
+    return rc2;
+
+fail_all:
+    for (i = 0; i < n; i++)
+        targets[i].rc = rc;
+
     return rc;
 }
@@ -0,0 +1,557 @@
+/* -*- mode: c; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief  Client cache of the object and layout metadata of Phobos store
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <glib.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "store_md_cache.h"
+
+#include "pho_cfg.h"
+#include "pho_common.h"
+#include "pho_dss_wrapper.h"
+#include "pho_type_utils.h"
+
+/**
+ * List of configuration parameters for the metadata cache
+ */
+enum pho_cfg_params_store_md_cache {
+    PHO_CFG_STORE_MD_CACHE_FIRST,
+
+    /* store parameters */
+    PHO_CFG_STORE_MD_CACHE_md_cache_size = PHO_CFG_STORE_MD_CACHE_FIRST,
+
+    PHO_CFG_STORE_MD_CACHE_LAST
+};
+
+const struct pho_config_item cfg_store_md_cache[] = {
+    [PHO_CFG_STORE_MD_CACHE_md_cache_size] = {
+        .section = "store",
+        .name    = "md_cache_size",
+        .value   = "0"
+    },
+};
+
+enum md_cache_kind {
+    MD_CACHE_FOUND_OBJECT,      /**< Result of dss_lazy_find_object */
+    MD_CACHE_LIVING_OBJECT,     /**< Object of the object table */
+    MD_CACHE_FULL_LAYOUT,       /**< Layout and extents of a version */
+};
+
+struct md_cache_key {
+    enum md_cache_kind kind;
+    char *oid;
+    char *uuid;
+    int version;
+};
+
+struct md_cache_entry {
+    struct md_cache_key key;
+    GList lru_link;             /**< Link in md_cache.lru */
+    const char *oid;            /**< OID of the cached value */
+    const char *uuid;           /**< UUID of the cached value */
+    union {
+        struct object_info *object;
+        struct layout_info *layout;
+    } value;
+};
+
+static struct md_cache {
+    pthread_mutex_t mutex;
+    bool configured;
+    size_t capacity;            /**< 0 if the cache is disabled */
+    GHashTable *entries;        /**< md_cache_key -> md_cache_entry */
+    GQueue lru;                 /**< Most recently used entry first */
+    GHashTable *by_oid;         /**< OID -> GQueue of entries */
+    GHashTable *by_uuid;        /**< UUID -> GQueue of entries */
+    /** Incremented on each invalidation, a value fetched from the DSS is only
+     *  cached if no invalidation happened since the cache miss. 0 is never
+     *  used, it means that the value must not be cached.
+     */
+    uint64_t generation;
+    struct dss_handle listener; /**< Connection receiving the notifications */
+    bool listening;
+} md_cache = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .generation = 1,
+};
+
+static guint md_cache_key_hash(gconstpointer key_ptr)
+{
+    const struct md_cache_key *key = key_ptr;
+    guint hash = key->kind * 31 + key->version;
+
+    if (key->oid)
+        hash = hash * 31 + g_str_hash(key->oid);
+    if (key->uuid)
+        hash = hash * 31 + g_str_hash(key->uuid);
+
+    return hash;
+}
+
+static gboolean md_cache_key_equal(gconstpointer a, gconstpointer b)
+{
+    const struct md_cache_key *key_a = a;
+    const struct md_cache_key *key_b = b;
+
+    return key_a->kind == key_b->kind && key_a->version == key_b->version &&
+           !g_strcmp0(key_a->oid, key_b->oid) &&
+           !g_strcmp0(key_a->uuid, key_b->uuid);
+}
+
+static void entry_free(struct md_cache_entry *entry)
+{
+    if (entry->key.kind == MD_CACHE_FULL_LAYOUT)
+        layout_info_free(entry->value.layout);
+    else
+        object_info_free(entry->value.object);
+
+    free(entry->key.oid);
+    free(entry->key.uuid);
+    free(entry);
+}
+
+static void index_add(GHashTable *index, const char *name,
+                      struct md_cache_entry *entry)
+{
+    GQueue *entries;
+
+    if (!name)
+        return;
+
+    entries = g_hash_table_lookup(index, name);
+    if (!entries) {
+        entries = g_queue_new();
+        g_hash_table_insert(index, xstrdup(name), entries);
+    }
+
+    g_queue_push_tail(entries, entry);
+}
+
+static void index_remove(GHashTable *index, const char *name,
+                         struct md_cache_entry *entry)
+{
+    GQueue *entries;
+
+    if (!name)
+        return;
+
+    entries = g_hash_table_lookup(index, name);
+    if (!entries)
+        return;
+
+    g_queue_remove(entries, entry);
+    if (g_queue_is_empty(entries))
+        g_hash_table_remove(index, name);
+}
+
+/* Must be called with the cache mutex held */
+static void entry_remove(struct md_cache_entry *entry)
+{
+    g_hash_table_remove(md_cache.entries, &entry->key);
+    g_queue_unlink(&md_cache.lru, &entry->lru_link);
+    index_remove(md_cache.by_oid, entry->oid, entry);
+    index_remove(md_cache.by_uuid, entry->uuid, entry);
+    entry_free(entry);
+}
+
+/* Must be called with the cache mutex held */
+static void invalidate_name(GHashTable *index, const char *name)
+{
+    GQueue *entries;
+
+    /* the queue is freed with its last entry */
+    while ((entries = g_hash_table_lookup(index, name)) != NULL)
+        entry_remove(g_queue_peek_head(entries));
+}
+
+/* Must be called with the cache mutex held */
+static void invalidate_all(void)
+{
+    GList *link;
+
+    md_cache.generation++;
+    if (!md_cache.entries)
+        return;
+
+    while ((link = g_queue_pop_head_link(&md_cache.lru)) != NULL)
+        entry_free(link->data);
+
+    g_hash_table_remove_all(md_cache.entries);
+    g_hash_table_remove_all(md_cache.by_oid);
+    g_hash_table_remove_all(md_cache.by_uuid);
+}
+
+static void notification_cb(const char *channel, const char *payload,
+                            void *udata)
+{
+    (void) udata;
+
+    if (strcmp(channel, DSS_OBJECT_CHANGE_CHANNEL))
+        return;
+
+    if (!strncmp(payload, "oid:", 4)) {
+        md_cache.generation++;
+        invalidate_name(md_cache.by_oid, payload + 4);
+    } else if (!strncmp(payload, "uuid:", 5)) {
+        md_cache.generation++;
+        invalidate_name(md_cache.by_uuid, payload + 5);
+    } else {
+        invalidate_all();
+    }
+}
+
+/* Must be called with the cache mutex held */
+static void listener_close(void)
+{
+    if (!md_cache.listening)
+        return;
+
+    dss_fini(&md_cache.listener);
+    md_cache.listening = false;
+}
+
+/* Must be called with the cache mutex held */
+static int listener_open(void)
+{
+    bool notified;
+    int rc;
+
+    rc = dss_init(&md_cache.listener);
+    if (rc)
+        return rc;
+
+    rc = dss_object_changes_notified(&md_cache.listener, &notified);
+    if (!rc && !notified)
+        LOG_GOTO(out_fini, rc = -ENOTSUP,
+                 "The DSS does not notify the object changes, set "
+                 DSS_OBJECT_CHANGE_SETTING " to use the metadata cache");
+    if (rc)
+        goto out_fini;
+
+    rc = dss_listen(&md_cache.listener, DSS_OBJECT_CHANGE_CHANNEL);
+    if (rc)
+        goto out_fini;
+
+    md_cache.listening = true;
+
+    return 0;
+
+out_fini:
+    dss_fini(&md_cache.listener);
+    return rc;
+}
+
+/**
+ * Take the cache mutex and make the cache up to date with the notifications.
+ *
+ * @return true if the cache can be used, with the mutex held, false
+ *         otherwise.
+ */
+static bool md_cache_enter(void)
+{
+    int rc;
+
+    MUTEX_LOCK(&md_cache.mutex);
+
+    if (!md_cache.configured) {
+        int size = PHO_CFG_GET_INT(cfg_store_md_cache, PHO_CFG_STORE_MD_CACHE,
+                                   md_cache_size, 0);
+
+        md_cache.capacity = size > 0 ? size : 0;
+        md_cache.configured = true;
+        if (md_cache.capacity > 0) {
+            md_cache.entries = g_hash_table_new(md_cache_key_hash,
+                                                md_cache_key_equal);
+            md_cache.by_oid = g_hash_table_new_full(
+                g_str_hash, g_str_equal, free, (GDestroyNotify)g_queue_free);
+            md_cache.by_uuid = g_hash_table_new_full(
+                g_str_hash, g_str_equal, free, (GDestroyNotify)g_queue_free);
+            g_queue_init(&md_cache.lru);
+        }
+    }
+
+    if (md_cache.capacity == 0)
+        goto bypass;
+
+    /* Nothing is cached while not listening, so nothing can be stale once
+     * listening again.
+     */
+    if (!md_cache.listening) {
+        rc = listener_open();
+        if (rc) {
+            pho_warn("Cannot listen to the DSS notifications, metadata cache "
+                     "bypassed: %s", strerror(-rc));
+            goto bypass;
+        }
+    }
+
+    rc = dss_notifications_consume(&md_cache.listener, notification_cb, NULL);
+    if (rc) {
+        pho_warn("DSS notifications lost, metadata cache emptied");
+        invalidate_all();
+        listener_close();
+        goto bypass;
+    }
+
+    return true;
+
+bypass:
+    MUTEX_UNLOCK(&md_cache.mutex);
+    return false;
+}
+
+/**
+ * Look up \p key in the cache.
+ *
+ * @param[in]   key         Key of the value.
+ * @param[out]  generation  On miss, generation to give to md_cache_insert.
+ *
+ * @return the cached entry with the cache mutex held, NULL on miss.
+ */
+static struct md_cache_entry *md_cache_lookup(const struct md_cache_key *key,
+                                              uint64_t *generation)
+{
+    struct md_cache_entry *entry;
+
+    *generation = 0;
+    if (!md_cache_enter())
+        return NULL;
+
+    entry = g_hash_table_lookup(md_cache.entries, key);
+    if (!entry) {
+        *generation = md_cache.generation;
+        MUTEX_UNLOCK(&md_cache.mutex);
+        return NULL;
+    }
+
+    g_queue_unlink(&md_cache.lru, &entry->lru_link);
+    g_queue_push_head_link(&md_cache.lru, &entry->lru_link);
+
+    return entry;
+}
+
+/**
+ * Cache the value fetched after a miss, unless it may be stale.
+ *
+ * @param[in]  key          Key of the value.
+ * @param[in]  generation   Generation returned by md_cache_lookup.
+ * @param[in]  entry        Entry holding the value, whose key is unset. It is
+ *                          freed if not cached.
+ */
+static void md_cache_insert(const struct md_cache_key *key,
+                            uint64_t generation, struct md_cache_entry *entry)
+{
+    entry->key.kind = key->kind;
+    entry->key.oid = xstrdup_safe(key->oid);
+    entry->key.uuid = xstrdup_safe(key->uuid);
+    entry->key.version = key->version;
+    entry->lru_link.data = entry;
+
+    MUTEX_LOCK(&md_cache.mutex);
+    if (generation == 0 || generation != md_cache.generation ||
+        !md_cache.listening ||
+        g_hash_table_contains(md_cache.entries, &entry->key)) {
+        MUTEX_UNLOCK(&md_cache.mutex);
+        entry_free(entry);
+        return;
+    }
+
+    g_hash_table_insert(md_cache.entries, &entry->key, entry);
+    g_queue_push_head_link(&md_cache.lru, &entry->lru_link);
+    index_add(md_cache.by_oid, entry->oid, entry);
+    index_add(md_cache.by_uuid, entry->uuid, entry);
+
+    while (md_cache.lru.length > md_cache.capacity)
+        entry_remove(g_queue_peek_tail(&md_cache.lru));
+    MUTEX_UNLOCK(&md_cache.mutex);
+}
+
+static struct md_cache_entry *object_entry_new(const struct object_info *obj)
+{
+    struct md_cache_entry *entry = xcalloc(1, sizeof(*entry));
+
+    entry->value.object = object_info_dup(obj);
+    entry->oid = entry->value.object->oid;
+    entry->uuid = entry->value.object->uuid;
+
+    return entry;
+}
+
+int md_cache_object_find(struct dss_handle *dss, const char *oid,
+                         const char *uuid, int version,
+                         struct object_info **obj)
+{
+    struct md_cache_key key = {
+        .kind = MD_CACHE_FOUND_OBJECT,
+        .oid = (char *)oid,
+        .uuid = (char *)uuid,
+        .version = version,
+    };
+    struct md_cache_entry *entry;
+    uint64_t generation;
+    int rc;
+
+    entry = md_cache_lookup(&key, &generation);
+    if (entry) {
+        *obj = object_info_dup(entry->value.object);
+        MUTEX_UNLOCK(&md_cache.mutex);
+        return 0;
+    }
+
+    rc = dss_lazy_find_object(dss, oid, uuid, version, obj);
+    if (rc)
+        return rc;
+
+    if (generation)
+        md_cache_insert(&key, generation, object_entry_new(*obj));
+
+    return 0;
+}
+
+int md_cache_living_object_get(struct dss_handle *dss, const char *oid,
+                               struct object_info **obj)
+{
+    struct md_cache_key key = {
+        .kind = MD_CACHE_LIVING_OBJECT,
+        .oid = (char *)oid,
+    };
+    struct md_cache_entry *entry;
+    struct object_info *objs;
+    struct dss_filter filter;
+    uint64_t generation;
+    int obj_cnt;
+    int rc;
+
+    entry = md_cache_lookup(&key, &generation);
+    if (entry) {
+        *obj = object_info_dup(entry->value.object);
+        MUTEX_UNLOCK(&md_cache.mutex);
+        return 0;
+    }
+
+    rc = dss_filter_build(&filter, "{\"DSS::OBJ::oid\": \"%s\"}", oid);
+    if (rc)
+        return rc;
+
+    rc = dss_object_get(dss, &filter, &objs, &obj_cnt, NULL);
+    dss_filter_free(&filter);
+    if (rc)
+        LOG_RETURN(rc, "Cannot fetch objid:'%s'", oid);
+
+    if (obj_cnt == 0) {
+        dss_res_free(objs, obj_cnt);
+        LOG_RETURN(-ENOENT, "No such object objid:'%s'", oid);
+    }
+
+    *obj = object_info_dup(&objs[0]);
+    dss_res_free(objs, obj_cnt);
+
+    if (generation)
+        md_cache_insert(&key, generation, object_entry_new(*obj));
+
+    return 0;
+}
+
+int md_cache_full_layout_get(struct dss_handle *dss, const char *uuid,
+                             int version, struct layout_info **layout)
+{
+    struct md_cache_key key = {
+        .kind = MD_CACHE_FULL_LAYOUT,
+        .uuid = (char *)uuid,
+        .version = version,
+    };
+    struct md_cache_entry *entry;
+    struct layout_info *layouts;
+    uint64_t generation;
+    int cnt = 0;
+    int rc;
+
+    entry = md_cache_lookup(&key, &generation);
+    if (entry) {
+        *layout = layout_info_dup(entry->value.layout);
+        MUTEX_UNLOCK(&md_cache.mutex);
+        return 0;
+    }
+
+    rc = dss_full_layout_get_from_uuid(dss, uuid, version, &layouts, &cnt);
+    if (rc)
+        return rc;
+
+    if (cnt == 0) {
+        dss_res_free(layouts, cnt);
+        return -ENOENT;
+    }
+
+    *layout = layout_info_dup(layouts);
+    dss_res_free(layouts, cnt);
+
+    if (generation) {
+        entry = xcalloc(1, sizeof(*entry));
+        entry->value.layout = layout_info_dup(*layout);
+        entry->oid = entry->value.layout->oid;
+        entry->uuid = entry->value.layout->uuid;
+        md_cache_insert(&key, generation, entry);
+    }
+
+    return 0;
+}
+
+void md_cache_invalidate(const char *oid, const char *uuid)
+{
+    MUTEX_LOCK(&md_cache.mutex);
+    if (md_cache.capacity > 0) {
+        md_cache.generation++;
+        if (oid)
+            invalidate_name(md_cache.by_oid, oid);
+        if (uuid)
+            invalidate_name(md_cache.by_uuid, uuid);
+    }
+    MUTEX_UNLOCK(&md_cache.mutex);
+}
+
+void md_cache_fini(void)
+{
+    MUTEX_LOCK(&md_cache.mutex);
+    invalidate_all();
+    listener_close();
+
+    if (md_cache.entries) {
+        g_hash_table_destroy(md_cache.entries);
+        g_hash_table_destroy(md_cache.by_oid);
+        g_hash_table_destroy(md_cache.by_uuid);
+        md_cache.entries = NULL;
+        md_cache.by_oid = NULL;
+        md_cache.by_uuid = NULL;
+    }
+
+    md_cache.capacity = 0;
+    md_cache.configured = false;
+    MUTEX_UNLOCK(&md_cache.mutex);
+}
@@ -0,0 +1,94 @@
+/* -*- mode: c; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief  Client cache of the object and layout metadata of Phobos store
+ *
+ * The cache keeps the last "md_cache_size" objects and layouts read from the
+ * DSS, and is disabled if this size is 0. It is invalidated by the
+ * notifications the DSS sends on DSS_OBJECT_CHANGE_CHANNEL, which are read on
+ * a dedicated connection before each lookup. A change made by another host
+ * may therefore be seen slightly after it is committed. If the notifications
+ * cannot be received, the cache is emptied and bypassed until the connection
+ * is back.
+ */
+#ifndef _STORE_MD_CACHE_H
+#define _STORE_MD_CACHE_H
+
+#include "pho_dss.h"
+#include "pho_types.h"
+
+/**
+ * Cached version of dss_lazy_find_object.
+ *
+ * @param[in]   dss     DSS handle to use on cache miss.
+ * @param[in]   oid     OID to find or NULL
+ * @param[in]   uuid    UUID to find or NULL
+ * @param[in]   version Version to find or 0
+ * @param[out]  obj     Found object, to be freed with object_info_free
+ *
+ * @return 0 on success, -errno on failure.
+ */
+int md_cache_object_find(struct dss_handle *dss, const char *oid,
+                         const char *uuid, int version,
+                         struct object_info **obj);
+
+/**
+ * Get the living object \p oid.
+ *
+ * @param[in]   dss     DSS handle to use on cache miss.
+ * @param[in]   oid     OID of the object.
+ * @param[out]  obj     Found object, to be freed with object_info_free
+ *
+ * @return 0 on success, -ENOENT if there is no such object, -errno on
+ *         failure.
+ */
+int md_cache_living_object_get(struct dss_handle *dss, const char *oid,
+                               struct object_info **obj);
+
+/**
+ * Get the layout and extents of one object version.
+ *
+ * @param[in]   dss     DSS handle to use on cache miss.
+ * @param[in]   uuid    UUID of the object.
+ * @param[in]   version Version of the object.
+ * @param[out]  layout  Found layout, to be freed with layout_info_free
+ *
+ * @return 0 on success, -ENOENT if there is no such layout, -errno on
+ *         failure.
+ */
+int md_cache_full_layout_get(struct dss_handle *dss, const char *uuid,
+                             int version, struct layout_info **layout);
+
+/**
+ * Drop the cached metadata of an object, to be called after changing it.
+ *
+ * @param[in]   oid     OID of the object or NULL
+ * @param[in]   uuid    UUID of the object or NULL
+ */
+void md_cache_invalidate(const char *oid, const char *uuid);
+
+/**
+ * Drop all the cached metadata and close the listening connection.
+ */
+void md_cache_fini(void);
+
+#endif
@@ -27,6 +27,8 @@
 #endif
 
 #include <fcntl.h>
+#include <glib.h>
+#include <pthread.h>
 #include <signal.h>
 #include <stdbool.h>
 #include <stdlib.h>
@@ -47,6 +49,7 @@
 #include "scsi_api.h"
 
 #include "tlc_cfg.h"
+#include "tlc_jobs.h"
 #include "tlc_library.h"
 
 static bool should_tlc_stop(void)
@@ -54,12 +57,114 @@ static bool should_tlc_stop(void)
     return !running;
 }
 
+/** Thread performing moves with one transport element of the library */
+struct tlc_mover {
+    struct tlc *tlc;
+    pthread_t tid;
+    bool started;
+    uint16_t arm_addr;          /*!< Transport element address, 0 for the
+                                  *  default one
+                                  */
+    struct dss_handle dss;      /*!< Own DSS handle, to log the moves */
+};
+
 struct tlc {
     struct pho_comm_info comm;  /*!< Communication handle */
+    struct pho_comm_info worker; /*!< Worker of comm polled by the main
+                                   *  thread, woken up to answer the jobs
+                                   *  processed by the movers
+                                   */
     struct lib_descriptor lib;  /*!< Library descriptor */
-    struct dss_handle dss;      /*!< DSS handle, configured from conf */
+    pthread_mutex_t mutex;      /*!< Protects lib cache and the fields below */
+    pthread_cond_t cond;        /*!< Signaled on new jobs and ended moves */
+    GQueue *jobs;               /*!< Pending struct tlc_job, in arrival order */
+    GQueue *done;               /*!< Processed struct tlc_job, to be answered
+                                  *  by the main thread
+                                  */
+    int n_moving;               /*!< Number of moves in progress */
+    bool refreshing;            /*!< A mover is refreshing the library */
+    bool stopping;              /*!< Set to stop the movers */
+    bool refresh_failed;        /*!< No valid library cache anymore */
+    struct tlc_mover *movers;   /*!< One mover per transport element */
+    int n_movers;
+    /* Only used by the main thread, which receives and closes the client
+     * sockets and sends all the responses: a response can then never be sent
+     * to a closed socket reused by another client.
+     */
+    GHashTable *clients;        /*!< Generation of the connection of each
+                                  *  client socket
+                                  */
+    size_t last_client_gen;     /*!< Generation of the last connection */
 };
 
+static void *tlc_mover_thread(void *arg);
+
+/**
+ * Start one mover per transport element of the library, so that the moves
+ * using different arms are performed concurrently.
+ */
+static int tlc_movers_start(struct tlc *tlc)
+{
+    int rc;
+    int i;
+
+    tlc->n_movers = tlc->lib.arms.count > 1 ? tlc->lib.arms.count : 1;
+    tlc->movers = xcalloc(tlc->n_movers, sizeof(*tlc->movers));
+
+    for (i = 0; i < tlc->n_movers; i++) {
+        struct tlc_mover *mover = &tlc->movers[i];
+
+        mover->tlc = tlc;
+        /* with a single arm, let the library use its default one */
+        mover->arm_addr = tlc->n_movers > 1 ?
+                              tlc->lib.arms.items[i].address : 0;
+
+        rc = dss_init(&mover->dss);
+        if (rc)
+            LOG_RETURN(rc, "Cannot initialize DSS of mover %d", i);
+
+        rc = -pthread_create(&mover->tid, NULL, tlc_mover_thread, mover);
+        if (rc) {
+            dss_fini(&mover->dss);
+            LOG_RETURN(rc, "Failed to start mover %d", i);
+        }
+
+        mover->started = true;
+    }
+
+    pho_verb("Library '%s' moves handled by %d threads", tlc->lib.name,
+             tlc->n_movers);
+
+    return 0;
+}
+
+/** Wait for the end of the moves in progress and of the movers */
+static void tlc_movers_stop(struct tlc *tlc)
+{
+    int i;
+
+    if (!tlc->movers)
+        return;
+
+    MUTEX_LOCK(&tlc->mutex);
+    tlc->stopping = true;
+    pthread_cond_broadcast(&tlc->cond);
+    MUTEX_UNLOCK(&tlc->mutex);
+
+    for (i = 0; i < tlc->n_movers; i++) {
+        struct tlc_mover *mover = &tlc->movers[i];
+
+        if (mover->started) {
+            pthread_join(mover->tid, NULL);
+            dss_fini(&mover->dss);
+            mover->started = false;
+        }
+    }
+
+    free(tlc->movers);
+    tlc->movers = NULL;
+}
+
 static int tlc_init(struct tlc *tlc, const char *library)
 {
     union pho_comm_addr sock_addr = {0};
@@ -82,6 +187,13 @@ static int tlc_init(struct tlc *tlc, const char *library)
     memcpy(tlc->lib.name, library, len_library);
     tlc->lib.name[len_library] = '\0';
 
+    pthread_mutex_init(&tlc->mutex, NULL);
+    pthread_cond_init(&tlc->cond, NULL);
+    tlc->jobs = g_queue_new();
+    tlc->done = g_queue_new();
+    tlc->clients = g_hash_table_new(g_direct_hash, g_direct_equal);
+    tlc->worker = pho_comm_info_init();
+
     /* open TLC lib file descriptor and load library cache */
     rc = tlc_lib_device_from_cfg(tlc->lib.name, &lib_dev);
     if (rc)
@@ -133,50 +245,47 @@ static int tlc_init(struct tlc *tlc, const char *library)
     if (rc)
         LOG_GOTO(close_lib, rc, "Error while opening the TLC socket");
 
-    /* DSS handle init */
-    rc = dss_init(&tlc->dss);
+    rc = pho_comm_open_worker(&tlc->worker, &tlc->comm);
     if (rc)
-        LOG_GOTO(close_lib, rc, "Cannot initialize DSS");
+        LOG_GOTO(close_comm, rc, "Error while opening the TLC socket worker");
+
+    rc = tlc_movers_start(tlc);
+    if (rc)
+        LOG_GOTO(close_comm, rc, "Cannot start the TLC movers");
 
     return rc;
 
+close_comm:
+    tlc_movers_stop(tlc);
+    pho_comm_close(&tlc->worker);
+    pho_comm_close(&tlc->comm);
 close_lib:
     tlc_library_close(&tlc->lib);
     return rc;
 }
 
-static void tlc_fini(struct tlc *tlc)
-{
-    int rc;
-
-    ENTRY;
-
-    if (tlc == NULL)
-        return;
-
-    rc = pho_comm_close(&tlc->comm);
-    if (rc)
-        pho_error(rc, "Error on closing the TLC socket");
-
-    tlc_library_close(&tlc->lib);
-
-    dss_fini(&tlc->dss);
-}
-
 /**
- * Send a response message
+ * Send a response message, must be called by the main thread
  *
+ * @param[in]   tlc             TLC
  * @param[in]   resp            response message to send
  * @param[in]   client_socket   socket fd on which the response message must be
- *                              sent
+ *                              sent, -1 if the client is disconnected
  *
  * @return 0 on success, else a negative error code
  */
-static int tlc_response_send(pho_tlc_resp_t *resp, int client_socket)
+static int tlc_response_send(struct tlc *tlc, pho_tlc_resp_t *resp,
+                             int client_socket)
 {
     struct pho_comm_data msg;
     int rc;
 
+    if (client_socket < 0) {
+        pho_verb("Dropping response to request %d of a disconnected client",
+                 resp->req_id);
+        return 0;
+    }
+
     pho_srl_tlc_response_pack(resp, &msg.buf);
 
     msg.fd = client_socket;
@@ -198,13 +307,16 @@ static int process_ping_request(struct tlc *tlc, pho_tlc_req_t *req,
 
     resp.req_id = req->id;
 
+    /* a refresh reopens the library device */
+    MUTEX_LOCK(&tlc->mutex);
     rc = scsi_inquiry(tlc->lib.fd);
+    MUTEX_UNLOCK(&tlc->mutex);
     if (rc)
         resp.ping->library_is_up = false;
     else
         resp.ping->library_is_up = true;
 
-    rc = tlc_response_send(&resp, client_socket);
+    rc = tlc_response_send(tlc, &resp, client_socket);
     pho_srl_tlc_response_free(&resp, false);
     return rc;
 }
@@ -238,8 +350,11 @@ static int process_drive_lookup_request(struct tlc *tlc, pho_tlc_req_t *req,
     pho_tlc_resp_t error_resp;
     int rc, rc2;
 
+    /* answered from the cache, even if a move of the drive is in progress */
+    MUTEX_LOCK(&tlc->mutex);
     rc = tlc_library_drive_lookup(&tlc->lib, req->drive_lookup->serial,
                                   &drv_info, &json_error_message);
+    MUTEX_UNLOCK(&tlc->mutex);
     if (rc)
         goto err;
 
@@ -265,7 +380,7 @@ err:
         resp = &error_resp;
     }
 
-    rc2 = tlc_response_send(resp, client_socket);
+    rc2 = tlc_response_send(tlc, resp, client_socket);
     if (rc2)
         rc = rc ? : rc2;
 
@@ -273,36 +388,30 @@ err:
     return rc;
 }
 
-static int process_load_request(struct tlc *tlc, pho_tlc_req_t *req,
-                                int client_socket)
+static int send_load_response(struct tlc *tlc, struct tlc_job *job,
+                              int client_socket)
 {
-    json_t *json_message = NULL;
     pho_tlc_resp_t *resp = NULL;
     pho_tlc_resp_t error_resp;
     pho_tlc_resp_t load_resp;
-    int rc, rc2;
+    int rc = job->rc;
+    int rc2;
 
-    rc = tlc_library_load(&tlc->dss, &tlc->lib, req->load->drive_serial,
-                          req->load->tape_label, &json_message);
     if (rc) {
-        tlc_build_response_error(&error_resp, req->id, rc, json_message);
-        if (json_message)
-            json_decref(json_message);
-
+        tlc_build_response_error(&error_resp, job->req->id, rc,
+                                 job->json_message);
         resp = &error_resp;
     } else {
         /* Build load response */
         pho_srl_tlc_response_load_alloc(&load_resp);
-        load_resp.req_id = req->id;
-        if (json_message) {
-            load_resp.load->message = json_dumps(json_message, 0);
-            json_decref(json_message);
-        }
+        load_resp.req_id = job->req->id;
+        if (job->json_message)
+            load_resp.load->message = json_dumps(job->json_message, 0);
 
         resp = &load_resp;
     }
 
-    rc2 = tlc_response_send(resp, client_socket);
+    rc2 = tlc_response_send(tlc, resp, client_socket);
     if (rc2)
         rc = rc ? : rc2;
 
@@ -310,44 +419,35 @@ static int process_load_request(struct tlc *tlc, pho_tlc_req_t *req,
     return rc;
 }
 
-static int process_unload_request(struct tlc *tlc, pho_tlc_req_t *req,
-                                  int client_socket)
+static int send_unload_response(struct tlc *tlc, struct tlc_job *job,
+                                int client_socket)
 {
-    struct lib_item_addr unload_addr;
-    json_t *json_message = NULL;
     pho_tlc_resp_t *resp = NULL;
     pho_tlc_resp_t unload_resp;
     pho_tlc_resp_t error_resp;
-    char *unloaded_tape_label;
-    int rc, rc2;
+    int rc = job->rc;
+    int rc2;
 
-    rc = tlc_library_unload(&tlc->dss, &tlc->lib, req->unload->drive_serial,
-                            req->unload->tape_label, &unloaded_tape_label,
-                            &unload_addr, &json_message);
     if (rc) {
-        tlc_build_response_error(&error_resp, req->id, rc, json_message);
-        if (json_message)
-            json_decref(json_message);
-
+        tlc_build_response_error(&error_resp, job->req->id, rc,
+                                 job->json_message);
         resp = &error_resp;
     } else {
         /* Build unload response */
         pho_srl_tlc_response_unload_alloc(&unload_resp);
-        if (unloaded_tape_label)
-            unload_resp.unload->tape_label = xstrdup(unloaded_tape_label);
+        if (job->unloaded_tape_label)
+            unload_resp.unload->tape_label =
+                xstrdup(job->unloaded_tape_label);
 
-        free(unloaded_tape_label);
-        unload_resp.unload->addr = unload_addr.lia_addr;
-        unload_resp.req_id = req->id;
-        if (json_message) {
-            unload_resp.unload->message = json_dumps(json_message, 0);
-            json_decref(json_message);
-        }
+        unload_resp.unload->addr = job->unload_addr.lia_addr;
+        unload_resp.req_id = job->req->id;
+        if (job->json_message)
+            unload_resp.unload->message = json_dumps(job->json_message, 0);
 
         resp = &unload_resp;
     }
 
-    rc2 = tlc_response_send(resp, client_socket);
+    rc2 = tlc_response_send(tlc, resp, client_socket);
     if (rc2)
         rc = rc ? : rc2;
 
@@ -355,42 +455,17 @@ static int process_unload_request(struct tlc *tlc, pho_tlc_req_t *req,
     return rc;
 }
 
-static int process_status_request(struct tlc *tlc, pho_tlc_req_t *req,
-                                  int client_socket)
+/**
+ * Build the status response of the library cache, must be called with
+ * tlc->mutex held
+ */
+static void build_status_response(struct tlc *tlc, pho_tlc_req_t *req,
+                                  pho_tlc_resp_t *resp)
 {
     char *string_lib_data = NULL;
     json_t *json_message = NULL;
-    pho_tlc_resp_t *resp = NULL;
-    bool refresh_failed = false;
-    pho_tlc_resp_t status_resp;
-    pho_tlc_resp_t error_resp;
     json_t *json_lib_data;
-    int rc, rc2;
-
-    if (req->status->refresh) {
-        const char *lib_dev;
-
-        rc = tlc_lib_device_from_cfg(tlc->lib.name, &lib_dev);
-        if (rc) {
-            pho_error(rc,
-                      "Failed to get default library device from config to "
-                      "refresh for library %s", tlc->lib.name);
-            json_message = json_pack("{s:s}", "LIB_DEV_CONF_ERROR",
-                                     "Failed to get default library device "
-                                     "from config to refresh");
-            refresh_failed = true;
-            goto error_response;
-        }
-
-        rc = tlc_library_refresh(&tlc->lib, lib_dev, &json_message);
-        if (rc) {
-            refresh_failed = true;
-            goto error_response;
-        }
-
-        if (json_message)
-            json_decref(json_message);
-    }
+    int rc;
 
     rc = tlc_library_status(&tlc->lib, &json_lib_data, &json_message);
     if (!rc) {
@@ -409,94 +484,294 @@ static int process_status_request(struct tlc *tlc, pho_tlc_req_t *req,
     }
 
     if (rc) {
-error_response:
-        tlc_build_response_error(&error_resp, req->id, rc, json_message);
-        if (json_message)
-            json_decref(json_message);
-
-        resp = &error_resp;
+        tlc_build_response_error(resp, req->id, rc, json_message);
     } else {
         /* Build status response */
-        pho_srl_tlc_response_status_alloc(&status_resp);
-        status_resp.status->lib_data = string_lib_data;
-        status_resp.req_id = req->id;
-        if (json_message) {
-            status_resp.status->message = json_dumps(json_message, 0);
-            json_decref(json_message);
-        }
-
-        resp = &status_resp;
+        pho_srl_tlc_response_status_alloc(resp);
+        resp->status->lib_data = string_lib_data;
+        resp->req_id = req->id;
+        if (json_message)
+            resp->status->message = json_dumps(json_message, 0);
     }
 
-    rc2 = tlc_response_send(resp, client_socket);
-    if (rc2)
-        rc = rc ? : rc2;
+    if (json_message)
+        json_decref(json_message);
+}
 
-    pho_srl_tlc_response_free(resp, false);
+/** Answer a status request without refresh from the library cache */
+static int process_status_request(struct tlc *tlc, pho_tlc_req_t *req,
+                                  int client_socket)
+{
+    pho_tlc_resp_t resp;
+    int rc;
 
-    if (refresh_failed) {
-        pho_error(rc, "On refresh failure, without any valid library cache, "
-                      "TLC commits suicide");
-        tlc_fini(tlc);
-        exit(EXIT_FAILURE);
+    MUTEX_LOCK(&tlc->mutex);
+    build_status_response(tlc, req, &resp);
+    MUTEX_UNLOCK(&tlc->mutex);
+
+    rc = tlc_response_send(tlc, &resp, client_socket);
+    pho_srl_tlc_response_free(&resp, false);
+    return rc;
+}
+
+/**
+ * Answer a refresh or a status with refresh request, once the library is
+ * refreshed
+ */
+static int send_refresh_response(struct tlc *tlc, struct tlc_job *job,
+                                 int client_socket)
+{
+    pho_tlc_resp_t resp;
+    int rc;
+
+    if (job->rc) {
+        tlc_build_response_error(&resp, job->req->id, job->rc,
+                                 job->json_message);
+    } else if (pho_tlc_request_is_status(job->req)) {
+        MUTEX_LOCK(&tlc->mutex);
+        build_status_response(tlc, job->req, &resp);
+        MUTEX_UNLOCK(&tlc->mutex);
+    } else {
+        pho_srl_tlc_response_refresh_alloc(&resp);
+        resp.req_id = job->req->id;
     }
 
+    rc = tlc_response_send(tlc, &resp, client_socket);
+    pho_srl_tlc_response_free(&resp, false);
     return rc;
 }
 
-static int process_refresh_request(struct tlc *tlc, pho_tlc_req_t *req,
-                                   int client_socket)
+/** Hand a processed job over to the main thread, tlc->mutex must be held */
+static void tlc_job_done(struct tlc *tlc, struct tlc_job *job)
 {
+    g_queue_push_tail(tlc->done, job);
+    pho_comm_wakeup(&tlc->worker);
+}
+
+/**
+ * Refresh the library once for all the given refresh and status requests,
+ * must be called with tlc->mutex held and no move in progress.
+ *
+ * The mutex is released while the library is read: the moves stay held back,
+ * and the other requests are answered from the former cache meanwhile.
+ */
+static void tlc_refresh(struct tlc *tlc, GList *jobs)
+{
+    struct lib_descriptor fresh = { .fd = -1 };
     json_t *json_message = NULL;
-    pho_tlc_resp_t *resp = NULL;
-    pho_tlc_resp_t refresh_resp;
-    pho_tlc_resp_t error_resp;
     const char *lib_dev;
-    int rc, rc2;
+    GList *item;
+    int rc;
 
-    rc = tlc_lib_device_from_cfg(tlc->lib.name, &lib_dev);
+    tlc->refreshing = true;
+    memcpy(fresh.name, tlc->lib.name, sizeof(fresh.name));
+    MUTEX_UNLOCK(&tlc->mutex);
+
+    rc = tlc_lib_device_from_cfg(fresh.name, &lib_dev);
     if (rc) {
         pho_error(rc,
                   "Failed to get default library device from config to refresh "
-                  "for library %s", tlc->lib.name);
+                  "for library %s", fresh.name);
         json_message = json_pack("{s:s}", "LIB_DEV_CONF_ERROR",
                                  "Failed to get default library device from "
                                  "config to refresh");
-        goto error_response;
+    } else {
+        rc = tlc_library_open(&fresh, lib_dev, &json_message);
     }
 
-    rc = tlc_library_refresh(&tlc->lib, lib_dev, &json_message);
+    MUTEX_LOCK(&tlc->mutex);
     if (rc) {
-error_response:
-        tlc_build_response_error(&error_resp, req->id, rc, json_message);
-        if (json_message)
-            json_decref(json_message);
-
-        resp = &error_resp;
+        tlc_library_close(&fresh);
     } else {
-        /* Build load response */
-        pho_srl_tlc_response_refresh_alloc(&refresh_resp);
-        refresh_resp.req_id = req->id;
+        tlc_library_close(&tlc->lib);
+        tlc->lib = fresh;
+    }
+
+    pho_debug("Library '%s' refreshed for %u requests", tlc->lib.name,
+              g_list_length(jobs));
+
+    for (item = jobs; item; item = item->next) {
+        struct tlc_job *job = item->data;
+
+        job->rc = rc;
         if (json_message)
-            json_decref(json_message);
+            job->json_message = json_incref(json_message);
 
-        resp = &refresh_resp;
+        tlc_job_done(tlc, job);
     }
 
-    rc2 = tlc_response_send(resp, client_socket);
-    if (rc2)
-        rc = rc ? : rc2;
-
-    pho_srl_tlc_response_free(resp, false);
+    if (json_message)
+        json_decref(json_message);
 
+    tlc->refreshing = false;
     if (rc) {
         pho_error(rc, "On refresh failure, without any valid library cache, "
                       "TLC commits suicide");
-        tlc_fini(tlc);
-        exit(EXIT_FAILURE);
+        tlc->refresh_failed = true;
+        tlc->stopping = true;
+        running = false;
+    }
+}
+
+static void *tlc_mover_thread(void *arg)
+{
+    struct tlc_mover *mover = arg;
+    struct tlc *tlc = mover->tlc;
+
+    MUTEX_LOCK(&tlc->mutex);
+    while (!tlc->stopping) {
+        GList *refreshes = NULL;
+        struct tlc_job *job;
+
+        /* the jobs are held back until the refresh in progress ends */
+        job = tlc->refreshing ? NULL :
+                  tlc_next_job(&tlc->lib, tlc->jobs, tlc->n_moving,
+                               &refreshes);
+        if (refreshes) {
+            tlc_refresh(tlc, refreshes);
+            g_list_free(refreshes);
+            /* the jobs held back by the refreshes can proceed */
+            pthread_cond_broadcast(&tlc->cond);
+            continue;
+        }
+
+        if (!job) {
+            pthread_cond_wait(&tlc->cond, &tlc->mutex);
+            continue;
+        }
+
+        if (job->moving) {
+            tlc->n_moving++;
+            MUTEX_UNLOCK(&tlc->mutex);
+
+            job->rc = tlc_library_move(&mover->dss, &tlc->lib,
+                                       mover->arm_addr, &job->move);
+
+            MUTEX_LOCK(&tlc->mutex);
+            tlc_library_move_end(&tlc->lib, &job->move, job->rc);
+            tlc->n_moving--;
+            /* the elements of the move are released */
+            pthread_cond_broadcast(&tlc->cond);
+        }
+
+        tlc_job_done(tlc, job);
     }
+    MUTEX_UNLOCK(&tlc->mutex);
 
-    return rc;
+    return NULL;
+}
+
+/**
+ * Get the generation of the connection of a client socket, a new one on its
+ * first request
+ */
+static size_t tlc_client_gen(struct tlc *tlc, int client_socket)
+{
+    gpointer gen = g_hash_table_lookup(tlc->clients,
+                                       GINT_TO_POINTER(client_socket));
+
+    if (!gen) {
+        gen = GSIZE_TO_POINTER(++tlc->last_client_gen);
+        g_hash_table_insert(tlc->clients, GINT_TO_POINTER(client_socket), gen);
+    }
+
+    return GPOINTER_TO_SIZE(gen);
+}
+
+/** Forget a disconnected client, its socket may be reused by a new one */
+static void tlc_client_closed(struct tlc *tlc, int client_socket)
+{
+    g_hash_table_remove(tlc->clients, GINT_TO_POINTER(client_socket));
+}
+
+/** Socket to answer \p job on, -1 if its client is disconnected */
+static int tlc_job_client_socket(struct tlc *tlc, struct tlc_job *job)
+{
+    gpointer gen = g_hash_table_lookup(tlc->clients,
+                                       GINT_TO_POINTER(job->client_socket));
+
+    return GPOINTER_TO_SIZE(gen) == job->client_gen ? job->client_socket : -1;
+}
+
+static void tlc_job_queue(struct tlc *tlc, pho_tlc_req_t *req,
+                          int client_socket)
+{
+    struct tlc_job *job = xcalloc(1, sizeof(*job));
+
+    job->req = req;
+    job->client_socket = client_socket;
+    job->client_gen = tlc_client_gen(tlc, client_socket);
+
+    MUTEX_LOCK(&tlc->mutex);
+    g_queue_push_tail(tlc->jobs, job);
+    pthread_cond_broadcast(&tlc->cond);
+    MUTEX_UNLOCK(&tlc->mutex);
+}
+
+/** Answer the jobs processed by the movers */
+static void tlc_answer_done_jobs(struct tlc *tlc)
+{
+    struct tlc_job *job;
+    GQueue done;
+
+    /* the responses are sent without holding the mutex */
+    MUTEX_LOCK(&tlc->mutex);
+    done = *tlc->done;
+    g_queue_init(tlc->done);
+    MUTEX_UNLOCK(&tlc->mutex);
+
+    while ((job = g_queue_pop_head(&done)) != NULL) {
+        int client_socket = tlc_job_client_socket(tlc, job);
+
+        if (pho_tlc_request_is_load(job->req))
+            send_load_response(tlc, job, client_socket);
+        else if (pho_tlc_request_is_unload(job->req))
+            send_unload_response(tlc, job, client_socket);
+        else
+            send_refresh_response(tlc, job, client_socket);
+
+        tlc_job_free(job);
+    }
+}
+
+static void tlc_fini(struct tlc *tlc)
+{
+    struct tlc_job *job;
+    int rc;
+
+    ENTRY;
+
+    if (tlc == NULL)
+        return;
+
+    tlc_movers_stop(tlc);
+    tlc_answer_done_jobs(tlc);
+
+    /* answer the jobs which will never be processed */
+    while ((job = g_queue_pop_head(tlc->jobs)) != NULL) {
+        pho_tlc_resp_t resp;
+
+        tlc_build_response_error(&resp, job->req->id, -ESHUTDOWN, NULL);
+        tlc_response_send(tlc, &resp, tlc_job_client_socket(tlc, job));
+        pho_srl_tlc_response_free(&resp, false);
+        tlc_job_free(job);
+    }
+
+    rc = pho_comm_close(&tlc->worker);
+    if (rc)
+        pho_error(rc, "Error on closing the TLC socket worker");
+
+    rc = pho_comm_close(&tlc->comm);
+    if (rc)
+        pho_error(rc, "Error on closing the TLC socket");
+
+    tlc_library_close(&tlc->lib);
+
+    g_hash_table_destroy(tlc->clients);
+    g_queue_free(tlc->done);
+    g_queue_free(tlc->jobs);
+    pthread_cond_destroy(&tlc->cond);
+    pthread_mutex_destroy(&tlc->mutex);
 }
 
 static int recv_work(struct tlc *tlc)
@@ -505,7 +780,8 @@ static int recv_work(struct tlc *tlc)
     int n_data;
     int rc, i;
 
-    rc = pho_comm_recv(&tlc->comm, &data, &n_data);
+    /* also woken up by the movers when jobs are processed */
+    rc = pho_comm_recv(&tlc->worker, &data, &n_data);
     if (rc) {
         for (i = 0; i < n_data; ++i)
             free(data[i].buf.buff);
@@ -517,8 +793,10 @@ static int recv_work(struct tlc *tlc)
     for (i = 0; i < n_data; i++) {
         pho_tlc_req_t *req;
 
-        if (data[i].buf.size == -1) /* close notification, ignore */
+        if (data[i].buf.size == -1) { /* close notification */
+            tlc_client_closed(tlc, data[i].fd);
             continue;
+        }
 
         req = pho_srl_tlc_request_unpack(&data[i].buf);
         if (!req)
@@ -534,24 +812,16 @@ static int recv_work(struct tlc *tlc)
             goto out_request;
         }
 
-        if (pho_tlc_request_is_load(req)) {
-            process_load_request(tlc, req, data[i].fd);
-            goto out_request;
-        }
-
-        if (pho_tlc_request_is_unload(req)) {
-            process_unload_request(tlc, req, data[i].fd);
-            goto out_request;
-        }
-
-        if (pho_tlc_request_is_status(req)) {
+        if (pho_tlc_request_is_status(req) && !req->status->refresh) {
             process_status_request(tlc, req, data[i].fd);
             goto out_request;
         }
 
-        if (pho_tlc_request_is_refresh(req)) {
-            process_refresh_request(tlc, req, data[i].fd);
-            goto out_request;
+        /* the moves and the refreshes are processed by the movers */
+        if (pho_tlc_request_is_load(req) || pho_tlc_request_is_unload(req) ||
+            pho_tlc_request_is_status(req) || pho_tlc_request_is_refresh(req)) {
+            tlc_job_queue(tlc, req, data[i].fd);
+            continue;
         }
 
 out_request:
@@ -560,6 +830,8 @@ out_request:
 
     free(data);
 
+    tlc_answer_done_jobs(tlc);
+
     return rc;
 }
 
@@ -599,5 +871,5 @@ int main(int argc, char **argv)
     }
 
     tlc_fini(&tlc);
-    return EXIT_SUCCESS;
+    return tlc.refresh_failed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
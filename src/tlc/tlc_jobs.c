@@ -0,0 +1,116 @@
+/* -*- mode: c; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief  TLC jobs -- moves and refreshes queued for the mover threads
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include "tlc_jobs.h"
+
+bool tlc_job_is_refresh(const struct tlc_job *job)
+{
+    return pho_tlc_request_is_refresh(job->req) ||
+           pho_tlc_request_is_status(job->req);
+}
+
+void tlc_job_free(struct tlc_job *job)
+{
+    if (job->json_message)
+        json_decref(job->json_message);
+
+    free(job->unloaded_tape_label);
+    pho_srl_tlc_request_free(job->req, true);
+    free(job);
+}
+
+/**
+ * Reserve the move of a load or unload job.
+ *
+ * @return -EBUSY if the job has to wait for the end of a move in progress,
+ *         0 otherwise: the job is then ready, with its move to perform or its
+ *         result.
+ */
+static int tlc_job_prepare(struct lib_descriptor *lib, struct tlc_job *job)
+{
+    int rc;
+
+    if (pho_tlc_request_is_load(job->req)) {
+        rc = tlc_library_load_prepare(lib, job->req->load->drive_serial,
+                                      job->req->load->tape_label, &job->move,
+                                      &job->json_message);
+        job->moving = !rc;
+    } else {
+        rc = tlc_library_unload_prepare(lib, job->req->unload->drive_serial,
+                                        job->req->unload->tape_label,
+                                        &job->move, &job->unloaded_tape_label,
+                                        &job->unload_addr, &job->json_message);
+        job->moving = !rc && job->unloaded_tape_label;
+    }
+
+    if (rc == -EBUSY)
+        return rc;
+
+    job->rc = rc;
+    return 0;
+}
+
+struct tlc_job *tlc_next_job(struct lib_descriptor *lib, GQueue *jobs,
+                             int n_moving, GList **refreshes)
+{
+    GList *item = jobs->head;
+
+    *refreshes = NULL;
+
+    while (item) {
+        struct tlc_job *job = item->data;
+        GList *next = item->next;
+
+        if (tlc_job_is_refresh(job)) {
+            if (n_moving > 0)
+                return NULL;
+
+            while (item && tlc_job_is_refresh(item->data)) {
+                next = item->next;
+                *refreshes = g_list_prepend(*refreshes, item->data);
+                g_queue_delete_link(jobs, item);
+                item = next;
+            }
+
+            *refreshes = g_list_reverse(*refreshes);
+            return NULL;
+        }
+
+        if (!tlc_job_prepare(lib, job)) {
+            g_queue_delete_link(jobs, item);
+            return job;
+        }
+
+        item = next;
+    }
+
+    return NULL;
+}
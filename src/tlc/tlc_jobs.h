@@ -0,0 +1,88 @@
+/* -*- mode: c; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief  TLC jobs -- moves and refreshes queued for the mover threads
+ */
+
+#ifndef _PHO_TLC_JOBS_H
+#define _PHO_TLC_JOBS_H
+
+#include <glib.h>
+#include <jansson.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "pho_srl_tlc.h"
+#include "tlc_library.h"
+
+/**
+ * Request of a robot move or of a library refresh, queued until a mover
+ * thread can process it
+ */
+struct tlc_job {
+    pho_tlc_req_t *req;         /*!< Load, unload, refresh or status with
+                                  *  refresh request
+                                  */
+    int client_socket;          /*!< Socket of the client to answer */
+    size_t client_gen;          /*!< Generation of the client connection on
+                                  *  client_socket, the response is dropped
+                                  *  if the socket now belongs to another
+                                  *  connection
+                                  */
+    struct tlc_move move;       /*!< Move reserved in the library */
+    bool moving;                /*!< Whether move has to be performed */
+    int rc;                     /*!< Result of the request */
+    json_t *json_message;       /*!< Message of the result, may be NULL */
+    char *unloaded_tape_label;  /*!< Unload result */
+    struct lib_item_addr unload_addr; /*!< Unload result */
+};
+
+/** Whether \p job refreshes the library: a refresh or a status with refresh */
+bool tlc_job_is_refresh(const struct tlc_job *job);
+
+/** Free \p job and its unpacked request */
+void tlc_job_free(struct tlc_job *job);
+
+/**
+ * Get the next job of \p jobs that can be processed.
+ *
+ * The jobs are considered in their arrival order. A move whose elements are
+ * involved in a move in progress stays queued, and the jobs behind it can
+ * proceed. A refresh waits for the end of the moves in progress and holds
+ * back the jobs queued behind it; the refreshes queued next to each other are
+ * then coalesced.
+ *
+ * The returned job and the refresh jobs are removed from \p jobs.
+ *
+ * @param[in]       lib         Library whose moves are reserved.
+ * @param[in, out]  jobs        Pending struct tlc_job, in arrival order.
+ * @param[in]       n_moving    Number of moves in progress.
+ * @param[out]      refreshes   List of refresh jobs to process together, or
+ *                              NULL.
+ *
+ * @return the move job to process, with its move reserved if it has to be
+ *         performed, or NULL.
+ */
+struct tlc_job *tlc_next_job(struct lib_descriptor *lib, GQueue *jobs,
+                             int n_moving, GList **refreshes);
+
+#endif /* _PHO_TLC_JOBS_H */
@@ -105,6 +105,110 @@ static void lib_status_clear(struct lib_descriptor *lib)
     memset(&lib->drives, 0, sizeof(lib->drives));
 }
 
+/**
+ * Convert a scsi element type code to a human readable string
+ * @param [in] code  element type code
+ *
+ * @return the converted result as a string
+ */
+static const char *type2str(enum element_type_code code)
+{
+    switch (code) {
+    case SCSI_TYPE_ARM:    return "arm";
+    case SCSI_TYPE_SLOT:   return "slot";
+    case SCSI_TYPE_IMPEXP: return "import/export";
+    case SCSI_TYPE_DRIVE:  return "drive";
+    default:               return "(unknown)";
+    }
+}
+
+/**
+ * Serial number of a drive element.
+ *
+ * Some librairies only return the SN as drive id, whereas some return a full
+ * description like: "VENDOR   MODEL   SERIAL". The serial is the last part.
+ */
+static const char *drive_serial(const struct element_status *drive)
+{
+    const char *sn;
+
+    sn = strrchr(drive->dev_id, ' ');
+    if (!sn) /* only contains the SN */
+        return drive->dev_id;
+
+    /* first char after last space */
+    return sn + 1;
+}
+
+static gint addr_cmp(gconstpointer a, gconstpointer b)
+{
+    return GPOINTER_TO_UINT(a) < GPOINTER_TO_UINT(b) ? -1 :
+           GPOINTER_TO_UINT(a) > GPOINTER_TO_UINT(b);
+}
+
+/** clear the indexes of the library elements status */
+static void lib_index_clear(struct lib_descriptor *lib)
+{
+    if (lib->by_label)
+        g_hash_table_destroy(lib->by_label);
+    if (lib->by_serial)
+        g_hash_table_destroy(lib->by_serial);
+    if (lib->free_slots)
+        g_tree_destroy(lib->free_slots);
+
+    lib->by_label = NULL;
+    lib->by_serial = NULL;
+    lib->free_slots = NULL;
+}
+
+static void index_label(struct lib_descriptor *lib,
+                        struct element_status *element)
+{
+    /* on duplicate labels, keep the first element found */
+    if (element->full && element->vol[0] &&
+        !g_hash_table_contains(lib->by_label, element->vol))
+        g_hash_table_insert(lib->by_label, element->vol, element);
+}
+
+/**
+ * Build the indexes of the library elements status. The elements are indexed
+ * in the order of the former linear lookups: slots, drives, arms and
+ * import/export slots.
+ */
+static void lib_index_build(struct lib_descriptor *lib)
+{
+    int i;
+
+    lib_index_clear(lib);
+    lib->by_label = g_hash_table_new(g_str_hash, g_str_equal);
+    lib->by_serial = g_hash_table_new(g_str_hash, g_str_equal);
+    lib->free_slots = g_tree_new(addr_cmp);
+
+    for (i = 0; i < lib->slots.count; i++) {
+        struct element_status *slot = &lib->slots.items[i];
+
+        index_label(lib, slot);
+        if (!slot->full)
+            g_tree_insert(lib->free_slots, GUINT_TO_POINTER(slot->address),
+                          slot);
+    }
+
+    for (i = 0; i < lib->drives.count; i++) {
+        struct element_status *drive = &lib->drives.items[i];
+        const char *serial = drive_serial(drive);
+
+        index_label(lib, drive);
+        if (serial[0] && !g_hash_table_contains(lib->by_serial, serial))
+            g_hash_table_insert(lib->by_serial, (gpointer)serial, drive);
+    }
+
+    for (i = 0; i < lib->arms.count; i++)
+        index_label(lib, &lib->arms.items[i]);
+
+    for (i = 0; i < lib->impexp.count; i++)
+        index_label(lib, &lib->impexp.items[i]);
+}
+
 /** Retrieve drive serial numbers in a separate ELEMENT_STATUS request. */
 static int query_drive_sn(struct lib_descriptor *lib, json_t *message)
 {
@@ -311,6 +415,9 @@ int tlc_library_open(struct lib_descriptor *lib, const char *dev,
     int rc;
 
     *json_message = NULL;
+    if (!lib->moving)
+        lib->moving = g_hash_table_new(g_direct_hash, g_direct_equal);
+
     lib->fd = open(dev, O_RDWR | O_NONBLOCK);
     if (lib->fd < 0) {
         *json_message = json_pack("{s:s}", "LIB_OPEN_FAILURE", dev);
@@ -321,13 +428,20 @@ int tlc_library_open(struct lib_descriptor *lib, const char *dev,
     if (rc)
         pho_error(rc, "Failed to load library status");
 
+    lib_index_build(lib);
+
     return rc;
 }
 
 void tlc_library_close(struct lib_descriptor *lib)
 {
+    lib_index_clear(lib);
     lib_status_clear(lib);
     lib_addrs_clear(lib);
+    if (lib->moving) {
+        g_hash_table_destroy(lib->moving);
+        lib->moving = NULL;
+    }
     if (lib->fd >= 0) {
         close(lib->fd);
         lib->fd = 0;
@@ -342,43 +456,16 @@ int tlc_library_refresh(struct lib_descriptor *lib, const char *dev,
     return tlc_library_open(lib, dev, json_message);
 }
 
-/**
- * Match a drive serial number vs. the requested S/N.
- * @return true if serial matches, else false.
- */
-static inline bool match_serial(const char *drv_descr, const char *req_sn)
-{
-    const char *sn;
-
-    /* Matching depends on library type:
-     * some librairies only return the SN as drive id,
-     * whereas some return a full description like:
-     * "VENDOR   MODEL   SERIAL".
-     * To match both, we match the last part of the serial.
-     */
-    sn = strrchr(drv_descr, ' ');
-    if (!sn) /* only contains the SN */
-        sn = drv_descr;
-    else /* first char after last space */
-        sn++;
-
-    /* return true on match */
-    return !strcmp(sn, req_sn);
-}
-
 struct element_status *drive_element_status_from_serial(
     struct lib_descriptor *lib, const char *serial)
 {
-    int i;
-
-    for (i = 0; i < lib->drives.count; i++) {
-        struct element_status *drv = &lib->drives.items[i];
+    struct element_status *drv;
 
-        if (match_serial(drv->dev_id, serial)) {
-            pho_debug("Found drive matching serial '%s': address=%#hx, id='%s'",
-                      serial, drv->address, drv->dev_id);
-            return drv;
-        }
+    drv = lib->by_serial ? g_hash_table_lookup(lib->by_serial, serial) : NULL;
+    if (drv) {
+        pho_debug("Found drive matching serial '%s': address=%#hx, id='%s'",
+                  serial, drv->address, drv->dev_id);
+        return drv;
     }
 
     pho_warn("No drive matching serial '%s'", serial);
@@ -390,50 +477,12 @@ struct element_status *media_element_status_from_label(
     struct lib_descriptor *lib, const char *label)
 {
     struct element_status *med;
-    int i;
-
-    /* search in slots */
-    for (i = 0; i < lib->slots.count; i++) {
-        med = &lib->slots.items[i];
 
-        if (med->full && !strcmp(med->vol, label)) {
-            pho_debug("Found volume matching label '%s' in slot %#hx", label,
-                      med->address);
-            return med;
-        }
-    }
-
-    /* search in drives */
-    for (i = 0; i < lib->drives.count; i++) {
-        med = &lib->drives.items[i];
-
-        if (med->full && !strcmp(med->vol, label)) {
-            pho_debug("Found volume matching label '%s' in drive %#hx", label,
-                      med->address);
-            return med;
-        }
-    }
-
-    /* search in arm */
-    for (i = 0; i < lib->arms.count; i++) {
-        med = &lib->arms.items[i];
-
-        if (med->full && !strcmp(med->vol, label)) {
-            pho_debug("Found volume matching label '%s' in arm %#hx", label,
-                      med->address);
-            return med;
-        }
-    }
-
-    /* search in imp/exp slots */
-    for (i = 0; i < lib->impexp.count; i++) {
-        med = &lib->impexp.items[i];
-
-        if (med->full && !strcmp(med->vol, label)) {
-            pho_debug("Found volume matching label '%s' in import/export slot"
-                      " %#hx", label, med->address);
-            return med;
-        }
+    med = lib->by_label ? g_hash_table_lookup(lib->by_label, label) : NULL;
+    if (med) {
+        pho_debug("Found volume matching label '%s' in %s %#hx", label,
+                  type2str(med->type), med->address);
+        return med;
     }
 
     pho_warn("No media matching label '%s'", label);
@@ -570,24 +619,8 @@ element_from_addr(const struct lib_descriptor *lib,
     return NULL;
 }
 
-/**
- * Convert a scsi element type code to a human readable string
- * @param [in] code  element type code
- *
- * @return the converted result as a string
- */
-static const char *type2str(enum element_type_code code)
-{
-    switch (code) {
-    case SCSI_TYPE_ARM:    return "arm";
-    case SCSI_TYPE_SLOT:   return "slot";
-    case SCSI_TYPE_IMPEXP: return "import/export";
-    case SCSI_TYPE_DRIVE:  return "drive";
-    default:               return "(unknown)";
-    }
-}
-
-static void move_tape_between_element_status(struct element_status *source,
+static void move_tape_between_element_status(struct lib_descriptor *lib,
+                                             struct element_status *source,
                                              struct element_status *destination)
 {
     source->full = false;
@@ -596,6 +629,17 @@ static void move_tape_between_element_status(struct element_status *source,
     destination->src_addr_is_set = true;
     destination->src_addr = source->address;
     memcpy(destination->vol, source->vol, VOL_ID_LEN);
+
+    /* update the indexes */
+    if (g_hash_table_lookup(lib->by_label, source->vol) == source)
+        g_hash_table_replace(lib->by_label, destination->vol, destination);
+
+    if (source->type == SCSI_TYPE_SLOT)
+        g_tree_insert(lib->free_slots, GUINT_TO_POINTER(source->address),
+                      source);
+
+    if (destination->type == SCSI_TYPE_SLOT)
+        g_tree_remove(lib->free_slots, GUINT_TO_POINTER(destination->address));
 }
 
 static void tlc_log_init(const char *drive_serial, const char *tape_label,
@@ -615,16 +659,28 @@ static void tlc_log_init(const char *drive_serial, const char *tape_label,
     log->message = json_object();
 }
 
-int tlc_library_load(struct dss_handle *dss, struct lib_descriptor *lib,
-                     const char *drive_serial, const char *tape_label,
-                     json_t **json_message)
+static bool element_is_moving(const struct lib_descriptor *lib,
+                              const struct element_status *element)
+{
+    return g_hash_table_contains(lib->moving,
+                                 GUINT_TO_POINTER(element->address));
+}
+
+static void move_reserve(struct lib_descriptor *lib, struct tlc_move *move)
+{
+    g_hash_table_add(lib->moving, GUINT_TO_POINTER(move->source->address));
+    g_hash_table_add(lib->moving, GUINT_TO_POINTER(move->target->address));
+}
+
+int tlc_library_load_prepare(struct lib_descriptor *lib,
+                             const char *drive_serial, const char *tape_label,
+                             struct tlc_move *move, json_t **json_message)
 {
     struct element_status *source_element_status;
     struct element_status *drive_element_status;
-    struct pho_log log;
-    int rc;
 
     *json_message = NULL;
+    memset(move, 0, sizeof(*move));
 
     /* get device addr */
     drive_element_status = drive_element_status_from_serial(lib, drive_serial);
@@ -642,39 +698,107 @@ int tlc_library_load(struct dss_handle *dss, struct lib_descriptor *lib,
         return -ENOENT;
     }
 
+    if (element_is_moving(lib, drive_element_status) ||
+        element_is_moving(lib, source_element_status))
+        return -EBUSY;
+
+    move->type = PHO_DEVICE_LOAD;
+    move->drive_serial = xstrdup(drive_serial);
+    move->tape_label = xstrdup(tape_label);
+    move->source = source_element_status;
+    move->target = drive_element_status;
+    move_reserve(lib, move);
+
+    return 0;
+}
+
+int tlc_library_move(struct dss_handle *dss, struct lib_descriptor *lib,
+                     uint16_t arm_addr, const struct tlc_move *move)
+{
+    struct pho_log log;
+    int rc;
+
     /* prepare SCSI log */
-    tlc_log_init(drive_serial, tape_label, lib->name, PHO_DEVICE_LOAD, &log,
-                 json_message);
+    tlc_log_init(move->drive_serial, move->tape_label, lib->name, move->type,
+                 &log, NULL);
 
-    /* move medium to device */
-    /* arm = 0 for default transport element */
-    rc = scsi_move_medium(lib->fd, 0, source_element_status->address,
-                          drive_element_status->address, log.message);
-    emit_log_after_action(dss, &log, PHO_DEVICE_LOAD, rc);
+    rc = scsi_move_medium(lib->fd, arm_addr, move->source->address,
+                          move->target->address, log.message);
+    emit_log_after_action(dss, &log, move->type, rc);
     if (rc)
-        LOG_RETURN(rc, "SCSI move failed for load of tape '%s' in drive '%s'",
-                   tape_label, drive_serial);
+        LOG_RETURN(rc, "SCSI move failed for %s of tape '%s' in drive '%s' "
+                   "from address %#hx to address %#hx",
+                   move->type == PHO_DEVICE_LOAD ? "load" : "unload",
+                   move->tape_label, move->drive_serial,
+                   move->source->address, move->target->address);
 
-    /* update element status lib cache */
-    move_tape_between_element_status(source_element_status,
-                                     drive_element_status);
     return 0;
 }
 
-/** Search for a free slot in the library */
-static struct element_status *get_free_slot(struct lib_descriptor *lib)
+void tlc_library_move_end(struct lib_descriptor *lib, struct tlc_move *move,
+                          int rc)
 {
+    /* update element status lib cache */
+    if (!rc)
+        move_tape_between_element_status(lib, move->source, move->target);
+
+    g_hash_table_remove(lib->moving, GUINT_TO_POINTER(move->source->address));
+    g_hash_table_remove(lib->moving, GUINT_TO_POINTER(move->target->address));
+    free(move->drive_serial);
+    free(move->tape_label);
+    memset(move, 0, sizeof(*move));
+}
+
+int tlc_library_load(struct dss_handle *dss, struct lib_descriptor *lib,
+                     const char *drive_serial, const char *tape_label,
+                     json_t **json_message)
+{
+    struct tlc_move move;
+    int rc;
+
+    rc = tlc_library_load_prepare(lib, drive_serial, tape_label, &move,
+                                  json_message);
+    if (rc)
+        return rc;
+
+    /* arm = 0 for default transport element */
+    rc = tlc_library_move(dss, lib, 0, &move);
+    tlc_library_move_end(lib, &move, rc);
+
+    return rc;
+}
+
+struct free_slot_search {
+    const struct lib_descriptor *lib;
     struct element_status *slot;
-    int i;
+};
 
-    for (i = 0; i < lib->slots.count; i++) {
-        slot = &lib->slots.items[i];
+static gboolean find_unreserved_slot(gpointer key, gpointer value,
+                                     gpointer udata)
+{
+    struct free_slot_search *search = udata;
 
-        if (!slot->full)
-            return slot;
-    }
+    (void) key;
 
-    return NULL;
+    if (element_is_moving(search->lib, value))
+        return FALSE;
+
+    search->slot = value;
+    return TRUE;
+}
+
+/**
+ * Search for the free slot of lowest address in the library, which is not
+ * the target of a move
+ */
+static struct element_status *get_free_slot(struct lib_descriptor *lib)
+{
+    struct free_slot_search search = { .lib = lib, .slot = NULL };
+
+    /* only the free slots reserved by the moves in progress are skipped */
+    g_tree_foreach(lib->free_slots, find_unreserved_slot, &search);
+
+    return search.slot;
 }
 
 /**
@@ -697,7 +821,6 @@ get_target_free_slot_from_source_or_any(struct lib_descriptor *lib,
 {
     unload_addr->lia_type = MED_LOC_UNKNOWN;
     unload_addr->lia_addr = 0;
-    json_message = NULL;
 
     /* check drive source */
     if (drive->src_addr_is_set) {
@@ -717,7 +840,7 @@ get_target_free_slot_from_source_or_any(struct lib_descriptor *lib,
                       type2str(drive->type), drive->address,
                       type2str((*target)->type), type2str(SCSI_TYPE_SLOT));
             unload_addr->lia_addr = 0;
-        } else if (!(*target)->full) {
+        } else if (!(*target)->full && !element_is_moving(lib, *target)) {
             /*
              * We change unload_addr->lia_type from UNKNOWN to SLOT to set we
              * find a valid slot.
@@ -726,7 +849,8 @@ get_target_free_slot_from_source_or_any(struct lib_descriptor *lib,
             pho_debug("Using element source address '%#hx'.", drive->src_addr);
         } else {
             pho_verb("Source address '%#hx' of element %s at address '%#hx' "
-                     "is full. We will search a free address to move.",
+                     "is full or reserved by another move. We will search a "
+                     "free address to move.",
                      drive->src_addr, type2str(drive->type), drive->address);
             unload_addr->lia_addr = 0;
         }
@@ -735,6 +859,10 @@ get_target_free_slot_from_source_or_any(struct lib_descriptor *lib,
     if (unload_addr->lia_type != MED_LOC_SLOT) {
         *target = get_free_slot(lib);
         if (!*target) {
+            /* the slots reserved by the moves in progress may be freed */
+            if (g_hash_table_size(lib->moving) > 0)
+                return -EBUSY;
+
             *json_message = json_pack("{s:s}",
                                       "NO_FREE_SLOT",
                                       "Unable to find a free slot to unload");
@@ -748,20 +876,23 @@ get_target_free_slot_from_source_or_any(struct lib_descriptor *lib,
     return 0;
 }
 
-int tlc_library_unload(struct dss_handle *dss, struct lib_descriptor *lib,
-                       const char *drive_serial, const char *expected_tape,
-                       char **unloaded_tape_label,
-                       struct lib_item_addr *unload_addr, json_t **json_message)
+int tlc_library_unload_prepare(struct lib_descriptor *lib,
+                               const char *drive_serial,
+                               const char *expected_tape,
+                               struct tlc_move *move,
+                               char **unloaded_tape_label,
+                               struct lib_item_addr *unload_addr,
+                               json_t **json_message)
 {
     struct element_status *target_element_status = NULL;
     struct element_status *drive_element_status;
-    struct pho_log log;
     int rc;
 
     unload_addr->lia_type = MED_LOC_UNKNOWN;
     unload_addr->lia_addr = 0;
     *json_message = NULL;
     *unloaded_tape_label = NULL;
+    memset(move, 0, sizeof(*move));
 
     /* get device addr */
     drive_element_status = drive_element_status_from_serial(lib, drive_serial);
@@ -771,6 +902,10 @@ int tlc_library_unload(struct dss_handle *dss, struct lib_descriptor *lib,
         return -ENOENT;
     }
 
+    /* the drive content is only known once its current move is over */
+    if (element_is_moving(lib, drive_element_status))
+        return -EBUSY;
+
     /* check if device is empty */
     if (drive_element_status->full == false) {
         if (expected_tape == NULL) {
@@ -794,11 +929,6 @@ int tlc_library_unload(struct dss_handle *dss, struct lib_descriptor *lib,
         }
     }
 
-    *unloaded_tape_label = xmalloc(sizeof(drive_element_status->vol) + 1);
-    memcpy(*unloaded_tape_label, drive_element_status->vol,
-           sizeof(drive_element_status->vol));
-    (*unloaded_tape_label)[sizeof(drive_element_status->vol)] = 0;
-
     /* get target free slot from drive source or any */
     rc = get_target_free_slot_from_source_or_any(lib, drive_element_status,
                                                  &target_element_status,
@@ -806,29 +936,44 @@ int tlc_library_unload(struct dss_handle *dss, struct lib_descriptor *lib,
     if (rc)
         return rc;
 
-    /* prepare SCSI log */
-    tlc_log_init(drive_serial, *unloaded_tape_label, lib->name,
-                 PHO_DEVICE_UNLOAD, &log, json_message);
+    *unloaded_tape_label = xmalloc(sizeof(drive_element_status->vol) + 1);
+    memcpy(*unloaded_tape_label, drive_element_status->vol,
+           sizeof(drive_element_status->vol));
+    (*unloaded_tape_label)[sizeof(drive_element_status->vol)] = 0;
+
+    move->type = PHO_DEVICE_UNLOAD;
+    move->drive_serial = xstrdup(drive_serial);
+    move->tape_label = xstrdup(*unloaded_tape_label);
+    move->source = drive_element_status;
+    move->target = target_element_status;
+    move_reserve(lib, move);
+
+    return 0;
+}
+
+int tlc_library_unload(struct dss_handle *dss, struct lib_descriptor *lib,
+                       const char *drive_serial, const char *expected_tape,
+                       char **unloaded_tape_label,
+                       struct lib_item_addr *unload_addr, json_t **json_message)
+{
+    struct tlc_move move;
+    int rc;
+
+    rc = tlc_library_unload_prepare(lib, drive_serial, expected_tape, &move,
+                                    unloaded_tape_label, unload_addr,
+                                    json_message);
+    if (rc || !*unloaded_tape_label)
+        return rc;
 
-    /* move medium to device */
     /* arm = 0 for default transport element */
-    rc = scsi_move_medium(lib->fd, 0, drive_element_status->address,
-                          target_element_status->address, log.message);
-    emit_log_after_action(dss, &log, PHO_DEVICE_UNLOAD, rc);
+    rc = tlc_library_move(dss, lib, 0, &move);
+    tlc_library_move_end(lib, &move, rc);
     if (rc) {
         free(*unloaded_tape_label);
         *unloaded_tape_label = NULL;
-        LOG_RETURN(rc,
-                   "SCSI move failed for unload of tape '%s' in drive '%s' to "
-                   "address %#hx",
-                   drive_element_status->vol, drive_serial,
-                   target_element_status->address);
     }
 
-    /* update element status lib cache */
-    move_tape_between_element_status(drive_element_status,
-                                     target_element_status);
-    return 0;
+    return rc;
 }
 
 /**
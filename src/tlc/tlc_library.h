@@ -26,6 +26,8 @@
 #ifndef _PHO_TLC_LIBRARY_H
 #define _PHO_TLC_LIBRARY_H
 
+#include <glib.h>
+
 #include "pho_dss.h"
 #include "pho_ldm.h"
 #include "scsi_api.h"
@@ -54,6 +56,29 @@ struct lib_descriptor {
     struct status_array slots;
     struct status_array impexp;
     struct status_array drives;
+
+    /* Indexes of the element status cache, updated on moves */
+    GHashTable *by_label;       /* label -> full element holding the tape */
+    GHashTable *by_serial;      /* serial number -> drive element */
+    GTree *free_slots;          /* address -> empty slot element */
+
+    /* Addresses of the elements involved in a move in progress */
+    GHashTable *moving;
+};
+
+/**
+ * Robot move reserved by tlc_library_load_prepare or
+ * tlc_library_unload_prepare.
+ *
+ * The source and target elements are reserved until tlc_library_move_end:
+ * no other move can use them. The library must not be refreshed meanwhile.
+ */
+struct tlc_move {
+    enum operation_type type;       /**< PHO_DEVICE_LOAD or PHO_DEVICE_UNLOAD */
+    char *drive_serial;
+    char *tape_label;
+    struct element_status *source;
+    struct element_status *target;
 };
 
 /**
@@ -117,6 +142,89 @@ int tlc_library_load(struct dss_handle *dss, struct lib_descriptor *lib,
                      const char *drive_serial, const char *tape_label,
                      json_t **json_message);
 
+/**
+ * Check and reserve the elements of the load of a medium into a drive
+ *
+ * @param[in]   lib             Library descriptor.
+ * @param[in]   drive_serial    Serial number of the target drive.
+ * @param[in]   tape_label      Label of the target tape.
+ * @param[out]  move            Move to perform, to be ended by
+ *                              tlc_library_move_end on success.
+ * @param[out]  json_message    Set to NULL, if no message. On error, could be
+ *                              set to a value different from NULL, containing
+ *                              a message which describes the error and must be
+ *                              decref by the caller.
+ *
+ * @return 0 on success, -EBUSY if the drive or the tape is involved in a move
+ *         in progress, another negative error code on failure.
+ */
+int tlc_library_load_prepare(struct lib_descriptor *lib,
+                             const char *drive_serial, const char *tape_label,
+                             struct tlc_move *move, json_t **json_message);
+
+/**
+ * Check and reserve the elements of the unload of a drive to a free slot
+ *
+ * The target slot is chosen as in tlc_library_unload, among the slots which
+ * are not reserved by another move.
+ *
+ * @param[in]   lib                 Library descriptor.
+ * @param[in]   drive_serial        Serial number of the target drive.
+ * @param[in]   loaded_tape_label   If not NULL, drive is unloaded only if the
+ *                                  loaded tape has this label.
+ * @param[out]  move                Move to perform, to be ended by
+ *                                  tlc_library_move_end if
+ *                                  \p unloaded_tape_label is set.
+ * @param[out]  unloaded_tape_label Label of the unloaded tape, to be freed by
+ *                                  the caller, or NULL if the drive is empty
+ *                                  and there is nothing to move.
+ * @param[out]  unload_addr         Target address of the unload.
+ * @param[out]  json_message        Set to NULL, if no message. On error, could
+ *                                  be set to a value different from NULL,
+ *                                  containing a message which describes the
+ *                                  error and must be decref by the caller.
+ *
+ * @return 0 on success, -EBUSY if the drive is involved in a move in progress
+ *         or if every free slot is reserved, another negative error code on
+ *         failure.
+ */
+int tlc_library_unload_prepare(struct lib_descriptor *lib,
+                               const char *drive_serial,
+                               const char *loaded_tape_label,
+                               struct tlc_move *move,
+                               char **unloaded_tape_label,
+                               struct lib_item_addr *unload_addr,
+                               json_t **json_message);
+
+/**
+ * Perform a prepared move with the robot
+ *
+ * Only the SCSI device of the library is used: the element status cache is
+ * left untouched, so that this call can be made without holding the lock
+ * protecting \p lib, concurrently with other moves using other arms.
+ *
+ * @param[in]   dss         DSS handle used to log the move.
+ * @param[in]   lib         Library descriptor.
+ * @param[in]   arm_addr    Address of the transport element to use, 0 for the
+ *                          default one.
+ * @param[in]   move        Move to perform.
+ *
+ * @return 0 on success, negative error code on failure.
+ */
+int tlc_library_move(struct dss_handle *dss, struct lib_descriptor *lib,
+                     uint16_t arm_addr, const struct tlc_move *move);
+
+/**
+ * Update the element status cache with the result of a move, release its
+ * elements and clean it
+ *
+ * @param[in]   lib     Library descriptor.
+ * @param[in]   move    Ended move.
+ * @param[in]   rc      Result of tlc_library_move.
+ */
+void tlc_library_move_end(struct lib_descriptor *lib, struct tlc_move *move,
+                          int rc);
+
 /**
  * Unload a tape from a drive to a free slot
  *
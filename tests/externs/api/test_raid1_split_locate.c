@@ -322,8 +322,8 @@ static void rsl_loss(void **state)
     }
 
     /* locate with all media locked */
-    rc = layout_raid1_locate(rsl_state->dss, rsl_state->layout, my_hostname,
-                             &hostname, &nb_new_lock);
+    rc = layout_raid1_locate(rsl_state->dss, NULL, rsl_state->layout,
+                             my_hostname, &hostname, &nb_new_lock);
     assert_return_code(rc, -rc);
     assert_non_null(hostname);
     assert_string_equal(my_hostname, hostname);
@@ -335,8 +335,8 @@ static void rsl_loss(void **state)
     rc = dss_media_update(rsl_state->dss, rsl_state->media[0],
                           rsl_state->media[0], 1, ADM_STATUS);
     assert_return_code(rc, -rc);
-    rc = layout_raid1_locate(rsl_state->dss, rsl_state->layout, my_hostname,
-                             &hostname, &nb_new_lock);
+    rc = layout_raid1_locate(rsl_state->dss, NULL, rsl_state->layout,
+                             my_hostname, &hostname, &nb_new_lock);
     assert_return_code(rc, -rc);
     assert_non_null(hostname);
     assert_string_equal(my_hostname, hostname);
@@ -350,8 +350,8 @@ static void rsl_loss(void **state)
                           rsl_state->media[rsl_state->repl_count],
                           1, GET_ACCESS);
     assert_return_code(rc, -rc);
-    rc = layout_raid1_locate(rsl_state->dss, rsl_state->layout, my_hostname,
-                             &hostname, &nb_new_lock);
+    rc = layout_raid1_locate(rsl_state->dss, NULL, rsl_state->layout,
+                             my_hostname, &hostname, &nb_new_lock);
     assert_return_code(rc, -rc);
     assert_non_null(hostname);
     assert_string_equal(my_hostname, hostname);
@@ -364,8 +364,8 @@ static void rsl_loss(void **state)
                         true);
         assert_return_code(rc, -rc);
     }
-    rc = layout_raid1_locate(rsl_state->dss, rsl_state->layout, my_hostname,
-                             &hostname, &nb_new_lock);
+    rc = layout_raid1_locate(rsl_state->dss, NULL, rsl_state->layout,
+                             my_hostname, &hostname, &nb_new_lock);
     if (rsl_state->rsc_family == PHO_RSC_DIR) {
         assert_int_equal(rc, -ENODEV);
     } else {
@@ -393,7 +393,7 @@ static void rsl_no_lock(void **state)
     assert_non_null(my_hostname);
 
     /* focus_host set to NULL */
-    rc = layout_raid1_locate(rsl_state->dss, rsl_state->layout, NULL,
+    rc = layout_raid1_locate(rsl_state->dss, NULL, rsl_state->layout, NULL,
                              &hostname, &nb_new_lock);
     assert_return_code(rc, -rc);
     assert_non_null(hostname);
@@ -402,8 +402,8 @@ static void rsl_no_lock(void **state)
     free(hostname);
 
     /* focus_host set to my_hostname with already taken lock */
-    rc = layout_raid1_locate(rsl_state->dss, rsl_state->layout, my_hostname,
-                             &hostname, &nb_new_lock);
+    rc = layout_raid1_locate(rsl_state->dss, NULL, rsl_state->layout,
+                             my_hostname, &hostname, &nb_new_lock);
     assert_return_code(rc, -rc);
     assert_non_null(hostname);
     assert_string_equal(my_hostname, hostname);
@@ -415,8 +415,8 @@ static void rsl_no_lock(void **state)
     assert_return_code(rc, -rc);
 
     /* focus_host set to my_hostname with no preexisting locks */
-    rc = layout_raid1_locate(rsl_state->dss, rsl_state->layout, my_hostname,
-                             &hostname, &nb_new_lock);
+    rc = layout_raid1_locate(rsl_state->dss, NULL, rsl_state->layout,
+                             my_hostname, &hostname, &nb_new_lock);
     assert_return_code(rc, -rc);
     assert_non_null(hostname);
     assert_string_equal(my_hostname, hostname);
@@ -453,8 +453,8 @@ static void rsl_one_lock(void **state)
         assert_return_code(rc, -rc);
 
         /* check locate */
-        rc = layout_raid1_locate(rsl_state->dss, rsl_state->layout, my_hostname,
-                                 &hostname, &nb_new_lock);
+        rc = layout_raid1_locate(rsl_state->dss, NULL, rsl_state->layout,
+                                 my_hostname, &hostname, &nb_new_lock);
         assert_return_code(rc, -rc);
         assert_non_null(hostname);
         assert_string_equal(WIN_HOST, hostname);
@@ -483,8 +483,9 @@ static void rsl_one_lock(void **state)
                 assert_return_code(rc, -rc);
 
                 /* check WIN_HOST as focus_host */
-                rc = layout_raid1_locate(rsl_state->dss, rsl_state->layout,
-                                         WIN_HOST, &hostname, &nb_new_lock);
+                rc = layout_raid1_locate(rsl_state->dss, NULL,
+                                         rsl_state->layout, WIN_HOST, &hostname,
+                                         &nb_new_lock);
                 assert_return_code(rc, -rc);
                 assert_non_null(hostname);
                 assert_string_equal(WIN_HOST, hostname);
@@ -503,8 +504,9 @@ static void rsl_one_lock(void **state)
                 assert_return_code(rc, -rc);
 
                 /* check my_hostname as focus_host */
-                rc = layout_raid1_locate(rsl_state->dss, rsl_state->layout,
-                                         my_hostname, &hostname, &nb_new_lock);
+                rc = layout_raid1_locate(rsl_state->dss, NULL,
+                                         rsl_state->layout, my_hostname,
+                                         &hostname, &nb_new_lock);
                 assert_return_code(rc, -rc);
                 assert_non_null(hostname);
                 assert_string_equal(my_hostname, hostname);
@@ -527,11 +529,11 @@ static void rsl_one_lock(void **state)
 
         /* check locate */
         if (rsl_state->repl_count <= 1) {
-            rc = layout_raid1_locate(rsl_state->dss, rsl_state->layout,
+            rc = layout_raid1_locate(rsl_state->dss, NULL, rsl_state->layout,
                                      my_hostname, &hostname, &nb_new_lock);
             assert_int_equal(rc, -EAGAIN);
         } else {
-            rc = layout_raid1_locate(rsl_state->dss, rsl_state->layout,
+            rc = layout_raid1_locate(rsl_state->dss, NULL, rsl_state->layout,
                                      my_hostname, &hostname, &nb_new_lock);
             assert_return_code(rc, -rc);
             assert_non_null(hostname);
@@ -555,12 +557,12 @@ static void rsl_one_lock(void **state)
 
         /* check locate */
         if (rsl_state->repl_count <= 1) {
-            rc = layout_raid1_locate(rsl_state->dss, rsl_state->layout,
+            rc = layout_raid1_locate(rsl_state->dss, NULL, rsl_state->layout,
                                      my_hostname, &hostname, &nb_new_lock);
             assert_int_equal(rc, -EAGAIN);
         } else {
             assert_return_code(rc, -rc);
-            rc = layout_raid1_locate(rsl_state->dss, rsl_state->layout,
+            rc = layout_raid1_locate(rsl_state->dss, NULL, rsl_state->layout,
                                      my_hostname, &hostname, &nb_new_lock);
             assert_return_code(rc, -rc);
             assert_non_null(hostname);
@@ -615,12 +617,12 @@ static void rsl_one_lock_one_not_avail(void **state)
 
         if (rsl_state->repl_count <= 1) {
             /* check locate */
-            rc = layout_raid1_locate(rsl_state->dss, rsl_state->layout,
+            rc = layout_raid1_locate(rsl_state->dss, NULL, rsl_state->layout,
                                      my_hostname, &hostname, &nb_new_lock);
             assert_int_equal(rc, -EAGAIN);
         } else {
             /* check locate */
-            rc = layout_raid1_locate(rsl_state->dss, rsl_state->layout,
+            rc = layout_raid1_locate(rsl_state->dss, NULL, rsl_state->layout,
                                      my_hostname, &hostname, &nb_new_lock);
             assert_return_code(rc, -rc);
             assert_non_null(hostname);
@@ -652,7 +654,7 @@ static void rsl_one_lock_one_not_avail(void **state)
             }
 
             /* check locate */
-            rc = layout_raid1_locate(rsl_state->dss, rsl_state->layout,
+            rc = layout_raid1_locate(rsl_state->dss, NULL, rsl_state->layout,
                                      my_hostname, &hostname, &nb_new_lock);
             assert_return_code(rc, -rc);
             assert_non_null(hostname);
@@ -678,7 +680,7 @@ static void rsl_one_lock_one_not_avail(void **state)
              * Only WIN_HOST_BIS could access to second split.
              * Check this dead lock returns -EAGAIN.
              */
-            rc = layout_raid1_locate(rsl_state->dss, rsl_state->layout,
+            rc = layout_raid1_locate(rsl_state->dss, NULL, rsl_state->layout,
                                      my_hostname, &hostname, &nb_new_lock);
             assert_int_equal(rc, -EAGAIN);
         }
@@ -0,0 +1,177 @@
+/* -*- mode: c; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief  Test several xfers of one store call, whose data is moved by the
+ *         I/O workers of the store
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "pho_test_utils.h"
+#include "pho_test_xfer_utils.h"
+#include "phobos_store.h"
+#include "pho_common.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* more xfers than the default number of I/O workers */
+#define N_XFERS 8
+
+static void xfers_init(struct pho_xfer_desc *xfers,
+                       struct pho_xfer_target *targets)
+{
+    int i;
+
+    memset(xfers, 0, (N_XFERS + 1) * sizeof(*xfers));
+    memset(targets, 0, (N_XFERS + 1) * sizeof(*targets));
+
+    for (i = 0; i <= N_XFERS; i++)
+        xfers[i].xd_targets = &targets[i];
+}
+
+/* Open \p path for the xfer of the object \p prefix_<idx> */
+static void xfer_open(struct pho_xfer_desc *xfer, const char *path,
+                      enum pho_xfer_op op, const char *prefix, int idx)
+{
+    assert(xfer_desc_open_path(xfer, path, op, 0) >= 0);
+    assert(asprintf(&xfer->xd_targets->xt_objid, "%s_%d", prefix, idx) > 0);
+    if (op == PHO_XFER_OP_PUT)
+        xfer->xd_params.put.family = PHO_RSC_INVAL;
+}
+
+static void xfers_fini(struct pho_xfer_desc *xfers)
+{
+    int i;
+
+    for (i = 0; i <= N_XFERS; i++) {
+        xfer_close_fd(xfers[i].xd_targets);
+        free(xfers[i].xd_targets->xt_objid);
+        free(xfers[i].xd_targets->xt_objuuid);
+    }
+}
+
+/* Only the last xfer, whose descriptor is unusable, fails */
+static void check_xfers(struct pho_xfer_desc *xfers, int rc, const char *op)
+{
+    int i;
+
+    if (!rc) {
+        fprintf(stderr, "%s of an unusable descriptor succeeded\n", op);
+        exit(EXIT_FAILURE);
+    }
+
+    for (i = 0; i < N_XFERS; i++) {
+        if (xfers[i].xd_rc) {
+            pho_error(xfers[i].xd_rc, "%s of '%s' failed", op,
+                      xfers[i].xd_targets->xt_objid);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (!xfers[N_XFERS].xd_rc) {
+        fprintf(stderr, "%s of an unusable descriptor succeeded\n", op);
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void check_same_content(const char *expected, const char *path)
+{
+    char buf_expected[4096];
+    char buf[4096];
+    FILE *file_expected;
+    FILE *file;
+    size_t len;
+
+    file_expected = fopen(expected, "r");
+    assert(file_expected);
+    file = fopen(path, "r");
+    assert(file);
+
+    do {
+        len = fread(buf_expected, 1, sizeof(buf_expected), file_expected);
+        if (fread(buf, 1, sizeof(buf), file) != len ||
+            memcmp(buf, buf_expected, len)) {
+            fprintf(stderr, "'%s' differs from '%s'\n", path, expected);
+            exit(EXIT_FAILURE);
+        }
+    } while (len > 0);
+
+    fclose(file);
+    fclose(file_expected);
+}
+
+int main(int argc, char **argv)
+{
+    struct pho_xfer_target targets[N_XFERS + 1];
+    struct pho_xfer_desc xfers[N_XFERS + 1];
+    char path[PATH_MAX];
+    int rc;
+    int i;
+
+    if (argc != 4) {
+        fprintf(stderr, "usage: %s <file> <out_dir> <oid_prefix>\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    test_env_initialize();
+
+    /* put the file N_XFERS times, and once from a write-only descriptor */
+    xfers_init(xfers, targets);
+    for (i = 0; i <= N_XFERS; i++)
+        xfer_open(&xfers[i], argv[1], PHO_XFER_OP_PUT, argv[3], i);
+
+    close(targets[N_XFERS].xt_fd);
+    targets[N_XFERS].xt_fd = open("/dev/null", O_WRONLY);
+    assert(targets[N_XFERS].xt_fd >= 0);
+
+    rc = phobos_put(xfers, N_XFERS + 1, NULL, NULL);
+    check_xfers(xfers, rc, "PUT");
+    xfers_fini(xfers);
+
+    /* get them back, and the first one to a read-only descriptor */
+    xfers_init(xfers, targets);
+    for (i = 0; i <= N_XFERS; i++) {
+        snprintf(path, sizeof(path), "%s/%d", argv[2], i);
+        xfer_open(&xfers[i], path, PHO_XFER_OP_GET, argv[3], i % N_XFERS);
+    }
+
+    close(targets[N_XFERS].xt_fd);
+    targets[N_XFERS].xt_fd = open("/dev/null", O_RDONLY);
+    assert(targets[N_XFERS].xt_fd >= 0);
+
+    rc = phobos_get(xfers, N_XFERS + 1, NULL, NULL);
+    check_xfers(xfers, rc, "GET");
+    xfers_fini(xfers);
+
+    for (i = 0; i < N_XFERS; i++) {
+        snprintf(path, sizeof(path), "%s/%d", argv[2], i);
+        check_same_content(argv[1], path);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -173,12 +173,39 @@ function raid4_extent_offset()
     echo $total
 }
 
+function raid_ec_extent_offset()
+{
+    local n1=$1[@]
+    local media=(${!n1})
+    local n2=$2[@]
+    local addresses=(${!n2})
+    local extent_index=$3
+    local n_data=$PHOBOS_LAYOUT_RAID_EC_data_extents
+    local n_total=$(nb_extent_per_split)
+    local total=0
+    local i
+    local j
+
+    for ((i = 0; i < $extent_index / $n_total; i++)); do
+        for ((j = 0; j < $n_data; j++)); do
+            local k=$((n_total * i + j))
+
+            ((total += $(stat -c %s "${media[k]}/${addresses[k]}")))
+        done
+    done
+
+    echo $total
+}
+
 function nb_extent_per_split()
 {
     if [[ "$RAID_LAYOUT" == "raid1" ]]; then
         echo $PHOBOS_LAYOUT_RAID1_repl_count
     elif [[ "$RAID_LAYOUT" == "raid4" ]]; then
         echo 3
+    elif [[ "$RAID_LAYOUT" == "raid_ec" ]]; then
+        echo $((PHOBOS_LAYOUT_RAID_EC_data_extents +
+                PHOBOS_LAYOUT_RAID_EC_parity_extents))
     else
         error "'$RAID_LAYOUT' not supported"
     fi
@@ -726,8 +753,9 @@ TESTS=(
      cleanup_dir_split"
 )
 
-if [[ "$RAID_LAYOUT" == "raid4" ]]; then
-    # These tests are written in a way that is specific to RAID4.
+if [[ "$RAID_LAYOUT" == "raid4" || "$RAID_LAYOUT" == "raid_ec" ]]; then
+    # These tests are written in a way that is specific to RAID4, raid_ec is
+    # run with 2 data extents and 1 parity extent so they also apply.
     TESTS+=(
         "setup_dir_split even; \
          test_put_get_split_corrupted; \
@@ -199,6 +199,72 @@ function test_md5_checksum
 
 test_md5_checksum
 
+################################################################################
+#                      MULTI-OBJECT PUT METADATA BATCHES                       #
+################################################################################
+
+function test_mput_md_batch
+{
+    local mput_file=$(mktemp /tmp/test.pho.XXXX)
+
+    echo "/etc/hosts mput_batch1 -
+/etc/hosts mput_batch2 -
+/etc/hosts mput_batch3 -" > $mput_file
+
+    # the layouts are saved by batches of two objects
+    PHOBOS_STORE_md_batch_size=2 $valg_phobos put --family dir \
+        --file $mput_file || error "Multi-object put should succeed"
+
+    for oid in mput_batch1 mput_batch2 mput_batch3; do
+        [[ $($phobos object list $oid) == "$oid" ]] ||
+            error "Object $oid should be complete"
+        [[ $($phobos extent list -o ext_count $oid) == "1" ]] ||
+            error "Object $oid should have one extent"
+    done
+
+    # a rejected layout fails the whole batch, the objects are then saved one
+    # by one and only the rejected one fails
+    $PSQL << EOF
+CREATE FUNCTION reject_layout() RETURNS trigger AS \$\$
+BEGIN
+    IF NEW.object_uuid IN (SELECT object_uuid FROM object
+                           WHERE oid = 'mput_fail2') THEN
+        RAISE EXCEPTION 'layout of mput_fail2 rejected';
+    END IF;
+    RETURN NEW;
+END;
+\$\$ LANGUAGE plpgsql;
+CREATE TRIGGER reject_layout BEFORE INSERT ON layout
+    FOR EACH ROW EXECUTE PROCEDURE reject_layout();
+EOF
+
+    echo "/etc/hosts mput_fail1 -
+/etc/hosts mput_fail2 -
+/etc/hosts mput_fail3 -" > $mput_file
+
+    PHOBOS_STORE_md_batch_size=256 $valg_phobos put --family dir \
+        --file $mput_file && error "Put of mput_fail2 should fail"
+
+    $PSQL << EOF
+DROP TRIGGER reject_layout ON layout;
+DROP FUNCTION reject_layout();
+EOF
+
+    rm $mput_file
+
+    for oid in mput_fail1 mput_fail3; do
+        [[ $($phobos object list $oid) == "$oid" ]] ||
+            error "Object $oid should be saved on its own"
+    done
+
+    [[ -z $($phobos object list mput_fail2) ]] ||
+        error "Object mput_fail2 should not exist"
+
+    return 0
+}
+
+test_mput_md_batch
+
 ################################################################################
 #                         TEST EMPTY PUT ON TAGGED DIR                         #
 ################################################################################
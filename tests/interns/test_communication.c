@@ -383,6 +383,139 @@ err_rc:
     return rc;
 }
 
+static int test_wait(void *arg)
+{
+    struct pho_comm_addr_type *addr_type = (struct pho_comm_addr_type *)arg;
+    struct pho_comm_data send_data_client;
+    struct pho_comm_data send_data_server;
+    struct pho_comm_data *data = NULL;
+    struct pho_comm_info ci_server;
+    struct pho_comm_info ci_client;
+    int rc = PHO_TEST_SUCCESS;
+    char ping[] = "ping";
+    char pong[] = "pong";
+    int nb_data;
+
+    assert(!pho_comm_open(&ci_server, &addr_type->addr,
+                          addr_type->server_type));
+    assert(!pho_comm_open(&ci_client, &addr_type->addr,
+                          addr_type->client_type));
+    assert(!pho_comm_recv(&ci_server, &data, &nb_data));
+    free(data);
+
+    /* nothing was sent yet, the client must time out */
+    rc = pho_comm_wait(&ci_client, 10);
+    if (rc != -ETIMEDOUT)
+        LOG_GOTO(out, rc = PHO_TEST_FAILURE,
+                 "client wait returned %d, expected %d", rc, -ETIMEDOUT);
+
+    send_data_client = pho_comm_data_init(&ci_client);
+    send_data_client.buf.buff = ping;
+    send_data_client.buf.size = strlen(send_data_client.buf.buff);
+    assert(!pho_comm_send(&send_data_client));
+
+    do {
+        assert(!pho_comm_recv(&ci_server, &data, &nb_data));
+        if (nb_data == 0)
+            free(data);
+    } while (nb_data == 0);
+
+    send_data_server.fd = data->fd;
+    send_data_server.buf.buff = pong;
+    send_data_server.buf.size = strlen(send_data_server.buf.buff);
+    free(data->buf.buff);
+    free(data);
+    assert(!pho_comm_send(&send_data_server));
+
+    /* the answer is available, the client must wake up */
+    rc = pho_comm_wait(&ci_client, -1);
+    if (rc)
+        LOG_GOTO(out, rc = PHO_TEST_FAILURE,
+                 "client wait failed with %d, expected 0", rc);
+
+    assert(!pho_comm_recv(&ci_client, &data, &nb_data));
+    if (nb_data != 1)
+        rc = PHO_TEST_FAILURE;
+    else
+        free(data->buf.buff);
+    free(data);
+
+out:
+    assert(!pho_comm_close(&ci_client));
+    assert(!pho_comm_close(&ci_server));
+    return rc;
+}
+
+static int test_workers(void *arg)
+{
+    struct pho_comm_addr_type *addr_type = (struct pho_comm_addr_type *)arg;
+    struct pho_comm_data send_data_client;
+    struct pho_comm_info ci_workers[2];
+    struct pho_comm_data *data = NULL;
+    struct pho_comm_info ci_server;
+    struct pho_comm_info ci_client;
+    int rc = PHO_TEST_SUCCESS;
+    char ping[] = "ping";
+    int received = -1;
+    int nb_data;
+    int i;
+
+    assert(!pho_comm_open(&ci_server, &addr_type->addr,
+                          addr_type->server_type));
+    for (i = 0; i < 2; ++i)
+        assert(!pho_comm_open_worker(ci_workers + i, &ci_server));
+
+    /* a wakeup interrupts the poll without any message */
+    assert(!pho_comm_wakeup(ci_workers));
+    assert(!pho_comm_recv(ci_workers, &data, &nb_data));
+    free(data);
+    if (nb_data)
+        LOG_GOTO(out_workers, rc = PHO_TEST_FAILURE,
+                 "worker recv returned %d messages after a wakeup", nb_data);
+
+    assert(!pho_comm_open(&ci_client, &addr_type->addr,
+                          addr_type->client_type));
+    send_data_client = pho_comm_data_init(&ci_client);
+    send_data_client.buf.buff = ping;
+    send_data_client.buf.size = strlen(send_data_client.buf.buff);
+    assert(!pho_comm_send(&send_data_client));
+
+    /* the client is accepted by one worker, which gets its messages */
+    while (received == -1) {
+        for (i = 0; i < 2; ++i) {
+            assert(!pho_comm_recv(ci_workers + i, &data, &nb_data));
+            if (nb_data == 1) {
+                if (received != -1 || data->buf.size != strlen(ping))
+                    rc = PHO_TEST_FAILURE;
+                received = i;
+                free(data->buf.buff);
+            } else if (nb_data) {
+                rc = PHO_TEST_FAILURE;
+            }
+            free(data);
+        }
+    }
+
+    if (rc)
+        LOG_GOTO(out_client, rc, "unexpected messages received by workers");
+
+    /* the other worker must not get the next message */
+    assert(!pho_comm_send(&send_data_client));
+    assert(!pho_comm_recv(ci_workers + 1 - received, &data, &nb_data));
+    free(data);
+    if (nb_data)
+        LOG_GOTO(out_client, rc = PHO_TEST_FAILURE,
+                 "message received by the worker of another client");
+
+out_client:
+    assert(!pho_comm_close(&ci_client));
+out_workers:
+    for (i = 0; i < 2; ++i)
+        assert(!pho_comm_close(ci_workers + i));
+    assert(!pho_comm_close(&ci_server));
+    return rc;
+}
+
 static int test_bad_hostname_port(void *arg)
 {
     struct pho_comm_info ci_client;
@@ -484,6 +617,10 @@ int main(int argc, char **argv)
                  &addr_type, PHO_TEST_SUCCESS);
     pho_run_test("Test: multiple sending/receiving AF_UNIX",
                  test_sendrecv_multiple, &addr_type, PHO_TEST_SUCCESS);
+    pho_run_test("Test: client wait AF_UNIX", test_wait, &addr_type,
+                 PHO_TEST_SUCCESS);
+    pho_run_test("Test: server workers AF_UNIX", test_workers, &addr_type,
+                 PHO_TEST_SUCCESS);
     addr_type.addr.tcp.hostname = "localhost";
     addr_type.addr.tcp.port = TCP_PORT_TEST;
     addr_type.server_type = PHO_COMM_TCP_SERVER;
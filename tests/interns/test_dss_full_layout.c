@@ -0,0 +1,161 @@
+/* -*- mode: c; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief  Tests for the decoding of the full layout rows
+ */
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmocka.h>
+#include <libpq-fe.h>
+
+#include "pho_common.h"
+#include "pho_type_utils.h"
+
+#include "full_layout.h"
+#include "resources.h"
+
+#define FL_N_COLUMNS 17
+
+#define LYT_INFO "{\"name\": \"raid1\", \"major\": 0, \"minor\": 2}"
+
+static const char *column_names[FL_N_COLUMNS] = {
+    "oid", "object_uuid", "version", "lyt_info", "extent_uuid",
+    "layout_index", "state", "size", "offsetof", "medium_family",
+    "medium_id", "medium_library", "address", "xxh128", "md5", "crc32c",
+    "info",
+};
+
+/* Add a row of the extent of index \p index of the layout \p uuid */
+static void add_row(PGresult *res, const char *oid, const char *uuid,
+                    const char *extent_uuid, const char *index)
+{
+    const char *values[FL_N_COLUMNS] = {
+        oid, uuid, "1", LYT_INFO, extent_uuid, index, "sync", "42", "0",
+        "dir", "/medium", "legacy", "address", NULL,
+        "d41d8cd98f00b204e9800998ecf8427e", NULL, "{\"key\": \"value\"}",
+    };
+    int row = PQntuples(res);
+    int i;
+
+    for (i = 0; i < FL_N_COLUMNS; i++)
+        assert_true(PQsetvalue(res, row, i, (char *)values[i],
+                               values[i] ? strlen(values[i]) : -1));
+}
+
+static PGresult *new_result(void)
+{
+    PGresAttDesc attrs[FL_N_COLUMNS] = { {0} };
+    PGresult *res;
+    int i;
+
+    res = PQmakeEmptyPGresult(NULL, PGRES_TUPLES_OK);
+    assert_non_null(res);
+
+    for (i = 0; i < FL_N_COLUMNS; i++) {
+        attrs[i].name = (char *)column_names[i];
+        attrs[i].format = 0;
+    }
+
+    assert_true(PQsetResultAttrs(res, FL_N_COLUMNS, attrs));
+
+    return res;
+}
+
+static void dfl_group(void **state)
+{
+    struct layout_info layouts[2];
+    PGresult *res;
+    int count = 0;
+    int rc;
+    int i;
+
+    (void) state;
+
+    res = new_result();
+    add_row(res, "oid1", "uuid1", "ext0", "0");
+    add_row(res, "oid1", "uuid1", "ext1", "1");
+    add_row(res, "oid1", "uuid1", "ext2", "2");
+    add_row(res, "oid2", "uuid2", "ext3", "0");
+
+    for (i = 0; i < PQntuples(res); i++) {
+        rc = full_layout_add_row(count ? &layouts[count - 1] : NULL,
+                                 &layouts[count], res, i);
+        assert_return_code(rc, -rc);
+        count += rc;
+    }
+    PQclear(res);
+
+    assert_int_equal(count, 2);
+
+    assert_string_equal(layouts[0].oid, "oid1");
+    assert_string_equal(layouts[0].layout_desc.mod_name, "raid1");
+    assert_int_equal(layouts[0].ext_count, 3);
+    for (i = 0; i < 3; i++)
+        assert_int_equal(layouts[0].extents[i].layout_idx, i);
+    assert_string_equal(layouts[0].extents[2].uuid, "ext2");
+    assert_string_equal(layouts[0].extents[2].media.name, "/medium");
+    assert_int_equal(layouts[0].extents[2].size, 42);
+    assert_true(layouts[0].extents[2].with_md5);
+    assert_false(layouts[0].extents[2].with_xxh128);
+    assert_string_equal(pho_attr_get(&layouts[0].extents[2].info, "key"),
+                        "value");
+
+    assert_string_equal(layouts[1].uuid, "uuid2");
+    assert_int_equal(layouts[1].ext_count, 1);
+    assert_string_equal(layouts[1].extents[0].uuid, "ext3");
+
+    for (i = 0; i < count; i++)
+        free_resource(DSS_FULL_LAYOUT, &layouts[i]);
+}
+
+static void dfl_missing_extent(void **state)
+{
+    struct layout_info layout;
+    PGresult *res;
+    int rc;
+
+    (void) state;
+
+    res = new_result();
+    add_row(res, "oid1", "uuid1", NULL, "0");
+
+    rc = full_layout_add_row(NULL, &layout, res, 0);
+    assert_int_equal(rc, -EINVAL);
+    PQclear(res);
+}
+
+int main(void)
+{
+    const struct CMUnitTest full_layout_tests[] = {
+        cmocka_unit_test(dfl_group),
+        cmocka_unit_test(dfl_missing_extent),
+    };
+
+    pho_context_init();
+    atexit(pho_context_fini);
+
+    return cmocka_run_group_tests(full_layout_tests, NULL, NULL);
+}
@@ -0,0 +1,210 @@
+/* -*- mode: c; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief  Tests for dss_layouts_save function
+ */
+
+#include "test_setup.h"
+#include "pho_dss.h"
+#include "pho_types.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#define N_OBJECTS 3
+#define N_EXTENTS 2
+
+struct saved_objects {
+    struct object_info objects[N_OBJECTS];
+    struct layout_info layouts[N_OBJECTS];
+    struct extent extents[N_OBJECTS][N_EXTENTS];
+    char oids[N_OBJECTS][32];
+    char uuids[N_OBJECTS][N_EXTENTS][37];
+    char addresses[N_OBJECTS][N_EXTENTS][64];
+};
+
+/* Insert incomplete objects named \p prefix_<i> and build their layouts */
+static void objects_init(struct dss_handle *handle, struct saved_objects *so,
+                         const char *prefix, int uuid_base)
+{
+    int rc;
+    int i;
+    int j;
+
+    memset(so, 0, sizeof(*so));
+
+    for (i = 0; i < N_OBJECTS; i++) {
+        snprintf(so->oids[i], sizeof(so->oids[i]), "%s_%d", prefix, i);
+        so->objects[i].oid = so->oids[i];
+        so->objects[i].user_md = "{}";
+        so->objects[i].obj_status = PHO_OBJ_STATUS_INCOMPLETE;
+
+        for (j = 0; j < N_EXTENTS; j++) {
+            struct extent *ext = &so->extents[i][j];
+
+            snprintf(so->uuids[i][j], sizeof(so->uuids[i][j]),
+                     "00000000-0000-0000-0000-%012d",
+                     uuid_base + i * N_EXTENTS + j);
+            snprintf(so->addresses[i][j], sizeof(so->addresses[i][j]),
+                     "%s/%d", so->oids[i], j);
+
+            ext->uuid = so->uuids[i][j];
+            ext->layout_idx = j;
+            ext->state = PHO_EXT_ST_SYNC;
+            ext->size = 42;
+            ext->media.family = PHO_RSC_DIR;
+            pho_id_name_set(&ext->media, "/mnt/medium", "legacy");
+            ext->address.buff = so->addresses[i][j];
+            ext->address.size = strlen(so->addresses[i][j]) + 1;
+        }
+
+        so->layouts[i].oid = so->oids[i];
+        so->layouts[i].version = 1;
+        so->layouts[i].layout_desc.mod_name = "raid1";
+        so->layouts[i].layout_desc.mod_major = 0;
+        so->layouts[i].layout_desc.mod_minor = 2;
+        so->layouts[i].extents = so->extents[i];
+        so->layouts[i].ext_count = N_EXTENTS;
+    }
+
+    rc = dss_object_insert(handle, so->objects, N_OBJECTS, DSS_SET_INSERT);
+    assert_return_code(rc, -rc);
+}
+
+static void check_object(struct dss_handle *handle, const char *oid,
+                         bool saved)
+{
+    struct object_info *obj;
+    struct layout_info *lyt;
+    struct dss_filter filter;
+    int obj_cnt;
+    int lyt_cnt;
+    int rc;
+
+    rc = dss_filter_build(&filter, "{\"DSS::OBJ::oid\": \"%s\"}", oid);
+    assert_return_code(rc, -rc);
+
+    rc = dss_object_get(handle, &filter, &obj, &obj_cnt, NULL);
+    assert_return_code(rc, -rc);
+    assert_int_equal(obj_cnt, 1);
+    assert_int_equal(obj->obj_status, saved ? PHO_OBJ_STATUS_COMPLETE :
+                                              PHO_OBJ_STATUS_INCOMPLETE);
+    dss_res_free(obj, obj_cnt);
+
+    rc = dss_full_layout_get(handle, &filter, NULL, &lyt, &lyt_cnt, NULL);
+    dss_filter_free(&filter);
+    assert_return_code(rc, -rc);
+
+    if (!saved) {
+        assert_int_equal(lyt_cnt, 0);
+        dss_res_free(lyt, lyt_cnt);
+        return;
+    }
+
+    assert_int_equal(lyt_cnt, 1);
+    assert_string_equal(lyt->layout_desc.mod_name, "raid1");
+    assert_int_equal(lyt->ext_count, N_EXTENTS);
+    assert_int_equal(lyt->extents[0].layout_idx, 0);
+    assert_int_equal(lyt->extents[1].layout_idx, 1);
+    assert_int_equal(lyt->extents[1].size, 42);
+    dss_res_free(lyt, lyt_cnt);
+}
+
+static void dls_save_ok(void **state)
+{
+    struct dss_handle *handle = (struct dss_handle *)*state;
+    struct saved_objects so;
+    int rc;
+    int i;
+
+    objects_init(handle, &so, "dls_save_ok", 0);
+
+    rc = dss_layouts_save(handle, so.layouts, N_OBJECTS);
+    assert_return_code(rc, -rc);
+
+    for (i = 0; i < N_OBJECTS; i++)
+        check_object(handle, so.oids[i], true);
+}
+
+static void dls_save_all_or_nothing(void **state)
+{
+    struct dss_handle *handle = (struct dss_handle *)*state;
+    struct saved_objects so;
+    int rc;
+    int i;
+
+    objects_init(handle, &so, "dls_save_fail", 100);
+
+    /* the last extent reuses the uuid of the first one */
+    so.extents[N_OBJECTS - 1][N_EXTENTS - 1].uuid = so.uuids[0][0];
+
+    rc = dss_layouts_save(handle, so.layouts, N_OBJECTS);
+    assert_int_equal(rc, -EEXIST);
+
+    for (i = 0; i < N_OBJECTS; i++)
+        check_object(handle, so.oids[i], false);
+
+    /* the objects can then be saved on their own */
+    so.extents[N_OBJECTS - 1][N_EXTENTS - 1].uuid =
+        so.uuids[N_OBJECTS - 1][N_EXTENTS - 1];
+
+    for (i = 0; i < N_OBJECTS; i++) {
+        rc = dss_layouts_save(handle, &so.layouts[i], 1);
+        assert_return_code(rc, -rc);
+        check_object(handle, so.oids[i], true);
+    }
+}
+
+static void dls_save_invalid(void **state)
+{
+    struct dss_handle *handle = (struct dss_handle *)*state;
+    struct layout_info layout = { 0 };
+    int rc;
+
+    rc = dss_layouts_save(handle, NULL, 1);
+    assert_int_equal(rc, -EINVAL);
+
+    rc = dss_layouts_save(handle, &layout, 0);
+    assert_int_equal(rc, -EINVAL);
+}
+
+int main(void)
+{
+    const struct CMUnitTest dss_layouts_save_cases[] = {
+        cmocka_unit_test(dls_save_ok),
+        cmocka_unit_test(dls_save_all_or_nothing),
+        cmocka_unit_test(dls_save_invalid),
+    };
+
+    pho_context_init();
+    atexit(pho_context_fini);
+
+    return cmocka_run_group_tests(dss_layouts_save_cases,
+                                  global_setup_dss_with_dbinit,
+                                  global_teardown_dss_with_dbdrop);
+}
@@ -168,6 +168,45 @@ static void dss_emit_logs_with_message_ok(void **state)
     dss_logs_delete(handle, NULL);
 }
 
+/* Logs emitted asynchronously are all written once flushed, in one batch */
+static void dss_async_emit_logs_ok(void **state)
+{
+    struct dss_handle *handle = (struct dss_handle *)*state;
+    struct dss_async *async;
+    struct pho_log *logs;
+    int n_errors = 0;
+    int n_logs;
+    int rc;
+    int i;
+
+    rc = dss_async_init(&async);
+    assert_return_code(rc, -rc);
+
+    for (i = 0; i < 10; i++) {
+        struct pho_log log;
+
+        init_pho_log(&log, &devices[0], &media[0], PHO_DEVICE_LOAD);
+        log.message = json_pack("{s:i}", "index", i);
+        assert_non_null(log.message);
+
+        dss_async_emit_log(async, &log, PHO_DEVICE_LOAD, i % 2 ? -EIO : 0);
+    }
+
+    dss_async_flush(async);
+
+    rc = dss_logs_get(handle, NULL, &logs, &n_logs);
+    assert_return_code(rc, -rc);
+    assert_int_equal(n_logs, 10);
+    for (i = 0; i < n_logs; i++)
+        if (logs[i].error_number)
+            n_errors++;
+    assert_int_equal(n_errors, 5);
+
+    dss_res_free(logs, n_logs);
+    dss_async_fini(async);
+    dss_logs_delete(handle, NULL);
+}
+
 static void check_logs_with_filter(struct dss_handle *handle,
                                    struct pho_id *device,
                                    struct pho_id *medium,
@@ -469,6 +508,7 @@ int main(void)
     const struct CMUnitTest dss_logs_test_cases[] = {
         cmocka_unit_test(dss_emit_logs_ok),
         cmocka_unit_test(dss_emit_logs_with_message_ok),
+        cmocka_unit_test(dss_async_emit_logs_ok),
         cmocka_unit_test(dss_logs_dump_with_filters),
         cmocka_unit_test(dss_logs_clear_with_filters),
         cmocka_unit_test(dss_medium_health_0),
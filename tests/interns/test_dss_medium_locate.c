@@ -20,7 +20,7 @@
  *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
  */
 /**
- * \brief  Tests for dss_medium_locate function
+ * \brief  Tests for dss_medium_locate and dss_media_locate functions
  */
 
 /* phobos stuff */
@@ -288,6 +288,94 @@ static void dml_ok_lock(void **state)
     media_info_free(medium);
 }
 
+/**
+ * dss_media_locate gives the same results as dss_medium_locate for each
+ * medium, the media being inserted by the previous tests
+ */
+static void dml_bulk(void **state)
+{
+    struct dss_handle *dss = (struct dss_handle *)*state;
+    struct pho_id unexisting_medium = {
+        .family = PHO_RSC_TAPE,
+        .name = "unexisting_medium_name",
+        .library = "legacy",
+    };
+    struct dss_medium_location locations[] = {
+        { .id = unexisting_medium },
+        { .id = admin_locked_medium },
+        { .id = false_get_medium },
+        { .id = dir_free_medium },
+        { .id = tape_free_medium },
+        { .id = locked_medium },
+        { .id = locked_medium },
+    };
+    int expected_rc[] = { -ENOENT, -EACCES, -EPERM, -ENODEV, 0, 0, 0 };
+    int count = sizeof(locations) / sizeof(locations[0]);
+    int rc;
+    int i;
+
+    rc = dss_media_locate(dss, locations, count);
+    assert_return_code(rc, -rc);
+
+    for (i = 0; i < count; i++)
+        assert_int_equal(locations[i].rc, expected_rc[i]);
+
+    check_medium_info_correctly_filled(locations[4].medium, tape_free_medium);
+    assert_null(locations[4].hostname);
+
+    for (i = 5; i < count; i++) {
+        check_medium_info_correctly_filled(locations[i].medium, locked_medium);
+        assert_string_equal(locations[i].medium->lock.hostname, HOSTNAME);
+        assert_string_equal(locations[i].hostname, HOSTNAME);
+    }
+
+    for (i = 0; i < count; i++)
+        dss_medium_location_fini(&locations[i]);
+}
+
+/**
+ * the locate cache returns the located media and the hosts set afterwards
+ */
+static void dml_cache(void **state)
+{
+    struct dss_handle *dss = (struct dss_handle *)*state;
+    struct pho_id ids[] = { tape_free_medium, locked_medium };
+    struct dss_locate_cache cache;
+    struct media_info *medium;
+    char *hostname;
+    int rc;
+
+    dss_locate_cache_init(&cache);
+
+    rc = dss_locate_cache_load(dss, &cache, ids, 2);
+    assert_return_code(rc, -rc);
+
+    rc = dss_locate_cache_medium(dss, &cache, &locked_medium, &hostname,
+                                 &medium);
+    assert_return_code(rc, -rc);
+    assert_string_equal(hostname, HOSTNAME);
+    free(hostname);
+    media_info_free(medium);
+
+    /* a lock taken by a previous locate */
+    dss_locate_cache_set_host(&cache, &tape_free_medium, "other_host");
+    rc = dss_locate_cache_medium(dss, &cache, &tape_free_medium, &hostname,
+                                 &medium);
+    assert_return_code(rc, -rc);
+    assert_string_equal(hostname, "other_host");
+    free(hostname);
+    media_info_free(medium);
+
+    /* not loaded yet */
+    rc = dss_locate_cache_medium(dss, &cache, &admin_locked_medium, &hostname,
+                                 &medium);
+    assert_int_equal(rc, -EACCES);
+    assert_null(hostname);
+    assert_null(medium);
+
+    dss_locate_cache_fini(&cache);
+}
+
 int main(void)
 {
     const struct CMUnitTest dss_medium_locate_cases[] = {
@@ -296,6 +384,8 @@ int main(void)
         cmocka_unit_test_setup(dml_eperm, dml_eperm_setup),
         cmocka_unit_test_setup(dml_ok_free, dml_ok_free_setup),
         cmocka_unit_test_setup(dml_ok_lock, dml_ok_lock_setup),
+        cmocka_unit_test(dml_bulk),
+        cmocka_unit_test(dml_cache),
     };
 
     pho_context_init();
@@ -0,0 +1,270 @@
+/* -*- mode: c; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief  Tests for the DSS requests sent as prepared statements
+ */
+
+#include "test_setup.h"
+#include "pho_dss.h"
+#include "pho_types.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <libpq-fe.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+/* Ensure no transaction is left open on the connection of \p handle */
+static void assert_conn_idle(struct dss_handle *handle)
+{
+    assert_int_equal(PQtransactionStatus(handle->dh_conn), PQTRANS_IDLE);
+}
+
+static struct object_info *get_object(struct dss_handle *handle,
+                                      const char *oid, int *count)
+{
+    struct object_info *obj;
+    struct dss_filter filter;
+    int rc;
+
+    rc = dss_filter_build(&filter, "{\"DSS::OBJ::oid\": \"%s\"}", oid);
+    assert_return_code(rc, -rc);
+
+    rc = dss_object_get(handle, &filter, &obj, count, NULL);
+    dss_filter_free(&filter);
+    assert_return_code(rc, -rc);
+
+    return obj;
+}
+
+static void insert_object(struct dss_handle *handle, const char *oid,
+                          int expected_rc)
+{
+    struct object_info object = {
+        .oid = (char *)oid,
+        .user_md = "{\"key\": \"value\"}",
+        .obj_status = PHO_OBJ_STATUS_INCOMPLETE,
+    };
+    int rc;
+
+    rc = dss_object_insert(handle, &object, 1, DSS_SET_INSERT);
+    assert_int_equal(rc, expected_rc);
+    assert_conn_idle(handle);
+}
+
+static void dp_object_insert(void **state)
+{
+    struct dss_handle *handle = (struct dss_handle *)*state;
+    struct object_info *obj;
+    int count;
+
+    insert_object(handle, "dp_object", 0);
+
+    obj = get_object(handle, "dp_object", &count);
+    assert_int_equal(count, 1);
+    assert_string_equal(obj->user_md, "{\"key\": \"value\"}");
+    assert_int_equal(obj->obj_status, PHO_OBJ_STATUS_INCOMPLETE);
+    assert_int_equal(obj->version, 1);
+    dss_res_free(obj, count);
+}
+
+static void dp_object_insert_duplicate(void **state)
+{
+    struct dss_handle *handle = (struct dss_handle *)*state;
+    struct object_info *obj;
+    int count;
+
+    insert_object(handle, "dp_duplicate", 0);
+    insert_object(handle, "dp_duplicate", -EEXIST);
+
+    /* the failure leaves the connection and its statements usable */
+    insert_object(handle, "dp_after_duplicate", 0);
+
+    obj = get_object(handle, "dp_after_duplicate", &count);
+    assert_int_equal(count, 1);
+    dss_res_free(obj, count);
+}
+
+static void dp_object_batch_insert(void **state)
+{
+    struct dss_handle *handle = (struct dss_handle *)*state;
+    struct object_info objects[3] = {
+        { .oid = "dp_batch1", .user_md = "{}" },
+        { .oid = "dp_batch2", .user_md = "{}" },
+        { .oid = "dp_batch1", .user_md = "{}" },
+    };
+    struct object_info *obj;
+    int count;
+    int rc;
+
+    /* a batch is inserted as a whole or not at all */
+    rc = dss_object_insert(handle, objects, 3, DSS_SET_INSERT);
+    assert_int_equal(rc, -EEXIST);
+    assert_conn_idle(handle);
+
+    obj = get_object(handle, "dp_batch2", &count);
+    assert_int_equal(count, 0);
+    dss_res_free(obj, count);
+
+    objects[2].oid = "dp_batch3";
+    rc = dss_object_insert(handle, objects, 3, DSS_SET_INSERT);
+    assert_return_code(rc, -rc);
+    assert_conn_idle(handle);
+
+    obj = get_object(handle, "dp_batch3", &count);
+    assert_int_equal(count, 1);
+    dss_res_free(obj, count);
+}
+
+static void dp_layout_insert(void **state)
+{
+    struct dss_handle *handle = (struct dss_handle *)*state;
+    char *uuids[] = {
+        "00000000-0000-0000-0000-00000000dp00",
+        "00000000-0000-0000-0000-00000000dp01",
+    };
+    char *addresses[] = { "dp_layout/0", "dp_layout/1" };
+    struct layout_info layout = { 0 };
+    struct extent extents[2] = { 0 };
+    struct layout_info *lyt;
+    struct object_info *obj;
+    int count;
+    int rc;
+    int i;
+
+    insert_object(handle, "dp_layout", 0);
+
+    for (i = 0; i < 2; i++) {
+        extents[i].uuid = uuids[i];
+        extents[i].layout_idx = i;
+        extents[i].state = PHO_EXT_ST_SYNC;
+        extents[i].size = 1024 + i;
+        extents[i].media.family = PHO_RSC_DIR;
+        pho_id_name_set(&extents[i].media, "/mnt/dp", "legacy");
+        extents[i].address.buff = addresses[i];
+        extents[i].address.size = strlen(addresses[i]) + 1;
+
+        rc = dss_extent_insert(handle, &extents[i], 1);
+        assert_return_code(rc, -rc);
+        assert_conn_idle(handle);
+    }
+
+    layout.oid = "dp_layout";
+    layout.layout_desc.mod_name = "raid1";
+    layout.layout_desc.mod_major = 0;
+    layout.layout_desc.mod_minor = 2;
+    layout.extents = extents;
+    layout.ext_count = 2;
+
+    rc = dss_layout_insert(handle, &layout, 1);
+    assert_return_code(rc, -rc);
+    assert_conn_idle(handle);
+
+    obj = get_object(handle, "dp_layout", &count);
+    assert_int_equal(count, 1);
+
+    /* prepared select, run twice to use the already prepared statement */
+    for (i = 0; i < 2; i++) {
+        int lyt_cnt;
+
+        rc = dss_full_layout_get_from_uuid(handle, obj->uuid, obj->version,
+                                           &lyt, &lyt_cnt);
+        assert_return_code(rc, -rc);
+        assert_int_equal(lyt_cnt, 1);
+        assert_string_equal(lyt->oid, "dp_layout");
+        assert_string_equal(lyt->layout_desc.mod_name, "raid1");
+        assert_int_equal(lyt->ext_count, 2);
+        assert_string_equal(lyt->extents[0].uuid, uuids[0]);
+        assert_string_equal(lyt->extents[1].uuid, uuids[1]);
+        assert_int_equal(lyt->extents[1].size, 1025);
+        dss_res_free(lyt, lyt_cnt);
+    }
+    dss_res_free(obj, count);
+
+    /* an extent already inserted is rejected */
+    rc = dss_extent_insert(handle, &extents[0], 1);
+    assert_int_equal(rc, -EEXIST);
+    assert_conn_idle(handle);
+}
+
+static void dp_media_get_from_id(void **state)
+{
+    struct dss_handle *handle = (struct dss_handle *)*state;
+    struct media_info medium = { 0 };
+    struct media_info *media;
+    struct pho_id unknown;
+    int count;
+    int rc;
+    int i;
+
+    medium.rsc.id.family = PHO_RSC_DIR;
+    pho_id_name_set(&medium.rsc.id, "/mnt/dp_medium", "legacy");
+    medium.rsc.model = "dir";
+    medium.rsc.adm_status = PHO_RSC_ADM_ST_UNLOCKED;
+    medium.addr_type = PHO_ADDR_HASH1;
+    medium.fs.type = PHO_FS_POSIX;
+    medium.fs.status = PHO_FS_STATUS_EMPTY;
+    medium.flags.put = true;
+    medium.flags.get = true;
+    medium.flags.delete = true;
+
+    rc = dss_media_insert(handle, &medium, 1);
+    assert_return_code(rc, -rc);
+
+    for (i = 0; i < 2; i++) {
+        rc = dss_media_get_from_id(handle, &medium.rsc.id, &media, &count);
+        assert_return_code(rc, -rc);
+        assert_int_equal(count, 1);
+        assert_string_equal(media->rsc.id.name, "/mnt/dp_medium");
+        assert_string_equal(media->rsc.id.library, "legacy");
+        assert_int_equal(media->fs.status, PHO_FS_STATUS_EMPTY);
+        dss_res_free(media, count);
+    }
+
+    unknown.family = PHO_RSC_DIR;
+    pho_id_name_set(&unknown, "/mnt/dp_unknown", "legacy");
+    rc = dss_media_get_from_id(handle, &unknown, &media, &count);
+    assert_return_code(rc, -rc);
+    assert_int_equal(count, 0);
+    dss_res_free(media, count);
+}
+
+int main(void)
+{
+    const struct CMUnitTest dss_prepared_cases[] = {
+        cmocka_unit_test(dp_object_insert),
+        cmocka_unit_test(dp_object_insert_duplicate),
+        cmocka_unit_test(dp_object_batch_insert),
+        cmocka_unit_test(dp_layout_insert),
+        cmocka_unit_test(dp_media_get_from_id),
+    };
+
+    pho_context_init();
+    atexit(pho_context_fini);
+
+    return cmocka_run_group_tests(dss_prepared_cases,
+                                  global_setup_dss_with_dbinit,
+                                  global_teardown_dss_with_dbdrop);
+}
@@ -39,6 +39,10 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#ifdef URING_ENABLED
+#include <liburing.h>
+#endif
+
 #define TERA (1024LL * 1024LL * 1024LL * 1024LL)
 #define MAX_NULL_IO 10
 
@@ -304,6 +308,242 @@ clean_test_dir:
     return rc;
 }
 
+static int test_posix_write_from_fd(void *hint)
+{
+    char test_dir[] = "/tmp/test_posix_write_from_fdXXXXXX";
+    char *put_extent_address = "put_extent";
+    struct io_adapter_module *ioa = {0};
+    struct pho_io_descr iod = {0};
+    struct pho_ext_loc loc = {0};
+    unsigned char *ibuff = NULL;
+    struct extent ext = {0};
+    char *src_path = NULL;
+    char *fpath = NULL;
+    size_t count = 4096;
+    int src_fd = -1;
+    int rc;
+    int i;
+
+    if (mkdtemp(test_dir) == NULL)
+        LOG_RETURN(-errno, "Unable to create test dir");
+
+    if (asprintf(&fpath, "%s/%s", test_dir, put_extent_address) < 0 ||
+        asprintf(&src_path, "%s/source", test_dir) < 0)
+        LOG_GOTO(free_path, rc = -ENOMEM, "Unable to allocate tested paths");
+
+    /* the source holds the pattern three times */
+    ibuff = xmalloc(count);
+    for (i = 0; i < count; i++)
+        ibuff[i] = (unsigned char)i;
+
+    src_fd = open(src_path, O_CREAT | O_RDWR, 0600);
+    if (src_fd < 0)
+        LOG_GOTO(free_path, rc = -errno, "Unable to create source file");
+
+    for (i = 0; i < REPEAT_COUNT; i++) {
+        if (write(src_fd, ibuff, count) != count)
+            LOG_GOTO(clean_source, rc = -EIO, "Unable to fill source file");
+    }
+
+    if (lseek(src_fd, 0, SEEK_SET))
+        LOG_GOTO(clean_source, rc = -errno, "Unable to rewind source file");
+
+    rc = get_io_adapter(PHO_FS_POSIX, &ioa);
+    if (rc)
+        LOG_GOTO(clean_source, rc, "Unable to get posix ioa");
+
+    if (!ioa_can_write_from_fd(ioa))
+        LOG_GOTO(clean_source, rc = -EINVAL,
+                 "Posix ioa does not implement write_from_fd");
+
+    ext.address.buff = put_extent_address;
+    loc.extent = &ext;
+    loc.root_path = test_dir;
+    iod.iod_loc = &loc;
+
+    rc = ioa_open(ioa, NULL, &iod, true);
+    if (rc)
+        LOG_GOTO(clean_source, rc, "Error on opening extent");
+
+    /* copy all but the first pattern, in two calls */
+    rc = ioa_write_from_fd(ioa, &iod, src_fd, count, count);
+    if (!rc)
+        rc = ioa_write_from_fd(ioa, &iod, src_fd, 2 * count, count);
+    if (rc) {
+        ioa_close(ioa, &iod);
+        LOG_GOTO(clean_extent, rc, "Error on copying into extent");
+    }
+
+    rc = ioa_close(ioa, &iod);
+    if (rc)
+        LOG_GOTO(clean_extent, rc, "Fail to close iod");
+
+    /* the offset of the source is left untouched */
+    if (lseek(src_fd, 0, SEEK_CUR) != 0)
+        LOG_GOTO(clean_extent, rc = -EINVAL, "Source offset was modified");
+
+    rc = check_file_content(fpath, ibuff, count, REPEAT_COUNT - 1);
+
+clean_extent:
+    if (unlink(fpath))
+        pho_error(rc = rc ? : -errno, "Fail to unlink extent file");
+
+clean_source:
+    close(src_fd);
+    if (unlink(src_path))
+        pho_error(rc = rc ? : -errno, "Fail to unlink source file");
+
+free_path:
+    free(ibuff);
+    free(src_path);
+    free(fpath);
+
+    if (rmdir(test_dir))
+        pho_error(rc = rc ? : -errno, "Unable to remove test dir");
+
+    return rc;
+}
+
+#ifdef URING_ENABLED
+/* not a multiple of the staging buffer size nor of the O_DIRECT alignment */
+#define URING_CHUNK_SIZE (64 * 1024 + 7)
+#define URING_CHUNK_COUNT 50
+
+static bool uring_available(void)
+{
+    struct io_uring ring;
+
+    if (io_uring_queue_init(1, &ring, 0))
+        return false;
+
+    io_uring_queue_exit(&ring);
+    return true;
+}
+
+static int test_uring_write_read(void *hint)
+{
+    char test_dir[] = "/tmp/test_uring_write_readXXXXXX";
+    char *put_extent_address = "put_extent";
+    struct io_adapter_module *ioa = NULL;
+    size_t size = URING_CHUNK_SIZE;
+    struct pho_io_descr iod = {0};
+    struct pho_ext_loc loc = {0};
+    unsigned char *ibuff = NULL;
+    unsigned char *obuff = NULL;
+    struct extent ext = {0};
+    size_t read_bytes = 0;
+    char *fpath = NULL;
+    int rc;
+    int i;
+
+    if (!uring_available()) {
+        pho_info("io_uring is not available on this host, skipping test");
+        return 0;
+    }
+
+    if (mkdtemp(test_dir) == NULL)
+        LOG_RETURN(-errno, "Unable to create test dir");
+
+    if (asprintf(&fpath, "%s/%s", test_dir, put_extent_address) < 0)
+        LOG_GOTO(clean_test_dir, rc = -ENOMEM,
+                 "Unable to allocate tested fpath");
+
+    rc = setenv("PHOBOS_IO_io_adapter", "dir=uring", 1);
+    if (rc)
+        LOG_GOTO(free_path, rc = -errno, "Unable to select uring adapter");
+
+    rc = get_io_adapter_for_family(PHO_FS_POSIX, PHO_RSC_DIR, &ioa);
+    unsetenv("PHOBOS_IO_io_adapter");
+    if (rc)
+        LOG_GOTO(free_path, rc, "Unable to get uring ioa");
+
+    ibuff = xmalloc(size);
+    for (i = 0; i < size; i++)
+        ibuff[i] = (unsigned char)(i * 7);
+
+    ext.address.buff = put_extent_address;
+    loc.extent = &ext;
+    loc.root_path = test_dir;
+    iod.iod_loc = &loc;
+
+    rc = ioa_open(ioa, NULL, &iod, true);
+    if (rc)
+        LOG_GOTO(free_path, rc, "Error on opening extent for put");
+
+    for (i = 0; i < URING_CHUNK_COUNT; i++) {
+        rc = ioa_write(ioa, &iod, ibuff, size);
+        if (rc) {
+            ioa_close(ioa, &iod);
+            LOG_GOTO(clean_extent, rc, "Error on writing with uring");
+        }
+    }
+
+    rc = ioa_close(ioa, &iod);
+    if (rc)
+        LOG_GOTO(clean_extent, rc, "Fail to close put iod");
+
+    /* the padding of the last O_DIRECT write must have been truncated */
+    rc = check_file_content(fpath, ibuff, size, URING_CHUNK_COUNT);
+    if (rc)
+        LOG_GOTO(clean_extent, rc, "Wrong content written by uring");
+
+    memset(&iod, 0, sizeof(iod));
+    iod.iod_loc = &loc;
+
+    rc = ioa_open(ioa, NULL, &iod, false);
+    if (rc)
+        LOG_GOTO(clean_extent, rc, "Error on opening extent for get");
+
+    /* read one more chunk than written to check the end of the extent */
+    obuff = xmalloc(size * (URING_CHUNK_COUNT + 1));
+    while (true) {
+        ssize_t nb_read;
+
+        nb_read = ioa_read(ioa, &iod, obuff + read_bytes, size);
+        if (nb_read < 0) {
+            ioa_close(ioa, &iod);
+            LOG_GOTO(clean_extent, rc = nb_read, "Error on reading with uring");
+        }
+
+        if (nb_read == 0)
+            break;
+
+        read_bytes += nb_read;
+        if (read_bytes > size * URING_CHUNK_COUNT) {
+            ioa_close(ioa, &iod);
+            LOG_GOTO(clean_extent, rc = -EINVAL, "Read past the extent end");
+        }
+    }
+
+    rc = ioa_close(ioa, &iod);
+    if (rc)
+        LOG_GOTO(clean_extent, rc, "Fail to close get iod");
+
+    if (read_bytes != size * URING_CHUNK_COUNT)
+        LOG_GOTO(clean_extent, rc = -EINVAL, "Read %zu bytes instead of %zu",
+                 read_bytes, size * URING_CHUNK_COUNT);
+
+    for (i = 0; i < URING_CHUNK_COUNT; i++)
+        if (memcmp(ibuff, obuff + i * size, size))
+            LOG_GOTO(clean_extent, rc = -EINVAL, "Wrong content read by uring");
+
+clean_extent:
+    if (unlink(fpath))
+        pho_error(rc = rc ? : -errno, "Fail to unlink extent file");
+
+free_path:
+    free(obuff);
+    free(ibuff);
+    free(fpath);
+
+clean_test_dir:
+    if (rmdir(test_dir))
+        pho_error(rc = rc ? : -errno, "Unable to remove test dir");
+
+    return rc;
+}
+#endif
+
 /**
  * TO DO
 static int test_posix_open_to_get_close(void *hint)
@@ -410,6 +650,12 @@ int main(int argc, char **argv)
 
     pho_run_test("Posix open, write and close",
                  test_posix_open_write_close, NULL, PHO_TEST_SUCCESS);
+    pho_run_test("Posix write from a file descriptor",
+                 test_posix_write_from_fd, NULL, PHO_TEST_SUCCESS);
+#ifdef URING_ENABLED
+    pho_run_test("Uring write and read back",
+                 test_uring_write_read, NULL, PHO_TEST_SUCCESS);
+#endif
     /**
      * TO DO
     pho_run_test("Posix open to get and close",
@@ -288,6 +288,38 @@ static void gcwtv_invalid_numbers(void **state)
     assert_int_equal(rc, -ERANGE);
 }
 
+static void gcsltv_valid(void **state)
+{
+    struct timespec res;
+    int rc;
+
+    (void)state;
+
+    rc = setenv("PHOBOS_LRS_sync_latency_target_ms", "dir=0,tape=30000", 1);
+    assert_int_equal(rc, -rc);
+
+    rc = get_cfg_sync_latency_target_ms_value(PHO_RSC_DIR, &res);
+    ASSERT_VALID_GET_TIME(rc, res, 0, 0);
+
+    rc = get_cfg_sync_latency_target_ms_value(PHO_RSC_TAPE, &res);
+    ASSERT_VALID_GET_TIME(rc, res, 30, 0);
+}
+
+static void gcsltv_default(void **state)
+{
+    struct timespec res;
+    int rc;
+
+    (void)state;
+
+    rc = unsetenv("PHOBOS_LRS_sync_latency_target_ms");
+    assert_int_equal(rc, -rc);
+
+    /* not configured: the adaptive mode is disabled */
+    rc = get_cfg_sync_latency_target_ms_value(PHO_RSC_TAPE, &res);
+    ASSERT_VALID_GET_TIME(rc, res, 0, 0);
+}
+
 int main(void)
 {
     const struct CMUnitTest get_time_threshold_test_cases[] = {
@@ -314,10 +346,16 @@ int main(void)
         cmocka_unit_test(gcwtv_invalid_numbers),
     };
 
+    const struct CMUnitTest get_latency_target_test_cases[] = {
+        cmocka_unit_test(gcsltv_valid),
+        cmocka_unit_test(gcsltv_default),
+    };
+
     pho_context_init();
     atexit(pho_context_fini);
 
     return cmocka_run_group_tests(get_time_threshold_test_cases, NULL, NULL) +
         cmocka_run_group_tests(get_nb_req_threshold_test_cases, NULL, NULL) +
-        cmocka_run_group_tests(get_wsize_threshold_test_cases, NULL, NULL);
+        cmocka_run_group_tests(get_wsize_threshold_test_cases, NULL, NULL) +
+        cmocka_run_group_tests(get_latency_target_test_cases, NULL, NULL);
 }
@@ -68,12 +68,15 @@ static int setup(void **data)
     assert_return_code(rc, -rc);
 
     rc = lock_handle_init(&scheduler.lock_handle, dss);
+    if (rc)
+        return rc;
 
-    return rc;
+    return dss_async_init(&scheduler.dss_async);
 }
 
 static int teardown(void **data)
 {
+    dss_async_fini(scheduler.dss_async);
     io_sched_fini(&scheduler.io_sched_hdl);
     return global_teardown_dss_with_dbdrop((void **)&dss);
 }
@@ -154,6 +157,81 @@ static void test_dev_init(void **data)
     lrs_dev_hdl_fini(&dev_handle);
 }
 
+static struct timespec ms2timespec(long ms)
+{
+    return (struct timespec) {
+        .tv_sec = ms / 1000,
+        .tv_nsec = (ms % 1000) * 1000000,
+    };
+}
+
+static long sync_window_ms(struct lrs_dev *dev)
+{
+    struct timespec window = lrs_dev_sync_window(dev);
+
+    return window.tv_sec * 1000 + window.tv_nsec / 1000000;
+}
+
+/* Record \p count releases \p interval_ms apart, each one synced in
+ * \p cost_ms
+ */
+static void record_load(struct lrs_dev *dev, struct timespec *date,
+                        long interval_ms, long cost_ms, int count)
+{
+    struct timespec interval = ms2timespec(interval_ms);
+    struct timespec cost = ms2timespec(cost_ms);
+    int i;
+
+    for (i = 0; i < count; i++) {
+        *date = add_timespec(date, &interval);
+        lrs_dev_sync_record_release(dev, date);
+        lrs_dev_sync_record_cost(dev, &cost);
+    }
+}
+
+static void test_dev_sync_window_adaptive(void **data)
+{
+    struct dev_info info = { .rsc.id.name = "test" };
+    struct timespec date = { .tv_sec = 1000 };
+    struct lrs_dev_hdl handle = { 0 };
+    struct lrs_dev dev = { 0 };
+
+    handle.sync_time_ms = ms2timespec(1000);
+    handle.sync_latency_target = ms2timespec(10000);
+    dev.ld_handle = &handle;
+    dev.ld_dss_dev_info = &info;
+    atomic_init(&dev.ld_sync_params.window_ms, 1000);
+
+    /* sync_time_ms is used until a sync is measured */
+    lrs_dev_sync_record_release(&dev, &date);
+    assert_int_equal(sync_window_ms(&dev), 1000);
+
+    /* close releases are batched for 4 times the cost of a sync */
+    record_load(&dev, &date, 10, 100, 1);
+    assert_int_equal(sync_window_ms(&dev), 400);
+
+    /* the window grows with the cost of the syncs... */
+    record_load(&dev, &date, 10, 1000, 30);
+    assert_in_range(sync_window_ms(&dev), 3990, 4000);
+
+    /* ... up to the latency target minus the sync */
+    record_load(&dev, &date, 10, 5000, 30);
+    assert_in_range(sync_window_ms(&dev), 5000, 5010);
+
+    /* it closes when the releases are too far apart to be batched... */
+    record_load(&dev, &date, 30000, 100, 30);
+    assert_int_equal(sync_window_ms(&dev), 0);
+
+    /* ... and opens again when they get closer */
+    record_load(&dev, &date, 10, 100, 30);
+    assert_int_equal(sync_window_ms(&dev), 400);
+
+    /* without latency target, the window is sync_time_ms */
+    handle.sync_latency_target = ms2timespec(0);
+    record_load(&dev, &date, 10, 5000, 30);
+    assert_int_equal(sync_window_ms(&dev), 1000);
+}
+
 static int remove_device(struct dss_handle *dss, char *device)
 {
     struct dev_info dev = {
@@ -342,6 +420,7 @@ int main(void)
 {
     const struct CMUnitTest lrs_device_tests[] = {
         cmocka_unit_test(test_dev_init),
+        cmocka_unit_test(test_dev_sync_window_adaptive),
         cmocka_unit_test_setup_teardown(test_ldh_add_one_device,
                                         test_setup_one_device,
                                         test_teardown_one_device),
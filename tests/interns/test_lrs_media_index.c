@@ -0,0 +1,171 @@
+/* -*- mode: c; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief  Tests for the LRS writable media index
+ */
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <cmocka.h>
+
+#include "lrs_media_index.h"
+#include "pho_common.h"
+#include "pho_test_utils.h"
+#include "pho_type_utils.h"
+
+static int lmi_setup(void **state)
+{
+    (void) state;
+
+    return lrs_media_index_setup(PHO_RSC_TAPE);
+}
+
+static int lmi_teardown(void **state)
+{
+    (void) state;
+
+    lrs_media_index_cleanup(PHO_RSC_TAPE);
+
+    return 0;
+}
+
+static void index_medium(const char *name, ssize_t free_space,
+                         enum fs_status status)
+{
+    struct media_info medium;
+
+    create_medium(&medium, name);
+    medium.fs.status = status;
+    medium.stats.phys_spc_free = free_space;
+    lrs_media_index_update(&medium);
+}
+
+/* Check the names returned by successive lookups */
+static void check_lookups(const struct media_index_query *query,
+                          bool descending, const char **expected, int count)
+{
+    struct media_index_cursor cursor = {0};
+    struct media_info *medium;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        medium = lrs_media_index_next(PHO_RSC_TAPE, query, &cursor,
+                                      descending);
+        assert_non_null(medium);
+        assert_string_equal(medium->rsc.id.name, expected[i]);
+        media_info_free(medium);
+    }
+
+    assert_null(lrs_media_index_next(PHO_RSC_TAPE, query, &cursor,
+                                     descending));
+}
+
+static void lmi_best_fit(void **state)
+{
+    struct media_index_query query = { .min_free = 150 };
+    const char *ascending[] = { "m200", "m300" };
+    const char *descending[] = { "m300", "m200" };
+
+    (void) state;
+
+    index_medium("m100", 100, PHO_FS_STATUS_USED);
+    index_medium("m300", 300, PHO_FS_STATUS_EMPTY);
+    index_medium("m200", 200, PHO_FS_STATUS_USED);
+
+    check_lookups(&query, false, ascending, 2);
+    check_lookups(&query, true, descending, 2);
+}
+
+static void lmi_update(void **state)
+{
+    struct media_index_query query = { .min_free = 0 };
+    const char *after_write[] = { "m300", "m100" };
+    const char *after_full[] = { "m300" };
+    struct media_info medium;
+
+    (void) state;
+
+    index_medium("m100", 100, PHO_FS_STATUS_USED);
+    index_medium("m300", 300, PHO_FS_STATUS_USED);
+
+    /* a write reduces the free space of m100 */
+    index_medium("m100", 50, PHO_FS_STATUS_USED);
+    check_lookups(&query, true, after_write, 2);
+
+    /* a full medium is removed from the index */
+    index_medium("m100", 0, PHO_FS_STATUS_FULL);
+    check_lookups(&query, true, after_full, 1);
+
+    /* so is an administratively locked one */
+    create_medium(&medium, "m300");
+    medium.fs.status = PHO_FS_STATUS_USED;
+    medium.rsc.adm_status = PHO_RSC_ADM_ST_LOCKED;
+    lrs_media_index_update(&medium);
+    check_lookups(&query, true, NULL, 0);
+}
+
+static void lmi_query(void **state)
+{
+    struct media_index_query query = { .min_free = 0 };
+    const char *empty[] = { "m200" };
+    const char *library[] = { "other" };
+    struct media_info medium;
+
+    (void) state;
+
+    index_medium("m100", 100, PHO_FS_STATUS_USED);
+    index_medium("m200", 200, PHO_FS_STATUS_EMPTY);
+
+    create_medium(&medium, "other");
+    pho_id_name_set(&medium.rsc.id, "other", "lib2");
+    medium.fs.status = PHO_FS_STATUS_USED;
+    medium.stats.phys_spc_free = 500;
+    lrs_media_index_update(&medium);
+
+    query.empty_medium = true;
+    check_lookups(&query, false, empty, 1);
+
+    query.empty_medium = false;
+    query.library = "lib2";
+    check_lookups(&query, false, library, 1);
+
+    assert_true(lrs_media_index_match(&medium, &query));
+    query.library = "legacy";
+    assert_false(lrs_media_index_match(&medium, &query));
+}
+
+int main(void)
+{
+    const struct CMUnitTest lrs_media_index_tests[] = {
+        cmocka_unit_test_setup_teardown(lmi_best_fit, lmi_setup,
+                                        lmi_teardown),
+        cmocka_unit_test_setup_teardown(lmi_update, lmi_setup, lmi_teardown),
+        cmocka_unit_test_setup_teardown(lmi_query, lmi_setup, lmi_teardown),
+    };
+
+    pho_context_init();
+    atexit(pho_context_fini);
+
+    return cmocka_run_group_tests(lrs_media_index_tests, NULL, NULL);
+}
@@ -519,6 +519,17 @@ int dss_media_get(struct dss_handle *hdl, const struct dss_filter *filter,
     return -ENOENT;
 }
 
+int dss_media_get_from_id(struct dss_handle *hdl,
+                          const struct pho_id *medium_id,
+                          struct media_info **med_ls, int *med_cnt)
+{
+    *med_ls = g_hash_table_lookup(fake_dss, medium_id->name);
+    assert_non_null(*med_ls);
+    *med_cnt = 1;
+
+    return 0;
+}
+
 int dss_medium_health(struct dss_handle *dss, const struct pho_id *medium_id,
                       size_t max_health, size_t *health)
 {
@@ -1235,6 +1246,230 @@ static void io_sched_requeue_one_request(void **data)
     g_ptr_array_free(devices, true);
 }
 
+static void push_request_at(struct io_sched_handle *io_sched,
+                            struct req_container *reqc,
+                            const char * const *media_names,
+                            uint64_t position)
+{
+    int rc;
+
+    create_request(reqc, media_names, 1, 1, io_sched->lock_handle);
+    reqc->req->ralloc->positions[0] = position + 1;
+
+    rc = io_sched_push_request(io_sched, reqc);
+    assert_return_code(rc, -rc);
+}
+
+static void serve_next_request(struct io_sched_handle *io_sched,
+                               struct req_container *expected,
+                               struct lrs_dev *device)
+{
+    struct req_container *new_reqc;
+    struct lrs_dev *dev;
+    size_t index = 0;
+    int rc;
+
+    rc = io_sched_peek_request(io_sched, &new_reqc);
+    assert_return_code(rc, -rc);
+    assert_ptr_equal(new_reqc, expected);
+
+    rc = io_sched_get_device_medium_pair(io_sched, new_reqc, &dev, &index);
+    free_medium_to_alloc(new_reqc, 0);
+    assert_return_code(rc, -rc);
+    assert_ptr_equal(dev, device);
+
+    rc = io_sched_remove_request(io_sched, new_reqc);
+    assert_return_code(rc, -rc);
+
+    /* the device is not scheduled */
+    dev->ld_ongoing_scheduled = false;
+}
+
+static void io_sched_read_by_position(void **data)
+{
+    struct io_sched_handle *io_sched = (struct io_sched_handle *) *data;
+    GPtrArray *devices = g_ptr_array_new();
+    static const char * const media_names[] = {
+        "M1",
+    };
+    struct req_container reqc[5];
+    struct lrs_dev device;
+    struct media_info M1;
+    int rc;
+    int i;
+
+    io_sched->global_device_list = devices;
+    create_device(&device, "test", LTO5_MODEL, NULL);
+    wrap_create_medium(&M1, media_names[0]);
+    add_media(&M1, 1);
+    mount_medium(&device, &M1);
+    gptr_array_from_list(devices, &device, 1, sizeof(device));
+
+    rc = io_sched_dispatch_devices(io_sched, devices);
+    assert_return_code(rc, -rc);
+
+    push_request_at(io_sched, &reqc[0], media_names, 30);
+    push_request_at(io_sched, &reqc[1], media_names, 10);
+    push_request_at(io_sched, &reqc[2], media_names, 40);
+
+    serve_next_request(io_sched, &reqc[1], &device);
+
+    /* 5 is behind the last position read, it is served on the next pass */
+    push_request_at(io_sched, &reqc[3], media_names, 5);
+    push_request_at(io_sched, &reqc[4], media_names, 20);
+
+    serve_next_request(io_sched, &reqc[4], &device);
+    serve_next_request(io_sched, &reqc[0], &device);
+    serve_next_request(io_sched, &reqc[2], &device);
+    serve_next_request(io_sched, &reqc[3], &device);
+
+    rc = io_sched_remove_device(io_sched, &device);
+    cleanup_device(&device);
+    assert_return_code(rc, -rc);
+
+    remove_media(&M1, 1);
+    for (i = 0; i < 5; i++)
+        destroy_request(&reqc[i]);
+    g_ptr_array_free(devices, true);
+}
+
+static void io_sched_read_prefetch(void **data)
+{
+    struct io_sched_handle *io_sched = (struct io_sched_handle *) *data;
+    GPtrArray *device_array = g_ptr_array_new();
+    static const char * const media_names[] = {
+        "M1", "M2",
+    };
+    struct req_container *new_reqc;
+    struct media_info *medium;
+    struct media_info media[2];
+    struct req_container reqc;
+    struct lrs_dev devices[2];
+    struct lrs_dev *dev;
+    int rc;
+
+    io_sched->global_device_list = device_array;
+    create_device(&devices[0], "D1", LTO5_MODEL, NULL);
+    create_device(&devices[1], "D2", LTO5_MODEL, NULL);
+    wrap_create_medium(&media[0], media_names[0]);
+    wrap_create_medium(&media[1], media_names[1]);
+    add_media(media, 2);
+    gptr_array_from_list(device_array, &devices, 2, sizeof(devices[0]));
+
+    rc = io_sched_dispatch_devices(io_sched, device_array);
+    assert_return_code(rc, -rc);
+
+    /* the request needs both media but D2 is busy */
+    devices[1].ld_ongoing_io = true;
+    create_request(&reqc, media_names, 2, 2, io_sched->lock_handle);
+    rc = io_sched_push_request(io_sched, &reqc);
+    assert_return_code(rc, -rc);
+
+    rc = io_sched_peek_request(io_sched, &new_reqc);
+    assert_return_code(rc, -rc);
+    assert_null(new_reqc);
+
+    /* one of the media can already be loaded in D1 */
+    rc = io_sched_prefetch(io_sched, &dev, &medium);
+    assert_return_code(rc, -rc);
+    assert_ptr_equal(dev, &devices[0]);
+    assert_non_null(medium);
+
+    /* D1 is busy while the medium is loaded */
+    devices[0].ld_preload_medium = medium;
+    rc = io_sched_prefetch(io_sched, &dev, &medium);
+    assert_return_code(rc, -rc);
+    assert_null(dev);
+
+    /* once loaded, the medium is kept for the request */
+    medium = devices[0].ld_preload_medium;
+    devices[0].ld_preload_medium = NULL;
+    load_medium(&devices[0],
+                !strcmp(medium->rsc.id.name, "M1") ? &media[0] : &media[1]);
+    lrs_medium_release(medium);
+
+    rc = io_sched_prefetch(io_sched, &dev, &medium);
+    assert_return_code(rc, -rc);
+    assert_null(dev);
+
+    rc = io_sched_remove_request(io_sched, &reqc);
+    assert_return_code(rc, -rc);
+
+    devices[1].ld_ongoing_io = false;
+    rc = io_sched_remove_device(io_sched, &devices[0]);
+    cleanup_device(&devices[0]);
+    assert_return_code(rc, -rc);
+
+    rc = io_sched_remove_device(io_sched, &devices[1]);
+    cleanup_device(&devices[1]);
+    assert_return_code(rc, -rc);
+
+    remove_media(media, 2);
+    destroy_request(&reqc);
+    g_ptr_array_free(device_array, true);
+}
+
+static void push_client_request(struct io_sched_handle *io_sched,
+                                struct req_container *reqc, int client,
+                                time_t received_at, unsigned int deadline_ms)
+{
+    static const char * const media_names[] = {
+        "M1",
+    };
+    int rc;
+
+    memset(reqc, 0, sizeof(*reqc));
+    create_request(reqc, media_names, 1, 1, io_sched->lock_handle);
+    reqc->socket_id = client;
+    reqc->received_at.tv_sec = received_at;
+    if (deadline_ms) {
+        reqc->req->has_deadline_ms = true;
+        reqc->req->deadline_ms = deadline_ms;
+    }
+
+    rc = io_sched_push_request(io_sched, reqc);
+    assert_return_code(rc, -rc);
+}
+
+static void io_sched_priority_order(void **data)
+{
+    struct io_sched_handle *io_sched = (struct io_sched_handle *) *data;
+    GPtrArray *devices = g_ptr_array_new();
+    struct req_container reqc[5];
+    /* the request with a past deadline, then one request of each client in
+     * turn
+     */
+    const int expected[] = { 4, 0, 3, 1, 2 };
+    struct req_container *new_reqc;
+    int rc;
+    int i;
+
+    io_sched->global_device_list = devices;
+
+    push_client_request(io_sched, &reqc[0], 1, 1, 0);
+    push_client_request(io_sched, &reqc[1], 1, 2, 0);
+    push_client_request(io_sched, &reqc[2], 1, 3, 0);
+    push_client_request(io_sched, &reqc[3], 2, 4, 0);
+    push_client_request(io_sched, &reqc[4], 3, 5, 1);
+
+    for (i = 0; i < ARRAY_SIZE(expected); i++) {
+        rc = io_sched_peek_request(io_sched, &new_reqc);
+        assert_return_code(rc, -rc);
+        assert_ptr_equal(new_reqc, &reqc[expected[i]]);
+
+        rc = io_sched_remove_request(io_sched, new_reqc);
+        assert_return_code(rc, -rc);
+    }
+
+    rc = io_sched_peek_request(io_sched, &new_reqc);
+    assert_return_code(rc, -rc);
+    assert_null(new_reqc);
+
+    for (i = 0; i < ARRAY_SIZE(reqc); i++)
+        destroy_request(&reqc[i]);
+    g_ptr_array_free(devices, true);
+}
+
 static void test_io_sched_error(void **data, bool free_device)
 {
     struct io_sched_handle *io_sched = (struct io_sched_handle *) *data;
@@ -2235,6 +2470,15 @@ int main(void)
         cmocka_unit_test(fair_share_one_shared_device_before_add),
         cmocka_unit_test(fair_share_one_non_shared_device_before_add_shared),
     };
+    const struct CMUnitTest test_read_order[] = {
+        cmocka_unit_test(io_sched_read_by_position),
+    };
+    const struct CMUnitTest test_read_prefetch[] = {
+        cmocka_unit_test(io_sched_read_prefetch),
+    };
+    const struct CMUnitTest test_priority[] = {
+        cmocka_unit_test(io_sched_priority_order),
+    };
     const struct CMUnitTest test_device_exchange[] = {
         cmocka_unit_test(io_sched_exchange_device_no_prior_repartition),
         cmocka_unit_test(io_sched_exchange_device),
@@ -2285,6 +2529,29 @@ int main(void)
                                           io_sched_setup,
                                           io_sched_teardown);
 
+    pho_info("Starting 'grouped_read' scheduler test with read_order set to "
+             "'position'");
+    check_rc(setenv("PHOBOS_IO_SCHED_TAPE_read_order", "position", 1));
+    error_count += cmocka_run_group_tests(test_read_order,
+                                          io_sched_setup,
+                                          io_sched_teardown);
+    check_rc(unsetenv("PHOBOS_IO_SCHED_TAPE_read_order"));
+
+    pho_info("Starting 'grouped_read' scheduler test with read_prefetch set "
+             "to 'true'");
+    check_rc(setenv("PHOBOS_IO_SCHED_TAPE_read_prefetch", "true", 1));
+    error_count += cmocka_run_group_tests(test_read_prefetch,
+                                          io_sched_setup,
+                                          io_sched_teardown);
+    check_rc(unsetenv("PHOBOS_IO_SCHED_TAPE_read_prefetch"));
+
+    check_rc(set_schedulers("priority", "fifo", "fifo", "none"));
+    pho_info("Starting 'priority' scheduler test");
+    error_count += cmocka_run_group_tests(test_priority,
+                                          io_sched_setup,
+                                          io_sched_teardown);
+    check_rc(set_schedulers("grouped_read", "fifo", "fifo", "none"));
+
     pho_info("Starting device dispatch tests");
     set_fair_share_minmax("LTO5", "1,1,1", "100,100,100");
     check_rc(setenv("PHOBOS_TAPE_MODEL_supported_list", "LTO5,LTO6,LTO7", 1));
@@ -0,0 +1,231 @@
+/* -*- mode: c; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief  Test the number of LTFS format commands run concurrently by the
+ *         device threads
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "pho_common.h"
+#include "pho_ldm.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+/* more threads than any tested limit */
+#define N_FORMATS 6
+
+/* delay after which a format stops waiting for the others */
+#define FORMAT_TIMEOUT_S 5
+
+/** Format commands in progress in the mock, and the most seen at once */
+static struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int running;
+    int max_running;
+    int expected;
+    int calls;
+} formats = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
+/* Each format waits until "expected" formats ran at once, so that the limit
+ * is reached whatever the scheduling of the threads. A limit that is not
+ * enforced makes the maximum exceed it, a too strict one times out.
+ */
+static int counting_command_call(const char *cmd_line, parse_cb_t cb_func,
+                                 void *cb_arg)
+{
+    struct timespec deadline;
+
+    (void) cmd_line;
+    (void) cb_func;
+    (void) cb_arg;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += FORMAT_TIMEOUT_S;
+
+    MUTEX_LOCK(&formats.mutex);
+    formats.calls++;
+    formats.running++;
+    if (formats.running > formats.max_running)
+        formats.max_running = formats.running;
+    pthread_cond_broadcast(&formats.cond);
+
+    while (formats.max_running < formats.expected)
+        if (pthread_cond_timedwait(&formats.cond, &formats.mutex, &deadline))
+            break;
+
+    formats.running--;
+    MUTEX_UNLOCK(&formats.mutex);
+
+    return 0;
+}
+
+struct format_arg {
+    struct fs_adapter_module *fsa;
+    char label[16];
+    int rc;
+};
+
+static void *format_thread(void *arg)
+{
+    struct format_arg *format = arg;
+    struct ldm_fs_space spc;
+    json_t *message = NULL;
+
+    format->rc = ldm_fs_format(format->fsa, "/dev/null", format->label, &spc,
+                               &message);
+    if (message)
+        json_decref(message);
+
+    return NULL;
+}
+
+static int lf_setup(void **state)
+{
+    (void) state;
+
+    formats.running = 0;
+    formats.max_running = 0;
+    formats.calls = 0;
+    phobos_context()->mock_ltfs.mock_command_call = counting_command_call;
+
+    return 0;
+}
+
+static int lf_teardown(void **state)
+{
+    (void) state;
+
+    unsetenv("PHOBOS_LTFS_max_concurrent_formats");
+    pho_context_reset_mock_ltfs_functions();
+
+    return 0;
+}
+
+/* Format N_FORMATS media at once with \p limit as max_concurrent_formats */
+static void format_concurrently(const char *limit, int expected)
+{
+    struct format_arg args[N_FORMATS];
+    pthread_t threads[N_FORMATS];
+    struct fs_adapter_module *fsa;
+    int rc;
+    int i;
+
+    assert_int_equal(setenv("PHOBOS_LTFS_max_concurrent_formats", limit, 1),
+                     0);
+    formats.expected = expected;
+
+    rc = get_fs_adapter(PHO_FS_LTFS, &fsa);
+    assert_return_code(rc, -rc);
+
+    for (i = 0; i < N_FORMATS; i++) {
+        args[i].fsa = fsa;
+        snprintf(args[i].label, sizeof(args[i].label), "P%05dL5", i);
+        assert_int_equal(pthread_create(&threads[i], NULL, format_thread,
+                                        &args[i]), 0);
+    }
+
+    for (i = 0; i < N_FORMATS; i++) {
+        assert_int_equal(pthread_join(threads[i], NULL), 0);
+        assert_int_equal(args[i].rc, 0);
+    }
+
+    assert_int_equal(formats.calls, N_FORMATS);
+    assert_int_equal(formats.running, 0);
+    assert_int_equal(formats.max_running, expected);
+}
+
+/* Without a limit, all the media are formatted at once */
+static void lf_no_limit(void **state)
+{
+    (void) state;
+
+    format_concurrently("0", N_FORMATS);
+}
+
+static void lf_one_at_a_time(void **state)
+{
+    (void) state;
+
+    format_concurrently("1", 1);
+}
+
+static void lf_two_at_a_time(void **state)
+{
+    (void) state;
+
+    format_concurrently("2", 2);
+}
+
+/* A negative limit fails the format before the command is run */
+static void lf_invalid_limit(void **state)
+{
+    struct fs_adapter_module *fsa;
+    json_t *message = NULL;
+    struct ldm_fs_space spc;
+    int rc;
+
+    (void) state;
+
+    assert_int_equal(setenv("PHOBOS_LTFS_max_concurrent_formats", "-1", 1), 0);
+
+    rc = get_fs_adapter(PHO_FS_LTFS, &fsa);
+    assert_return_code(rc, -rc);
+
+    rc = ldm_fs_format(fsa, "/dev/null", "P00000L5", &spc, &message);
+    assert_int_equal(rc, -EINVAL);
+    assert_int_equal(formats.calls, 0);
+    if (message)
+        json_decref(message);
+}
+
+int main(void)
+{
+    const struct CMUnitTest ltfs_formats_cases[] = {
+        cmocka_unit_test_setup_teardown(lf_no_limit, lf_setup, lf_teardown),
+        cmocka_unit_test_setup_teardown(lf_one_at_a_time,
+                                        lf_setup, lf_teardown),
+        cmocka_unit_test_setup_teardown(lf_two_at_a_time,
+                                        lf_setup, lf_teardown),
+        cmocka_unit_test_setup_teardown(lf_invalid_limit,
+                                        lf_setup, lf_teardown),
+    };
+
+    pho_context_init();
+    atexit(pho_context_fini);
+
+    return cmocka_run_group_tests(ltfs_formats_cases, NULL, NULL);
+}
@@ -0,0 +1,165 @@
+/* -*- mode: c; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief  Tests and micro-benchmark of the raid4 xor implementations
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "raid4.h"
+
+#include <cmocka.h>
+
+#define BENCH_SIZE       (16 * 1024 * 1024)
+#define BENCH_ITERATIONS 16
+
+static const char * const IMPLS[] = { "avx512", "avx2", "sse2", "word" };
+
+static void fill_random(char *buff, size_t size)
+{
+    size_t i;
+
+    for (i = 0; i < size; i++)
+        buff[i] = rand();
+}
+
+/* Check each implementation against a byte loop, with sizes and offsets that
+ * exercise the vector loops as well as their tails.
+ */
+static void xor_matches_reference(void **state)
+{
+    static const size_t sizes[] = { 0, 1, 7, 8, 15, 16, 63, 64, 65, 127, 128,
+                                    129, 4095, 4096, 65536 + 13 };
+    size_t max_size = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1] + 1;
+    char *in1 = malloc(max_size);
+    char *in2 = malloc(max_size);
+    char *out = malloc(max_size);
+    char *ref = malloc(max_size);
+    size_t i, j, k;
+
+    (void) state;
+
+    assert_non_null(in1);
+    assert_non_null(in2);
+    assert_non_null(out);
+    assert_non_null(ref);
+
+    fill_random(in1, max_size);
+    fill_random(in2, max_size);
+
+    for (i = 0; i < sizeof(IMPLS) / sizeof(IMPLS[0]); i++) {
+        int rc = buffer_xor_set_impl(IMPLS[i]);
+
+        if (rc == -ENOTSUP)
+            continue;
+        assert_int_equal(rc, 0);
+
+        for (j = 0; j < sizeof(sizes) / sizeof(sizes[0]); j++) {
+            /* misalign the buffers by one byte */
+            for (k = 0; k < 2 && sizes[j] + k <= max_size - 1; k++) {
+                struct pho_buff buff1 = { .buff = in1 + k, .size = sizes[j] };
+                struct pho_buff buff2 = { .buff = in2 + k, .size = sizes[j] };
+                struct pho_buff xor = { .buff = out, .size = sizes[j] };
+                size_t l;
+
+                for (l = 0; l < sizes[j]; l++)
+                    ref[l] = buff1.buff[l] ^ buff2.buff[l];
+
+                /* guard byte must not be written */
+                out[sizes[j]] = 0x5a;
+                buffer_xor(&buff1, &buff2, &xor, sizes[j]);
+                assert_memory_equal(out, ref, sizes[j]);
+                assert_int_equal(out[sizes[j]], 0x5a);
+            }
+        }
+    }
+
+    assert_int_equal(buffer_xor_set_impl("unknown"), -EINVAL);
+
+    free(in1);
+    free(in2);
+    free(out);
+    free(ref);
+}
+
+/* Not a pass/fail test: print the throughput of each implementation */
+static void xor_bench(void **state)
+{
+    struct pho_buff buff1 = { .buff = malloc(BENCH_SIZE), .size = BENCH_SIZE };
+    struct pho_buff buff2 = { .buff = malloc(BENCH_SIZE), .size = BENCH_SIZE };
+    struct pho_buff xor = { .buff = malloc(BENCH_SIZE), .size = BENCH_SIZE };
+    size_t i;
+    int j;
+
+    (void) state;
+
+    assert_non_null(buff1.buff);
+    assert_non_null(buff2.buff);
+    assert_non_null(xor.buff);
+
+    fill_random(buff1.buff, BENCH_SIZE);
+    fill_random(buff2.buff, BENCH_SIZE);
+
+    for (i = 0; i < sizeof(IMPLS) / sizeof(IMPLS[0]); i++) {
+        struct timespec start, end;
+        double elapsed;
+
+        if (buffer_xor_set_impl(IMPLS[i]))
+            continue;
+
+        /* warm up */
+        buffer_xor(&buff1, &buff2, &xor, BENCH_SIZE);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (j = 0; j < BENCH_ITERATIONS; j++)
+            buffer_xor(&buff1, &buff2, &xor, BENCH_SIZE);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        elapsed = (end.tv_sec - start.tv_sec) +
+                  (end.tv_nsec - start.tv_nsec) / 1e9;
+        printf("xor %-6s: %6.2f GB/s\n", IMPLS[i],
+               (double)BENCH_SIZE * BENCH_ITERATIONS / elapsed / 1e9);
+    }
+
+    free(buff1.buff);
+    free(buff2.buff);
+    free(xor.buff);
+}
+
+int main(void)
+{
+    const struct CMUnitTest xor_tests[] = {
+        cmocka_unit_test(xor_matches_reference),
+        cmocka_unit_test(xor_bench),
+    };
+
+    return cmocka_run_group_tests(xor_tests, NULL, NULL);
+}
@@ -0,0 +1,255 @@
+/* -*- mode: c; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief  Tests of the raid_ec Galois field kernels and Reed-Solomon code
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "raid_ec.h"
+
+#include <cmocka.h>
+
+#define BENCH_SIZE       (16 * 1024 * 1024)
+#define BENCH_ITERATIONS 16
+
+static const char * const IMPLS[] = { "avx2", "ssse3", "table" };
+
+static void fill_random(char *buff, size_t size)
+{
+    size_t i;
+
+    for (i = 0; i < size; i++)
+        buff[i] = rand();
+}
+
+/* Reference multiplication, shift and add */
+static uint8_t ref_mul(uint8_t a, uint8_t b)
+{
+    uint8_t product = 0;
+
+    while (b) {
+        if (b & 1)
+            product ^= a;
+        a = (a << 1) ^ (a & 0x80 ? 0x1d : 0);
+        b >>= 1;
+    }
+
+    return product;
+}
+
+static void gf_arithmetic(void **state)
+{
+    int a, b;
+
+    (void) state;
+
+    for (a = 0; a < 256; a++) {
+        for (b = 0; b < 256; b++)
+            assert_int_equal(gf256_mul(a, b), ref_mul(a, b));
+
+        if (a != 0)
+            assert_int_equal(gf256_mul(a, gf256_inv(a)), 1);
+    }
+}
+
+/* Check each implementation against the reference multiplication, with sizes
+ * and offsets that exercise the vector loops as well as their tails.
+ */
+static void gf_region_matches_reference(void **state)
+{
+    static const size_t sizes[] = { 0, 1, 15, 16, 17, 31, 32, 33, 4095,
+                                    65536 + 13 };
+    static const uint8_t coefs[] = { 1, 2, 0x53, 0xff };
+    size_t max_size = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1] + 2;
+    char *src = malloc(max_size);
+    char *dst = malloc(max_size);
+    char *ref = malloc(max_size);
+    size_t i, j, k, c;
+
+    (void) state;
+
+    assert_non_null(src);
+    assert_non_null(dst);
+    assert_non_null(ref);
+
+    fill_random(src, max_size);
+
+    for (i = 0; i < sizeof(IMPLS) / sizeof(IMPLS[0]); i++) {
+        int rc = gf256_set_impl(IMPLS[i]);
+
+        if (rc == -ENOTSUP)
+            continue;
+        assert_int_equal(rc, 0);
+
+        for (c = 0; c < sizeof(coefs); c++) {
+            for (j = 0; j < sizeof(sizes) / sizeof(sizes[0]); j++) {
+                /* misalign the source by one byte */
+                for (k = 0; k < 2; k++) {
+                    size_t l;
+
+                    fill_random(dst, max_size);
+                    memcpy(ref, dst, max_size);
+                    for (l = 0; l < sizes[j]; l++)
+                        ref[l] ^= ref_mul(coefs[c], src[k + l]);
+
+                    gf256_mul_add_region(src + k, dst, coefs[c], sizes[j]);
+                    /* bytes past the region must not be written */
+                    assert_memory_equal(dst, ref, max_size);
+                }
+            }
+        }
+    }
+
+    assert_int_equal(gf256_set_impl("unknown"), -EINVAL);
+
+    free(src);
+    free(dst);
+    free(ref);
+}
+
+/* Encode a stripe and rebuild it from every subset of n_data blocks */
+static void rs_check_geometry(size_t n_data, size_t n_parity, size_t size)
+{
+    size_t n_total = n_data + n_parity;
+    char *blocks[RAID_EC_MAX_EXTENTS];
+    char *avail[RAID_EC_MAX_EXTENTS];
+    size_t positions[RAID_EC_MAX_EXTENTS];
+    uint8_t *matrix = malloc(n_data * n_data);
+    char *output = malloc(size);
+    unsigned long subset;
+    size_t i;
+
+    assert_non_null(matrix);
+    assert_non_null(output);
+
+    for (i = 0; i < n_total; i++) {
+        blocks[i] = malloc(size);
+        assert_non_null(blocks[i]);
+        if (i < n_data)
+            fill_random(blocks[i], size);
+    }
+
+    rs_encode(n_data, n_parity, blocks, blocks + n_data, size);
+
+    for (subset = 0; subset < (1UL << n_total); subset++) {
+        size_t n = 0;
+
+        if ((size_t)__builtin_popcountl(subset) != n_data)
+            continue;
+
+        for (i = 0; i < n_total; i++) {
+            if (subset & (1UL << i)) {
+                positions[n] = i;
+                avail[n] = blocks[i];
+                n++;
+            }
+        }
+
+        assert_int_equal(rs_decode_matrix(n_data, positions, matrix), 0);
+
+        for (i = 0; i < n_data; i++) {
+            rs_decode_block(n_data, matrix + i * n_data, avail, output, size);
+            assert_memory_equal(output, blocks[i], size);
+        }
+    }
+
+    for (i = 0; i < n_total; i++)
+        free(blocks[i]);
+    free(matrix);
+    free(output);
+}
+
+static void rs_rebuild_from_any_subset(void **state)
+{
+    (void) state;
+
+    rs_check_geometry(1, 1, 100);
+    rs_check_geometry(2, 1, 4096);
+    rs_check_geometry(4, 2, 1000);
+    rs_check_geometry(6, 3, 333);
+    rs_check_geometry(10, 4, 64);
+}
+
+/* Not a pass/fail test: print the encoding throughput of each implementation */
+static void rs_bench(void **state)
+{
+    const size_t n_data = 8;
+    const size_t n_parity = 2;
+    size_t block_size = BENCH_SIZE / n_data;
+    char *blocks[10];
+    size_t i;
+    int j;
+
+    (void) state;
+
+    for (i = 0; i < n_data + n_parity; i++) {
+        blocks[i] = malloc(block_size);
+        assert_non_null(blocks[i]);
+        fill_random(blocks[i], block_size);
+    }
+
+    for (i = 0; i < sizeof(IMPLS) / sizeof(IMPLS[0]); i++) {
+        struct timespec start, end;
+        double elapsed;
+
+        if (gf256_set_impl(IMPLS[i]))
+            continue;
+
+        /* warm up */
+        rs_encode(n_data, n_parity, blocks, blocks + n_data, block_size);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (j = 0; j < BENCH_ITERATIONS; j++)
+            rs_encode(n_data, n_parity, blocks, blocks + n_data, block_size);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        elapsed = (end.tv_sec - start.tv_sec) +
+                  (end.tv_nsec - start.tv_nsec) / 1e9;
+        printf("rs 8+2 %-5s: %6.2f GB/s\n", IMPLS[i],
+               (double)BENCH_SIZE * BENCH_ITERATIONS / elapsed / 1e9);
+    }
+
+    for (i = 0; i < n_data + n_parity; i++)
+        free(blocks[i]);
+}
+
+int main(void)
+{
+    const struct CMUnitTest gf_tests[] = {
+        cmocka_unit_test(gf_arithmetic),
+        cmocka_unit_test(gf_region_matches_reference),
+        cmocka_unit_test(rs_rebuild_from_any_subset),
+        cmocka_unit_test(rs_bench),
+    };
+
+    return cmocka_run_group_tests(gf_tests, NULL, NULL);
+}
@@ -0,0 +1,297 @@
+/* -*- mode: c; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief  Tests of the extent hashes of the raid layouts
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "pho_common.h"
+#include "pho_io.h"
+#include "raid_common.h"
+
+#include <cmocka.h>
+
+#define DATA_SIZE (300 * 1024 + 17)
+#define BLOCK_SIZE (64 * 1024)
+
+static char *random_data(size_t size)
+{
+    char *data = malloc(size);
+    size_t i;
+
+    assert_non_null(data);
+    for (i = 0; i < size; i++)
+        data[i] = rand();
+
+    return data;
+}
+
+static void hash_data(struct extent_hash *hash, char *data,
+                      const size_t *sizes, int count)
+{
+    int i;
+
+    assert_return_code(extent_hash_reset(hash), -1);
+    for (i = 0; i < count; i++) {
+        assert_return_code(extent_hash_update(hash, data, sizes[i]), -1);
+        data += sizes[i];
+    }
+    assert_return_code(extent_hash_digest(hash), -1);
+}
+
+/* Check value of the CRC32C, from RFC 3720 */
+static void crc32c_check_value(void **state)
+{
+    static const unsigned char expected[] = { 0xe3, 0x06, 0x92, 0x83 };
+    char data[] = "123456789";
+    struct extent_hash hash = {0};
+    struct extent extent = {0};
+    size_t size = strlen(data);
+
+    (void) state;
+
+    assert_return_code(extent_hash_init(&hash, false, false, true), -1);
+    assert_true(extent_hash_is_enabled(&hash));
+    hash_data(&hash, data, &size, 1);
+
+    assert_return_code(extent_hash_copy(&hash, &extent), -1);
+    assert_true(extent.with_crc32c);
+    assert_false(extent.with_md5);
+    assert_memory_equal(extent.crc32c, expected, sizeof(expected));
+
+    extent_hash_fini(&hash);
+}
+
+/* The digests do not depend on how the data is split between the updates */
+static void hash_split_updates(void **state)
+{
+    static const size_t one_update[] = { DATA_SIZE };
+    static const size_t updates[] = { 1, 7, 64 * 1024, 65 * 1024 + 3,
+                                      DATA_SIZE - 1 - 7 - 64 * 1024 -
+                                      (65 * 1024 + 3) };
+    struct extent_hash hash = {0};
+    struct extent extent = {0};
+    char *data = random_data(DATA_SIZE);
+
+    (void) state;
+
+    assert_return_code(extent_hash_init(&hash, true, true, true), -1);
+
+    hash_data(&hash, data, one_update, 1);
+    assert_return_code(extent_hash_copy(&hash, &extent), -1);
+
+    hash_data(&hash, data, updates, sizeof(updates) / sizeof(updates[0]));
+    assert_return_code(extent_hash_compare(&hash, &extent), -1);
+
+    /* a corrupted byte is detected */
+    data[DATA_SIZE / 2] ^= 1;
+    hash_data(&hash, data, one_update, 1);
+    assert_int_equal(extent_hash_compare(&hash, &extent), -EINVAL);
+
+    extent_hash_fini(&hash);
+    free(data);
+}
+
+static void crc32c_of(const char *impl, char *data, size_t size,
+                      unsigned char *crc32c)
+{
+    struct extent_hash hash = {0};
+    struct extent extent = {0};
+
+    assert_int_equal(extent_hash_crc32c_set_impl(impl), 0);
+    assert_string_equal(extent_hash_crc32c_impl(), impl);
+
+    assert_return_code(extent_hash_init(&hash, false, false, true), -1);
+    hash_data(&hash, data, &size, 1);
+    assert_return_code(extent_hash_copy(&hash, &extent), -1);
+    memcpy(crc32c, extent.crc32c, CRC32C_BYTE_LENGTH);
+
+    extent_hash_fini(&hash);
+}
+
+/* The SSE 4.2 instruction and the tables give the same CRC32C, with sizes and
+ * offsets that exercise the 8-byte loops as well as their head and tail.
+ */
+static void crc32c_impls_match(void **state)
+{
+    static const size_t sizes[] = { 0, 1, 7, 8, 9, 63, 64, 4095,
+                                    BLOCK_SIZE + 13 };
+    const char *initial_impl = extent_hash_crc32c_impl();
+    char *data = random_data(BLOCK_SIZE + 13 + 8);
+    size_t i, j;
+    int rc;
+
+    (void) state;
+
+    rc = extent_hash_crc32c_set_impl("sse4.2");
+    if (rc == -ENOTSUP) {
+        free(data);
+        skip();
+    }
+    assert_int_equal(rc, 0);
+
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        for (j = 0; j < 8; j++) {
+            unsigned char crc32c_hw[CRC32C_BYTE_LENGTH];
+            unsigned char crc32c_sw[CRC32C_BYTE_LENGTH];
+
+            crc32c_of("sse4.2", data + j, sizes[i], crc32c_hw);
+            crc32c_of("sw", data + j, sizes[i], crc32c_sw);
+            assert_memory_equal(crc32c_hw, crc32c_sw, CRC32C_BYTE_LENGTH);
+        }
+    }
+
+    assert_int_equal(extent_hash_crc32c_set_impl("unknown"), -EINVAL);
+    assert_int_equal(extent_hash_crc32c_set_impl(initial_impl), 0);
+    free(data);
+}
+
+static void iod_open_tmp(struct io_adapter_module *ioa,
+                         struct pho_io_descr *iod, int *fd)
+{
+    char path[] = "/tmp/test_raid_hashXXXXXX";
+
+    *fd = mkstemp(path);
+    assert_true(*fd >= 0);
+    assert_int_equal(unlink(path), 0);
+
+    memset(iod, 0, sizeof(*iod));
+    assert_return_code(iod_from_fd(ioa, iod, *fd), -1);
+}
+
+/* The hashes of the jobs of a worker are computed by its hashing thread, in
+ * the order of the jobs: while a block is written, or once it is read.
+ */
+static void pipeline_hasher_thread(void **state)
+{
+    char *read_buff = malloc(2 * BLOCK_SIZE);
+    char *data = random_data(DATA_SIZE);
+    const size_t whole = DATA_SIZE;
+    struct raid_io_pipeline pipeline;
+    struct extent_hash hash = {0};
+    struct io_adapter_module *ioa;
+    struct extent extent = {0};
+    struct pho_io_descr iods[2];
+    size_t offset;
+    ssize_t size;
+    int cur = 0;
+    int fds[2];
+    int i;
+
+    (void) state;
+
+    assert_non_null(read_buff);
+    assert_return_code(get_io_adapter(PHO_FS_POSIX, &ioa), -1);
+    for (i = 0; i < 2; i++)
+        iod_open_tmp(ioa, &iods[i], &fds[i]);
+
+    /* reference digests, computed inline */
+    assert_return_code(extent_hash_init(&hash, true, true, true), -1);
+    hash_data(&hash, data, &whole, 1);
+    assert_return_code(extent_hash_copy(&hash, &extent), -1);
+
+    /* only the first extent is hashed, as the raid1 replicas */
+    assert_return_code(extent_hash_reset(&hash), -1);
+    assert_return_code(raid_io_pipeline_start(&pipeline, 2), -1);
+    for (offset = 0; offset < DATA_SIZE; offset += size) {
+        size = min(BLOCK_SIZE, DATA_SIZE - offset);
+        for (i = 0; i < 2; i++)
+            raid_io_pipeline_submit(&pipeline, i, RAID_IO_WRITE, &iods[i],
+                                    data + offset, size,
+                                    i == 0 ? &hash : NULL);
+        assert_return_code(raid_io_pipeline_wait(&pipeline), -1);
+    }
+
+    assert_true(pipeline.workers[0].hasher_started);
+    assert_false(pipeline.workers[1].hasher_started);
+    raid_io_pipeline_stop(&pipeline);
+
+    for (i = 0; i < 2; i++)
+        assert_int_equal(iods[i].iod_size, DATA_SIZE);
+
+    assert_return_code(extent_hash_digest(&hash), -1);
+    assert_return_code(extent_hash_compare(&hash, &extent), -1);
+
+    /* each block read is hashed while the next one is read */
+    assert_int_equal(lseek(fds[0], 0, SEEK_SET), 0);
+    assert_return_code(extent_hash_reset(&hash), -1);
+    assert_return_code(raid_io_pipeline_start(&pipeline, 1), -1);
+    raid_io_pipeline_submit(&pipeline, 0, RAID_IO_READ, &iods[0], read_buff,
+                            BLOCK_SIZE, &hash);
+
+    for (offset = 0; ; offset += size) {
+        char *block = read_buff + cur * BLOCK_SIZE;
+
+        assert_return_code(raid_io_pipeline_wait(&pipeline), -1);
+        size = raid_io_pipeline_result(&pipeline, 0);
+        if (size == 0)
+            break;
+
+        raid_io_pipeline_submit(&pipeline, 0, RAID_IO_READ, &iods[0],
+                                read_buff + (1 - cur) * BLOCK_SIZE,
+                                BLOCK_SIZE, &hash);
+
+        /* the block is still being hashed, it must only be read */
+        assert_in_range(size, 1, BLOCK_SIZE);
+        assert_memory_equal(block, data + offset, size);
+        cur = 1 - cur;
+    }
+
+    assert_true(pipeline.workers[0].hasher_started);
+    raid_io_pipeline_stop(&pipeline);
+    assert_int_equal(offset, DATA_SIZE);
+
+    assert_return_code(extent_hash_digest(&hash), -1);
+    assert_return_code(extent_hash_compare(&hash, &extent), -1);
+
+    for (i = 0; i < 2; i++)
+        ioa_close(ioa, &iods[i]);
+
+    extent_hash_fini(&hash);
+    free(read_buff);
+    free(data);
+}
+
+int main(void)
+{
+    const struct CMUnitTest hash_tests[] = {
+        cmocka_unit_test(crc32c_check_value),
+        cmocka_unit_test(hash_split_updates),
+        cmocka_unit_test(crc32c_impls_match),
+        cmocka_unit_test(pipeline_hasher_thread),
+    };
+
+    pho_context_init();
+    atexit(pho_context_fini);
+
+    return cmocka_run_group_tests(hash_tests, NULL, NULL);
+}
@@ -0,0 +1,366 @@
+/* -*- mode: c; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief  Put/get round trips of the raid1 and raid4 layouts on directories,
+ *         whose extents are written and read by the raid I/O pipeline
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "pho_attrs.h"
+#include "pho_common.h"
+#include "pho_layout.h"
+#include "pho_srl_common.h"
+#include "pho_srl_lrs.h"
+#include "pho_types.h"
+#include "phobos_store.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#define N_MEDIA 3
+
+/* several blocks of the pipeline per extent, with a tail */
+#define IO_BLOCK_SIZE "dir=65536"
+#define OBJECT_SIZE (1024 * 1024 + 13)
+
+struct raid_fixture {
+    char dirs[N_MEDIA][32];
+    char source[32];
+    char target[32];
+    int source_fd;
+    int target_fd;
+};
+
+static struct raid_fixture fx;
+
+static int rp_setup(void **state)
+{
+    char buff[4096];
+    size_t written;
+    int i;
+
+    (void) state;
+
+    memset(&fx, 0, sizeof(fx));
+    for (i = 0; i < N_MEDIA; i++) {
+        strcpy(fx.dirs[i], "/tmp/test_raid_dirXXXXXX");
+        if (!mkdtemp(fx.dirs[i]))
+            return -1;
+    }
+
+    strcpy(fx.source, "/tmp/test_raid_srcXXXXXX");
+    strcpy(fx.target, "/tmp/test_raid_tgtXXXXXX");
+    fx.source_fd = mkstemp(fx.source);
+    fx.target_fd = mkstemp(fx.target);
+    if (fx.source_fd < 0 || fx.target_fd < 0)
+        return -1;
+
+    for (written = 0; written < OBJECT_SIZE; written += sizeof(buff)) {
+        size_t size = sizeof(buff);
+
+        if (size > OBJECT_SIZE - written)
+            size = OBJECT_SIZE - written;
+
+        for (i = 0; i < size; i++)
+            buff[i] = rand();
+
+        if (write(fx.source_fd, buff, size) != size)
+            return -1;
+    }
+
+    return setenv("PHOBOS_IO_io_block_size", IO_BLOCK_SIZE, 1);
+}
+
+static int remove_entry(const char *path, const struct stat *st, int flag,
+                        struct FTW *ftw)
+{
+    (void) st;
+    (void) flag;
+    (void) ftw;
+
+    return remove(path);
+}
+
+static int rp_teardown(void **state)
+{
+    int rc = 0;
+    int i;
+
+    (void) state;
+
+    unsetenv("PHOBOS_IO_io_block_size");
+    close(fx.source_fd);
+    close(fx.target_fd);
+    unlink(fx.source);
+    unlink(fx.target);
+
+    for (i = 0; i < N_MEDIA; i++)
+        rc = rc ? : nftw(fx.dirs[i], remove_entry, 8, FTW_DEPTH | FTW_PHYS);
+
+    return rc;
+}
+
+static void reqs_free(pho_req_t *reqs, size_t n_reqs)
+{
+    size_t i;
+
+    for (i = 0; i < n_reqs; i++)
+        pho_srl_request_free(reqs + i, false);
+
+    free(reqs);
+}
+
+/* Allocate the N_MEDIA directories for a write */
+static void write_response(pho_resp_t *resp)
+{
+    int i;
+
+    pho_srl_response_write_alloc(resp, N_MEDIA);
+    for (i = 0; i < N_MEDIA; i++) {
+        pho_resp_write_elt_t *medium = resp->walloc->media[i];
+
+        medium->med_id->family = PHO_RSC_DIR;
+        medium->med_id->name = xstrdup(fx.dirs[i]);
+        medium->med_id->library = xstrdup("legacy");
+        medium->avail_size = 1024 * 1024 * 1024;
+        medium->root_path = xstrdup(fx.dirs[i]);
+        medium->fs_type = PHO_FS_POSIX;
+        medium->addr_type = PHO_ADDR_HASH1;
+    }
+}
+
+/* Allocate the \p n_media media of \p ralloc given by \p indexes for a read */
+static void read_response(pho_resp_t *resp, pho_req_read_t *ralloc,
+                          const int *indexes, size_t n_media)
+{
+    int i;
+
+    pho_srl_response_read_alloc(resp, n_media);
+    for (i = 0; i < n_media; i++) {
+        pho_resp_read_elt_t *medium = resp->ralloc->media[i];
+
+        rsc_id_cpy(medium->med_id, ralloc->med_ids[indexes[i]]);
+        medium->root_path = xstrdup(medium->med_id->name);
+        medium->fs_type = PHO_FS_POSIX;
+        medium->addr_type = PHO_ADDR_HASH1;
+    }
+}
+
+static void release_response(pho_resp_t *resp, pho_req_release_t *release)
+{
+    int i;
+
+    pho_srl_response_release_alloc(resp, release->n_media);
+    for (i = 0; i < release->n_media; i++)
+        rsc_id_cpy(resp->release->med_ids[i], release->media[i]->med_id);
+}
+
+/* Put the source file with \p layout_name as if the LRS allocated the
+ * N_MEDIA directories, the layout of the object is left in \p enc.
+ */
+static void raid_put(struct pho_encoder *enc, struct pho_xfer_desc *xfer,
+                     struct pho_xfer_target *target, const char *layout_name)
+{
+    pho_req_t *reqs;
+    pho_resp_t resp;
+    size_t n_reqs;
+    int rc;
+    int i;
+
+    target->xt_objid = "oid";
+    target->xt_objuuid = "uuid";
+    target->xt_fd = fx.source_fd;
+    target->xt_size = OBJECT_SIZE;
+    xfer->xd_op = PHO_XFER_OP_PUT;
+    xfer->xd_ntargets = 1;
+    xfer->xd_targets = target;
+    xfer->xd_params.put.layout_name = layout_name;
+    xfer->xd_params.put.family = PHO_RSC_DIR;
+
+    assert_int_equal(lseek(fx.source_fd, 0, SEEK_SET), 0);
+
+    rc = layout_encode(enc, xfer);
+    assert_return_code(rc, -rc);
+
+    rc = layout_step(enc, NULL, &reqs, &n_reqs);
+    assert_return_code(rc, -rc);
+    assert_int_equal(n_reqs, 1);
+    assert_true(pho_request_is_write(reqs));
+    assert_int_equal(reqs->walloc->n_media, N_MEDIA);
+    reqs_free(reqs, n_reqs);
+
+    /* the whole object fits in one split */
+    write_response(&resp);
+    rc = layout_step(enc, &resp, &reqs, &n_reqs);
+    pho_srl_response_free(&resp, false);
+    assert_return_code(rc, -rc);
+    assert_int_equal(n_reqs, 1);
+    assert_true(pho_request_is_release(reqs));
+    assert_int_equal(reqs->release->n_media, N_MEDIA);
+    for (i = 0; i < N_MEDIA; i++) {
+        assert_int_equal(reqs->release->media[i]->rc, 0);
+        assert_true(reqs->release->media[i]->size_written > 0);
+    }
+
+    release_response(&resp, reqs->release);
+    reqs_free(reqs, n_reqs);
+    rc = layout_step(enc, &resp, &reqs, &n_reqs);
+    pho_srl_response_free(&resp, false);
+    assert_return_code(rc, -rc);
+    assert_int_equal(n_reqs, 0);
+    assert_true(enc->done);
+    assert_int_equal(enc->layout->ext_count, N_MEDIA);
+}
+
+static void assert_same_content(void)
+{
+    char source[4096];
+    char target[4096];
+    ssize_t len;
+
+    assert_int_equal(lseek(fx.source_fd, 0, SEEK_SET), 0);
+    assert_int_equal(lseek(fx.target_fd, 0, SEEK_SET), 0);
+
+    do {
+        len = read(fx.source_fd, source, sizeof(source));
+        assert_true(len >= 0);
+        assert_int_equal(read(fx.target_fd, target, sizeof(target)), len);
+        assert_memory_equal(source, target, len);
+    } while (len > 0);
+}
+
+/* Get the object of \p layout from the \p n_media extents given by
+ * \p indexes and check its content.
+ */
+static void raid_get(struct layout_info *layout, const int *indexes,
+                     size_t n_media)
+{
+    struct pho_xfer_target target = {0};
+    struct pho_xfer_desc xfer = {0};
+    struct pho_encoder dec = {0};
+    pho_req_t *reqs;
+    pho_resp_t resp;
+    size_t n_reqs;
+    size_t i;
+    int rc;
+
+    assert_int_equal(ftruncate(fx.target_fd, 0), 0);
+    assert_int_equal(lseek(fx.target_fd, 0, SEEK_SET), 0);
+
+    target.xt_objid = "oid";
+    target.xt_fd = fx.target_fd;
+    xfer.xd_op = PHO_XFER_OP_GET;
+    xfer.xd_ntargets = 1;
+    xfer.xd_targets = &target;
+
+    rc = layout_decode(&dec, &xfer, layout);
+    assert_return_code(rc, -rc);
+
+    rc = layout_step(&dec, NULL, &reqs, &n_reqs);
+    assert_return_code(rc, -rc);
+    assert_int_equal(n_reqs, 1);
+    assert_true(pho_request_is_read(reqs));
+    assert_int_equal(reqs->ralloc->n_med_ids, N_MEDIA);
+    assert_int_equal(reqs->ralloc->n_required, n_media);
+
+    read_response(&resp, reqs->ralloc, indexes, n_media);
+    reqs_free(reqs, n_reqs);
+    rc = layout_step(&dec, &resp, &reqs, &n_reqs);
+    pho_srl_response_free(&resp, false);
+    assert_return_code(rc, -rc);
+    assert_int_equal(n_reqs, 1);
+    assert_true(pho_request_is_release(reqs));
+    for (i = 0; i < n_media; i++)
+        assert_int_equal(reqs->release->media[i]->rc, 0);
+
+    reqs_free(reqs, n_reqs);
+    assert_true(dec.done);
+    layout_destroy(&dec);
+
+    assert_same_content();
+}
+
+/* Each replica is enough to get the object back */
+static void rp_raid1_round_trip(void **state)
+{
+    struct pho_xfer_target target = {0};
+    struct pho_xfer_desc xfer = {0};
+    struct pho_encoder enc = {0};
+    int i;
+
+    (void) state;
+
+    pho_attr_set(&xfer.xd_params.put.lyt_params, "repl_count", "3");
+    raid_put(&enc, &xfer, &target, "raid1");
+
+    for (i = 0; i < N_MEDIA; i++)
+        raid_get(enc.layout, &i, 1);
+
+    layout_destroy(&enc);
+    pho_attrs_free(&xfer.xd_params.put.lyt_params);
+}
+
+/* Both halves, or one of them rebuilt from the parity, give the object back */
+static void rp_raid4_round_trip(void **state)
+{
+    static const int pairs[][2] = { {0, 1}, {0, 2}, {1, 2} };
+    struct pho_xfer_target target = {0};
+    struct pho_xfer_desc xfer = {0};
+    struct pho_encoder enc = {0};
+    int i;
+
+    (void) state;
+
+    raid_put(&enc, &xfer, &target, "raid4");
+
+    for (i = 0; i < sizeof(pairs) / sizeof(pairs[0]); i++)
+        raid_get(enc.layout, pairs[i], 2);
+
+    layout_destroy(&enc);
+}
+
+int main(void)
+{
+    const struct CMUnitTest raid_pipeline_cases[] = {
+        cmocka_unit_test_setup_teardown(rp_raid1_round_trip,
+                                        rp_setup, rp_teardown),
+        cmocka_unit_test_setup_teardown(rp_raid4_round_trip,
+                                        rp_setup, rp_teardown),
+    };
+
+    pho_context_init();
+    atexit(pho_context_fini);
+
+    return cmocka_run_group_tests(raid_pipeline_cases, NULL, NULL);
+}
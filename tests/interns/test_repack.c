@@ -0,0 +1,388 @@
+/* -*- mode: c; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief  Tests for the copy of the extents of a repack, on directories
+ */
+
+#include "test_setup.h"
+#include "pho_attrs.h"
+#include "pho_common.h"
+#include "pho_dss.h"
+#include "pho_dss_wrapper.h"
+#include "pho_io.h"
+#include "pho_type_utils.h"
+#include "pho_types.h"
+#include "repack.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#define N_EXTENTS 3
+
+/* the first extent spans several chunks of the copy ring */
+static const size_t extent_sizes[N_EXTENTS] = {
+    3 * 1024 * 1024 + 17, 4096, 1
+};
+
+struct repack_fixture {
+    char source_dir[32];
+    char target_dir[32];
+    struct io_adapter_module *ioa;
+    struct pho_ext_loc loc_source;
+    struct pho_ext_loc loc_target;
+    struct pho_io_descr iod_source;
+    struct pho_io_descr iod_target;
+    struct pho_id target;
+    struct extent extents[N_EXTENTS];
+    char uuids[N_EXTENTS][37];
+    char addresses[N_EXTENTS][32];
+    struct repack_copy copy;
+};
+
+static struct repack_fixture fx;
+static int uuid_base;
+
+static char *file_path(const char *dir, const char *address)
+{
+    char *path;
+
+    assert_true(asprintf(&path, "%s/%s", dir, address) > 0);
+
+    return path;
+}
+
+static void write_source(int idx)
+{
+    char *path = file_path(fx.source_dir, fx.addresses[idx]);
+    FILE *file;
+    size_t i;
+
+    file = fopen(path, "w");
+    assert_non_null(file);
+    for (i = 0; i < extent_sizes[idx]; i++)
+        assert_int_not_equal(fputc((i * 7 + idx) & 0xff, file), EOF);
+
+    assert_int_equal(fclose(file), 0);
+    free(path);
+}
+
+/* The last extent has no recorded position, LTFS gives its start block */
+static ssize_t rp_getxattr(const char *path, const char *name, void *value,
+                           size_t size)
+{
+    size_t len = strlen(fx.addresses[N_EXTENTS - 1]);
+    size_t path_len = strlen(path);
+
+    if (!strcmp(name, "user.ltfs.startblock") && path_len >= len &&
+        !strcmp(path + path_len - len, fx.addresses[N_EXTENTS - 1]))
+        return snprintf(value, size, "200");
+
+    errno = ENODATA;
+    return -1;
+}
+
+static int rp_setup(void **state)
+{
+    int i;
+
+    (void) state;
+
+    memset(&fx, 0, sizeof(fx));
+    strcpy(fx.source_dir, "/tmp/test_repack_srcXXXXXX");
+    strcpy(fx.target_dir, "/tmp/test_repack_tgtXXXXXX");
+    if (!mkdtemp(fx.source_dir) || !mkdtemp(fx.target_dir))
+        return -1;
+
+    if (get_io_adapter(PHO_FS_POSIX, &fx.ioa))
+        return -1;
+
+    fx.loc_source.root_path = fx.source_dir;
+    fx.loc_source.addr_type = PHO_ADDR_PATH;
+    fx.iod_source.iod_loc = &fx.loc_source;
+    fx.loc_target.root_path = fx.target_dir;
+    fx.iod_target.iod_loc = &fx.loc_target;
+
+    fx.target.family = PHO_RSC_DIR;
+    pho_id_name_set(&fx.target, fx.target_dir, "legacy");
+
+    for (i = 0; i < N_EXTENTS; i++) {
+        struct extent *ext = &fx.extents[i];
+
+        snprintf(fx.uuids[i], sizeof(fx.uuids[i]),
+                 "00000000-0000-0000-0000-%012d", uuid_base++);
+        snprintf(fx.addresses[i], sizeof(fx.addresses[i]), "rp_extent_%d", i);
+
+        ext->uuid = fx.uuids[i];
+        ext->layout_idx = i;
+        ext->state = PHO_EXT_ST_SYNC;
+        ext->size = extent_sizes[i];
+        ext->media.family = PHO_RSC_DIR;
+        pho_id_name_set(&ext->media, fx.source_dir, "legacy");
+        ext->address.buff = fx.addresses[i];
+        ext->address.size = strlen(fx.addresses[i]) + 1;
+
+        write_source(i);
+    }
+
+    /* on-tape order: extents 1, 2 then 0 */
+    pho_attr_set(&fx.extents[0].info, PHO_EXT_INFO_POSITION_NAME, "300");
+    pho_attr_set(&fx.extents[1].info, PHO_EXT_INFO_POSITION_NAME, "100");
+    phobos_context()->mock_ltfs.mock_getxattr = rp_getxattr;
+
+    fx.copy.ioa = fx.ioa;
+    fx.copy.iod_source = &fx.iod_source;
+    fx.copy.iod_target = &fx.iod_target;
+    fx.copy.target = &fx.target;
+    fx.copy.extents = fx.extents;
+    fx.copy.count = N_EXTENTS;
+    fx.copy.buffer_size = 0;
+    fx.copy.dss_batch = 2;
+
+    return 0;
+}
+
+static int rp_teardown(void **state)
+{
+    char *path;
+    int i;
+
+    (void) state;
+
+    pho_context_reset_mock_ltfs_functions();
+    repack_copy_fini(&fx.copy);
+
+    for (i = 0; i < N_EXTENTS; i++) {
+        path = file_path(fx.source_dir, fx.addresses[i]);
+        remove(path);
+        free(path);
+        path = file_path(fx.target_dir, fx.addresses[i]);
+        remove(path);
+        free(path);
+        pho_attrs_free(&fx.extents[i].info);
+    }
+
+    return rmdir(fx.target_dir) || rmdir(fx.source_dir) ? -1 : 0;
+}
+
+static void assert_same_file(const char *address)
+{
+    char *source_path = file_path(fx.source_dir, address);
+    char *target_path = file_path(fx.target_dir, address);
+    FILE *source;
+    FILE *target;
+    int c;
+
+    source = fopen(source_path, "r");
+    assert_non_null(source);
+    target = fopen(target_path, "r");
+    assert_non_null(target);
+
+    do {
+        c = fgetc(source);
+        assert_int_equal(fgetc(target), c);
+    } while (c != EOF);
+
+    fclose(target);
+    fclose(source);
+    free(target_path);
+    free(source_path);
+}
+
+static void assert_no_file(const char *dir, const char *address)
+{
+    char *path = file_path(dir, address);
+
+    assert_int_not_equal(access(path, F_OK), 0);
+    free(path);
+}
+
+static void assert_extent(struct dss_handle *handle, const char *uuid,
+                          enum extent_state state, const struct pho_id *medium,
+                          ssize_t size)
+{
+    struct dss_filter filter;
+    struct extent *ext;
+    int count;
+    int rc;
+
+    rc = dss_filter_build(&filter, "{\"DSS::EXT::uuid\": \"%s\"}", uuid);
+    assert_return_code(rc, -rc);
+
+    rc = dss_extent_get(handle, &filter, &ext, &count);
+    dss_filter_free(&filter);
+    assert_return_code(rc, -rc);
+    assert_int_equal(count, 1);
+    assert_int_equal(ext->state, state);
+    assert_int_equal(ext->size, size);
+    assert_true(pho_id_equal(&ext->media, medium));
+    dss_res_free(ext, count);
+}
+
+static void rp_copy_in_tape_order(void **state)
+{
+    struct dss_handle *handle = (struct dss_handle *)*state;
+    ssize_t size = 0;
+    int rc;
+    int i;
+
+    rc = repack_copy_extents(handle, &fx.copy);
+    assert_return_code(rc, -rc);
+
+    assert_string_equal(fx.extents[0].address.buff, fx.addresses[1]);
+    assert_string_equal(fx.extents[1].address.buff, fx.addresses[2]);
+    assert_string_equal(fx.extents[2].address.buff, fx.addresses[0]);
+
+    assert_int_equal(fx.copy.n_done, N_EXTENTS);
+    for (i = 0; i < N_EXTENTS; i++) {
+        assert_same_file(fx.addresses[i]);
+        assert_extent(handle, fx.copy.new_uuids[i], PHO_EXT_ST_PENDING,
+                      &fx.target, fx.extents[i].size);
+        size += extent_sizes[i];
+    }
+    assert_int_equal(fx.copy.size_done, size);
+}
+
+static void rp_copy_source_missing(void **state)
+{
+    struct dss_handle *handle = (struct dss_handle *)*state;
+    char *path;
+    int rc;
+
+    /* the second extent in tape order cannot be read */
+    path = file_path(fx.source_dir, fx.addresses[2]);
+    assert_int_equal(remove(path), 0);
+    free(path);
+
+    rc = repack_copy_extents(handle, &fx.copy);
+    assert_int_not_equal(rc, 0);
+
+    /* the copy done before the failure is recorded */
+    assert_int_equal(fx.copy.n_done, 1);
+    assert_int_equal(fx.copy.size_done, extent_sizes[1]);
+    assert_same_file(fx.addresses[1]);
+    assert_extent(handle, fx.copy.new_uuids[0], PHO_EXT_ST_PENDING,
+                  &fx.target, extent_sizes[1]);
+
+    assert_no_file(fx.target_dir, fx.addresses[2]);
+    assert_no_file(fx.target_dir, fx.addresses[0]);
+}
+
+static void rp_extents_migrate(void **state)
+{
+    struct dss_handle *handle = (struct dss_handle *)*state;
+    const char *old_uuids[N_EXTENTS];
+    struct object_info object = { 0 };
+    struct layout_info layout = { 0 };
+    struct layout_info *lyt;
+    struct dss_filter filter;
+    int lyt_cnt;
+    int rc;
+    int i;
+    int j;
+
+    object.oid = "rp_migrate";
+    object.user_md = "{}";
+    rc = dss_object_insert(handle, &object, 1, DSS_SET_INSERT);
+    assert_return_code(rc, -rc);
+
+    rc = dss_extent_insert(handle, fx.extents, N_EXTENTS);
+    assert_return_code(rc, -rc);
+
+    layout.oid = "rp_migrate";
+    layout.version = 1;
+    layout.layout_desc.mod_name = "raid1";
+    layout.layout_desc.mod_major = 0;
+    layout.layout_desc.mod_minor = 2;
+    layout.extents = fx.extents;
+    layout.ext_count = N_EXTENTS;
+    rc = dss_layout_insert(handle, &layout, 1);
+    assert_return_code(rc, -rc);
+
+    rc = repack_copy_extents(handle, &fx.copy);
+    assert_return_code(rc, -rc);
+
+    /* nothing to migrate */
+    rc = dss_update_extents_migrate(handle, old_uuids, NULL, 0);
+    assert_return_code(rc, -rc);
+
+    for (i = 0; i < N_EXTENTS; i++)
+        old_uuids[i] = fx.extents[i].uuid;
+
+    rc = dss_update_extents_migrate(handle, old_uuids,
+                                    (const char **)fx.copy.new_uuids,
+                                    N_EXTENTS);
+    assert_return_code(rc, -rc);
+
+    for (i = 0; i < N_EXTENTS; i++) {
+        assert_extent(handle, old_uuids[i], PHO_EXT_ST_ORPHAN,
+                      &fx.extents[i].media, fx.extents[i].size);
+        assert_extent(handle, fx.copy.new_uuids[i], PHO_EXT_ST_SYNC,
+                      &fx.target, fx.extents[i].size);
+    }
+
+    /* each index of the layout now refers to the copy of its extent */
+    rc = dss_filter_build(&filter, "{\"DSS::OBJ::oid\": \"rp_migrate\"}");
+    assert_return_code(rc, -rc);
+    rc = dss_full_layout_get(handle, &filter, NULL, &lyt, &lyt_cnt, NULL);
+    dss_filter_free(&filter);
+    assert_return_code(rc, -rc);
+    assert_int_equal(lyt_cnt, 1);
+    assert_int_equal(lyt->ext_count, N_EXTENTS);
+
+    for (i = 0; i < N_EXTENTS; i++) {
+        for (j = 0; j < N_EXTENTS; j++)
+            if (fx.extents[j].layout_idx == lyt->extents[i].layout_idx)
+                break;
+
+        assert_true(j < N_EXTENTS);
+        assert_string_equal(lyt->extents[i].uuid, fx.copy.new_uuids[j]);
+        assert_true(pho_id_equal(&lyt->extents[i].media, &fx.target));
+    }
+    dss_res_free(lyt, lyt_cnt);
+}
+
+int main(void)
+{
+    const struct CMUnitTest repack_cases[] = {
+        cmocka_unit_test_setup_teardown(rp_copy_in_tape_order,
+                                        rp_setup, rp_teardown),
+        cmocka_unit_test_setup_teardown(rp_copy_source_missing,
+                                        rp_setup, rp_teardown),
+        cmocka_unit_test_setup_teardown(rp_extents_migrate,
+                                        rp_setup, rp_teardown),
+    };
+
+    pho_context_init();
+    atexit(pho_context_fini);
+
+    return cmocka_run_group_tests(repack_cases,
+                                  global_setup_dss_with_dbinit,
+                                  global_teardown_dss_with_dbdrop);
+}
@@ -0,0 +1,157 @@
+/* -*- mode: c; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief  Tests for the metadata cache of the store
+ */
+
+#include "test_setup.h"
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <cmocka.h>
+
+#include "pho_dss.h"
+#include "pho_type_utils.h"
+
+#include "store_md_cache.h"
+
+static struct object_info mdc_obj = {
+    .oid = "oid1",
+    .uuid = "uuid1",
+    .version = 1,
+    .user_md = "{\"titi\": \"tutu\"}",
+};
+
+static int mdc_setup(void **state)
+{
+    int rc;
+
+    /* the changes are only notified once enabled, for all the sessions */
+    if (setenv("PGOPTIONS", "-c " DSS_OBJECT_CHANGE_SETTING "=on", 1))
+        return -1;
+
+    rc = global_setup_dss_with_dbinit(state);
+    if (rc)
+        return -1;
+
+    if (setenv("PHOBOS_STORE_md_cache_size", "2", 1))
+        return -1;
+
+    rc = dss_object_insert(*state, &mdc_obj, 1, DSS_SET_FULL_INSERT);
+    if (rc)
+        return -1;
+
+    return 0;
+}
+
+static int mdc_teardown(void **state)
+{
+    md_cache_fini();
+    unsetenv("PHOBOS_STORE_md_cache_size");
+    unsetenv("PGOPTIONS");
+
+    return global_teardown_dss_with_dbdrop(state);
+}
+
+/* A hit does not use the DSS handle */
+static void check_cached(const char *user_md)
+{
+    struct object_info *obj;
+    int rc;
+
+    rc = md_cache_living_object_get(NULL, mdc_obj.oid, &obj);
+    assert_return_code(rc, -rc);
+    assert_string_equal(obj->user_md, user_md);
+    object_info_free(obj);
+}
+
+static void mdc_hit(void **state)
+{
+    struct object_info *obj;
+    int rc;
+
+    rc = md_cache_living_object_get(*state, mdc_obj.oid, &obj);
+    assert_return_code(rc, -rc);
+    assert_string_equal(obj->uuid, mdc_obj.uuid);
+    object_info_free(obj);
+
+    check_cached(mdc_obj.user_md);
+
+    md_cache_invalidate(mdc_obj.oid, NULL);
+    rc = md_cache_living_object_get(*state, mdc_obj.oid, &obj);
+    assert_return_code(rc, -rc);
+    object_info_free(obj);
+
+    check_cached(mdc_obj.user_md);
+}
+
+static void mdc_notified(void **state)
+{
+    struct object_info update = mdc_obj;
+    struct object_info *obj = NULL;
+    int retry;
+    int rc;
+
+    rc = md_cache_living_object_get(*state, mdc_obj.oid, &obj);
+    assert_return_code(rc, -rc);
+    object_info_free(obj);
+
+    update.user_md = "{\"titi\": \"toto\"}";
+    rc = dss_object_update(*state, &mdc_obj, &update, 1,
+                           DSS_OBJECT_UPDATE_USER_MD);
+    assert_return_code(rc, -rc);
+
+    /* the notification is received asynchronously */
+    for (retry = 0; retry < 100; retry++) {
+        rc = md_cache_living_object_get(*state, mdc_obj.oid, &obj);
+        assert_return_code(rc, -rc);
+        if (!strcmp(obj->user_md, update.user_md))
+            break;
+
+        object_info_free(obj);
+        obj = NULL;
+        usleep(10000);
+    }
+
+    assert_non_null(obj);
+    assert_string_equal(obj->user_md, update.user_md);
+    object_info_free(obj);
+
+    check_cached(update.user_md);
+}
+
+int main(void)
+{
+    const struct CMUnitTest md_cache_tests[] = {
+        cmocka_unit_test(mdc_hit),
+        cmocka_unit_test(mdc_notified),
+    };
+
+    pho_context_init();
+    atexit(pho_context_fini);
+
+    return cmocka_run_group_tests(md_cache_tests, mdc_setup, mdc_teardown);
+}
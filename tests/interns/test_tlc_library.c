@@ -0,0 +1,875 @@
+/* -*- mode: c; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+/*
+ *  All rights reserved (c) 2014-2024 CEA/DAM.
+ *
+ *  This file is part of Phobos.
+ *
+ *  Phobos is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Phobos is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Phobos. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * \brief  Tests for the TLC moves and jobs, against a fake SCSI changer
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <endian.h>
+#include <errno.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <scsi/sg.h>
+#include <scsi/sg_io_linux.h>
+#include <scsi/scsi.h>
+
+#include "test_setup.h"
+#include "pho_common.h"
+#include "pho_dss.h"
+#include "pho_srl_tlc.h"
+
+#include <cmocka.h>
+
+#include "scsi_api.h"
+#include "scsi_common.h"
+#include "tlc_jobs.h"
+#include "tlc_library.h"
+
+#define N_SLOTS         4
+#define N_DRIVES        2
+#define ARM_ADDR        0x0
+#define FIRST_SLOT      0x1000
+#define FIRST_DRIVE     0x100
+
+/** Element of the fake changer */
+struct fake_element {
+    uint16_t address;
+    bool full;
+    bool src_valid;
+    uint16_t src_addr;
+    char label[VOL_ID_LEN];
+    char serial[DEV_ID_LEN];    /*!< Drive only */
+};
+
+/** Fake changer answering the SCSI requests of the library cache */
+static struct fake_changer {
+    struct fake_element arm;
+    struct fake_element slots[N_SLOTS];
+    struct fake_element drives[N_DRIVES];
+    bool fail_moves;            /*!< Reject the MOVE_MEDIUM requests */
+    int n_moves;                /*!< MOVE_MEDIUM requests received */
+} changer;
+
+static struct lib_descriptor lib;
+
+/* Slots 0 to 2 hold P0000<i>L5, slot 3 and the drives are empty */
+static void fake_changer_init(void)
+{
+    int i;
+
+    memset(&changer, 0, sizeof(changer));
+    changer.arm.address = ARM_ADDR;
+
+    for (i = 0; i < N_SLOTS; i++) {
+        changer.slots[i].address = FIRST_SLOT + i;
+        if (i < N_SLOTS - 1) {
+            changer.slots[i].full = true;
+            sprintf(changer.slots[i].label, "P0000%dL5", i);
+        }
+    }
+
+    for (i = 0; i < N_DRIVES; i++) {
+        changer.drives[i].address = FIRST_DRIVE + i;
+        sprintf(changer.drives[i].serial, "DRV%d", i);
+    }
+}
+
+static struct fake_element *fake_elements(uint8_t type, int *count)
+{
+    switch (type) {
+    case SCSI_TYPE_ARM:
+        *count = 1;
+        return &changer.arm;
+    case SCSI_TYPE_SLOT:
+        *count = N_SLOTS;
+        return changer.slots;
+    case SCSI_TYPE_DRIVE:
+        *count = N_DRIVES;
+        return changer.drives;
+    default:
+        *count = 0;
+        return NULL;
+    }
+}
+
+static struct fake_element *fake_element_from_addr(uint16_t address)
+{
+    int i;
+
+    for (i = 0; i < N_SLOTS; i++)
+        if (changer.slots[i].address == address)
+            return &changer.slots[i];
+
+    for (i = 0; i < N_DRIVES; i++)
+        if (changer.drives[i].address == address)
+            return &changer.drives[i];
+
+    return NULL;
+}
+
+static void fake_mode_sense(struct sg_io_hdr *hdr)
+{
+    struct mode_sense_result_header *res_hdr = hdr->dxferp;
+    struct mode_sense_result_EAAP *eaap = (void *)(res_hdr + 1);
+
+    res_hdr->mode_data_length = sizeof(*res_hdr) + sizeof(*eaap);
+    eaap->page_code = PAGECODE_ELEMENT_ADDRESS;
+    eaap->parameter_length = sizeof(*eaap) - 2;
+    eaap->first_medium_transport_elt_addr = htobe16(ARM_ADDR);
+    eaap->medium_transport_elt_nb = htobe16(1);
+    eaap->first_storage_elt_addr = htobe16(FIRST_SLOT);
+    eaap->storage_elt_nb = htobe16(N_SLOTS);
+    eaap->first_ie_elt_addr = 0;
+    eaap->ie_elt_nb = 0;
+    eaap->first_data_transfer_elt_addr = htobe16(FIRST_DRIVE);
+    eaap->data_transfer_elt_nb = htobe16(N_DRIVES);
+}
+
+static void set_be24(uint32_t value, uint8_t *be)
+{
+    be[0] = (value >> 16) & 0xFF;
+    be[1] = (value >> 8) & 0xFF;
+    be[2] = value & 0xFF;
+}
+
+/* One page of full descriptors, with volume tags and drive identifiers */
+static void fake_element_status(struct sg_io_hdr *hdr)
+{
+    struct read_status_cdb *req = (struct read_status_cdb *)hdr->cmdp;
+    struct element_status_header *res_hdr = hdr->dxferp;
+    struct element_status_page *page = (void *)(res_hdr + 1);
+    struct element_descriptor *desc = (void *)(page + 1);
+    uint16_t start = be16toh(req->starting_address);
+    uint16_t nb = be16toh(req->elements_nb);
+    struct fake_element *elements;
+    int n_elements;
+    int count = 0;
+    int i;
+
+    elements = fake_elements(req->element_type_code, &n_elements);
+
+    for (i = 0; i < n_elements && count < nb; i++) {
+        struct fake_element *elt = &elements[i];
+
+        if (elt->address < start)
+            continue;
+
+        desc->address = htobe16(elt->address);
+        desc->full = elt->full;
+        desc->access = 1;
+        desc->svalid = elt->src_valid;
+        desc->ssea = htobe16(elt->src_addr);
+        memset(desc->pvti, ' ', sizeof(desc->pvti));
+        if (elt->full)
+            memcpy(desc->pvti, elt->label, strlen(elt->label));
+
+        if (req->element_type_code == SCSI_TYPE_DRIVE) {
+            desc->alt_info.dev.id_len = strlen(elt->serial);
+            memcpy(desc->alt_info.dev.devid, elt->serial, strlen(elt->serial));
+        }
+
+        desc++;
+        count++;
+    }
+
+    if (!count)
+        return;
+
+    page->type_code = req->element_type_code;
+    page->pvoltag = 1;
+    page->ed_len = htobe16(sizeof(*desc));
+    res_hdr->first_address = htobe16(start);
+    res_hdr->elements_nb = htobe16(count);
+    set_be24(sizeof(*page) + count * sizeof(*desc), res_hdr->byte_count);
+}
+
+static void fake_move_medium(struct sg_io_hdr *hdr)
+{
+    struct move_medium_cdb *req = (struct move_medium_cdb *)hdr->cmdp;
+    struct fake_element *src = fake_element_from_addr(
+                                   be16toh(req->source_address));
+    struct fake_element *tgt = fake_element_from_addr(
+                                   be16toh(req->destination_address));
+
+    changer.n_moves++;
+
+    if (changer.fail_moves || !src || !tgt || !src->full || tgt->full) {
+        struct scsi_req_sense *sbp = (struct scsi_req_sense *)hdr->sbp;
+
+        /* converted to -EINVAL, without retry */
+        hdr->masked_status = CHECK_CONDITION;
+        sbp->sense_key = SPC_SK_ILLEGAL_REQUEST;
+        return;
+    }
+
+    tgt->full = true;
+    tgt->src_valid = true;
+    tgt->src_addr = src->address;
+    memcpy(tgt->label, src->label, sizeof(tgt->label));
+    src->full = false;
+    src->src_valid = false;
+    memset(src->label, 0, sizeof(src->label));
+}
+
+static int fake_changer_ioctl(int fd, unsigned long request, void *sg_io_hdr)
+{
+    struct sg_io_hdr *hdr = (struct sg_io_hdr *)sg_io_hdr;
+
+    (void) fd;
+    (void) request;
+
+    switch (hdr->cmdp[0]) {
+    case MODE_SENSE:
+        fake_mode_sense(hdr);
+        break;
+    case READ_ELEMENT_STATUS:
+        fake_element_status(hdr);
+        break;
+    case MOVE_MEDIUM:
+        fake_move_medium(hdr);
+        break;
+    default:
+        fail();
+    }
+
+    return 0;
+}
+
+static int tl_setup(void **state)
+{
+    json_t *json_message;
+    int rc;
+
+    (void) state;
+
+    fake_changer_init();
+    phobos_context()->mock_ioctl = &fake_changer_ioctl;
+
+    memset(&lib, 0, sizeof(lib));
+    strcpy(lib.name, "legacy");
+    rc = tlc_library_open(&lib, "/dev/null", &json_message);
+    if (json_message)
+        json_decref(json_message);
+
+    return rc;
+}
+
+static int tl_teardown(void **state)
+{
+    (void) state;
+
+    tlc_library_close(&lib);
+    pho_context_reset_scsi_ioctl();
+    return 0;
+}
+
+static struct element_status *slot(int i)
+{
+    return &lib.slots.items[i];
+}
+
+static struct element_status *drive(int i)
+{
+    return &lib.drives.items[i];
+}
+
+/* Check that \p label is cached in \p element, as in the fake changer */
+static void assert_holds(struct element_status *element, const char *label)
+{
+    struct fake_element *fake = fake_element_from_addr(element->address);
+
+    assert_true(element->full);
+    assert_string_equal(element->vol, label);
+    assert_ptr_equal(media_element_status_from_label(&lib, label), element);
+    assert_true(fake->full);
+    assert_string_equal(fake->label, label);
+}
+
+static void assert_empty(struct element_status *element)
+{
+    struct fake_element *fake = fake_element_from_addr(element->address);
+
+    assert_false(element->full);
+    assert_false(fake->full);
+}
+
+/* Prepare, perform and end a move, the move must succeed */
+static void load(struct dss_handle *dss, const char *serial, const char *label)
+{
+    json_t *json_message;
+    struct tlc_move move;
+    int rc;
+
+    rc = tlc_library_load_prepare(&lib, serial, label, &move, &json_message);
+    assert_return_code(rc, -rc);
+
+    rc = tlc_library_move(dss, &lib, 0, &move);
+    assert_return_code(rc, -rc);
+    tlc_library_move_end(&lib, &move, rc);
+}
+
+static void unload(struct dss_handle *dss, const char *serial,
+                   const char *label)
+{
+    struct lib_item_addr unload_addr;
+    char *unloaded_tape_label;
+    json_t *json_message;
+    struct tlc_move move;
+    int rc;
+
+    rc = tlc_library_unload_prepare(&lib, serial, label, &move,
+                                    &unloaded_tape_label, &unload_addr,
+                                    &json_message);
+    assert_return_code(rc, -rc);
+    assert_string_equal(unloaded_tape_label, label);
+    free(unloaded_tape_label);
+
+    rc = tlc_library_move(dss, &lib, 0, &move);
+    assert_return_code(rc, -rc);
+    tlc_library_move_end(&lib, &move, rc);
+}
+
+static void tl_load_unload(void **state)
+{
+    struct dss_handle *dss = (struct dss_handle *)*state;
+    struct lib_item_addr unload_addr;
+    char *unloaded_tape_label;
+    json_t *json_message;
+    struct tlc_move move;
+    int rc;
+
+    rc = tlc_library_load_prepare(&lib, "DRV0", "P00001L5", &move,
+                                  &json_message);
+    assert_return_code(rc, -rc);
+    assert_int_equal(move.type, PHO_DEVICE_LOAD);
+    assert_ptr_equal(move.source, slot(1));
+    assert_ptr_equal(move.target, drive(0));
+
+    rc = tlc_library_move(dss, &lib, 0, &move);
+    assert_return_code(rc, -rc);
+    assert_int_equal(changer.n_moves, 1);
+
+    /* the cache is only updated at the end of the move */
+    assert_true(slot(1)->full);
+    tlc_library_move_end(&lib, &move, rc);
+    assert_null(move.source);
+
+    assert_holds(drive(0), "P00001L5");
+    assert_empty(slot(1));
+    assert_true(drive(0)->src_addr_is_set);
+    assert_int_equal(drive(0)->src_addr, FIRST_SLOT + 1);
+
+    /* the tape goes back to its source slot */
+    rc = tlc_library_unload_prepare(&lib, "DRV0", NULL, &move,
+                                    &unloaded_tape_label, &unload_addr,
+                                    &json_message);
+    assert_return_code(rc, -rc);
+    assert_string_equal(unloaded_tape_label, "P00001L5");
+    free(unloaded_tape_label);
+    assert_int_equal(unload_addr.lia_type, MED_LOC_SLOT);
+    assert_int_equal(unload_addr.lia_addr, FIRST_SLOT + 1);
+    assert_ptr_equal(move.source, drive(0));
+    assert_ptr_equal(move.target, slot(1));
+
+    rc = tlc_library_move(dss, &lib, 0, &move);
+    assert_return_code(rc, -rc);
+    tlc_library_move_end(&lib, &move, rc);
+
+    assert_holds(slot(1), "P00001L5");
+    assert_empty(drive(0));
+
+    /* unloading an empty drive does not move anything */
+    rc = tlc_library_unload_prepare(&lib, "DRV0", NULL, &move,
+                                    &unloaded_tape_label, &unload_addr,
+                                    &json_message);
+    assert_return_code(rc, -rc);
+    assert_null(unloaded_tape_label);
+    assert_null(move.source);
+
+    dss_logs_delete(dss, NULL);
+}
+
+static void tl_busy_until_move_end(void **state)
+{
+    struct dss_handle *dss = (struct dss_handle *)*state;
+    struct lib_item_addr unload_addr;
+    char *unloaded_tape_label;
+    json_t *json_message;
+    struct tlc_move move0;
+    struct tlc_move move1;
+    struct tlc_move busy;
+    int rc;
+
+    rc = tlc_library_load_prepare(&lib, "DRV0", "P00000L5", &move0,
+                                  &json_message);
+    assert_return_code(rc, -rc);
+
+    /* the drive and the tape of the move are reserved */
+    rc = tlc_library_load_prepare(&lib, "DRV1", "P00000L5", &busy,
+                                  &json_message);
+    assert_int_equal(rc, -EBUSY);
+    assert_null(json_message);
+
+    rc = tlc_library_load_prepare(&lib, "DRV0", "P00002L5", &busy,
+                                  &json_message);
+    assert_int_equal(rc, -EBUSY);
+
+    rc = tlc_library_unload_prepare(&lib, "DRV0", NULL, &busy,
+                                    &unloaded_tape_label, &unload_addr,
+                                    &json_message);
+    assert_int_equal(rc, -EBUSY);
+
+    /* the other elements can move concurrently */
+    rc = tlc_library_load_prepare(&lib, "DRV1", "P00001L5", &move1,
+                                  &json_message);
+    assert_return_code(rc, -rc);
+
+    rc = tlc_library_move(dss, &lib, 0, &move1);
+    assert_return_code(rc, -rc);
+    tlc_library_move_end(&lib, &move1, rc);
+    assert_holds(drive(1), "P00001L5");
+
+    rc = tlc_library_move(dss, &lib, 0, &move0);
+    assert_return_code(rc, -rc);
+    tlc_library_move_end(&lib, &move0, rc);
+
+    /* once released, the elements can be moved again */
+    unload(dss, "DRV0", "P00000L5");
+    unload(dss, "DRV1", "P00001L5");
+    assert_holds(slot(0), "P00000L5");
+    assert_holds(slot(1), "P00001L5");
+    assert_empty(drive(0));
+    assert_empty(drive(1));
+
+    dss_logs_delete(dss, NULL);
+}
+
+static void tl_move_failure(void **state)
+{
+    struct dss_handle *dss = (struct dss_handle *)*state;
+    json_t *json_message;
+    struct tlc_move move;
+    int rc;
+
+    rc = tlc_library_load_prepare(&lib, "DRV0", "P00002L5", &move,
+                                  &json_message);
+    assert_return_code(rc, -rc);
+
+    changer.fail_moves = true;
+    rc = tlc_library_move(dss, &lib, 0, &move);
+    assert_int_equal(rc, -EINVAL);
+    tlc_library_move_end(&lib, &move, rc);
+    changer.fail_moves = false;
+
+    /* the cache is unchanged and the elements are released */
+    assert_holds(slot(2), "P00002L5");
+    assert_empty(drive(0));
+
+    load(dss, "DRV0", "P00002L5");
+    assert_holds(drive(0), "P00002L5");
+    unload(dss, "DRV0", "P00002L5");
+    assert_holds(slot(2), "P00002L5");
+
+    dss_logs_delete(dss, NULL);
+}
+
+/* Check the label index against a linear scan of \p elements */
+static void assert_labels_indexed(struct status_array *elements,
+                                  int *n_labels)
+{
+    int i;
+
+    for (i = 0; i < elements->count; i++) {
+        struct element_status *element = &elements->items[i];
+        struct element_status *indexed;
+
+        if (!element->full || !element->vol[0])
+            continue;
+
+        indexed = g_hash_table_lookup(lib.by_label, element->vol);
+        assert_non_null(indexed);
+        if (indexed == element)
+            (*n_labels)++;
+    }
+}
+
+/* Check that the indexes match the cached element status */
+static void assert_indexes(void)
+{
+    GHashTableIter iter;
+    gpointer value;
+    gpointer key;
+    int n_labels = 0;
+    int n_serials = 0;
+    int n_free = 0;
+    int i;
+
+    /* each indexed label is held by its element */
+    g_hash_table_iter_init(&iter, lib.by_label);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        struct element_status *element = value;
+
+        assert_true(element->full);
+        assert_string_equal(element->vol, key);
+    }
+
+    /* and each label held is indexed, once */
+    assert_labels_indexed(&lib.slots, &n_labels);
+    assert_labels_indexed(&lib.drives, &n_labels);
+    assert_labels_indexed(&lib.arms, &n_labels);
+    assert_labels_indexed(&lib.impexp, &n_labels);
+    assert_int_equal(g_hash_table_size(lib.by_label), n_labels);
+
+    for (i = 0; i < lib.drives.count; i++) {
+        if (!drive(i)->dev_id[0])
+            continue;
+
+        assert_ptr_equal(g_hash_table_lookup(lib.by_serial, drive(i)->dev_id),
+                         drive(i));
+        n_serials++;
+    }
+    assert_int_equal(g_hash_table_size(lib.by_serial), n_serials);
+
+    for (i = 0; i < lib.slots.count; i++) {
+        struct element_status *free_slot;
+
+        free_slot = g_tree_lookup(lib.free_slots,
+                                  GUINT_TO_POINTER(slot(i)->address));
+        if (slot(i)->full) {
+            assert_null(free_slot);
+        } else {
+            assert_ptr_equal(free_slot, slot(i));
+            n_free++;
+        }
+    }
+    assert_int_equal(g_tree_nnodes(lib.free_slots), n_free);
+}
+
+static void tl_indexes_after_moves(void **state)
+{
+    struct dss_handle *dss = (struct dss_handle *)*state;
+    struct lib_item_addr unload_addr;
+    char *unloaded_tape_label;
+    json_t *json_message;
+    struct tlc_move move;
+    int rc;
+
+    assert_indexes();
+    assert_ptr_equal(drive_element_status_from_serial(&lib, "DRV1"),
+                     drive(1));
+
+    load(dss, "DRV0", "P00000L5");
+    assert_indexes();
+    assert_holds(drive(0), "P00000L5");
+
+    load(dss, "DRV1", "P00002L5");
+    assert_indexes();
+    assert_holds(drive(1), "P00002L5");
+    assert_int_equal(g_tree_nnodes(lib.free_slots), 3);
+
+    /* a failed move leaves the indexes unchanged */
+    rc = tlc_library_unload_prepare(&lib, "DRV0", NULL, &move,
+                                    &unloaded_tape_label, &unload_addr,
+                                    &json_message);
+    assert_return_code(rc, -rc);
+    free(unloaded_tape_label);
+    changer.fail_moves = true;
+    rc = tlc_library_move(dss, &lib, 0, &move);
+    assert_int_equal(rc, -EINVAL);
+    tlc_library_move_end(&lib, &move, rc);
+    changer.fail_moves = false;
+    assert_indexes();
+    assert_holds(drive(0), "P00000L5");
+
+    unload(dss, "DRV0", "P00000L5");
+    assert_indexes();
+    assert_holds(slot(0), "P00000L5");
+
+    unload(dss, "DRV1", "P00002L5");
+    assert_indexes();
+    assert_holds(slot(2), "P00002L5");
+    assert_int_equal(g_tree_nnodes(lib.free_slots), 1);
+
+    dss_logs_delete(dss, NULL);
+}
+
+static void tl_indexes_after_refresh(void **state)
+{
+    struct dss_handle *dss = (struct dss_handle *)*state;
+    json_t *json_message;
+    int rc;
+
+    load(dss, "DRV0", "P00000L5");
+
+    /* the changer state changes behind the cache: a tape is moved by hand
+     * and a drive is replaced
+     */
+    memcpy(changer.slots[3].label, changer.slots[1].label, VOL_ID_LEN);
+    changer.slots[3].full = true;
+    memset(changer.slots[1].label, 0, VOL_ID_LEN);
+    changer.slots[1].full = false;
+    strcpy(changer.drives[1].serial, "DRV9");
+
+    rc = tlc_library_refresh(&lib, "/dev/null", &json_message);
+    assert_return_code(rc, -rc);
+    assert_indexes();
+
+    assert_holds(drive(0), "P00000L5");
+    assert_holds(slot(3), "P00001L5");
+    assert_empty(slot(1));
+    assert_null(drive_element_status_from_serial(&lib, "DRV1"));
+    assert_ptr_equal(drive_element_status_from_serial(&lib, "DRV9"),
+                     drive(1));
+
+    /* the refreshed indexes are then kept up to date by the moves */
+    load(dss, "DRV9", "P00001L5");
+    assert_indexes();
+    assert_holds(drive(1), "P00001L5");
+
+    unload(dss, "DRV9", "P00001L5");
+    unload(dss, "DRV0", "P00000L5");
+    assert_indexes();
+    assert_holds(slot(3), "P00001L5");
+    assert_holds(slot(0), "P00000L5");
+
+    dss_logs_delete(dss, NULL);
+}
+
+static struct tlc_job *job_new(pho_tlc_req_t *req)
+{
+    struct tlc_job *job = xcalloc(1, sizeof(*job));
+    struct pho_buff buf;
+
+    /* the jobs hold requests unpacked as received by the TLC */
+    pho_srl_tlc_request_pack(req, &buf);
+    pho_srl_tlc_request_free(req, false);
+    job->req = pho_srl_tlc_request_unpack(&buf);
+    assert_non_null(job->req);
+    job->client_socket = -1;
+
+    return job;
+}
+
+static struct tlc_job *load_job(int id, const char *serial, const char *label)
+{
+    pho_tlc_req_t req;
+
+    pho_srl_tlc_request_load_alloc(&req);
+    req.id = id;
+    req.load->drive_serial = xstrdup(serial);
+    req.load->tape_label = xstrdup(label);
+
+    return job_new(&req);
+}
+
+static struct tlc_job *unload_job(int id, const char *serial,
+                                  const char *label)
+{
+    pho_tlc_req_t req;
+
+    pho_srl_tlc_request_unload_alloc(&req);
+    req.id = id;
+    req.unload->drive_serial = xstrdup(serial);
+    req.unload->tape_label = xstrdup(label);
+
+    return job_new(&req);
+}
+
+static struct tlc_job *refresh_job(int id, bool status)
+{
+    pho_tlc_req_t req;
+
+    if (status) {
+        pho_srl_tlc_request_status_alloc(&req);
+        req.status->refresh = true;
+    } else {
+        pho_srl_tlc_request_refresh_alloc(&req);
+    }
+    req.id = id;
+
+    return job_new(&req);
+}
+
+/* Perform the move of a job returned by tlc_next_job and free it */
+static void job_move(struct dss_handle *dss, struct tlc_job *job)
+{
+    assert_true(job->moving);
+    job->rc = tlc_library_move(dss, &lib, 0, &job->move);
+    assert_return_code(job->rc, -job->rc);
+    tlc_library_move_end(&lib, &job->move, job->rc);
+    tlc_job_free(job);
+}
+
+static void tl_next_job_busy(void **state)
+{
+    struct dss_handle *dss = (struct dss_handle *)*state;
+    struct tlc_job *unload0;
+    struct tlc_job *load0;
+    struct tlc_job *load1;
+    GQueue *jobs = g_queue_new();
+    GList *refreshes;
+
+    g_queue_push_tail(jobs, load_job(1, "DRV0", "P00000L5"));
+    g_queue_push_tail(jobs, unload_job(2, "DRV0", "P00000L5"));
+    g_queue_push_tail(jobs, load_job(3, "DRV1", "P00001L5"));
+
+    load0 = tlc_next_job(&lib, jobs, 0, &refreshes);
+    assert_non_null(load0);
+    assert_null(refreshes);
+    assert_int_equal(load0->req->id, 1);
+
+    /* the unload waits for the load of its drive, the next load proceeds */
+    load1 = tlc_next_job(&lib, jobs, 1, &refreshes);
+    assert_non_null(load1);
+    assert_int_equal(load1->req->id, 3);
+    assert_int_equal(g_queue_get_length(jobs), 1);
+
+    assert_null(tlc_next_job(&lib, jobs, 2, &refreshes));
+    assert_null(refreshes);
+    assert_int_equal(g_queue_get_length(jobs), 1);
+
+    job_move(dss, load0);
+
+    unload0 = tlc_next_job(&lib, jobs, 1, &refreshes);
+    assert_non_null(unload0);
+    assert_int_equal(unload0->req->id, 2);
+    assert_string_equal(unload0->unloaded_tape_label, "P00000L5");
+    assert_int_equal(unload0->unload_addr.lia_addr, FIRST_SLOT);
+    assert_true(g_queue_is_empty(jobs));
+
+    job_move(dss, unload0);
+    job_move(dss, load1);
+    unload(dss, "DRV1", "P00001L5");
+
+    /* a job which fails on preparation is ready, with its result */
+    g_queue_push_tail(jobs, load_job(4, "DRV0", "UNKNOWN"));
+    load0 = tlc_next_job(&lib, jobs, 0, &refreshes);
+    assert_non_null(load0);
+    assert_false(load0->moving);
+    assert_int_equal(load0->rc, -ENOENT);
+    assert_non_null(load0->json_message);
+    tlc_job_free(load0);
+
+    g_queue_free(jobs);
+    dss_logs_delete(dss, NULL);
+}
+
+static void assert_refreshes(GList *refreshes, int first_id, int n)
+{
+    GList *item;
+    int i = 0;
+
+    for (item = refreshes; item; item = item->next, i++) {
+        struct tlc_job *job = item->data;
+
+        assert_true(tlc_job_is_refresh(job));
+        assert_int_equal(job->req->id, first_id + i);
+    }
+
+    assert_int_equal(i, n);
+    g_list_free_full(refreshes, (GDestroyNotify)tlc_job_free);
+}
+
+static void tl_next_job_refresh(void **state)
+{
+    struct dss_handle *dss = (struct dss_handle *)*state;
+    GQueue *jobs = g_queue_new();
+    struct tlc_job *job;
+    GList *refreshes;
+
+    g_queue_push_tail(jobs, load_job(1, "DRV0", "P00000L5"));
+    g_queue_push_tail(jobs, refresh_job(2, false));
+    g_queue_push_tail(jobs, refresh_job(3, true));
+    g_queue_push_tail(jobs, load_job(4, "DRV1", "P00001L5"));
+    g_queue_push_tail(jobs, refresh_job(5, false));
+
+    job = tlc_next_job(&lib, jobs, 0, &refreshes);
+    assert_non_null(job);
+    assert_int_equal(job->req->id, 1);
+
+    /* the refreshes wait for the moves in progress and hold back the load */
+    assert_null(tlc_next_job(&lib, jobs, 1, &refreshes));
+    assert_null(refreshes);
+    assert_int_equal(g_queue_get_length(jobs), 4);
+
+    job_move(dss, job);
+
+    /* the adjacent refreshes are coalesced */
+    assert_null(tlc_next_job(&lib, jobs, 0, &refreshes));
+    assert_refreshes(refreshes, 2, 2);
+    assert_int_equal(g_queue_get_length(jobs), 2);
+
+    job = tlc_next_job(&lib, jobs, 0, &refreshes);
+    assert_non_null(job);
+    assert_int_equal(job->req->id, 4);
+
+    assert_null(tlc_next_job(&lib, jobs, 1, &refreshes));
+    assert_null(refreshes);
+
+    job_move(dss, job);
+
+    assert_null(tlc_next_job(&lib, jobs, 0, &refreshes));
+    assert_refreshes(refreshes, 5, 1);
+    assert_true(g_queue_is_empty(jobs));
+
+    assert_null(tlc_next_job(&lib, jobs, 0, &refreshes));
+    assert_null(refreshes);
+
+    unload(dss, "DRV0", "P00000L5");
+    unload(dss, "DRV1", "P00001L5");
+
+    g_queue_free(jobs);
+    dss_logs_delete(dss, NULL);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tlc_library_cases[] = {
+        cmocka_unit_test_setup_teardown(tl_load_unload, tl_setup, tl_teardown),
+        cmocka_unit_test_setup_teardown(tl_busy_until_move_end, tl_setup,
+                                        tl_teardown),
+        cmocka_unit_test_setup_teardown(tl_move_failure, tl_setup,
+                                        tl_teardown),
+        cmocka_unit_test_setup_teardown(tl_indexes_after_moves, tl_setup,
+                                        tl_teardown),
+        cmocka_unit_test_setup_teardown(tl_indexes_after_refresh, tl_setup,
+                                        tl_teardown),
+        cmocka_unit_test_setup_teardown(tl_next_job_busy, tl_setup,
+                                        tl_teardown),
+        cmocka_unit_test_setup_teardown(tl_next_job_refresh, tl_setup,
+                                        tl_teardown),
+    };
+
+    pho_context_init();
+    atexit(pho_context_fini);
+
+    return cmocka_run_group_tests(tlc_library_cases,
+                                  global_setup_dss_with_dbinit,
+                                  global_teardown_dss_with_dbdrop);
+}
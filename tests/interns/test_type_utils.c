@@ -33,6 +33,10 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
 
 static const char *const T_AB[] = {"a", "b"};
 static const char *const T_AC[] = {"a", "c"};
@@ -157,6 +161,161 @@ static void test_str2string_array(void)
     string_array_free(&string_array_new);
 }
 
+#define TSQ_PRODUCERS 4
+#define TSQ_ELEMENTS 10000
+
+static void *tsqueue_producer(void *arg)
+{
+    struct tsqueue *tsq = arg;
+    static int next_producer;
+    intptr_t producer;
+    intptr_t i;
+
+    producer = __atomic_fetch_add(&next_producer, 1, __ATOMIC_RELAXED) %
+               TSQ_PRODUCERS;
+    for (i = 1; i <= TSQ_ELEMENTS; i++)
+        tsqueue_push(tsq, (void *)(producer * TSQ_ELEMENTS + i));
+
+    return NULL;
+}
+
+static void count_notify(void *arg)
+{
+    __atomic_fetch_add((int *)arg, 1, __ATOMIC_RELAXED);
+}
+
+static void test_tsqueue_producers(void)
+{
+    intptr_t last[TSQ_PRODUCERS] = {0};
+    pthread_t producers[TSQ_PRODUCERS];
+    struct tsqueue tsq;
+    int n_popped = 0;
+    int n_notify = 0;
+    int i;
+
+    assert(tsqueue_init(&tsq) == 0);
+    tsqueue_set_notify(&tsq, count_notify, &n_notify);
+    assert(tsqueue_pop(&tsq) == NULL);
+
+    for (i = 0; i < TSQ_PRODUCERS; i++)
+        assert(pthread_create(&producers[i], NULL, tsqueue_producer,
+                              &tsq) == 0);
+
+    /* the elements of each producer are popped in their push order */
+    while (n_popped < TSQ_PRODUCERS * TSQ_ELEMENTS) {
+        intptr_t elt = (intptr_t)tsqueue_pop(&tsq);
+        intptr_t producer;
+
+        if (!elt)
+            continue;
+
+        producer = (elt - 1) / TSQ_ELEMENTS;
+        assert(producer >= 0 && producer < TSQ_PRODUCERS);
+        assert(elt > last[producer]);
+        last[producer] = elt;
+        n_popped++;
+    }
+
+    for (i = 0; i < TSQ_PRODUCERS; i++)
+        assert(pthread_join(producers[i], NULL) == 0);
+
+    assert(tsqueue_pop(&tsq) == NULL);
+    assert(tsqueue_get_length(&tsq) == 0);
+    assert(n_notify >= 1);
+
+    tsqueue_push(&tsq, xstrdup("left"));
+    assert(tsqueue_get_length(&tsq) == 1);
+    tsqueue_destroy(&tsq, free);
+}
+
+#define TSQ_WAKEUP_ELEMENTS 200000
+/* a lost wakeup leaves the consumer asleep with elements in the queue */
+#define TSQ_WAKEUP_TIMEOUT 10
+
+struct tsqueue_wakeup {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool pending;
+};
+
+static void wakeup_notify(void *arg)
+{
+    struct tsqueue_wakeup *wakeup = arg;
+
+    pthread_mutex_lock(&wakeup->lock);
+    wakeup->pending = true;
+    pthread_cond_signal(&wakeup->cond);
+    pthread_mutex_unlock(&wakeup->lock);
+}
+
+static void *tsqueue_bursty_producer(void *arg)
+{
+    struct tsqueue *tsq = arg;
+    intptr_t i;
+
+    /* short bursts, so that the consumer often empties the queue */
+    for (i = 1; i <= TSQ_WAKEUP_ELEMENTS; i++) {
+        tsqueue_push(tsq, (void *)i);
+        if (i % 3 == 0)
+            sched_yield();
+    }
+
+    return NULL;
+}
+
+/* The consumer only polls the queue when notified, as the LRS workers do */
+static void test_tsqueue_wakeup(void)
+{
+    struct tsqueue_wakeup wakeup = {
+        .lock = PTHREAD_MUTEX_INITIALIZER,
+        .cond = PTHREAD_COND_INITIALIZER,
+        .pending = false,
+    };
+    struct tsqueue tsq;
+    pthread_t producer;
+    intptr_t last = 0;
+
+    assert(tsqueue_init(&tsq) == 0);
+    tsqueue_set_notify(&tsq, wakeup_notify, &wakeup);
+
+    assert(pthread_create(&producer, NULL, tsqueue_bursty_producer,
+                          &tsq) == 0);
+
+    while (last < TSQ_WAKEUP_ELEMENTS) {
+        intptr_t elt = (intptr_t)tsqueue_pop(&tsq);
+        struct timespec deadline;
+
+        if (elt) {
+            assert(elt == last + 1);
+            last = elt;
+            continue;
+        }
+
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += TSQ_WAKEUP_TIMEOUT;
+
+        pthread_mutex_lock(&wakeup.lock);
+        while (!wakeup.pending) {
+            int rc = pthread_cond_timedwait(&wakeup.cond, &wakeup.lock,
+                                            &deadline);
+
+            if (rc == ETIMEDOUT) {
+                fprintf(stderr, "No wakeup after element %ld, queue length "
+                        "%u\n", (long)last, tsqueue_get_length(&tsq));
+                abort();
+            }
+        }
+        wakeup.pending = false;
+        pthread_mutex_unlock(&wakeup.lock);
+    }
+
+    assert(pthread_join(producer, NULL) == 0);
+    assert(tsqueue_pop(&tsq) == NULL);
+    assert(tsqueue_get_length(&tsq) == 0);
+
+    tsqueue_destroy(&tsq, NULL);
+}
+
 int main(int argc, char **argv)
 {
     test_env_initialize();
@@ -164,6 +323,8 @@ int main(int argc, char **argv)
     test_string_array_various();
     test_string_array_dup();
     test_str2string_array();
+    test_tsqueue_producers();
+    test_tsqueue_wakeup();
 
     return EXIT_SUCCESS;
 }